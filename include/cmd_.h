@@ -5,10 +5,24 @@
 #ifndef SSW_CMD__H
 #define SSW_CMD__H
 #include <stdio.h>
+#include <math.h>
 
 #include "string.h"
 
 #include "ohashtable.h"
+#include "osv.h"
+#include "osv_bloom.h"
+#include "osv_hash.h"
+#include "osv_hll.h"
+#include "osv_json.h"
+#include "osv_list.h"
+#include "osv_set.h"
+#include "osv_sketch.h"
+#include "osv_stream.h"
+#include "osv_ts.h"
+#include "osv_vset.h"
+#include "osv_zset.h"
+#include "otier.h"
 
 #define  MAX_KEY_LEN ((1U << 30) -1)
 #define  IS_VALID_KEY_LEN(len) ((len) > 0 && (len) <= MAX_KEY_LEN)
@@ -17,16 +31,65 @@ typedef void (*free_)(void *);
 
 typedef void * (*malloc_)(size_t size);
 
+/** 值的类型与命令不符 (Redis 的 WRONGTYPE) */
+#define EWRONGTYPE EPROTOTYPE
+
+/** INCRBYFLOAT 结果的最大长度 (%.17Lf 格式下 long double 的上界) */
+#define LD_STR_MAX (5 * 1024)
+
+/**
+ * 严格的十进制整数解析 (与 Redis 的 string2ll 相同的规则):
+ * 可选的 '-', 不允许前导 0 / '+' / 空白, 不允许溢出
+ * @return 0 或 -EINVAL
+ */
+int string2ll(const char *s, uint64_t len, int64_t *out);
+
+/** 整个字符串必须是一个有限的浮点数, 不允许前导空白 @return 0 或 -EINVAL */
+int string2ld(const char *s, uint64_t len, long double *out);
+
+/** %.17Lf 去掉末尾的 0 和 '.', 不使用指数形式 @return 写入的长度 */
+int ld2string(char *bf, int bflen, long double v);
+
+/** key 不存在: 插入一个新的 OSV_INT (复制 key) @return 0 或 -ENOMEM */
+int osv_new_int(const char *key, uint32_t u30keylen, int64_t n);
+
 /**
- * However, on high-performance links, especially v, it supports big data
- * Then value_len's profits will be very large
+ * slot 中的值转成 OSV_INT: 冷值先 promote, 字符串值解析一次
+ * 容量 >= 8 时原地改写, 否则 realloc (slot->v 会被替换)
+ * @return 0, -EINVAL (不是整数), -EIO / -ENOMEM
  */
-struct osv {
-    uint64_t vlen;
-    char d[];
-}__attribute__((aligned(8)));
+int osv_to_int(ohash_t *slot);
 
-typedef struct osv osv;
+/**
+ * 保证 slot 中是一个容量 >= need 的 OSV_RAW 值 (冷值 promote, OSV_INT 格式化成字符串)
+ * 扩容按几何级数: need < 1MB 时翻倍, 之后每次多留 1MB, 与 sds 的策略相同
+ * 扩容后 [vlen, need) 的内容未定义, 由调用者填写
+ * @return 0, -ENOMEM / -EIO (值不变)
+ */
+int osv_make_room(ohash_t *slot, uint64_t need);
+
+/**
+ * 释放表中的一个值, 按类型释放嵌套结构 (hash 的 OSV_HASH_TABLE ...)
+ * 命令层释放 value 一律用它, key 仍然是 free
+ * osv_free_with: 嵌套结构总是 libc free, osv 本身用 free_func (DEL / MDEL 的参数)
+ */
+void osv_free(void *v);
+
+void osv_free_with(void *v, free_ free_func);
+
+/** 全局表扩容, 顺带释放过期元素 (value 用 osv_free) */
+int osv_expand(void);
+
+/**
+ * 集合类命令 (HSET ...) 取 key 上指定类型的值
+ * key 不存在时: create 为 NULL 则返回 NULL, 否则插入 create() 返回的空值 (复制 key)
+ * *err <- 0, -EWRONGTYPE (key 上是别的类型), -ENOMEM
+ * @return slot (BORROWED, 同 olookup)
+ */
+ohash_t *otype_lookup(char *key, uint32_t u30keylen, int type, osv *(*create)(void), int *err);
+
+/** 集合类的值被删空时连同 key 一起删除 */
+void otype_remove(ohash_t *slot);
 
 /**
  * 四个基础命令
@@ -37,7 +100,7 @@ typedef struct osv osv;
  */
 
 inline int
-SET4dup_(const char *key, uint32_t u30keylen, const void *v, uint64_t vlen, const uint32_t expired,
+SET4dup_(const char *key, uint32_t u30keylen, const void *v, uint64_t vlen, const uint64_t expired,
          const malloc_ malloc_func, const free_ free_func) {
 #ifndef NDEBUG
     if (!IS_VALID_KEY_LEN(u30keylen))
@@ -53,6 +116,8 @@ SET4dup_(const char *key, uint32_t u30keylen, const void *v, uint64_t vlen, cons
         goto failure;
     }
     osv_->vlen = vlen;
+    osv_->meta = 0;
+    osv_->ref = 1;
     memcpy(osv_->d, v, vlen);
     oret_t ot = {0};
     ret = oinsert(key_dup, u30keylen, osv_, expired, &ot);
@@ -74,7 +139,7 @@ failure:
 }
 
 inline int
-SET4dup(const char *key, uint32_t u30keylen, const void *v, uint64_t vlen, const uint32_t expired) {
+SET4dup(const char *key, uint32_t u30keylen, const void *v, uint64_t vlen, const uint64_t expired) {
 #ifndef NDEBUG
     if (!IS_VALID_KEY_LEN(u30keylen))
         return -EINVAL;
@@ -90,18 +155,20 @@ SET4dup(const char *key, uint32_t u30keylen, const void *v, uint64_t vlen, const
         goto failure;
     }
     osv_->vlen = vlen;
+    osv_->meta = 0;
+    osv_->ref = 1;
     memcpy(osv_->d, v, vlen);
     oret_t ot = {0};
     ret = oinsert(key_dup, u30keylen, osv_, expired, &ot);
     if (ret == FULL) {
-        if ((ret = expand_capacity(free)) < 0)
+        if ((ret = osv_expand()) < 0)
             goto failure;
         ret = oinsert(key_dup, u30keylen, osv_, expired, &ot);
     }
     if (ret < 0) goto failure;
     if (ret == REPLACED || ret == EXPIRED_) {
         free(ot.key);
-        free(ot.value);
+        osv_free(ot.value);
     }
     return ret;
 failure:
@@ -110,13 +177,189 @@ failure:
     return ret;
 }
 
+/**
+ * 写入一个已经构造好的值 (BITOP 的结果这类大块), 避免 SET4dup 再复制一遍
+ * 成功时 v 的所有权转给表, 原值和过期时间一起被替换; 失败时 v 仍归调用者
+ * @return 同 SET4dup
+ */
+inline int
+SET4own(const char *key, uint32_t u30keylen, osv *v) {
+#ifndef NDEBUG
+    if (!IS_VALID_KEY_LEN(u30keylen))
+        return -EINVAL;
+#endif
+    char *key_dup = strndup(key, u30keylen);
+    if (!key_dup)
+        return -ENOMEM;
+    oret_t ot = {0};
+    int ret = oinsert(key_dup, u30keylen, v, 0, &ot);
+    if (ret == FULL) {
+        if ((ret = osv_expand()) < 0) {
+            free(key_dup);
+            return ret;
+        }
+        ret = oinsert(key_dup, u30keylen, v, 0, &ot);
+    }
+    if (ret < 0) {
+        free(key_dup);
+        return ret;
+    }
+    if (ret == REPLACED || ret == EXPIRED_) {
+        free(ot.key);
+        osv_free(ot.value);
+    }
+    return ret;
+}
+
+/**
+ * SET 的选项 (SETOPT4dup 的 flags)
+ * SET_NX / SET_XX: 条件写, 不满足时不写
+ * SET_KEEPTTL: key 已存在时保留原过期时间 (忽略 expired)
+ * SET_GET: 返回旧值
+ */
+#define SET_NX 0x1
+#define SET_XX 0x2
+#define SET_KEEPTTL 0x4
+#define SET_GET 0x8
+
+/**
+ * SET 的完整形式, 只有一次 hash 和一次 probe (oprobe + 原地改写 / oclaim)
+ * - key 已存在时沿用表中的 key, 不再复制 key
+ * - 旧值是没有余量浪费的 OSV_RAW 且放得下时, 直接覆盖, 不分配也不释放
+ *
+ * SET_GET: *old <- 旧值 (不存在为 NULL, 冷值已 promote)
+ *          返回 1 时 *old 的所有权转给调用者 (调用者 free), 返回 0 时是 BORROWED
+ *          旧值不是字符串时什么都不写, 返回 -EWRONGTYPE
+ * 不带 SET_GET 时与 Redis 一样, 任何类型的旧值都被覆盖
+ * @return 1 已写入, 0 NX/XX 条件不满足, <0 -ENOMEM / -EIO / -EWRONGTYPE
+ */
+inline int
+SETOPT4dup(const char *key, uint32_t u30keylen, const void *v, uint64_t vlen, const uint64_t expired,
+           int flags, osv **old) {
+#ifndef NDEBUG
+    if (!IS_VALID_KEY_LEN(u30keylen))
+        return -EINVAL;
+#endif
+    int ret, found;
+    uint64_t hash;
+    if (old) *old = NULL;
+    ohash_t *slot = oprobe((char *) key, u30keylen, &hash, &found);
+    if (found) {
+        osv *cur = slot->v;
+        if ((flags & SET_GET) && osv_type(cur) != OSV_T_STRING) return -EWRONGTYPE;
+        if ((flags & SET_GET) && cur->enc == OSV_COLD && !(cur = otier_promote(slot))) return -EIO;
+        if (old) *old = (flags & SET_GET) ? cur : NULL;
+        if (flags & SET_NX) return 0;
+        uint64_t room = cur->vlen + cur->spare;
+        if (!(flags & SET_GET) && cur->enc == OSV_RAW && vlen <= room && room <= (vlen << 1) + 32) {
+            memcpy(cur->d, v, vlen);
+            cur->vlen = vlen;
+            cur->spare = room - vlen;
+            cur->ref = 1;
+        } else {
+            osv *osv_ = malloc(sizeof(osv) + vlen);
+            if (!osv_) return -ENOMEM;
+            osv_->vlen = vlen;
+            osv_->meta = 0;
+            osv_->ref = 1;
+            memcpy(osv_->d, v, vlen);
+            slot->v = osv_;
+            if (!(flags & SET_GET)) osv_free(cur);
+        }
+        if (!(flags & SET_KEEPTTL)) slot->expiratime = expired;
+        return 1;
+    }
+    if (flags & SET_XX) return 0;
+    char *key_dup = malloc(u30keylen);
+    osv *osv_ = malloc(sizeof(osv) + vlen);
+    if (!key_dup || !osv_) {
+        ret = -ENOMEM;
+        goto failure;
+    }
+    memcpy(key_dup, key, u30keylen);
+    osv_->vlen = vlen;
+    osv_->meta = 0;
+    osv_->ref = 1;
+    memcpy(osv_->d, v, vlen);
+    if (!slot) {
+        if ((ret = osv_expand()) < 0) goto failure;
+        slot = oprobe((char *) key, u30keylen, &hash, &found);
+    }
+    oret_t ot = {0};
+    if (oclaim(slot, key_dup, u30keylen, hash, osv_, expired, &ot) == EXPIRED_) {
+        free(ot.key);
+        osv_free(ot.value);
+    }
+    return 1;
+failure:
+    free(key_dup);
+    free(osv_);
+    return ret;
+}
+
+/** 非字符串的值也原样返回, 由调用者按 osv_type 回复 WRONGTYPE */
 inline osv *
 GET(char *key, uint32_t u30keylen) {
 #ifndef NDEBUG
     if (!IS_VALID_KEY_LEN(u30keylen))
         return NULL;
 #endif
-    return oget(key, u30keylen);
+    ohash_t *slot = olookup(key, u30keylen);
+    if (!slot) return NULL;
+    osv *v = slot->v;
+    if (v->enc == OSV_COLD) return otier_promote(slot);
+    if (!v->ref) v->ref = 1; // 只在需要时写, 避免每次 GET 都弄脏 cache line
+    return v;
+}
+
+/**
+ * GETDEL: 一次 probe 找到 slot, 冷值先 promote, 再从同一个 slot 摘下
+ * @return 被删除的值, 所有权转给调用者 (free); 不存在为 NULL
+ * *err <- 0, -EIO (promote 失败) 或 -EWRONGTYPE, 出错时 key 保持不变
+ */
+inline osv *
+GETDEL(char *key, uint32_t u30keylen, int *err) {
+    *err = 0;
+#ifndef NDEBUG
+    if (!IS_VALID_KEY_LEN(u30keylen))
+        return NULL;
+#endif
+    ohash_t *slot = olookup(key, u30keylen);
+    if (!slot) return NULL;
+    osv *v = slot->v;
+    if (osv_type(v) != OSV_T_STRING) {
+        *err = -EWRONGTYPE;
+        return NULL;
+    }
+    if (v->enc == OSV_COLD && !(v = otier_promote(slot))) {
+        *err = -EIO;
+        return NULL;
+    }
+    oret_t ot = {0};
+    otake_slot(slot, &ot);
+    free(ot.key);
+    return v;
+}
+
+/**
+ * GETEX: GET 的同时改写过期时间 (同一个 slot, 一次 probe)
+ * set_ttl == 0 时不改动, 否则写入 expired (0 即 PERSIST)
+ * 非字符串的值原样返回且不改过期时间, 由调用者回复 WRONGTYPE
+ */
+inline osv *
+GETEX(char *key, uint32_t u30keylen, int set_ttl, const uint64_t expired) {
+#ifndef NDEBUG
+    if (!IS_VALID_KEY_LEN(u30keylen))
+        return NULL;
+#endif
+    ohash_t *slot = olookup(key, u30keylen);
+    if (!slot) return NULL;
+    osv *v = slot->v;
+    if (osv_type(v) != OSV_T_STRING) return v;
+    if (v->enc == OSV_COLD && !(v = otier_promote(slot))) return NULL;
+    if (!v->ref) v->ref = 1;
+    if (set_ttl) slot->expiratime = expired;
+    return v;
 }
 
 inline int
@@ -128,12 +371,12 @@ DEL(char *key, uint32_t u30keylen, const free_ free_func) {
     oret_t ot = {0};
     otake(key, u30keylen, &ot);
     if (ot.key) free_func(ot.key);
-    if (ot.value) free_func(ot.value);
+    if (ot.value) osv_free_with(ot.value, free_func);
     return 0;
 }
 
 inline int
-EXPIRED(char *key, uint32_t u30keylen, const uint32_t expired) {
+EXPIRED(char *key, uint32_t u30keylen, const uint64_t expired) {
 #ifndef NDEBUG
     if (!IS_VALID_KEY_LEN(u30keylen))
         return -EINVAL;
@@ -142,4 +385,356 @@ EXPIRED(char *key, uint32_t u30keylen, const uint32_t expired) {
     return 0;
 }
 
+/**
+ * INCR / DECR / INCRBY / DECRBY 都归结到 INCRBY
+ * 计数器以 OSV_INT 保存, 热路径上只有一次 probe 和一个带溢出检查的加法:
+ * 不分配, 不解析, 不格式化. 已存在的 key 保留原来的过期时间
+ * *out <- 新值
+ * @return 0, -EINVAL (原值不是整数), -ERANGE (溢出, 值不变), -ENOMEM / -EIO / -EWRONGTYPE
+ */
+inline int
+INCRBY(char *key, uint32_t u30keylen, int64_t by, int64_t *out) {
+#ifndef NDEBUG
+    if (!IS_VALID_KEY_LEN(u30keylen))
+        return -EINVAL;
+#endif
+    ohash_t *slot = olookup(key, u30keylen);
+    if (!slot) {
+        *out = by;
+        return osv_new_int(key, u30keylen, by);
+    }
+    osv *v = slot->v;
+    if (osv_type(v) != OSV_T_STRING) return -EWRONGTYPE;
+    if (v->enc != OSV_INT) {
+        int ret = osv_to_int(slot);
+        if (ret < 0) return ret;
+        v = slot->v;
+    }
+    if (__builtin_add_overflow(osv_int(v), by, out)) return -ERANGE;
+    osv_int(v) = *out;
+    if (!v->ref) v->ref = 1;
+    return 0;
+}
+
+/**
+ * 浮点结果按字符串 (OSV_RAW) 保存, 与 Redis 一致: 结果能放进原来的 osv 时原地改写
+ * *out <- 存放结果的 osv (BORROWED)
+ * @return 0, -EINVAL (原值不是浮点数), -ERANGE (结果是 NaN / Inf), -ENOMEM / -EIO / -EWRONGTYPE
+ */
+inline int
+INCRBYFLOAT(char *key, uint32_t u30keylen, long double by, osv **out) {
+#ifndef NDEBUG
+    if (!IS_VALID_KEY_LEN(u30keylen))
+        return -EINVAL;
+#endif
+    ohash_t *slot = olookup(key, u30keylen);
+    long double cur = 0;
+    osv *v = NULL;
+    if (slot) {
+        v = slot->v;
+        if (osv_type(v) != OSV_T_STRING) return -EWRONGTYPE;
+        if (v->enc == OSV_COLD && !(v = otier_promote(slot))) return -EIO;
+        if (v->enc == OSV_INT) cur = (long double) osv_int(v);
+        else if (string2ld(v->d, v->vlen, &cur) < 0) return -EINVAL;
+    }
+    cur += by;
+    if (!isfinite(cur)) return -ERANGE;
+    char bf[LD_STR_MAX];
+    int len = ld2string(bf, sizeof(bf), cur);
+    if (!slot) {
+        int ret = SET4dup(key, u30keylen, bf, len, 0);
+        if (ret < 0) return ret;
+        *out = olookup(key, u30keylen)->v;
+        return 0;
+    }
+    uint64_t room = v->vlen + v->spare; // OSV_INT 的 8 字节同样可以复用
+    if ((uint64_t) len > room) {
+        osv *nv = realloc(v, sizeof(osv) + len);
+        if (!nv) return -ENOMEM;
+        slot->v = v = nv;
+        room = len;
+    }
+    memcpy(v->d, bf, len);
+    v->vlen = len;
+    v->spare = room - len;
+    v->enc = OSV_RAW;
+    v->ref = 1;
+    *out = v;
+    return 0;
+}
+
+/**
+ * APPEND: 余量够时只是一次 memcpy, 否则 osv_make_room 几何扩容, 均摊 O(1)
+ * *out <- 追加后的长度
+ * @return 0, -EFBIG (超过 OSV_MAX_STRLEN), -ENOMEM / -EIO / -EWRONGTYPE
+ */
+inline int
+APPEND(char *key, uint32_t u30keylen, const char *p, uint64_t len, uint64_t *out) {
+#ifndef NDEBUG
+    if (!IS_VALID_KEY_LEN(u30keylen))
+        return -EINVAL;
+#endif
+    ohash_t *slot = olookup(key, u30keylen);
+    if (!slot) {
+        if (len > OSV_MAX_STRLEN) return -EFBIG;
+        *out = len;
+        int ret = SET4dup(key, u30keylen, p, len, 0);
+        return ret < 0 ? ret : 0;
+    }
+    osv *v = slot->v;
+    if (osv_type(v) != OSV_T_STRING) return -EWRONGTYPE;
+    if (v->enc != OSV_RAW || len > v->spare) {
+        uint64_t cur = v->enc == OSV_INT ? 20 : v->vlen; // 格式化后的长度上界
+        if (cur + len > OSV_MAX_STRLEN) return -EFBIG;
+        int ret = osv_make_room(slot, cur + len);
+        if (ret < 0) return ret;
+        v = slot->v;
+    }
+    memcpy(v->d + v->vlen, p, len);
+    v->vlen += len;
+    v->spare -= len;
+    if (!v->ref) v->ref = 1;
+    *out = v->vlen;
+    return 0;
+}
+
+/**
+ * SETRANGE: 从 offset 开始覆盖写, 超出原长度的部分用 0 填充
+ * len == 0 时不创建 key, 只返回当前长度
+ * *out <- 修改后的长度
+ * @return 0, -EFBIG (offset + len 超过 OSV_MAX_STRLEN), -ENOMEM / -EIO / -EWRONGTYPE
+ */
+inline int
+SETRANGE(char *key, uint32_t u30keylen, uint64_t offset, const char *p, uint64_t len, uint64_t *out) {
+#ifndef NDEBUG
+    if (!IS_VALID_KEY_LEN(u30keylen))
+        return -EINVAL;
+#endif
+    if (offset + len > OSV_MAX_STRLEN) return -EFBIG;
+    ohash_t *slot = olookup(key, u30keylen);
+    if (!slot) {
+        *out = 0;
+        if (!len) return 0;
+        int ret = SET4dup(key, u30keylen, "", 0, 0);
+        if (ret < 0) return ret;
+        slot = olookup(key, u30keylen);
+    }
+    osv *v = slot->v;
+    if (osv_type(v) != OSV_T_STRING) return -EWRONGTYPE;
+    if (!len) {
+        if (v->enc == OSV_INT) {
+            int ret = osv_make_room(slot, 0);
+            if (ret < 0) return ret;
+            v = slot->v;
+        }
+        *out = v->vlen;
+        return 0;
+    }
+    uint64_t end = offset + len;
+    if (v->enc != OSV_RAW || end > v->vlen + v->spare) {
+        int ret = osv_make_room(slot, end);
+        if (ret < 0) return ret;
+        v = slot->v;
+    }
+    if (offset > v->vlen) memset(v->d + v->vlen, 0, offset - v->vlen);
+    memcpy(v->d + offset, p, len);
+    if (end > v->vlen) {
+        v->spare -= end - v->vlen;
+        v->vlen = end;
+    }
+    if (!v->ref) v->ref = 1;
+    *out = v->vlen;
+    return 0;
+}
+
+/** THROTTLE 的结果, 时间单位都是 ns */
+struct othrottle {
+    int limited;
+    int64_t remaining;
+    int64_t retry_after; // -1: 没有被限制, 或者 quantity 超过了 burst 永远不会被允许
+    int64_t reset_after; // 桶重新装满的时间
+};
+
+/**
+ * GCRA (generic cell rate algorithm) 限流, 一次 probe 完成 GET + INCR + EXPIRE
+ * 状态只有一个 TAT (theoretical arrival time, unix ns), 以 OSV_INT 存在 slot 里,
+ * slot 的过期时间就是 TAT: 桶装满后 key 自然过期, 与一个新的 key 没有区别
+ * interval: 两个请求之间的间隔 (period / count), tolerance = interval * (burst + 1)
+ *   tat = max(TAT, now), new_tat = tat + interval * quantity
+ *   new_tat - tolerance > now 时拒绝 (什么都不写), 否则 TAT <- new_tat
+ * 第一次调用分配 key 和 osv, 之后只是原地改写 8 字节和 expiratime, 不分配
+ * @return 0, -ERANGE (参数溢出), -EINVAL (原值不是整数), -ENOMEM / -EIO / -EWRONGTYPE
+ */
+inline int
+THROTTLE(char *key, uint32_t u30keylen, int64_t burst, int64_t interval, int64_t quantity, int64_t now,
+         struct othrottle *out) {
+#ifndef NDEBUG
+    if (!IS_VALID_KEY_LEN(u30keylen))
+        return -EINVAL;
+#endif
+    int64_t tolerance, inc, tat = now, ntat;
+    if (__builtin_mul_overflow(interval, burst + 1, &tolerance) ||
+        __builtin_mul_overflow(interval, quantity, &inc))
+        return -ERANGE;
+    int found;
+    uint64_t hash;
+    ohash_t *slot = oprobe(key, u30keylen, &hash, &found);
+    osv *v = NULL;
+    if (found) {
+        v = slot->v;
+        if (osv_type(v) != OSV_T_STRING) return -EWRONGTYPE;
+        if (v->enc != OSV_INT) {
+            int ret = osv_to_int(slot);
+            if (ret < 0) return ret;
+            v = slot->v;
+        }
+        if (osv_int(v) > now) tat = osv_int(v);
+    }
+    if (__builtin_add_overflow(tat, inc, &ntat)) return -ERANGE;
+    int64_t allow_at = ntat - tolerance;
+    int64_t ttl;
+    if (allow_at > now) {
+        out->limited = 1;
+        out->retry_after = inc <= tolerance ? allow_at - now : -1;
+        ttl = tat - now;
+    } else {
+        out->limited = 0;
+        out->retry_after = -1;
+        ttl = ntat - now;
+        uint64_t expired = ((uint64_t) ntat + 999999) / 1000000;
+        if (v) {
+            osv_int(v) = ntat;
+            if (!v->ref) v->ref = 1;
+            slot->expiratime = expired;
+        } else if (ttl > 0) {
+            char *key_dup = malloc(u30keylen);
+            v = malloc(sizeof(osv) + sizeof(int64_t));
+            if (!key_dup || !v || (!slot && osv_expand() < 0)) {
+                free(key_dup);
+                free(v);
+                return -ENOMEM;
+            }
+            memcpy(key_dup, key, u30keylen);
+            v->vlen = sizeof(int64_t);
+            v->meta = 0;
+            v->enc = OSV_INT;
+            v->ref = 1;
+            osv_int(v) = ntat;
+            if (!slot) slot = oprobe(key, u30keylen, &hash, &found);
+            oret_t ot = {0};
+            if (oclaim(slot, key_dup, u30keylen, hash, v, expired, &ot) == EXPIRED_) {
+                free(ot.key);
+                osv_free(ot.value);
+            }
+        }
+    }
+    int64_t next = tolerance - ttl;
+    out->remaining = next > 0 ? next / interval : 0;
+    out->reset_after = ttl;
+    return 0;
+}
+
+/**
+ * 三个批量命令 MGET / MSET / MDEL
+ * 调用者只填写 b[i].key / b[i].keylen (MSET 还有 b[i].v / b[i].vlen)
+ * 先整体 hash + prefetch 再逐个解析: n 个 DRAM miss 是重叠的, 而不是串行的
+ */
+
+/**
+ * b[i].v <- osv * (BORROWED, NULL 表示不存在或不是字符串, 与 Redis 的 MGET 相同)
+ * 冷值先全部发出 readahead, 再逐个 promote
+ */
+inline void
+MGET(obatch_t *b, uint32_t n) {
+    olookup_batch(b, n);
+    int cold = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (!b[i].slot) continue;
+        osv *v = b[i].slot->v;
+        if (v->enc == OSV_COLD) {
+            otier_prefetch_slot(b[i].slot);
+            cold = 1;
+        }
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        if (!b[i].slot) {
+            b[i].v = NULL;
+            continue;
+        }
+        osv *v = b[i].slot->v;
+        if (osv_type(v) != OSV_T_STRING) v = NULL;
+        else if (cold && v->enc == OSV_COLD) v = otier_promote(b[i].slot);
+        else if (!v->ref) v->ref = 1;
+        b[i].v = v;
+    }
+}
+
+/**
+ * 全部 key/osv 先分配, 容量先扩好, 然后才开始插入:
+ * 返回 -ENOMEM 时表中没有任何变化 (不会留下半个 MSET)
+ * 同一个 key 出现多次时后者覆盖前者
+ * b[i].key / b[i].v 会被替换为表持有的副本, 调用者不能再使用
+ */
+inline int
+MSET4dup(obatch_t *b, uint32_t n, const uint64_t expired) {
+    int ret = -ENOMEM;
+    uint32_t i;
+    for (i = 0; i < n; i++) {
+#ifndef NDEBUG
+        if (!IS_VALID_KEY_LEN(b[i].keylen)) {
+            ret = -EINVAL;
+            goto failure;
+        }
+#endif
+        char *key_dup = malloc(b[i].keylen);
+        osv *osv_ = malloc(sizeof(osv) + b[i].vlen);
+        if (!key_dup || !osv_) {
+            free(key_dup);
+            free(osv_);
+            goto failure;
+        }
+        memcpy(key_dup, b[i].key, b[i].keylen);
+        osv_->vlen = b[i].vlen;
+        osv_->meta = 0;
+        osv_->ref = 1;
+        memcpy(osv_->d, b[i].v, b[i].vlen);
+        b[i].key = key_dup;
+        b[i].v = osv_;
+    }
+    while ((size + n) * LOAD_FACTOR_DENOMINATOR >= cap * LOAD_FACTOR_THRESHOLD)
+        if (osv_expand() < 0) goto failure;
+    ohash_batch(b, n);
+    for (i = 0; i < n; i++) {
+        oret_t ot = {0};
+        ret = oinsert_h(b[i].key, b[i].keylen, b[i].hash, b[i].v, expired, &ot);
+        if (ret == REPLACED || ret == EXPIRED_) {
+            free(ot.key);
+            osv_free(ot.value);
+        }
+    }
+    return OK;
+failure:
+    while (i--) {
+        free(b[i].key);
+        free(b[i].v);
+    }
+    return ret;
+}
+
+/** @return 删除的个数 */
+inline int
+MDEL(obatch_t *b, uint32_t n, const free_ free_func) {
+    int deleted = 0;
+    ohash_batch(b, n);
+    for (uint32_t i = 0; i < n; i++) {
+        oret_t ot = {0};
+        otake_h(b[i].key, b[i].keylen, b[i].hash, &ot);
+        if (!ot.key) continue;
+        free_func(ot.key);
+        osv_free_with(ot.value, free_func);
+        deleted++;
+    }
+    return deleted;
+}
+
 #endif //SSW_CMD__H
@@ -0,0 +1,250 @@
+//
+// Created by weishen on 2025/11/8.
+//
+
+#ifndef SSW_CMD_DISPATCH_H
+#define SSW_CMD_DISPATCH_H
+#include "cmd_.h"
+#include "resp2parser.h"
+#include "resp2reply.h"
+
+#include <strings.h>
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "cmd_dispatch compares command names as little endian words"
+#endif
+
+/**
+ * 命令分发表
+ *
+ * 命令名按 8 字节字加载 (最多两个字, 所以名字 <= 16 字节),
+ * 只在字母的位置 OR 0x20 (表项里的 mlo / mhi) 后与表项整字比较, 不做逐字节 tolower;
+ * 非字母的字节 ('.', '_', 数字) 必须原样相等, 否则 0x0E 会被折叠成 '.'
+ *
+ * 表是编译期的完美哈希, 哈希的输入是整字 OR 0x20 (只用来选 slot, 不参与比较):
+ *   slot = (((wlo | fold) ^ len << 59) * CMD_HASH_MUL) >> (64 - CMD_TABLE_BITS)
+ * 表项用 designated initializer 放在自己的 slot 上, CMD_HASH_MUL 是针对当前
+ * 命令集合搜索出来的无冲突乘数. 增加命令时必须重新挑选 CMD_HASH_MUL,
+ * cmd_table_check() 会发现冲突 (两个命令落在同一个 slot, 后者覆盖前者)
+ */
+#define CMD_TABLE_BITS 9
+#define CMD_TABLE_SIZE (1U << CMD_TABLE_BITS)
+#define CMD_HASH_MUL 0xd006680876d21245ULL
+#define CMD_NAME_MAX 16
+
+#define CMD_W8_(a, b, c, d, e, f, g, h, ...)                                  \
+    ((uint64_t) (a) | (uint64_t) (b) << 8 | (uint64_t) (c) << 16 |            \
+     (uint64_t) (d) << 24 | (uint64_t) (e) << 32 | (uint64_t) (f) << 40 |     \
+     (uint64_t) (g) << 48 | (uint64_t) (h) << 56)
+#define CMD_WLO(...) CMD_W8_(__VA_ARGS__, 0, 0, 0, 0, 0, 0, 0, 0)
+#define CMD_WHI_(a, b, c, d, e, f, g, h, ...) CMD_W8_(__VA_ARGS__)
+#define CMD_WHI(...) CMD_WHI_(__VA_ARGS__, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+/** 字母的位置是 0x20, 其余是 0 */
+#define CMD_LM_(c) ((c) >= 'a' && (c) <= 'z' ? 0x20 : 0)
+#define CMD_M8_(a, b, c, d, e, f, g, h, ...) \
+    CMD_W8_(CMD_LM_(a), CMD_LM_(b), CMD_LM_(c), CMD_LM_(d), CMD_LM_(e), CMD_LM_(f), CMD_LM_(g), CMD_LM_(h))
+#define CMD_MLO(...) CMD_M8_(__VA_ARGS__, 0, 0, 0, 0, 0, 0, 0, 0)
+#define CMD_MHI_(a, b, c, d, e, f, g, h, ...) CMD_M8_(__VA_ARGS__)
+#define CMD_MHI(...) CMD_MHI_(__VA_ARGS__, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+/** 低 min(len, 8) 个字节为 0x20: 哈希前的折叠 */
+#define CMD_FOLD(len) (0x2020202020202020ULL >> ((len) >= 8 ? 0 : (8 - (len)) << 3))
+#define CMD_SLOT(wlo, len) \
+    (((((uint64_t) (wlo) | CMD_FOLD(len)) ^ (uint64_t) (len) << 59) * CMD_HASH_MUL) >> (64 - CMD_TABLE_BITS))
+
+typedef int (*cmd_handler_t)(struct connection_t *cn, struct element *argv, int argc);
+
+struct cmd_def {
+    const char *name;
+    uint64_t wlo;
+    uint64_t whi;
+    uint64_t mlo; // 字母位置的 0x20, 大小写折叠只作用在这些字节上
+    uint64_t mhi;
+    uint32_t len;
+    int arity; // > 0: argc 必须相等, < 0: argc >= -arity (argv[0] 是命令名)
+    cmd_handler_t handler;
+};
+
+extern const struct cmd_def cmd_table[CMD_TABLE_SIZE];
+
+static inline const struct cmd_def *cmd_lookup(const char *name, uint32_t len) {
+    if (!len || len > CMD_NAME_MAX) return NULL;
+    uint64_t wlo = 0, whi = 0;
+    if (len <= 8) {
+        memcpy(&wlo, name, len);
+    } else {
+        memcpy(&wlo, name, 8);
+        memcpy(&whi, name + 8, len - 8);
+    }
+    const struct cmd_def *c = cmd_table + CMD_SLOT(wlo, len);
+    if ((wlo | c->mlo) == c->wlo && (whi | c->mhi) == c->whi && c->len == len) return c;
+    return NULL;
+}
+
+/*********************** handler 共用 ******************************/
+
+/** 按编码回复一个 osv: OSV_INT 在这里才格式化成十进制 */
+static inline int reply_osv(struct connection_t *cn, osv *v) {
+    if (v->enc == OSV_INT) {
+        char bf[24];
+        return reply_bulk(cn, bf, ll2str(bf, osv_int(v)));
+    }
+    return reply_bulk(cn, v->d, (long long) v->vlen);
+}
+
+/** osv 的回复长度上界 */
+static inline long long reply_osv_len(osv *v) {
+    return v->enc == OSV_INT ? reply_bulk_len(20) : reply_bulk_len((long long) v->vlen);
+}
+
+static inline int reply_wrongtype(struct connection_t *cn) {
+    return reply_error(cn, "WRONGTYPE Operation against a key holding the wrong kind of value");
+}
+
+/** otype_lookup 的错误: WRONGTYPE 或 OOM */
+static inline int reply_type_err(struct connection_t *cn, int err) {
+    if (err == -EWRONGTYPE) return reply_wrongtype(cn);
+    return reply_error(cn, "OOM command not allowed when used memory > 'maxmemory'");
+}
+
+/** 写命令的错误: WRONGTYPE, 冷值读取失败或 OOM */
+static inline int reply_write_err(struct connection_t *cn, int ret) {
+    if (ret == -EWRONGTYPE) return reply_wrongtype(cn);
+    if (ret == -EIO) return reply_error(cn, "ERR tiered storage read failed");
+    return reply_error(cn, "OOM command not allowed when used memory > 'maxmemory'");
+}
+
+/** 选项名比较, 不区分大小写 */
+static inline int arg_is(const struct element *e, const char *opt) {
+    size_t n = strlen(opt);
+    return e->len == n && !strncasecmp(e->data, opt, n);
+}
+
+/**
+ * 各类型的 handler 分散在 cmd_<type>.c 中, 在 cmd_dispatch.c 的 CMD_LIST 里登记
+ */
+#define CMD_HANDLER(fn) int fn(struct connection_t *cn, struct element *argv, int argc);
+
+/** hash: cmd_hash.c */
+CMD_HANDLER(cmd_hset)
+CMD_HANDLER(cmd_hget)
+CMD_HANDLER(cmd_hmget)
+CMD_HANDLER(cmd_hdel)
+CMD_HANDLER(cmd_hgetall)
+CMD_HANDLER(cmd_hincrby)
+CMD_HANDLER(cmd_hlen)
+
+/** list: cmd_list.c */
+CMD_HANDLER(cmd_lpush)
+CMD_HANDLER(cmd_rpush)
+CMD_HANDLER(cmd_lpop)
+CMD_HANDLER(cmd_rpop)
+CMD_HANDLER(cmd_llen)
+CMD_HANDLER(cmd_lrange)
+CMD_HANDLER(cmd_ltrim)
+CMD_HANDLER(cmd_lindex)
+
+/** sorted set: cmd_zset.c */
+CMD_HANDLER(cmd_zadd)
+CMD_HANDLER(cmd_zscore)
+CMD_HANDLER(cmd_zcard)
+CMD_HANDLER(cmd_zrem)
+CMD_HANDLER(cmd_zrank)
+CMD_HANDLER(cmd_zrange)
+CMD_HANDLER(cmd_zrangebyscore)
+CMD_HANDLER(cmd_zpopmin)
+
+/** set: cmd_set.c */
+CMD_HANDLER(cmd_sadd)
+CMD_HANDLER(cmd_srem)
+CMD_HANDLER(cmd_sismember)
+CMD_HANDLER(cmd_scard)
+CMD_HANDLER(cmd_smembers)
+CMD_HANDLER(cmd_sinter)
+CMD_HANDLER(cmd_sunion)
+
+/** bitmap: cmd_bitmap.c */
+CMD_HANDLER(cmd_setbit)
+CMD_HANDLER(cmd_getbit)
+CMD_HANDLER(cmd_bitcount)
+CMD_HANDLER(cmd_bitpos)
+CMD_HANDLER(cmd_bitop)
+CMD_HANDLER(cmd_bitfield)
+
+/** hyperloglog: cmd_hll.c */
+CMD_HANDLER(cmd_pfadd)
+CMD_HANDLER(cmd_pfcount)
+CMD_HANDLER(cmd_pfmerge)
+
+/** bloom filter: cmd_bloom.c */
+CMD_HANDLER(cmd_bf_reserve)
+CMD_HANDLER(cmd_bf_add)
+CMD_HANDLER(cmd_bf_madd)
+CMD_HANDLER(cmd_bf_exists)
+CMD_HANDLER(cmd_bf_mexists)
+
+/** count-min sketch / top-k: cmd_sketch.c */
+CMD_HANDLER(cmd_cms_initbydim)
+CMD_HANDLER(cmd_cms_initbyprob)
+CMD_HANDLER(cmd_cms_incrby)
+CMD_HANDLER(cmd_cms_query)
+CMD_HANDLER(cmd_topk_reserve)
+CMD_HANDLER(cmd_topk_add)
+CMD_HANDLER(cmd_topk_list)
+
+/** time series: cmd_ts.c */
+CMD_HANDLER(cmd_ts_create)
+CMD_HANDLER(cmd_ts_add)
+CMD_HANDLER(cmd_ts_get)
+CMD_HANDLER(cmd_ts_range)
+CMD_HANDLER(cmd_ts_mrange)
+
+/** geo: cmd_geo.c */
+CMD_HANDLER(cmd_geoadd)
+CMD_HANDLER(cmd_geodist)
+CMD_HANDLER(cmd_geosearch)
+
+/** stream: cmd_stream.c */
+CMD_HANDLER(cmd_xadd)
+CMD_HANDLER(cmd_xlen)
+CMD_HANDLER(cmd_xrange)
+CMD_HANDLER(cmd_xtrim)
+CMD_HANDLER(cmd_xread)
+CMD_HANDLER(cmd_xgroup)
+CMD_HANDLER(cmd_xreadgroup)
+CMD_HANDLER(cmd_xack)
+CMD_HANDLER(cmd_xpending)
+
+/** json: cmd_json.c */
+CMD_HANDLER(cmd_json_set)
+CMD_HANDLER(cmd_json_get)
+CMD_HANDLER(cmd_json_numincrby)
+CMD_HANDLER(cmd_json_arrappend)
+
+/** vector set: cmd_vset.c */
+CMD_HANDLER(cmd_vadd)
+CMD_HANDLER(cmd_vsim)
+CMD_HANDLER(cmd_vcard)
+CMD_HANDLER(cmd_vdim)
+
+/**
+ * argv 指向 read_buffer (零拷贝), 只在本次调用中有效
+ * @return 0: 已处理 (包括回复了错误), <0: 写缓冲无法扩容, 连接应当关闭
+ */
+int cmd_dispatch(struct connection_t *cn, struct element *argv, int argc);
+
+/**
+ * epollrun 回调
+ * on_read: 分帧 -> 聚合 -> 分发, 回复写入 write_buffer, 然后压缩 read_buffer
+ * on_writer: 回复已经在 write_buffer 里, 交给 writere 发送即可
+ */
+int cmd_on_read(struct connection_t *cn);
+
+int cmd_on_writer(struct connection_t *cn);
+
+/**
+ * 校验每个命令都能被自己的名字查到 (即表中没有 slot 冲突)
+ * @return 0 或 第一个冲突的命令序号 + 1
+ */
+int cmd_table_check(void);
+
+#endif //SSW_CMD_DISPATCH_H
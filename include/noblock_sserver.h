@@ -48,6 +48,11 @@ struct connection_t {
     void *use_data;
     ufree use_data_free;
     int flag;
+    /**
+     * events -> 当前在 epoll 中注册的事件
+     * 只有 EPOLLOUT 真正需要打开 / 关闭时才 EPOLL_CTL_MOD, 而不是每次发送完都改一次
+     */
+    unsigned events;
 };
 
 /**
@@ -70,12 +75,24 @@ typedef int (*on_writer_t)(struct connection_t *conn);
 
 typedef int (*on_error_t)(struct connection_t *conn);
 
+/**
+ * 系统调用计数, 用来确认 pipeline 的一批命令只花一次 read + 一次 send
+ * runenvironment.stats 为 NULL 时不统计 (测试里放在 fork 前 mmap 的共享内存中)
+ */
+struct sserver_stats {
+    unsigned long long wakeups; // epoll_wait 返回的次数
+    unsigned long long reads; // 客户端连接上的 read, 包括返回 EAGAIN 的
+    unsigned long long sends;
+    unsigned long long ctls; // 客户端连接上的 EPOLL_CTL_MOD
+};
+
 struct runenvironment {
     int sfd;
     struct connection_pool *pool;
     on_read_t on_read;
     on_writer_t on_writer;
     on_error_t on_error;
+    struct sserver_stats *stats;
 };
 
 
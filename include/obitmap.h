@@ -0,0 +1,42 @@
+//
+// Created by weishen on 2025/11/13.
+//
+
+#ifndef SSW_OBITMAP_H
+#define SSW_OBITMAP_H
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * 位图 (字符串值上的 SETBIT / BITCOUNT / BITOP ...) 的批量内核
+ * 位序与 Redis 相同: 第 i 位是第 i / 8 个字节的 0x80 >> (i % 8)
+ * x86-64 上运行时选择 AVX2 / POPCNT 的实现, 否则是 64 位 SWAR
+ */
+
+enum obit_op {
+    OBIT_AND = 0,
+    OBIT_OR = 1,
+    OBIT_XOR = 2,
+    OBIT_NOT = 3,
+};
+
+/** p[0, n) 中 1 的个数 */
+uint64_t obit_count(const void *p, uint64_t n);
+
+/**
+ * dst[0, len) = src[0] op src[1] op ... (较短的源按 0 补齐), NOT 只用 src[0]
+ * dst 不能与任何一个源重叠
+ */
+void obit_op(enum obit_op op, uint8_t *dst, uint64_t len, const uint8_t *const *src, const uint64_t *srclen,
+             int nsrc);
+
+/** p[0, n) 中第一个不等于 skip (0x00 或 0xff) 的字节的下标, 没有时返回 n */
+uint64_t obit_skip(const void *p, uint64_t n, uint8_t skip);
+
+/** 字节内第一个值为 bit 的位 (0 是最高位), 没有时返回 8 */
+static inline int obit_first_in_byte(uint8_t b, int bit) {
+    uint32_t x = bit ? b : (uint8_t) ~b;
+    return x ? __builtin_clz(x) - 24 : 8;
+}
+
+#endif //SSW_OBITMAP_H
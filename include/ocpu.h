@@ -0,0 +1,35 @@
+//
+// Created by weishen on 2025/11/17.
+//
+
+#ifndef SSW_OCPU_H
+#define SSW_OCPU_H
+
+/**
+ * SIMD 内核的运行时 CPU 特性检测, 第一次调用时探测一次并缓存
+ * 非 x86-64 上全部为 0, 调用方退回标量实现
+ */
+
+#if defined(__x86_64__)
+#define OCPU_FEATURE(name, feature)                                                  \
+    static inline int cpu_has_##name(void) {                                         \
+        static int has = -1;                                                         \
+        if (has < 0) {                                                               \
+            __builtin_cpu_init();                                                    \
+            has = __builtin_cpu_supports(feature);                                   \
+        }                                                                            \
+        return has;                                                                  \
+    }
+#else
+#define OCPU_FEATURE(name, feature)                                                  \
+    static inline int cpu_has_##name(void) { return 0; }
+#endif
+
+OCPU_FEATURE(avx2, "avx2")
+OCPU_FEATURE(fma, "fma")
+OCPU_FEATURE(popcnt, "popcnt")
+OCPU_FEATURE(sse42, "sse4.2")
+
+#undef OCPU_FEATURE
+
+#endif //SSW_OCPU_H
@@ -42,25 +42,57 @@ typedef enum {
  * - 64 / 32 = 2 perfect slots per cache line
  * - Linear probing gets 2 slots in ONE memory fetch
  * - This is the FOUNDATION of our performance
+ *
+ * hash 只保存 64 位 hash 的低 32 位 (比较用的 tag + 扩容时重新定位),
+ * 省下的 4 字节给了 64 位毫秒过期时间; 因此 cap 最多 2^32 (OHASH_CAP_MAX)
  */
 struct ohash_t {
-    uint64_t hash; // 8 字节
-    char *key; // 8 字节
-    void *v; // 8 字节
+    uint32_t hash; // 4 字节, low 32 bits of ohash_key
     uint32_t tb: 1;
     uint32_t rm: 1; // is removed
     uint32_t keylen: 30;
-    uint32_t expiratime; // seconds
+    char *key; // 8 字节
+    void *v; // 8 字节
+    uint64_t expiratime; // unix milliseconds, 0 = never
 } __attribute__((aligned(8)));
 
+_Static_assert(sizeof(struct ohash_t) == 32, "ohash_t must stay 32 bytes");
+
+#define OHASH_CAP_MAX (1ULL << 32)
 
 struct oret_t {
     char *key;
     void *value;
 } __attribute__((aligned(8)));
 
+/**
+ * 批量操作的一项: key/keylen 由调用者填写, hash/slot 由 olookup_batch 填写
+ * v/vlen 供命令层使用 (MSET 的输入值, MGET 的输出 osv)
+ */
+struct obatch_t {
+    char *key;
+    uint32_t keylen;
+    uint64_t hash;
+    struct ohash_t *slot;
+    void *v;
+    uint64_t vlen;
+};
+
+/**
+ * 嵌套表: 与全局表同一套 probe / 扩容代码, 只是表本身由调用者持有
+ * (例如 hash 类型的值升级后就是一个 otable_t). 嵌套表中的元素没有过期时间.
+ * 遍历: slots[0, cap) 中 key != NULL && !tb 的就是活跃元素
+ */
+struct otable_t {
+    struct ohash_t *slots;
+    uint64_t cap;
+    uint64_t size;
+};
+
 typedef struct ohash_t ohash_t;
 typedef struct oret_t oret_t;
+typedef struct obatch_t obatch_t;
+typedef struct otable_t otable_t;
 
 /**
  * ohash_t 并不需要create
@@ -74,6 +106,41 @@ static inline time_t get_current_time_seconds(void) {
     return time(NULL);
 }
 
+static inline uint64_t get_current_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000;
+}
+
+/**
+ * 过期判断用的缓存时钟 (unix ms)
+ * 事件循环每处理一批命令前调用 oclock_tick() 一次, 同一批命令看到同一个 "现在",
+ * 热路径上不再有 clock_gettime; 批次结束时 oclock_reset() 清零. 没有事件循环
+ * 驱动时 (ohash_clock_ms == 0, 例如直接调用 cmd_ 的单元测试) oclock_ms 每次现读时钟.
+ */
+extern uint64_t ohash_clock_ms;
+
+static inline uint64_t oclock_tick(void) {
+    return ohash_clock_ms = get_current_time_ms();
+}
+
+static inline void oclock_reset(void) {
+    ohash_clock_ms = 0;
+}
+
+static inline uint64_t oclock_ms(void) {
+    return ohash_clock_ms ? ohash_clock_ms : get_current_time_ms();
+}
+
+static inline uint64_t ohash_key(const char *key, uint32_t keylen) {
+    return XXH64(key, keylen, H_SEED);
+}
+
+/** 预取 hash 的 home slot (一次取回两个 32 字节 slot 所在的 cache line) */
+static inline void oprefetch(uint64_t hash) {
+    __builtin_prefetch(ohashtabl + (hash & (cap - 1)));
+}
+
 static inline uint64_t getnext2power(uint64_t i) {
     i |= i >> 1;
     i |= i >> 2;
@@ -108,7 +175,7 @@ static inline uint64_t getnext2power(uint64_t i) {
  */
 int initohash(uint64_t cap_);
 
-int oinsert(char *key, uint32_t keylen, void *v, uint32_t expira, oret_t *oret);
+int oinsert(char *key, uint32_t keylen, void *v, uint64_t expira, oret_t *oret);
 
 /**
  * Retrieves a value by key.
@@ -117,9 +184,58 @@ int oinsert(char *key, uint32_t keylen, void *v, uint32_t expira, oret_t *oret);
  */
 void *oget(char *key, uint32_t keylen);
 
+/**
+ * Same probe as oget, but returns the live slot itself (BORROWED).
+ * Callers may rewrite slot->v / slot->expiratime in place (one probe
+ * instead of otake + oinsert). The slot pointer is invalidated by the next
+ * oinsert (expansion) or otake.
+ */
+ohash_t *olookup(char *key, uint32_t keylen);
+
+/**
+ * *_h variants take a hash already computed by ohash_key, so batched callers
+ * can hash and oprefetch every key before touching any slot.
+ */
+int oinsert_h(char *key, uint32_t keylen, uint64_t hash, void *v, uint64_t expira, oret_t *oret);
+
+ohash_t *olookup_h(char *key, uint32_t keylen, uint64_t hash);
+
+void otake_h(char *key, uint32_t keylen, uint64_t hash, oret_t *oret);
+
+/** stage 1 of every batched path: b[i].hash = ohash_key(...), then oprefetch it */
+void ohash_batch(obatch_t *b, uint32_t n);
+
+/**
+ * Resolve n keys in two stages: hash all + prefetch home slots, then probe.
+ * Fills b[i].hash and b[i].slot (NULL on miss). Same borrow rules as olookup.
+ */
+void olookup_batch(obatch_t *b, uint32_t n);
+
 void otake(char *key, uint32_t keylen, oret_t *oret);
 
-void oexpired(char *key, uint32_t keylen, uint32_t expiratime);
+/**
+ * Single probe for read-modify-write commands (SET NX/XX/GET, GETSET ...).
+ * *hash <- ohash_key(key)
+ * *found = 1: returns the live slot of key (BORROWED, same rules as olookup)
+ * *found = 0: returns the slot a new entry for key must be written to with oclaim,
+ *             the first tombstone on the probe path or the terminating empty slot.
+ *             Returns NULL instead when the table is FULL (expand and probe again).
+ * Nothing is written until oclaim, so a caller may still decide not to insert.
+ */
+ohash_t *oprobe(char *key, uint32_t keylen, uint64_t *hash, int *found);
+
+/**
+ * Write a new entry into a slot returned by oprobe (*found == 0), TAKES ownership
+ * of key and v like oinsert. When the slot held an expired entry its key/value are
+ * handed back through oret and EXPIRED_ is returned.
+ * @return OK / REMOVED / EXPIRED_
+ */
+int oclaim(ohash_t *slot, char *key, uint32_t keylen, uint64_t hash, void *v, uint64_t expira, oret_t *oret);
+
+/** otake for a slot already found by olookup / oprobe: RETURNS ownership via oret */
+void otake_slot(ohash_t *slot, oret_t *oret);
+
+void oexpired(char *key, uint32_t keylen, uint64_t expiratime);
 
 /**
  *  expand_capacity is an authorization action
@@ -129,5 +245,23 @@ void oexpired(char *key, uint32_t keylen, uint32_t expiratime);
  */
 int expand_capacity(void *free_func);
 
+/** 同 expand_capacity, 过期元素的 key 与 value 分别用不同的函数释放 (value 可能是嵌套结构) */
+int expand_capacity_kv(void *key_free, void *value_free);
+
+/**
+ * otable_t API, 所有权规则与全局表相同
+ * otable_insert 在装载因子达到阈值时自己扩容, 返回 OK / REPLACED / REMOVED / -ENOMEM
+ * otable_destroy 用 free_func 释放所有活跃元素的 key 和 value (NULL 则不释放)
+ */
+int otable_init(otable_t *t, uint64_t cap_);
+
+void otable_destroy(otable_t *t, void *free_func);
+
+int otable_insert(otable_t *t, char *key, uint32_t keylen, void *v, oret_t *oret);
+
+ohash_t *otable_lookup(otable_t *t, const char *key, uint32_t keylen);
+
+void otable_take(otable_t *t, const char *key, uint32_t keylen, oret_t *oret);
+
 
 #endif //SSW_OHASHTABLE_H
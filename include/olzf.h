@@ -0,0 +1,24 @@
+//
+// Created by weishen on 2025/11/10.
+//
+
+#ifndef SSW_OLZF_H
+#define SSW_OLZF_H
+#include <stddef.h>
+
+/**
+ * 小块数据的 LZ77 压缩 (LZF 的格式, 没有外部依赖)
+ * 控制字节 c:
+ *   c < 32  -> 后面 c + 1 个字节是字面量
+ *   c >= 32 -> 回溯: 长度 (c >> 5) + 2 (c >> 5 == 7 时再加下一个字节),
+ *              距离 ((c & 31) << 8 | 下一个字节) + 1, 最远 8KB
+ * 面向 list 的中间节点这类几 KB 的块: 压缩率一般, 但速度接近 memcpy
+ */
+
+/** @return 压缩后的长度, 0 表示 out 放不下 (数据不可压缩) */
+size_t olzf_compress(const void *in, size_t inlen, void *out, size_t outcap);
+
+/** @return 解压后的长度, 0 表示数据损坏或 out 放不下 */
+size_t olzf_decompress(const void *in, size_t inlen, void *out, size_t outcap);
+
+#endif //SSW_OLZF_H
@@ -0,0 +1,109 @@
+//
+// Created by weishen on 2025/11/2.
+//
+
+#ifndef SSW_OSV_H
+#define SSW_OSV_H
+#include "inttypes.h"
+
+/**
+ * osv 的编码(enc)
+ * OSV_RAW  -> d[0, vlen) 就是值本身
+ * OSV_COLD -> 值已经被 otier 下沉到磁盘, d 中只有一个 uint64_t 文件偏移
+ *             vlen 仍是原值长度 (STRLEN 之类的命令不需要 IO)
+ * OSV_INT  -> d 中是一个 int64_t (vlen == sizeof(int64_t)), INCR 系列原地加减
+ *             读取方按需格式化成十进制, 见 osv_int
+ *
+ * 高 4 位是值的类型 (osv_type), 低 4 位是该类型下的编码:
+ * OSV_HASH_PACK  -> d 是紧凑的 field/value 序列, 线性扫描, 见 osv_hash.h
+ * OSV_HASH_TABLE -> d 中是一个 otable_t (嵌套的 ohashtable)
+ * OSV_LIST_QUICK -> d 中是一个 struct olist (压缩节点组成的双向链表), 见 osv_list.h
+ * OSV_ZSET_PACK  -> d 是按 (score, member) 排序的紧凑序列, 见 osv_zset.h
+ * OSV_ZSET_TREE  -> d 中是一个 struct ozset (member -> score 的 otable_t + B+ 树)
+ * OSV_SET_INT16 / INT32 / INT64 -> d 是升序的整数数组, 见 osv_set.h
+ * OSV_SET_TABLE  -> d 中是一个 otable_t, 只用 key
+ * OSV_HLL_SPARSE / DENSE -> d 是基数缓存 + 游程编码 / 6 位打包的寄存器, 见 osv_hll.h
+ * OSV_BLOOM      -> d 中是一个 struct obloom (按 cache line 分块的多层 Bloom filter), 见 osv_bloom.h
+ * OSV_CMS / OSV_TOPK -> d 中是固定大小的 Count-Min Sketch / HeavyKeeper Top-K, 见 osv_sketch.h
+ * OSV_TS         -> d 中是一个 struct ots (Gorilla 压缩的 chunk 数组), 见 osv_ts.h
+ * OSV_STREAM     -> d 中是一个 struct ostream (按 ID 索引的宏节点 + 消费组), 见 osv_stream.h
+ * OSV_VSET       -> d 中是一个 struct ovset (连续存放的向量 + HNSW 图), 见 osv_vset.h
+ * OSV_JSON       -> d 是解析过的 JSON 文档 (前序的紧凑二进制树, 带子树长度), 见 osv_json.h
+ *
+ * spare: d 在 vlen 之后还有多少已分配的字节 (分配大小 = sizeof(osv) + vlen + spare)
+ * SET 出来的值 spare == 0, APPEND / SETRANGE 按几何级数扩容并把余量记在这里
+ */
+enum osv_enc {
+    OSV_RAW = 0,
+    OSV_COLD = 1,
+    OSV_INT = 2,
+    OSV_HASH_PACK = 0x10,
+    OSV_HASH_TABLE = 0x11,
+    OSV_LIST_QUICK = 0x20,
+    OSV_ZSET_PACK = 0x30,
+    OSV_ZSET_TREE = 0x31,
+    OSV_SET_INT16 = 0x40,
+    OSV_SET_INT32 = 0x41,
+    OSV_SET_INT64 = 0x42,
+    OSV_SET_TABLE = 0x43,
+    OSV_HLL_SPARSE = 0x50,
+    OSV_HLL_DENSE = 0x51,
+    OSV_BLOOM = 0x60,
+    OSV_CMS = 0x70,
+    OSV_TOPK = 0x80,
+    OSV_TS = 0x90,
+    OSV_STREAM = 0xA0,
+    OSV_VSET = 0xB0,
+    OSV_JSON = 0xC0,
+};
+
+enum osv_type {
+    OSV_T_STRING = 0,
+    OSV_T_HASH = 1,
+    OSV_T_LIST = 2,
+    OSV_T_ZSET = 3,
+    OSV_T_SET = 4,
+    OSV_T_HLL = 5,
+    OSV_T_BLOOM = 6,
+    OSV_T_CMS = 7,
+    OSV_T_TOPK = 8,
+    OSV_T_TS = 9,
+    OSV_T_STREAM = 10,
+    OSV_T_VSET = 11,
+    OSV_T_JSON = 12,
+};
+
+/**
+ * However, on high-performance links, especially v, it supports big data
+ * Then value_len's profits will be very large
+ *
+ * meta is one word so that a fresh osv can be reset with a single store.
+ */
+struct osv {
+    uint64_t vlen;
+
+    union {
+        uint64_t meta;
+
+        struct {
+            uint64_t enc: 8; // enum osv_enc
+            uint64_t ref: 1; // CLOCK reference bit, set by GET, cleared by the otier sweep
+            uint64_t spare: 48; // 256 TB, 远大于 OSV_MAX_STRLEN
+            uint64_t: 7;
+        };
+    };
+
+    char d[];
+}__attribute__((aligned(8)));
+
+typedef struct osv osv;
+
+/** 字符串值的上限, 与 Redis 的 proto-max-bulk-len 默认值一致 */
+#define OSV_MAX_STRLEN (512ULL << 20)
+
+#define osv_type(v) ((v)->enc >> 4)
+
+/** d 在 16 字节偏移处, 对 int64_t 天然对齐 */
+#define osv_int(v) (*(int64_t *) (v)->d)
+
+#endif //SSW_OSV_H
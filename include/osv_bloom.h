@@ -0,0 +1,88 @@
+//
+// Created by weishen on 2025/11/14.
+//
+
+#ifndef SSW_OSV_BLOOM_H
+#define SSW_OSV_BLOOM_H
+#include <stdint.h>
+#include "osv.h"
+
+/**
+ * Bloom filter 类型的值 (osv_type == OSV_T_BLOOM), 编码只有 OSV_BLOOM
+ * d 中是一个 struct obloom, 由若干层 (layer) 组成, 每层是一个分块的 Bloom filter:
+ *
+ * 每层是 nblocks 个 64 字节 (一条 cache line) 的块, 按 64 字节对齐
+ *   元素只用一次 XXH3_64bits: 高位选块 (乘法取模), 低 32 位乘 16 个奇数常量
+ *   得到块内 16 个 32 位字各自的一位, 从 (h >> 32) & 15 开始的连续 k 个字生效
+ *   查询只碰一条 cache line, 掩码和比较在 x86-64 上是两条 AVX2 的 256 位运算
+ *   k 个位落在不同的字里, 误判率比不分块的 Bloom 略高 (k 越大越明显), 建层时按 OBLOOM_BLOCK_PENALTY 多给位数
+ *
+ * 可扩展: 当前层的元素数达到 capacity 后追加一层, capacity *= expansion,
+ *   error *= OBLOOM_TIGHTENING, 总误判率收敛于 error / (1 - OBLOOM_TIGHTENING)
+ *   expansion == 0 (NONSCALING) 时写满返回 -ENOSPC
+ *
+ * 默认参数与 RedisBloom 相同: error 0.01, capacity 100, expansion 2
+ */
+#define OBLOOM_BLOCK 64
+#define OBLOOM_WORDS (OBLOOM_BLOCK / 4)
+#define OBLOOM_K_MAX OBLOOM_WORDS
+#define OBLOOM_TIGHTENING 0.5
+/** 分块的补偿: 位数乘 (1 + k * OBLOOM_BLOCK_PENALTY), 按实测误判率拟合 */
+#define OBLOOM_BLOCK_PENALTY 0.015
+
+#define OBLOOM_ERROR_DEFAULT 0.01
+#define OBLOOM_CAPACITY_DEFAULT 100
+#define OBLOOM_EXPANSION_DEFAULT 2
+
+/** 批量命令一次 hash + 预取多少个元素 */
+#define OBLOOM_BATCH 16
+
+struct obloom_layer {
+    uint8_t *blocks;
+    uint64_t nblocks;
+    uint64_t capacity;
+    uint64_t count;
+    uint32_t k;
+};
+
+struct obloom {
+    struct obloom_layer *layers;
+    uint32_t nlayers;
+    uint32_t expansion; // 0: NONSCALING
+    double error; // 第一层的误判率
+    uint64_t items; // 所有层的 count 之和
+};
+
+#define obloomv_bf(v) ((struct obloom *) (v)->d)
+
+/**
+ * 带一层的空 filter, 参数由调用者校验: 0 < error < 1, capacity > 0
+ * @return NULL 表示 -ENOMEM
+ */
+osv *obloomv_new(double error, uint64_t capacity, uint32_t expansion);
+
+/** 默认参数 (BF.ADD 自动创建), 签名符合 otype_lookup 的 create */
+osv *obloomv_new_default(void);
+
+/** 释放所有层, 不释放 v 本身 */
+void obloomv_clear(osv *v);
+
+/** 所有层占用的字节数 */
+uint64_t obloomv_bytes(const osv *v);
+
+/** 元素的 64 位哈希, 后面三个函数都用它 */
+uint64_t obloom_hash(const char *e, uint64_t len);
+
+/** 预取 h 在每一层的块, 批量命令先对一批元素预取再逐个查询 */
+void obloomv_prefetch(const osv *v, uint64_t h);
+
+/** @return 1 可能存在, 0 一定不存在 */
+int obloomv_exists(const osv *v, uint64_t h);
+
+/**
+ * 已经 (可能) 存在时不写入, 否则写入最新的一层, 写满时先追加一层
+ * @return 1 新元素, 0 可能已存在, -ENOMEM / -ENOSPC (NONSCALING 且已满)
+ */
+int obloomv_add(osv *v, uint64_t h);
+
+#endif //SSW_OSV_BLOOM_H
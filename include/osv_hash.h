@@ -0,0 +1,69 @@
+//
+// Created by weishen on 2025/11/9.
+//
+
+#ifndef SSW_OSV_HASH_H
+#define SSW_OSV_HASH_H
+#include "ohashtable.h"
+#include "osv.h"
+
+/**
+ * hash 类型的值 (osv_type == OSV_T_HASH), 两种编码:
+ *
+ * OSV_HASH_PACK: 小 hash, d 是连续的 entry 序列, 查找就是线性扫描
+ *   entry = [u8 flen][field][u8 vlen][value]
+ *   vlen 是已用字节数, 余量记在 spare (几何扩容, 同 APPEND)
+ *   一个 field 的开销只有 2 字节, 没有 slot / key 副本 / osv 头 / malloc 头
+ *
+ * OSV_HASH_TABLE: field 数超过 OSV_HASH_PACK_ENTRIES, 或者某个 field / value
+ *   超过 OSV_HASH_PACK_VALUE 字节时一次性转换 (不会再转回去)
+ *   d 中是一个 otable_t, key 是 field 的副本, v 是 OSV_RAW 的 osv, 都由表持有
+ *
+ * 阈值与 Redis 的 hash-max-listpack-entries / hash-max-listpack-value 默认值相同
+ */
+#define OSV_HASH_PACK_ENTRIES 128
+#define OSV_HASH_PACK_VALUE 64
+
+#define ohv_table(v) ((otable_t *) (v)->d)
+
+/** 空的 OSV_HASH_PACK, NULL 表示 -ENOMEM */
+osv *ohv_new(void);
+
+/** 释放整个 hash (OSV_HASH_TABLE 的 field / value 一起释放) */
+void ohv_free(osv *v);
+
+uint64_t ohv_len(const osv *v);
+
+/**
+ * *val / *vlen 指向 hash 内部 (BORROWED), 下一次修改这个 hash 之前有效
+ * @return 1 找到, 0 不存在
+ */
+int ohv_get(const osv *v, const char *f, uint32_t flen, const char **val, uint64_t *vlen);
+
+/**
+ * 写入一个 field, 必要时扩容或转换编码, *pv 可能被替换 (调用者写回 slot->v)
+ * @return 1 新 field, 0 覆盖已有 field, -ENOMEM (hash 不变)
+ */
+int ohv_set(osv **pv, const char *f, uint32_t flen, const char *val, uint64_t vlen);
+
+/** @return 1 已删除, 0 不存在 */
+int ohv_del(osv *v, const char *f, uint32_t flen);
+
+/**
+ * 遍历, 顺序: PACK 为插入顺序, TABLE 为 slot 顺序
+ * 遍历中不能修改 hash
+ */
+struct ohv_iter {
+    const osv *v;
+    uint64_t pos;
+};
+
+static inline void ohv_iter_init(struct ohv_iter *it, const osv *v) {
+    it->v = v;
+    it->pos = 0;
+}
+
+/** @return 1 取到一项, 0 结束 */
+int ohv_next(struct ohv_iter *it, const char **f, uint32_t *flen, const char **val, uint64_t *vlen);
+
+#endif //SSW_OSV_HASH_H
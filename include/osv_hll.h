@@ -0,0 +1,64 @@
+//
+// Created by weishen on 2025/11/14.
+//
+
+#ifndef SSW_OSV_HLL_H
+#define SSW_OSV_HLL_H
+#include <stddef.h>
+#include <stdint.h>
+#include "osv.h"
+
+/**
+ * HyperLogLog 类型的值 (osv_type == OSV_T_HLL), 2^14 个 6 位寄存器, 标准误差 0.81%
+ * 元素用 XXH64 哈希: 低 14 位选寄存器, 其余 50 位的 (尾随零个数 + 1) 是候选值
+ *
+ * d = [u64 card][寄存器], card 是缓存的基数, 最高位 OHLL_STALE 表示缓存已失效
+ * PFADD 修改了寄存器时置失效位, PFCOUNT 重新估算后写回
+ *
+ * OSV_HLL_SPARSE: 寄存器的游程编码, 与 Redis 的 sparse 表示相同:
+ *   ZERO  00xxxxxx          xxxxxx + 1 个 0 寄存器 (1..64)
+ *   XZERO 01xxxxxx yyyyyyyy  14 位长度 + 1 个 0 寄存器 (1..16384)
+ *   VAL   1vvvvvxx          xx + 1 个值为 vvvvv + 1 的寄存器 (值 1..32, 长度 1..4)
+ *   空 HLL 只有 2 字节, 小基数时每个非零寄存器约 1~3 字节
+ *
+ * OSV_HLL_DENSE: 出现 > 32 的寄存器值, 或者编码超过 ohll_sparse_max 字节时一次性转换
+ *   d 中是 OHLL_DENSE_SIZE (12 KB) 字节的 6 位小端打包寄存器, 末尾多 1 字节方便跨字节读取
+ *
+ * 合并 (PFMERGE / 多 key PFCOUNT) 在解包后的 8 位寄存器上做逐字节 max, x86-64 上是 AVX2
+ */
+#define OHLL_P 14
+#define OHLL_REGS (1U << OHLL_P)
+#define OHLL_BITS 6
+#define OHLL_DENSE_SIZE (OHLL_REGS * OHLL_BITS / 8)
+#define OHLL_STALE (1ULL << 63)
+
+/** 与 Redis 的 hll-sparse-max-bytes 默认值相同 */
+#define OHLL_SPARSE_MAX_DEFAULT 3000
+
+extern uint32_t ohll_sparse_max;
+
+/** 空的 OSV_HLL_SPARSE, NULL 表示 -ENOMEM */
+osv *ohllv_new(void);
+
+/**
+ * 加入一个元素, 必要时扩容或转成 dense, *pv 可能被替换 (调用者写回 slot->v)
+ * @return 1 有寄存器变大, 0 没有变化, -ENOMEM (HLL 不变)
+ */
+int ohllv_add(osv **pv, const char *e, uint64_t len);
+
+/** 基数估算, 缓存有效时直接返回, 否则估算后写回缓存 */
+uint64_t ohllv_count(osv *v);
+
+/** regs[i] = max(regs[i], v 的第 i 个寄存器), regs 是 OHLL_REGS 个 8 位寄存器 */
+void ohllv_merge(const osv *v, uint8_t *regs);
+
+/** 由 8 位寄存器构造 OSV_HLL_DENSE (缓存失效), NULL 表示 -ENOMEM */
+osv *ohllv_from_regs(const uint8_t *regs);
+
+/** 8 位寄存器上的基数估算 (Ertl 的改进估计, 同 Redis) */
+uint64_t ohll_estimate(const uint8_t *regs);
+
+/** dst[i] = max(dst[i], src[i]), i < n */
+void ohll_max(uint8_t *dst, const uint8_t *src, size_t n);
+
+#endif //SSW_OSV_HLL_H
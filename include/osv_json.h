@@ -0,0 +1,107 @@
+//
+// Created by weishen on 2025/11/17.
+//
+
+#ifndef SSW_OSV_JSON_H
+#define SSW_OSV_JSON_H
+#include <stdint.h>
+#include "osv.h"
+
+/**
+ * JSON 类型的值 (osv_type == OSV_T_JSON), 编码只有 OSV_JSON
+ * d 是解析一次之后的紧凑二进制树, 前序排列在一整块内存里, 之后读写都不再解析文本:
+ *   node = [u8 tag][payload]
+ *   OJ_NULL / OJ_FALSE / OJ_TRUE  没有 payload
+ *   OJ_INT / OJ_DBL               int64 / double, 都是 8 字节, NUMINCRBY 原地改写
+ *   OJ_STR                        [u32 len][bytes], 已经去掉转义
+ *   OJ_ARR                        [u32 size][u32 count][node ...]
+ *   OJ_OBJ                        [u32 size][u32 count]([u32 klen][key][node] ...)
+ *   size 是 count 之后的字节数: 跳过一个子树是 O(1), 按路径下降时只扫同一层的兄弟
+ * 改写一棵子树 (JSON.SET / ARRAPPEND) 就是 memmove 它后面的字节, 再修正路径上各祖先的 size
+ * vlen 是已用字节数, 余量记在 spare (同 OSV_HASH_PACK); 多字节整数都不对齐, 用 memcpy 读写
+ *
+ * 路径只支持确定的单个位置 (不支持通配符 / 过滤器 / 递归下降):
+ *   $ 开头 (JSONPath): $.a.b, $['a'][0], $.arr[-1]
+ *   其余按旧语法: . (根), .a.b, a.b[2]
+ */
+enum ojson_tag {
+    OJ_NULL = 0,
+    OJ_FALSE = 1,
+    OJ_TRUE = 2,
+    OJ_INT = 3,
+    OJ_DBL = 4,
+    OJ_STR = 5,
+    OJ_ARR = 6,
+    OJ_OBJ = 7,
+};
+
+/** 嵌套深度 / 路径长度上限, 解析和下降都用定长数组 */
+#define OJSON_DEPTH_MAX 128
+
+#define OJSON_NX 0x1
+#define OJSON_XX 0x2
+
+/** 可增长的字节缓冲, 解析和序列化的输出都追加在 len 之后 */
+struct ojbuf {
+    char *p;
+    uint64_t len;
+    uint64_t cap;
+};
+
+struct ojstep {
+    const char *key; // NULL 表示数组下标
+    uint32_t klen;
+    int64_t idx; // 负数从末尾数
+};
+
+struct ojpath {
+    struct ojstep s[OJSON_DEPTH_MAX];
+    uint32_t n; // 0 是根
+    int dollar; // JSONPath 语法, 回复包成数组
+};
+
+/**
+ * JSON 文本 -> 一个二进制 node, 追加到 b
+ * @return 0, -EINVAL (不是合法的 JSON, 或者嵌套超过 OJSON_DEPTH_MAX), -ENOMEM; 失败时 b->len 不变
+ */
+int ojson_parse(struct ojbuf *b, const char *s, uint64_t len);
+
+/** 二进制 node -> 紧凑的 JSON 文本, 追加到 b @return 0 或 -ENOMEM */
+int ojson_dump(struct ojbuf *b, const char *node);
+
+/** 原样追加 n 字节 @return 0 或 -ENOMEM */
+int ojson_put(struct ojbuf *b, const void *s, uint64_t n);
+
+/** 追加一个带引号和转义的 JSON 字符串 @return 0 或 -ENOMEM */
+int ojson_put_string(struct ojbuf *b, const char *s, uint32_t n);
+
+/** @return 0 或 -EINVAL (语法错误, 或者用了不支持的通配符 / 过滤器) */
+int ojpath_parse(struct ojpath *p, const char *s, uint32_t len);
+
+/** 新的 OSV_JSON, 内容是 bin 这一个 node, NULL 表示 -ENOMEM */
+osv *ojsonv_new(const char *bin, uint64_t blen);
+
+/** path 指向的 node (BORROWED, 下一次修改之前有效), NULL 表示不存在 */
+const char *ojsonv_find(const osv *v, const struct ojpath *p);
+
+/**
+ * path 处写入 bin 这一个 node: 已存在则替换, 不存在且父节点是 object 时新增成员
+ * *pv 可能被替换 (调用者写回 slot->v)
+ * @return 1 已写入, 0 没有写 (NX / XX 不满足, 或者父节点不存在), -ENOMEM / -E2BIG (文档不变)
+ */
+int ojsonv_set(osv **pv, const struct ojpath *p, const char *bin, uint64_t blen, int flags);
+
+/**
+ * path 处的数字原地加上 by (by_int 为真时是整数 i, 否则是 d)
+ * 整数 + 整数仍是整数, 溢出或者有一方是浮点数时结果是浮点数
+ * @return 0, -ENOENT, -EINVAL (不是数字), -ERANGE (结果不是有限数, 值不变); *node 指向结果
+ */
+int ojsonv_numincrby(osv *v, const struct ojpath *p, int by_int, int64_t i, double d, const char **node);
+
+/**
+ * path 处的数组末尾追加 n 个 node (bin 是它们首尾相连)
+ * @return 追加后的长度, -ENOENT, -EINVAL (不是数组), -ENOMEM / -E2BIG (文档不变)
+ */
+int64_t ojsonv_arrappend(osv **pv, const struct ojpath *p, const char *bin, uint64_t blen, uint32_t n);
+
+#endif //SSW_OSV_JSON_H
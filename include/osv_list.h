@@ -0,0 +1,94 @@
+//
+// Created by weishen on 2025/11/10.
+//
+
+#ifndef SSW_OSV_LIST_H
+#define SSW_OSV_LIST_H
+#include "osv.h"
+
+/**
+ * list 类型的值 (osv_type == OSV_T_LIST, enc == OSV_LIST_QUICK)
+ *
+ * 节点组成的双向链表, 每个节点是一段连续的 entry:
+ *   entry = [len][data][len]     len < 128: 1 字节, 否则 0xFF + u32 (共 5 字节)
+ *   尾部的 len 是反向读的, 所以节点两端都能 O(1) 取出元素
+ *
+ * 节点内数据放在 d[lo, hi), 两端都有余量:
+ *   头部新建的节点数据靠右放 (LPUSH 向左长), 尾部新建的节点靠左放 (RPUSH 向右长)
+ *   一端没有余量时才 realloc (几何扩容到 OLIST_NODE_MAX) 或挪动一次
+ * 节点超过 OLIST_NODE_MAX 时新建节点; 比它还大的元素单独占一个节点
+ *
+ * 压缩: olist_compress_depth > 0 时, 距两端 depth 个节点以外的中间节点用 olzf 压缩
+ *   (Redis 的 list-compress-depth). 两端的节点永远不压缩, push / pop 不会碰到压缩数据
+ */
+#define OLIST_NODE_MAX 8192 // 与 Redis 的 list-max-listpack-size -2 相同
+#define OLIST_NODE_MIN 64
+
+#define OLIST_HEAD 0
+#define OLIST_TAIL 1
+
+struct olnode {
+    struct olnode *prev, *next;
+    uint32_t count; // 元素个数
+    uint32_t lo, hi; // 数据在 d[lo, hi)
+    uint32_t cap; // d 的大小
+    uint32_t lz: 1; // d[0, hi) 是压缩后的数据
+    uint32_t rawsz: 31; // 压缩前的字节数
+    char d[];
+};
+
+struct olist {
+    struct olnode *head, *tail;
+    uint64_t len;
+    uint64_t nodes;
+};
+
+#define olv_list(v) ((struct olist *) (v)->d)
+
+/** 0 表示不压缩 (默认) */
+extern uint32_t olist_compress_depth;
+
+/** 空 list, NULL 表示 -ENOMEM */
+osv *olv_new(void);
+
+/** 释放所有节点, 不释放 v 本身 */
+void olv_clear(osv *v);
+
+static inline uint64_t olv_len(const osv *v) {
+    return olv_list(v)->len;
+}
+
+/** @return 0, -ENOMEM (list 不变) */
+int olv_push(osv *v, int where, const char *p, uint64_t len);
+
+/**
+ * 两端的元素 (BORROWED, 下一次修改 list 前有效)
+ * @return 1 取到, 0 list 为空
+ */
+int olv_peek(const osv *v, int where, const char **p, uint64_t *len);
+
+/** 删除一端的元素, list 为空时什么也不做 @return 0, -ENOMEM (邻居节点解压失败, list 不变) */
+int olv_pop(osv *v, int where);
+
+/** 从头部删除 head 个, 从尾部删除 tail 个 (LTRIM), 超过长度时删空 @return 0, -ENOMEM */
+int olv_trim(osv *v, uint64_t head, uint64_t tail);
+
+/**
+ * 从下标 start 开始顺序遍历, 压缩节点解压到迭代器自己的缓冲中
+ * 遍历中不能修改 list; 结束后必须 olv_iter_release
+ */
+struct olv_iter {
+    const struct olnode *node;
+    const char *p, *end; // 当前节点 (或解压缓冲) 中未读的部分
+    char *scratch;
+};
+
+/** @return 0, -ENOMEM (第一个节点解压失败, 不需要 release) */
+int olv_iter_init(struct olv_iter *it, const osv *v, uint64_t start);
+
+/** @return 1 取到一项, 0 结束, -ENOMEM (解压缓冲分配失败) */
+int olv_next(struct olv_iter *it, const char **p, uint64_t *len);
+
+void olv_iter_release(struct olv_iter *it);
+
+#endif //SSW_OSV_LIST_H
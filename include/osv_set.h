@@ -0,0 +1,97 @@
+//
+// Created by weishen on 2025/11/12.
+//
+
+#ifndef SSW_OSV_SET_H
+#define SSW_OSV_SET_H
+#include <stddef.h>
+#include "ohashtable.h"
+#include "osv.h"
+
+/**
+ * set 类型的值 (osv_type == OSV_T_SET), 两种编码:
+ *
+ * OSV_SET_INT16 / INT32 / INT64: 成员全是整数 (string2ll 的规范形式) 时,
+ *   d 是升序排列的有符号整数数组, 宽度随成员的范围升级 (不会降级), vlen 是字节数
+ *   一个成员只占 2 / 4 / 8 字节, SISMEMBER 是二分查找, SINTER 是 SIMD 的有序交集
+ *
+ * OSV_SET_TABLE: 出现非整数成员, 或者成员数超过 oset_intset_max 时一次性转换
+ *   d 中是一个 otable_t, key 是成员的副本, v 不使用 (NULL)
+ *
+ * oset_intset_max 默认 512, 与 Redis 的 set-max-intset-entries 相同:
+ * 整数数组的插入要挪动后面的元素, 调大它用插入换内存和交集速度
+ */
+#define OSET_INTSET_MAX_DEFAULT 512
+
+extern uint32_t oset_intset_max;
+
+#define osetv_table(v) ((otable_t *) (v)->d)
+
+static inline int osetv_is_int(const osv *v) {
+    return v->enc != OSV_SET_TABLE;
+}
+
+/** 整数编码的元素宽度: 2 / 4 / 8 */
+static inline uint32_t osetv_width(const osv *v) {
+    return 2U << (v->enc & 0xF);
+}
+
+/** 空的 OSV_SET_INT16, NULL 表示 -ENOMEM */
+osv *osetv_new(void);
+
+/** 释放嵌套结构, 不释放 v 本身 */
+void osetv_clear(osv *v);
+
+uint64_t osetv_len(const osv *v);
+
+/** @return 1 是成员, 0 不是 */
+int osetv_has(const osv *v, const char *m, uint32_t mlen);
+
+/**
+ * 加入一个成员, 必要时升级宽度或转换编码, *pv 可能被替换 (调用者写回 slot->v)
+ * @return 1 新成员, 0 已存在, -ENOMEM (集合不变)
+ */
+int osetv_add(osv **pv, const char *m, uint32_t mlen);
+
+/** @return 1 已删除, 0 不存在 */
+int osetv_del(osv *v, const char *m, uint32_t mlen);
+
+/**
+ * 遍历: 整数编码按升序 (成员格式化到 bf 中), TABLE 按 slot 顺序
+ * 遍历中不能修改集合
+ */
+struct osetv_iter {
+    const osv *v;
+    uint64_t pos;
+    char bf[24];
+};
+
+static inline void osetv_iter_init(struct osetv_iter *it, const osv *v) {
+    it->v = v;
+    it->pos = 0;
+}
+
+/** @return 1 取到一项, 0 结束 */
+int osetv_next(struct osetv_iter *it, const char **m, uint32_t *mlen);
+
+/**
+ * 两个整数编码集合的交集 / 并集, 结果是新的整数编码 osv (宽度取两者中较宽的)
+ * 结果不受 oset_intset_max 限制, 用完后 free
+ * @return NULL 表示 -ENOMEM
+ */
+osv *osetv_inter_int(const osv *a, const osv *b);
+
+osv *osetv_union_int(const osv *a, const osv *b);
+
+/**
+ * 有序 (严格升序) 数组的交集, 写入 out (容量 >= min(na, nb), 不能与 a / b 重叠)
+ * x86-64 上运行时选择 SSE4.2 (16 位) / AVX2 (32 / 64 位) 的实现, 否则标量归并
+ * @return 交集的元素个数
+ */
+size_t oset_inter16(const int16_t *a, size_t na, const int16_t *b, size_t nb, int16_t *out);
+
+size_t oset_inter32(const int32_t *a, size_t na, const int32_t *b, size_t nb, int32_t *out);
+
+size_t oset_inter64(const int64_t *a, size_t na, const int64_t *b, size_t nb, int64_t *out);
+
+#endif //SSW_OSV_SET_H
@@ -0,0 +1,114 @@
+//
+// Created by weishen on 2025/11/15.
+//
+
+#ifndef SSW_OSV_SKETCH_H
+#define SSW_OSV_SKETCH_H
+#include <stdint.h>
+#include "osv.h"
+
+/**
+ * 频率类的概率结构, 大小在创建时固定, 与流中不同元素的个数无关
+ * 元素只做一次 XXH3_64bits, 各行的列由 h1 + i * h2 (Kirsch-Mitzenmacher) 乘法取模得到
+ *
+ * Count-Min Sketch (osv_type == OSV_T_CMS, 编码 OSV_CMS)
+ *   d 是一个 struct ocms, 后面紧跟 depth 行 x width 列的 u32 计数器, 行优先
+ *   查询要取 depth 行中各自一个计数器的最小值: x86-64 上一次 AVX2 gather 取 8 行,
+ *   列下标和 min 归约都在向量里完成; 增加是逐行的标量加法 (饱和在 UINT32_MAX)
+ *   depth <= OCMS_DEPTH_MAX, width * depth < 2^31 (gather 的下标是 i32)
+ *
+ * Top-K (osv_type == OSV_T_TOPK, 编码 OSV_TOPK), HeavyKeeper, 与 RedisBloom 的 TOPK 相同:
+ *   d 是一个 struct otopk, 后面是 depth x width 个 {指纹, 计数} 桶, 再后面是 k 个元素的小顶堆
+ *   桶的指纹不同时以 decay^count 的概率减一, 减到 0 时换成新的指纹, 大流量元素留在桶里
+ *   元素的估计值 (各行中指纹相同的桶的最大计数) 不小于堆顶时进入堆, 挤出的元素返回给调用者
+ *   堆中元素的字符串单独分配, 最多 k 个
+ */
+#define OCMS_DEPTH_MAX 16
+#define OTOPK_DECAY_TABLE 256
+
+#define OTOPK_WIDTH_DEFAULT 8
+#define OTOPK_DEPTH_DEFAULT 7
+#define OTOPK_DECAY_DEFAULT 0.9
+
+/** 批量命令一次 hash + 预取多少个元素 */
+#define OSKETCH_BATCH 16
+
+struct ocms {
+    uint32_t width;
+    uint32_t depth;
+    uint64_t count; // 所有增量之和
+    uint32_t c[];
+};
+
+struct otopk_bucket {
+    uint32_t fp;
+    uint32_t count;
+};
+
+struct otopk_item {
+    char *item; // NULL: 空位
+    uint32_t len;
+    uint32_t fp;
+    uint64_t count;
+};
+
+struct otopk {
+    uint32_t k;
+    uint32_t width;
+    uint32_t depth;
+    double decay;
+    uint64_t rng;
+    double decay_pow[OTOPK_DECAY_TABLE]; // decay^i, 更大的计数由表中的值相乘得到
+    struct otopk_bucket b[]; // depth * width 个桶, 之后是 k 个 struct otopk_item (堆)
+};
+
+#define ocmsv_cms(v) ((struct ocms *) (v)->d)
+#define otopkv_tk(v) ((struct otopk *) (v)->d)
+#define otopk_heap(tk) ((struct otopk_item *) ((tk)->b + (uint64_t) (tk)->width * (tk)->depth))
+
+/** 元素的 64 位哈希, CMS 和 Top-K 共用 */
+uint64_t osketch_hash(const char *e, uint64_t len);
+
+/*********************** Count-Min Sketch ******************************/
+
+/** 全 0 的 sketch, 参数由调用者校验 @return NULL 表示 -ENOMEM */
+osv *ocmsv_new(uint32_t width, uint32_t depth);
+
+/**
+ * 由误差和置信度算出尺寸 (同 RedisBloom): 估计值超出 error * count 的概率小于 prob
+ * width = ceil(2 / error), depth = ceil(log(prob) / log(1/2))
+ * @return 0, 或 -EINVAL 尺寸超出上限
+ */
+int ocms_dims(double error, double prob, uint32_t *width, uint32_t *depth);
+
+/** 预取 h 在每一行的计数器 */
+void ocmsv_prefetch(const osv *v, uint64_t h);
+
+/** 各行加 by (饱和), @return 增加后的估计值 */
+uint32_t ocmsv_incrby(osv *v, uint64_t h, uint32_t by);
+
+/** 估计值: 各行计数器的最小值 */
+uint32_t ocmsv_query(const osv *v, uint64_t h);
+
+/*********************** Top-K ******************************/
+
+/** 空的 Top-K, 参数由调用者校验 (decay in (0, 1]) @return NULL 表示 -ENOMEM */
+osv *otopkv_new(uint32_t k, uint32_t width, uint32_t depth, double decay);
+
+/** 释放堆中元素的字符串, 不释放 v 本身 */
+void otopkv_clear(osv *v);
+
+/**
+ * 加入一次元素, h 是 osketch_hash(e, len)
+ * 元素进入堆并挤出另一个元素时, *expelled (由调用者 free) / *elen 是被挤出的元素
+ * @return 1 有元素被挤出, 0 没有, -ENOMEM (堆不变)
+ */
+int otopkv_add(osv *v, const char *e, uint32_t len, uint64_t h, char **expelled, uint32_t *elen);
+
+/**
+ * 堆中的元素按计数从大到小排列, out 至少 k 个
+ * @return 元素个数
+ */
+uint32_t otopkv_list(const osv *v, const struct otopk_item **out);
+
+#endif //SSW_OSV_SKETCH_H
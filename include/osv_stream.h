@@ -0,0 +1,168 @@
+//
+// Created by weishen on 2025/11/16.
+//
+
+#ifndef SSW_OSV_STREAM_H
+#define SSW_OSV_STREAM_H
+#include <stdint.h>
+#include "osv.h"
+
+/**
+ * stream 类型的值 (osv_type == OSV_T_STREAM, 编码只有 OSV_STREAM)
+ * d 中是一个 struct ostream: 只追加的 entry 序列, ID (ms-seq) 严格递增
+ *
+ * entry 打包在宏节点 (struct osnode) 里, 每个节点最多 OSTREAM_NODE_ENTRIES 个 / OSTREAM_NODE_BYTES 字节:
+ *   d[0, mlen)  主字段表: varint 个数 + (varint 长度 + 字节) ...  取自节点的第一个 entry
+ *   d[off, len) entry: [flags][varint ms - master.ms][varint seq][varint n 字段数][字段/值 ...]
+ *               flags & OSE_SAMEFIELDS: 字段名与主字段表相同, 只存值 (没有 n)
+ *   off 之前是已经被 XTRIM 删掉的 entry, 节点整个删除前不回收
+ * 索引: 节点按主 ID 升序放在指针数组里. ID 单调递增, Redis 的 radix tree (rax) 在这里
+ *   退化成有序数组: 追加只动最后一个节点, 按 ID 定位是一次二分 + 节点内顺序解码
+ *
+ * 消费组 (struct osgroup): last_delivered + 待确认列表 (PEL) + 消费者
+ *   PEL 按 ID 升序的数组: 新投递的 ID 总是大于 last_delivered, 追加到尾部;
+ *   XACK 只打删除标记 (consumer == OSPEL_ACKED), 标记多于一半时压缩一次, 查找始终是二分
+ */
+#define OSTREAM_NODE_ENTRIES 100 // 与 Redis 的 stream-node-max-entries 相同
+#define OSTREAM_NODE_BYTES 4096
+
+#define OSE_SAMEFIELDS 0x1
+#define OSPEL_ACKED UINT32_MAX
+
+struct ostream_id {
+    uint64_t ms;
+    uint64_t seq;
+};
+
+struct osnode {
+    struct ostream_id master;
+    uint32_t count; // off 之后的 entry 数
+    uint32_t mlen;
+    uint32_t off;
+    uint32_t len;
+    uint32_t cap;
+    uint8_t d[];
+};
+
+struct ospel {
+    struct ostream_id id;
+    uint32_t consumer; // 下标, OSPEL_ACKED: 已确认
+    uint32_t deliveries;
+    uint64_t delivered_ms;
+};
+
+struct osconsumer {
+    char *name;
+    uint32_t len;
+    uint64_t pending;
+    uint64_t seen_ms;
+};
+
+struct osgroup {
+    char *name;
+    uint32_t len;
+    struct ostream_id last_delivered;
+    struct ospel *pel;
+    uint64_t npel; // 包括已确认的标记
+    uint64_t cpel;
+    uint64_t pending; // 未确认的个数
+    struct osconsumer *consumers;
+    uint32_t nconsumers;
+};
+
+struct ostream {
+    struct osnode **nodes;
+    uint32_t nnodes;
+    uint32_t cnodes;
+    uint64_t length;
+    struct ostream_id last_id;
+    struct osgroup *groups;
+    uint32_t ngroups;
+};
+
+/** 字段或值 */
+struct ostream_str {
+    const char *p;
+    uint32_t len;
+};
+
+/** 解码出来的 entry, 字段用 ostream_entry_next 逐个取出 (BORROWED, 下一次修改 stream 前有效) */
+struct ostream_entry {
+    struct ostream_id id;
+    uint32_t nfields;
+    const uint8_t *p; // 下一个字段 (或 SAMEFIELDS 时的值)
+    const uint8_t *mf; // SAMEFIELDS: 主字段表中的下一个字段, 否则 NULL
+};
+
+struct ostream_iter {
+    const struct ostream *s;
+    uint32_t ni;
+    uint32_t off;
+};
+
+#define ostreamv_s(v) ((struct ostream *) (v)->d)
+
+static inline int ostream_id_cmp(const struct ostream_id *a, const struct ostream_id *b) {
+    if (a->ms != b->ms) return a->ms < b->ms ? -1 : 1;
+    return a->seq < b->seq ? -1 : a->seq > b->seq;
+}
+
+/** 空 stream, NULL 表示 -ENOMEM */
+osv *ostreamv_new(void);
+
+/** 释放所有节点和消费组, 不释放 v 本身 */
+void ostreamv_clear(osv *v);
+
+/** 节点 + 索引 + 消费组占用的字节数 */
+uint64_t ostreamv_bytes(const osv *v);
+
+/**
+ * 追加一个 entry, id 必须大于 last_id (由调用者保证), fv 是 nfields 对字段/值
+ * @return 0, -ENOMEM (stream 不变)
+ */
+int ostreamv_append(osv *v, const struct ostream_id *id, const struct ostream_str *fv, uint32_t nfields);
+
+/** 游标定位到第一个 >= start 的 entry */
+void ostreamv_iter_init(struct ostream_iter *it, const osv *v, const struct ostream_id *start);
+
+/** @return 1 取到一个 entry, 0 结束 */
+int ostreamv_next(struct ostream_iter *it, struct ostream_entry *e);
+
+/** 取出 e 的下一对字段/值 */
+void ostream_entry_next(struct ostream_entry *e, struct ostream_str *f, struct ostream_str *val);
+
+/** @return 1 找到 id, 0 不存在 (从未写入或已被删除) */
+int ostreamv_get(const osv *v, const struct ostream_id *id, struct ostream_entry *e);
+
+/** 删除最旧的 entry 直到长度 <= maxlen; approx 时只删整个节点 @return 删除的个数 */
+uint64_t ostreamv_trim_maxlen(osv *v, uint64_t maxlen, int approx);
+
+/** 删除 ID < minid 的 entry; approx 时只删整个节点 @return 删除的个数 */
+uint64_t ostreamv_trim_minid(osv *v, const struct ostream_id *minid, int approx);
+
+/*********************** 消费组 ******************************/
+
+struct osgroup *ostreamv_group(const osv *v, const char *name, uint32_t len);
+
+/** @return 0, -EEXIST, -ENOMEM */
+int ostreamv_group_create(osv *v, const char *name, uint32_t len, const struct ostream_id *last);
+
+/** @return 1 删除了, 0 不存在 */
+int ostreamv_group_destroy(osv *v, const char *name, uint32_t len);
+
+/** 按名字找消费者, 不存在时 create 则新建 @return 下标, -1 不存在, -ENOMEM */
+int64_t osgroup_consumer(struct osgroup *g, const char *name, uint32_t len, int create);
+
+/** 投递给 consumer: 追加到 PEL, id 必须大于 PEL 中所有的 ID @return 0, -ENOMEM */
+int osgroup_pel_add(struct osgroup *g, const struct ostream_id *id, uint32_t consumer, uint64_t now);
+
+/** 未确认的 id, NULL 表示不在 PEL 中 */
+struct ospel *osgroup_pel_find(const struct osgroup *g, const struct ostream_id *id);
+
+/** 第一个 >= id 且未确认的位置 (下标, 可能等于 npel) */
+uint64_t osgroup_pel_seek(const struct osgroup *g, const struct ostream_id *id);
+
+/** @return 1 确认了, 0 不在 PEL 中 */
+int osgroup_ack(struct osgroup *g, const struct ostream_id *id);
+
+#endif //SSW_OSV_STREAM_H
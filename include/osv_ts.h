@@ -0,0 +1,117 @@
+//
+// Created by weishen on 2025/11/16.
+//
+
+#ifndef SSW_OSV_TS_H
+#define SSW_OSV_TS_H
+#include <stdint.h>
+#include "osv.h"
+
+/**
+ * 时间序列类型的值 (osv_type == OSV_T_TS), 编码只有 OSV_TS
+ * d 中是一个 struct ots: 按时间升序的 chunk 指针数组, 样本只能追加 (时间戳严格递增)
+ *
+ * 每个 chunk 是 Gorilla (Facebook, VLDB 2015) 的位流, 第一个样本原样放在 chunk 头里:
+ *   时间戳: delta-of-delta (dod), 按大小取前缀
+ *     '0' -> dod == 0, '10' + 7 位, '110' + 9 位, '1110' + 12 位, '1111' + 64 位
+ *   值: 与上一个值的 IEEE 754 位模式异或 (xor)
+ *     '0' -> 相同; '10' + 有效位 (前导/尾随 0 的窗口与上一个相同);
+ *     '11' + 5 位前导 0 个数 + 6 位有效位长度 (64 记为 0) + 有效位
+ *   等间隔采样 + 变化缓慢的值, 每个样本 1~2 字节
+ * 位流按高位在前写入, 读写都是一次 8 字节的大端 load/store, chunk 尾部多分配 8 字节
+ * chunk 写满 (剩余位数放不下最坏情况的一个样本) 后新开一个, 范围查询先二分到起始 chunk, 再顺序解码
+ *
+ * retention (毫秒, 0 表示不限): 追加后丢弃最后时间戳早于 last - retention 的整个 chunk
+ */
+#define OTS_CHUNK_SIZE_DEFAULT 4096
+#define OTS_CHUNK_SIZE_MIN 64
+#define OTS_CHUNK_SIZE_MAX (1U << 20)
+
+struct ots_chunk {
+    int64_t first_ts;
+    uint64_t first_bits;
+    int64_t last_ts;
+    uint64_t last_bits; // 最后一个值的位模式
+    int64_t last_delta;
+    uint32_t n; // 样本数
+    uint32_t pos; // 已写入的位数
+    uint32_t cap; // data 的字节数 (不含尾部的 8 字节)
+    uint8_t leading; // 上一个 xor 窗口, leading == 0xff 表示还没有
+    uint8_t trailing;
+    uint8_t data[];
+};
+
+struct ots {
+    struct ots_chunk **chunks;
+    uint32_t nchunks;
+    uint32_t cchunks;
+    uint32_t chunk_size;
+    int64_t retention;
+    uint64_t total; // 所有 chunk 的样本数
+};
+
+struct ots_sample {
+    int64_t ts;
+    double v;
+};
+
+/** 顺序解码的游标 */
+struct ots_iter {
+    const struct ots *s;
+    uint32_t ci; // 当前 chunk
+    uint32_t i; // chunk 内的下一个样本
+    uint32_t pos;
+    int64_t ts;
+    int64_t delta;
+    uint64_t bits;
+    uint8_t leading;
+    uint8_t trailing;
+};
+
+enum ots_agg {
+    OTS_AGG_NONE = 0,
+    OTS_AGG_AVG,
+    OTS_AGG_SUM,
+    OTS_AGG_MIN,
+    OTS_AGG_MAX,
+    OTS_AGG_COUNT,
+};
+
+#define otsv_ts(v) ((struct ots *) (v)->d)
+
+/** 空序列, 参数由调用者校验 @return NULL 表示 -ENOMEM */
+osv *otsv_new(int64_t retention, uint32_t chunk_size);
+
+/** 默认参数 (TS.ADD 自动创建), 签名符合 otype_lookup 的 create */
+osv *otsv_new_default(void);
+
+/** 释放所有 chunk, 不释放 v 本身 */
+void otsv_clear(osv *v);
+
+/** 所有 chunk 占用的字节数 */
+uint64_t otsv_bytes(const osv *v);
+
+/**
+ * 追加一个样本, ts >= 0
+ * @return 0, -EEXIST (ts 等于最后一个时间戳), -ERANGE (ts 更早), -ENOMEM
+ */
+int otsv_add(osv *v, int64_t ts, double val);
+
+/** 最后一个样本 @return 0 序列为空 */
+int otsv_last(const osv *v, struct ots_sample *out);
+
+/** 游标定位到第一个可能包含 >= from 的样本的 chunk 开头 */
+void otsv_iter_init(struct ots_iter *it, const osv *v, int64_t from);
+
+/** @return 1 取到一个样本, 0 结束 */
+int ots_iter_next(struct ots_iter *it, struct ots_sample *out);
+
+/**
+ * [from, to] 内的样本, agg != OTS_AGG_NONE 时按 bucket 毫秒对齐到 0 分桶聚合 (桶的时间戳是桶的起点)
+ * limit > 0 时最多 limit 个结果, *out 由调用者 free
+ * @return 结果个数, 或 -ENOMEM
+ */
+int64_t otsv_range(const osv *v, int64_t from, int64_t to, int agg, int64_t bucket, uint64_t limit,
+                   struct ots_sample **out);
+
+#endif //SSW_OSV_TS_H
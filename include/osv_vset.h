@@ -0,0 +1,109 @@
+//
+// Created by weishen on 2025/11/17.
+//
+
+#ifndef SSW_OSV_VSET_H
+#define SSW_OSV_VSET_H
+#include <stdint.h>
+#include "ohashtable.h"
+#include "osv.h"
+
+/**
+ * 向量集合类型的值 (osv_type == OSV_T_VSET), 编码只有 OSV_VSET
+ * d 中是一个 struct ovset: 元素名 -> 一个 dim 维向量, 按相似度查最近邻
+ *
+ * 存储: 向量按 id (插入顺序) 连续放在 vecs 里, 距离内核顺序读
+ *   OVSET_F32: 原样的 float; COSINE 时插入前先归一化, 距离就是 1 - 点积
+ *   OVSET_Q8:  每个向量一个 scale (max|x| / 127) 的对称 int8 量化, 占 1/4 的内存,
+ *              aux[2 * id] = scale, aux[2 * id + 1] = 反量化后的 |x|^2 (L2 用)
+ *   dict: 元素名 -> id (id 直接放在 slot 的 v 里), names[id] 指向 dict 中的 key
+ *
+ * 查询: 元素个数 <= OVSET_FLAT_MAX 时精确扫描 (AVX2 + FMA 的点积 / L2, int8 用 madd);
+ *   超过后一次性建 HNSW 图 (Malkov & Yashunin), 之后每次 VADD 增量插入:
+ *   第 0 层每个点最多 2M 条边, 放在 links0 的定长槽里 ([n][id ...]);
+ *   第 l >= 1 层每个点最多 M 条边, 只有层数 >= 1 的点 (约 1/M) 才分配 upper[id]
+ *   邻居用启发式选择 (与已选的邻居相比更靠近新点才保留), 插入时 ef 取 ef_construction
+ *   visited 用每次查询递增的 epoch 标记, 不需要每次清零
+ */
+#define OVSET_DIM_MAX 32768
+#define OVSET_FLAT_MAX 1024
+#define OVSET_M_DEFAULT 16
+#define OVSET_M_MAX 128
+#define OVSET_EF_DEFAULT 200
+#define OVSET_EF_MAX 1000000
+#define OVSET_LEVEL_MAX 16
+
+enum ovset_metric {
+    OVSET_COSINE = 0,
+    OVSET_L2 = 1,
+};
+
+enum ovset_quant {
+    OVSET_F32 = 0,
+    OVSET_Q8 = 1,
+};
+
+struct ovname {
+    const char *p; // dict 中的 key
+    uint32_t len;
+};
+
+struct ovset {
+    uint32_t dim;
+    uint8_t metric;
+    uint8_t quant;
+    uint32_t stride; // 一个向量的字节数
+    uint64_t count;
+    uint64_t cap;
+    uint8_t *vecs;
+    float *aux; // OVSET_Q8
+    struct ovname *names;
+    otable_t dict;
+    // HNSW, links0 == NULL 时还是精确扫描
+    uint32_t m;
+    uint32_t ef; // ef_construction
+    uint32_t *links0; // cap * (1 + 2m)
+    uint32_t **upper; // upper[id]: level[id] * (1 + m), level 0 的点为 NULL
+    uint8_t *level;
+    uint32_t entry;
+    uint32_t max_level;
+    uint32_t *visited;
+    uint32_t epoch;
+    uint64_t rng;
+};
+
+/** 查询结果, dist: COSINE 是 1 - cos, L2 是距离的平方 */
+struct ovhit {
+    uint32_t id;
+    float dist;
+};
+
+#define ovsetv_s(v) ((struct ovset *) (v)->d)
+
+/** 空集合, NULL 表示 -ENOMEM */
+osv *ovsetv_new(uint32_t dim, enum ovset_metric metric, enum ovset_quant quant, uint32_t m, uint32_t ef);
+
+/** 释放向量, 图和 dict, 不释放 v 本身 */
+void ovsetv_clear(osv *v);
+
+uint64_t ovsetv_bytes(const osv *v);
+
+/** 元素的 id, -1 表示不存在 */
+int64_t ovsetv_find(const osv *v, const char *name, uint32_t len);
+
+/**
+ * 插入一个元素, x 是 dim 个 float (COSINE 时不需要事先归一化)
+ * 元素已存在时什么都不做
+ * @return 1 新元素, 0 已存在, -ENOMEM (集合不变)
+ */
+int ovsetv_add(osv *v, const char *name, uint32_t len, const float *x);
+
+/**
+ * k 个最近邻, 按距离升序写入 out (容量 >= k)
+ * 查询向量是 x (dim 个 float), x == NULL 时用已有元素 id 的向量
+ * exact 或者还没有建图时精确扫描, 否则 HNSW 搜索, ef 取 max(ef, k)
+ * @return 结果个数
+ */
+uint32_t ovsetv_search(osv *v, const float *x, uint32_t id, uint32_t k, uint32_t ef, int exact, struct ovhit *out);
+
+#endif //SSW_OSV_VSET_H
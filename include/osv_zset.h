@@ -0,0 +1,112 @@
+//
+// Created by weishen on 2025/11/11.
+//
+
+#ifndef SSW_OSV_ZSET_H
+#define SSW_OSV_ZSET_H
+#include "ohashtable.h"
+#include "osv.h"
+
+/**
+ * sorted set 类型的值 (osv_type == OSV_T_ZSET), 两种编码:
+ *
+ * OSV_ZSET_PACK: 小集合, d 是按 (score, member) 排好序的 entry 序列
+ *   entry = [double score][u8 mlen][member]
+ *   余量记在 spare, 与 OSV_HASH_PACK 相同
+ *
+ * OSV_ZSET_TREE: 成员数超过 OSV_ZSET_PACK_ENTRIES, 或者某个 member 超过
+ *   OSV_ZSET_PACK_VALUE 字节时一次性转换 (不会再转回去). d 中是一个 struct ozset:
+ *   dict: otable_t, member -> score (score 的位模式直接放在 slot 的 v 里, 不另外分配)
+ *   tree: 以 (score, member) 为 key 的 B+ 树, 叶子里是 {score, member 指针} 的数组,
+ *         member 指针指向 dict 中的 key, 不再复制一份
+ *   内部节点记录每个子树的元素个数, 按名次定位 / 求名次都是 O(log n)
+ *   宽节点 (64 路) 让一次查找只碰到 3 ~ 4 个节点, 范围查询在叶子链表上顺序读
+ *
+ * 阈值与 Redis 的 zset-max-listpack-entries / zset-max-listpack-value 默认值相同
+ */
+#define OSV_ZSET_PACK_ENTRIES 128
+#define OSV_ZSET_PACK_VALUE 64
+
+#define OZ_LEAF 64
+#define OZ_FAN 64
+
+struct ozent {
+    double score;
+    const char *m;
+    uint32_t mlen;
+};
+
+struct ozleaf {
+    struct ozleaf *prev, *next;
+    uint32_t n;
+    struct ozent e[OZ_LEAF];
+};
+
+/**
+ * k[i] (i >= 1) 是子树 c[i] 中最小的元素, 查找时取最大的 k[i] <= key; k[0] 不使用
+ * cnt[i] 是子树 c[i] 中的元素个数
+ */
+struct ozinner {
+    uint32_t n;
+    uint64_t cnt[OZ_FAN];
+    void *c[OZ_FAN];
+    struct ozent k[OZ_FAN];
+};
+
+struct ozset {
+    otable_t dict;
+    void *root; // len == 0 时为 NULL
+    uint32_t height; // 0: root 是叶子
+    uint64_t len;
+    struct ozleaf *first;
+};
+
+#define ozv_set(v) ((struct ozset *) (v)->d)
+
+/** 空的 OSV_ZSET_PACK, NULL 表示 -ENOMEM */
+osv *ozv_new(void);
+
+/** 释放嵌套结构, 不释放 v 本身 */
+void ozv_clear(osv *v);
+
+uint64_t ozv_len(const osv *v);
+
+/** @return 1 找到 (*score), 0 不存在 */
+int ozv_score(const osv *v, const char *m, uint32_t mlen, double *score);
+
+/**
+ * 写入 member 的 score, 必要时扩容或转换编码, *pv 可能被替换 (调用者写回 slot->v)
+ * score 不能是 NaN
+ * @return 1 新成员, 0 已有成员 (score 可能没变), -ENOMEM (集合不变)
+ */
+int ozv_add(osv **pv, const char *m, uint32_t mlen, double score);
+
+/** @return 1 已删除, 0 不存在 */
+int ozv_del(osv *v, const char *m, uint32_t mlen);
+
+/** 升序名次 (从 0 开始) @return 1 找到, 0 不存在 */
+int ozv_rank(const osv *v, const char *m, uint32_t mlen, uint64_t *rank);
+
+/**
+ * 按 (score, member) 升序遍历, 遍历中不能修改集合
+ * member 指向集合内部 (BORROWED)
+ */
+struct ozv_iter {
+    const osv *v;
+    const struct ozleaf *leaf; // OSV_ZSET_TREE
+    uint64_t pos; // PACK: 字节偏移; TREE: 叶子内下标
+};
+
+/** 从名次 rank 开始 */
+void ozv_iter_rank(struct ozv_iter *it, const osv *v, uint64_t rank);
+
+/**
+ * 从第一个 score >= min (exclusive 时 > min) 的元素开始
+ * @return 该元素的名次 (== len 表示没有)
+ */
+uint64_t ozv_iter_score(struct ozv_iter *it, const osv *v, double min, int exclusive);
+
+/** @return 1 取到一项, 0 结束 */
+int ozv_next(struct ozv_iter *it, const char **m, uint32_t *mlen, double *score);
+
+#endif //SSW_OSV_ZSET_H
@@ -0,0 +1,71 @@
+//
+// Created by weishen on 2025/11/2.
+//
+
+#ifndef SSW_OTIER_H
+#define SSW_OTIER_H
+#include "ohashtable.h"
+#include "osv.h"
+
+/**
+ * Tiered storage: cold osv values spill to an append-only local file
+ *
+ * - keys and the ohash index never leave RAM, a miss costs exactly what it did before
+ * - a spilled value is replaced in its slot by a 24 byte OSV_COLD stub
+ *   (vlen + meta + file offset), the original osv is freed
+ * - "cold" is decided by CLOCK: GET sets osv.ref, otier_evict walks the table with a
+ *   hand, clears ref on the first pass and spills on the second
+ * - GET on a stub preads the value back and promotes it (the stub is freed)
+ *
+ * The file is never rewritten in place, promoted/overwritten records are only
+ * accounted in dead_bytes. The RAM index is not persisted, so otier_open truncates.
+ *
+ * Tiered mode assumes the values were allocated with malloc (SET4dup),
+ * promote/evict allocate and free with libc.
+ */
+#define OTIER_MIN_SPILL 64 // 小于它的值下沉后 stub 省不了多少内存
+#define OTIER_WBUF_SIZE (1U << 20) // evict 的批量写缓冲
+
+struct otier_stats {
+    uint64_t disk_hits; // promote 次数
+    uint64_t disk_read_ns; // promote 中 pread 的总耗时
+    uint64_t spilled; // 下沉的值个数
+    uint64_t spilled_bytes;
+    uint64_t file_bytes; // 文件尾
+    uint64_t dead_bytes; // 已被 promote 的记录 (文件中的垃圾)
+};
+
+extern struct otier_stats otier_stats;
+
+int otier_open(const char *path);
+
+int otier_close(void);
+
+/**
+ * Run the CLOCK hand until roughly `bytes` of value payload have been spilled,
+ * or two full laps have been made (everything left is hot or too small).
+ * Spilled records are written with one pwrite per OTIER_WBUF_SIZE batch, slots
+ * are only switched to stubs after their batch reached the file.
+ *
+ * @return bytes of payload released from RAM, or <0 (-errno)
+ */
+long long otier_evict(uint64_t bytes);
+
+/**
+ * slot->v must be an OSV_COLD stub. Reads the value back, installs it in the
+ * slot (ref=1) and frees the stub.
+ * @return the promoted osv, NULL on IO/alloc failure (the stub stays in place)
+ */
+osv *otier_promote(ohash_t *slot);
+
+/**
+ * Asynchronous hint: if key is cold, start kernel readahead of its record so the
+ * following GET is served from the page cache. Batched readers call this for every
+ * key first, then GET them.
+ */
+void otier_prefetch(char *key, uint32_t keylen);
+
+/** otier_prefetch for a slot already found (no-op unless slot->v is a stub) */
+void otier_prefetch_slot(ohash_t *slot);
+
+#endif //SSW_OTIER_H
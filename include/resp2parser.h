@@ -7,13 +7,17 @@
 #include "noblock_sserver.h"
 #include "limits.h"
 #include "errno.h"
+#include <stdint.h>
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
 
 #if LLONG_MAX == 9223372036854775807LL
 #define try_parser_num try_parser_positive_num_str_64
 #else
 #define try_parser_num try_parser_positive_num_str
 #endif
-#define MAX_ARRAY_ELEMENTS 50
+#define MAX_ARRAY_ELEMENTS 1024 // MGET/MSET 一次携带几百个 key
 /**
  * state 处理拆粘包的状态
  * 它不需要太复杂的状态
@@ -62,15 +66,26 @@ struct parser_process {
 };
 
 
+/**
+ * command_proceed 的断点: 一条 *N 命令只到了一部分时, 记住已经切好的参数个数和下一个参数的位置
+ * base 是命令起点的地址 (只用来比较): 缓冲区扩容 / 压缩后命令挪了位置, 已切好的 element 指针失效, 从头再切
+ */
+struct command_process {
+    uintptr_t base;
+    uint32_t argc; // 0 表示没有断点
+    uint32_t done; // 已切好的参数个数
+    long long pos; // 下一个参数相对 base 的偏移
+};
+
 struct element {
     protocol_type type;
-    uint16_t len;
+    uint32_t len; // bulk 最大 BUFFER_SIZE_MAX (1G), uint16_t 会截断 64K 以上的值
     char *data;
 };
 
 struct simple_segment_context {
-    uint8_t element_count; // 已接收元素数
-    uint8_t expected_count; // 期望元素数（数组长度）
+    uint16_t element_count; // 已接收元素数
+    uint16_t expected_count; // 期望元素数（数组长度）
     uint8_t consumed: 1; // 命令是否完整
     uint8_t in_array: 1; // 是否在数组中
     struct element elements[MAX_ARRAY_ELEMENTS];
@@ -125,6 +140,7 @@ struct parser_context {
     // 输出与进度
     struct parser_out outframe; // 当前帧数据
     struct parser_process prog; // 解析进度
+    struct command_process cmdprog; // command_proceed 的断点
     struct simple_segment_context segment_context;
 };
 
@@ -132,14 +148,10 @@ struct parser_context {
 /*********************** inline of hot path ******************************/
 /**
  *  accₖ = Σ_{i=0}^{k−1} dᵢ · 10^{k−1−i}
- *
+ *  逐位解析, 每一位一个分支 + 溢出检查; 只给 SWAR 版本处理不了的情况 (> 19 位, 大端) 兜底
  */
 static inline long long
-try_parser_positive_num_str_64(const char *restrict bf, size_t len) {
-#ifndef NDEBUG
-    if (!bf) return -EINVAL;
-#endif
-    if (!len) return 0;
+try_parser_positive_num_str_64_scalar(const char *restrict bf, size_t len) {
     long long acc = 0;
     for (size_t i = 0; i < len; ++i) {
         unsigned char uc = (unsigned char) bf[i];
@@ -152,6 +164,120 @@ try_parser_positive_num_str_64(const char *restrict bf, size_t len) {
     return acc;
 }
 
+/**
+ * SWAR: 一个 u64 里的 8 个 ASCII 数字 (第一个在最低字节)
+ * 合法: 每个字节的高半字节是 3, 并且加 6 之后不进位到高半字节 (<= '9')
+ */
+static inline int swar_is_8digits(uint64_t x) {
+    return ((x & 0xF0F0F0F0F0F0F0F0ULL) | (((x + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+           0x3333333333333333ULL;
+}
+
+/** 相邻的位两两合并: 1 位 -> 2 位 -> 4 位 -> 8 位, 三次乘法 + 移位 */
+static inline uint64_t swar_8digits(uint64_t x) {
+    x = (x & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+    x = (x & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+    return (x & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32;
+}
+
+/** k (1..8) 个数字 -> 值, 不读 bf[k] 之后; 不足 8 个时在前面补 '0' @return -1 表示有非数字 */
+static inline long long swar_digits(const char *bf, size_t k) {
+    uint64_t x = 0;
+    if (k == 8) {
+        memcpy(&x, bf, 8);
+    } else {
+        unsigned sh = 0;
+        if (k & 4) {
+            uint32_t t;
+            memcpy(&t, bf, 4);
+            x = t;
+            sh = 32;
+        }
+        if (k & 2) {
+            uint16_t t;
+            memcpy(&t, bf + (k & 4), 2);
+            x |= (uint64_t) t << sh;
+            sh += 16;
+        }
+        if (k & 1) x |= (uint64_t) (unsigned char) bf[k - 1] << sh;
+        sh = 8 * (8 - (unsigned) k);
+        x = x << sh | 0x3030303030303030ULL >> (64 - sh);
+    }
+    if (!swar_is_8digits(x)) return -1;
+    return (long long) swar_8digits(x);
+}
+
+/**
+ * $<len> / *<n> 的非负整数, 每条命令要解析好几次
+ * 1-4 位 (绝大多数长度) 直接展开, 不需要溢出检查;
+ * 更长的先转换 len % 8 位, 再 8 位一组 SWAR 转换, 只有 19 位时才可能溢出
+ * @return 值, -1 表示不是非负整数或者溢出; 空串是 0
+ */
+static inline long long
+try_parser_positive_num_str_64(const char *restrict bf, size_t len) {
+#ifndef NDEBUG
+    if (!bf) return -EINVAL;
+#endif
+    if (!len) return 0;
+    if (len <= 4) {
+        unsigned acc = 0;
+        for (size_t i = 0; i < len; ++i) {
+            unsigned d = (unsigned char) bf[i] - (unsigned) '0';
+            if (d > 9) return -1;
+            acc = acc * 10 + d;
+        }
+        return acc;
+    }
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (len <= 19) {
+        size_t head = len & 7 ? len & 7 : 8;
+        long long acc = swar_digits(bf, head);
+        if (acc < 0) return -1;
+        for (size_t i = head; i < len; i += 8) {
+            long long c = swar_digits(bf + i, 8);
+            if (c < 0) return -1;
+            if (__builtin_mul_overflow(acc, 100000000LL, &acc) || __builtin_add_overflow(acc, c, &acc)) return -1;
+        }
+        return acc;
+    }
+#endif
+    return try_parser_positive_num_str_64_scalar(bf, len);
+}
+
+/**
+ * ':' 帧的有符号整数: [+-]<digits>, 范围是完整的 long long (包括 LLONG_MIN)
+ * @return 0 或 -1 (空, 不是整数, 溢出)
+ */
+static inline int
+try_parser_signed_num_str_64(const char *restrict bf, size_t len, long long *out) {
+    int neg = 0;
+    if (len && (bf[0] == '-' || bf[0] == '+')) {
+        neg = bf[0] == '-';
+        bf++;
+        len--;
+    }
+    if (!len) return -1;
+    // |LLONG_MIN| 不能表示成正数
+    if (neg && len == 19 && !memcmp(bf, "9223372036854775808", 19)) {
+        *out = LLONG_MIN;
+        return 0;
+    }
+    long long v = try_parser_positive_num_str_64(bf, len);
+    if (v < 0) return -1;
+    *out = neg ? -v : v;
+    return 0;
+}
+
+/**
+ * NUMERIC 帧的值, 分帧时不解析, 用到值的地方再调用 (热路径上的 ':' 只切帧)
+ * @return 0 或 -1 (不是 ':' 帧, 不是整数, 溢出)
+ */
+static inline int
+frame_integer(const struct parser_out *f, long long *out) {
+    if (f->type != NUMERIC) return -1;
+    return try_parser_signed_num_str_64(f->start_rbp, f->data_len, out);
+}
+
 static inline long long
 try_parser_positive_num_str(const char *restrict bf, size_t len) {
 #ifndef NDEBUG
@@ -259,6 +385,49 @@ static inline char *get_next_crlf_rp_memchr_inline(const char *buffer, unsigned
 }
 
 
+/**
+ * SIMD 扫描 (resp2parser.c), 运行时选择 AVX2 32 字节 / SSE2 16 字节 / 标量
+ * 只读 [p, p + n), 不会越过 rb_size
+ * resp_scan_crlf: 第一个完整 "\r\n" 中 \r 的偏移, -1 表示没有
+ * resp_scan_prefix: 第一个 prefix 字节 (+ - : $ *) 的偏移, -1 表示没有
+ */
+long long resp_scan_crlf(const char *p, long long n);
+
+long long resp_scan_prefix(const char *p, long long n);
+
+/**
+ * find next complete CRLF
+ * 小参数的行 ("$3\r\n", "SET\r\n") 几乎都落在前 16 字节里, 这一组在这里内联用 SSE2 比较:
+ * \r 的掩码和右移一位的 \n 掩码相与, 最低位就是答案; 没有时从第 15 字节起交给 resp_scan_crlf
+ * (第 15 字节的 \r 要看第 16 字节). 不足 16 字节走 memchr
+ */
+static inline long long get_next_crlf_simd_inline(const char *buffer, long long cap) {
+#if defined(__x86_64__)
+    if (cap >= 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i *) buffer);
+        unsigned r = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+        unsigned nl = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+        unsigned m = r & (nl >> 1);
+        if (m) return __builtin_ctz(m);
+        long long rest = resp_scan_crlf(buffer + 15, cap - 15);
+        return rest < 0 ? -1 : rest + 15;
+    }
+#endif
+    return get_next_crlf_memchr_inline(buffer, (unsigned long long) cap);
+}
+
+/**
+ * find next prefix
+ * 完整的命令之间没有多余字节, prefix 通常就是第一个字节, 只有它不是时才做 SIMD 扫描
+ */
+static inline long long get_next_prefix_inline(const char *buffer, long long cap) {
+    if (cap <= 0) return -1;
+    if (is_prefix[(unsigned char) buffer[0]]) return 0;
+    long long i = resp_scan_prefix(buffer + 1, cap - 1);
+    return i < 0 ? -1 : i + 1;
+}
+
+
 static inline void clear_prog(struct parser_context *ctx) {
     ctx->prog.anchorpoint_offset = 0;
     ctx->prog.bulk_len = 0;
@@ -371,21 +540,15 @@ static inline int zerocopy_proceed(struct parser_context *ctx) {
         if (cn->rb_offset == cn->rb_size)
             goto waitingout;
 
-        long long i;
-        for (i = 0; i < remaining; ++i) {
-            char c = start[i];
-            if (is_prefix[(unsigned char) c]) {
-                prefix = c;
-                anchorpoint = start + i;
-                break;
-            }
-        }
-        if (!prefix) {
+        long long i = get_next_prefix_inline(start, remaining);
+        if (i < 0) {
             ctx->prog.prefix = prefix;
             goto waitingout;
         }
-        size_t cap = (cn->read_buffer + cn->rb_size) - (anchorpoint + 1);
-        long long next_crlf_len = get_next_crlf_memchr_inline(anchorpoint + 1, cap);
+        prefix = start[i];
+        anchorpoint = start + i;
+        long long cap = (cn->read_buffer + cn->rb_size) - (anchorpoint + 1);
+        long long next_crlf_len = get_next_crlf_simd_inline(anchorpoint + 1, cap);
         if (next_crlf_len < 0) {
             ctx->prog.prefix = prefix;
             goto waitingout;
@@ -471,18 +634,13 @@ static inline int zerocopy_proceed(struct parser_context *ctx) {
 
         long long i = 0;
         if (!prefix_waiting) {
-            for (i = 0; i < remaining; ++i) {
-                char c = anchorpoint_start[i];
-                if (is_prefix[(unsigned char) c]) {
-                    prefix_waiting = c;
-                    anchorpoint_start = anchorpoint_start + i;
-                    break;
-                }
-            }
-            if (!prefix_waiting) goto waitingout;
+            i = get_next_prefix_inline(anchorpoint_start, remaining);
+            if (i < 0) goto waitingout;
+            prefix_waiting = anchorpoint_start[i];
+            anchorpoint_start = anchorpoint_start + i;
         }
-        size_t cap = (cn->read_buffer + cn->rb_size) - (anchorpoint_start + 1);
-        long long next_crlf_len = get_next_crlf_memchr_inline(anchorpoint_start + 1, cap);
+        long long cap = (cn->read_buffer + cn->rb_size) - (anchorpoint_start + 1);
+        long long next_crlf_len = get_next_crlf_simd_inline(anchorpoint_start + 1, cap);
         if (next_crlf_len < 0) {
             ctx->prog.prefix = prefix_waiting;
             goto waitingout;
@@ -583,6 +741,99 @@ errorpprotocol:
 }
 
 
+/**
+ * <digits>\r\n, 边扫边累加, 最多 10 位 (长度 < BUFFER_SIZE_MAX, 参数个数 < MAX_ARRAY_ELEMENTS)
+ * @return 1 (*pp 移到 \r\n 之后), 0 数据不全, -1 形状不对
+ */
+static inline int command_scan_len(char **pp, const char *end, long long *out) {
+    char *p = *pp;
+    long long acc = 0;
+    int nd = 0;
+    for (;; p++, nd++) {
+        if (p >= end) return 0;
+        unsigned d = (unsigned char) *p - (unsigned) '0';
+        if (d > 9) break;
+        if (nd == 10) return -1;
+        acc = acc * 10 + d;
+    }
+    if (!nd || *p != '\r') return -1;
+    if (p + 1 >= end) return 0;
+    if (p[1] != '\n') return -1;
+    *pp = p + 2;
+    *out = acc;
+    return 1;
+}
+
+/**
+ * @brief       单趟解析一整条 *N\r\n$len\r\n<data>\r\n... 命令, (ptr, len) 直接写进 segment_context.elements
+ * @details     zerocopy_proceed 每次只切一帧, 再由 segment_proceed 聚合; 这里一次线性扫描切完整条命令,
+ *              中间没有帧状态的切换, 连接的字段只在开头读一次
+ *              pipeline 下缓冲区里是一串完整的命令, 每条都走这里
+ *
+ *              只认 "*N 个 $ 参数" 这一种形状 (客户端发的命令都是这样);
+ *              其他前缀, 空数组, 格式错误都交给逐帧的 zerocopy_proceed, 由它给出原来的回复和错误
+ *
+ *              数据不全时 (拆包) 在 ctx->cmdprog 里记下断点, 下一次从断点继续, 已经切好的参数不再扫描
+ *
+ * 只能在两条命令之间调用 (segment_context 不在数组中, state == COMPLETE)
+ * @return 1: 一条完整的命令, element_count 个参数, rb_offset 已经前进
+ * @return 0: 数据不全 (或者缓冲区已经空了), rb_offset 不变
+ * @return -EAGAIN: 不是这种形状, 改用 zerocopy_proceed + segment_proceed
+ */
+static inline int command_proceed(struct parser_context *ctx) {
+    struct connection_t *cn = ctx->connection;
+    struct command_process *cp = &ctx->cmdprog;
+    struct simple_segment_context *stx = &ctx->segment_context;
+    char *base = cn->read_buffer + cn->rb_offset;
+    const char *end = cn->read_buffer + cn->rb_size;
+    char *p = base;
+    long long n, len;
+    uint32_t k = 0;
+
+    if (cp->argc && cp->base == (uintptr_t) base) {
+        n = cp->argc;
+        k = cp->done;
+        p = base + cp->pos;
+    } else {
+        cp->argc = 0;
+        if (p >= end) return 0;
+        if (*p != '*') return -EAGAIN;
+        p++;
+        int r = command_scan_len(&p, end, &n);
+        if (r <= 0) return r ? -EAGAIN : 0;
+        if (n == 0 || n >= MAX_ARRAY_ELEMENTS) return -EAGAIN;
+    }
+    for (; k < n; k++) {
+        char *q = p;
+        if (q >= end) goto more;
+        if (*q != '$') goto fallback;
+        q++;
+        int r = command_scan_len(&q, end, &len);
+        if (!r) goto more;
+        if (r < 0 || len >= BUFFER_SIZE_MAX) goto fallback;
+        if (end - q < len + 2) goto more;
+        if (q[len] != '\r' || q[len + 1] != '\n') goto fallback;
+        stx->elements[k].type = BULK_STRINGS;
+        stx->elements[k].len = (uint32_t) len;
+        stx->elements[k].data = q;
+        p = q + len + 2;
+    }
+    cp->argc = 0;
+    stx->element_count = (uint16_t) n;
+    cn->rb_offset += p - base;
+    return 1;
+more:
+    cp->base = (uintptr_t) base;
+    cp->argc = (uint32_t) n;
+    cp->done = k;
+    cp->pos = p - base;
+    return 0;
+fallback:
+    cp->argc = 0;
+    return -EAGAIN;
+}
+
+
 static inline int create_ctx(struct connection_t *connection) {
     struct parser_context *ctx_n = calloc(sizeof(struct parser_context), 1);
     if (!ctx_n) return -ENOMEM;
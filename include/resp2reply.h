@@ -0,0 +1,132 @@
+//
+// Created by weishen on 2025/11/8.
+//
+
+#ifndef SSW_RESP2REPLY_H
+#define SSW_RESP2REPLY_H
+#include "noblock_sserver.h"
+#include "errno.h"
+#include "inttypes.h"
+
+/**
+ * RESP2 回复编码器
+ *
+ * 所有回复都直接追加到 connection_t.write_buffer 的 [wb_limit, wb_cap) 区间
+ * wb_limit 前进, wb_offset 由 writere 消费
+ * 写缓冲不足时 reply_grow 先把未发送的部分挪到头部 再按 2 倍扩容 (上限 BUFFER_SIZE_MAX)
+ *
+ * 每个函数返回 0 或 -ENOMEM / -EMSGSIZE, 失败时 write_buffer 不变
+ */
+
+int reply_grow(struct connection_t *cn, long long need);
+
+static inline int reply_reserve(struct connection_t *cn, long long need) {
+    if (cn->wb_cap - cn->wb_limit >= need) return 0;
+    return reply_grow(cn, need);
+}
+
+/**
+ * 写入十进制, 返回写入的字节数 (最多 20)
+ * 先反向写进临时区再一次拷贝, 比 snprintf 快一个数量级
+ */
+static inline int ll2str(char *bf, long long v) {
+    char tmp[24];
+    int n = 0, neg = v < 0;
+    unsigned long long u = neg ? 0ULL - (unsigned long long) v : (unsigned long long) v;
+    do {
+        tmp[n++] = (char) ('0' + u % 10);
+        u /= 10;
+    } while (u);
+    int len = n + neg;
+    if (neg) *bf++ = '-';
+    while (n) *bf++ = tmp[--n];
+    return len;
+}
+
+static inline int reply_raw(struct connection_t *cn, const char *p, long long len) {
+    int ret = reply_reserve(cn, len);
+    if (ret < 0) return ret;
+    memcpy(cn->write_buffer + cn->wb_limit, p, len);
+    cn->wb_limit += len;
+    return 0;
+}
+
+/** <prefix><num>\r\n , 用于 : * $ 三种头 */
+static inline int reply_prefixed_num(struct connection_t *cn, char prefix, long long v) {
+    int ret = reply_reserve(cn, 24);
+    if (ret < 0) return ret;
+    char *w = cn->write_buffer + cn->wb_limit;
+    *w = prefix;
+    int n = ll2str(w + 1, v);
+    w[n + 1] = '\r';
+    w[n + 2] = '\n';
+    cn->wb_limit += n + 3;
+    return 0;
+}
+
+static inline int reply_ok(struct connection_t *cn) {
+    return reply_raw(cn, "+OK\r\n", 5);
+}
+
+static inline int reply_nil(struct connection_t *cn) {
+    return reply_raw(cn, "$-1\r\n", 5);
+}
+
+static inline int reply_simple(struct connection_t *cn, const char *s, long long len) {
+    int ret = reply_reserve(cn, len + 3);
+    if (ret < 0) return ret;
+    char *w = cn->write_buffer + cn->wb_limit;
+    *w = '+';
+    memcpy(w + 1, s, len);
+    w[len + 1] = '\r';
+    w[len + 2] = '\n';
+    cn->wb_limit += len + 3;
+    return 0;
+}
+
+/** msg 不含前缀 '-', 例如 "ERR syntax error" */
+static inline int reply_error(struct connection_t *cn, const char *msg) {
+    long long len = (long long) strlen(msg);
+    int ret = reply_reserve(cn, len + 3);
+    if (ret < 0) return ret;
+    char *w = cn->write_buffer + cn->wb_limit;
+    *w = '-';
+    memcpy(w + 1, msg, len);
+    w[len + 1] = '\r';
+    w[len + 2] = '\n';
+    cn->wb_limit += len + 3;
+    return 0;
+}
+
+static inline int reply_int(struct connection_t *cn, long long v) {
+    return reply_prefixed_num(cn, ':', v);
+}
+
+static inline int reply_array(struct connection_t *cn, long long n) {
+    return reply_prefixed_num(cn, '*', n);
+}
+
+/** reply_bulk 写出的总字节数, 用于批量回复先一次 reserve */
+static inline long long reply_bulk_len(long long len) {
+    long long digits = 1;
+    for (long long x = len; x >= 10; x /= 10) digits++;
+    return 1 + digits + 2 + len + 2;
+}
+
+/** 头和数据一次 reserve, 一次完成 */
+static inline int reply_bulk(struct connection_t *cn, const char *p, long long len) {
+    int ret = reply_reserve(cn, len + 24 + 2);
+    if (ret < 0) return ret;
+    char *w = cn->write_buffer + cn->wb_limit;
+    *w = '$';
+    int n = ll2str(w + 1, len) + 1;
+    w[n] = '\r';
+    w[n + 1] = '\n';
+    memcpy(w + n + 2, p, len);
+    w[n + 2 + len] = '\r';
+    w[n + 3 + len] = '\n';
+    cn->wb_limit += n + 4 + len;
+    return 0;
+}
+
+#endif //SSW_RESP2REPLY_H
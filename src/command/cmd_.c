@@ -3,3 +3,276 @@
 //
 
 #include "cmd_.h"
+
+#include <ctype.h>
+#include <float.h>
+
+/**
+ * cmd_.h 中的命令是 C99 inline definition
+ * 这里提供唯一的 external definition, 编译器不内联时链接到这里
+ */
+extern inline int
+SET4dup_(const char *key, uint32_t u30keylen, const void *v, uint64_t vlen, uint64_t expired,
+         malloc_ malloc_func, free_ free_func);
+
+extern inline int
+SET4dup(const char *key, uint32_t u30keylen, const void *v, uint64_t vlen, uint64_t expired);
+
+extern inline int
+SET4own(const char *key, uint32_t u30keylen, osv *v);
+
+extern inline int
+SETOPT4dup(const char *key, uint32_t u30keylen, const void *v, uint64_t vlen, uint64_t expired,
+           int flags, osv **old);
+
+extern inline osv *
+GET(char *key, uint32_t u30keylen);
+
+extern inline osv *
+GETDEL(char *key, uint32_t u30keylen, int *err);
+
+extern inline osv *
+GETEX(char *key, uint32_t u30keylen, int set_ttl, uint64_t expired);
+
+extern inline int
+DEL(char *key, uint32_t u30keylen, free_ free_func);
+
+extern inline int
+EXPIRED(char *key, uint32_t u30keylen, uint64_t expired);
+
+extern inline void
+MGET(obatch_t *b, uint32_t n);
+
+extern inline int
+MSET4dup(obatch_t *b, uint32_t n, uint64_t expired);
+
+extern inline int
+MDEL(obatch_t *b, uint32_t n, free_ free_func);
+
+extern inline int
+INCRBY(char *key, uint32_t u30keylen, int64_t by, int64_t *out);
+
+extern inline int
+INCRBYFLOAT(char *key, uint32_t u30keylen, long double by, osv **out);
+
+extern inline int
+APPEND(char *key, uint32_t u30keylen, const char *p, uint64_t len, uint64_t *out);
+
+extern inline int
+SETRANGE(char *key, uint32_t u30keylen, uint64_t offset, const char *p, uint64_t len, uint64_t *out);
+
+extern inline int
+THROTTLE(char *key, uint32_t u30keylen, int64_t burst, int64_t interval, int64_t quantity, int64_t now,
+         struct othrottle *out);
+
+void
+osv_free_with(void *v, free_ free_func) {
+    osv *o = v;
+    // 只有嵌套结构需要先释放内部; 其余编码 (包括冷值 stub) 都是一整块
+    if (o->enc == OSV_HASH_TABLE) otable_destroy(ohv_table(o), free);
+    else if (o->enc == OSV_LIST_QUICK) olv_clear(o);
+    else if (o->enc == OSV_ZSET_TREE) ozv_clear(o);
+    else if (o->enc == OSV_SET_TABLE) osetv_clear(o);
+    else if (o->enc == OSV_BLOOM) obloomv_clear(o);
+    else if (o->enc == OSV_TOPK) otopkv_clear(o);
+    else if (o->enc == OSV_TS) otsv_clear(o);
+    else if (o->enc == OSV_STREAM) ostreamv_clear(o);
+    else if (o->enc == OSV_VSET) ovsetv_clear(o);
+    free_func(o);
+}
+
+void
+osv_free(void *v) {
+    osv_free_with(v, free);
+}
+
+int
+osv_expand(void) {
+    return expand_capacity_kv(free, osv_free);
+}
+
+ohash_t *
+otype_lookup(char *key, uint32_t u30keylen, int type, osv *(*create)(void), int *err) {
+    *err = 0;
+#ifndef NDEBUG
+    if (!IS_VALID_KEY_LEN(u30keylen)) {
+        *err = -EINVAL;
+        return NULL;
+    }
+#endif
+    int found;
+    uint64_t hash;
+    ohash_t *slot = oprobe(key, u30keylen, &hash, &found);
+    if (found) {
+        if (osv_type((osv *) slot->v) != type) {
+            *err = -EWRONGTYPE;
+            return NULL;
+        }
+        return slot;
+    }
+    if (!create) return NULL;
+    char *key_dup = malloc(u30keylen);
+    osv *v = create();
+    if (!key_dup || !v) goto failure;
+    memcpy(key_dup, key, u30keylen);
+    if (!slot) {
+        if (osv_expand() < 0) goto failure;
+        slot = oprobe(key, u30keylen, &hash, &found);
+    }
+    oret_t ot = {0};
+    if (oclaim(slot, key_dup, u30keylen, hash, v, 0, &ot) == EXPIRED_) {
+        free(ot.key);
+        osv_free(ot.value);
+    }
+    return slot;
+failure:
+    free(key_dup);
+    free(v);
+    *err = -ENOMEM;
+    return NULL;
+}
+
+void
+otype_remove(ohash_t *slot) {
+    oret_t ot = {0};
+    otake_slot(slot, &ot);
+    free(ot.key);
+    osv_free(ot.value);
+}
+
+int
+string2ll(const char *s, uint64_t len, int64_t *out) {
+    if (len == 0 || len > 20) return -EINVAL;
+    const char *p = s, *end = s + len;
+    int neg = 0;
+    if (*p == '-') {
+        neg = 1;
+        if (++p == end) return -EINVAL;
+    }
+    // "0" 只能单独出现, 拒绝 "-0" / "01"
+    if (*p == '0') {
+        if (end - p != 1 || neg) return -EINVAL;
+        *out = 0;
+        return 0;
+    }
+    uint64_t u = 0;
+    for (; p < end; p++) {
+        unsigned d = (unsigned) (*p - '0');
+        if (d > 9) return -EINVAL;
+        if (u > (UINT64_MAX - d) / 10) return -EINVAL;
+        u = u * 10 + d;
+    }
+    if (neg) {
+        if (u > (uint64_t) INT64_MAX + 1) return -EINVAL;
+        *out = (int64_t) (0 - u);
+    } else {
+        if (u > INT64_MAX) return -EINVAL;
+        *out = (int64_t) u;
+    }
+    return 0;
+}
+
+int
+string2ld(const char *s, uint64_t len, long double *out) {
+    char bf[LD_STR_MAX];
+    if (len == 0 || len >= sizeof(bf) || isspace((unsigned char) s[0])) return -EINVAL;
+    memcpy(bf, s, len);
+    bf[len] = '\0';
+    char *end;
+    errno = 0;
+    long double v = strtold(bf, &end);
+    if (end != bf + len || errno == ERANGE || isnan(v)) return -EINVAL;
+    *out = v;
+    return 0;
+}
+
+int
+ld2string(char *bf, int bflen, long double v) {
+    int len = snprintf(bf, bflen, "%.17Lf", v);
+    if (len <= 0 || len >= bflen) return 0;
+    if (memchr(bf, '.', len)) {
+        while (bf[len - 1] == '0') len--;
+        if (bf[len - 1] == '.') len--;
+    }
+    if (len == 2 && bf[0] == '-' && bf[1] == '0') {
+        bf[0] = '0';
+        len = 1;
+    }
+    bf[len] = '\0';
+    return len;
+}
+
+int
+osv_new_int(const char *key, uint32_t u30keylen, int64_t n) {
+    char *key_dup = strndup(key, u30keylen);
+    osv *v = malloc(sizeof(osv) + sizeof(int64_t));
+    if (!key_dup || !v) goto failure;
+    v->vlen = sizeof(int64_t);
+    v->meta = 0;
+    v->enc = OSV_INT;
+    v->ref = 1;
+    osv_int(v) = n;
+    oret_t ot = {0};
+    int ret = oinsert(key_dup, u30keylen, v, 0, &ot);
+    if (ret == FULL) {
+        if (osv_expand() < 0) goto failure;
+        ret = oinsert(key_dup, u30keylen, v, 0, &ot);
+    }
+    if (ret < 0) goto failure;
+    if (ret == REPLACED || ret == EXPIRED_) {
+        free(ot.key);
+        osv_free(ot.value);
+    }
+    return 0;
+failure:
+    free(key_dup);
+    free(v);
+    return -ENOMEM;
+}
+
+int
+osv_to_int(ohash_t *slot) {
+    osv *v = slot->v;
+    if (v->enc == OSV_COLD && !(v = otier_promote(slot))) return -EIO;
+    if (v->enc == OSV_INT) return 0;
+    int64_t n;
+    if (string2ll(v->d, v->vlen, &n) < 0) return -EINVAL;
+    uint64_t room = v->vlen + v->spare;
+    if (room < sizeof(int64_t)) {
+        osv *nv = realloc(v, sizeof(osv) + sizeof(int64_t));
+        if (!nv) return -ENOMEM;
+        slot->v = v = nv;
+        room = sizeof(int64_t);
+    }
+    v->vlen = sizeof(int64_t);
+    v->spare = room - sizeof(int64_t);
+    v->enc = OSV_INT;
+    osv_int(v) = n;
+    return 0;
+}
+
+int
+osv_make_room(ohash_t *slot, uint64_t need) {
+    osv *v = slot->v;
+    if (v->enc == OSV_COLD && !(v = otier_promote(slot))) return -EIO;
+    char num[24];
+    uint64_t vlen = v->vlen;
+    if (v->enc == OSV_INT) {
+        vlen = snprintf(num, sizeof(num), "%" PRId64, osv_int(v));
+        if (need < vlen) need = vlen;
+    }
+    uint64_t room = v->vlen + v->spare;
+    if (need > room) {
+        room = need < (1U << 20) ? need << 1 : need + (1U << 20);
+        osv *nv = realloc(v, sizeof(osv) + room);
+        if (!nv) return -ENOMEM;
+        slot->v = v = nv;
+    }
+    if (v->enc == OSV_INT) {
+        memcpy(v->d, num, vlen);
+        v->enc = OSV_RAW;
+    }
+    v->vlen = vlen;
+    v->spare = room - vlen;
+    return 0;
+}
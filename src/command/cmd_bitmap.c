@@ -0,0 +1,398 @@
+//
+// Created by weishen on 2025/11/13.
+//
+
+#include "cmd_dispatch.h"
+#include "obitmap.h"
+
+/*********************** bitmap handlers ******************************/
+
+/** 位偏移的上限: 字符串最长 OSV_MAX_STRLEN 字节 */
+#define BIT_OFFSET_MAX (OSV_MAX_STRLEN * 8)
+
+static inline int bit_at(const uint8_t *p, uint64_t i) {
+    return p[i >> 3] >> (7 - (i & 7)) & 1;
+}
+
+/**
+ * 位图的只读视图: 字符串值的字节, OSV_INT 格式化到 num 中, key 不存在时长度为 0
+ * @return 0 或 -EWRONGTYPE
+ */
+static int bitmap_view(struct element *key, char *num, const uint8_t **p, uint64_t *len) {
+    osv *v = GET(key->data, key->len);
+    *p = (const uint8_t *) num;
+    *len = 0;
+    if (!v) return 0;
+    if (osv_type(v) != OSV_T_STRING) return -EWRONGTYPE;
+    if (v->enc == OSV_INT) {
+        *len = (uint64_t) ll2str(num, osv_int(v));
+        return 0;
+    }
+    *p = (const uint8_t *) v->d;
+    *len = v->vlen;
+    return 0;
+}
+
+/**
+ * 写位图前保证 key 上是长度 >= need 的 OSV_RAW, 新增的字节填 0 (同 SETRANGE)
+ * @return 0, -EWRONGTYPE / -ENOMEM / -EIO
+ */
+static int bitmap_grow(struct element *key, uint64_t need, osv **out) {
+    ohash_t *slot = olookup(key->data, key->len);
+    if (!slot) {
+        int ret = SET4dup(key->data, key->len, "", 0, 0);
+        if (ret < 0) return ret;
+        slot = olookup(key->data, key->len);
+    }
+    osv *v = slot->v;
+    if (osv_type(v) != OSV_T_STRING) return -EWRONGTYPE;
+    if (v->enc != OSV_RAW || need > v->vlen + v->spare) {
+        int ret = osv_make_room(slot, need);
+        if (ret < 0) return ret;
+        v = slot->v;
+    }
+    if (need > v->vlen) {
+        memset(v->d + v->vlen, 0, need - v->vlen);
+        v->spare -= need - v->vlen;
+        v->vlen = need;
+    }
+    if (!v->ref) v->ref = 1;
+    *out = v;
+    return 0;
+}
+
+/** 位偏移, "#N" (hash_width != 0 时) 表示 N * hash_width @return 0 或 -EINVAL */
+static int parse_bitoffset(const struct element *e, uint32_t hash_width, uint64_t *off) {
+    struct element t = *e;
+    uint64_t mul = 1;
+    if (hash_width && t.len && t.data[0] == '#') {
+        t.data++;
+        t.len--;
+        mul = hash_width;
+    }
+    int64_t v;
+    if (string2ll(t.data, t.len, &v) < 0 || v < 0 || (uint64_t) v >= BIT_OFFSET_MAX / mul) return -EINVAL;
+    *off = (uint64_t) v * mul;
+    return 0;
+}
+
+static int reply_bitoffset_err(struct connection_t *cn) {
+    return reply_error(cn, "ERR bit offset is not an integer or out of range");
+}
+
+/** SETBIT key offset 0|1 -> 原来的位 */
+int cmd_setbit(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    uint64_t off;
+    if (parse_bitoffset(&argv[2], 0, &off) < 0) return reply_bitoffset_err(cn);
+    if (argv[3].len != 1 || (argv[3].data[0] != '0' && argv[3].data[0] != '1'))
+        return reply_error(cn, "ERR bit is not an integer or out of range");
+    osv *v;
+    int ret = bitmap_grow(&argv[1], (off >> 3) + 1, &v);
+    if (ret < 0) return reply_write_err(cn, ret);
+    uint8_t *b = (uint8_t *) v->d + (off >> 3), mask = (uint8_t) (0x80 >> (off & 7));
+    int old = (*b & mask) != 0;
+    if (argv[3].data[0] == '1') *b |= mask;
+    else *b &= (uint8_t) ~mask;
+    return reply_int(cn, old);
+}
+
+int cmd_getbit(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    uint64_t off, len;
+    if (parse_bitoffset(&argv[2], 0, &off) < 0) return reply_bitoffset_err(cn);
+    char num[24];
+    const uint8_t *p;
+    if (bitmap_view(&argv[1], num, &p, &len) < 0) return reply_wrongtype(cn);
+    return reply_int(cn, (off >> 3) < len ? bit_at(p, off) : 0);
+}
+
+/**
+ * [start end [BYTE|BIT]] 的区间, 下标规则同 GETRANGE, 结果换算成位区间 [*bs, *be]
+ * @return 1 区间非空, 0 空, -EINVAL 参数错误 (*err 是错误信息)
+ */
+static int bit_range(struct element *argv, int argc, uint64_t len, uint64_t *bs, uint64_t *be, const char **err) {
+    int64_t s = 0, e = -1;
+    int bitmode = 0;
+    if ((argc > 0 && string2ll(argv[0].data, argv[0].len, &s) < 0) ||
+        (argc > 1 && string2ll(argv[1].data, argv[1].len, &e) < 0)) {
+        *err = "ERR value is not an integer or out of range";
+        return -EINVAL;
+    }
+    if (argc > 2) {
+        if (arg_is(&argv[2], "bit")) bitmode = 1;
+        else if (!arg_is(&argv[2], "byte")) {
+            *err = "ERR syntax error";
+            return -EINVAL;
+        }
+    }
+    int64_t total = (int64_t) (bitmode ? len * 8 : len);
+    if (s < 0) s += total;
+    if (e < 0) e += total;
+    if (s < 0) s = 0;
+    if (e < 0) e = 0;
+    if (e >= total) e = total - 1;
+    if (!total || s > e) return 0;
+    *bs = bitmode ? (uint64_t) s : (uint64_t) s * 8;
+    *be = bitmode ? (uint64_t) e : (uint64_t) e * 8 + 7;
+    return 1;
+}
+
+/** BITCOUNT key [start end [BYTE|BIT]], 中间的整字节走 obit_count, 两端的零头用掩码 */
+int cmd_bitcount(struct connection_t *cn, struct element *argv, int argc) {
+    if (argc == 3 || argc > 5) return reply_error(cn, "ERR syntax error");
+    char num[24];
+    const uint8_t *p;
+    uint64_t len, bs, be;
+    const char *err;
+    if (bitmap_view(&argv[1], num, &p, &len) < 0) return reply_wrongtype(cn);
+    if (argc == 2) return reply_int(cn, (long long) obit_count(p, len));
+    int r = bit_range(argv + 2, argc - 2, len, &bs, &be, &err);
+    if (r < 0) return reply_error(cn, err);
+    if (!r) return reply_int(cn, 0);
+    uint64_t sb = bs >> 3, eb = be >> 3;
+    uint8_t fm = (uint8_t) (0xff >> (bs & 7)), lm = (uint8_t) (0xff << (7 - (be & 7)));
+    if (sb == eb) return reply_int(cn, __builtin_popcount(p[sb] & fm & lm));
+    uint64_t c = (uint64_t) __builtin_popcount(p[sb] & fm) + (uint64_t) __builtin_popcount(p[eb] & lm);
+    return reply_int(cn, (long long) (c + obit_count(p + sb + 1, eb - sb - 1)));
+}
+
+/** 位区间 [bs, be] 中第一个值为 bit 的位, 对齐后的整字节用 obit_skip 跳过 @return 位下标, -1 表示没有 */
+static int64_t find_bit(const uint8_t *p, uint64_t bs, uint64_t be, int bit) {
+    uint64_t i = bs;
+    for (; i <= be && (i & 7); i++)
+        if (bit_at(p, i) == bit) return (int64_t) i;
+    if (i > be) return -1;
+    uint64_t first = i >> 3, nbytes = (be + 1 - i) >> 3;
+    uint64_t k = obit_skip(p + first, nbytes, bit ? 0x00 : 0xff);
+    if (k < nbytes) return (int64_t) ((first + k) * 8 + (uint64_t) obit_first_in_byte(p[first + k], bit));
+    for (i += nbytes * 8; i <= be; i++)
+        if (bit_at(p, i) == bit) return (int64_t) i;
+    return -1;
+}
+
+/**
+ * BITPOS key bit [start [end [BYTE|BIT]]]
+ * 找 0 且没有给出 end 时, 与 Redis 一样把区间之后的第一位当作 0
+ */
+int cmd_bitpos(struct connection_t *cn, struct element *argv, int argc) {
+    if (argc > 6) return reply_error(cn, "ERR syntax error");
+    if (argv[2].len != 1 || (argv[2].data[0] != '0' && argv[2].data[0] != '1'))
+        return reply_error(cn, "ERR The bit argument must be 1 or 0.");
+    int bit = argv[2].data[0] == '1';
+    char num[24];
+    const uint8_t *p;
+    uint64_t len, bs, be;
+    const char *err;
+    if (bitmap_view(&argv[1], num, &p, &len) < 0) return reply_wrongtype(cn);
+    if (!len) return reply_int(cn, bit ? -1 : 0);
+    int r = bit_range(argv + 3, argc - 3, len, &bs, &be, &err);
+    if (r < 0) return reply_error(cn, err);
+    if (!r) return reply_int(cn, -1);
+    int64_t pos = find_bit(p, bs, be, bit);
+    if (pos < 0 && !bit && argc < 5) pos = (int64_t) be + 1;
+    return reply_int(cn, pos);
+}
+
+/**
+ * BITOP AND|OR|XOR|NOT destkey key [key ...] -> 结果的长度
+ * 结果直接算进新分配的 osv 再整体替换 destkey (destkey 也可以是源), 结果为空时删除 destkey
+ */
+int cmd_bitop(struct connection_t *cn, struct element *argv, int argc) {
+    enum obit_op op;
+    if (arg_is(&argv[1], "and")) op = OBIT_AND;
+    else if (arg_is(&argv[1], "or")) op = OBIT_OR;
+    else if (arg_is(&argv[1], "xor")) op = OBIT_XOR;
+    else if (arg_is(&argv[1], "not")) op = OBIT_NOT;
+    else return reply_error(cn, "ERR syntax error");
+    if (op == OBIT_NOT && argc != 4) return reply_error(cn, "ERR BITOP NOT must be called with a single source key.");
+    int n = argc - 3;
+    const uint8_t **src = malloc(sizeof(*src) * (size_t) n);
+    uint64_t *lens = malloc(sizeof(*lens) * (size_t) n);
+    char (*nums)[24] = malloc(sizeof(*nums) * (size_t) n);
+    if (!src || !lens || !nums) {
+        free(src);
+        free(lens);
+        free(nums);
+        return reply_write_err(cn, -ENOMEM);
+    }
+    uint64_t maxlen = 0;
+    int ret = 0;
+    for (int i = 0; i < n && !ret; i++) {
+        ret = bitmap_view(&argv[3 + i], nums[i], &src[i], &lens[i]);
+        if (lens[i] > maxlen) maxlen = lens[i];
+    }
+    if (ret < 0) ret = reply_wrongtype(cn);
+    else if (!maxlen) {
+        DEL(argv[2].data, argv[2].len, free);
+        ret = reply_int(cn, 0);
+    } else {
+        osv *r = malloc(sizeof(osv) + maxlen);
+        if (!r) ret = reply_write_err(cn, -ENOMEM);
+        else {
+            r->vlen = maxlen;
+            r->meta = 0;
+            r->ref = 1;
+            obit_op(op, (uint8_t *) r->d, maxlen, src, lens, n);
+            if ((ret = SET4own(argv[2].data, argv[2].len, r)) < 0) {
+                free(r);
+                ret = reply_write_err(cn, ret);
+            } else ret = reply_int(cn, (long long) maxlen);
+        }
+    }
+    free(src);
+    free(lens);
+    free(nums);
+    return ret;
+}
+
+/*********************** BITFIELD ******************************/
+
+enum bf_kind { BF_GET, BF_SET, BF_INCRBY };
+enum bf_overflow { BF_WRAP, BF_SAT, BF_FAIL };
+
+struct bf_op {
+    uint8_t kind;
+    uint8_t sign;
+    uint8_t bits;
+    uint8_t ow;
+    uint64_t off;
+    int64_t arg;
+};
+
+/** i1..i64 / u1..u63 @return 0 或 -EINVAL */
+static int parse_bftype(const struct element *e, struct bf_op *op) {
+    int64_t bits;
+    if (e->len < 2 || ((e->data[0] | 0x20) != 'i' && (e->data[0] | 0x20) != 'u')) return -EINVAL;
+    op->sign = (e->data[0] | 0x20) == 'i';
+    if (string2ll(e->data + 1, e->len - 1, &bits) < 0 || bits < 1 || bits > (op->sign ? 64 : 63)) return -EINVAL;
+    op->bits = (uint8_t) bits;
+    return 0;
+}
+
+/** 从 off 开始的 bits 位 (高位在前), 超出 len 的部分读作 0 */
+static uint64_t field_get(const uint8_t *p, uint64_t len, uint64_t off, int bits) {
+    uint64_t v = 0;
+    for (int i = 0; i < bits; i++) {
+        uint64_t b = off + (uint64_t) i;
+        v = v << 1 | (uint64_t) ((b >> 3) < len ? bit_at(p, b) : 0);
+    }
+    return v;
+}
+
+static void field_set(uint8_t *p, uint64_t off, int bits, uint64_t v) {
+    for (int i = 0; i < bits; i++) {
+        uint64_t b = off + (uint64_t) i;
+        uint8_t m = (uint8_t) (0x80 >> (b & 7));
+        if (v >> (bits - 1 - i) & 1) p[b >> 3] |= m;
+        else p[b >> 3] &= (uint8_t) ~m;
+    }
+}
+
+static int64_t sign_extend(uint64_t v, int bits) {
+    if (bits < 64 && (v >> (bits - 1) & 1)) v |= ~0ULL << bits;
+    return (int64_t) v;
+}
+
+/**
+ * cur + incr 按字段的类型检查溢出, *out <- 结果 (溢出时是 WRAP / SAT 之后的值)
+ * @return 1 溢出, 0 没有
+ */
+static int field_add(const struct bf_op *op, int64_t cur, int64_t incr, int64_t *out) {
+    uint64_t mask = op->bits == 64 ? ~0ULL : (1ULL << op->bits) - 1;
+    if (!op->sign) {
+        uint64_t c = (uint64_t) cur;
+        int of = incr >= 0 ? (uint64_t) incr > mask - c : (uint64_t) -(incr + 1) + 1 > c;
+        if (of && op->ow == BF_SAT) *out = incr > 0 ? (int64_t) mask : 0;
+        else *out = (int64_t) ((c + (uint64_t) incr) & mask);
+        return of;
+    }
+    int64_t max = (int64_t) (mask >> 1), min = -max - 1, r;
+    int of = __builtin_add_overflow(cur, incr, &r) || r > max || r < min;
+    if (of && op->ow == BF_SAT) *out = incr > 0 ? max : min;
+    else *out = sign_extend(((uint64_t) cur + (uint64_t) incr) & mask, op->bits);
+    return of;
+}
+
+/**
+ * BITFIELD key [GET type offset] [SET type offset value] [INCRBY type offset increment]
+ *              [OVERFLOW WRAP|SAT|FAIL] ...
+ * 先解析完所有子命令 (参数错误时不写), 有写操作时一次性把字符串扩到最大的偏移
+ */
+int cmd_bitfield(struct connection_t *cn, struct element *argv, int argc) {
+    struct bf_op *ops = malloc(sizeof(*ops) * (size_t) (argc / 3 + 1));
+    if (!ops) return reply_write_err(cn, -ENOMEM);
+    int nops = 0, ret = 0;
+    uint8_t ow = BF_WRAP;
+    uint64_t need = 0;
+    const char *err = NULL;
+    for (int i = 2; i < argc && !err;) {
+        struct bf_op *op = &ops[nops];
+        if (arg_is(&argv[i], "overflow") && i + 1 < argc) {
+            if (arg_is(&argv[i + 1], "wrap")) ow = BF_WRAP;
+            else if (arg_is(&argv[i + 1], "sat")) ow = BF_SAT;
+            else if (arg_is(&argv[i + 1], "fail")) ow = BF_FAIL;
+            else err = "ERR Invalid OVERFLOW type specified";
+            i += 2;
+            continue;
+        }
+        if (arg_is(&argv[i], "get") && i + 2 < argc) op->kind = BF_GET;
+        else if (arg_is(&argv[i], "set") && i + 3 < argc) op->kind = BF_SET;
+        else if (arg_is(&argv[i], "incrby") && i + 3 < argc) op->kind = BF_INCRBY;
+        else {
+            err = "ERR syntax error";
+            break;
+        }
+        op->ow = ow;
+        if (parse_bftype(&argv[i + 1], op) < 0)
+            err = "ERR Invalid bitfield type. Use something like i16 u8. Note that u64 is not supported but i64 is.";
+        else if (parse_bitoffset(&argv[i + 2], op->bits, &op->off) < 0 || op->off + op->bits > BIT_OFFSET_MAX)
+            err = "ERR bit offset is not an integer or out of range";
+        else if (op->kind != BF_GET && string2ll(argv[i + 3].data, argv[i + 3].len, &op->arg) < 0)
+            err = "ERR value is not an integer or out of range";
+        if (op->kind != BF_GET && (op->off + op->bits + 7) >> 3 > need) need = (op->off + op->bits + 7) >> 3;
+        i += op->kind == BF_GET ? 3 : 4;
+        nops++;
+    }
+    if (err) {
+        free(ops);
+        return reply_error(cn, err);
+    }
+
+    char num[24];
+    const uint8_t *p;
+    uint64_t len;
+    uint8_t *w = NULL;
+    if (need) {
+        osv *v;
+        if ((ret = bitmap_grow(&argv[1], need, &v)) < 0) {
+            free(ops);
+            return reply_write_err(cn, ret);
+        }
+        p = w = (uint8_t *) v->d;
+        len = v->vlen;
+    } else if (bitmap_view(&argv[1], num, &p, &len) < 0) {
+        free(ops);
+        return reply_wrongtype(cn);
+    }
+
+    ret = reply_array(cn, nops);
+    for (int i = 0; i < nops && ret >= 0; i++) {
+        const struct bf_op *op = &ops[i];
+        uint64_t raw = field_get(p, len, op->off, op->bits);
+        int64_t cur = op->sign ? sign_extend(raw, op->bits) : (int64_t) raw, nv;
+        if (op->kind == BF_GET) {
+            ret = reply_int(cn, cur);
+            continue;
+        }
+        int of = op->kind == BF_SET ? field_add(op, 0, op->arg, &nv) : field_add(op, cur, op->arg, &nv);
+        if (of && op->ow == BF_FAIL) {
+            ret = reply_nil(cn);
+            continue;
+        }
+        field_set(w, op->off, op->bits, (uint64_t) nv);
+        ret = reply_int(cn, op->kind == BF_SET ? cur : nv);
+    }
+    free(ops);
+    return ret;
+}
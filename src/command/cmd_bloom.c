@@ -0,0 +1,96 @@
+//
+// Created by weishen on 2025/11/14.
+//
+
+#include "cmd_dispatch.h"
+
+/*********************** bloom filter handlers ******************************/
+
+static int reply_bloom_err(struct connection_t *cn, int err) {
+    if (err == -ENOSPC) return reply_error(cn, "ERR non scaling filter is full");
+    return reply_type_err(cn, err);
+}
+
+/** BF.RESERVE key error_rate capacity [EXPANSION expansion] [NONSCALING] */
+int cmd_bf_reserve(struct connection_t *cn, struct element *argv, int argc) {
+    long double error;
+    int64_t capacity, expansion = OBLOOM_EXPANSION_DEFAULT;
+    if (string2ld(argv[2].data, argv[2].len, &error) < 0 || !(error > 0 && error < 1))
+        return reply_error(cn, "ERR (0 < error rate range < 1)");
+    if (string2ll(argv[3].data, argv[3].len, &capacity) < 0 || capacity <= 0)
+        return reply_error(cn, "ERR (capacity should be larger than 0)");
+    for (int i = 4; i < argc; i++) {
+        if (arg_is(&argv[i], "NONSCALING")) expansion = 0;
+        else if (arg_is(&argv[i], "EXPANSION") && i + 1 < argc) {
+            if (string2ll(argv[i + 1].data, argv[i + 1].len, &expansion) < 0 || expansion < 1 ||
+                expansion > UINT32_MAX)
+                return reply_error(cn, "ERR (expansion should be greater or equal to 1)");
+            i++;
+        } else return reply_error(cn, "ERR syntax error");
+    }
+    int err;
+    if (otype_lookup(argv[1].data, argv[1].len, OSV_T_BLOOM, NULL, &err) || err == -EWRONGTYPE)
+        return reply_error(cn, "ERR item exists");
+    osv *v = obloomv_new((double) error, (uint64_t) capacity, (uint32_t) expansion);
+    if (!v) return reply_type_err(cn, -ENOMEM);
+    if ((err = SET4own(argv[1].data, argv[1].len, v)) < 0) {
+        osv_free(v);
+        return reply_write_err(cn, err);
+    }
+    return reply_ok(cn);
+}
+
+/** BF.ADD key item, key 不存在时按默认参数创建 */
+int cmd_bf_add(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_BLOOM, obloomv_new_default, &err);
+    if (!slot) return reply_type_err(cn, err);
+    int ret = obloomv_add(slot->v, obloom_hash(argv[2].data, argv[2].len));
+    return ret < 0 ? reply_bloom_err(cn, ret) : reply_int(cn, ret);
+}
+
+int cmd_bf_exists(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_BLOOM, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+    return reply_int(cn, obloomv_exists(slot->v, obloom_hash(argv[2].data, argv[2].len)));
+}
+
+/**
+ * BF.MADD / BF.MEXISTS: 每 OBLOOM_BATCH 个元素先全部 hash 并预取各自的块,
+ * 再逐个查询 / 写入, 块的 DRAM miss 重叠而不是串行 (同 olookup_batch)
+ * 单个元素的错误 (NONSCALING 已满) 作为数组里的错误回复, 不影响其余元素
+ */
+static int bf_multi(struct connection_t *cn, struct element *argv, int argc, int add) {
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_BLOOM, add ? obloomv_new_default : NULL, &err);
+    if (!slot && err) return reply_type_err(cn, err);
+    int ret = reply_array(cn, argc - 2);
+    uint64_t h[OBLOOM_BATCH];
+    for (int i = 2; ret >= 0 && i < argc; i += OBLOOM_BATCH) {
+        int n = argc - i < OBLOOM_BATCH ? argc - i : OBLOOM_BATCH;
+        for (int j = 0; slot && j < n; j++) {
+            h[j] = obloom_hash(argv[i + j].data, argv[i + j].len);
+            obloomv_prefetch(slot->v, h[j]);
+        }
+        for (int j = 0; ret >= 0 && j < n; j++) {
+            if (!slot) ret = reply_int(cn, 0);
+            else if (!add) ret = reply_int(cn, obloomv_exists(slot->v, h[j]));
+            else {
+                int r = obloomv_add(slot->v, h[j]);
+                ret = r < 0 ? reply_bloom_err(cn, r) : reply_int(cn, r);
+            }
+        }
+    }
+    return ret;
+}
+
+int cmd_bf_madd(struct connection_t *cn, struct element *argv, int argc) {
+    return bf_multi(cn, argv, argc, 1);
+}
+
+int cmd_bf_mexists(struct connection_t *cn, struct element *argv, int argc) {
+    return bf_multi(cn, argv, argc, 0);
+}
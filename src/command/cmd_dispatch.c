@@ -0,0 +1,599 @@
+//
+// Created by weishen on 2025/11/8.
+//
+
+#include "cmd_dispatch.h"
+
+#include <stddef.h>
+
+/*********************** handlers ******************************/
+
+static int cmd_ping(struct connection_t *cn, struct element *argv, int argc) {
+    if (argc > 2) return reply_error(cn, "ERR wrong number of arguments for 'ping' command");
+    if (argc == 2) return reply_bulk(cn, argv[1].data, argv[1].len);
+    return reply_simple(cn, "PONG", 4);
+}
+
+static int cmd_get(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    osv *v = GET(argv[1].data, argv[1].len);
+    if (!v) return reply_nil(cn);
+    if (osv_type(v) != OSV_T_STRING) return reply_wrongtype(cn);
+    return reply_osv(cn, v);
+}
+
+enum expire_opt {
+    EXPIRE_NONE = 0,
+    EXPIRE_EX,
+    EXPIRE_PX,
+    EXPIRE_EXAT,
+    EXPIRE_PXAT,
+};
+
+static enum expire_opt expire_opt_of(const struct element *e) {
+    if (arg_is(e, "EX")) return EXPIRE_EX;
+    if (arg_is(e, "PX")) return EXPIRE_PX;
+    if (arg_is(e, "EXAT")) return EXPIRE_EXAT;
+    if (arg_is(e, "PXAT")) return EXPIRE_PXAT;
+    return EXPIRE_NONE;
+}
+
+/**
+ * EX / PX / EXAT / PXAT 的参数转成 slot 的绝对 unix 毫秒
+ * @return 0, -EINVAL (不是整数), -ERANGE (<= 0 或溢出)
+ */
+static int expire_at(enum expire_opt opt, const struct element *arg, uint64_t *at) {
+    int64_t n;
+    if (string2ll(arg->data, arg->len, &n) < 0) return -EINVAL;
+    if (n <= 0) return -ERANGE;
+    uint64_t u = (uint64_t) n;
+    if (opt == EXPIRE_EX || opt == EXPIRE_EXAT) {
+        if (u > INT64_MAX / 1000) return -ERANGE;
+        u *= 1000;
+    }
+    if (opt == EXPIRE_EX || opt == EXPIRE_PX) {
+        uint64_t now = oclock_ms();
+        if (u > INT64_MAX - now) return -ERANGE;
+        u += now;
+    }
+    *at = u;
+    return 0;
+}
+
+static int reply_expire_err(struct connection_t *cn, int ret, const char *cmd) {
+    if (ret == -EINVAL) return reply_error(cn, "ERR value is not an integer or out of range");
+    char msg[64];
+    snprintf(msg, sizeof(msg), "ERR invalid expire time in '%s' command", cmd);
+    return reply_error(cn, msg);
+}
+
+/** SET key value [NX|XX] [GET] [EX s|PX ms|EXAT ts|PXAT ms-ts|KEEPTTL] */
+static int cmd_set(struct connection_t *cn, struct element *argv, int argc) {
+    int flags = 0;
+    enum expire_opt eo = EXPIRE_NONE;
+    uint64_t at = 0;
+    for (int i = 3; i < argc; i++) {
+        const struct element *o = argv + i;
+        enum expire_opt k;
+        if (arg_is(o, "NX") && !(flags & SET_XX)) flags |= SET_NX;
+        else if (arg_is(o, "XX") && !(flags & SET_NX)) flags |= SET_XX;
+        else if (arg_is(o, "GET")) flags |= SET_GET;
+        else if (arg_is(o, "KEEPTTL") && !eo) flags |= SET_KEEPTTL;
+        else if ((k = expire_opt_of(o)) && !eo && !(flags & SET_KEEPTTL) && i + 1 < argc) {
+            eo = k;
+            int ret = expire_at(k, argv + ++i, &at);
+            if (ret < 0) return reply_expire_err(cn, ret, "set");
+        } else return reply_error(cn, "ERR syntax error");
+    }
+    osv *old;
+    int ret = SETOPT4dup(argv[1].data, argv[1].len, argv[2].data, argv[2].len, at, flags, &old);
+    if (ret < 0) return reply_write_err(cn, ret);
+    if (!(flags & SET_GET)) return ret ? reply_ok(cn) : reply_nil(cn);
+    if (!old) return reply_nil(cn);
+    int wret = reply_osv(cn, old);
+    if (ret == 1) free(old);
+    return wret;
+}
+
+static int cmd_getset(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    osv *old;
+    int ret = SETOPT4dup(argv[1].data, argv[1].len, argv[2].data, argv[2].len, 0, SET_GET, &old);
+    if (ret < 0) return reply_write_err(cn, ret);
+    if (!old) return reply_nil(cn);
+    int wret = reply_osv(cn, old);
+    free(old);
+    return wret;
+}
+
+static int cmd_getdel(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    osv *v = GETDEL(argv[1].data, argv[1].len, &err);
+    if (err < 0) return reply_write_err(cn, err);
+    if (!v) return reply_nil(cn);
+    int ret = reply_osv(cn, v);
+    free(v);
+    return ret;
+}
+
+/** GETEX key [EX s|PX ms|EXAT ts|PXAT ms-ts|PERSIST] */
+static int cmd_getex(struct connection_t *cn, struct element *argv, int argc) {
+    int set_ttl = 0;
+    uint64_t at = 0;
+    if (argc == 3 && arg_is(argv + 2, "PERSIST")) set_ttl = 1;
+    else if (argc == 4 && expire_opt_of(argv + 2)) {
+        int ret = expire_at(expire_opt_of(argv + 2), argv + 3, &at);
+        if (ret < 0) return reply_expire_err(cn, ret, "getex");
+        set_ttl = 1;
+    } else if (argc != 2) return reply_error(cn, "ERR syntax error");
+    osv *v = GETEX(argv[1].data, argv[1].len, set_ttl, at);
+    if (!v) return reply_nil(cn);
+    if (osv_type(v) != OSV_T_STRING) return reply_wrongtype(cn);
+    return reply_osv(cn, v);
+}
+
+/** 批量命令的 scratch, 单线程的 epoll loop 中复用 */
+static obatch_t batch[MAX_ARRAY_ELEMENTS];
+
+static int cmd_del(struct connection_t *cn, struct element *argv, int argc) {
+    uint32_t n = argc - 1;
+    for (uint32_t i = 0; i < n; i++) {
+        batch[i].key = argv[i + 1].data;
+        batch[i].keylen = argv[i + 1].len;
+    }
+    return reply_int(cn, MDEL(batch, n, free));
+}
+
+static int cmd_mget(struct connection_t *cn, struct element *argv, int argc) {
+    uint32_t n = argc - 1;
+    for (uint32_t i = 0; i < n; i++) {
+        batch[i].key = argv[i + 1].data;
+        batch[i].keylen = argv[i + 1].len;
+    }
+    MGET(batch, n);
+    // 一次 reserve, 然后顺序写完整个回复
+    long long total = 48; // 数组头 + 最后一个 reply_bulk 的 reserve 余量
+    for (uint32_t i = 0; i < n; i++) {
+        osv *v = batch[i].v;
+        total += v ? reply_osv_len(v) : 5;
+    }
+    int ret = reply_reserve(cn, total);
+    if (ret < 0) return ret;
+    reply_array(cn, n);
+    for (uint32_t i = 0; i < n; i++) {
+        osv *v = batch[i].v;
+        if (v) reply_osv(cn, v);
+        else reply_nil(cn);
+    }
+    return 0;
+}
+
+static int cmd_mset(struct connection_t *cn, struct element *argv, int argc) {
+    if (!(argc & 1)) return reply_error(cn, "ERR wrong number of arguments for 'mset' command");
+    uint32_t n = (argc - 1) >> 1;
+    for (uint32_t i = 0; i < n; i++) {
+        batch[i].key = argv[2 * i + 1].data;
+        batch[i].keylen = argv[2 * i + 1].len;
+        batch[i].v = argv[2 * i + 2].data;
+        batch[i].vlen = argv[2 * i + 2].len;
+    }
+    if (MSET4dup(batch, n, 0) < 0)
+        return reply_error(cn, "OOM command not allowed when used memory > 'maxmemory'");
+    return reply_ok(cn);
+}
+
+static int reply_incr(struct connection_t *cn, char *key, uint32_t keylen, int64_t by) {
+    int64_t n;
+    int ret = INCRBY(key, keylen, by, &n);
+    if (ret == -EINVAL) return reply_error(cn, "ERR value is not an integer or out of range");
+    if (ret == -ERANGE) return reply_error(cn, "ERR increment or decrement would overflow");
+    if (ret < 0) return reply_write_err(cn, ret);
+    return reply_int(cn, n);
+}
+
+static int cmd_incr(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    return reply_incr(cn, argv[1].data, argv[1].len, 1);
+}
+
+static int cmd_decr(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    return reply_incr(cn, argv[1].data, argv[1].len, -1);
+}
+
+static int cmd_incrby(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int64_t by;
+    if (string2ll(argv[2].data, argv[2].len, &by) < 0)
+        return reply_error(cn, "ERR value is not an integer or out of range");
+    return reply_incr(cn, argv[1].data, argv[1].len, by);
+}
+
+static int cmd_decrby(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int64_t by;
+    if (string2ll(argv[2].data, argv[2].len, &by) < 0)
+        return reply_error(cn, "ERR value is not an integer or out of range");
+    if (by == INT64_MIN) return reply_error(cn, "ERR decrement would overflow");
+    return reply_incr(cn, argv[1].data, argv[1].len, -by);
+}
+
+static int cmd_incrbyfloat(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    long double by;
+    if (string2ld(argv[2].data, argv[2].len, &by) < 0)
+        return reply_error(cn, "ERR value is not a valid float");
+    osv *v;
+    int ret = INCRBYFLOAT(argv[1].data, argv[1].len, by, &v);
+    if (ret == -EINVAL) return reply_error(cn, "ERR value is not a valid float");
+    if (ret == -ERANGE) return reply_error(cn, "ERR increment would produce NaN or Infinity");
+    if (ret < 0) return reply_write_err(cn, ret);
+    return reply_bulk(cn, v->d, (long long) v->vlen);
+}
+
+/** ns -> 秒, 向上取整; 负数 (-1) 原样返回 */
+static long long throttle_sec(int64_t ns) {
+    return ns < 0 ? -1 : (long long) ((ns + 999999999) / 1000000000);
+}
+
+/**
+ * THROTTLE key max_burst count period [quantity]
+ * 每 period 秒 count 个, 允许突发 max_burst + 1 个. 回复与 redis-cell 的 CL.THROTTLE 相同:
+ * [limited, limit, remaining, retry_after, reset_after], 时间以秒为单位 (向上取整), -1 表示不适用
+ */
+static int cmd_throttle(struct connection_t *cn, struct element *argv, int argc) {
+    if (argc > 6) return reply_error(cn, "ERR syntax error");
+    int64_t burst, count, period, quantity = 1;
+    if (string2ll(argv[2].data, argv[2].len, &burst) < 0 || string2ll(argv[3].data, argv[3].len, &count) < 0 ||
+        string2ll(argv[4].data, argv[4].len, &period) < 0 ||
+        (argc == 6 && string2ll(argv[5].data, argv[5].len, &quantity) < 0))
+        return reply_error(cn, "ERR value is not an integer or out of range");
+    if (burst < 0 || burst == INT64_MAX || count < 1 || period < 1 || quantity < 0 ||
+        period > INT64_MAX / 1000000000 || period * 1000000000 / count < 1)
+        return reply_error(cn, "ERR invalid THROTTLE arguments");
+    struct othrottle t;
+    int64_t interval = period * 1000000000 / count;
+    int ret = THROTTLE(argv[1].data, argv[1].len, burst, interval, quantity, (int64_t) oclock_ms() * 1000000, &t);
+    if (ret == -EINVAL) return reply_error(cn, "ERR value is not an integer or out of range");
+    if (ret == -ERANGE) return reply_error(cn, "ERR THROTTLE arguments would overflow");
+    if (ret < 0) return reply_write_err(cn, ret);
+    ret = reply_array(cn, 5);
+    if (ret >= 0) ret = reply_int(cn, t.limited);
+    if (ret >= 0) ret = reply_int(cn, burst + 1);
+    if (ret >= 0) ret = reply_int(cn, t.remaining);
+    if (ret >= 0) ret = reply_int(cn, throttle_sec(t.retry_after));
+    if (ret >= 0) ret = reply_int(cn, throttle_sec(t.reset_after));
+    return ret;
+}
+
+static int cmd_append(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    uint64_t n;
+    int ret = APPEND(argv[1].data, argv[1].len, argv[2].data, argv[2].len, &n);
+    if (ret == -EFBIG) return reply_error(cn, "ERR string exceeds maximum allowed size (proto-max-bulk-len)");
+    if (ret < 0) return reply_write_err(cn, ret);
+    return reply_int(cn, (long long) n);
+}
+
+static int cmd_setrange(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int64_t off;
+    if (string2ll(argv[2].data, argv[2].len, &off) < 0)
+        return reply_error(cn, "ERR value is not an integer or out of range");
+    if (off < 0) return reply_error(cn, "ERR offset is out of range");
+    uint64_t n;
+    int ret = SETRANGE(argv[1].data, argv[1].len, off, argv[3].data, argv[3].len, &n);
+    if (ret == -EFBIG) return reply_error(cn, "ERR string exceeds maximum allowed size (proto-max-bulk-len)");
+    if (ret < 0) return reply_write_err(cn, ret);
+    return reply_int(cn, (long long) n);
+}
+
+/** 切片直接从 osv 拷进回复, 不复制整个值 */
+static int cmd_getrange(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int64_t start, end;
+    if (string2ll(argv[2].data, argv[2].len, &start) < 0 || string2ll(argv[3].data, argv[3].len, &end) < 0)
+        return reply_error(cn, "ERR value is not an integer or out of range");
+    osv *v = GET(argv[1].data, argv[1].len);
+    if (!v) return reply_bulk(cn, "", 0);
+    if (osv_type(v) != OSV_T_STRING) return reply_wrongtype(cn);
+    char num[24];
+    const char *p = v->d;
+    int64_t len = (int64_t) v->vlen;
+    if (v->enc == OSV_INT) {
+        len = ll2str(num, osv_int(v));
+        p = num;
+    }
+    if (start < 0 && end < 0 && start > end) return reply_bulk(cn, "", 0);
+    if (start < 0) start += len;
+    if (end < 0) end += len;
+    if (start < 0) start = 0;
+    if (end < 0) end = 0;
+    if (end >= len) end = len - 1;
+    if (!len || start > end) return reply_bulk(cn, "", 0);
+    return reply_bulk(cn, p + start, end - start + 1);
+}
+
+/** 冷值不需要 IO: stub 中保留了原长度 */
+static int cmd_strlen(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    ohash_t *slot = olookup(argv[1].data, argv[1].len);
+    if (!slot) return reply_int(cn, 0);
+    osv *v = slot->v;
+    if (osv_type(v) != OSV_T_STRING) return reply_wrongtype(cn);
+    if (v->enc == OSV_INT) {
+        char num[24];
+        return reply_int(cn, ll2str(num, osv_int(v)));
+    }
+    return reply_int(cn, (long long) v->vlen);
+}
+
+/**
+ * EXPIRE / PEXPIRE: 一次 probe, 直接改写 slot (不走 oexpired 的第二次查找)
+ * 时间 <= 0 或已经过去时与 Redis 一样立即删除 key
+ */
+static int expire_generic(struct connection_t *cn, struct element *argv, uint64_t unit, const char *cmd) {
+    int64_t n;
+    if (string2ll(argv[2].data, argv[2].len, &n) < 0)
+        return reply_error(cn, "ERR value is not an integer or out of range");
+    uint64_t now = oclock_ms();
+    if (n > 0 && (uint64_t) n > (INT64_MAX - now) / unit)
+        return reply_expire_err(cn, -ERANGE, cmd);
+    ohash_t *slot = olookup(argv[1].data, argv[1].len);
+    if (!slot) return reply_int(cn, 0);
+    if (n <= 0) {
+        otype_remove(slot);
+        return reply_int(cn, 1);
+    }
+    slot->expiratime = now + (uint64_t) n * unit;
+    return reply_int(cn, 1);
+}
+
+static int cmd_expire(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    return expire_generic(cn, argv, 1000, "expire");
+}
+
+static int cmd_pexpire(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    return expire_generic(cn, argv, 1, "pexpire");
+}
+
+/** -2: key 不存在, -1: 没有过期时间 */
+static int ttl_generic(struct connection_t *cn, struct element *argv, int ms) {
+    ohash_t *slot = olookup(argv[1].data, argv[1].len);
+    if (!slot) return reply_int(cn, -2);
+    if (!slot->expiratime) return reply_int(cn, -1);
+    uint64_t now = oclock_ms();
+    uint64_t left = slot->expiratime > now ? slot->expiratime - now : 0;
+    return reply_int(cn, (long long) (ms ? left : (left + 500) / 1000));
+}
+
+static int cmd_ttl(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    return ttl_generic(cn, argv, 0);
+}
+
+static int cmd_pttl(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    return ttl_generic(cn, argv, 1);
+}
+
+static int cmd_persist(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    ohash_t *slot = olookup(argv[1].data, argv[1].len);
+    if (!slot || !slot->expiratime) return reply_int(cn, 0);
+    slot->expiratime = 0;
+    return reply_int(cn, 1);
+}
+
+/*********************** table ******************************/
+
+#define CMD_LIST(X)                                                         \
+    X("get", 2, cmd_get, 'g', 'e', 't')                                     \
+    X("set", -3, cmd_set, 's', 'e', 't')                                    \
+    X("del", -2, cmd_del, 'd', 'e', 'l')                                    \
+    X("expire", 3, cmd_expire, 'e', 'x', 'p', 'i', 'r', 'e')                \
+    X("ping", -1, cmd_ping, 'p', 'i', 'n', 'g')                             \
+    X("mget", -2, cmd_mget, 'm', 'g', 'e', 't')                             \
+    X("mset", -3, cmd_mset, 'm', 's', 'e', 't')                             \
+    X("incr", 2, cmd_incr, 'i', 'n', 'c', 'r')                              \
+    X("decr", 2, cmd_decr, 'd', 'e', 'c', 'r')                              \
+    X("incrby", 3, cmd_incrby, 'i', 'n', 'c', 'r', 'b', 'y')                \
+    X("decrby", 3, cmd_decrby, 'd', 'e', 'c', 'r', 'b', 'y')                \
+    X("incrbyfloat", 3, cmd_incrbyfloat, 'i', 'n', 'c', 'r', 'b', 'y', 'f', 'l', 'o', 'a', 't')\
+    X("append", 3, cmd_append, 'a', 'p', 'p', 'e', 'n', 'd')                \
+    X("setrange", 4, cmd_setrange, 's', 'e', 't', 'r', 'a', 'n', 'g', 'e')  \
+    X("getrange", 4, cmd_getrange, 'g', 'e', 't', 'r', 'a', 'n', 'g', 'e')  \
+    X("strlen", 2, cmd_strlen, 's', 't', 'r', 'l', 'e', 'n')                \
+    X("getset", 3, cmd_getset, 'g', 'e', 't', 's', 'e', 't')                \
+    X("getdel", 2, cmd_getdel, 'g', 'e', 't', 'd', 'e', 'l')                \
+    X("getex", -2, cmd_getex, 'g', 'e', 't', 'e', 'x')                      \
+    X("pexpire", 3, cmd_pexpire, 'p', 'e', 'x', 'p', 'i', 'r', 'e')         \
+    X("ttl", 2, cmd_ttl, 't', 't', 'l')                                     \
+    X("pttl", 2, cmd_pttl, 'p', 't', 't', 'l')                              \
+    X("persist", 2, cmd_persist, 'p', 'e', 'r', 's', 'i', 's', 't')         \
+    X("hset", -4, cmd_hset, 'h', 's', 'e', 't')                             \
+    X("hget", 3, cmd_hget, 'h', 'g', 'e', 't')                              \
+    X("hmget", -3, cmd_hmget, 'h', 'm', 'g', 'e', 't')                      \
+    X("hdel", -3, cmd_hdel, 'h', 'd', 'e', 'l')                             \
+    X("hgetall", 2, cmd_hgetall, 'h', 'g', 'e', 't', 'a', 'l', 'l')         \
+    X("hincrby", 4, cmd_hincrby, 'h', 'i', 'n', 'c', 'r', 'b', 'y')         \
+    X("hlen", 2, cmd_hlen, 'h', 'l', 'e', 'n')                              \
+    X("lpush", -3, cmd_lpush, 'l', 'p', 'u', 's', 'h')                      \
+    X("rpush", -3, cmd_rpush, 'r', 'p', 'u', 's', 'h')                      \
+    X("lpop", -2, cmd_lpop, 'l', 'p', 'o', 'p')                             \
+    X("rpop", -2, cmd_rpop, 'r', 'p', 'o', 'p')                             \
+    X("llen", 2, cmd_llen, 'l', 'l', 'e', 'n')                              \
+    X("lrange", 4, cmd_lrange, 'l', 'r', 'a', 'n', 'g', 'e')                \
+    X("ltrim", 4, cmd_ltrim, 'l', 't', 'r', 'i', 'm')                       \
+    X("lindex", 3, cmd_lindex, 'l', 'i', 'n', 'd', 'e', 'x')                \
+    X("zadd", -4, cmd_zadd, 'z', 'a', 'd', 'd')                             \
+    X("zscore", 3, cmd_zscore, 'z', 's', 'c', 'o', 'r', 'e')                \
+    X("zcard", 2, cmd_zcard, 'z', 'c', 'a', 'r', 'd')                       \
+    X("zrem", -3, cmd_zrem, 'z', 'r', 'e', 'm')                             \
+    X("zrank", 3, cmd_zrank, 'z', 'r', 'a', 'n', 'k')                       \
+    X("zrange", -4, cmd_zrange, 'z', 'r', 'a', 'n', 'g', 'e')               \
+    X("zrangebyscore", -4, cmd_zrangebyscore, 'z', 'r', 'a', 'n', 'g', 'e', 'b', 'y', 's', 'c', 'o', 'r', 'e')\
+    X("zpopmin", -2, cmd_zpopmin, 'z', 'p', 'o', 'p', 'm', 'i', 'n')        \
+    X("sadd", -3, cmd_sadd, 's', 'a', 'd', 'd')                             \
+    X("srem", -3, cmd_srem, 's', 'r', 'e', 'm')                             \
+    X("sismember", 3, cmd_sismember, 's', 'i', 's', 'm', 'e', 'm', 'b', 'e', 'r')\
+    X("scard", 2, cmd_scard, 's', 'c', 'a', 'r', 'd')                       \
+    X("smembers", 2, cmd_smembers, 's', 'm', 'e', 'm', 'b', 'e', 'r', 's')  \
+    X("sinter", -2, cmd_sinter, 's', 'i', 'n', 't', 'e', 'r')               \
+    X("sunion", -2, cmd_sunion, 's', 'u', 'n', 'i', 'o', 'n')               \
+    X("setbit", 4, cmd_setbit, 's', 'e', 't', 'b', 'i', 't')                \
+    X("getbit", 3, cmd_getbit, 'g', 'e', 't', 'b', 'i', 't')                \
+    X("bitcount", -2, cmd_bitcount, 'b', 'i', 't', 'c', 'o', 'u', 'n', 't') \
+    X("bitpos", -3, cmd_bitpos, 'b', 'i', 't', 'p', 'o', 's')               \
+    X("bitop", -4, cmd_bitop, 'b', 'i', 't', 'o', 'p')                      \
+    X("bitfield", -2, cmd_bitfield, 'b', 'i', 't', 'f', 'i', 'e', 'l', 'd') \
+    X("pfadd", -2, cmd_pfadd, 'p', 'f', 'a', 'd', 'd')                      \
+    X("pfcount", -2, cmd_pfcount, 'p', 'f', 'c', 'o', 'u', 'n', 't')        \
+    X("pfmerge", -2, cmd_pfmerge, 'p', 'f', 'm', 'e', 'r', 'g', 'e')        \
+    X("bf.reserve", -4, cmd_bf_reserve, 'b', 'f', '.', 'r', 'e', 's', 'e', 'r', 'v', 'e')\
+    X("bf.add", 3, cmd_bf_add, 'b', 'f', '.', 'a', 'd', 'd')                \
+    X("bf.madd", -3, cmd_bf_madd, 'b', 'f', '.', 'm', 'a', 'd', 'd')        \
+    X("bf.exists", 3, cmd_bf_exists, 'b', 'f', '.', 'e', 'x', 'i', 's', 't', 's')\
+    X("bf.mexists", -3, cmd_bf_mexists, 'b', 'f', '.', 'm', 'e', 'x', 'i', 's', 't', 's')\
+    X("cms.initbydim", 4, cmd_cms_initbydim, 'c', 'm', 's', '.', 'i', 'n', 'i', 't', 'b', 'y', 'd', 'i', 'm')\
+    X("cms.initbyprob", 4, cmd_cms_initbyprob, 'c', 'm', 's', '.', 'i', 'n', 'i', 't', 'b', 'y', 'p', 'r', 'o', 'b')\
+    X("cms.incrby", -4, cmd_cms_incrby, 'c', 'm', 's', '.', 'i', 'n', 'c', 'r', 'b', 'y')\
+    X("cms.query", -3, cmd_cms_query, 'c', 'm', 's', '.', 'q', 'u', 'e', 'r', 'y')\
+    X("topk.reserve", -3, cmd_topk_reserve, 't', 'o', 'p', 'k', '.', 'r', 'e', 's', 'e', 'r', 'v', 'e')\
+    X("topk.add", -3, cmd_topk_add, 't', 'o', 'p', 'k', '.', 'a', 'd', 'd') \
+    X("topk.list", -2, cmd_topk_list, 't', 'o', 'p', 'k', '.', 'l', 'i', 's', 't')\
+    X("ts.create", -2, cmd_ts_create, 't', 's', '.', 'c', 'r', 'e', 'a', 't', 'e')\
+    X("ts.add", -4, cmd_ts_add, 't', 's', '.', 'a', 'd', 'd')               \
+    X("ts.get", 2, cmd_ts_get, 't', 's', '.', 'g', 'e', 't')                \
+    X("ts.range", -4, cmd_ts_range, 't', 's', '.', 'r', 'a', 'n', 'g', 'e') \
+    X("ts.mrange", -5, cmd_ts_mrange, 't', 's', '.', 'm', 'r', 'a', 'n', 'g', 'e')\
+    X("xadd", -5, cmd_xadd, 'x', 'a', 'd', 'd')                             \
+    X("xlen", 2, cmd_xlen, 'x', 'l', 'e', 'n')                              \
+    X("xrange", -4, cmd_xrange, 'x', 'r', 'a', 'n', 'g', 'e')               \
+    X("xtrim", -4, cmd_xtrim, 'x', 't', 'r', 'i', 'm')                      \
+    X("xread", -4, cmd_xread, 'x', 'r', 'e', 'a', 'd')                      \
+    X("xgroup", -4, cmd_xgroup, 'x', 'g', 'r', 'o', 'u', 'p')               \
+    X("xreadgroup", -7, cmd_xreadgroup, 'x', 'r', 'e', 'a', 'd', 'g', 'r', 'o', 'u', 'p')\
+    X("xack", -4, cmd_xack, 'x', 'a', 'c', 'k')                             \
+    X("xpending", -3, cmd_xpending, 'x', 'p', 'e', 'n', 'd', 'i', 'n', 'g') \
+    X("throttle", -5, cmd_throttle, 't', 'h', 'r', 'o', 't', 't', 'l', 'e') \
+    X("geoadd", -5, cmd_geoadd, 'g', 'e', 'o', 'a', 'd', 'd')               \
+    X("geodist", -4, cmd_geodist, 'g', 'e', 'o', 'd', 'i', 's', 't')        \
+    X("geosearch", -7, cmd_geosearch, 'g', 'e', 'o', 's', 'e', 'a', 'r', 'c', 'h')\
+    X("vadd", -5, cmd_vadd, 'v', 'a', 'd', 'd')                             \
+    X("vsim", -4, cmd_vsim, 'v', 's', 'i', 'm')                             \
+    X("vcard", 2, cmd_vcard, 'v', 'c', 'a', 'r', 'd')                       \
+    X("vdim", 2, cmd_vdim, 'v', 'd', 'i', 'm')                              \
+    X("json.set", -4, cmd_json_set, 'j', 's', 'o', 'n', '.', 's', 'e', 't') \
+    X("json.get", -2, cmd_json_get, 'j', 's', 'o', 'n', '.', 'g', 'e', 't') \
+    X("json.numincrby", 4, cmd_json_numincrby, 'j', 's', 'o', 'n', '.', 'n', 'u', 'm', 'i', 'n', 'c', 'r', 'b', 'y')\
+    X("json.arrappend", -4, cmd_json_arrappend, 'j', 's', 'o', 'n', '.', 'a', 'r', 'r', 'a', 'p', 'p', 'e', 'n', 'd')
+
+#define CMD_ENTRY(nm, ar, fn, ...)                                          \
+    [CMD_SLOT(CMD_WLO(__VA_ARGS__), sizeof(nm) - 1)] = {                    \
+        nm, CMD_WLO(__VA_ARGS__), CMD_WHI(__VA_ARGS__), CMD_MLO(__VA_ARGS__), CMD_MHI(__VA_ARGS__),  \
+        sizeof(nm) - 1, ar, fn},
+
+const struct cmd_def cmd_table[CMD_TABLE_SIZE] = {
+    CMD_LIST(CMD_ENTRY)
+};
+
+#define CMD_NAME(nm, ...) nm,
+static const char *const cmd_names[] = {CMD_LIST(CMD_NAME)};
+
+int cmd_table_check(void) {
+    for (size_t i = 0; i < sizeof(cmd_names) / sizeof(cmd_names[0]); i++) {
+        const struct cmd_def *c = cmd_lookup(cmd_names[i], strlen(cmd_names[i]));
+        if (!c || strcmp(c->name, cmd_names[i]) != 0) return (int) i + 1;
+    }
+    return 0;
+}
+
+/*********************** driver ******************************/
+
+int cmd_dispatch(struct connection_t *cn, struct element *argv, int argc) {
+    if (argc <= 0) return 0;
+    const struct cmd_def *c = cmd_lookup(argv[0].data, argv[0].len);
+    if (!c) {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "ERR unknown command '%.*s'",
+                 argv[0].len > 32 ? 32 : (int) argv[0].len, argv[0].data);
+        return reply_error(cn, msg);
+    }
+    if ((c->arity > 0 && argc != c->arity) || (c->arity < 0 && argc < -c->arity)) {
+        char msg[80];
+        snprintf(msg, sizeof(msg), "ERR wrong number of arguments for '%s' command", c->name);
+        return reply_error(cn, msg);
+    }
+    return c->handler(cn, argv, argc);
+}
+
+static inline void reset_segment(struct parser_context *ctx) {
+    memset(&ctx->segment_context, 0, offsetof(struct simple_segment_context, elements));
+    memset(&ctx->prog, 0, sizeof(ctx->prog));
+    ctx->state = COMPLETE;
+}
+
+static int on_read_batch(struct connection_t *cn) {
+    int ret = bindctx(cn);
+    if (ret < 0) return ret;
+    if (!cn->use_data_free) cn->use_data_free = free;
+    struct parser_context *ctx = cn->use_data;
+    struct simple_segment_context *stx = &ctx->segment_context;
+
+    // 命令起点: 命令跨越多次 read 时, 已聚合的 element 指针会因 read_buffer
+    // 扩容/压缩而失效, 所以不完整的命令总是回退到这里重新分帧
+    long long cmd_start = cn->rb_offset;
+    for (;;) {
+        if (!stx->in_array) {
+            cmd_start = cn->rb_offset;
+            // 整条命令单趟切完; 不是 *N $len 的形状时这一条退回逐帧分帧
+            ret = command_proceed(ctx);
+            if (ret == 0) break;
+            if (ret > 0) {
+                if ((ret = cmd_dispatch(cn, stx->elements, stx->element_count)) < 0) return ret;
+                continue;
+            }
+        }
+        ret = zerocopy_proceed(ctx);
+        if (ret < 0) goto protocol_error;
+        if (ctx->state != COMPLETE) break;
+        if (segment_proceed(stx, &ctx->outframe) < 0) goto protocol_error;
+        if (stx->consumed) {
+            stx->consumed = 0;
+            if ((ret = cmd_dispatch(cn, stx->elements, stx->element_count)) < 0) return ret;
+        }
+    }
+    // WAITING 的进度 (prog) 也一起丢弃, 下次从命令起点重新分帧
+    cn->rb_offset = cmd_start;
+    reset_segment(ctx);
+    // compact: 未消费的字节挪到头部, 给下一次 read 留空间
+    if (cn->rb_offset) {
+        memmove(cn->read_buffer, cn->read_buffer + cn->rb_offset, cn->rb_size - cn->rb_offset);
+        cn->rb_size -= cn->rb_offset;
+        cn->rb_offset = 0;
+    }
+    return 0;
+
+protocol_error:
+    // 与 Redis 一样: 回复错误后不再解析, 后面的字节已经对不上客户端的 pipeline, 连接由 epollrun 关闭
+    reset_segment(ctx);
+    if ((ret = reply_error(cn, "ERR Protocol error")) < 0) return ret;
+    return -EPROTO;
+}
+
+int cmd_on_read(struct connection_t *cn) {
+    if (cn->flag < 0) return cn->flag; // 连接即将关闭 (epollrun 通知的 ENOMEM, 或者上一次 on_read 的错误)
+    oclock_tick(); // 这一批命令共用一个 "现在"
+    int ret = on_read_batch(cn);
+    oclock_reset(); // 批次之外直接调用 cmd_ 的路径重新现读时钟
+    return ret;
+}
+
+int cmd_on_writer(struct connection_t *cn) {
+    (void) cn;
+    return 0;
+}
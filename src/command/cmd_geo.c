@@ -0,0 +1,301 @@
+//
+// Created by weishen on 2025/11/17.
+//
+
+#include "cmd_dispatch.h"
+#include "ogeo.h"
+
+#include <stdio.h>
+
+/*********************** geo handlers ******************************/
+
+/**
+ * 与 Redis 一样, GEO 的值就是一个 sorted set: member -> 52 位 geohash (作为 score)
+ * ZRANGE / ZREM / ZCARD 等命令可以直接作用在同一个 key 上
+ */
+
+/** 距离单位 -> 米的倍数, 0 表示不认识 */
+static double parse_unit(const struct element *e) {
+    if (arg_is(e, "m")) return 1;
+    if (arg_is(e, "km")) return 1000;
+    if (arg_is(e, "ft")) return 0.3048;
+    if (arg_is(e, "mi")) return 1609.34;
+    return 0;
+}
+
+static int parse_coord(const struct element *e, double *out) {
+    long double v;
+    if (string2ld(e->data, e->len, &v) < 0) return -EINVAL;
+    *out = (double) v;
+    return 0;
+}
+
+static int parse_lonlat(struct connection_t *cn, const struct element *e, double *lon, double *lat, int *ret) {
+    if (parse_coord(&e[0], lon) < 0 || parse_coord(&e[1], lat) < 0) {
+        *ret = reply_error(cn, "ERR value is not a valid float");
+        return -EINVAL;
+    }
+    if (!ogeo_valid(*lon, *lat)) {
+        char bf[128];
+        snprintf(bf, sizeof(bf), "ERR invalid longitude,latitude pair %f,%f", *lon, *lat);
+        *ret = reply_error(cn, bf);
+        return -EINVAL;
+    }
+    return 0;
+}
+
+static int reply_dist(struct connection_t *cn, double d) {
+    char bf[64];
+    int len = snprintf(bf, sizeof(bf), "%.4f", d);
+    return reply_bulk(cn, bf, len);
+}
+
+static int reply_coord(struct connection_t *cn, double v) {
+    char bf[64];
+    return reply_bulk(cn, bf, ld2string(bf, sizeof(bf), v));
+}
+
+#define GEOADD_NX 0x1
+#define GEOADD_XX 0x2
+#define GEOADD_CH 0x4
+
+/**
+ * GEOADD key [NX|XX] [CH] longitude latitude member [longitude latitude member ...]
+ * 先校验所有坐标再写, 参数错误时集合不变
+ */
+int cmd_geoadd(struct connection_t *cn, struct element *argv, int argc) {
+    int flags = 0, i = 2, ret;
+    for (; i < argc; i++) {
+        if (arg_is(&argv[i], "nx")) flags |= GEOADD_NX;
+        else if (arg_is(&argv[i], "xx")) flags |= GEOADD_XX;
+        else if (arg_is(&argv[i], "ch")) flags |= GEOADD_CH;
+        else break;
+    }
+    if (i == argc || (argc - i) % 3) return reply_error(cn, "ERR syntax error");
+    if ((flags & GEOADD_NX) && (flags & GEOADD_XX))
+        return reply_error(cn, "ERR XX and NX options at the same time are not compatible");
+    double lon, lat;
+    for (int j = i; j < argc; j += 3)
+        if (parse_lonlat(cn, &argv[j], &lon, &lat, &ret) < 0) return ret;
+
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_ZSET, (flags & GEOADD_XX) ? NULL : ozv_new, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+    long long changed = 0;
+    for (int j = i; j < argc; j += 3) {
+        parse_lonlat(cn, &argv[j], &lon, &lat, &ret);
+        double score = (double) ogeo_encode(lon, lat), cur = 0;
+        int exists = ozv_score(slot->v, argv[j + 2].data, argv[j + 2].len, &cur);
+        if ((exists && (flags & GEOADD_NX)) || (!exists && (flags & GEOADD_XX))) continue;
+        osv *v = slot->v;
+        ret = ozv_add(&v, argv[j + 2].data, argv[j + 2].len, score);
+        slot->v = v;
+        if (ret < 0) {
+            if (!ozv_len(v)) otype_remove(slot);
+            return reply_type_err(cn, ret);
+        }
+        changed += ret || ((flags & GEOADD_CH) && cur != score);
+    }
+    return reply_int(cn, changed);
+}
+
+/** member 的坐标 (格子中心) @return 1 找到, 0 不存在 */
+static int member_pos(const osv *v, const struct element *m, double *lon, double *lat) {
+    double score;
+    if (!ozv_score(v, m->data, m->len, &score)) return 0;
+    if (!(score >= 0 && score < (double) (1ULL << (2 * OGEO_STEP_MAX)))) return 0; // ZADD 写入的任意 score
+    ogeo_decode((uint64_t) score, lon, lat);
+    return 1;
+}
+
+/** GEODIST key member1 member2 [M|KM|FT|MI] */
+int cmd_geodist(struct connection_t *cn, struct element *argv, int argc) {
+    if (argc > 5) return reply_error(cn, "ERR syntax error");
+    double unit = argc == 5 ? parse_unit(&argv[4]) : 1;
+    if (unit == 0) return reply_error(cn, "ERR unsupported unit provided. please use M, KM, FT, MI");
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_ZSET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_nil(cn);
+    double lon1, lat1, lon2, lat2;
+    if (!member_pos(slot->v, &argv[2], &lon1, &lat1) || !member_pos(slot->v, &argv[3], &lon2, &lat2))
+        return reply_nil(cn);
+    return reply_dist(cn, ogeo_dist(lon1, lat1, lon2, lat2) / unit);
+}
+
+/*********************** GEOSEARCH ******************************/
+
+/**
+ * 候选点与结果的缓冲区, 跨调用复用 (单线程), 热路径上不再分配
+ * 候选点按列存放 (lon[] / lat[] 连续), 距离内核一次读 4 个
+ */
+struct geo_cand {
+    const char *m;
+    uint32_t mlen;
+    uint64_t bits;
+};
+
+struct geo_hit {
+    uint32_t c;
+    double dist;
+};
+
+static struct {
+    struct geo_cand *cand;
+    double *lon, *lat, *dist;
+    uint32_t *idx;
+    struct geo_hit *hits;
+    uint32_t cap;
+} gs;
+
+static int geo_reserve(uint64_t n) {
+    if (n <= gs.cap) return 0;
+    if (n > UINT32_MAX / 2) return -ENOMEM;
+    uint32_t cap = gs.cap ? gs.cap : 256;
+    while (cap < n) cap <<= 1;
+    void *p;
+    if (!(p = realloc(gs.cand, cap * sizeof(*gs.cand)))) return -ENOMEM;
+    gs.cand = p;
+    if (!(p = realloc(gs.lon, cap * sizeof(double)))) return -ENOMEM;
+    gs.lon = p;
+    if (!(p = realloc(gs.lat, cap * sizeof(double)))) return -ENOMEM;
+    gs.lat = p;
+    if (!(p = realloc(gs.dist, cap * sizeof(double)))) return -ENOMEM;
+    gs.dist = p;
+    if (!(p = realloc(gs.idx, cap * sizeof(uint32_t)))) return -ENOMEM;
+    gs.idx = p;
+    if (!(p = realloc(gs.hits, cap * sizeof(struct geo_hit)))) return -ENOMEM;
+    gs.hits = p;
+    gs.cap = cap;
+    return 0;
+}
+
+static int hit_asc(const void *a, const void *b) {
+    double x = ((const struct geo_hit *) a)->dist, y = ((const struct geo_hit *) b)->dist;
+    return x < y ? -1 : x > y;
+}
+
+static int hit_desc(const void *a, const void *b) {
+    return hit_asc(b, a);
+}
+
+/**
+ * 每个 score 区间: B+ 树定位一次, 顺序取出候选点并解码坐标, 然后整段交给 ogeo_within
+ * any: 凑够 limit 个就停 @return 命中个数, -ENOMEM
+ */
+static int64_t geo_collect(const osv *v, const struct ogeo_shape *s, uint64_t limit, int any) {
+    struct ogeo_range r[OGEO_RANGES_MAX];
+    uint32_t nr = ogeo_ranges(s, r);
+    uint32_t n = 0, nhits = 0;
+    for (uint32_t k = 0; k < nr; k++) {
+        struct ozv_iter it;
+        uint64_t rank = ozv_iter_score(&it, v, (double) r[k].min, 0);
+        uint32_t start = n;
+        const char *m;
+        uint32_t mlen;
+        double score;
+        for (; rank < ozv_len(v) && ozv_next(&it, &m, &mlen, &score) && score < (double) r[k].max; rank++) {
+            if (n == gs.cap && geo_reserve((uint64_t) n + 1) < 0) return -ENOMEM;
+            gs.cand[n] = (struct geo_cand) {m, mlen, (uint64_t) score};
+            ogeo_decode((uint64_t) score, &gs.lon[n], &gs.lat[n]);
+            n++;
+        }
+        uint32_t got = ogeo_within(s, gs.lon + start, gs.lat + start, n - start, gs.idx + start, gs.dist + start);
+        for (uint32_t j = 0; j < got; j++)
+            gs.hits[nhits++] = (struct geo_hit) {start + gs.idx[start + j], gs.dist[start + j]};
+        if (any && nhits >= limit) break;
+    }
+    return nhits;
+}
+
+#define GEO_WITHCOORD 0x1
+#define GEO_WITHDIST 0x2
+#define GEO_WITHHASH 0x4
+
+/**
+ * GEOSEARCH key <FROMMEMBER member | FROMLONLAT lon lat> <BYRADIUS r unit | BYBOX w h unit>
+ *           [ASC|DESC] [COUNT n [ANY]] [WITHCOORD] [WITHDIST] [WITHHASH]
+ * 回复: 没有 WITH* 时是 member 数组, 否则每项是 [member, dist?, hash?, [lon, lat]?]
+ */
+int cmd_geosearch(struct connection_t *cn, struct element *argv, int argc) {
+    struct ogeo_shape s = {0};
+    const struct element *from_member = NULL;
+    int from = 0, by = 0, sort = 0, any = 0, with = 0, ret;
+    int64_t count = 0;
+    double unit = 1;
+    for (int i = 2; i < argc; i++) {
+        if (arg_is(&argv[i], "frommember") && i + 1 < argc) {
+            from_member = &argv[++i];
+            from++;
+        } else if (arg_is(&argv[i], "fromlonlat") && i + 2 < argc) {
+            if (parse_lonlat(cn, &argv[i + 1], &s.lon, &s.lat, &ret) < 0) return ret;
+            i += 2;
+            from++;
+        } else if (arg_is(&argv[i], "byradius") && i + 2 < argc) {
+            if (parse_coord(&argv[i + 1], &s.radius) < 0) return reply_error(cn, "ERR need numeric radius");
+            if (s.radius < 0) return reply_error(cn, "ERR radius cannot be negative");
+            unit = parse_unit(&argv[i + 2]);
+            s.box = 0;
+            i += 2;
+            by++;
+        } else if (arg_is(&argv[i], "bybox") && i + 3 < argc) {
+            if (parse_coord(&argv[i + 1], &s.width) < 0 || parse_coord(&argv[i + 2], &s.height) < 0)
+                return reply_error(cn, "ERR need numeric width and height");
+            if (s.width < 0 || s.height < 0) return reply_error(cn, "ERR height or width cannot be negative");
+            unit = parse_unit(&argv[i + 3]);
+            s.box = 1;
+            i += 3;
+            by++;
+        } else if (arg_is(&argv[i], "asc")) sort = 1;
+        else if (arg_is(&argv[i], "desc")) sort = -1;
+        else if (arg_is(&argv[i], "count") && i + 1 < argc) {
+            if (string2ll(argv[i + 1].data, argv[i + 1].len, &count) < 0)
+                return reply_error(cn, "ERR value is not an integer or out of range");
+            if (count <= 0) return reply_error(cn, "ERR COUNT must be > 0");
+            i++;
+            if (i + 1 < argc && arg_is(&argv[i + 1], "any")) {
+                any = 1;
+                i++;
+            }
+        } else if (arg_is(&argv[i], "withcoord")) with |= GEO_WITHCOORD;
+        else if (arg_is(&argv[i], "withdist")) with |= GEO_WITHDIST;
+        else if (arg_is(&argv[i], "withhash")) with |= GEO_WITHHASH;
+        else return reply_error(cn, "ERR syntax error");
+    }
+    if (from != 1)
+        return reply_error(cn, "ERR exactly one of FROMMEMBER or FROMLONLAT can be specified for GEOSEARCH");
+    if (by != 1) return reply_error(cn, "ERR exactly one of BYRADIUS and BYBOX can be specified for GEOSEARCH");
+    if (unit == 0) return reply_error(cn, "ERR unsupported unit provided. please use M, KM, FT, MI");
+    s.radius *= unit;
+    s.width *= unit;
+    s.height *= unit;
+
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_ZSET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_array(cn, 0);
+    const osv *v = slot->v;
+    if (from_member && !member_pos(v, from_member, &s.lon, &s.lat))
+        return reply_error(cn, "ERR could not decode requested zset member");
+
+    if (count && !sort && !any) sort = 1; // 与 Redis 一样, 只给 COUNT 时返回最近的 count 个, 不是 geohash 序的前几个
+    int64_t n = geo_collect(v, &s, (uint64_t) count, any);
+    if (n < 0) return reply_type_err(cn, (int) n);
+    if (sort) qsort(gs.hits, (size_t) n, sizeof(struct geo_hit), sort > 0 ? hit_asc : hit_desc);
+    if (count && n > count) n = count;
+
+    int fields = 1 + !!(with & GEO_WITHDIST) + !!(with & GEO_WITHHASH) + !!(with & GEO_WITHCOORD);
+    ret = reply_array(cn, n);
+    for (int64_t i = 0; ret >= 0 && i < n; i++) {
+        const struct geo_hit *h = &gs.hits[i];
+        const struct geo_cand *c = &gs.cand[h->c];
+        if (with) ret = reply_array(cn, fields);
+        if (ret >= 0) ret = reply_bulk(cn, c->m, c->mlen);
+        if (ret >= 0 && (with & GEO_WITHDIST)) ret = reply_dist(cn, h->dist / unit);
+        if (ret >= 0 && (with & GEO_WITHHASH)) ret = reply_int(cn, (long long) c->bits);
+        if (ret >= 0 && (with & GEO_WITHCOORD)) {
+            ret = reply_array(cn, 2);
+            if (ret >= 0) ret = reply_coord(cn, gs.lon[h->c]);
+            if (ret >= 0) ret = reply_coord(cn, gs.lat[h->c]);
+        }
+    }
+    return ret;
+}
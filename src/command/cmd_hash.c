@@ -0,0 +1,117 @@
+//
+// Created by weishen on 2025/11/9.
+//
+
+#include "cmd_dispatch.h"
+
+/*********************** hash handlers ******************************/
+
+/** HSET key field value [field value ...] -> 新增的 field 数 */
+int cmd_hset(struct connection_t *cn, struct element *argv, int argc) {
+    if (argc & 1) return reply_error(cn, "ERR wrong number of arguments for 'hset' command");
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_HASH, ohv_new, &err);
+    if (!slot) return reply_type_err(cn, err);
+    long long added = 0;
+    for (int i = 2; i < argc; i += 2) {
+        osv *v = slot->v;
+        int ret = ohv_set(&v, argv[i].data, argv[i].len, argv[i + 1].data, argv[i + 1].len);
+        slot->v = v;
+        if (ret < 0) {
+            if (!ohv_len(v)) otype_remove(slot);
+            return reply_type_err(cn, ret);
+        }
+        added += ret;
+    }
+    return reply_int(cn, added);
+}
+
+int cmd_hget(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_HASH, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_nil(cn);
+    const char *val;
+    uint64_t vlen;
+    if (!ohv_get(slot->v, argv[2].data, argv[2].len, &val, &vlen)) return reply_nil(cn);
+    return reply_bulk(cn, val, (long long) vlen);
+}
+
+int cmd_hmget(struct connection_t *cn, struct element *argv, int argc) {
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_HASH, NULL, &err);
+    if (!slot && err) return reply_type_err(cn, err);
+    int ret = reply_array(cn, argc - 2);
+    for (int i = 2; i < argc && ret >= 0; i++) {
+        const char *val;
+        uint64_t vlen;
+        if (slot && ohv_get(slot->v, argv[i].data, argv[i].len, &val, &vlen))
+            ret = reply_bulk(cn, val, (long long) vlen);
+        else ret = reply_nil(cn);
+    }
+    return ret;
+}
+
+/** 删空的 hash 连同 key 一起删除 */
+int cmd_hdel(struct connection_t *cn, struct element *argv, int argc) {
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_HASH, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+    long long deleted = 0;
+    for (int i = 2; i < argc; i++) deleted += ohv_del(slot->v, argv[i].data, argv[i].len);
+    if (!ohv_len(slot->v)) otype_remove(slot);
+    return reply_int(cn, deleted);
+}
+
+int cmd_hgetall(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_HASH, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_array(cn, 0);
+    const osv *v = slot->v;
+    int ret = reply_array(cn, (long long) ohv_len(v) * 2);
+    struct ohv_iter it;
+    const char *f, *val;
+    uint32_t flen;
+    uint64_t vlen;
+    ohv_iter_init(&it, v);
+    while (ret >= 0 && ohv_next(&it, &f, &flen, &val, &vlen)) {
+        if ((ret = reply_bulk(cn, f, flen)) < 0) break;
+        ret = reply_bulk(cn, val, (long long) vlen);
+    }
+    return ret;
+}
+
+/** 值以字符串保存 (PACK 中没有地方放 OSV_INT), 每次解析 + 格式化 */
+int cmd_hincrby(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int64_t by, cur = 0;
+    if (string2ll(argv[3].data, argv[3].len, &by) < 0)
+        return reply_error(cn, "ERR value is not an integer or out of range");
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_HASH, ohv_new, &err);
+    if (!slot) return reply_type_err(cn, err);
+    const char *val;
+    uint64_t vlen;
+    if (ohv_get(slot->v, argv[2].data, argv[2].len, &val, &vlen) && string2ll(val, vlen, &cur) < 0)
+        return reply_error(cn, "ERR hash value is not an integer");
+    if (__builtin_add_overflow(cur, by, &cur))
+        return reply_error(cn, "ERR increment or decrement would overflow");
+    char bf[24];
+    osv *v = slot->v;
+    int ret = ohv_set(&v, argv[2].data, argv[2].len, bf, ll2str(bf, cur));
+    slot->v = v;
+    if (ret < 0) {
+        if (!ohv_len(v)) otype_remove(slot);
+        return reply_type_err(cn, ret);
+    }
+    return reply_int(cn, cur);
+}
+
+int cmd_hlen(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_HASH, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+    return reply_int(cn, (long long) ohv_len(slot->v));
+}
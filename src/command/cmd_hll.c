@@ -0,0 +1,79 @@
+//
+// Created by weishen on 2025/11/14.
+//
+
+#include "cmd_dispatch.h"
+
+/*********************** hyperloglog handlers ******************************/
+
+/** PFADD key [element ...] -> 1: 新建了 key 或者有寄存器变化 */
+int cmd_pfadd(struct connection_t *cn, struct element *argv, int argc) {
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_HLL, NULL, &err);
+    if (!slot && err) return reply_type_err(cn, err);
+    int changed = !slot;
+    if (!slot && !(slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_HLL, ohllv_new, &err)))
+        return reply_type_err(cn, err);
+    for (int i = 2; i < argc; i++) {
+        osv *v = slot->v;
+        int ret = ohllv_add(&v, argv[i].data, argv[i].len);
+        slot->v = v;
+        if (ret < 0) return reply_type_err(cn, ret);
+        changed |= ret;
+    }
+    return reply_int(cn, changed);
+}
+
+/**
+ * 把 argv[from, argc) 的寄存器合并到 regs, 不存在的 key 当作空 HLL
+ * @return 0 或 -EWRONGTYPE
+ */
+static int merge_keys(struct element *argv, int from, int argc, uint8_t *regs) {
+    for (int i = from; i < argc; i++) {
+        int err;
+        ohash_t *slot = otype_lookup(argv[i].data, argv[i].len, OSV_T_HLL, NULL, &err);
+        if (err) return err;
+        if (slot) ohllv_merge(slot->v, regs);
+    }
+    return 0;
+}
+
+/**
+ * PFCOUNT key [key ...]
+ * 单个 key 用 (并刷新) 缓存的基数, 多个 key 估算并集, 不写回任何缓存
+ */
+int cmd_pfcount(struct connection_t *cn, struct element *argv, int argc) {
+    int err;
+    if (argc == 2) {
+        ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_HLL, NULL, &err);
+        if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+        return reply_int(cn, (long long) ohllv_count(slot->v));
+    }
+    uint8_t regs[OHLL_REGS] = {0};
+    if ((err = merge_keys(argv, 1, argc, regs)) < 0) return reply_type_err(cn, err);
+    return reply_int(cn, (long long) ohll_estimate(regs));
+}
+
+/**
+ * PFMERGE destkey [sourcekey ...]
+ * 目标 (如果存在) 和所有源的寄存器逐个取 max, 结果总是 dense
+ * 目标已存在时原地替换值, 保留 TTL
+ */
+int cmd_pfmerge(struct connection_t *cn, struct element *argv, int argc) {
+    uint8_t regs[OHLL_REGS] = {0};
+    int err = merge_keys(argv, 1, argc, regs);
+    if (err < 0) return reply_type_err(cn, err);
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_HLL, NULL, &err);
+    osv *r = ohllv_from_regs(regs);
+    if (!r) return reply_type_err(cn, -ENOMEM);
+    if (slot) {
+        osv *old = slot->v;
+        r->ref = old->ref;
+        slot->v = r;
+        free(old);
+    } else if ((err = SET4own(argv[1].data, argv[1].len, r)) < 0) {
+        free(r);
+        return reply_write_err(cn, err);
+    }
+    return reply_ok(cn);
+}
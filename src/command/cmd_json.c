@@ -0,0 +1,183 @@
+//
+// Created by weishen on 2025/11/17.
+//
+
+#include "cmd_dispatch.h"
+
+#include <math.h>
+#include <stdio.h>
+
+/*********************** json handlers ******************************/
+
+/**
+ * $ 开头的路径按 JSONPath 回复: 结果包成数组 (这里最多一个元素), 不存在时是空数组
+ * 旧语法的路径直接回复结果本身, 不存在时报错
+ */
+
+static const char *err_no_key = "ERR could not perform this operation on a key that doesn't exist";
+
+/** 单线程: 解析出来的 node, 序列化的文本和路径共用这些缓冲区 */
+static struct ojbuf jb, tb;
+static struct ojpath path;
+
+static int reply_no_path(struct connection_t *cn, const struct element *e) {
+    char bf[256];
+    snprintf(bf, sizeof(bf), "ERR Path '%.*s' does not exist", e->len > 200 ? 200 : (int) e->len, e->data);
+    return reply_error(cn, bf);
+}
+
+static int parse_path(struct connection_t *cn, const struct element *e, int *ret) {
+    if (ojpath_parse(&path, e->data, e->len) < 0) {
+        *ret = reply_error(cn, "ERR invalid or unsupported JSON path");
+        return -EINVAL;
+    }
+    return 0;
+}
+
+static int reply_json_err(struct connection_t *cn, int err) {
+    if (err == -E2BIG) return reply_error(cn, "ERR JSON document too large");
+    return reply_type_err(cn, err);
+}
+
+/** JSON 类型的 key, 不存在时回复 err_no_key @return slot, NULL 表示已经回复了错误 (*ret) */
+static ohash_t *json_lookup(struct connection_t *cn, struct element *key, int *ret) {
+    int err;
+    ohash_t *slot = otype_lookup(key->data, key->len, OSV_T_JSON, NULL, &err);
+    if (!slot) *ret = err ? reply_type_err(cn, err) : reply_error(cn, err_no_key);
+    return slot;
+}
+
+/**
+ * JSON.SET key path value [NX | XX]
+ * 新 key 只能写根路径; 已有的文档按路径替换子树或者给 object 新增成员, 只移动它后面的字节
+ * @return OK, nil 表示 NX / XX 不满足或者父节点不存在
+ */
+int cmd_json_set(struct connection_t *cn, struct element *argv, int argc) {
+    int ret = 0, err, flags = 0;
+    for (int i = 4; i < argc; i++) {
+        if (arg_is(&argv[i], "nx")) flags |= OJSON_NX;
+        else if (arg_is(&argv[i], "xx")) flags |= OJSON_XX;
+        else return reply_error(cn, "ERR syntax error");
+    }
+    if (flags == (OJSON_NX | OJSON_XX)) return reply_error(cn, "ERR syntax error");
+    if (parse_path(cn, &argv[2], &ret) < 0) return ret;
+    jb.len = 0;
+    if ((err = ojson_parse(&jb, argv[3].data, argv[3].len)) < 0)
+        return err == -EINVAL ? reply_error(cn, "ERR invalid JSON") : reply_type_err(cn, err);
+
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_JSON, NULL, &err);
+    if (!slot && err) return reply_type_err(cn, err);
+    if (!slot) {
+        if (path.n) return reply_error(cn, "ERR new objects must be created at the root");
+        if (flags & OJSON_XX) return reply_nil(cn);
+        osv *v = ojsonv_new(jb.p, jb.len);
+        if (!v) return reply_type_err(cn, -ENOMEM);
+        if ((err = SET4own(argv[1].data, argv[1].len, v)) < 0) {
+            osv_free(v);
+            return reply_write_err(cn, err);
+        }
+        return reply_ok(cn);
+    }
+    osv *v = slot->v;
+    ret = ojsonv_set(&v, &path, jb.p, jb.len, flags);
+    slot->v = v;
+    if (ret < 0) return reply_json_err(cn, ret);
+    return ret ? reply_ok(cn) : reply_nil(cn);
+}
+
+/** 当前 path 的结果追加到 tb @return 0, -ENOENT (旧语法且不存在), -ENOMEM */
+static int dump_path(const osv *v) {
+    const char *node = ojsonv_find(v, &path);
+    if (!path.dollar) return node ? ojson_dump(&tb, node) : -ENOENT;
+    if (ojson_put(&tb, "[", 1) < 0 || (node && ojson_dump(&tb, node) < 0)) return -ENOMEM;
+    return ojson_put(&tb, "]", 1);
+}
+
+/**
+ * JSON.GET key [path ...]
+ * 只序列化路径指向的子树; 多个路径时回复 {"path": 结果, ...}
+ */
+int cmd_json_get(struct connection_t *cn, struct element *argv, int argc) {
+    int ret = 0, err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_JSON, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_nil(cn);
+    osv *v = slot->v;
+    tb.len = 0;
+    if (argc <= 3) {
+        if (argc == 2) ojpath_parse(&path, ".", 1);
+        else if (parse_path(cn, &argv[2], &ret) < 0) return ret;
+        if ((err = dump_path(v)) < 0) return err == -ENOENT ? reply_no_path(cn, &argv[2]) : reply_type_err(cn, err);
+        return reply_bulk(cn, tb.p, (long long) tb.len);
+    }
+    for (int i = 2; i < argc; i++) {
+        if (parse_path(cn, &argv[i], &ret) < 0) return ret;
+        if (ojson_put(&tb, i == 2 ? "{" : ",", 1) < 0 || ojson_put_string(&tb, argv[i].data, argv[i].len) < 0 ||
+            ojson_put(&tb, ":", 1) < 0)
+            return reply_type_err(cn, -ENOMEM);
+        if ((err = dump_path(v)) < 0) return err == -ENOENT ? reply_no_path(cn, &argv[i]) : reply_type_err(cn, err);
+    }
+    if (ojson_put(&tb, "}", 1) < 0) return reply_type_err(cn, -ENOMEM);
+    return reply_bulk(cn, tb.p, (long long) tb.len);
+}
+
+/**
+ * JSON.NUMINCRBY key path number -> 新的值 (JSON 文本)
+ * 数字在文档里是定长的 8 字节, 原地改写, 不移动任何字节
+ */
+int cmd_json_numincrby(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int ret = 0, by_int = 1;
+    int64_t i = 0;
+    double d = 0;
+    if (parse_path(cn, &argv[2], &ret) < 0) return ret;
+    if (string2ll(argv[3].data, argv[3].len, &i) < 0) {
+        long double ld;
+        if (string2ld(argv[3].data, argv[3].len, &ld) < 0 || !isfinite((double) ld))
+            return reply_error(cn, "ERR value is not a number");
+        by_int = 0;
+        d = (double) ld;
+    }
+    ohash_t *slot = json_lookup(cn, &argv[1], &ret);
+    if (!slot) return ret;
+    const char *node;
+    int err = ojsonv_numincrby(slot->v, &path, by_int, i, d, &node);
+    if (err == -ERANGE) return reply_error(cn, "ERR result is not a finite number");
+    if (!path.dollar) {
+        if (err == -ENOENT) return reply_no_path(cn, &argv[2]);
+        if (err == -EINVAL) return reply_error(cn, "ERR value at path is not a number");
+    }
+    tb.len = 0;
+    if (path.dollar && ojson_put(&tb, "[", 1) < 0) return reply_type_err(cn, -ENOMEM);
+    if (err == 0 && ojson_dump(&tb, node) < 0) return reply_type_err(cn, -ENOMEM);
+    if (err == -EINVAL && ojson_put(&tb, "null", 4) < 0) return reply_type_err(cn, -ENOMEM);
+    if (path.dollar && ojson_put(&tb, "]", 1) < 0) return reply_type_err(cn, -ENOMEM);
+    return reply_bulk(cn, tb.p, (long long) tb.len);
+}
+
+/**
+ * JSON.ARRAPPEND key path value [value ...] -> 追加后的长度
+ * 全部 value 先解析成首尾相连的 node, 再一次性插到数组末尾
+ */
+int cmd_json_arrappend(struct connection_t *cn, struct element *argv, int argc) {
+    int ret = 0, err;
+    if (parse_path(cn, &argv[2], &ret) < 0) return ret;
+    jb.len = 0;
+    for (int i = 3; i < argc; i++)
+        if ((err = ojson_parse(&jb, argv[i].data, argv[i].len)) < 0)
+            return err == -EINVAL ? reply_error(cn, "ERR invalid JSON") : reply_type_err(cn, err);
+    ohash_t *slot = json_lookup(cn, &argv[1], &ret);
+    if (!slot) return ret;
+    osv *v = slot->v;
+    int64_t n = ojsonv_arrappend(&v, &path, jb.p, jb.len, (uint32_t) (argc - 3));
+    slot->v = v;
+    if (n == -ENOMEM || n == -E2BIG) return reply_json_err(cn, (int) n);
+    if (!path.dollar) {
+        if (n == -ENOENT) return reply_no_path(cn, &argv[2]);
+        if (n == -EINVAL) return reply_error(cn, "ERR value at path is not an array");
+        return reply_int(cn, n);
+    }
+    if (n == -ENOENT) return reply_array(cn, 0);
+    ret = reply_array(cn, 1);
+    if (ret >= 0) ret = n == -EINVAL ? reply_nil(cn) : reply_int(cn, n);
+    return ret;
+}
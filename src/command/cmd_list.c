@@ -0,0 +1,160 @@
+//
+// Created by weishen on 2025/11/10.
+//
+
+#include "cmd_dispatch.h"
+
+/*********************** list handlers ******************************/
+
+/** LPUSH / RPUSH key element [element ...] -> push 之后的长度 */
+static int list_push(struct connection_t *cn, struct element *argv, int argc, int where) {
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_LIST, olv_new, &err);
+    if (!slot) return reply_type_err(cn, err);
+    for (int i = 2; i < argc; i++) {
+        int ret = olv_push(slot->v, where, argv[i].data, argv[i].len);
+        if (ret < 0) {
+            if (!olv_len(slot->v)) otype_remove(slot);
+            return reply_type_err(cn, ret);
+        }
+    }
+    return reply_int(cn, (long long) olv_len(slot->v));
+}
+
+int cmd_lpush(struct connection_t *cn, struct element *argv, int argc) {
+    return list_push(cn, argv, argc, OLIST_HEAD);
+}
+
+int cmd_rpush(struct connection_t *cn, struct element *argv, int argc) {
+    return list_push(cn, argv, argc, OLIST_TAIL);
+}
+
+/**
+ * LPOP / RPOP key [count]
+ * 没有 count: 一个元素或 nil; 有 count: 数组, key 不存在时是 nil 数组
+ * 元素先写进回复再删除 (peek 到的是节点里的数据)
+ */
+static int list_pop(struct connection_t *cn, struct element *argv, int argc, int where) {
+    if (argc > 3) return reply_error(cn, "ERR syntax error");
+    int64_t count = 1;
+    if (argc == 3 && (string2ll(argv[2].data, argv[2].len, &count) < 0 || count < 0))
+        return reply_error(cn, "ERR value is out of range, must be positive");
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_LIST, NULL, &err);
+    if (!slot) {
+        if (err) return reply_type_err(cn, err);
+        return argc == 3 ? reply_array(cn, -1) : reply_nil(cn);
+    }
+    osv *v = slot->v;
+    int ret = 0;
+    if (argc == 3) {
+        if ((uint64_t) count > olv_len(v)) count = (int64_t) olv_len(v);
+        ret = reply_array(cn, count);
+    }
+    const char *p;
+    uint64_t len;
+    for (int64_t i = 0; i < count && ret >= 0; i++) {
+        olv_peek(v, where, &p, &len);
+        if ((ret = reply_bulk(cn, p, (long long) len)) >= 0) ret = olv_pop(v, where);
+    }
+    if (!olv_len(v)) otype_remove(slot);
+    return ret;
+}
+
+int cmd_lpop(struct connection_t *cn, struct element *argv, int argc) {
+    return list_pop(cn, argv, argc, OLIST_HEAD);
+}
+
+int cmd_rpop(struct connection_t *cn, struct element *argv, int argc) {
+    return list_pop(cn, argv, argc, OLIST_TAIL);
+}
+
+int cmd_llen(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_LIST, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+    return reply_int(cn, (long long) olv_len(slot->v));
+}
+
+/**
+ * LRANGE / LTRIM 的下标: 负数从尾部算, 截到 [0, len - 1]
+ * @return 0 区间为空, 1 区间是 [*start, *stop], -1 不是整数
+ */
+static int list_range(const struct element *a, const struct element *b, uint64_t len,
+                      uint64_t *start, uint64_t *stop) {
+    int64_t s, e;
+    if (string2ll(a->data, a->len, &s) < 0 || string2ll(b->data, b->len, &e) < 0) return -1;
+    if (s < 0) s += (int64_t) len;
+    if (e < 0) e += (int64_t) len;
+    if (s < 0) s = 0;
+    if (e >= (int64_t) len) e = (int64_t) len - 1;
+    if (s > e || (uint64_t) s >= len) return 0;
+    *start = (uint64_t) s;
+    *stop = (uint64_t) e;
+    return 1;
+}
+
+int cmd_lrange(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_LIST, NULL, &err);
+    if (!slot && err) return reply_type_err(cn, err);
+    uint64_t start, stop;
+    int r = list_range(&argv[2], &argv[3], slot ? olv_len(slot->v) : 0, &start, &stop);
+    if (r < 0) return reply_error(cn, "ERR value is not an integer or out of range");
+    if (!r) return reply_array(cn, 0);
+    struct olv_iter it;
+    if (olv_iter_init(&it, slot->v, start) < 0) return reply_type_err(cn, -ENOMEM);
+    int ret = reply_array(cn, (long long) (stop - start + 1));
+    const char *p;
+    uint64_t len;
+    // 回复头已经写出, 中途解压失败只能断开连接
+    for (uint64_t i = start; i <= stop && ret >= 0; i++) {
+        if ((ret = olv_next(&it, &p, &len)) <= 0) {
+            ret = -ENOMEM;
+            break;
+        }
+        ret = reply_bulk(cn, p, (long long) len);
+    }
+    olv_iter_release(&it);
+    return ret;
+}
+
+/** 只保留 [start, stop], 区间为空时删除 key */
+int cmd_ltrim(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_LIST, NULL, &err);
+    if (!slot && err) return reply_type_err(cn, err);
+    uint64_t len = slot ? olv_len(slot->v) : 0, start, stop;
+    int r = list_range(&argv[2], &argv[3], len, &start, &stop);
+    if (r < 0) return reply_error(cn, "ERR value is not an integer or out of range");
+    if (!slot) return reply_ok(cn);
+    if (!r) {
+        otype_remove(slot);
+        return reply_ok(cn);
+    }
+    if (olv_trim(slot->v, start, len - 1 - stop) < 0) return reply_type_err(cn, -ENOMEM);
+    return reply_ok(cn);
+}
+
+int cmd_lindex(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int64_t idx;
+    if (string2ll(argv[2].data, argv[2].len, &idx) < 0)
+        return reply_error(cn, "ERR value is not an integer or out of range");
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_LIST, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_nil(cn);
+    uint64_t len = olv_len(slot->v);
+    if (idx < 0) idx += (int64_t) len;
+    if (idx < 0 || (uint64_t) idx >= len) return reply_nil(cn);
+    struct olv_iter it;
+    if (olv_iter_init(&it, slot->v, (uint64_t) idx) < 0) return reply_type_err(cn, -ENOMEM);
+    const char *p;
+    uint64_t plen;
+    int ret = olv_next(&it, &p, &plen) > 0 ? reply_bulk(cn, p, (long long) plen) : reply_type_err(cn, -ENOMEM);
+    olv_iter_release(&it);
+    return ret;
+}
@@ -0,0 +1,194 @@
+//
+// Created by weishen on 2025/11/12.
+//
+
+#include "cmd_dispatch.h"
+
+/*********************** set handlers ******************************/
+
+/** SADD key member [member ...] -> 新增的成员数 */
+int cmd_sadd(struct connection_t *cn, struct element *argv, int argc) {
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_SET, osetv_new, &err);
+    if (!slot) return reply_type_err(cn, err);
+    long long added = 0;
+    for (int i = 2; i < argc; i++) {
+        osv *v = slot->v;
+        int ret = osetv_add(&v, argv[i].data, argv[i].len);
+        slot->v = v;
+        if (ret < 0) {
+            if (!osetv_len(v)) otype_remove(slot);
+            return reply_type_err(cn, ret);
+        }
+        added += ret;
+    }
+    return reply_int(cn, added);
+}
+
+/** 删空的集合连同 key 一起删除 */
+int cmd_srem(struct connection_t *cn, struct element *argv, int argc) {
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_SET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+    long long deleted = 0;
+    for (int i = 2; i < argc; i++) deleted += osetv_del(slot->v, argv[i].data, argv[i].len);
+    if (!osetv_len(slot->v)) otype_remove(slot);
+    return reply_int(cn, deleted);
+}
+
+int cmd_sismember(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_SET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+    return reply_int(cn, osetv_has(slot->v, argv[2].data, argv[2].len));
+}
+
+int cmd_scard(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_SET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+    return reply_int(cn, (long long) osetv_len(slot->v));
+}
+
+static int reply_set(struct connection_t *cn, const osv *v) {
+    int ret = reply_array(cn, (long long) osetv_len(v));
+    struct osetv_iter it;
+    const char *m;
+    uint32_t mlen;
+    osetv_iter_init(&it, v);
+    while (ret >= 0 && osetv_next(&it, &m, &mlen)) ret = reply_bulk(cn, m, mlen);
+    return ret;
+}
+
+/** 整数编码是升序的, TABLE 按 slot 顺序 */
+int cmd_smembers(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_SET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_array(cn, 0);
+    return reply_set(cn, slot->v);
+}
+
+/**
+ * 查出 argv[1..argc) 的所有集合 (只读, slot 不会移动), 不存在的 key 是 NULL
+ * @return 0, 或者 -EWRONGTYPE / -ENOMEM, 此时没有分配 *sets
+ */
+static int lookup_sets(struct element *argv, int argc, osv ***sets, int *all_int) {
+    osv **s = malloc(sizeof(osv *) * (size_t) (argc - 1));
+    if (!s) return -ENOMEM;
+    *all_int = 1;
+    for (int i = 1; i < argc; i++) {
+        int err;
+        ohash_t *slot = otype_lookup(argv[i].data, argv[i].len, OSV_T_SET, NULL, &err);
+        if (!slot && err) {
+            free(s);
+            return err;
+        }
+        s[i - 1] = slot ? slot->v : NULL;
+        if (slot && !osetv_is_int(slot->v)) *all_int = 0;
+    }
+    *sets = s;
+    return 0;
+}
+
+static int cmp_len(const void *a, const void *b) {
+    uint64_t x = osetv_len(*(osv *const *) a), y = osetv_len(*(osv *const *) b);
+    return (x > y) - (x < y);
+}
+
+/**
+ * SINTER key [key ...]
+ * 全是整数编码: 从最小的集合开始两两做有序交集 (SIMD), 结果越来越小
+ * 否则遍历一次最小的集合, 到其余集合里逐个 osetv_has, 记下命中的迭代位置;
+ * 回复时按位置直接取回命中的成员, 不再重复查找
+ * 超过 oset_intset_max 的集合是 TABLE 编码, 走的是后一条路径 (查找次数 = 最小集合的大小)
+ */
+int cmd_sinter(struct connection_t *cn, struct element *argv, int argc) {
+    osv **sets;
+    int all_int, ret = lookup_sets(argv, argc, &sets, &all_int);
+    if (ret < 0) return reply_type_err(cn, ret);
+    int n = argc - 1;
+    for (int i = 0; i < n; i++) {
+        if (!sets[i]) {
+            free(sets);
+            return reply_array(cn, 0);
+        }
+    }
+    qsort(sets, (size_t) n, sizeof(osv *), cmp_len);
+    if (n == 1) ret = reply_set(cn, sets[0]);
+    else if (all_int) {
+        osv *r = osetv_inter_int(sets[0], sets[1]);
+        for (int i = 2; r && i < n && osetv_len(r); i++) {
+            osv *t = osetv_inter_int(r, sets[i]);
+            free(r);
+            r = t;
+        }
+        ret = r ? reply_set(cn, r) : reply_type_err(cn, -ENOMEM);
+        free(r);
+    } else {
+        uint64_t *hits = malloc(sizeof(uint64_t) * (size_t) osetv_len(sets[0]));
+        if (!hits) {
+            free(sets);
+            return reply_type_err(cn, -ENOMEM);
+        }
+        struct osetv_iter it;
+        const char *m;
+        uint32_t mlen;
+        long long count = 0;
+        osetv_iter_init(&it, sets[0]);
+        while (osetv_next(&it, &m, &mlen)) {
+            int i = 1;
+            while (i < n && osetv_has(sets[i], m, mlen)) i++;
+            if (i == n) hits[count++] = it.pos - 1; // osetv_next 之后 pos 指向下一项
+        }
+        ret = reply_array(cn, count);
+        for (long long j = 0; ret >= 0 && j < count; j++) {
+            it.pos = hits[j];
+            osetv_next(&it, &m, &mlen);
+            ret = reply_bulk(cn, m, mlen);
+        }
+        free(hits);
+    }
+    free(sets);
+    return ret;
+}
+
+/**
+ * SUNION key [key ...], 不存在的 key 当作空集
+ * 全是整数编码时两两有序归并, 否则把所有成员加入一个临时集合
+ */
+int cmd_sunion(struct connection_t *cn, struct element *argv, int argc) {
+    osv **sets;
+    int all_int, ret = lookup_sets(argv, argc, &sets, &all_int);
+    if (ret < 0) return reply_type_err(cn, ret);
+    osv *r = osetv_new();
+    for (int i = 0; r && i < argc - 1; i++) {
+        if (!sets[i]) continue;
+        if (all_int) {
+            osv *t = osetv_union_int(r, sets[i]);
+            free(r);
+            r = t;
+            continue;
+        }
+        struct osetv_iter it;
+        const char *m;
+        uint32_t mlen;
+        osetv_iter_init(&it, sets[i]);
+        while (osetv_next(&it, &m, &mlen)) {
+            if (osetv_add(&r, m, mlen) < 0) {
+                osetv_clear(r);
+                free(r);
+                r = NULL;
+                break;
+            }
+        }
+    }
+    free(sets);
+    if (!r) return reply_type_err(cn, -ENOMEM);
+    ret = reply_set(cn, r);
+    osetv_clear(r);
+    free(r);
+    return ret;
+}
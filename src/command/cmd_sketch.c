@@ -0,0 +1,172 @@
+//
+// Created by weishen on 2025/11/15.
+//
+
+#include "cmd_dispatch.h"
+
+/*********************** count-min sketch / top-k handlers ******************************/
+
+/** k / width / depth 的上限, 保证桶和堆的下标不溢出 u32 */
+#define OSKETCH_DIM_MAX (1LL << 30)
+
+/** key 不存在 (也不是别的类型) 时写入 v, 否则 v 被释放 */
+static int sketch_create(struct connection_t *cn, struct element *key, osv *v, const char *exists) {
+    if (!v) return reply_type_err(cn, -ENOMEM);
+    int err;
+    if (otype_lookup(key->data, key->len, osv_type(v), NULL, &err) || err == -EWRONGTYPE) {
+        osv_free(v);
+        return reply_error(cn, exists);
+    }
+    if ((err = SET4own(key->data, key->len, v)) < 0) {
+        osv_free(v);
+        return reply_write_err(cn, err);
+    }
+    return reply_ok(cn);
+}
+
+/** 已存在的 sketch, 不存在时回复 missing @return slot, NULL 表示已经回复了错误 (*ret) */
+static ohash_t *sketch_lookup(struct connection_t *cn, struct element *key, int type, const char *missing, int *ret) {
+    int err;
+    ohash_t *slot = otype_lookup(key->data, key->len, type, NULL, &err);
+    if (!slot) *ret = err ? reply_type_err(cn, err) : reply_error(cn, missing);
+    return slot;
+}
+
+static int parse_dim(const struct element *e, int64_t *out) {
+    return string2ll(e->data, e->len, out) == 0 && *out >= 1 && *out <= OSKETCH_DIM_MAX ? 0 : -EINVAL;
+}
+
+static int parse_prob(const struct element *e, double *out) {
+    long double d;
+    if (string2ld(e->data, e->len, &d) < 0 || !(d > 0 && d < 1)) return -EINVAL;
+    *out = (double) d;
+    return 0;
+}
+
+/** CMS.INITBYDIM key width depth */
+int cmd_cms_initbydim(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int64_t w, d;
+    if (parse_dim(&argv[2], &w) < 0) return reply_error(cn, "CMS: invalid width");
+    if (parse_dim(&argv[3], &d) < 0 || d > OCMS_DEPTH_MAX) return reply_error(cn, "CMS: invalid depth");
+    if (w * d >= INT32_MAX) return reply_error(cn, "CMS: invalid width");
+    return sketch_create(cn, &argv[1], ocmsv_new((uint32_t) w, (uint32_t) d), "CMS: key already exists");
+}
+
+/** CMS.INITBYPROB key error probability */
+int cmd_cms_initbyprob(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    double error, prob;
+    uint32_t w, d;
+    if (parse_prob(&argv[2], &error) < 0) return reply_error(cn, "CMS: invalid overestimation value");
+    if (parse_prob(&argv[3], &prob) < 0) return reply_error(cn, "CMS: invalid prob value");
+    if (ocms_dims(error, prob, &w, &d) < 0) return reply_error(cn, "CMS: sketch too large");
+    return sketch_create(cn, &argv[1], ocmsv_new(w, d), "CMS: key already exists");
+}
+
+/**
+ * CMS.INCRBY key item increment [item increment ...] -> 各元素增加后的估计值
+ * 先校验全部增量, 再每 OSKETCH_BATCH 个元素一组: 全部 hash 并预取各行的计数器, 再逐个增加
+ */
+int cmd_cms_incrby(struct connection_t *cn, struct element *argv, int argc) {
+    if (argc % 2) return reply_error(cn, "ERR wrong number of arguments for 'cms.incrby' command");
+    int ret;
+    ohash_t *slot = sketch_lookup(cn, &argv[1], OSV_T_CMS, "CMS: key does not exist", &ret);
+    if (!slot) return ret;
+    int64_t by;
+    for (int i = 3; i < argc; i += 2)
+        if (string2ll(argv[i].data, argv[i].len, &by) < 0 || by < 0 || by > UINT32_MAX)
+            return reply_error(cn, "CMS: Cannot parse number");
+    int n = (argc - 2) / 2;
+    ret = reply_array(cn, n);
+    uint64_t h[OSKETCH_BATCH];
+    for (int i = 0; ret >= 0 && i < n; i += OSKETCH_BATCH) {
+        int m = n - i < OSKETCH_BATCH ? n - i : OSKETCH_BATCH;
+        for (int j = 0; j < m; j++) {
+            const struct element *e = &argv[2 + 2 * (i + j)];
+            h[j] = osketch_hash(e->data, e->len);
+            ocmsv_prefetch(slot->v, h[j]);
+        }
+        for (int j = 0; ret >= 0 && j < m; j++) {
+            const struct element *e = &argv[3 + 2 * (i + j)];
+            string2ll(e->data, e->len, &by);
+            ret = reply_int(cn, ocmsv_incrby(slot->v, h[j], (uint32_t) by));
+        }
+    }
+    return ret;
+}
+
+/** CMS.QUERY key item [item ...], 预取方式同 CMS.INCRBY */
+int cmd_cms_query(struct connection_t *cn, struct element *argv, int argc) {
+    int ret;
+    ohash_t *slot = sketch_lookup(cn, &argv[1], OSV_T_CMS, "CMS: key does not exist", &ret);
+    if (!slot) return ret;
+    ret = reply_array(cn, argc - 2);
+    uint64_t h[OSKETCH_BATCH];
+    for (int i = 2; ret >= 0 && i < argc; i += OSKETCH_BATCH) {
+        int m = argc - i < OSKETCH_BATCH ? argc - i : OSKETCH_BATCH;
+        for (int j = 0; j < m; j++) {
+            h[j] = osketch_hash(argv[i + j].data, argv[i + j].len);
+            ocmsv_prefetch(slot->v, h[j]);
+        }
+        for (int j = 0; ret >= 0 && j < m; j++) ret = reply_int(cn, ocmsv_query(slot->v, h[j]));
+    }
+    return ret;
+}
+
+/** TOPK.RESERVE key topk [width depth decay] */
+int cmd_topk_reserve(struct connection_t *cn, struct element *argv, int argc) {
+    int64_t k, w = OTOPK_WIDTH_DEFAULT, d = OTOPK_DEPTH_DEFAULT;
+    long double decay = OTOPK_DECAY_DEFAULT;
+    if (argc != 3 && argc != 6) return reply_error(cn, "ERR wrong number of arguments for 'topk.reserve' command");
+    if (parse_dim(&argv[2], &k) < 0) return reply_error(cn, "TopK: invalid k");
+    if (argc == 6) {
+        if (parse_dim(&argv[3], &w) < 0) return reply_error(cn, "TopK: invalid width");
+        if (parse_dim(&argv[4], &d) < 0) return reply_error(cn, "TopK: invalid depth");
+        if (string2ld(argv[5].data, argv[5].len, &decay) < 0 || !(decay > 0 && decay <= 1))
+            return reply_error(cn, "TopK: invalid decay value. must be '<= 1' & '> 0'");
+        if (w * d > OSKETCH_DIM_MAX) return reply_error(cn, "TopK: invalid width");
+    }
+    osv *v = otopkv_new((uint32_t) k, (uint32_t) w, (uint32_t) d, (double) decay);
+    return sketch_create(cn, &argv[1], v, "TopK: key already exists");
+}
+
+/** TOPK.ADD key item [item ...] -> 每个元素挤出的元素, 没有时为 nil */
+int cmd_topk_add(struct connection_t *cn, struct element *argv, int argc) {
+    int ret;
+    ohash_t *slot = sketch_lookup(cn, &argv[1], OSV_T_TOPK, "TopK: key does not exist", &ret);
+    if (!slot) return ret;
+    ret = reply_array(cn, argc - 2);
+    for (int i = 2; ret >= 0 && i < argc; i++) {
+        char *out;
+        uint32_t olen;
+        int r = otopkv_add(slot->v, argv[i].data, argv[i].len, osketch_hash(argv[i].data, argv[i].len), &out, &olen);
+        if (r < 0) ret = reply_type_err(cn, r);
+        else if (!r) ret = reply_nil(cn);
+        else {
+            ret = reply_bulk(cn, out, olen);
+            free(out);
+        }
+    }
+    return ret;
+}
+
+/** TOPK.LIST key [WITHCOUNT], 按计数从大到小 */
+int cmd_topk_list(struct connection_t *cn, struct element *argv, int argc) {
+    int withcount = 0;
+    if (argc > 3 || (argc == 3 && !(withcount = arg_is(&argv[2], "WITHCOUNT"))))
+        return reply_error(cn, "ERR syntax error");
+    int ret;
+    ohash_t *slot = sketch_lookup(cn, &argv[1], OSV_T_TOPK, "TopK: key does not exist", &ret);
+    if (!slot) return ret;
+    const struct otopk_item **items = malloc(sizeof(*items) * otopkv_tk((osv *) slot->v)->k);
+    if (!items) return reply_type_err(cn, -ENOMEM);
+    uint32_t n = otopkv_list(slot->v, items);
+    ret = reply_array(cn, (long long) n * (withcount ? 2 : 1));
+    for (uint32_t i = 0; ret >= 0 && i < n; i++) {
+        ret = reply_bulk(cn, items[i]->item, items[i]->len);
+        if (ret >= 0 && withcount) ret = reply_int(cn, (long long) items[i]->count);
+    }
+    free(items);
+    return ret;
+}
@@ -0,0 +1,586 @@
+//
+// Created by weishen on 2025/11/16.
+//
+
+#include "cmd_dispatch.h"
+
+/*********************** stream handlers ******************************/
+
+#define STREAM_ID_MAX 44
+/** 字段/值对少于这个数时在栈上转换参数 */
+#define STREAM_FV_STACK 32
+
+static const char *err_bad_id = "ERR Invalid stream ID specified as stream command argument";
+
+static int u64str(char *bf, uint64_t v) {
+    char t[20];
+    int n = 0, len = 0;
+    do t[n++] = (char) ('0' + v % 10); while (v /= 10);
+    while (n) bf[len++] = t[--n];
+    return len;
+}
+
+/** ms-seq, XADD 每次都要回复, 不走 snprintf */
+static int reply_id(struct connection_t *cn, const struct ostream_id *id) {
+    char bf[STREAM_ID_MAX];
+    int len = u64str(bf, id->ms);
+    bf[len++] = '-';
+    len += u64str(bf + len, id->seq);
+    return reply_bulk(cn, bf, len);
+}
+
+/** [id, [field, value, ...]] */
+static int reply_entry(struct connection_t *cn, struct ostream_entry *e) {
+    int ret = reply_array(cn, 2);
+    if (ret >= 0) ret = reply_id(cn, &e->id);
+    if (ret >= 0) ret = reply_array(cn, (long long) e->nfields * 2);
+    struct ostream_str f, val;
+    for (uint32_t i = 0; ret >= 0 && i < e->nfields; i++) {
+        ostream_entry_next(e, &f, &val);
+        if ((ret = reply_bulk(cn, f.p, f.len)) >= 0) ret = reply_bulk(cn, val.p, val.len);
+    }
+    return ret;
+}
+
+static int parse_u64(const char *p, uint32_t len, uint64_t *out) {
+    int64_t v;
+    if (string2ll(p, len, &v) < 0 || v < 0) return -EINVAL;
+    *out = (uint64_t) v;
+    return 0;
+}
+
+/** ms 或 ms-seq, 只有 ms 时 seq 取 0 (upper 时取最大) */
+static int parse_id(const struct element *e, int upper, struct ostream_id *id) {
+    const char *dash = memchr(e->data, '-', e->len);
+    if (!dash) {
+        id->seq = upper ? UINT64_MAX : 0;
+        return parse_u64(e->data, e->len, &id->ms);
+    }
+    uint32_t ml = (uint32_t) (dash - e->data);
+    if (parse_u64(e->data, ml, &id->ms) < 0) return -EINVAL;
+    return parse_u64(dash + 1, e->len - ml - 1, &id->seq);
+}
+
+static int id_incr(struct ostream_id *id) {
+    if (id->seq < UINT64_MAX) id->seq++;
+    else if (id->ms < UINT64_MAX) id->ms++, id->seq = 0;
+    else return -1;
+    return 0;
+}
+
+static int id_decr(struct ostream_id *id) {
+    if (id->seq > 0) id->seq--;
+    else if (id->ms > 0) id->ms--, id->seq = UINT64_MAX;
+    else return -1;
+    return 0;
+}
+
+/**
+ * XRANGE 的边界: - / + / id / (id (不含)
+ * @return 0, 1 区间一定为空 (不含的边界越界), -EINVAL
+ */
+static int parse_range_id(const struct element *e, int upper, struct ostream_id *id) {
+    if (e->len == 1 && (e->data[0] == '-' || e->data[0] == '+')) {
+        id->ms = id->seq = e->data[0] == '-' ? 0 : UINT64_MAX;
+        return 0;
+    }
+    if (e->len > 1 && e->data[0] == '(') {
+        struct element in = {e->type, e->len - 1, e->data + 1};
+        if (parse_id(&in, upper, id) < 0) return -EINVAL;
+        return (upper ? id_decr(id) : id_incr(id)) < 0 ? 1 : 0;
+    }
+    return parse_id(e, upper, id);
+}
+
+/** 流中 [start, end] 内的 entry 数, 最多 limit 个 (0 不限) */
+static uint64_t range_count(const osv *v, const struct ostream_id *start, const struct ostream_id *end,
+                            uint64_t limit) {
+    struct ostream_iter it;
+    struct ostream_entry e;
+    uint64_t n = 0;
+    ostreamv_iter_init(&it, v, start);
+    while ((!limit || n < limit) && ostreamv_next(&it, &e) && ostream_id_cmp(&e.id, end) <= 0) n++;
+    return n;
+}
+
+/** 先数出个数写数组头, 再逐个回复 */
+static int reply_range(struct connection_t *cn, const osv *v, const struct ostream_id *start,
+                       const struct ostream_id *end, uint64_t limit) {
+    uint64_t n = range_count(v, start, end, limit);
+    int ret = reply_array(cn, (long long) n);
+    struct ostream_iter it;
+    struct ostream_entry e;
+    ostreamv_iter_init(&it, v, start);
+    for (uint64_t i = 0; ret >= 0 && i < n && ostreamv_next(&it, &e); i++) ret = reply_entry(cn, &e);
+    return ret;
+}
+
+struct stream_trim {
+    int strategy; // 0: 不裁剪, 1: MAXLEN, 2: MINID
+    int approx;
+    uint64_t maxlen;
+    struct ostream_id minid;
+};
+
+/** MAXLEN|MINID [=|~] threshold, argv[*i] 是 MAXLEN / MINID @return 0, -EINVAL (*i 指向下一个参数) */
+static int parse_trim(struct element *argv, int argc, int *i, struct stream_trim *t) {
+    t->strategy = arg_is(&argv[*i], "MAXLEN") ? 1 : 2;
+    t->approx = 0;
+    if (++*i < argc && argv[*i].len == 1 && (argv[*i].data[0] == '~' || argv[*i].data[0] == '=')) {
+        t->approx = argv[*i].data[0] == '~';
+        ++*i;
+    }
+    if (*i >= argc) return -EINVAL;
+    int r = t->strategy == 1 ? parse_u64(argv[*i].data, argv[*i].len, &t->maxlen) : parse_id(&argv[*i], 0, &t->minid);
+    ++*i;
+    return r;
+}
+
+static uint64_t apply_trim(osv *v, const struct stream_trim *t) {
+    if (t->strategy == 1) return ostreamv_trim_maxlen(v, t->maxlen, t->approx);
+    if (t->strategy == 2) return ostreamv_trim_minid(v, &t->minid, t->approx);
+    return 0;
+}
+
+/**
+ * 新 entry 的 ID: * 或 ms-* 自动生成, 否则必须大于 last
+ * @return 0, 或错误信息
+ */
+static const char *next_id(const struct element *e, const struct ostream_id *last, struct ostream_id *id) {
+    static const char *err_small = "ERR The ID specified in XADD is equal or smaller than the target stream top item";
+    if (e->len == 1 && e->data[0] == '*') {
+        uint64_t now = oclock_ms();
+        if (now > last->ms) {
+            *id = (struct ostream_id) {now, 0};
+            return NULL;
+        }
+        *id = *last;
+        return id_incr(id) < 0 ? err_small : NULL;
+    }
+    if (e->len > 2 && e->data[e->len - 1] == '*' && e->data[e->len - 2] == '-') {
+        if (parse_u64(e->data, e->len - 2, &id->ms) < 0) return err_bad_id;
+        if (id->ms < last->ms) return err_small;
+        if (id->ms > last->ms) id->seq = 0;
+        else if (last->seq == UINT64_MAX) return err_small;
+        else id->seq = last->seq + 1;
+        return NULL;
+    }
+    if (parse_id(e, 0, id) < 0) return err_bad_id;
+    if (!id->ms && !id->seq) return "ERR The ID specified in XADD must be greater than 0-0";
+    return ostream_id_cmp(id, last) <= 0 ? err_small : NULL;
+}
+
+/** XADD key [NOMKSTREAM] [MAXLEN|MINID [=|~] threshold] *|id field value [field value ...] -> ID */
+int cmd_xadd(struct connection_t *cn, struct element *argv, int argc) {
+    int i = 2, nomk = 0;
+    struct stream_trim t = {0};
+    for (; i < argc; i++) {
+        if (arg_is(&argv[i], "NOMKSTREAM")) nomk = 1;
+        else if (arg_is(&argv[i], "MAXLEN") || arg_is(&argv[i], "MINID")) {
+            if (parse_trim(argv, argc, &i, &t) < 0) return reply_error(cn, "ERR syntax error");
+            i--;
+        } else break;
+    }
+    int npairs = argc - i - 1;
+    if (npairs <= 0 || npairs % 2) return reply_error(cn, "ERR wrong number of arguments for 'xadd' command");
+    npairs /= 2;
+
+    // ID 在创建 key 之前校验, 失败时不留下空的 stream
+    int err, created = 0;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_STREAM, NULL, &err);
+    if (!slot && err) return reply_type_err(cn, err);
+    const struct ostream_id zero = {0, 0};
+    struct ostream_id id;
+    const char *bad = next_id(&argv[i], slot ? &ostreamv_s((osv *) slot->v)->last_id : &zero, &id);
+    if (bad) return reply_error(cn, bad);
+    if (!slot) {
+        if (nomk) return reply_nil(cn);
+        if (!(slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_STREAM, ostreamv_new, &err)))
+            return reply_type_err(cn, err);
+        created = 1;
+    }
+
+    struct ostream_str stack[STREAM_FV_STACK * 2], *fv = stack;
+    if (npairs > STREAM_FV_STACK && !(fv = malloc(sizeof(*fv) * 2 * npairs))) err = -ENOMEM;
+    else {
+        for (int j = 0; j < 2 * npairs; j++) fv[j] = (struct ostream_str) {argv[i + 1 + j].data, argv[i + 1 + j].len};
+        err = ostreamv_append(slot->v, &id, fv, (uint32_t) npairs);
+        if (fv != stack) free(fv);
+    }
+    if (err < 0) {
+        if (created) otype_remove(slot);
+        return reply_type_err(cn, err);
+    }
+    apply_trim(slot->v, &t);
+    return reply_id(cn, &id);
+}
+
+/** XLEN key */
+int cmd_xlen(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_STREAM, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+    return reply_int(cn, (long long) ostreamv_s((osv *) slot->v)->length);
+}
+
+/** COUNT n, 出现在 argv[*i] 时解析并前进 @return 0, -EINVAL */
+static int parse_count(struct element *argv, int argc, int *i, uint64_t *count) {
+    if (*i + 1 >= argc || parse_u64(argv[*i + 1].data, argv[*i + 1].len, count) < 0) return -EINVAL;
+    *i += 2;
+    return 0;
+}
+
+/** XRANGE key start end [COUNT n] */
+int cmd_xrange(struct connection_t *cn, struct element *argv, int argc) {
+    struct ostream_id start, end;
+    uint64_t count = 0;
+    int es = parse_range_id(&argv[2], 0, &start), ee = parse_range_id(&argv[3], 1, &end);
+    if (es < 0 || ee < 0) return reply_error(cn, err_bad_id);
+    int i = 4;
+    if (argc > 4 && !(argc == 6 && arg_is(&argv[4], "COUNT") && parse_count(argv, argc, &i, &count) == 0))
+        return reply_error(cn, "ERR syntax error");
+    if (argc == 6 && !count) return reply_array(cn, 0);
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_STREAM, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_array(cn, 0);
+    if (es || ee || ostream_id_cmp(&start, &end) > 0) return reply_array(cn, 0);
+    return reply_range(cn, slot->v, &start, &end, count);
+}
+
+/** XTRIM key MAXLEN|MINID [=|~] threshold -> 删除的个数 */
+int cmd_xtrim(struct connection_t *cn, struct element *argv, int argc) {
+    struct stream_trim t;
+    int i = 2;
+    if (!arg_is(&argv[2], "MAXLEN") && !arg_is(&argv[2], "MINID")) return reply_error(cn, "ERR syntax error");
+    if (parse_trim(argv, argc, &i, &t) < 0 || i != argc) return reply_error(cn, "ERR syntax error");
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_STREAM, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+    return reply_int(cn, (long long) apply_trim(slot->v, &t));
+}
+
+/**
+ * STREAMS key [key ...] id [id ...] 的位置
+ * @return key 的个数, 或 -1 (已回复错误)
+ */
+static int parse_streams(struct connection_t *cn, struct element *argv, int argc, int i, int *ret) {
+    if (i >= argc || !arg_is(&argv[i], "STREAMS")) return *ret = reply_error(cn, "ERR syntax error"), -1;
+    int rest = argc - i - 1;
+    if (rest <= 0 || rest % 2)
+        return *ret = reply_error(cn, "ERR Unbalanced 'xread' list of streams: for each stream key an ID or '$' must be specified."), -1;
+    return rest / 2;
+}
+
+/**
+ * XREAD [COUNT n] STREAMS key [key ...] id [id ...] -> [[key, entries] ...], 都没有新 entry 时 nil
+ * 没有阻塞: 事件循环不挂起连接, BLOCK 返回错误, 由客户端轮询
+ */
+int cmd_xread(struct connection_t *cn, struct element *argv, int argc) {
+    uint64_t count = 0;
+    int i = 1, ret, err;
+    while (i < argc && !arg_is(&argv[i], "STREAMS")) {
+        if (arg_is(&argv[i], "COUNT")) {
+            if (parse_count(argv, argc, &i, &count) < 0) return reply_error(cn, "ERR syntax error");
+        } else if (arg_is(&argv[i], "BLOCK")) {
+            return reply_error(cn, "ERR BLOCK is not supported, poll with XREAD instead");
+        } else {
+            return reply_error(cn, "ERR syntax error");
+        }
+    }
+    int nkeys = parse_streams(cn, argv, argc, i, &ret);
+    if (nkeys < 0) return ret;
+    struct element *keys = argv + i + 1, *ids = keys + nkeys;
+    struct {
+        osv *v;
+        struct ostream_id from;
+        uint64_t n;
+    } *ks = malloc(sizeof(*ks) * nkeys);
+    if (!ks) return reply_type_err(cn, -ENOMEM);
+    const struct ostream_id top = {UINT64_MAX, UINT64_MAX};
+    int found = 0;
+    for (int j = 0; j < nkeys; j++) {
+        ohash_t *slot = otype_lookup(keys[j].data, keys[j].len, OSV_T_STREAM, NULL, &err);
+        if (!slot && err) {
+            free(ks);
+            return reply_type_err(cn, err);
+        }
+        ks[j].v = slot ? slot->v : NULL;
+        if (ids[j].len == 1 && ids[j].data[0] == '$') {
+            ks[j].from = ks[j].v ? ostreamv_s(ks[j].v)->last_id : (struct ostream_id) {0, 0};
+        } else if (parse_id(&ids[j], 0, &ks[j].from) < 0) {
+            free(ks);
+            return reply_error(cn, err_bad_id);
+        }
+        ks[j].n = ks[j].v && id_incr(&ks[j].from) == 0 ? range_count(ks[j].v, &ks[j].from, &top, count) : 0;
+        found += ks[j].n > 0;
+    }
+    ret = reply_array(cn, found ? found : -1);
+    for (int j = 0; ret >= 0 && j < nkeys; j++) {
+        if (!ks[j].n) continue;
+        ret = reply_array(cn, 2);
+        if (ret >= 0) ret = reply_bulk(cn, keys[j].data, keys[j].len);
+        if (ret >= 0) ret = reply_range(cn, ks[j].v, &ks[j].from, &top, ks[j].n);
+    }
+    free(ks);
+    return ret;
+}
+
+/*********************** consumer groups ******************************/
+
+/**
+ * XGROUP CREATE key group id|$ [MKSTREAM]
+ * XGROUP DESTROY key group
+ */
+int cmd_xgroup(struct connection_t *cn, struct element *argv, int argc) {
+    int err;
+    if (arg_is(&argv[1], "CREATE")) {
+        int mk = argc == 6 && arg_is(&argv[5], "MKSTREAM");
+        if (argc < 5 || (argc == 6 && !mk) || argc > 6) return reply_error(cn, "ERR syntax error");
+        ohash_t *slot = otype_lookup(argv[2].data, argv[2].len, OSV_T_STREAM, mk ? ostreamv_new : NULL, &err);
+        if (!slot && err) return reply_type_err(cn, err);
+        if (!slot)
+            return reply_error(cn, "ERR The XGROUP subcommand requires the key to exist. "
+                                   "Note that for CREATE you may want to use the MKSTREAM option to create an empty stream automatically.");
+        struct ostream_id last;
+        if (argv[4].len == 1 && argv[4].data[0] == '$') last = ostreamv_s((osv *) slot->v)->last_id;
+        else if (parse_id(&argv[4], 0, &last) < 0) return reply_error(cn, err_bad_id);
+        err = ostreamv_group_create(slot->v, argv[3].data, argv[3].len, &last);
+        if (err == -EEXIST) return reply_error(cn, "BUSYGROUP Consumer Group name already exists");
+        return err < 0 ? reply_type_err(cn, err) : reply_ok(cn);
+    }
+    if (arg_is(&argv[1], "DESTROY")) {
+        if (argc != 4) return reply_error(cn, "ERR syntax error");
+        ohash_t *slot = otype_lookup(argv[2].data, argv[2].len, OSV_T_STREAM, NULL, &err);
+        if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+        return reply_int(cn, ostreamv_group_destroy(slot->v, argv[3].data, argv[3].len));
+    }
+    return reply_error(cn, "ERR unknown XGROUP subcommand, try CREATE or DESTROY");
+}
+
+/** key 上的消费组, 不存在时回复 NOGROUP */
+static struct osgroup *group_lookup(struct connection_t *cn, const struct element *key, const struct element *group,
+                                    osv **v, int *ret) {
+    int err;
+    ohash_t *slot = otype_lookup(key->data, key->len, OSV_T_STREAM, NULL, &err);
+    if (!slot && err) return *ret = reply_type_err(cn, err), NULL;
+    struct osgroup *g = slot ? ostreamv_group(slot->v, group->data, group->len) : NULL;
+    if (!g) {
+        char bf[256];
+        snprintf(bf, sizeof(bf), "NOGROUP No such key '%.*s' or consumer group '%.*s'",
+                 (int) (key->len < 64 ? key->len : 64), key->data, (int) (group->len < 64 ? group->len : 64), group->data);
+        *ret = reply_error(cn, bf);
+        return NULL;
+    }
+    *v = slot->v;
+    return g;
+}
+
+/** consumer 在 PEL 中 >= from 的 entry 数, 最多 limit 个 */
+static uint64_t history_count(const struct osgroup *g, uint32_t c, const struct ostream_id *from, uint64_t limit) {
+    uint64_t n = 0;
+    for (uint64_t k = osgroup_pel_seek(g, from); k < g->npel && (!limit || n < limit); k++)
+        n += g->pel[k].consumer == c;
+    return n;
+}
+
+/** 重新投递 consumer 自己待确认的 entry, 已经被裁剪掉的回复 [id, nil] */
+static int reply_history(struct connection_t *cn, const osv *v, struct osgroup *g, uint32_t c,
+                         const struct ostream_id *from, uint64_t n, uint64_t now) {
+    int ret = reply_array(cn, (long long) n);
+    struct ostream_entry e;
+    for (uint64_t k = osgroup_pel_seek(g, from); ret >= 0 && n && k < g->npel; k++) {
+        struct ospel *p = g->pel + k;
+        if (p->consumer != c) continue;
+        n--;
+        p->deliveries++;
+        p->delivered_ms = now;
+        if (ostreamv_get(v, &p->id, &e)) {
+            ret = reply_entry(cn, &e);
+        } else {
+            ret = reply_array(cn, 2);
+            if (ret >= 0) ret = reply_id(cn, &p->id);
+            if (ret >= 0) ret = reply_nil(cn);
+        }
+    }
+    return ret;
+}
+
+/** 投递 last_delivered 之后的新 entry, 记入 PEL (NOACK 时不记) */
+static int reply_new(struct connection_t *cn, osv *v, struct osgroup *g, uint32_t c, uint64_t n, int noack,
+                     uint64_t now) {
+    struct ostream_id from = g->last_delivered;
+    int ret = reply_array(cn, (long long) n);
+    if (id_incr(&from) < 0) return ret;
+    struct ostream_iter it;
+    struct ostream_entry e;
+    ostreamv_iter_init(&it, v, &from);
+    for (uint64_t i = 0; ret >= 0 && i < n && ostreamv_next(&it, &e); i++) {
+        g->last_delivered = e.id;
+        if (!noack && (ret = osgroup_pel_add(g, &e.id, c, now)) < 0) break;
+        ret = reply_entry(cn, &e);
+    }
+    return ret;
+}
+
+/**
+ * XREADGROUP GROUP group consumer [COUNT n] [NOACK] STREAMS key [key ...] id [id ...]
+ * id 为 > 时读新 entry 并记入 PEL, 否则重新读 consumer 自己大于 id 的待确认 entry
+ */
+int cmd_xreadgroup(struct connection_t *cn, struct element *argv, int argc) {
+    uint64_t count = 0, now = oclock_ms();
+    int noack = 0, i = 4, ret;
+    if (!arg_is(&argv[1], "GROUP")) return reply_error(cn, "ERR syntax error");
+    while (i < argc && !arg_is(&argv[i], "STREAMS")) {
+        if (arg_is(&argv[i], "COUNT")) {
+            if (parse_count(argv, argc, &i, &count) < 0) return reply_error(cn, "ERR syntax error");
+        } else if (arg_is(&argv[i], "NOACK")) {
+            noack = 1;
+            i++;
+        } else if (arg_is(&argv[i], "BLOCK")) {
+            return reply_error(cn, "ERR BLOCK is not supported, poll with XREADGROUP instead");
+        } else {
+            return reply_error(cn, "ERR syntax error");
+        }
+    }
+    int nkeys = parse_streams(cn, argv, argc, i, &ret);
+    if (nkeys < 0) return ret;
+    struct element *keys = argv + i + 1, *ids = keys + nkeys;
+    struct {
+        osv *v;
+        struct osgroup *g;
+        struct ostream_id from; // 历史模式: 从这个 ID 开始
+        uint64_t n;
+        uint32_t c;
+        int newer; // id 是 >
+    } *ks = malloc(sizeof(*ks) * nkeys);
+    if (!ks) return reply_type_err(cn, -ENOMEM);
+    int found = 0;
+    for (int j = 0; j < nkeys; j++) {
+        if (!(ks[j].g = group_lookup(cn, &keys[j], &argv[2], &ks[j].v, &ret))) goto done;
+        ks[j].newer = ids[j].len == 1 && ids[j].data[0] == '>';
+        if (!ks[j].newer && (parse_id(&ids[j], 0, &ks[j].from) < 0 || id_incr(&ks[j].from) < 0)) {
+            ret = reply_error(cn, err_bad_id);
+            goto done;
+        }
+        int64_t c = osgroup_consumer(ks[j].g, argv[3].data, argv[3].len, 1);
+        if (c < 0) {
+            ret = reply_type_err(cn, (int) c);
+            goto done;
+        }
+        ks[j].c = (uint32_t) c;
+        ks[j].g->consumers[c].seen_ms = now;
+        if (ks[j].newer) {
+            struct ostream_id f = ks[j].g->last_delivered;
+            const struct ostream_id top = {UINT64_MAX, UINT64_MAX};
+            ks[j].n = id_incr(&f) == 0 ? range_count(ks[j].v, &f, &top, count) : 0;
+            found += ks[j].n > 0;
+        } else {
+            ks[j].n = history_count(ks[j].g, ks[j].c, &ks[j].from, count);
+            found++;
+        }
+    }
+    ret = reply_array(cn, found ? found : -1);
+    for (int j = 0; ret >= 0 && j < nkeys; j++) {
+        if (ks[j].newer && !ks[j].n) continue;
+        ret = reply_array(cn, 2);
+        if (ret >= 0) ret = reply_bulk(cn, keys[j].data, keys[j].len);
+        if (ret < 0) break;
+        ret = ks[j].newer ? reply_new(cn, ks[j].v, ks[j].g, ks[j].c, ks[j].n, noack, now)
+                          : reply_history(cn, ks[j].v, ks[j].g, ks[j].c, &ks[j].from, ks[j].n, now);
+    }
+done:
+    free(ks);
+    return ret;
+}
+
+/** XACK key group id [id ...] -> 确认的个数 */
+int cmd_xack(struct connection_t *cn, struct element *argv, int argc) {
+    struct ostream_id id;
+    for (int i = 3; i < argc; i++)
+        if (parse_id(&argv[i], 0, &id) < 0) return reply_error(cn, err_bad_id);
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_STREAM, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+    struct osgroup *g = ostreamv_group(slot->v, argv[2].data, argv[2].len);
+    if (!g) return reply_int(cn, 0);
+    long long acked = 0;
+    for (int i = 3; i < argc; i++) {
+        parse_id(&argv[i], 0, &id);
+        acked += osgroup_ack(g, &id);
+    }
+    return reply_int(cn, acked);
+}
+
+/** [pending, 最小 ID, 最大 ID, [[consumer, count] ...]] */
+static int reply_pending_summary(struct connection_t *cn, const struct osgroup *g) {
+    if (!g->pending) {
+        int ret = reply_array(cn, 4);
+        if (ret >= 0) ret = reply_int(cn, 0);
+        for (int k = 0; ret >= 0 && k < 3; k++) ret = reply_nil(cn);
+        return ret;
+    }
+    uint64_t first = osgroup_pel_seek(g, &(struct ostream_id) {0, 0}), last = g->npel - 1;
+    while (g->pel[last].consumer == OSPEL_ACKED) last--;
+    uint32_t active = 0;
+    for (uint32_t c = 0; c < g->nconsumers; c++) active += g->consumers[c].pending > 0;
+    int ret = reply_array(cn, 4);
+    if (ret >= 0) ret = reply_int(cn, (long long) g->pending);
+    if (ret >= 0) ret = reply_id(cn, &g->pel[first].id);
+    if (ret >= 0) ret = reply_id(cn, &g->pel[last].id);
+    if (ret >= 0) ret = reply_array(cn, active);
+    for (uint32_t c = 0; ret >= 0 && c < g->nconsumers; c++) {
+        const struct osconsumer *o = g->consumers + c;
+        if (!o->pending) continue;
+        char bf[24];
+        int len = ll2str(bf, (long long) o->pending);
+        if ((ret = reply_array(cn, 2)) >= 0 && (ret = reply_bulk(cn, o->name, o->len)) >= 0)
+            ret = reply_bulk(cn, bf, len);
+    }
+    return ret;
+}
+
+/**
+ * XPENDING key group -> 汇总
+ * XPENDING key group [IDLE ms] start end count [consumer] -> [[id, consumer, idle ms, deliveries] ...]
+ */
+int cmd_xpending(struct connection_t *cn, struct element *argv, int argc) {
+    int ret, i = 3;
+    uint64_t idle = 0, count = 0; // 没有 start end count 时是汇总, 不用 count
+    struct ostream_id start, end;
+    if (argc > 3) {
+        if (arg_is(&argv[3], "IDLE") && (argc < 5 || parse_u64(argv[4].data, argv[4].len, &idle) < 0))
+            return reply_error(cn, "ERR syntax error");
+        if (arg_is(&argv[3], "IDLE")) i = 5;
+        if (argc - i != 3 && argc - i != 4) return reply_error(cn, "ERR syntax error");
+        int es = parse_range_id(&argv[i], 0, &start), ee = parse_range_id(&argv[i + 1], 1, &end);
+        if (es < 0 || ee < 0) return reply_error(cn, err_bad_id);
+        if (parse_u64(argv[i + 2].data, argv[i + 2].len, &count) < 0)
+            return reply_error(cn, "ERR value is not an integer or out of range");
+        if (es || ee) count = 0;
+    }
+    osv *v;
+    struct osgroup *g = group_lookup(cn, &argv[1], &argv[2], &v, &ret);
+    if (!g) return ret;
+    if (argc == 3) return reply_pending_summary(cn, g);
+
+    int64_t c = -2; // 不限 consumer
+    if (argc - i == 4 && (c = osgroup_consumer(g, argv[i + 3].data, argv[i + 3].len, 0)) < 0) return reply_array(cn, 0);
+    uint64_t now = oclock_ms(), n = 0, k0 = osgroup_pel_seek(g, &start);
+#define PEL_MATCH(p) ((p)->consumer != OSPEL_ACKED && (c < 0 || (p)->consumer == (uint32_t) c) && \
+                      now - (p)->delivered_ms >= idle)
+    for (uint64_t k = k0; n < count && k < g->npel && ostream_id_cmp(&g->pel[k].id, &end) <= 0; k++)
+        n += PEL_MATCH(g->pel + k);
+    ret = reply_array(cn, (long long) n);
+    for (uint64_t k = k0; ret >= 0 && n; k++) {
+        const struct ospel *p = g->pel + k;
+        if (!PEL_MATCH(p)) continue;
+        n--;
+        const struct osconsumer *o = g->consumers + p->consumer;
+        if ((ret = reply_array(cn, 4)) >= 0 && (ret = reply_id(cn, &p->id)) >= 0 &&
+            (ret = reply_bulk(cn, o->name, o->len)) >= 0 && (ret = reply_int(cn, (long long) (now - p->delivered_ms))) >= 0)
+            ret = reply_int(cn, p->deliveries);
+    }
+#undef PEL_MATCH
+    return ret;
+}
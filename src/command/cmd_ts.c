@@ -0,0 +1,228 @@
+//
+// Created by weishen on 2025/11/16.
+//
+
+#include "cmd_dispatch.h"
+
+/*********************** time series handlers ******************************/
+
+#define TS_VALUE_MAX 32
+
+/** 值的十进制形式: 能 round-trip 的最短 %g */
+static int reply_value(struct connection_t *cn, double d) {
+    char bf[TS_VALUE_MAX];
+    if (isinf(d)) return d > 0 ? reply_simple(cn, "inf", 3) : reply_simple(cn, "-inf", 4);
+    int len = snprintf(bf, sizeof(bf), "%.15g", d);
+    if (strtod(bf, NULL) != d) len = snprintf(bf, sizeof(bf), "%.17g", d);
+    return reply_simple(cn, bf, len);
+}
+
+/** [ts, value] */
+static int reply_sample(struct connection_t *cn, const struct ots_sample *s) {
+    int ret = reply_array(cn, 2);
+    if (ret >= 0) ret = reply_int(cn, s->ts);
+    return ret >= 0 ? reply_value(cn, s->v) : ret;
+}
+
+static int reply_samples(struct connection_t *cn, const struct ots_sample *a, int64_t n) {
+    int ret = reply_array(cn, n);
+    for (int64_t i = 0; ret >= 0 && i < n; i++) ret = reply_sample(cn, a + i);
+    return ret;
+}
+
+/** 非负的毫秒时间戳, range 的边界还可以是 - / + */
+static int parse_ts(const struct element *e, int range, int64_t *out) {
+    if (range && e->len == 1 && (e->data[0] == '-' || e->data[0] == '+')) {
+        *out = e->data[0] == '-' ? 0 : INT64_MAX;
+        return 0;
+    }
+    return string2ll(e->data, e->len, out) == 0 && *out >= 0 ? 0 : -EINVAL;
+}
+
+static int parse_value(const struct element *e, double *out) {
+    long double d;
+    if (string2ld(e->data, e->len, &d) < 0) return -EINVAL;
+    *out = (double) d;
+    return 0;
+}
+
+struct ts_create_opts {
+    int64_t retention;
+    int64_t chunk_size;
+};
+
+/** [RETENTION ms] [CHUNK_SIZE bytes] @return 0, 或已回复的错误 (*ret) */
+static int parse_create_opts(struct connection_t *cn, struct element *argv, int i, int argc,
+                             struct ts_create_opts *o, int *ret) {
+    o->retention = 0;
+    o->chunk_size = OTS_CHUNK_SIZE_DEFAULT;
+    for (; i < argc; i += 2) {
+        if (i + 1 >= argc) return *ret = reply_error(cn, "ERR syntax error"), -1;
+        if (arg_is(&argv[i], "RETENTION")) {
+            if (string2ll(argv[i + 1].data, argv[i + 1].len, &o->retention) < 0 || o->retention < 0)
+                return *ret = reply_error(cn, "ERR TSDB: invalid RETENTION value"), -1;
+        } else if (arg_is(&argv[i], "CHUNK_SIZE")) {
+            if (string2ll(argv[i + 1].data, argv[i + 1].len, &o->chunk_size) < 0 ||
+                o->chunk_size < OTS_CHUNK_SIZE_MIN || o->chunk_size > OTS_CHUNK_SIZE_MAX)
+                return *ret = reply_error(cn, "ERR TSDB: invalid CHUNK_SIZE value"), -1;
+        } else {
+            return *ret = reply_error(cn, "ERR syntax error"), -1;
+        }
+    }
+    return 0;
+}
+
+/** TS.CREATE key [RETENTION ms] [CHUNK_SIZE bytes] */
+int cmd_ts_create(struct connection_t *cn, struct element *argv, int argc) {
+    struct ts_create_opts o;
+    int ret, err;
+    if (parse_create_opts(cn, argv, 2, argc, &o, &ret) < 0) return ret;
+    if (otype_lookup(argv[1].data, argv[1].len, OSV_T_TS, NULL, &err) || err == -EWRONGTYPE)
+        return reply_error(cn, "ERR TSDB: key already exists");
+    osv *v = otsv_new(o.retention, (uint32_t) o.chunk_size);
+    if (!v) return reply_type_err(cn, -ENOMEM);
+    if ((err = SET4own(argv[1].data, argv[1].len, v)) < 0) {
+        osv_free(v);
+        return reply_write_err(cn, err);
+    }
+    return reply_ok(cn);
+}
+
+/** TS.ADD key timestamp|* value [RETENTION ms] [CHUNK_SIZE bytes] -> 时间戳, 选项只在自动创建时生效 */
+int cmd_ts_add(struct connection_t *cn, struct element *argv, int argc) {
+    struct ts_create_opts o;
+    int64_t ts;
+    double val;
+    int ret, err;
+    if (parse_create_opts(cn, argv, 4, argc, &o, &ret) < 0) return ret;
+    if (argv[2].len == 1 && argv[2].data[0] == '*') ts = (int64_t) oclock_ms();
+    else if (parse_ts(&argv[2], 0, &ts) < 0) return reply_error(cn, "ERR TSDB: invalid timestamp");
+    if (parse_value(&argv[3], &val) < 0) return reply_error(cn, "ERR TSDB: invalid value");
+
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_TS, NULL, &err);
+    if (!slot && err) return reply_type_err(cn, err);
+    if (!slot) {
+        osv *v = otsv_new(o.retention, (uint32_t) o.chunk_size);
+        if (!v) return reply_type_err(cn, -ENOMEM);
+        if ((err = otsv_add(v, ts, val)) < 0 || (err = SET4own(argv[1].data, argv[1].len, v)) < 0) {
+            osv_free(v);
+            return reply_write_err(cn, err);
+        }
+        return reply_int(cn, ts);
+    }
+    err = otsv_add(slot->v, ts, val);
+    if (err == -EEXIST) return reply_error(cn, "ERR TSDB: duplicate sample for the last timestamp");
+    if (err == -ERANGE) return reply_error(cn, "ERR TSDB: timestamp is older than the last sample");
+    if (err < 0) return reply_type_err(cn, err);
+    return reply_int(cn, ts);
+}
+
+/** TS.GET key -> [ts, value], 空序列回复空数组 */
+int cmd_ts_get(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_TS, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_error(cn, "ERR TSDB: the key does not exist");
+    struct ots_sample s;
+    return otsv_last(slot->v, &s) ? reply_sample(cn, &s) : reply_array(cn, 0);
+}
+
+struct ts_range_opts {
+    int64_t from;
+    int64_t to;
+    uint64_t count;
+    int agg;
+    int64_t bucket;
+};
+
+static int parse_agg(const struct element *e) {
+    static const char *names[] = {"avg", "sum", "min", "max", "count"};
+    for (int i = 0; i < 5; i++)
+        if (arg_is(e, names[i])) return OTS_AGG_AVG + i;
+    return -1;
+}
+
+/**
+ * from to [COUNT n] [AGGREGATION avg|sum|min|max|count bucket], 在 stop 处 (如 KEYS) 停下
+ * @return 下一个参数的下标, 或 -1 (已回复错误, *ret)
+ */
+static int parse_range_opts(struct connection_t *cn, struct element *argv, int i, int argc, const char *stop,
+                            struct ts_range_opts *o, int *ret) {
+    int64_t n;
+    if (parse_ts(&argv[i], 1, &o->from) < 0 || parse_ts(&argv[i + 1], 1, &o->to) < 0)
+        return *ret = reply_error(cn, "ERR TSDB: invalid timestamp"), -1;
+    o->count = 0;
+    o->agg = OTS_AGG_NONE;
+    o->bucket = 0;
+    for (i += 2; i < argc && !(stop && arg_is(&argv[i], stop));) {
+        if (arg_is(&argv[i], "COUNT") && i + 1 < argc) {
+            if (string2ll(argv[i + 1].data, argv[i + 1].len, &n) < 0 || n <= 0)
+                return *ret = reply_error(cn, "ERR TSDB: invalid COUNT value"), -1;
+            o->count = (uint64_t) n;
+            i += 2;
+        } else if (arg_is(&argv[i], "AGGREGATION") && i + 2 < argc) {
+            if ((o->agg = parse_agg(&argv[i + 1])) < 0)
+                return *ret = reply_error(cn, "ERR TSDB: unknown aggregation type"), -1;
+            if (string2ll(argv[i + 2].data, argv[i + 2].len, &o->bucket) < 0 || o->bucket <= 0)
+                return *ret = reply_error(cn, "ERR TSDB: invalid bucket duration"), -1;
+            i += 3;
+        } else {
+            return *ret = reply_error(cn, "ERR syntax error"), -1;
+        }
+    }
+    return i;
+}
+
+static int reply_range(struct connection_t *cn, osv *v, const struct ts_range_opts *o) {
+    struct ots_sample *a = NULL;
+    int64_t n = o->from > o->to ? 0 : otsv_range(v, o->from, o->to, o->agg, o->bucket, o->count, &a);
+    if (n < 0) return reply_type_err(cn, (int) n);
+    int ret = reply_samples(cn, a, n);
+    free(a);
+    return ret;
+}
+
+/** TS.RANGE key from to [COUNT n] [AGGREGATION agg bucket] */
+int cmd_ts_range(struct connection_t *cn, struct element *argv, int argc) {
+    struct ts_range_opts o;
+    int ret, err;
+    if (parse_range_opts(cn, argv, 2, argc, NULL, &o, &ret) < 0) return ret;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_TS, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_error(cn, "ERR TSDB: the key does not exist");
+    return reply_range(cn, slot->v, &o);
+}
+
+/**
+ * TS.MRANGE from to [COUNT n] [AGGREGATION agg bucket] KEYS key [key ...]
+ * -> 每个存在的 key 一项 [key, [], samples], 第二项是标签的位置 (没有标签索引, 总是空)
+ */
+int cmd_ts_mrange(struct connection_t *cn, struct element *argv, int argc) {
+    struct ts_range_opts o;
+    int ret, err;
+    int i = parse_range_opts(cn, argv, 1, argc, "KEYS", &o, &ret);
+    if (i < 0) return ret;
+    if (i + 1 >= argc) return reply_error(cn, "ERR syntax error");
+    int nkeys = argc - i - 1;
+    osv **vs = malloc(sizeof(*vs) * nkeys);
+    if (!vs) return reply_type_err(cn, -ENOMEM);
+    int found = 0;
+    for (int j = 0; j < nkeys; j++) {
+        ohash_t *slot = otype_lookup(argv[i + 1 + j].data, argv[i + 1 + j].len, OSV_T_TS, NULL, &err);
+        if (!slot && err) {
+            free(vs);
+            return reply_type_err(cn, err);
+        }
+        vs[j] = slot ? slot->v : NULL;
+        found += slot != NULL;
+    }
+    ret = reply_array(cn, found);
+    for (int j = 0; ret >= 0 && j < nkeys; j++) {
+        if (!vs[j]) continue;
+        ret = reply_array(cn, 3);
+        if (ret >= 0) ret = reply_bulk(cn, argv[i + 1 + j].data, argv[i + 1 + j].len);
+        if (ret >= 0) ret = reply_array(cn, 0);
+        if (ret >= 0) ret = reply_range(cn, vs[j], &o);
+    }
+    free(vs);
+    return ret;
+}
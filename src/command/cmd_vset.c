@@ -0,0 +1,225 @@
+//
+// Created by weishen on 2025/11/17.
+//
+
+#include "cmd_dispatch.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*********************** vector set handlers ******************************/
+
+#define VSIM_COUNT_DEFAULT 10
+/** 没有给 EF 时 HNSW 搜索的候选集大小 (不小于 COUNT) */
+#define VSIM_EF_DEFAULT 100
+
+static const char *err_missing = "ERR key does not exist";
+
+/** 单线程: 解析出来的向量和查询结果共用这两块缓冲区 */
+static float *vbuf;
+static uint32_t vcap;
+static struct ovhit *hits;
+static uint32_t hcap;
+
+static int grow(void **p, uint32_t *cap, uint32_t need, size_t size) {
+    if (need <= *cap) return 0;
+    uint32_t n = *cap ? *cap : 64;
+    while (n < need) n *= 2;
+    void *q = realloc(*p, (size_t) n * size);
+    if (!q) return -ENOMEM;
+    *p = q;
+    *cap = n;
+    return 0;
+}
+
+static int parse_u32(const struct element *e, uint32_t min, uint32_t max, uint32_t *out) {
+    int64_t v;
+    if (string2ll(e->data, e->len, &v) < 0 || v < min || v > max) return -EINVAL;
+    *out = (uint32_t) v;
+    return 0;
+}
+
+/**
+ * FP32 blob | VALUES n v1 .. vn -> vbuf
+ * @return 消耗的参数个数, <0 时已经回复了错误 (*ret)
+ */
+static int parse_vector(struct connection_t *cn, struct element *argv, int argc, uint32_t *dim, int *ret) {
+    uint32_t n;
+    if (argc >= 2 && arg_is(&argv[0], "fp32")) {
+        if (!argv[1].len || argv[1].len % 4 || argv[1].len / 4 > OVSET_DIM_MAX) {
+            *ret = reply_error(cn, "ERR invalid vector specification");
+            return -EINVAL;
+        }
+        n = argv[1].len / 4;
+        if (grow((void **) &vbuf, &vcap, n, sizeof(float)) < 0) goto oom;
+        memcpy(vbuf, argv[1].data, argv[1].len);
+        for (uint32_t i = 0; i < n; i++)
+            if (!isfinite(vbuf[i])) goto invalid;
+        *dim = n;
+        return 2;
+    }
+    if (argc >= 2 && arg_is(&argv[0], "values")) {
+        if (parse_u32(&argv[1], 1, OVSET_DIM_MAX, &n) < 0 || (uint32_t) argc - 2 < n) {
+            *ret = reply_error(cn, "ERR invalid vector specification");
+            return -EINVAL;
+        }
+        if (grow((void **) &vbuf, &vcap, n, sizeof(float)) < 0) goto oom;
+        for (uint32_t i = 0; i < n; i++) {
+            long double d;
+            if (string2ld(argv[2 + i].data, argv[2 + i].len, &d) < 0 || !isfinite((float) d)) goto invalid;
+            vbuf[i] = (float) d;
+        }
+        *dim = n;
+        return (int) n + 2;
+    }
+    *ret = reply_error(cn, "ERR syntax error");
+    return -EINVAL;
+invalid:
+    *ret = reply_error(cn, "ERR invalid vector specification");
+    return -EINVAL;
+oom:
+    *ret = reply_type_err(cn, -ENOMEM);
+    return -ENOMEM;
+}
+
+/** 能还原出同一个 float 的最短表示 */
+static int reply_score(struct connection_t *cn, float f) {
+    char bf[32];
+    int len = 0;
+    for (int p = 6; p <= 9; p++) {
+        len = snprintf(bf, sizeof(bf), "%.*g", p, (double) f);
+        if (strtof(bf, NULL) == f) break;
+    }
+    return reply_bulk(cn, bf, len);
+}
+
+/**
+ * VADD key (FP32 blob | VALUES n v1 .. vn) element [NOQUANT | Q8] [EF ef] [M m] [METRIC COSINE | L2]
+ * 量化, M, EF, METRIC 只在创建时生效; 元素已存在时不更新向量
+ * @return 1 新元素, 0 已存在
+ */
+int cmd_vadd(struct connection_t *cn, struct element *argv, int argc) {
+    int ret = 0, err;
+    uint32_t dim, m = OVSET_M_DEFAULT, ef = OVSET_EF_DEFAULT;
+    int used = parse_vector(cn, &argv[2], argc - 2, &dim, &ret);
+    if (used < 0) return ret;
+    int i = 2 + used;
+    if (i >= argc) return reply_error(cn, "ERR syntax error");
+    struct element *ele = &argv[i++];
+    int quant = -1;
+    enum ovset_metric metric = OVSET_COSINE;
+    for (; i < argc; i++) {
+        if (arg_is(&argv[i], "noquant")) quant = OVSET_F32;
+        else if (arg_is(&argv[i], "q8")) quant = OVSET_Q8;
+        else if (arg_is(&argv[i], "ef") && i + 1 < argc) {
+            if (parse_u32(&argv[++i], 1, OVSET_EF_MAX, &ef) < 0) return reply_error(cn, "ERR invalid EF");
+        } else if (arg_is(&argv[i], "m") && i + 1 < argc) {
+            if (parse_u32(&argv[++i], 2, OVSET_M_MAX, &m) < 0) return reply_error(cn, "ERR invalid M");
+        } else if (arg_is(&argv[i], "metric") && i + 1 < argc) {
+            i++;
+            if (arg_is(&argv[i], "cosine")) metric = OVSET_COSINE;
+            else if (arg_is(&argv[i], "l2")) metric = OVSET_L2;
+            else return reply_error(cn, "ERR invalid METRIC");
+        } else return reply_error(cn, "ERR syntax error");
+    }
+
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_VSET, NULL, &err);
+    if (!slot && err) return reply_type_err(cn, err);
+    if (slot) {
+        struct ovset *s = ovsetv_s((osv *) slot->v);
+        if (dim != s->dim) {
+            char bf[96];
+            snprintf(bf, sizeof(bf), "ERR Vector dimension mismatch - got %u but set has %u", dim, s->dim);
+            return reply_error(cn, bf);
+        }
+        if (quant >= 0 && quant != s->quant)
+            return reply_error(cn, "ERR asked quantization mismatch with existing vector set");
+        int r = ovsetv_add(slot->v, ele->data, ele->len, vbuf);
+        return r < 0 ? reply_type_err(cn, r) : reply_int(cn, r);
+    }
+    // 新 key: 先在独立的值里插好第一个元素, 再挂到全局表, 失败时什么都不留下
+    osv *v = ovsetv_new(dim, metric, quant < 0 ? OVSET_F32 : (enum ovset_quant) quant, m, ef);
+    if (!v) return reply_type_err(cn, -ENOMEM);
+    if ((err = ovsetv_add(v, ele->data, ele->len, vbuf)) < 0) {
+        osv_free(v);
+        return reply_type_err(cn, err);
+    }
+    if ((err = SET4own(argv[1].data, argv[1].len, v)) < 0) {
+        osv_free(v);
+        return reply_write_err(cn, err);
+    }
+    return reply_int(cn, 1);
+}
+
+/**
+ * VSIM key (ELE element | FP32 blob | VALUES n v1 .. vn) [WITHSCORES] [COUNT k] [EF ef] [TRUTH]
+ * 按相似度降序; 分数 COSINE 是 (1 + cos) / 2 (1 最相似), L2 是欧氏距离 (0 最相似)
+ * TRUTH: 不走 HNSW, 精确扫描
+ */
+int cmd_vsim(struct connection_t *cn, struct element *argv, int argc) {
+    int ret = 0, err, withscores = 0, exact = 0, i;
+    uint32_t dim = 0, count = VSIM_COUNT_DEFAULT, ef = 0;
+    struct element *ele = NULL;
+    if (arg_is(&argv[2], "ele")) {
+        ele = &argv[3];
+        i = 4;
+    } else {
+        int used = parse_vector(cn, &argv[2], argc - 2, &dim, &ret);
+        if (used < 0) return ret;
+        i = 2 + used;
+    }
+    for (; i < argc; i++) {
+        if (arg_is(&argv[i], "withscores")) withscores = 1;
+        else if (arg_is(&argv[i], "truth")) exact = 1;
+        else if (arg_is(&argv[i], "count") && i + 1 < argc) {
+            if (parse_u32(&argv[++i], 1, OVSET_EF_MAX, &count) < 0) return reply_error(cn, "ERR invalid COUNT");
+        } else if (arg_is(&argv[i], "ef") && i + 1 < argc) {
+            if (parse_u32(&argv[++i], 1, OVSET_EF_MAX, &ef) < 0) return reply_error(cn, "ERR invalid EF");
+        } else return reply_error(cn, "ERR syntax error");
+    }
+
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_VSET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_array(cn, 0);
+    osv *v = slot->v;
+    struct ovset *s = ovsetv_s(v);
+    int64_t id = -1;
+    if (ele && (id = ovsetv_find(v, ele->data, ele->len)) < 0) return reply_error(cn, "ERR element not found in set");
+    if (!ele && dim != s->dim) {
+        char bf[96];
+        snprintf(bf, sizeof(bf), "ERR Vector dimension mismatch - got %u but set has %u", dim, s->dim);
+        return reply_error(cn, bf);
+    }
+    if (count > s->count) count = (uint32_t) s->count;
+    if (grow((void **) &hits, &hcap, count, sizeof(struct ovhit)) < 0) return reply_type_err(cn, -ENOMEM);
+    uint32_t n = ovsetv_search(v, ele ? NULL : vbuf, (uint32_t) (id < 0 ? 0 : id), count, ef ? ef : VSIM_EF_DEFAULT, exact, hits);
+
+    ret = reply_array(cn, (long long) n * (withscores ? 2 : 1));
+    for (uint32_t j = 0; ret >= 0 && j < n; j++) {
+        struct ovname *name = &s->names[hits[j].id];
+        ret = reply_bulk(cn, name->p, name->len);
+        if (ret >= 0 && withscores) {
+            float d = hits[j].dist;
+            ret = reply_score(cn, s->metric == OVSET_COSINE ? 1 - d / 2 : sqrtf(d));
+        }
+    }
+    return ret;
+}
+
+/** VCARD key -> 元素个数, 不存在时 0 */
+int cmd_vcard(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_VSET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+    return reply_int(cn, (long long) ovsetv_s((osv *) slot->v)->count);
+}
+
+/** VDIM key -> 向量维数 */
+int cmd_vdim(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_VSET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_error(cn, err_missing);
+    return reply_int(cn, ovsetv_s((osv *) slot->v)->dim);
+}
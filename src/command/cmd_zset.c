@@ -0,0 +1,248 @@
+//
+// Created by weishen on 2025/11/11.
+//
+
+#include "cmd_dispatch.h"
+
+#include <math.h>
+#include <stdio.h>
+
+/*********************** sorted set handlers ******************************/
+
+#define ZSET_SCORE_MAX 32
+
+/** score 的十进制形式: 能 round-trip 的最短 %g, 与 Redis 一样用 inf / -inf */
+static int d2str(char *bf, double d) {
+    if (isinf(d)) return d > 0 ? (memcpy(bf, "inf", 3), 3) : (memcpy(bf, "-inf", 4), 4);
+    int len = snprintf(bf, ZSET_SCORE_MAX, "%.15g", d);
+    if (strtod(bf, NULL) != d) len = snprintf(bf, ZSET_SCORE_MAX, "%.17g", d);
+    return len;
+}
+
+static int reply_score(struct connection_t *cn, double d) {
+    char bf[ZSET_SCORE_MAX];
+    return reply_bulk(cn, bf, d2str(bf, d));
+}
+
+static int parse_score(const struct element *e, double *out) {
+    long double v;
+    if (string2ld(e->data, e->len, &v) < 0) return -EINVAL;
+    *out = (double) v;
+    return 0;
+}
+
+/** ZRANGEBYSCORE 的区间端点: "(1.5" 表示开区间 */
+static int parse_bound(const struct element *e, double *out, int *exclusive) {
+    struct element t = *e;
+    *exclusive = t.len && t.data[0] == '(';
+    if (*exclusive) {
+        t.data++;
+        t.len--;
+    }
+    return parse_score(&t, out);
+}
+
+#define ZADD_NX 0x1
+#define ZADD_XX 0x2
+#define ZADD_GT 0x4
+#define ZADD_LT 0x8
+#define ZADD_CH 0x10
+#define ZADD_INCR 0x20
+
+/**
+ * ZADD key [NX|XX] [GT|LT] [CH] [INCR] score member [score member ...]
+ * -> 新增的成员数 (CH: 新增 + score 改变的), INCR: 新的 score 或 nil
+ * 先解析完所有 score 再写, 参数错误时集合不变
+ */
+int cmd_zadd(struct connection_t *cn, struct element *argv, int argc) {
+    int flags = 0, i = 2;
+    for (; i < argc; i++) {
+        if (arg_is(&argv[i], "nx")) flags |= ZADD_NX;
+        else if (arg_is(&argv[i], "xx")) flags |= ZADD_XX;
+        else if (arg_is(&argv[i], "gt")) flags |= ZADD_GT;
+        else if (arg_is(&argv[i], "lt")) flags |= ZADD_LT;
+        else if (arg_is(&argv[i], "ch")) flags |= ZADD_CH;
+        else if (arg_is(&argv[i], "incr")) flags |= ZADD_INCR;
+        else break;
+    }
+    if (i == argc || (argc - i) & 1) return reply_error(cn, "ERR syntax error");
+    if ((flags & ZADD_NX) && (flags & ZADD_XX))
+        return reply_error(cn, "ERR XX and NX options at the same time are not compatible");
+    if (((flags & ZADD_GT) && (flags & ZADD_LT)) || ((flags & ZADD_NX) && (flags & (ZADD_GT | ZADD_LT))))
+        return reply_error(cn, "ERR GT, LT, and/or NX options at the same time are not compatible");
+    if ((flags & ZADD_INCR) && argc - i != 2)
+        return reply_error(cn, "ERR INCR option supports a single increment-element pair");
+    double score = 0;
+    for (int j = i; j < argc; j += 2)
+        if (parse_score(&argv[j], &score) < 0) return reply_error(cn, "ERR value is not a valid float");
+
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_ZSET, (flags & ZADD_XX) ? NULL : ozv_new, &err);
+    if (!slot) {
+        if (err) return reply_type_err(cn, err);
+        return (flags & ZADD_INCR) ? reply_nil(cn) : reply_int(cn, 0); // XX 且 key 不存在
+    }
+    long long changed = 0;
+    for (int j = i; j < argc; j += 2) {
+        parse_score(&argv[j], &score);
+        double cur = 0;
+        int exists = ozv_score(slot->v, argv[j + 1].data, argv[j + 1].len, &cur);
+        if ((exists && (flags & ZADD_NX)) || (!exists && (flags & ZADD_XX))) {
+            if (flags & ZADD_INCR) return reply_nil(cn);
+            continue;
+        }
+        if (flags & ZADD_INCR) {
+            if (exists) score += cur;
+            if (isnan(score)) return reply_error(cn, "ERR resulting score is not a number (NaN)");
+        }
+        if (exists && (((flags & ZADD_GT) && score <= cur) || ((flags & ZADD_LT) && score >= cur))) {
+            if (flags & ZADD_INCR) return reply_nil(cn);
+            continue;
+        }
+        osv *v = slot->v;
+        int ret = ozv_add(&v, argv[j + 1].data, argv[j + 1].len, score);
+        slot->v = v;
+        if (ret < 0) {
+            if (!ozv_len(v)) otype_remove(slot);
+            return reply_type_err(cn, ret);
+        }
+        changed += ret || ((flags & ZADD_CH) && cur != score);
+    }
+    if (flags & ZADD_INCR) return reply_score(cn, score);
+    return reply_int(cn, changed);
+}
+
+int cmd_zscore(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_ZSET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_nil(cn);
+    double score;
+    if (!ozv_score(slot->v, argv[2].data, argv[2].len, &score)) return reply_nil(cn);
+    return reply_score(cn, score);
+}
+
+int cmd_zcard(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_ZSET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+    return reply_int(cn, (long long) ozv_len(slot->v));
+}
+
+/** 删空的集合连同 key 一起删除 */
+int cmd_zrem(struct connection_t *cn, struct element *argv, int argc) {
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_ZSET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_int(cn, 0);
+    long long deleted = 0;
+    for (int i = 2; i < argc; i++) deleted += ozv_del(slot->v, argv[i].data, argv[i].len);
+    if (!ozv_len(slot->v)) otype_remove(slot);
+    return reply_int(cn, deleted);
+}
+
+int cmd_zrank(struct connection_t *cn, struct element *argv, int argc) {
+    (void) argc;
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_ZSET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_nil(cn);
+    uint64_t rank;
+    if (!ozv_rank(slot->v, argv[2].data, argv[2].len, &rank)) return reply_nil(cn);
+    return reply_int(cn, (long long) rank);
+}
+
+/** 从 it 开始回复 n 个成员 (withscores 时每个成员后跟 score) */
+static int reply_members(struct connection_t *cn, struct ozv_iter *it, uint64_t n, int withscores) {
+    int ret = reply_array(cn, (long long) (withscores ? n * 2 : n));
+    const char *m;
+    uint32_t mlen;
+    double score;
+    while (n-- && ret >= 0 && ozv_next(it, &m, &mlen, &score)) {
+        if ((ret = reply_bulk(cn, m, mlen)) >= 0 && withscores) ret = reply_score(cn, score);
+    }
+    return ret;
+}
+
+/** ZRANGE key start stop [WITHSCORES], 下标规则同 LRANGE */
+int cmd_zrange(struct connection_t *cn, struct element *argv, int argc) {
+    int withscores = 0;
+    for (int i = 4; i < argc; i++) {
+        if (arg_is(&argv[i], "withscores")) withscores = 1;
+        else return reply_error(cn, "ERR syntax error");
+    }
+    int64_t s, e;
+    if (string2ll(argv[2].data, argv[2].len, &s) < 0 || string2ll(argv[3].data, argv[3].len, &e) < 0)
+        return reply_error(cn, "ERR value is not an integer or out of range");
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_ZSET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_array(cn, 0);
+    int64_t len = (int64_t) ozv_len(slot->v);
+    if (s < 0) s += len;
+    if (e < 0) e += len;
+    if (s < 0) s = 0;
+    if (e >= len) e = len - 1;
+    if (s > e || s >= len) return reply_array(cn, 0);
+    struct ozv_iter it;
+    ozv_iter_rank(&it, slot->v, (uint64_t) s);
+    return reply_members(cn, &it, (uint64_t) (e - s + 1), withscores);
+}
+
+/**
+ * ZRANGEBYSCORE key min max [WITHSCORES] [LIMIT offset count]
+ * 两端各 seek 一次得到名次区间, 回复头里的元素个数不需要先扫一遍
+ */
+int cmd_zrangebyscore(struct connection_t *cn, struct element *argv, int argc) {
+    int withscores = 0;
+    int64_t offset = 0, count = -1;
+    for (int i = 4; i < argc; i++) {
+        if (arg_is(&argv[i], "withscores")) withscores = 1;
+        else if (arg_is(&argv[i], "limit") && i + 2 < argc) {
+            if (string2ll(argv[i + 1].data, argv[i + 1].len, &offset) < 0 ||
+                string2ll(argv[i + 2].data, argv[i + 2].len, &count) < 0)
+                return reply_error(cn, "ERR value is not an integer or out of range");
+            i += 2;
+        } else return reply_error(cn, "ERR syntax error");
+    }
+    double min, max;
+    int minex, maxex;
+    if (parse_bound(&argv[2], &min, &minex) < 0 || parse_bound(&argv[3], &max, &maxex) < 0)
+        return reply_error(cn, "ERR min or max is not a float");
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_ZSET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_array(cn, 0);
+    struct ozv_iter it;
+    // end: 第一个排在 max 之后的元素
+    uint64_t end = ozv_iter_score(&it, slot->v, max, !maxex);
+    uint64_t start = ozv_iter_score(&it, slot->v, min, minex);
+    if (offset < 0 || start >= end || (uint64_t) offset >= end - start) return reply_array(cn, 0);
+    uint64_t n = end - start - (uint64_t) offset;
+    if (count >= 0 && (uint64_t) count < n) n = (uint64_t) count;
+    if (offset) ozv_iter_rank(&it, slot->v, start + (uint64_t) offset);
+    return reply_members(cn, &it, n, withscores);
+}
+
+/** ZPOPMIN key [count] -> [member, score, ...], 成员先写进回复再删除 */
+int cmd_zpopmin(struct connection_t *cn, struct element *argv, int argc) {
+    if (argc > 3) return reply_error(cn, "ERR syntax error");
+    int64_t count = 1;
+    if (argc == 3 && (string2ll(argv[2].data, argv[2].len, &count) < 0 || count < 0))
+        return reply_error(cn, "ERR value is out of range, must be positive");
+    int err;
+    ohash_t *slot = otype_lookup(argv[1].data, argv[1].len, OSV_T_ZSET, NULL, &err);
+    if (!slot) return err ? reply_type_err(cn, err) : reply_array(cn, 0);
+    osv *v = slot->v;
+    if ((uint64_t) count > ozv_len(v)) count = (int64_t) ozv_len(v);
+    int ret = reply_array(cn, count * 2);
+    struct ozv_iter it;
+    const char *m;
+    uint32_t mlen;
+    double score;
+    for (int64_t i = 0; i < count && ret >= 0; i++) {
+        ozv_iter_rank(&it, v, 0);
+        ozv_next(&it, &m, &mlen, &score);
+        if ((ret = reply_bulk(cn, m, mlen)) >= 0) ret = reply_score(cn, score);
+        ozv_del(v, m, mlen);
+    }
+    if (!ozv_len(v)) otype_remove(slot);
+    return ret;
+}
@@ -1,12 +1,52 @@
-#include <stdio.h>
-#include "../include/resp2parser.h"
-#include "../include/noblock_sserver.h"
-#include "../include/xxhash.h"
-#include "../test/test_protocol_framework.h"
-#define XXH_INLINE_ALL
-#include "resp2parser.h"
-#include "cmd_.h"
+#include "cmd_dispatch.h"
 #include "ohashtable.h"
 
-int main() {
+#define SSW_PORT_DEFAULT 6380
+#define SSW_BACKLOG 511
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-p port] [-t tier_file]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    int port = SSW_PORT_DEFAULT;
+    const char *tier_file = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-p") && i + 1 < argc) port = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) tier_file = argv[++i];
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    openlog("ssw", LOG_PID | LOG_PERROR, LOG_USER);
+
+    int ret = cmd_table_check();
+    if (ret) {
+        syslog(LOG_ERR, "command table has a slot collision at entry %d, re-pick CMD_HASH_MUL", ret - 1);
+        return 1;
+    }
+    if ((ret = initohash(1024)) < 0) {
+        syslog(LOG_ERR, "initohash() failed : %s", strerror(-ret));
+        return 1;
+    }
+    if (tier_file && (ret = otier_open(tier_file)) < 0) {
+        syslog(LOG_ERR, "otier_open() failed : %s", strerror(-ret));
+        return 1;
+    }
+    struct connection_pool *pool = create_pool(1024);
+    if (!pool) return 1;
+    int sfd = createsfd(port, SSW_BACKLOG);
+    if (sfd < 0) return 1;
+    syslog(LOG_INFO, "ssw listening on %d", port);
+
+    struct runenvironment rt = {
+        .sfd = sfd,
+        .pool = pool,
+        .on_read = cmd_on_read,
+        .on_writer = cmd_on_writer,
+        .on_error = NULL,
+        .stats = NULL,
+    };
+    return epollrun(rt);
 }
@@ -3,6 +3,11 @@
 //
 
 #include "resp2parser.h"
+#include "ocpu.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 int bindctx(struct connection_t *connection) {
 #ifndef NDEBUG
@@ -12,3 +17,108 @@ int bindctx(struct connection_t *connection) {
     if (!connection->use_data) ret = create_ctx(connection);
     return ret;
 }
+
+/*********************** CRLF / prefix 扫描 ******************************/
+
+static long long crlf_scalar(const char *p, long long n, long long i) {
+    for (; i + 1 < n; i++)
+        if (p[i] == '\r' && p[i + 1] == '\n') return i;
+    return -1;
+}
+
+static long long prefix_scalar(const char *p, long long n, long long i) {
+    for (; i < n; i++)
+        if (is_prefix[(unsigned char) p[i]]) return i;
+    return -1;
+}
+
+#if defined(__x86_64__)
+/**
+ * 一组 W 字节: \r 的掩码 & (\n 的掩码 >> 1), 最高位的 \r 要看下一组的第一个字节,
+ * 所以循环条件是 i + W < n, 保证 p[i + W] 可读
+ */
+static long long crlf_sse2(const char *p, long long n, long long *pi) {
+    const __m128i cr = _mm_set1_epi8('\r'), lf = _mm_set1_epi8('\n');
+    long long i = *pi;
+    for (; i + 16 < n; i += 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i *) (p + i));
+        unsigned r = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, cr));
+        if (!r) continue;
+        unsigned nl = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, lf)) | (unsigned) (p[i + 16] == '\n') << 16;
+        unsigned m = r & (nl >> 1);
+        if (m) return i + __builtin_ctz(m);
+    }
+    *pi = i;
+    return -1;
+}
+
+__attribute__((target("avx2")))
+static long long crlf_avx2(const char *p, long long n, long long *pi) {
+    const __m256i cr = _mm256_set1_epi8('\r'), lf = _mm256_set1_epi8('\n');
+    long long i = *pi;
+    for (; i + 32 < n; i += 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i *) (p + i));
+        uint32_t r = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, cr));
+        if (!r) continue;
+        uint32_t nl = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, lf));
+        uint32_t m = r & ((nl >> 1) | (uint32_t) (p[i + 32] == '\n') << 31);
+        if (m) return i + __builtin_ctz(m);
+    }
+    *pi = i;
+    return -1;
+}
+
+/** 五个 prefix 各比较一次, 掩码相或 */
+static long long prefix_sse2(const char *p, long long n, long long *pi) {
+    long long i = *pi;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i *) (p + i));
+        __m128i e = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('$')), _mm_cmpeq_epi8(v, _mm_set1_epi8('*')));
+        e = _mm_or_si128(e, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('+')), _mm_cmpeq_epi8(v, _mm_set1_epi8('-'))));
+        e = _mm_or_si128(e, _mm_cmpeq_epi8(v, _mm_set1_epi8(':')));
+        unsigned m = (unsigned) _mm_movemask_epi8(e);
+        if (m) return i + __builtin_ctz(m);
+    }
+    *pi = i;
+    return -1;
+}
+
+__attribute__((target("avx2")))
+static long long prefix_avx2(const char *p, long long n, long long *pi) {
+    long long i = *pi;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i *) (p + i));
+        __m256i e = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('$')),
+                                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('*')));
+        e = _mm256_or_si256(e, _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('+')),
+                                               _mm256_cmpeq_epi8(v, _mm256_set1_epi8('-'))));
+        e = _mm256_or_si256(e, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')));
+        uint32_t m = (uint32_t) _mm256_movemask_epi8(e);
+        if (m) return i + __builtin_ctz(m);
+    }
+    *pi = i;
+    return -1;
+}
+
+#endif
+
+/** AVX2 先走 32 字节一组, 剩下不足一组的用 SSE2, 最后标量收尾 */
+long long resp_scan_crlf(const char *p, long long n) {
+    long long i = 0;
+#if defined(__x86_64__)
+    long long r;
+    if (cpu_has_avx2() && (r = crlf_avx2(p, n, &i)) >= 0) return r;
+    if ((r = crlf_sse2(p, n, &i)) >= 0) return r;
+#endif
+    return crlf_scalar(p, n, i);
+}
+
+long long resp_scan_prefix(const char *p, long long n) {
+    long long i = 0;
+#if defined(__x86_64__)
+    long long r;
+    if (cpu_has_avx2() && (r = prefix_avx2(p, n, &i)) >= 0) return r;
+    if ((r = prefix_sse2(p, n, &i)) >= 0) return r;
+#endif
+    return prefix_scalar(p, n, i);
+}
@@ -0,0 +1,27 @@
+//
+// Created by weishen on 2025/11/8.
+//
+
+#include "resp2reply.h"
+
+int reply_grow(struct connection_t *cn, long long need) {
+    long long pending = cn->wb_limit - cn->wb_offset;
+    // 先回收已发送的部分
+    if (cn->wb_offset) {
+        memmove(cn->write_buffer, cn->write_buffer + cn->wb_offset, pending);
+        cn->wb_offset = 0;
+        cn->wb_limit = pending;
+        if (cn->wb_cap - cn->wb_limit >= need) return 0;
+    }
+    long long n_cap = cn->wb_cap ? cn->wb_cap : BUFFER_SIZE_DEFAULT;
+    while (n_cap - pending < need) n_cap <<= 1;
+    if (n_cap > BUFFER_SIZE_MAX) {
+        syslog(LOG_WARNING, "[%d]:reply error : write buffer over max size", cn->fd);
+        return -EMSGSIZE;
+    }
+    char *nwb = realloc(cn->write_buffer, n_cap);
+    if (!nwb) return -ENOMEM;
+    cn->write_buffer = nwb;
+    cn->wb_cap = n_cap;
+    return 0;
+}
@@ -181,10 +181,31 @@ int setnonblocking(int fd) {
     return 0;
 }
 
+#define CN_EVENTS (EPOLLIN | EPOLLET | EPOLLRDHUP)
+
+/**
+ * 把 cn 在 epoll 中的事件改成 events, 和当前注册的一样时什么都不做
+ * pipeline 下每一批回复通常一次 send 就发完, EPOLLOUT 从来不需要打开, 也就不该有 epoll_ctl
+ */
+static int rearm(int efd, struct connection_t *cn, unsigned events, struct sserver_stats *st) {
+    if (cn->events == events) return 0;
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.fd = cn->fd;
+    if (st) st->ctls++;
+    if (epoll_ctl(efd, EPOLL_CTL_MOD, cn->fd, &ev) < 0) {
+        syslog(LOG_WARNING, "epoll_ctl() failed : %s", strerror(errno));
+        return -1;
+    }
+    cn->events = events;
+    return 0;
+}
+
 /**
  *  writere 只发送 writerBuffer中的数据(如果存在)
+ *  发不完时打开 EPOLLOUT, 发完时关掉它 (只在状态真正变化时)
  */
-int writere(int efd, const int current_fd, struct connection_t *cn) {
+int writere(int efd, const int current_fd, struct connection_t *cn, struct sserver_stats *st) {
     /**
      * wb_size -> 当前 wb 的大小
      * 它支持扩容刷新 也是被共享的(thead unsafe)
@@ -204,19 +225,13 @@ int writere(int efd, const int current_fd, struct connection_t *cn) {
         while (1) {
             // cn->write_buffer + cn->wb_offset:  当次发送的位置
             // cn->wb_limit - cn->wb_offset: 剩余量
+            if (st) st->sends++;
             ssize_t current_quantity_sent = send(current_fd, cn->write_buffer + cn->wb_offset,
                                                  cn->wb_limit - cn->wb_offset,MSG_NOSIGNAL);
             if (current_quantity_sent < 0) {
                 if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                    // 内核写缓冲区已满 重新注册上写事件 等待下回
-                    struct epoll_event ev;
-                    ev.events = EPOLLIN | EPOLLET | EPOLLRDHUP | EPOLLOUT;
-                    ev.data.fd = current_fd;
-                    if (epoll_ctl(efd, EPOLL_CTL_MOD, current_fd, &ev) < 0) {
-                        syslog(LOG_WARNING, "epoll_ctl() failed : %s", strerror(errno));
-                        return -1;
-                    }
-                    break;
+                    // 内核写缓冲区已满 注册上写事件 等待下回
+                    return rearm(efd, cn, CN_EVENTS | EPOLLOUT, st);
                 }
                 if (errno == EINTR) {
                     syslog(LOG_WARNING, "send failed of eintr retry: %d", current_fd);
@@ -239,23 +254,17 @@ int writere(int efd, const int current_fd, struct connection_t *cn) {
                 //已经发送完所有buffer中的内容
                 cn->wb_limit = 0;
                 cn->wb_offset = 0;
-                struct epoll_event ev;
-                ev.events = EPOLLIN | EPOLLET | EPOLLRDHUP;
-                ev.data.fd = current_fd;
-                if (epoll_ctl(efd, EPOLL_CTL_MOD, current_fd, &ev) < 0) {
-                    syslog(LOG_WARNING, "epoll_ctl() failed : %s", strerror(errno));
-                    return -1;
-                }
                 break;
             }
         }
     }
-    return 0;
+    return rearm(efd, cn, CN_EVENTS, st);
 }
 
 int epollrun(struct runenvironment rt) {
     int sfd = rt.sfd;
     struct connection_pool *pool = rt.pool;
+    struct sserver_stats *st = rt.stats;
 
     if (sfd < 0 || !pool) return -EINVAL;
     int ret = setnonblocking(sfd);
@@ -272,6 +281,7 @@ int epollrun(struct runenvironment rt) {
     struct epoll_event events[1024];
     for (;;) {
         int nfds = epoll_wait(efd, events, 1024, -1);
+        if (st && nfds > 0) st->wakeups++;
 
         for (int i = 0; i < nfds; i++) {
             const struct epoll_event ready_e = events[i];
@@ -287,12 +297,15 @@ int epollrun(struct runenvironment rt) {
                             continue;
                         }
                         setnonblocking(cfd);
-                        ev.events = EPOLLIN | EPOLLET;
+                        ev.events = CN_EVENTS;
                         ev.data.fd = cfd;
                         if (epoll_ctl(efd, EPOLL_CTL_ADD, cfd, &ev) < 0) {
                             syslog(LOG_WARNING, "epoll_ctl() failed : %s", strerror(errno));
+                            destroy_connection(take_connection(pool, cfd));
                             close(cfd);
+                            continue;
                         }
+                        get_connection(pool, cfd)->events = CN_EVENTS;
                         continue;
                     }
 
@@ -331,39 +344,52 @@ int epollrun(struct runenvironment rt) {
                             free(cn->read_buffer);
                             cn->read_buffer = nrb; // update
                         }
-                        ssize_t n = read(current_fd, cn->read_buffer + cn->rb_size, cn->rb_cap - cn->rb_size);
+                        const size_t want = cn->rb_cap - cn->rb_size;
+                        if (st) st->reads++;
+                        ssize_t n = read(current_fd, cn->read_buffer + cn->rb_size, want);
 
                         if (n > 0) {
                             // update count
                             cn->rb_size += n;
+                            // 没读满说明内核缓冲区已经空了, 不必再 read 一次等 EAGAIN:
+                            // 之后到达的数据在 ET 下会产生新的边沿
+                            if ((size_t) n < want) goto drained;
                         } else if (n == 0) {
                             // client disconnect
                             syslog(LOG_INFO, "client disconnect fd :%d", current_fd);
                             goto completedfd;
                         } else {
                             // n < 0
-                            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                                // 网络是存在拆粘包的问题 所以eagain 的触发点是 内核多缓冲区是否被消费完
-                                // 但处理拆粘包的问题并不是epoll的职责 而是on_read()的职责
-                                int retofread = rt.on_read(cn); // call on_read_callback
-                                //cn 存在 use_data 和 flag 它们影响接下来的 on_writer
-                                cn->flag = retofread;
-                                if (rt.on_writer) {
-                                    rt.on_writer(cn);
-                                    if (writere(efd, current_fd, cn) < 0) goto completedfd;
-                                }
-                                break;
-                            }
+                            if (errno == EAGAIN || errno == EWOULDBLOCK) goto drained;
                             if (errno == EINTR) continue;
                             syslog(LOG_ERR, "read() failed destroy_connection and close fd: %s", strerror(errno));
                             goto completedfd;
                         }
+                        continue;
+                    drained:
+                        // 网络是存在拆粘包的问题 所以 drained 的触发点是 内核多缓冲区是否被消费完
+                        // 但处理拆粘包的问题并不是epoll的职责 而是on_read()的职责
+                        // on_read 一次执行完这一批里的所有完整命令, 回复都追加在 write_buffer 里, 下面一次 send 发出
+                        cn->flag = rt.on_read(cn); // call on_read_callback
+                        //cn 存在 use_data 和 flag 它们影响接下来的 on_writer
+                        if (rt.on_writer) {
+                            rt.on_writer(cn);
+                            // EPOLLOUT 已经打开说明内核写缓冲区还是满的, 等写事件 (可能就在这一次的 ready_e 里) 再发;
+                            // 即将关闭的连接没有下一次了, 直接尽力发出
+                            if ((!(cn->events & EPOLLOUT) || cn->flag < 0) && writere(efd, current_fd, cn, st) < 0) goto completedfd;
+                        }
+                        // on_read 失败 (协议错误, 回复缓冲区无法扩容): 已有的回复上面已经发出, 关闭连接
+                        if (cn->flag < 0) {
+                            syslog(LOG_INFO, "on_read failed (%d), close fd: %d", cn->flag, current_fd);
+                            goto completedfd;
+                        }
+                        break;
                     }
                 }
                 // writer ready
                 if (ready_e.events & EPOLLOUT && rt.on_writer) {
                     //当写事件被触发 则证明cn写缓冲区是存在数据的
-                    if (writere(efd, current_fd, cn) < 0) goto completedfd;
+                    if (writere(efd, current_fd, cn, st) < 0) goto completedfd;
                 }
                 if (ready_e.events & EPOLLRDHUP) goto completedfd;
                 if (ready_e.events & EPOLLERR) {
@@ -375,7 +401,9 @@ int epollrun(struct runenvironment rt) {
                 destroy_connection(take_connection(pool, current_fd));
                 epoll_ctl(efd, EPOLL_CTL_DEL, current_fd, NULL);
                 close(current_fd);
-                break;
+                // continue, not break: the rest of this batch (e.g. the listen fd, which is
+                // edge triggered and will not be reported again) must still be handled
+                continue;
             }
         }
     }
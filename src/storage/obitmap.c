@@ -0,0 +1,197 @@
+//
+// Created by weishen on 2025/11/13.
+//
+
+#include "obitmap.h"
+#include "ocpu.h"
+
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+static inline uint64_t load64(const uint8_t *p) {
+    uint64_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+static inline void store64(uint8_t *p, uint64_t w) {
+    memcpy(p, &w, sizeof(w));
+}
+
+/*********************** 标量版本 ******************************/
+
+static inline uint64_t popcount_swar(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (x * 0x0101010101010101ULL) >> 56;
+}
+
+static uint64_t count_scalar(const uint8_t *p, uint64_t n) {
+    uint64_t c = 0, i = 0;
+    for (; i + 8 <= n; i += 8) c += popcount_swar(load64(p + i));
+    for (; i < n; i++) c += popcount_swar(p[i]);
+    return c;
+}
+
+/** dst[0, n) = dst op src, 按 8 字节一组 */
+#define OBIT_APPLY(dst, src, n, i, expr8, expr1)                                     \
+    do {                                                                             \
+        for (; (i) + 8 <= (n); (i) += 8) {                                           \
+            uint64_t a = load64((dst) + (i)), b = load64((src) + (i));               \
+            store64((dst) + (i), expr8);                                             \
+        }                                                                            \
+        for (; (i) < (n); (i)++) {                                                   \
+            uint8_t a = (dst)[i], b = (src)[i];                                      \
+            (dst)[i] = (uint8_t) (expr1);                                            \
+        }                                                                            \
+    } while (0)
+
+static void apply_scalar(enum obit_op op, uint8_t *dst, const uint8_t *src, uint64_t n, uint64_t i) {
+    switch (op) {
+        case OBIT_AND: OBIT_APPLY(dst, src, n, i, a & b, a & b); break;
+        case OBIT_OR: OBIT_APPLY(dst, src, n, i, a | b, a | b); break;
+        case OBIT_XOR: OBIT_APPLY(dst, src, n, i, a ^ b, a ^ b); break;
+        case OBIT_NOT:
+            for (; i + 8 <= n; i += 8) store64(dst + i, ~load64(src + i));
+            for (; i < n; i++) dst[i] = (uint8_t) ~src[i];
+            break;
+    }
+}
+
+static uint64_t skip_scalar(const uint8_t *p, uint64_t n, uint8_t skip, uint64_t i) {
+    uint64_t w = skip * 0x0101010101010101ULL;
+    while (i + 8 <= n && load64(p + i) == w) i += 8;
+    while (i < n && p[i] == skip) i++;
+    return i;
+}
+
+/*********************** SIMD 版本 ******************************/
+
+#if defined(__x86_64__)
+/**
+ * BITCOUNT: Mula 的 nibble 查表, 每个字节的计数用 vpshufb 查 16 项的表得到
+ * 8 个向量的字节计数先在 8 位上累加 (最多 64, 不会溢出), 再用 vpsadbw 归约到 64 位
+ */
+__attribute__((target("avx2")))
+static uint64_t count_avx2(const uint8_t *p, uint64_t n) {
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i acc = _mm256_setzero_si256();
+    uint64_t i = 0;
+    for (; i + 256 <= n; i += 256) {
+        __m256i local = _mm256_setzero_si256();
+        for (int u = 0; u < 8; u++) {
+            __m256i v = _mm256_loadu_si256((const __m256i *) (p + i + 32 * u));
+            __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low));
+            __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+            local = _mm256_add_epi8(local, _mm256_add_epi8(lo, hi));
+        }
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(local, _mm256_setzero_si256()));
+    }
+    uint64_t c = (uint64_t) _mm256_extract_epi64(acc, 0) + (uint64_t) _mm256_extract_epi64(acc, 1) +
+                 (uint64_t) _mm256_extract_epi64(acc, 2) + (uint64_t) _mm256_extract_epi64(acc, 3);
+    return c + count_scalar(p + i, n - i);
+}
+
+/** 没有 AVX2 时的硬件 popcnt, 四路累加打断依赖链 */
+__attribute__((target("popcnt")))
+static uint64_t count_popcnt(const uint8_t *p, uint64_t n) {
+    uint64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0, i = 0;
+    for (; i + 32 <= n; i += 32) {
+        c0 += (uint64_t) __builtin_popcountll(load64(p + i));
+        c1 += (uint64_t) __builtin_popcountll(load64(p + i + 8));
+        c2 += (uint64_t) __builtin_popcountll(load64(p + i + 16));
+        c3 += (uint64_t) __builtin_popcountll(load64(p + i + 24));
+    }
+    for (; i < n; i++) c0 += (uint64_t) __builtin_popcountll(p[i]);
+    return c0 + c1 + c2 + c3;
+}
+
+#define OBIT_APPLY_AVX2(dst, src, n, i, vexpr)                                       \
+    for (; (i) + 32 <= (n); (i) += 32) {                                             \
+        __m256i a = _mm256_loadu_si256((const __m256i *) ((dst) + (i)));             \
+        __m256i b = _mm256_loadu_si256((const __m256i *) ((src) + (i)));             \
+        _mm256_storeu_si256((__m256i *) ((dst) + (i)), vexpr);                       \
+    }
+
+/** 32 字节一组, 剩下的交给标量 @return 已处理的字节数 */
+__attribute__((target("avx2")))
+static uint64_t apply_avx2(enum obit_op op, uint8_t *dst, const uint8_t *src, uint64_t n) {
+    uint64_t i = 0;
+    switch (op) {
+        case OBIT_AND: OBIT_APPLY_AVX2(dst, src, n, i, _mm256_and_si256(a, b)) break;
+        case OBIT_OR: OBIT_APPLY_AVX2(dst, src, n, i, _mm256_or_si256(a, b)) break;
+        case OBIT_XOR: OBIT_APPLY_AVX2(dst, src, n, i, _mm256_xor_si256(a, b)) break;
+        case OBIT_NOT:
+            for (; i + 32 <= n; i += 32) {
+                __m256i b = _mm256_loadu_si256((const __m256i *) (src + i));
+                _mm256_storeu_si256((__m256i *) (dst + i), _mm256_xor_si256(b, _mm256_set1_epi8(-1)));
+            }
+            break;
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static uint64_t skip_avx2(const uint8_t *p, uint64_t n, uint8_t skip) {
+    const __m256i s = _mm256_set1_epi8((char) skip);
+    uint64_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        uint32_t eq = (uint32_t) _mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (p + i)), s));
+        if (eq != 0xffffffffU) return i + (uint64_t) __builtin_ctz(~eq);
+    }
+    return i;
+}
+
+#endif
+
+/*********************** API ******************************/
+
+uint64_t
+obit_count(const void *p, uint64_t n) {
+#if defined(__x86_64__)
+    if (cpu_has_avx2()) return count_avx2(p, n);
+    if (cpu_has_popcnt()) return count_popcnt(p, n);
+#endif
+    return count_scalar(p, n);
+}
+
+static void apply(enum obit_op op, uint8_t *dst, const uint8_t *src, uint64_t n) {
+    uint64_t i = 0;
+#if defined(__x86_64__)
+    if (cpu_has_avx2()) i = apply_avx2(op, dst, src, n);
+#endif
+    apply_scalar(op, dst, src, n, i);
+}
+
+void
+obit_op(enum obit_op op, uint8_t *dst, uint64_t len, const uint8_t *const *src, const uint64_t *srclen, int nsrc) {
+    uint64_t l0 = srclen[0] < len ? srclen[0] : len;
+    if (op == OBIT_NOT) {
+        apply(OBIT_NOT, dst, src[0], l0);
+        memset(dst + l0, 0xff, len - l0);
+        return;
+    }
+    memcpy(dst, src[0], l0);
+    memset(dst + l0, 0, len - l0);
+    for (int k = 1; k < nsrc; k++) {
+        uint64_t lk = srclen[k] < len ? srclen[k] : len;
+        apply(op, dst, src[k], lk);
+        if (op == OBIT_AND) memset(dst + lk, 0, len - lk); // 较短的源按 0 补齐
+    }
+}
+
+uint64_t
+obit_skip(const void *p, uint64_t n, uint8_t skip) {
+    uint64_t i = 0;
+#if defined(__x86_64__)
+    if (cpu_has_avx2()) i = skip_avx2(p, n, skip);
+#endif
+    return skip_scalar(p, n, skip, i);
+}
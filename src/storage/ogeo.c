@@ -0,0 +1,248 @@
+//
+// Created by weishen on 2025/11/17.
+//
+
+#include "ogeo.h"
+#include "ocpu.h"
+
+#include <math.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#define D2R (M_PI / 180.0)
+#define R2D (180.0 / M_PI)
+#define LAT_SPAN (OGEO_LAT_MAX - OGEO_LAT_MIN)
+#define LON_SPAN (OGEO_LON_MAX - OGEO_LON_MIN)
+
+/*********************** geohash ******************************/
+
+/** 低 32 位展开到偶数位 */
+static inline uint64_t spread(uint32_t v) {
+    uint64_t x = v;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & 0x5555555555555555ULL;
+    return x;
+}
+
+/** 偶数位收拢到低 32 位 */
+static inline uint32_t squash(uint64_t x) {
+    x &= 0x5555555555555555ULL;
+    x = (x | (x >> 1)) & 0x3333333333333333ULL;
+    x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+    return (uint32_t) x;
+}
+
+static inline uint32_t quantize(double v, double min, double span) {
+    double off = (v - min) / span * (double) (1 << OGEO_STEP_MAX);
+    uint32_t q = (uint32_t) off;
+    return q >= (1u << OGEO_STEP_MAX) ? (1u << OGEO_STEP_MAX) - 1 : q; // 上边界归到最后一格
+}
+
+uint64_t
+ogeo_encode(double lon, double lat) {
+    return spread(quantize(lat, OGEO_LAT_MIN, LAT_SPAN)) | spread(quantize(lon, OGEO_LON_MIN, LON_SPAN)) << 1;
+}
+
+void
+ogeo_decode(uint64_t bits, double *lon, double *lat) {
+    const double cells = (double) (1 << OGEO_STEP_MAX);
+    uint32_t ilat = squash(bits), ilon = squash(bits >> 1);
+    double lat_min = OGEO_LAT_MIN + ilat / cells * LAT_SPAN, lat_max = OGEO_LAT_MIN + (ilat + 1) / cells * LAT_SPAN;
+    double lon_min = OGEO_LON_MIN + ilon / cells * LON_SPAN, lon_max = OGEO_LON_MIN + (ilon + 1) / cells * LON_SPAN;
+    *lon = (lon_min + lon_max) / 2;
+    *lat = (lat_min + lat_max) / 2;
+    if (*lon > OGEO_LON_MAX) *lon = OGEO_LON_MAX;
+    if (*lon < OGEO_LON_MIN) *lon = OGEO_LON_MIN;
+    if (*lat > OGEO_LAT_MAX) *lat = OGEO_LAT_MAX;
+    if (*lat < OGEO_LAT_MIN) *lat = OGEO_LAT_MIN;
+}
+
+double
+ogeo_dist(double lon1, double lat1, double lon2, double lat2) {
+    double v = sin((lon2 - lon1) * D2R / 2);
+    if (v == 0.0) return OGEO_EARTH_RADIUS * fabs((lat2 - lat1) * D2R);
+    double u = sin((lat2 - lat1) * D2R / 2);
+    double a = u * u + cos(lat1 * D2R) * cos(lat2 * D2R) * v * v;
+    return 2.0 * OGEO_EARTH_RADIUS * asin(sqrt(a));
+}
+
+/*********************** 覆盖查询范围的格子 ******************************/
+
+/**
+ * 查询范围的外接经纬度框 (半宽 dlon, 半高 dlat, 度), dlon >= 180 表示整圈经度
+ * 圆: 纬度方向 r / R, 经度方向是球冠的最大经度差 asin(sin(r/R) / cos(lat))
+ * 矩形: 与 exact 的判定一致, 经度方向取框内 |纬度| 最大处 (cos 最小) 的经度差
+ */
+static void bounding(const struct ogeo_shape *s, double *dlat, double *dlon) {
+    double lat = s->lat * D2R;
+    if (!s->box) {
+        double t = s->radius / OGEO_EARTH_RADIUS;
+        double r = t < M_PI / 2 ? sin(t) / cos(lat) : 2;
+        *dlat = t * R2D;
+        *dlon = r < 1 ? asin(r) * R2D : 180;
+    } else {
+        double t = s->height / 2 / OGEO_EARTH_RADIUS;
+        double far = fabs(lat) + t;
+        double r = far < M_PI / 2 && s->width / 4 / OGEO_EARTH_RADIUS < M_PI / 2
+                       ? sin(s->width / 4 / OGEO_EARTH_RADIUS) / cos(far)
+                       : 2;
+        *dlat = t * R2D;
+        *dlon = r < 1 ? 2 * asin(r) * R2D : 180;
+    }
+}
+
+uint32_t
+ogeo_ranges(const struct ogeo_shape *s, struct ogeo_range *out) {
+    double dlat, dlon;
+    bounding(s, &dlat, &dlon);
+    // 格子不小于外接框的半宽 / 半高时, 中心格子加 8 个邻居一定盖住整个框
+    int step = OGEO_STEP_MAX;
+    while (step > 1 && (LAT_SPAN / (double) (1 << step) < dlat || LON_SPAN / (double) (1 << step) < dlon)) step--;
+    double ch = LAT_SPAN / (double) (1 << step), cw = LON_SPAN / (double) (1 << step);
+    uint64_t center = ogeo_encode(s->lon, s->lat) >> (2 * (OGEO_STEP_MAX - step));
+    int64_t ilat = squash(center), ilon = squash(center >> 1), cells = 1LL << step;
+    double lat_lo = s->lat - dlat, lat_hi = s->lat + dlat, lon_lo = s->lon - dlon, lon_hi = s->lon + dlon;
+    double lat0 = OGEO_LAT_MIN + (double) ilat * ch, lon0 = OGEO_LON_MIN + (double) ilon * cw;
+    uint32_t n = 0;
+    for (int dy = -1; dy <= 1; dy++) {
+        int64_t y = ilat + dy;
+        double ymin = lat0 + dy * ch;
+        if (y < 0 || y >= cells || ymin > lat_hi || ymin + ch < lat_lo) continue;
+        for (int dx = -1; dx <= 1; dx++) {
+            double xmin = lon0 + dx * cw; // 不回绕的经度, 与不回绕的外接框比较
+            if (xmin > lon_hi || xmin + cw < lon_lo) continue;
+            int64_t x = (ilon + dx + cells) % cells;
+            uint64_t h = spread((uint32_t) y) | spread((uint32_t) x) << 1;
+            int shift = 2 * (OGEO_STEP_MAX - step);
+            struct ogeo_range r = {h << shift, (h + 1) << shift};
+            uint32_t i = n++;
+            for (; i > 0 && out[i - 1].min > r.min; i--) out[i] = out[i - 1];
+            out[i] = r;
+        }
+    }
+    // 合并相邻 / 重叠 (step 1 时左右邻居是同一个格子)
+    uint32_t m = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (m && out[i].min <= out[m - 1].max) {
+            if (out[i].max > out[m - 1].max) out[m - 1].max = out[i].max;
+        } else out[m++] = out[i];
+    }
+    return m;
+}
+
+/*********************** 距离过滤 ******************************/
+
+/** 精确判定 (libm), *dist <- 到中心的距离 */
+static int exact(const struct ogeo_shape *s, double lon, double lat, double *dist) {
+    if (!s->box) {
+        *dist = ogeo_dist(s->lon, s->lat, lon, lat);
+        return *dist <= s->radius;
+    }
+    // 与 Redis 相同: 先比较纬度方向的距离, 再比较点所在纬度上的经度方向距离
+    if (OGEO_EARTH_RADIUS * fabs((lat - s->lat) * D2R) > s->height / 2) return 0;
+    if (ogeo_dist(lon, lat, s->lon, lat) > s->width / 2) return 0;
+    *dist = ogeo_dist(s->lon, s->lat, lon, lat);
+    return 1;
+}
+
+#if defined(__x86_64__)
+/** [-pi/2, pi/2] 上的 sin, Taylor 展开到 x^15, 误差 < 1e-11 */
+__attribute__((target("avx2")))
+static inline __m256d sin_avx2(__m256d x) {
+    __m256d x2 = _mm256_mul_pd(x, x);
+    __m256d p = _mm256_set1_pd(-1.0 / 1307674368000.0);
+    p = _mm256_add_pd(_mm256_mul_pd(p, x2), _mm256_set1_pd(1.0 / 6227020800.0));
+    p = _mm256_add_pd(_mm256_mul_pd(p, x2), _mm256_set1_pd(-1.0 / 39916800.0));
+    p = _mm256_add_pd(_mm256_mul_pd(p, x2), _mm256_set1_pd(1.0 / 362880.0));
+    p = _mm256_add_pd(_mm256_mul_pd(p, x2), _mm256_set1_pd(-1.0 / 5040.0));
+    p = _mm256_add_pd(_mm256_mul_pd(p, x2), _mm256_set1_pd(1.0 / 120.0));
+    p = _mm256_add_pd(_mm256_mul_pd(p, x2), _mm256_set1_pd(-1.0 / 6.0));
+    p = _mm256_add_pd(_mm256_mul_pd(p, x2), _mm256_set1_pd(1.0));
+    return _mm256_mul_pd(p, x);
+}
+
+/** sin(x)^2, x in [-pi, pi]: 先折到 [0, pi/2] */
+__attribute__((target("avx2")))
+static inline __m256d sin2_avx2(__m256d x) {
+    const __m256d half_pi = _mm256_set1_pd(M_PI / 2), pi = _mm256_set1_pd(M_PI);
+    __m256d t = _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+    t = _mm256_blendv_pd(t, _mm256_sub_pd(pi, t), _mm256_cmp_pd(t, half_pi, _CMP_GT_OQ));
+    __m256d s = sin_avx2(t);
+    return _mm256_mul_pd(s, s);
+}
+
+/**
+ * 预过滤: 阈值放宽 1e-7 (远大于多项式的误差), 只会多放过边界附近的点, 不会漏掉
+ * 通过的下标写到 idx @return 个数
+ */
+__attribute__((target("avx2")))
+static uint32_t prefilter_avx2(const struct ogeo_shape *s, const double *lon, const double *lat, uint32_t n,
+                               uint32_t *idx, uint32_t *done) {
+    const __m256d d2r = _mm256_set1_pd(D2R), half = _mm256_set1_pd(0.5);
+    const __m256d lon0 = _mm256_set1_pd(s->lon), lat0 = _mm256_set1_pd(s->lat * D2R);
+    const __m256d half_pi = _mm256_set1_pd(M_PI / 2), absmask = _mm256_set1_pd(-0.0);
+    __m256d thr, thr_lat = _mm256_set1_pd(0);
+    __m256d coslat0 = _mm256_set1_pd(cos(s->lat * D2R));
+    int circle = !s->box;
+    if (circle) {
+        double t = s->radius / OGEO_EARTH_RADIUS / 2, st = t < M_PI / 2 ? sin(t) : 1;
+        thr = _mm256_set1_pd(st * st * (1 + 1e-7) + 1e-300);
+    } else {
+        double t = s->width / OGEO_EARTH_RADIUS / 4, st = t < M_PI / 2 ? sin(t) : 1;
+        thr = _mm256_set1_pd(st * st * (1 + 1e-7) + 1e-300);
+        thr_lat = _mm256_set1_pd(s->height / 2 / OGEO_EARTH_RADIUS * (1 + 1e-7));
+    }
+    uint32_t m = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d la = _mm256_mul_pd(_mm256_loadu_pd(lat + i), d2r);
+        __m256d dlat = _mm256_sub_pd(la, lat0);
+        __m256d dlon = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(lon + i), lon0), d2r);
+        __m256d coslat = sin_avx2(_mm256_sub_pd(half_pi, _mm256_andnot_pd(absmask, la)));
+        __m256d sdl = sin2_avx2(_mm256_mul_pd(dlon, half));
+        __m256d ok;
+        if (circle) {
+            __m256d a = _mm256_add_pd(sin2_avx2(_mm256_mul_pd(dlat, half)),
+                                      _mm256_mul_pd(_mm256_mul_pd(coslat0, coslat), sdl));
+            ok = _mm256_cmp_pd(a, thr, _CMP_LE_OQ);
+        } else {
+            __m256d a = _mm256_mul_pd(_mm256_mul_pd(coslat, coslat), sdl);
+            ok = _mm256_and_pd(_mm256_cmp_pd(_mm256_andnot_pd(absmask, dlat), thr_lat, _CMP_LE_OQ),
+                               _mm256_cmp_pd(a, thr, _CMP_LE_OQ));
+        }
+        uint32_t mask = (uint32_t) _mm256_movemask_pd(ok);
+        while (mask) {
+            idx[m++] = i + (uint32_t) __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+    *done = i;
+    return m;
+}
+
+#endif
+
+uint32_t
+ogeo_within(const struct ogeo_shape *s, const double *lon, const double *lat, uint32_t n, uint32_t *idx,
+            double *dist) {
+    uint32_t m = 0, i = 0;
+#if defined(__x86_64__)
+    if (cpu_has_avx2()) {
+        uint32_t k = prefilter_avx2(s, lon, lat, n, idx, &i);
+        for (uint32_t j = 0; j < k; j++) {
+            uint32_t c = idx[j];
+            if (exact(s, lon[c], lat[c], &dist[m])) idx[m++] = c;
+        }
+    }
+#endif
+    for (; i < n; i++)
+        if (exact(s, lon[i], lat[i], &dist[m])) idx[m++] = i;
+    return m;
+}
@@ -9,6 +9,7 @@
 ohash_t *ohashtabl = NULL;
 uint64_t cap = 0;
 uint64_t size = 0;
+uint64_t ohash_clock_ms = 0;
 
 int
 initohash(uint64_t cap_) {
@@ -21,31 +22,40 @@ initohash(uint64_t cap_) {
     return OK;
 }
 
-int
-expand_capacity(void *free_func) {
-    uint64_t n_cap = cap << 1;
+/**
+ * 全局表与嵌套表 (otable_t) 共用下面这组 core:
+ * 表 / 容量 / 元素个数作为参数传入, 全局 API 传 ohashtabl, cap, &size
+ * 嵌套表的 expiratime 总是 0, 传 now = 0 即可跳过过期判断 (也不读时钟)
+ */
+static int
+expand_core(ohash_t **tab, uint64_t *tcap, void *kfree, void *vfree) {
+    ohash_t *t = *tab;
+    uint64_t old_cap = *tcap;
+    uint64_t n_cap = old_cap << 1;
+    if (n_cap > OHASH_CAP_MAX) return -ENOMEM;
 #ifndef NDEBUG
-    syslog(LOG_INFO, "ohash expand capacity org %" PRIu64 ", new %" PRIu64, cap, n_cap);
+    if (t == ohashtabl)
+        syslog(LOG_INFO, "ohash expand capacity org %" PRIu64 ", new %" PRIu64, old_cap, n_cap);
     uint64_t migrated = 0, freed = 0;
 #endif
     ohash_t *n_ohash = calloc(n_cap * sizeof(ohash_t), 1);
     if (!n_ohash) return -ENOMEM;
     // Start migrating both cap and n_cap, which are powers of 2
-    for (uint64_t i = 0; i < cap; i++) {
+    for (uint64_t i = 0; i < old_cap; i++) {
         /**
         * rm = 0, tb = 0：活跃元素，所有权在哈希表
         * rm = 0, tb = 1：过期元素，所有权仍在哈希表（需要释放）
         * rm = 1, tb = 1：已删除元素，所有权已转移出去（不能释放)
         */
-        if (!ohashtabl[i].key && !ohashtabl[i].tb) continue; // NULL Slot
+        if (!t[i].key && !t[i].tb) continue; // NULL Slot
 
         // Survive
-        if (!ohashtabl[i].tb && !ohashtabl[i].rm) {
-            uint64_t n_idx = ohashtabl[i].hash & (n_cap - 1);
+        if (!t[i].tb && !t[i].rm) {
+            uint64_t n_idx = t[i].hash & (n_cap - 1);
             while (1) {
                 //There is no tombstone because it is new
-                if (!n_ohash[n_idx].hash) {
-                    memcpy(n_ohash + n_idx, ohashtabl + i, sizeof(ohash_t));
+                if (!n_ohash[n_idx].key) {
+                    memcpy(n_ohash + n_idx, t + i, sizeof(ohash_t));
 #ifndef NDEBUG
                     migrated++;
 #endif
@@ -55,134 +65,265 @@ expand_capacity(void *free_func) {
             }
         }
         //Die due to expiration
-        if (ohashtabl[i].tb && !ohashtabl[i].rm && free_func) {
+        if (t[i].tb && !t[i].rm) {
 #ifndef NDEBUG
             freed++;
 #endif
-            ((void (*)(void *)) free_func)(ohashtabl[i].key);
-            ((void (*)(void *)) free_func)(ohashtabl[i].v);
+            if (kfree) ((void (*)(void *)) kfree)(t[i].key);
+            if (vfree) ((void (*)(void *)) vfree)(t[i].v);
         }
     }
 #ifndef NDEBUG
-    syslog(LOG_INFO, "expansion complete: migrated %" PRIu64 ", freed %" PRIu64,
-           migrated, freed);
+    if (t == ohashtabl)
+        syslog(LOG_INFO, "expansion complete: migrated %" PRIu64 ", freed %" PRIu64,
+               migrated, freed);
 #endif
-    free(ohashtabl);
-    ohashtabl = n_ohash;
-    cap = n_cap;
+    free(t);
+    *tab = n_ohash;
+    *tcap = n_cap;
     return OK;
 }
 
-int
-oinsert(char *key, uint32_t keylen, void *v, uint32_t expira, oret_t *oret) {
-    if (size * LOAD_FACTOR_DENOMINATOR >= cap * LOAD_FACTOR_THRESHOLD) return FULL;
+static inline int
+insert_core(ohash_t *t, uint64_t tcap, uint64_t *tsize, char *key, uint32_t keylen, uint64_t hash,
+            void *v, uint64_t expira, oret_t *oret) {
+    if (*tsize * LOAD_FACTOR_DENOMINATOR >= tcap * LOAD_FACTOR_THRESHOLD) return FULL;
     int ret = OK;
-    uint64_t hash = XXH64(key, keylen, H_SEED);
-    uint64_t idx = hash & (cap - 1); // cap is 2 power
+    uint64_t idx = hash & (tcap - 1); // cap is 2 power
     // linear addressing of load-factor is 0.7
-    uint64_t icap = cap;
+    uint64_t icap = tcap;
     while (icap--) {
-        if (!ohashtabl[idx].key || ohashtabl[idx].rm) {
-            if (ohashtabl[idx].rm) ret = REMOVED;
+        if (!t[idx].key || t[idx].rm) {
+            if (t[idx].rm) ret = REMOVED;
             goto gotoinsert;
         }
-        if (ohashtabl[idx].tb) {
+        if (t[idx].tb) {
             if (oret) {
-                oret->key = ohashtabl[idx].key;
-                oret->value = ohashtabl[idx].v;
+                oret->key = t[idx].key;
+                oret->value = t[idx].v;
             }
             ret = EXPIRED_;
             goto gotoinsert;
         }
-        if (hash == ohashtabl[idx].hash && keylen == ohashtabl[idx].keylen) {
-            if (!memcmp(key, ohashtabl[idx].key, keylen)) {
+        if ((uint32_t) hash == t[idx].hash && keylen == t[idx].keylen) {
+            if (!memcmp(key, t[idx].key, keylen)) {
                 if (oret) {
-                    oret->key = ohashtabl[idx].key;
-                    oret->value = ohashtabl[idx].v;
+                    oret->key = t[idx].key;
+                    oret->value = t[idx].v;
                 }
                 ret = REPLACED;
                 goto gotoinsert;
             }
         }
-        idx = (idx + 1) & (cap - 1);
+        idx = (idx + 1) & (tcap - 1);
     }
     return UNKNOWN_ERROR;
 gotoinsert:
-    ohashtabl[idx].hash = hash;
+    t[idx].hash = (uint32_t) hash;
     // 所有权转移 table 并不会支持分配和释放 它只负责管理所有权
-    ohashtabl[idx].key = key;
-    ohashtabl[idx].v = v;
-    ohashtabl[idx].keylen = keylen;
-    ohashtabl[idx].expiratime = expira;
-    ohashtabl[idx].tb = 0;
-    ohashtabl[idx].rm = 0;
-    if (ret == OK || ret == REMOVED) size++;
+    t[idx].key = key;
+    t[idx].v = v;
+    t[idx].keylen = keylen;
+    t[idx].expiratime = expira;
+    t[idx].tb = 0;
+    t[idx].rm = 0;
+    if (ret == OK || ret == REMOVED) (*tsize)++;
     return ret;
 }
 
-
-void *
-oget(char *key, uint32_t keylen) {
-    long sec = get_current_time_seconds();
-    uint64_t hash = XXH64(key, keylen, H_SEED);
-    uint64_t idx = hash & (cap - 1); // cap is 2 power
-    uint64_t icap = cap;
+static inline ohash_t *
+lookup_core(ohash_t *t, uint64_t tcap, const char *key, uint32_t keylen, uint64_t hash, uint64_t now) {
+    uint64_t idx = hash & (tcap - 1); // cap is 2 power
+    uint64_t icap = tcap;
     while (icap--) {
-        if (!ohashtabl[idx].key && !ohashtabl[idx].tb)
+        if (!t[idx].key && !t[idx].tb)
             goto notfound;
-        if (ohashtabl[idx].tb)
+        if (t[idx].tb)
             goto next;
-        if (hash == ohashtabl[idx].hash && keylen == ohashtabl[idx].keylen) {
-            if (ohashtabl[idx].expiratime > 0 && sec >= ohashtabl[idx].expiratime)
+        if ((uint32_t) hash == t[idx].hash && keylen == t[idx].keylen) {
+            if (t[idx].expiratime > 0 && now >= t[idx].expiratime)
                 goto expire;
-            if (!memcmp(key, ohashtabl[idx].key, keylen))
-                return ohashtabl[idx].v;
+            if (!memcmp(key, t[idx].key, keylen))
+                return t + idx;
         }
-        if (ohashtabl[idx].expiratime > 0 && sec >= ohashtabl[idx].expiratime)
-            ohashtabl[idx].tb = 1; // tombstone,without any deletions
+        if (t[idx].expiratime > 0 && now >= t[idx].expiratime)
+            t[idx].tb = 1; // tombstone,without any deletions
     next:
-        idx = (idx + 1) & (cap - 1);
+        idx = (idx + 1) & (tcap - 1);
     }
 notfound:
     return NULL;
 expire:
-    ohashtabl[idx].tb = 1; // tombstone,without any deletions
+    t[idx].tb = 1; // tombstone,without any deletions
     return NULL;
 }
 
-void
-otake(char *key, uint32_t keylen, oret_t *oret) {
-    long sec = get_current_time_seconds();
-    uint64_t hash = XXH64(key, keylen, H_SEED);
-    uint64_t idx = hash & (cap - 1); // cap is 2 power
-    uint64_t icap = cap;
+static inline void
+take_core(ohash_t *t, uint64_t tcap, uint64_t *tsize, const char *key, uint32_t keylen, uint64_t hash,
+          uint64_t now, oret_t *oret) {
+    uint64_t idx = hash & (tcap - 1); // cap is 2 power
+    uint64_t icap = tcap;
     while (icap--) {
-        if (!ohashtabl[idx].key && !ohashtabl[idx].tb)
+        if (!t[idx].key && !t[idx].tb)
             return;
-        if (ohashtabl[idx].tb)
+        if (t[idx].tb)
             goto next;
-        if (hash == ohashtabl[idx].hash && keylen == ohashtabl[idx].keylen) {
-            if (!memcmp(key, ohashtabl[idx].key, keylen)) {
-                ohashtabl[idx].rm = 1;
-                ohashtabl[idx].tb = 1;
-                oret->key = ohashtabl[idx].key;
-                oret->value = ohashtabl[idx].v;
-                ohashtabl[idx].key = NULL;
-                ohashtabl[idx].v = NULL;
-                size--;
+        if ((uint32_t) hash == t[idx].hash && keylen == t[idx].keylen) {
+            if (!memcmp(key, t[idx].key, keylen)) {
+                t[idx].rm = 1;
+                t[idx].tb = 1;
+                oret->key = t[idx].key;
+                oret->value = t[idx].v;
+                t[idx].key = NULL;
+                t[idx].v = NULL;
+                (*tsize)--;
                 break;
             }
         }
-        if (ohashtabl[idx].expiratime > 0 && sec >= ohashtabl[idx].expiratime)
-            ohashtabl[idx].tb = 1; // tombstone,without any deletions
+        if (t[idx].expiratime > 0 && now >= t[idx].expiratime)
+            t[idx].tb = 1; // tombstone,without any deletions
+    next:
+        idx = (idx + 1) & (tcap - 1);
+    }
+}
+
+int
+expand_capacity(void *free_func) {
+    return expand_core(&ohashtabl, &cap, free_func, free_func);
+}
+
+int
+expand_capacity_kv(void *key_free, void *value_free) {
+    return expand_core(&ohashtabl, &cap, key_free, value_free);
+}
+
+int
+oinsert(char *key, uint32_t keylen, void *v, uint64_t expira, oret_t *oret) {
+    return insert_core(ohashtabl, cap, &size, key, keylen, ohash_key(key, keylen), v, expira, oret);
+}
+
+int
+oinsert_h(char *key, uint32_t keylen, uint64_t hash, void *v, uint64_t expira, oret_t *oret) {
+    return insert_core(ohashtabl, cap, &size, key, keylen, hash, v, expira, oret);
+}
+
+ohash_t *
+olookup(char *key, uint32_t keylen) {
+    return lookup_core(ohashtabl, cap, key, keylen, ohash_key(key, keylen), oclock_ms());
+}
+
+ohash_t *
+olookup_h(char *key, uint32_t keylen, uint64_t hash) {
+    return lookup_core(ohashtabl, cap, key, keylen, hash, oclock_ms());
+}
+
+void *
+oget(char *key, uint32_t keylen) {
+    ohash_t *slot = olookup(key, keylen);
+    return slot ? slot->v : NULL;
+}
+
+void
+otake(char *key, uint32_t keylen, oret_t *oret) {
+    take_core(ohashtabl, cap, &size, key, keylen, ohash_key(key, keylen), oclock_ms(), oret);
+}
+
+void
+otake_h(char *key, uint32_t keylen, uint64_t hash, oret_t *oret) {
+    take_core(ohashtabl, cap, &size, key, keylen, hash, oclock_ms(), oret);
+}
+
+ohash_t *
+oprobe(char *key, uint32_t keylen, uint64_t *hash, int *found) {
+    uint64_t now = oclock_ms();
+    uint64_t h = ohash_key(key, keylen);
+    uint64_t idx = h & (cap - 1); // cap is 2 power
+    uint64_t icap = cap;
+    ohash_t *avail = NULL; // first reusable tombstone on the probe path
+    *hash = h;
+    *found = 0;
+    while (icap--) {
+        ohash_t *s = ohashtabl + idx;
+        if (!s->key && !s->tb)
+            goto notfound;
+        if (s->tb) {
+            if (!avail) avail = s;
+            goto next;
+        }
+        if (s->expiratime > 0 && now >= s->expiratime) {
+            s->tb = 1; // tombstone,without any deletions
+            if (!avail) avail = s;
+            // key 是唯一的, 它自己过期了就不会出现在后面
+            if ((uint32_t) h == s->hash && keylen == s->keylen && !memcmp(key, s->key, keylen))
+                goto notfound;
+            goto next;
+        }
+        if ((uint32_t) h == s->hash && keylen == s->keylen && !memcmp(key, s->key, keylen)) {
+            *found = 1;
+            return s;
+        }
     next:
         idx = (idx + 1) & (cap - 1);
     }
+    if (!avail) return NULL;
+notfound:
+    if (size * LOAD_FACTOR_DENOMINATOR >= cap * LOAD_FACTOR_THRESHOLD) return NULL;
+    return avail ? avail : ohashtabl + idx;
+}
+
+int
+oclaim(ohash_t *slot, char *key, uint32_t keylen, uint64_t hash, void *v, uint64_t expira, oret_t *oret) {
+    int ret = OK;
+    if (slot->rm) ret = REMOVED;
+    else if (slot->tb) {
+        oret->key = slot->key;
+        oret->value = slot->v;
+        ret = EXPIRED_;
+    }
+    slot->hash = (uint32_t) hash;
+    slot->key = key;
+    slot->v = v;
+    slot->keylen = keylen;
+    slot->expiratime = expira;
+    slot->tb = 0;
+    slot->rm = 0;
+    if (ret != EXPIRED_) size++;
+    return ret;
+}
+
+void
+otake_slot(ohash_t *slot, oret_t *oret) {
+    slot->rm = 1;
+    slot->tb = 1;
+    oret->key = slot->key;
+    oret->value = slot->v;
+    slot->key = NULL;
+    slot->v = NULL;
+    size--;
+}
+
+void
+ohash_batch(obatch_t *b, uint32_t n) {
+    // 全部先 hash, 并预取 home slot; n 个 DRAM miss 重叠而不是串行
+    for (uint32_t i = 0; i < n; i++) {
+        b[i].hash = ohash_key(b[i].key, b[i].keylen);
+        oprefetch(b[i].hash);
+    }
 }
 
+void
+olookup_batch(obatch_t *b, uint32_t n) {
+    // stage 1: hash + prefetch
+    ohash_batch(b, n);
+    // stage 2: probe, 此时 home slot 大多已在 cache 中; 顺便预取命中的值
+    for (uint32_t i = 0; i < n; i++) {
+        b[i].slot = olookup_h(b[i].key, b[i].keylen, b[i].hash);
+        if (b[i].slot) __builtin_prefetch(b[i].slot->v);
+    }
+}
 
-void oexpired(char *key, uint32_t keylen, uint32_t expiratime) {
-    long sec = get_current_time_seconds();
+void oexpired(char *key, uint32_t keylen, uint64_t expiratime) {
+    uint64_t now = oclock_ms();
     uint64_t hash = XXH64(key, keylen, H_SEED);
     uint64_t idx = hash & (cap - 1);
     uint64_t icap = cap;
@@ -191,15 +332,59 @@ void oexpired(char *key, uint32_t keylen, uint32_t expiratime) {
             return;
         if (ohashtabl[idx].tb)
             goto next;
-        if (hash == ohashtabl[idx].hash && keylen == ohashtabl[idx].keylen) {
+        if ((uint32_t) hash == ohashtabl[idx].hash && keylen == ohashtabl[idx].keylen) {
             if (!memcmp(key, ohashtabl[idx].key, keylen)) {
                 ohashtabl[idx].expiratime = expiratime;
                 return;
             }
         }
-        if (ohashtabl[idx].expiratime > 0 && sec >= ohashtabl[idx].expiratime)
+        if (ohashtabl[idx].expiratime > 0 && now >= ohashtabl[idx].expiratime)
             ohashtabl[idx].tb = 1; // tombstone,without any deletions
     next:
         idx = (idx + 1) & (cap - 1);
     }
 }
+
+/*********************** nested tables ******************************/
+
+int
+otable_init(otable_t *t, uint64_t cap_) {
+    if (cap_ & cap_ - 1)
+        cap_ = getnext2power(cap_);
+    t->slots = calloc(cap_ * sizeof(ohash_t), 1);
+    if (!t->slots) return -ENOMEM;
+    t->cap = cap_;
+    t->size = 0;
+    return OK;
+}
+
+void
+otable_destroy(otable_t *t, void *free_func) {
+    for (uint64_t i = 0; i < t->cap && free_func; i++) {
+        if (!t->slots[i].key || t->slots[i].rm) continue;
+        ((void (*)(void *)) free_func)(t->slots[i].key);
+        ((void (*)(void *)) free_func)(t->slots[i].v);
+    }
+    free(t->slots);
+    t->slots = NULL;
+    t->cap = t->size = 0;
+}
+
+int
+otable_insert(otable_t *t, char *key, uint32_t keylen, void *v, oret_t *oret) {
+    uint64_t hash = ohash_key(key, keylen);
+    int ret = insert_core(t->slots, t->cap, &t->size, key, keylen, hash, v, 0, oret);
+    if (ret != FULL) return ret;
+    if ((ret = expand_core(&t->slots, &t->cap, NULL, NULL)) < 0) return ret;
+    return insert_core(t->slots, t->cap, &t->size, key, keylen, hash, v, 0, oret);
+}
+
+ohash_t *
+otable_lookup(otable_t *t, const char *key, uint32_t keylen) {
+    return lookup_core(t->slots, t->cap, key, keylen, ohash_key(key, keylen), 0);
+}
+
+void
+otable_take(otable_t *t, const char *key, uint32_t keylen, oret_t *oret) {
+    take_core(t->slots, t->cap, &t->size, key, keylen, ohash_key(key, keylen), 0, oret);
+}
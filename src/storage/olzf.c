@@ -0,0 +1,96 @@
+//
+// Created by weishen on 2025/11/10.
+//
+
+#include "olzf.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define OLZF_HLOG 13
+#define OLZF_MAX_OFF (1U << 13)
+#define OLZF_MAX_REF (7 + 255 + 2)
+
+static inline uint32_t hash3(const uint8_t *p) {
+    uint32_t v = (uint32_t) p[0] << 16 | (uint32_t) p[1] << 8 | p[2];
+    return (v * 2654435761U) >> (32 - OLZF_HLOG);
+}
+
+/** 字面量每 32 个一组, 前面一个控制字节 */
+static int emit_literals(uint8_t **op, const uint8_t *oend, const uint8_t *s, const uint8_t *e) {
+    while (s < e) {
+        size_t k = (size_t) (e - s) > 32 ? 32 : (size_t) (e - s);
+        if ((size_t) (oend - *op) < k + 1) return -1;
+        *(*op)++ = (uint8_t) (k - 1);
+        memcpy(*op, s, k);
+        *op += k;
+        s += k;
+    }
+    return 0;
+}
+
+size_t
+olzf_compress(const void *in, size_t inlen, void *out, size_t outcap) {
+    const uint8_t *base = in, *ip = base, *end = base + inlen, *lit = base;
+    uint8_t *op = out, *oend = op + outcap;
+    uint32_t htab[1U << OLZF_HLOG] = {0}; // 位置 + 1, 0 表示空
+    while (ip + 3 <= end) {
+        uint32_t h = hash3(ip);
+        uint32_t cand = htab[h];
+        htab[h] = (uint32_t) (ip - base) + 1;
+        if (cand) {
+            const uint8_t *ref = base + cand - 1;
+            size_t off = (size_t) (ip - ref) - 1;
+            if (off < OLZF_MAX_OFF && ref[0] == ip[0] && ref[1] == ip[1] && ref[2] == ip[2]) {
+                if (emit_literals(&op, oend, lit, ip) < 0) return 0;
+                size_t len = 3, max = (size_t) (end - ip);
+                if (max > OLZF_MAX_REF) max = OLZF_MAX_REF;
+                while (len < max && ref[len] == ip[len]) len++;
+                size_t l = len - 2;
+                if (oend - op < 3) return 0;
+                if (l < 7) *op++ = (uint8_t) (l << 5 | off >> 8);
+                else {
+                    *op++ = (uint8_t) (7 << 5 | off >> 8);
+                    *op++ = (uint8_t) (l - 7);
+                }
+                *op++ = (uint8_t) off;
+                ip += len;
+                lit = ip;
+                continue;
+            }
+        }
+        ip++;
+    }
+    if (emit_literals(&op, oend, lit, end) < 0) return 0;
+    return (size_t) (op - (uint8_t *) out);
+}
+
+size_t
+olzf_decompress(const void *in, size_t inlen, void *out, size_t outcap) {
+    const uint8_t *ip = in, *iend = ip + inlen;
+    uint8_t *op = out, *oend = op + outcap;
+    while (ip < iend) {
+        size_t c = *ip++;
+        if (c < 32) {
+            c++;
+            if ((size_t) (iend - ip) < c || (size_t) (oend - op) < c) return 0;
+            memcpy(op, ip, c);
+            op += c;
+            ip += c;
+            continue;
+        }
+        size_t len = c >> 5;
+        if (len == 7) {
+            if (ip >= iend) return 0;
+            len += *ip++;
+        }
+        len += 2;
+        if (ip >= iend) return 0;
+        size_t off = ((c & 31) << 8 | *ip++) + 1;
+        if ((size_t) (op - (uint8_t *) out) < off || (size_t) (oend - op) < len) return 0;
+        const uint8_t *ref = op - off;
+        // 可能与输出重叠 (off < len), 只能逐字节复制
+        while (len--) *op++ = *ref++;
+    }
+    return (size_t) (op - (uint8_t *) out);
+}
@@ -0,0 +1,231 @@
+//
+// Created by weishen on 2025/11/14.
+//
+
+#include "osv_bloom.h"
+#include "ocpu.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xxhash.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+/** 每个字一个奇数乘数, 前 8 个与 Parquet 的 split block Bloom filter 相同 */
+static const uint32_t salt[OBLOOM_WORDS] __attribute__((aligned(32))) = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+    0x9e3779b1U, 0x85ebca77U, 0xc2b2ae3dU, 0x27d4eb2fU, 0x165667b1U, 0xd3a2646dU, 0xfd7046c5U, 0xb55a4f09U,
+};
+
+/** 块下标: 用 h 的高位做乘法取模, 不要求 nblocks 是 2 的幂 */
+static inline uint8_t *block_of(const struct obloom_layer *l, uint64_t h) {
+    uint64_t i = (uint64_t) (((unsigned __int128) h * l->nblocks) >> 64);
+    return l->blocks + i * OBLOOM_BLOCK;
+}
+
+/*********************** 标量版本 ******************************/
+
+static inline void mask_scalar(uint64_t h, uint32_t k, uint32_t *m) {
+    uint32_t h32 = (uint32_t) h, w0 = (uint32_t) (h >> 32) & (OBLOOM_WORDS - 1);
+    for (uint32_t j = 0; j < OBLOOM_WORDS; j++)
+        m[j] = ((j - w0) & (OBLOOM_WORDS - 1)) < k ? 1U << ((h32 * salt[j]) >> 27) : 0;
+}
+
+static int test_scalar(const uint8_t *blk, uint64_t h, uint32_t k) {
+    uint32_t m[OBLOOM_WORDS], w[OBLOOM_WORDS];
+    mask_scalar(h, k, m);
+    memcpy(w, blk, OBLOOM_BLOCK);
+    for (uint32_t j = 0; j < OBLOOM_WORDS; j++)
+        if ((w[j] & m[j]) != m[j]) return 0;
+    return 1;
+}
+
+static void set_scalar(uint8_t *blk, uint64_t h, uint32_t k) {
+    uint32_t m[OBLOOM_WORDS], w[OBLOOM_WORDS];
+    mask_scalar(h, k, m);
+    memcpy(w, blk, OBLOOM_BLOCK);
+    for (uint32_t j = 0; j < OBLOOM_WORDS; j++) w[j] |= m[j];
+    memcpy(blk, w, OBLOOM_BLOCK);
+}
+
+/*********************** SIMD 版本 ******************************/
+
+#if defined(__x86_64__)
+/** 16 个字的掩码, 每个 __m256i 8 个字: 1 << (h32 * salt >> 27), 只保留生效的 k 个字 */
+__attribute__((target("avx2")))
+static inline void mask_avx2(uint64_t h, uint32_t k, __m256i *m0, __m256i *m1) {
+    const __m256i hv = _mm256_set1_epi32((int) (uint32_t) h);
+    const __m256i one = _mm256_set1_epi32(1), wrap = _mm256_set1_epi32(OBLOOM_WORDS - 1);
+    const __m256i w0 = _mm256_set1_epi32((int) ((h >> 32) & (OBLOOM_WORDS - 1)));
+    const __m256i kv = _mm256_set1_epi32((int) k);
+    __m256i p0 = _mm256_srli_epi32(_mm256_mullo_epi32(hv, _mm256_load_si256((const __m256i *) salt)), 27);
+    __m256i p1 = _mm256_srli_epi32(_mm256_mullo_epi32(hv, _mm256_load_si256((const __m256i *) salt + 1)), 27);
+    __m256i r0 = _mm256_and_si256(_mm256_sub_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), w0), wrap);
+    __m256i r1 = _mm256_and_si256(_mm256_sub_epi32(_mm256_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15), w0), wrap);
+    *m0 = _mm256_and_si256(_mm256_sllv_epi32(one, p0), _mm256_cmpgt_epi32(kv, r0));
+    *m1 = _mm256_and_si256(_mm256_sllv_epi32(one, p1), _mm256_cmpgt_epi32(kv, r1));
+}
+
+/** (块 & 掩码) == 掩码, 即 vptest 的 CF */
+__attribute__((target("avx2")))
+static int test_avx2(const uint8_t *blk, uint64_t h, uint32_t k) {
+    __m256i m0, m1;
+    mask_avx2(h, k, &m0, &m1);
+    const __m256i *b = (const __m256i *) blk;
+    return _mm256_testc_si256(_mm256_load_si256(b), m0) & _mm256_testc_si256(_mm256_load_si256(b + 1), m1);
+}
+
+__attribute__((target("avx2")))
+static void set_avx2(uint8_t *blk, uint64_t h, uint32_t k) {
+    __m256i m0, m1;
+    mask_avx2(h, k, &m0, &m1);
+    __m256i *b = (__m256i *) blk;
+    _mm256_store_si256(b, _mm256_or_si256(_mm256_load_si256(b), m0));
+    _mm256_store_si256(b + 1, _mm256_or_si256(_mm256_load_si256(b + 1), m1));
+}
+
+#endif
+
+static int block_test(const uint8_t *blk, uint64_t h, uint32_t k) {
+#if defined(__x86_64__)
+    if (cpu_has_avx2()) return test_avx2(blk, h, k);
+#endif
+    return test_scalar(blk, h, k);
+}
+
+static void block_set(uint8_t *blk, uint64_t h, uint32_t k) {
+#if defined(__x86_64__)
+    if (cpu_has_avx2()) {
+        set_avx2(blk, h, k);
+        return;
+    }
+#endif
+    set_scalar(blk, h, k);
+}
+
+/*********************** 层 ******************************/
+
+/**
+ * bits/元素 = -ln(error) / ln2^2 (再乘分块的补偿), k = ceil(-log2(error)), 限制在 [1, 16]
+ * @return 0 或 -ENOMEM
+ */
+static int layer_init(struct obloom_layer *l, double error, uint64_t capacity) {
+    double bpe = -log(error) / (M_LN2 * M_LN2);
+    double k = ceil(M_LN2 * bpe);
+    l->k = k < 1 ? 1 : k > OBLOOM_K_MAX ? OBLOOM_K_MAX : (uint32_t) k;
+    bpe *= 1 + l->k * OBLOOM_BLOCK_PENALTY;
+    double blocks = ceil((double) capacity * bpe / (OBLOOM_BLOCK * 8));
+    if (blocks > (double) (SIZE_MAX / 2 / OBLOOM_BLOCK)) return -ENOMEM;
+    l->nblocks = blocks < 1 ? 1 : (uint64_t) blocks;
+    l->capacity = capacity;
+    l->count = 0;
+    l->blocks = aligned_alloc(OBLOOM_BLOCK, l->nblocks * OBLOOM_BLOCK);
+    if (!l->blocks) return -ENOMEM;
+    memset(l->blocks, 0, l->nblocks * OBLOOM_BLOCK);
+    return 0;
+}
+
+/** 追加一层, 容量和误判率按层数收紧 */
+static int layer_push(struct obloom *bf) {
+    struct obloom_layer *last = bf->layers + bf->nlayers - 1;
+    double error = bf->error * pow(OBLOOM_TIGHTENING, bf->nlayers);
+    uint64_t capacity = last->capacity * bf->expansion;
+    if (capacity / bf->expansion != last->capacity) return -ENOMEM;
+    struct obloom_layer *ls = realloc(bf->layers, sizeof(*ls) * (bf->nlayers + 1));
+    if (!ls) return -ENOMEM;
+    bf->layers = ls;
+    int ret = layer_init(ls + bf->nlayers, error, capacity);
+    if (ret < 0) return ret;
+    bf->nlayers++;
+    return 0;
+}
+
+/*********************** API ******************************/
+
+osv *
+obloomv_new(double error, uint64_t capacity, uint32_t expansion) {
+    osv *v = malloc(sizeof(osv) + sizeof(struct obloom));
+    if (!v) return NULL;
+    v->vlen = sizeof(struct obloom);
+    v->meta = 0;
+    v->enc = OSV_BLOOM;
+    struct obloom *bf = obloomv_bf(v);
+    bf->layers = malloc(sizeof(struct obloom_layer));
+    bf->nlayers = 0;
+    bf->expansion = expansion;
+    bf->error = error;
+    bf->items = 0;
+    if (!bf->layers || layer_init(bf->layers, error, capacity) < 0) {
+        free(bf->layers);
+        free(v);
+        return NULL;
+    }
+    bf->nlayers = 1;
+    return v;
+}
+
+osv *
+obloomv_new_default(void) {
+    return obloomv_new(OBLOOM_ERROR_DEFAULT, OBLOOM_CAPACITY_DEFAULT, OBLOOM_EXPANSION_DEFAULT);
+}
+
+void
+obloomv_clear(osv *v) {
+    struct obloom *bf = obloomv_bf(v);
+    for (uint32_t i = 0; i < bf->nlayers; i++) free(bf->layers[i].blocks);
+    free(bf->layers);
+    bf->layers = NULL;
+    bf->nlayers = 0;
+}
+
+uint64_t
+obloomv_bytes(const osv *v) {
+    const struct obloom *bf = obloomv_bf(v);
+    uint64_t n = sizeof(osv) + v->vlen + sizeof(struct obloom_layer) * bf->nlayers;
+    for (uint32_t i = 0; i < bf->nlayers; i++) n += bf->layers[i].nblocks * OBLOOM_BLOCK;
+    return n;
+}
+
+uint64_t
+obloom_hash(const char *e, uint64_t len) {
+    return XXH3_64bits(e, len);
+}
+
+void
+obloomv_prefetch(const osv *v, uint64_t h) {
+    const struct obloom *bf = obloomv_bf(v);
+    for (uint32_t i = 0; i < bf->nlayers; i++) __builtin_prefetch(block_of(bf->layers + i, h));
+}
+
+int
+obloomv_exists(const osv *v, uint64_t h) {
+    const struct obloom *bf = obloomv_bf(v);
+    // 新的层更大, 装的元素也更多, 从后往前查
+    for (uint32_t i = bf->nlayers; i-- > 0;) {
+        const struct obloom_layer *l = bf->layers + i;
+        if (block_test(block_of(l, h), h, l->k)) return 1;
+    }
+    return 0;
+}
+
+int
+obloomv_add(osv *v, uint64_t h) {
+    if (obloomv_exists(v, h)) return 0;
+    struct obloom *bf = obloomv_bf(v);
+    struct obloom_layer *l = bf->layers + bf->nlayers - 1;
+    if (l->count >= l->capacity) {
+        if (!bf->expansion) return -ENOSPC;
+        int ret = layer_push(bf);
+        if (ret < 0) return ret;
+        l = bf->layers + bf->nlayers - 1;
+    }
+    block_set(block_of(l, h), h, l->k);
+    l->count++;
+    bf->items++;
+    return 1;
+}
@@ -0,0 +1,251 @@
+//
+// Created by weishen on 2025/11/9.
+//
+
+#include "osv_hash.h"
+
+#include <string.h>
+
+/** PACK 的 entry 起点 -> field / value */
+#define PK_FLEN(p) ((uint8_t) (p)[0])
+#define PK_FIELD(p) ((p) + 1)
+#define PK_VLEN(p) ((uint8_t) (p)[1 + PK_FLEN(p)])
+#define PK_VAL(p) ((p) + 2 + PK_FLEN(p))
+#define PK_SIZE(p) (2 + PK_FLEN(p) + PK_VLEN(p))
+
+osv *
+ohv_new(void) {
+    osv *v = malloc(sizeof(osv));
+    if (!v) return NULL;
+    v->vlen = 0;
+    v->meta = 0;
+    v->enc = OSV_HASH_PACK;
+    return v;
+}
+
+void
+ohv_free(osv *v) {
+    if (v->enc == OSV_HASH_TABLE) otable_destroy(ohv_table(v), free);
+    free(v);
+}
+
+/**
+ * PACK 中查找 field, *count <- 扫描过的 entry 数 (没找到时就是总数)
+ * @return entry 起点, NULL 不存在
+ */
+static char *
+pack_find(const osv *v, const char *f, uint32_t flen, uint64_t *count) {
+    char *p = (char *) v->d, *end = p + v->vlen;
+    uint64_t n = 0;
+    for (; p < end; p += PK_SIZE(p), n++) {
+        if (PK_FLEN(p) == flen && !memcmp(PK_FIELD(p), f, flen)) {
+            if (count) *count = n;
+            return p;
+        }
+    }
+    if (count) *count = n;
+    return NULL;
+}
+
+uint64_t
+ohv_len(const osv *v) {
+    if (v->enc == OSV_HASH_TABLE) return ohv_table(v)->size;
+    uint64_t n;
+    pack_find(v, NULL, UINT32_MAX, &n);
+    return n;
+}
+
+int
+ohv_get(const osv *v, const char *f, uint32_t flen, const char **val, uint64_t *vlen) {
+    if (v->enc == OSV_HASH_TABLE) {
+        ohash_t *s = otable_lookup(ohv_table(v), f, flen);
+        if (!s) return 0;
+        osv *fv = s->v;
+        *val = fv->d;
+        *vlen = fv->vlen;
+        return 1;
+    }
+    if (flen > OSV_HASH_PACK_VALUE) return 0;
+    const char *p = pack_find(v, f, flen, NULL);
+    if (!p) return 0;
+    *val = PK_VAL(p);
+    *vlen = PK_VLEN(p);
+    return 1;
+}
+
+/** 表中 field 的值: 放得下就原地覆盖 */
+static osv *
+field_value(osv *old, const char *val, uint64_t vlen) {
+    uint64_t room = old ? old->vlen + old->spare : 0;
+    if (old && room >= vlen) {
+        old->vlen = vlen;
+        old->spare = room - vlen;
+        memcpy(old->d, val, vlen);
+        return old;
+    }
+    osv *fv = malloc(sizeof(osv) + vlen);
+    if (!fv) return NULL;
+    fv->vlen = vlen;
+    fv->meta = 0;
+    memcpy(fv->d, val, vlen);
+    return fv;
+}
+
+static int
+table_set(otable_t *t, const char *f, uint32_t flen, const char *val, uint64_t vlen) {
+    ohash_t *s = otable_lookup(t, f, flen);
+    if (s) {
+        osv *fv = field_value(s->v, val, vlen);
+        if (!fv) return -ENOMEM;
+        if (fv != s->v) {
+            free(s->v);
+            s->v = fv;
+        }
+        return 0;
+    }
+    char *fdup = malloc(flen ? flen : 1);
+    osv *fv = field_value(NULL, val, vlen);
+    if (!fdup || !fv || otable_insert(t, memcpy(fdup, f, flen), flen, fv, NULL) < 0) {
+        free(fdup);
+        free(fv);
+        return -ENOMEM;
+    }
+    return 1;
+}
+
+/** PACK -> TABLE, 成功后释放原来的 PACK @return 新的 osv, NULL 表示 -ENOMEM (原值不变) */
+static osv *
+pack_to_table(osv *v, uint64_t count) {
+    osv *nv = malloc(sizeof(osv) + sizeof(otable_t));
+    if (!nv) return NULL;
+    nv->vlen = sizeof(otable_t);
+    nv->meta = 0;
+    nv->enc = OSV_HASH_TABLE;
+    // 预留到转换后再插入一批也不扩容
+    if (otable_init(ohv_table(nv), (count + 1) * 2 * LOAD_FACTOR_DENOMINATOR / LOAD_FACTOR_THRESHOLD) < 0) {
+        free(nv);
+        return NULL;
+    }
+    char *p = v->d, *end = p + v->vlen;
+    for (; p < end; p += PK_SIZE(p)) {
+        if (table_set(ohv_table(nv), PK_FIELD(p), PK_FLEN(p), PK_VAL(p), PK_VLEN(p)) < 0) {
+            ohv_free(nv);
+            return NULL;
+        }
+    }
+    free(v);
+    return nv;
+}
+
+/**
+ * PACK 的容量至少为 need
+ * 按 1.25 倍扩容: PACK 最多约 16KB, realloc 次数仍是对数级, 而余量浪费小得多
+ */
+static osv *
+pack_reserve(osv *v, uint64_t need) {
+    uint64_t room = v->vlen + v->spare;
+    if (need <= room) return v;
+    room = need < 32 ? 32 : need + (need >> 2);
+    osv *nv = realloc(v, sizeof(osv) + room);
+    if (!nv) return NULL;
+    nv->spare = room - nv->vlen;
+    return nv;
+}
+
+int
+ohv_set(osv **pv, const char *f, uint32_t flen, const char *val, uint64_t vlen) {
+    osv *v = *pv;
+    if (v->enc == OSV_HASH_TABLE) return table_set(ohv_table(v), f, flen, val, vlen);
+
+    uint64_t count;
+    char *p = NULL;
+    if (flen <= OSV_HASH_PACK_VALUE) p = pack_find(v, f, flen, &count);
+    else count = ohv_len(v);
+    if (flen > OSV_HASH_PACK_VALUE || vlen > OSV_HASH_PACK_VALUE || (!p && count >= OSV_HASH_PACK_ENTRIES)) {
+        osv *nv = pack_to_table(v, count);
+        if (!nv) return -ENOMEM;
+        *pv = nv;
+        return table_set(ohv_table(nv), f, flen, val, vlen);
+    }
+
+    if (p) {
+        uint64_t old = PK_VLEN(p);
+        if (old == vlen) {
+            memcpy(PK_VAL(p), val, vlen);
+            return 0;
+        }
+        uint64_t off = p - v->d;
+        if (vlen > old) {
+            if (!(v = pack_reserve(v, v->vlen + vlen - old))) return -ENOMEM;
+            *pv = v;
+            p = v->d + off;
+        }
+        char *tail = PK_VAL(p) + old;
+        memmove(PK_VAL(p) + vlen, tail, v->d + v->vlen - tail);
+        v->vlen = v->vlen + vlen - old;
+        v->spare = v->spare + old - vlen;
+        p[1 + flen] = (char) vlen;
+        memcpy(PK_VAL(p), val, vlen);
+        return 0;
+    }
+
+    uint64_t need = 2 + flen + vlen;
+    if (!(v = pack_reserve(v, v->vlen + need))) return -ENOMEM;
+    *pv = v;
+    p = v->d + v->vlen;
+    p[0] = (char) flen;
+    memcpy(p + 1, f, flen);
+    p[1 + flen] = (char) vlen;
+    memcpy(p + 2 + flen, val, vlen);
+    v->vlen += need;
+    v->spare -= need;
+    return 1;
+}
+
+int
+ohv_del(osv *v, const char *f, uint32_t flen) {
+    if (v->enc == OSV_HASH_TABLE) {
+        oret_t ot = {0};
+        otable_take(ohv_table(v), f, flen, &ot);
+        if (!ot.key) return 0;
+        free(ot.key);
+        free(ot.value);
+        return 1;
+    }
+    if (flen > OSV_HASH_PACK_VALUE) return 0;
+    char *p = pack_find(v, f, flen, NULL);
+    if (!p) return 0;
+    uint64_t sz = PK_SIZE(p);
+    memmove(p, p + sz, v->d + v->vlen - p - sz);
+    v->vlen -= sz;
+    v->spare += sz;
+    return 1;
+}
+
+int
+ohv_next(struct ohv_iter *it, const char **f, uint32_t *flen, const char **val, uint64_t *vlen) {
+    const osv *v = it->v;
+    if (v->enc == OSV_HASH_TABLE) {
+        const otable_t *t = ohv_table(v);
+        for (; it->pos < t->cap; it->pos++) {
+            const ohash_t *s = t->slots + it->pos;
+            if (!s->key || s->tb) continue;
+            const osv *fv = s->v;
+            *f = s->key;
+            *flen = s->keylen;
+            *val = fv->d;
+            *vlen = fv->vlen;
+            it->pos++;
+            return 1;
+        }
+        return 0;
+    }
+    if (it->pos >= v->vlen) return 0;
+    const char *p = v->d + it->pos;
+    *f = PK_FIELD(p);
+    *flen = PK_FLEN(p);
+    *val = PK_VAL(p);
+    *vlen = PK_VLEN(p);
+    it->pos += PK_SIZE(p);
+    return 1;
+}
@@ -0,0 +1,350 @@
+//
+// Created by weishen on 2025/11/14.
+//
+
+#include "osv_hll.h"
+#include "ocpu.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xxhash.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+uint32_t ohll_sparse_max = OHLL_SPARSE_MAX_DEFAULT;
+
+/** 与 ohashtable 的 H_SEED 错开, 寄存器的选择与表的 slot 无关 */
+#define OHLL_SEED 0xadc83b19ULL
+/** 去掉选寄存器的 P 位后剩下的位数, 寄存器值最大 Q + 1 */
+#define OHLL_Q (64 - OHLL_P)
+#define OHLL_ALPHA_INF 0.721347520444481703680
+
+#define OHLL_SPARSE_VAL_MAX 32
+#define OHLL_ZERO_MAX 64
+#define OHLL_HDR sizeof(uint64_t)
+
+#define hll_card(v) (*(uint64_t *) (v)->d)
+#define hll_regs(v) ((uint8_t *) (v)->d + OHLL_HDR)
+
+/*********************** 哈希与 dense 寄存器 ******************************/
+
+/** @return 寄存器下标, *val 为候选值 (1..Q+1) */
+static inline uint32_t hll_pos(const char *e, uint64_t len, uint8_t *val) {
+    uint64_t h = XXH64(e, len, OHLL_SEED);
+    uint32_t idx = (uint32_t) (h & (OHLL_REGS - 1));
+    h >>= OHLL_P;
+    h |= 1ULL << OHLL_Q; // 保证有一个 1, 值不超过 Q + 1
+    *val = (uint8_t) (__builtin_ctzll(h) + 1);
+    return idx;
+}
+
+static inline uint8_t dense_get(const uint8_t *p, uint32_t i) {
+    uint32_t b = i * OHLL_BITS / 8, fb = i * OHLL_BITS & 7;
+    return (uint8_t) (((uint32_t) p[b] >> fb | (uint32_t) p[b + 1] << (8 - fb)) & 63);
+}
+
+static inline void dense_set(uint8_t *p, uint32_t i, uint8_t val) {
+    uint32_t b = i * OHLL_BITS / 8, fb = i * OHLL_BITS & 7;
+    p[b] = (uint8_t) ((p[b] & ~(63U << fb)) | (uint32_t) val << fb);
+    p[b + 1] = (uint8_t) ((p[b + 1] & ~(63U >> (8 - fb))) | (uint32_t) val >> (8 - fb));
+}
+
+/** 3 字节正好是 4 个寄存器 */
+static void dense_unpack(const uint8_t *p, uint8_t *regs) {
+    for (uint32_t i = 0; i < OHLL_REGS; i += 4, p += 3) {
+        uint32_t x = (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16;
+        regs[i] = (uint8_t) (x & 63);
+        regs[i + 1] = (uint8_t) (x >> 6 & 63);
+        regs[i + 2] = (uint8_t) (x >> 12 & 63);
+        regs[i + 3] = (uint8_t) (x >> 18);
+    }
+}
+
+static void dense_pack(const uint8_t *regs, uint8_t *p) {
+    for (uint32_t i = 0; i < OHLL_REGS; i += 4, p += 3) {
+        uint32_t x = (uint32_t) regs[i] | (uint32_t) regs[i + 1] << 6 | (uint32_t) regs[i + 2] << 12 |
+                     (uint32_t) regs[i + 3] << 18;
+        p[0] = (uint8_t) x;
+        p[1] = (uint8_t) (x >> 8);
+        p[2] = (uint8_t) (x >> 16);
+    }
+}
+
+static osv *dense_new(void) {
+    osv *v = calloc(1, sizeof(osv) + OHLL_HDR + OHLL_DENSE_SIZE + 1);
+    if (!v) return NULL;
+    v->vlen = OHLL_HDR + OHLL_DENSE_SIZE + 1;
+    v->enc = OSV_HLL_DENSE;
+    hll_card(v) = OHLL_STALE;
+    return v;
+}
+
+/*********************** sparse ******************************/
+
+/** 解码一个操作码 @return 操作码的字节数 */
+static inline uint32_t sparse_op(const uint8_t *p, uint32_t *run, uint8_t *val) {
+    if (p[0] & 0x80) {
+        *val = (uint8_t) ((p[0] >> 2 & 0x1f) + 1);
+        *run = (p[0] & 3U) + 1;
+        return 1;
+    }
+    *val = 0;
+    if (p[0] & 0x40) {
+        *run = ((p[0] & 0x3fU) << 8 | p[1]) + 1;
+        return 2;
+    }
+    *run = (p[0] & 0x3fU) + 1;
+    return 1;
+}
+
+/** 写出 n 个值为 val 的寄存器 (VAL 时 n <= 4) @return 写入的字节数 */
+static inline uint32_t sparse_emit(uint8_t *p, uint8_t val, uint32_t n) {
+    if (val) {
+        p[0] = (uint8_t) (0x80 | (val - 1) << 2 | (n - 1));
+        return 1;
+    }
+    if (n <= OHLL_ZERO_MAX) {
+        p[0] = (uint8_t) (n - 1);
+        return 1;
+    }
+    p[0] = (uint8_t) (0x40 | (n - 1) >> 8);
+    p[1] = (uint8_t) (n - 1);
+    return 2;
+}
+
+osv *
+ohllv_new(void) {
+    osv *v = malloc(sizeof(osv) + OHLL_HDR + 2);
+    if (!v) return NULL;
+    v->vlen = OHLL_HDR;
+    v->meta = 0;
+    v->enc = OSV_HLL_SPARSE;
+    hll_card(v) = 0;
+    v->vlen += sparse_emit(hll_regs(v), 0, OHLL_REGS);
+    return v;
+}
+
+/** 转成 dense, 成功时释放原来的 sparse */
+static osv *sparse_to_dense(osv *v) {
+    osv *d = dense_new();
+    if (!d) return NULL;
+    const uint8_t *p = hll_regs(v), *end = (const uint8_t *) v->d + v->vlen;
+    uint8_t *regs = hll_regs(d);
+    uint32_t idx = 0, run;
+    uint8_t val;
+    while (p < end) {
+        p += sparse_op(p, &run, &val);
+        for (uint32_t k = 0; val && k < run; k++) dense_set(regs, idx + k, val);
+        idx += run;
+    }
+    d->ref = v->ref;
+    free(v);
+    return d;
+}
+
+/**
+ * 把覆盖 idx 的那个操作码拆成 [前段][VAL val 1][后段], 最多 5 字节
+ * @return 1 已修改, 0 没有变化, 2 需要转成 dense, -ENOMEM
+ */
+static int sparse_set(osv **pv, uint32_t idx, uint8_t val) {
+    osv *v = *pv;
+    uint8_t *p = hll_regs(v), *end = (uint8_t *) v->d + v->vlen;
+    uint32_t first = 0, run = 0, oplen = 0;
+    uint8_t cur = 0;
+    while (p < end) {
+        oplen = sparse_op(p, &run, &cur);
+        if (idx < first + run) break;
+        first += run;
+        p += oplen;
+    }
+    if (cur >= val) return 0;
+    if (val > OHLL_SPARSE_VAL_MAX) return 2;
+
+    uint8_t seq[5];
+    uint32_t n = 0, off = idx - first;
+    if (off) n += sparse_emit(seq + n, cur, off);
+    n += sparse_emit(seq + n, val, 1);
+    if (run - off - 1) n += sparse_emit(seq + n, cur, run - off - 1);
+    if (n > oplen && v->vlen - OHLL_HDR + n - oplen > ohll_sparse_max) return 2;
+
+    uint64_t pos = (uint64_t) (p - (uint8_t *) v->d), grow = n > oplen ? n - oplen : 0;
+    if (grow > v->spare) {
+        uint64_t cap = v->vlen + grow;
+        cap += cap / 2;
+        osv *nv = realloc(v, sizeof(osv) + cap);
+        if (!nv) return -ENOMEM;
+        v = *pv = nv;
+        v->spare = cap - v->vlen;
+        p = (uint8_t *) v->d + pos;
+        end = (uint8_t *) v->d + v->vlen;
+    }
+    memmove(p + n, p + oplen, (size_t) (end - p - oplen));
+    memcpy(p, seq, n);
+    v->vlen = v->vlen + n - oplen;
+    v->spare = v->spare + oplen - n;
+    return 1;
+}
+
+/*********************** 估算 ******************************/
+
+static double hll_sigma(double x) {
+    if (x == 1.) return INFINITY;
+    double zp, y = 1, z = x;
+    do {
+        x *= x;
+        zp = z;
+        z += x * y;
+        y += y;
+    } while (zp != z);
+    return z;
+}
+
+static double hll_tau(double x) {
+    if (x == 0. || x == 1.) return 0.;
+    double zp, y = 1.0, z = 1 - x;
+    do {
+        x = sqrt(x);
+        zp = z;
+        y *= 0.5;
+        z -= pow(1 - x, 2) * y;
+    } while (zp != z);
+    return z / 3;
+}
+
+/** Ertl, "New cardinality estimation algorithms for HyperLogLog sketches", 只依赖寄存器值的直方图 */
+static uint64_t hist_estimate(const uint32_t *hist) {
+    double m = OHLL_REGS;
+    double z = m * hll_tau((m - hist[OHLL_Q + 1]) / m);
+    for (int j = OHLL_Q; j >= 1; j--) {
+        z += hist[j];
+        z *= 0.5;
+    }
+    z += m * hll_sigma(hist[0] / m);
+    return (uint64_t) llroundl(OHLL_ALPHA_INF * m * m / z);
+}
+
+uint64_t
+ohll_estimate(const uint8_t *regs) {
+    uint32_t hist[64] = {0};
+    for (uint32_t i = 0; i < OHLL_REGS; i++) hist[regs[i]]++;
+    return hist_estimate(hist);
+}
+
+uint64_t
+ohllv_count(osv *v) {
+    if (!(hll_card(v) & OHLL_STALE)) return hll_card(v);
+    uint32_t hist[64] = {0};
+    const uint8_t *p = hll_regs(v);
+    if (v->enc == OSV_HLL_DENSE) {
+        for (uint32_t i = 0; i < OHLL_REGS; i += 4, p += 3) {
+            uint32_t x = (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16;
+            hist[x & 63]++;
+            hist[x >> 6 & 63]++;
+            hist[x >> 12 & 63]++;
+            hist[x >> 18]++;
+        }
+    } else {
+        const uint8_t *end = (const uint8_t *) v->d + v->vlen;
+        uint32_t run;
+        uint8_t val;
+        while (p < end) {
+            p += sparse_op(p, &run, &val);
+            hist[val] += run;
+        }
+    }
+    return hll_card(v) = hist_estimate(hist);
+}
+
+/*********************** 写入 / 合并 ******************************/
+
+int
+ohllv_add(osv **pv, const char *e, uint64_t len) {
+    osv *v = *pv;
+    uint8_t val;
+    uint32_t idx = hll_pos(e, len, &val);
+    if (v->enc == OSV_HLL_SPARSE) {
+        int ret = sparse_set(pv, idx, val);
+        v = *pv;
+        if (ret < 2) {
+            if (ret == 1) hll_card(v) |= OHLL_STALE;
+            return ret;
+        }
+        osv *d = sparse_to_dense(v);
+        if (!d) return -ENOMEM;
+        *pv = v = d;
+    }
+    uint8_t *regs = hll_regs(v);
+    if (dense_get(regs, idx) >= val) return 0;
+    dense_set(regs, idx, val);
+    hll_card(v) |= OHLL_STALE;
+    return 1;
+}
+
+#if defined(__x86_64__)
+/** 32 个寄存器一组 @return 已处理的字节数 */
+__attribute__((target("avx2")))
+static size_t max_avx2(uint8_t *dst, const uint8_t *src, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *) (dst + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *) (src + i));
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_max_epu8(a, b));
+    }
+    return i;
+}
+
+/** SSE2 是 x86-64 的基线, 不需要检测 */
+static size_t max_sse2(uint8_t *dst, const uint8_t *src, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128i b = _mm_loadu_si128((const __m128i *) (src + i));
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_max_epu8(a, b));
+    }
+    return i;
+}
+
+#endif
+
+void
+ohll_max(uint8_t *dst, const uint8_t *src, size_t n) {
+    size_t i = 0;
+#if defined(__x86_64__)
+    i = cpu_has_avx2() ? max_avx2(dst, src, n) : max_sse2(dst, src, n);
+#endif
+    for (; i < n; i++)
+        if (src[i] > dst[i]) dst[i] = src[i];
+}
+
+void
+ohllv_merge(const osv *v, uint8_t *regs) {
+    const uint8_t *p = hll_regs(v);
+    if (v->enc == OSV_HLL_DENSE) {
+        uint8_t tmp[OHLL_REGS];
+        dense_unpack(p, tmp);
+        ohll_max(regs, tmp, OHLL_REGS);
+        return;
+    }
+    // sparse 的非零寄存器很少, 直接逐个比较
+    const uint8_t *end = (const uint8_t *) v->d + v->vlen;
+    uint32_t idx = 0, run;
+    uint8_t val;
+    while (p < end) {
+        p += sparse_op(p, &run, &val);
+        for (uint32_t k = 0; val && k < run; k++)
+            if (regs[idx + k] < val) regs[idx + k] = val;
+        idx += run;
+    }
+}
+
+osv *
+ohllv_from_regs(const uint8_t *regs) {
+    osv *v = dense_new();
+    if (v) dense_pack(regs, hll_regs(v));
+    return v;
+}
@@ -0,0 +1,628 @@
+//
+// Created by weishen on 2025/11/17.
+//
+
+#include "osv_json.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*********************** 二进制格式 ******************************/
+
+static inline uint32_t rd32(const char *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline void wr32(char *p, uint32_t v) {
+    memcpy(p, &v, 4);
+}
+
+/** tag + size + count */
+#define OJ_HDR 9
+
+static uint64_t node_size(const char *p) {
+    switch (*p) {
+        case OJ_INT:
+        case OJ_DBL:
+            return 9;
+        case OJ_STR:
+            return 5 + (uint64_t) rd32(p + 1);
+        case OJ_ARR:
+        case OJ_OBJ:
+            return OJ_HDR + (uint64_t) rd32(p + 1);
+        default:
+            return 1;
+    }
+}
+
+static int buf_reserve(struct ojbuf *b, uint64_t n) {
+    if (b->len + n <= b->cap) return 0;
+    uint64_t cap = b->cap ? b->cap : 256;
+    while (cap < b->len + n) cap *= 2;
+    char *p = realloc(b->p, cap);
+    if (!p) return -ENOMEM;
+    b->p = p;
+    b->cap = cap;
+    return 0;
+}
+
+static inline int put(struct ojbuf *b, const void *s, uint64_t n) {
+    if (buf_reserve(b, n) < 0) return -ENOMEM;
+    memcpy(b->p + b->len, s, n);
+    b->len += n;
+    return 0;
+}
+
+static inline int putc_(struct ojbuf *b, char c) {
+    return put(b, &c, 1);
+}
+
+/*********************** 解析 ******************************/
+
+struct ojparser {
+    const char *s;
+    const char *end;
+    struct ojbuf *b;
+    int depth;
+};
+
+static inline void skip_ws(struct ojparser *ps) {
+    while (ps->s < ps->end && (*ps->s == ' ' || *ps->s == '\t' || *ps->s == '\n' || *ps->s == '\r')) ps->s++;
+}
+
+static int hex4(const char *s, uint32_t *out) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = s[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= c - '0';
+        else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') v |= (c | 0x20) - 'a' + 10;
+        else return -EINVAL;
+    }
+    *out = v;
+    return 0;
+}
+
+static int put_utf8(struct ojbuf *b, uint32_t cp) {
+    char u[4];
+    int n;
+    if (cp < 0x80) {
+        u[0] = (char) cp;
+        n = 1;
+    } else if (cp < 0x800) {
+        u[0] = (char) (0xc0 | cp >> 6);
+        u[1] = (char) (0x80 | (cp & 0x3f));
+        n = 2;
+    } else if (cp < 0x10000) {
+        u[0] = (char) (0xe0 | cp >> 12);
+        u[1] = (char) (0x80 | (cp >> 6 & 0x3f));
+        u[2] = (char) (0x80 | (cp & 0x3f));
+        n = 3;
+    } else {
+        u[0] = (char) (0xf0 | cp >> 18);
+        u[1] = (char) (0x80 | (cp >> 12 & 0x3f));
+        u[2] = (char) (0x80 | (cp >> 6 & 0x3f));
+        u[3] = (char) (0x80 | (cp & 0x3f));
+        n = 4;
+    }
+    return put(b, u, n);
+}
+
+/** ps->s 在开头的 '"' 上, 写出 [u32 len][bytes] */
+static int parse_string(struct ojparser *ps) {
+    struct ojbuf *b = ps->b;
+    uint64_t hdr = b->len;
+    if (put(b, "\0\0\0\0", 4) < 0) return -ENOMEM;
+    const char *s = ps->s + 1;
+    for (;;) {
+        // 没有转义的一段整体复制
+        const char *run = s;
+        while (s < ps->end && *s != '"' && *s != '\\' && (unsigned char) *s >= 0x20) s++;
+        if (put(b, run, s - run) < 0) return -ENOMEM;
+        if (s >= ps->end || (unsigned char) *s < 0x20) return -EINVAL;
+        if (*s == '"') break;
+        if (++s >= ps->end) return -EINVAL;
+        char c = *s++, e;
+        switch (c) {
+            case '"': e = '"'; break;
+            case '\\': e = '\\'; break;
+            case '/': e = '/'; break;
+            case 'b': e = '\b'; break;
+            case 'f': e = '\f'; break;
+            case 'n': e = '\n'; break;
+            case 'r': e = '\r'; break;
+            case 't': e = '\t'; break;
+            case 'u': {
+                uint32_t cp, lo;
+                if (ps->end - s < 4 || hex4(s, &cp) < 0) return -EINVAL;
+                s += 4;
+                if (cp >= 0xdc00 && cp <= 0xdfff) return -EINVAL;
+                if (cp >= 0xd800 && cp <= 0xdbff) {
+                    if (ps->end - s < 6 || s[0] != '\\' || s[1] != 'u' || hex4(s + 2, &lo) < 0) return -EINVAL;
+                    if (lo < 0xdc00 || lo > 0xdfff) return -EINVAL;
+                    s += 6;
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+                }
+                if (put_utf8(b, cp) < 0) return -ENOMEM;
+                continue;
+            }
+            default:
+                return -EINVAL;
+        }
+        if (putc_(b, e) < 0) return -ENOMEM;
+    }
+    uint64_t n = b->len - hdr - 4;
+    if (n > UINT32_MAX) return -EINVAL;
+    wr32(b->p + hdr, (uint32_t) n);
+    ps->s = s + 1;
+    return 0;
+}
+
+static int parse_number(struct ojparser *ps) {
+    const char *s = ps->s, *e = s;
+    int integral = 1;
+    if (e < ps->end && *e == '-') e++;
+    if (e >= ps->end || *e < '0' || *e > '9') return -EINVAL;
+    if (*e == '0') e++;
+    else
+        while (e < ps->end && *e >= '0' && *e <= '9') e++;
+    if (e < ps->end && *e == '.') {
+        integral = 0;
+        if (++e >= ps->end || *e < '0' || *e > '9') return -EINVAL;
+        while (e < ps->end && *e >= '0' && *e <= '9') e++;
+    }
+    if (e < ps->end && (*e == 'e' || *e == 'E')) {
+        integral = 0;
+        if (++e < ps->end && (*e == '+' || *e == '-')) e++;
+        if (e >= ps->end || *e < '0' || *e > '9') return -EINVAL;
+        while (e < ps->end && *e >= '0' && *e <= '9') e++;
+    }
+    ps->s = e;
+    char node[9];
+    int64_t i = 0;
+    int ok = integral, neg = *s == '-';
+    // 整数部分逐位累加, 溢出时改用 double
+    for (const char *d = s + neg; ok && d < e; d++) {
+        int digit = *d - '0';
+        if (neg ? __builtin_mul_overflow(i, 10, &i) || __builtin_sub_overflow(i, digit, &i)
+                : __builtin_mul_overflow(i, 10, &i) || __builtin_add_overflow(i, digit, &i))
+            ok = 0;
+    }
+    if (ok) {
+        node[0] = OJ_INT;
+        memcpy(node + 1, &i, 8);
+        return put(ps->b, node, 9);
+    }
+    char stack[64], *tmp = stack;
+    uint64_t n = e - s;
+    if (n >= sizeof(stack) && !(tmp = malloc(n + 1))) return -ENOMEM;
+    memcpy(tmp, s, n);
+    tmp[n] = '\0';
+    double d = strtod(tmp, NULL);
+    if (tmp != stack) free(tmp);
+    if (!isfinite(d)) return -EINVAL;
+    node[0] = OJ_DBL;
+    memcpy(node + 1, &d, 8);
+    return put(ps->b, node, 9);
+}
+
+static int parse_value(struct ojparser *ps);
+
+/** 数组和对象: 先占好 [tag][size][count], 元素写完再回填 */
+static int parse_container(struct ojparser *ps, char tag) {
+    struct ojbuf *b = ps->b;
+    char close = tag == OJ_ARR ? ']' : '}';
+    if (++ps->depth > OJSON_DEPTH_MAX) return -EINVAL;
+    uint64_t hdr = b->len;
+    char h[OJ_HDR] = {tag};
+    if (put(b, h, OJ_HDR) < 0) return -ENOMEM;
+    uint32_t count = 0;
+    ps->s++;
+    skip_ws(ps);
+    if (ps->s < ps->end && *ps->s == close) ps->s++;
+    else {
+        for (;;) {
+            int ret;
+            if (tag == OJ_OBJ) {
+                skip_ws(ps);
+                if (ps->s >= ps->end || *ps->s != '"') return -EINVAL;
+                if ((ret = parse_string(ps)) < 0) return ret;
+                skip_ws(ps);
+                if (ps->s >= ps->end || *ps->s != ':') return -EINVAL;
+                ps->s++;
+            }
+            if ((ret = parse_value(ps)) < 0) return ret;
+            if (++count == UINT32_MAX) return -EINVAL;
+            skip_ws(ps);
+            if (ps->s >= ps->end) return -EINVAL;
+            if (*ps->s == close) {
+                ps->s++;
+                break;
+            }
+            if (*ps->s++ != ',') return -EINVAL;
+        }
+    }
+    uint64_t size = b->len - hdr - OJ_HDR;
+    if (size > UINT32_MAX) return -EINVAL;
+    wr32(b->p + hdr + 1, (uint32_t) size);
+    wr32(b->p + hdr + 5, count);
+    ps->depth--;
+    return 0;
+}
+
+static int parse_literal(struct ojparser *ps, const char *lit, uint32_t n, char tag) {
+    if ((uint64_t) (ps->end - ps->s) < n || memcmp(ps->s, lit, n)) return -EINVAL;
+    ps->s += n;
+    return putc_(ps->b, tag);
+}
+
+static int parse_value(struct ojparser *ps) {
+    skip_ws(ps);
+    if (ps->s >= ps->end) return -EINVAL;
+    switch (*ps->s) {
+        case '{':
+            return parse_container(ps, OJ_OBJ);
+        case '[':
+            return parse_container(ps, OJ_ARR);
+        case '"':
+            if (putc_(ps->b, OJ_STR) < 0) return -ENOMEM;
+            return parse_string(ps);
+        case 't':
+            return parse_literal(ps, "true", 4, OJ_TRUE);
+        case 'f':
+            return parse_literal(ps, "false", 5, OJ_FALSE);
+        case 'n':
+            return parse_literal(ps, "null", 4, OJ_NULL);
+        default:
+            return parse_number(ps);
+    }
+}
+
+int
+ojson_parse(struct ojbuf *b, const char *s, uint64_t len) {
+    uint64_t start = b->len;
+    struct ojparser ps = {s, s + len, b, 0};
+    int ret = parse_value(&ps);
+    if (ret == 0) {
+        skip_ws(&ps);
+        if (ps.s != ps.end) ret = -EINVAL;
+    }
+    if (ret < 0) b->len = start;
+    return ret;
+}
+
+/*********************** 序列化 ******************************/
+
+static int dump_string(struct ojbuf *b, const char *s, uint32_t n) {
+    static const char hex[] = "0123456789abcdef";
+    if (putc_(b, '"') < 0) return -ENOMEM;
+    const char *end = s + n;
+    while (s < end) {
+        const char *run = s;
+        while (s < end && *s != '"' && *s != '\\' && (unsigned char) *s >= 0x20) s++;
+        if (put(b, run, s - run) < 0) return -ENOMEM;
+        if (s == end) break;
+        char esc[6] = {'\\'};
+        int len = 2;
+        switch (*s) {
+            case '"': esc[1] = '"'; break;
+            case '\\': esc[1] = '\\'; break;
+            case '\b': esc[1] = 'b'; break;
+            case '\f': esc[1] = 'f'; break;
+            case '\n': esc[1] = 'n'; break;
+            case '\r': esc[1] = 'r'; break;
+            case '\t': esc[1] = 't'; break;
+            default:
+                memcpy(esc + 1, "u00", 3);
+                esc[4] = hex[(unsigned char) *s >> 4];
+                esc[5] = hex[*s & 0xf];
+                len = 6;
+        }
+        if (put(b, esc, len) < 0) return -ENOMEM;
+        s++;
+    }
+    return putc_(b, '"');
+}
+
+/** 能还原出同一个 double 的最短表示, 整数值补 ".0" 以免再解析时变成整数 */
+static int dump_double(struct ojbuf *b, double d) {
+    char bf[40];
+    int n = 0;
+    for (int p = 15; p <= 17; p++) {
+        n = snprintf(bf, sizeof(bf), "%.*g", p, d);
+        if (strtod(bf, NULL) == d) break;
+    }
+    if (!strpbrk(bf, ".e")) {
+        memcpy(bf + n, ".0", 2);
+        n += 2;
+    }
+    return put(b, bf, n);
+}
+
+static int dump_node(struct ojbuf *b, const char *p) {
+    int64_t i;
+    double d;
+    char bf[24];
+    switch (*p) {
+        case OJ_NULL:
+            return put(b, "null", 4);
+        case OJ_FALSE:
+            return put(b, "false", 5);
+        case OJ_TRUE:
+            return put(b, "true", 4);
+        case OJ_INT:
+            memcpy(&i, p + 1, 8);
+            return put(b, bf, snprintf(bf, sizeof(bf), "%" PRId64, i));
+        case OJ_DBL:
+            memcpy(&d, p + 1, 8);
+            return dump_double(b, d);
+        case OJ_STR:
+            return dump_string(b, p + 5, rd32(p + 1));
+        default:
+            break;
+    }
+    int obj = *p == OJ_OBJ;
+    uint32_t count = rd32(p + 5);
+    const char *q = p + OJ_HDR;
+    if (putc_(b, obj ? '{' : '[') < 0) return -ENOMEM;
+    for (uint32_t k = 0; k < count; k++) {
+        if (k && putc_(b, ',') < 0) return -ENOMEM;
+        if (obj) {
+            uint32_t klen = rd32(q);
+            if (dump_string(b, q + 4, klen) < 0 || putc_(b, ':') < 0) return -ENOMEM;
+            q += 4 + klen;
+        }
+        if (dump_node(b, q) < 0) return -ENOMEM;
+        q += node_size(q);
+    }
+    return putc_(b, obj ? '}' : ']');
+}
+
+int
+ojson_dump(struct ojbuf *b, const char *node) {
+    uint64_t start = b->len;
+    int ret = dump_node(b, node);
+    if (ret < 0) b->len = start;
+    return ret;
+}
+
+int
+ojson_put(struct ojbuf *b, const void *s, uint64_t n) {
+    return put(b, s, n);
+}
+
+int
+ojson_put_string(struct ojbuf *b, const char *s, uint32_t n) {
+    uint64_t start = b->len;
+    int ret = dump_string(b, s, n);
+    if (ret < 0) b->len = start;
+    return ret;
+}
+
+/*********************** 路径 ******************************/
+
+int
+ojpath_parse(struct ojpath *p, const char *s, uint32_t len) {
+    const char *end = s + len;
+    p->n = 0;
+    p->dollar = len && *s == '$';
+    if (p->dollar) s++;
+    else if (len && *s != '.' && *s != '[') {
+        // 旧语法可以省略开头的 '.': a.b 等同于 .a.b
+        const char *e = s;
+        while (e < end && *e != '.' && *e != '[') e++;
+        p->s[p->n++] = (struct ojstep) {s, (uint32_t) (e - s), 0};
+        s = e;
+    } else if (len == 1 && *s == '.') return 0;
+    while (s < end) {
+        if (p->n == OJSON_DEPTH_MAX) return -EINVAL;
+        struct ojstep *st = &p->s[p->n++];
+        if (*s == '.') {
+            const char *e = ++s;
+            while (e < end && *e != '.' && *e != '[') e++;
+            if (e == s || (e - s == 1 && *s == '*')) return -EINVAL;
+            *st = (struct ojstep) {s, (uint32_t) (e - s), 0};
+            s = e;
+            continue;
+        }
+        if (*s != '[' || ++s >= end) return -EINVAL;
+        if (*s == '\'' || *s == '"') {
+            char q = *s++;
+            const char *e = memchr(s, q, end - s);
+            if (!e || e + 1 >= end || e[1] != ']') return -EINVAL;
+            *st = (struct ojstep) {s, (uint32_t) (e - s), 0};
+            s = e + 2;
+            continue;
+        }
+        const char *e = memchr(s, ']', end - s);
+        if (!e) return -EINVAL;
+        int64_t idx = 0;
+        int neg = *s == '-';
+        const char *d = s + neg;
+        if (d == e) return -EINVAL;
+        for (; d < e; d++) {
+            if (*d < '0' || *d > '9' || idx > (INT64_MAX - 9) / 10) return -EINVAL;
+            idx = idx * 10 + (*d - '0');
+        }
+        *st = (struct ojstep) {NULL, 0, neg ? -idx : idx};
+        s = e + 1;
+    }
+    return 0;
+}
+
+/** 下降的结果: 目标 node 的偏移, 以及路径上各个祖先容器的偏移 */
+struct ojcur {
+    uint64_t off;
+    uint64_t anc[OJSON_DEPTH_MAX + 1];
+    uint32_t nanc;
+    int missing; // 最后一步是 object 中不存在的 key, 此时 anc[nanc - 1] 是这个 object
+};
+
+/** @return 0 或 -ENOENT */
+static int resolve(const osv *v, const struct ojpath *path, struct ojcur *c) {
+    const char *d = v->d;
+    uint64_t off = 0;
+    c->nanc = 0;
+    c->missing = 0;
+    for (uint32_t i = 0; i < path->n; i++) {
+        const struct ojstep *st = &path->s[i];
+        const char *p = d + off, *q = p + OJ_HDR, *found = NULL;
+        uint32_t count;
+        if (st->key) {
+            if (*p != OJ_OBJ) return -ENOENT;
+            count = rd32(p + 5);
+            for (uint32_t k = 0; k < count && !found; k++) {
+                uint32_t klen = rd32(q);
+                const char *node = q + 4 + klen;
+                if (klen == st->klen && !memcmp(q + 4, st->key, klen)) found = node;
+                else q = node + node_size(node);
+            }
+            if (!found) {
+                if (i + 1 < path->n) return -ENOENT;
+                c->anc[c->nanc++] = off;
+                c->missing = 1;
+                return 0;
+            }
+        } else {
+            if (*p != OJ_ARR) return -ENOENT;
+            count = rd32(p + 5);
+            int64_t idx = st->idx < 0 ? st->idx + count : st->idx;
+            if (idx < 0 || idx >= count) return -ENOENT;
+            for (; idx > 0; idx--) q += node_size(q);
+            found = q;
+        }
+        c->anc[c->nanc++] = off;
+        off = found - d;
+    }
+    c->off = off;
+    return 0;
+}
+
+/*********************** 修改 ******************************/
+
+osv *
+ojsonv_new(const char *bin, uint64_t blen) {
+    osv *v = malloc(sizeof(osv) + blen);
+    if (!v) return NULL;
+    v->vlen = blen;
+    v->meta = 0;
+    v->enc = OSV_JSON;
+    memcpy(v->d, bin, blen);
+    return v;
+}
+
+const char *
+ojsonv_find(const osv *v, const struct ojpath *p) {
+    struct ojcur c;
+    if (resolve(v, p, &c) < 0 || c.missing) return NULL;
+    return v->d + c.off;
+}
+
+/**
+ * [at, at + old) 换成 len 字节的空位, 路径上的祖先 size += len - old
+ * 扩容按 1.25 倍, 同 OSV_HASH_PACK @return 空位的地址, NULL 表示失败 (*err, 文档不变)
+ */
+static char *
+splice(osv **pv, const uint64_t *anc, uint32_t nanc, uint64_t at, uint64_t old, uint64_t len, int *err) {
+    osv *v = *pv;
+    uint64_t vlen = v->vlen - old + len;
+    if (vlen > OSV_MAX_STRLEN) {
+        *err = -E2BIG;
+        return NULL;
+    }
+    uint64_t room = v->vlen + v->spare;
+    if (vlen > room) {
+        room = vlen + (vlen >> 2);
+        osv *nv = realloc(v, sizeof(osv) + room);
+        if (!nv) {
+            *err = -ENOMEM;
+            return NULL;
+        }
+        *pv = v = nv;
+    }
+    memmove(v->d + at + len, v->d + at + old, v->vlen - at - old);
+    for (uint32_t k = 0; k < nanc; k++) {
+        char *a = v->d + anc[k];
+        wr32(a + 1, (uint32_t) (rd32(a + 1) + len - old));
+    }
+    v->vlen = vlen;
+    v->spare = room - vlen;
+    return v->d + at;
+}
+
+int
+ojsonv_set(osv **pv, const struct ojpath *p, const char *bin, uint64_t blen, int flags) {
+    struct ojcur c;
+    int err = 0;
+    if (resolve(*pv, p, &c) < 0) return 0;
+    if (c.missing) {
+        if (flags & OJSON_XX) return 0;
+        // 新成员追加在 object 的末尾: [u32 klen][key][node]
+        const struct ojstep *st = &p->s[p->n - 1];
+        uint64_t obj = c.anc[c.nanc - 1], at = obj + node_size((*pv)->d + obj);
+        char *gap = splice(pv, c.anc, c.nanc, at, 0, 4 + st->klen + blen, &err);
+        if (!gap) return err;
+        wr32(gap, st->klen);
+        memcpy(gap + 4, st->key, st->klen);
+        memcpy(gap + 4 + st->klen, bin, blen);
+        char *o = (*pv)->d + obj;
+        wr32(o + 5, rd32(o + 5) + 1);
+        return 1;
+    }
+    if (flags & OJSON_NX) return 0;
+    char *gap = splice(pv, c.anc, c.nanc, c.off, node_size((*pv)->d + c.off), blen, &err);
+    if (!gap) return err;
+    memcpy(gap, bin, blen);
+    return 1;
+}
+
+int
+ojsonv_numincrby(osv *v, const struct ojpath *p, int by_int, int64_t i, double d, const char **node) {
+    struct ojcur c;
+    if (resolve(v, p, &c) < 0 || c.missing) return -ENOENT;
+    char *n = v->d + c.off;
+    if (*n != OJ_INT && *n != OJ_DBL) return -EINVAL;
+    int64_t cur_i;
+    double cur_d;
+    if (*n == OJ_INT) {
+        memcpy(&cur_i, n + 1, 8);
+        int64_t r;
+        if (by_int && !__builtin_add_overflow(cur_i, i, &r)) {
+            memcpy(n + 1, &r, 8);
+            *node = n;
+            return 0;
+        }
+        cur_d = (double) cur_i;
+    } else memcpy(&cur_d, n + 1, 8);
+    double r = cur_d + (by_int ? (double) i : d);
+    if (!isfinite(r)) return -ERANGE;
+    *n = OJ_DBL;
+    memcpy(n + 1, &r, 8);
+    *node = n;
+    return 0;
+}
+
+int64_t
+ojsonv_arrappend(osv **pv, const struct ojpath *p, const char *bin, uint64_t blen, uint32_t n) {
+    struct ojcur c;
+    int err = 0;
+    if (resolve(*pv, p, &c) < 0 || c.missing) return -ENOENT;
+    char *a = (*pv)->d + c.off;
+    if (*a != OJ_ARR) return -EINVAL;
+    if ((uint64_t) rd32(a + 5) + n >= UINT32_MAX) return -E2BIG;
+    // 数组自己也是要修正 size 的祖先
+    c.anc[c.nanc++] = c.off;
+    char *gap = splice(pv, c.anc, c.nanc, c.off + node_size(a), 0, blen, &err);
+    if (!gap) return err;
+    memcpy(gap, bin, blen);
+    a = (*pv)->d + c.off;
+    uint32_t count = rd32(a + 5) + n;
+    wr32(a + 5, count);
+    return count;
+}
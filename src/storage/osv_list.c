@@ -0,0 +1,361 @@
+//
+// Created by weishen on 2025/11/10.
+//
+
+#include "osv_list.h"
+#include "olzf.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+uint32_t olist_compress_depth = 0;
+
+#define ENT_BIG 0xFF
+#define OLIST_LZ_MIN 48 // 更小的节点压缩后省不下什么
+
+/*********************** entry ******************************/
+
+static inline uint64_t ent_size(uint64_t len) {
+    return len < 128 ? len + 2 : len + 10;
+}
+
+static void ent_write(char *w, const char *p, uint64_t len) {
+    if (len < 128) {
+        w[0] = (char) len;
+        memcpy(w + 1, p, len);
+        w[1 + len] = (char) len;
+        return;
+    }
+    uint32_t l = (uint32_t) len;
+    w[0] = (char) ENT_BIG;
+    memcpy(w + 1, &l, 4);
+    memcpy(w + 5, p, len);
+    memcpy(w + 5 + len, &l, 4);
+    w[9 + len] = (char) ENT_BIG;
+}
+
+/** 正向读 s 处的 entry @return 下一个 entry 的起点 */
+static inline const char *ent_fwd(const char *s, const char **p, uint64_t *len) {
+    if ((uint8_t) s[0] != ENT_BIG) {
+        *len = (uint8_t) s[0];
+        *p = s + 1;
+        return s + 2 + *len;
+    }
+    uint32_t l;
+    memcpy(&l, s + 1, 4);
+    *len = l;
+    *p = s + 5;
+    return s + 10 + l;
+}
+
+/** 反向读以 e 结尾的 entry @return 它的起点 */
+static inline const char *ent_back(const char *e, const char **p, uint64_t *len) {
+    if ((uint8_t) e[-1] != ENT_BIG) {
+        *len = (uint8_t) e[-1];
+        *p = e - 1 - *len;
+        return *p - 1;
+    }
+    uint32_t l;
+    memcpy(&l, e - 5, 4);
+    *len = l;
+    *p = e - 5 - l;
+    return *p - 5;
+}
+
+/*********************** node ******************************/
+
+static uint64_t node_cap_for(uint64_t need) {
+    if (need > OLIST_NODE_MAX) return need;
+    uint64_t c = OLIST_NODE_MIN;
+    while (c < need) c <<= 1;
+    return c;
+}
+
+static struct olnode *node_new(uint64_t cap) {
+    struct olnode *n = malloc(sizeof(struct olnode) + cap);
+    if (!n) return NULL;
+    memset(n, 0, sizeof(struct olnode));
+    n->cap = (uint32_t) cap;
+    return n;
+}
+
+/** n 被 realloc / 替换之后, 让邻居和 list 指向新地址 */
+static void relink(struct olist *l, struct olnode *n) {
+    if (n->prev) n->prev->next = n;
+    else l->head = n;
+    if (n->next) n->next->prev = n;
+    else l->tail = n;
+}
+
+static void unlink_node(struct olist *l, struct olnode *n) {
+    if (n->prev) n->prev->next = n->next;
+    else l->head = n->next;
+    if (n->next) n->next->prev = n->prev;
+    else l->tail = n->prev;
+    l->len -= n->count;
+    l->nodes--;
+    free(n);
+}
+
+/** @return 解压后的节点 (替换了 n), NULL 表示 -ENOMEM (n 不变) */
+static struct olnode *node_inflate(struct olist *l, struct olnode *n) {
+    uint64_t cap = node_cap_for(n->rawsz);
+    struct olnode *nn = malloc(sizeof(struct olnode) + cap);
+    if (!nn) return NULL;
+    memcpy(nn, n, sizeof(struct olnode));
+    if (olzf_decompress(n->d, n->hi, nn->d, cap) != n->rawsz) {
+        free(nn);
+        return NULL;
+    }
+    nn->cap = (uint32_t) cap;
+    nn->lo = 0;
+    nn->hi = n->rawsz;
+    nn->lz = 0;
+    nn->rawsz = 0;
+    relink(l, nn);
+    free(n);
+    return nn;
+}
+
+/** 压不小的节点保持原样 */
+static void node_deflate(struct olist *l, struct olnode *n) {
+    uint32_t raw = n->hi - n->lo;
+    if (n->lz || raw < OLIST_LZ_MIN || raw > OLIST_NODE_MAX) return;
+    char buf[OLIST_NODE_MAX];
+    size_t clen = olzf_compress(n->d + n->lo, raw, buf, raw - raw / 8);
+    if (!clen) return;
+    struct olnode *nn = malloc(sizeof(struct olnode) + clen);
+    if (!nn) return;
+    memcpy(nn, n, sizeof(struct olnode));
+    memcpy(nn->d, buf, clen);
+    nn->lz = 1;
+    nn->rawsz = raw;
+    nn->lo = 0;
+    nn->hi = nn->cap = (uint32_t) clen;
+    relink(l, nn);
+    free(n);
+}
+
+/**
+ * 节点增减之后调用: 两端 depth 个节点解压, 第 depth 个节点 (刚变成中间节点) 压缩
+ * depth == 0 时也保证两端节点不是压缩的
+ * 失败 (内存不足) 时只是少压缩 / 少解压一个中间节点, 迭代器两种都能读
+ */
+static void compress_fix(struct olist *l) {
+    uint32_t depth = olist_compress_depth;
+    uint32_t raw = depth ? depth : 1;
+    struct olnode *h = l->head, *t = l->tail;
+    for (uint32_t i = 0; i < raw && h; i++, h = h->next)
+        if (h->lz && !(h = node_inflate(l, h))) break;
+    for (uint32_t i = 0; i < raw && t; i++, t = t->prev)
+        if (t->lz && !(t = node_inflate(l, t))) break;
+    if (!depth || l->nodes < 2ULL * depth + 1) return;
+    // h / t 是距两端 depth 的节点, 节点数 >= 2 * depth + 1 时它们都不在另一端的范围内
+    if (h) node_deflate(l, h);
+    if (t && t != h) node_deflate(l, t);
+}
+
+/*********************** list ******************************/
+
+osv *
+olv_new(void) {
+    osv *v = malloc(sizeof(osv) + sizeof(struct olist));
+    if (!v) return NULL;
+    v->vlen = sizeof(struct olist);
+    v->meta = 0;
+    v->enc = OSV_LIST_QUICK;
+    memset(olv_list(v), 0, sizeof(struct olist));
+    return v;
+}
+
+void
+olv_clear(osv *v) {
+    struct olist *l = olv_list(v);
+    for (struct olnode *n = l->head, *next; n; n = next) {
+        next = n->next;
+        free(n);
+    }
+    memset(l, 0, sizeof(struct olist));
+}
+
+int
+olv_push(osv *v, int where, const char *p, uint64_t len) {
+    struct olist *l = olv_list(v);
+    uint64_t need = ent_size(len);
+    struct olnode *n = where == OLIST_HEAD ? l->head : l->tail;
+    int added = 0;
+    if (!n || (uint64_t) (n->hi - n->lo) + need > OLIST_NODE_MAX) {
+        if (!(n = node_new(node_cap_for(need)))) return -ENOMEM;
+        n->lo = n->hi = where == OLIST_HEAD ? n->cap : 0;
+        if (where == OLIST_HEAD) {
+            n->next = l->head;
+            if (l->head) l->head->prev = n;
+            else l->tail = n;
+            l->head = n;
+        } else {
+            n->prev = l->tail;
+            if (l->tail) l->tail->next = n;
+            else l->head = n;
+            l->tail = n;
+        }
+        l->nodes++;
+        added = 1;
+    } else if (where == OLIST_HEAD ? n->lo < need : n->cap - n->hi < need) {
+        // 增长的这一端没有余量: 先扩容 (几何级数), 再把数据挪到另一端
+        uint32_t used = n->hi - n->lo;
+        uint64_t ncap = n->cap;
+        while (ncap < used + need) ncap <<= 1;
+        if (ncap > n->cap) {
+            struct olnode *nn = realloc(n, sizeof(struct olnode) + ncap);
+            if (!nn) return -ENOMEM;
+            relink(l, nn);
+            n = nn;
+            n->cap = (uint32_t) ncap;
+        }
+        uint32_t nlo = where == OLIST_HEAD ? n->cap - used : 0;
+        memmove(n->d + nlo, n->d + n->lo, used);
+        n->lo = nlo;
+        n->hi = nlo + used;
+    }
+    if (where == OLIST_HEAD) {
+        n->lo -= (uint32_t) need;
+        ent_write(n->d + n->lo, p, len);
+    } else {
+        ent_write(n->d + n->hi, p, len);
+        n->hi += (uint32_t) need;
+    }
+    n->count++;
+    l->len++;
+    if (added) compress_fix(l);
+    return 0;
+}
+
+int
+olv_peek(const osv *v, int where, const char **p, uint64_t *len) {
+    const struct olist *l = olv_list(v);
+    if (!l->len) return 0;
+    if (where == OLIST_HEAD) ent_fwd(l->head->d + l->head->lo, p, len);
+    else ent_back(l->tail->d + l->tail->hi, p, len);
+    return 1;
+}
+
+int
+olv_pop(osv *v, int where) {
+    struct olist *l = olv_list(v);
+    struct olnode *n = where == OLIST_HEAD ? l->head : l->tail;
+    if (!n) return 0;
+    if (n->count == 1) {
+        // 邻居将成为新的一端, 先解压, 失败时 list 不变
+        struct olnode *nb = where == OLIST_HEAD ? n->next : n->prev;
+        if (nb && nb->lz && !node_inflate(l, nb)) return -ENOMEM;
+        unlink_node(l, n);
+        compress_fix(l);
+        return 0;
+    }
+    const char *p;
+    uint64_t len;
+    if (where == OLIST_HEAD) n->lo = (uint32_t) (ent_fwd(n->d + n->lo, &p, &len) - n->d);
+    else n->hi = (uint32_t) (ent_back(n->d + n->hi, &p, &len) - n->d);
+    n->count--;
+    l->len--;
+    return 0;
+}
+
+int
+olv_trim(osv *v, uint64_t head, uint64_t tail) {
+    struct olist *l = olv_list(v);
+    if (head + tail >= l->len) {
+        olv_clear(v);
+        return 0;
+    }
+    const char *p;
+    uint64_t len;
+    if (head) {
+        // 新的头节点先解压, 之后的操作不会失败
+        struct olnode *n = l->head;
+        uint64_t k = head;
+        while (k >= n->count) {
+            k -= n->count;
+            n = n->next;
+        }
+        if (n->lz && !(n = node_inflate(l, n))) return -ENOMEM;
+        while (l->head != n) unlink_node(l, l->head);
+        for (uint64_t i = 0; i < k; i++) n->lo = (uint32_t) (ent_fwd(n->d + n->lo, &p, &len) - n->d);
+        n->count -= (uint32_t) k;
+        l->len -= k;
+    }
+    if (tail) {
+        struct olnode *n = l->tail;
+        uint64_t k = tail;
+        while (k >= n->count) {
+            k -= n->count;
+            n = n->prev;
+        }
+        if (n->lz && !(n = node_inflate(l, n))) return -ENOMEM;
+        while (l->tail != n) unlink_node(l, l->tail);
+        for (uint64_t i = 0; i < k; i++) n->hi = (uint32_t) (ent_back(n->d + n->hi, &p, &len) - n->d);
+        n->count -= (uint32_t) k;
+        l->len -= k;
+    }
+    compress_fix(l);
+    return 0;
+}
+
+/*********************** iterator ******************************/
+
+static int iter_load(struct olv_iter *it, const struct olnode *n) {
+    it->node = n;
+    if (!n->lz) {
+        it->p = n->d + n->lo;
+        it->end = n->d + n->hi;
+        return 0;
+    }
+    if (!it->scratch && !(it->scratch = malloc(OLIST_NODE_MAX))) return -ENOMEM;
+    if (olzf_decompress(n->d, n->hi, it->scratch, OLIST_NODE_MAX) != n->rawsz) return -ENOMEM;
+    it->p = it->scratch;
+    it->end = it->scratch + n->rawsz;
+    return 0;
+}
+
+int
+olv_iter_init(struct olv_iter *it, const osv *v, uint64_t start) {
+    const struct olist *l = olv_list(v);
+    it->node = NULL;
+    it->p = it->end = NULL;
+    it->scratch = NULL;
+    if (start >= l->len) return 0;
+    // 从离 start 近的一端找节点
+    const struct olnode *n;
+    if (start < l->len / 2) {
+        for (n = l->head; start >= n->count; n = n->next) start -= n->count;
+    } else {
+        uint64_t from_tail = l->len - 1 - start;
+        for (n = l->tail; from_tail >= n->count; n = n->prev) from_tail -= n->count;
+        start = n->count - 1 - from_tail;
+    }
+    if (iter_load(it, n) < 0) {
+        olv_iter_release(it);
+        return -ENOMEM;
+    }
+    const char *p;
+    uint64_t len;
+    while (start--) it->p = ent_fwd(it->p, &p, &len);
+    return 0;
+}
+
+int
+olv_next(struct olv_iter *it, const char **p, uint64_t *len) {
+    while (it->p == it->end) {
+        if (!it->node || !it->node->next) return 0;
+        if (iter_load(it, it->node->next) < 0) return -ENOMEM;
+    }
+    it->p = ent_fwd(it->p, p, len);
+    return 1;
+}
+
+void
+olv_iter_release(struct olv_iter *it) {
+    free(it->scratch);
+    it->scratch = NULL;
+}
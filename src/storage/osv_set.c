@@ -0,0 +1,465 @@
+//
+// Created by weishen on 2025/11/12.
+//
+
+#include "osv_set.h"
+#include "ocpu.h"
+#include "cmd_.h"
+#include "resp2reply.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+uint32_t oset_intset_max = OSET_INTSET_MAX_DEFAULT;
+
+/*********************** 整数编码 ******************************/
+
+static inline int64_t iget(uint8_t enc, const char *d, uint64_t i) {
+    if (enc == OSV_SET_INT16) return ((const int16_t *) d)[i];
+    if (enc == OSV_SET_INT32) return ((const int32_t *) d)[i];
+    return ((const int64_t *) d)[i];
+}
+
+static inline void iput(uint8_t enc, char *d, uint64_t i, int64_t x) {
+    if (enc == OSV_SET_INT16) ((int16_t *) d)[i] = (int16_t) x;
+    else if (enc == OSV_SET_INT32) ((int32_t *) d)[i] = (int32_t) x;
+    else ((int64_t *) d)[i] = x;
+}
+
+/** 放得下 x 的最窄编码 */
+static inline uint8_t enc_for(int64_t x) {
+    if (x >= INT16_MIN && x <= INT16_MAX) return OSV_SET_INT16;
+    if (x >= INT32_MIN && x <= INT32_MAX) return OSV_SET_INT32;
+    return OSV_SET_INT64;
+}
+
+static inline uint64_t icount(const osv *v) {
+    return v->vlen / osetv_width(v);
+}
+
+/** 二分查找 @return 1 找到 (*pos 是下标), 0 不存在 (*pos 是插入位置) */
+static int ifind(const osv *v, int64_t x, uint64_t *pos) {
+    uint64_t lo = 0, hi = icount(v);
+    while (lo < hi) {
+        uint64_t mid = (lo + hi) >> 1;
+        int64_t y = iget(v->enc, v->d, mid);
+        if (y < x) lo = mid + 1;
+        else if (y > x) hi = mid;
+        else {
+            *pos = mid;
+            return 1;
+        }
+    }
+    *pos = lo;
+    return 0;
+}
+
+/** 按 1.25 倍扩容, 同 OSV_HASH_PACK */
+static osv *ireserve(osv *v, uint64_t need) {
+    uint64_t room = v->vlen + v->spare;
+    if (need <= room) return v;
+    room = need < 32 ? 32 : need + (need >> 2);
+    osv *nv = realloc(v, sizeof(osv) + room);
+    if (!nv) return NULL;
+    nv->spare = room - nv->vlen;
+    return nv;
+}
+
+/**
+ * 升级到 nenc 并加入 x: x 超出了原来的范围, 所以不是最小就是最大
+ * 从后往前展开, 新位置总在旧位置之后, 不会覆盖还没读的元素
+ */
+static osv *iupgrade(osv *v, uint8_t nenc, int64_t x) {
+    uint64_t n = icount(v), need = (n + 1) * (2U << (nenc & 0xF));
+    osv *nv = ireserve(v, need);
+    if (!nv) return NULL;
+    uint8_t oenc = nv->enc;
+    int front = x < 0;
+    for (uint64_t i = n; i-- > 0;) iput(nenc, nv->d, i + front, iget(oenc, nv->d, i));
+    iput(nenc, nv->d, front ? 0 : n, x);
+    nv->enc = nenc;
+    nv->spare = nv->vlen + nv->spare - need;
+    nv->vlen = need;
+    return nv;
+}
+
+/*********************** TABLE ******************************/
+
+static int table_add(otable_t *t, const char *m, uint32_t mlen) {
+    if (otable_lookup(t, m, mlen)) return 0;
+    char *dup = malloc(mlen ? mlen : 1);
+    if (!dup) return -ENOMEM;
+    memcpy(dup, m, mlen);
+    if (otable_insert(t, dup, mlen, NULL, NULL) < 0) {
+        free(dup);
+        return -ENOMEM;
+    }
+    return 1;
+}
+
+/** 整数编码 -> TABLE, 成功后释放原值 @return 新的 osv, NULL 表示 -ENOMEM (原值不变) */
+static osv *int_to_table(osv *v) {
+    uint64_t n = icount(v);
+    osv *nv = malloc(sizeof(osv) + sizeof(otable_t));
+    if (!nv) return NULL;
+    nv->vlen = sizeof(otable_t);
+    nv->meta = 0;
+    nv->enc = OSV_SET_TABLE;
+    if (otable_init(osetv_table(nv), (n + 1) * 2 * LOAD_FACTOR_DENOMINATOR / LOAD_FACTOR_THRESHOLD) < 0) {
+        free(nv);
+        return NULL;
+    }
+    char bf[24];
+    for (uint64_t i = 0; i < n; i++) {
+        if (table_add(osetv_table(nv), bf, ll2str(bf, iget(v->enc, v->d, i))) < 0) {
+            otable_destroy(osetv_table(nv), free);
+            free(nv);
+            return NULL;
+        }
+    }
+    free(v);
+    return nv;
+}
+
+/*********************** API ******************************/
+
+osv *
+osetv_new(void) {
+    osv *v = malloc(sizeof(osv));
+    if (!v) return NULL;
+    v->vlen = 0;
+    v->meta = 0;
+    v->enc = OSV_SET_INT16;
+    return v;
+}
+
+void
+osetv_clear(osv *v) {
+    if (v->enc == OSV_SET_TABLE) otable_destroy(osetv_table(v), free);
+}
+
+uint64_t
+osetv_len(const osv *v) {
+    return osetv_is_int(v) ? icount(v) : osetv_table(v)->size;
+}
+
+int
+osetv_has(const osv *v, const char *m, uint32_t mlen) {
+    if (!osetv_is_int(v)) return otable_lookup(osetv_table(v), m, mlen) != NULL;
+    int64_t x;
+    uint64_t pos;
+    if (string2ll(m, mlen, &x) < 0 || enc_for(x) > v->enc) return 0;
+    return ifind(v, x, &pos);
+}
+
+int
+osetv_add(osv **pv, const char *m, uint32_t mlen) {
+    osv *v = *pv;
+    if (!osetv_is_int(v)) return table_add(osetv_table(v), m, mlen);
+    int64_t x;
+    uint64_t pos = 0;
+    int isint = string2ll(m, mlen, &x) == 0;
+    if (isint && enc_for(x) <= v->enc && ifind(v, x, &pos)) return 0;
+    if (!isint || icount(v) >= oset_intset_max) {
+        osv *nv = int_to_table(v);
+        if (!nv) return -ENOMEM;
+        *pv = nv;
+        return table_add(osetv_table(nv), m, mlen);
+    }
+    if (enc_for(x) > v->enc) {
+        if (!(v = iupgrade(v, enc_for(x), x))) return -ENOMEM;
+        *pv = v;
+        return 1;
+    }
+    uint32_t w = osetv_width(v);
+    if (!(v = ireserve(v, v->vlen + w))) return -ENOMEM;
+    *pv = v;
+    memmove(v->d + (pos + 1) * w, v->d + pos * w, v->vlen - pos * w);
+    iput(v->enc, v->d, pos, x);
+    v->vlen += w;
+    v->spare -= w;
+    return 1;
+}
+
+int
+osetv_del(osv *v, const char *m, uint32_t mlen) {
+    if (!osetv_is_int(v)) {
+        oret_t ot = {0};
+        otable_take(osetv_table(v), m, mlen, &ot);
+        if (!ot.key) return 0;
+        free(ot.key);
+        return 1;
+    }
+    int64_t x;
+    uint64_t pos;
+    if (string2ll(m, mlen, &x) < 0 || enc_for(x) > v->enc || !ifind(v, x, &pos)) return 0;
+    uint32_t w = osetv_width(v);
+    memmove(v->d + pos * w, v->d + (pos + 1) * w, v->vlen - (pos + 1) * w);
+    v->vlen -= w;
+    v->spare += w;
+    return 1;
+}
+
+int
+osetv_next(struct osetv_iter *it, const char **m, uint32_t *mlen) {
+    const osv *v = it->v;
+    if (osetv_is_int(v)) {
+        if (it->pos >= icount(v)) return 0;
+        *mlen = (uint32_t) ll2str(it->bf, iget(v->enc, v->d, it->pos++));
+        *m = it->bf;
+        return 1;
+    }
+    const otable_t *t = osetv_table(v);
+    for (; it->pos < t->cap; it->pos++) {
+        const ohash_t *s = t->slots + it->pos;
+        if (!s->key || s->tb) continue;
+        *m = s->key;
+        *mlen = s->keylen;
+        it->pos++;
+        return 1;
+    }
+    return 0;
+}
+
+/*********************** 有序数组的交集 / 并集 ******************************/
+
+/**
+ * 标量版本: 无分支归并, 每步至少前进一个, out[k] 先写后判断, k 不超过 min(i, j)
+ * 一侧比另一侧小很多时改为在大的一侧上倍增查找 (galloping)
+ */
+#define OSET_SCALAR(T)                                                               \
+    static size_t inter_merge_##T(const T *a, size_t na, const T *b, size_t nb, T *out) { \
+        size_t i = 0, j = 0, k = 0;                                                  \
+        while (i < na && j < nb) {                                                   \
+            T x = a[i], y = b[j];                                                    \
+            out[k] = x;                                                              \
+            k += x == y;                                                             \
+            i += x <= y;                                                             \
+            j += y <= x;                                                             \
+        }                                                                            \
+        return k;                                                                    \
+    }                                                                                \
+    static size_t inter_gallop_##T(const T *a, size_t na, const T *b, size_t nb, T *out) { \
+        size_t j = 0, k = 0;                                                         \
+        for (size_t i = 0; i < na && j < nb; i++) {                                  \
+            T x = a[i];                                                              \
+            size_t step = 1, lo = j, hi = j;                                         \
+            while (hi < nb && b[hi] < x) {                                           \
+                lo = hi + 1;                                                         \
+                hi += step;                                                          \
+                step <<= 1;                                                          \
+            }                                                                        \
+            if (hi > nb) hi = nb;                                                    \
+            while (lo < hi) {                                                        \
+                size_t mid = (lo + hi) >> 1;                                         \
+                if (b[mid] < x) lo = mid + 1;                                        \
+                else hi = mid;                                                       \
+            }                                                                        \
+            j = lo;                                                                  \
+            if (j < nb && b[j] == x) out[k++] = x;                                   \
+        }                                                                            \
+        return k;                                                                    \
+    }                                                                                \
+    static size_t union_merge_##T(const T *a, size_t na, const T *b, size_t nb, T *out) { \
+        size_t i = 0, j = 0, k = 0;                                                  \
+        while (i < na && j < nb) {                                                   \
+            T x = a[i], y = b[j];                                                    \
+            out[k++] = x < y ? x : y;                                                \
+            i += x <= y;                                                             \
+            j += y <= x;                                                             \
+        }                                                                            \
+        memcpy(out + k, a + i, (na - i) * sizeof(T));                                \
+        k += na - i;                                                                 \
+        memcpy(out + k, b + j, (nb - j) * sizeof(T));                                \
+        return k + nb - j;                                                           \
+    }
+
+OSET_SCALAR(int16_t)
+OSET_SCALAR(int32_t)
+OSET_SCALAR(int64_t)
+
+#define OSET_GALLOP_RATIO 32
+
+#if defined(__x86_64__)
+/**
+ * SIMD 版本 (Schlegel / Lemire 的块比较):
+ * a, b 各取一个块, 块内所有元素两两比较得到 a 中命中的掩码;
+ * 块尾较小的一侧前进 (相等时两侧都前进), 剩下不足一块的部分用标量归并
+ */
+__attribute__((target("sse4.2")))
+static size_t inter16_sse42(const int16_t *a, size_t na, const int16_t *b, size_t nb, int16_t *out) {
+    size_t i = 0, j = 0, k = 0;
+    while (i + 8 <= na && j + 8 <= nb) {
+        __m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *) (b + j));
+        // 8 x 8 个 16 位元素一条指令比完: va 中每个元素是否等于 vb 中任一个
+        __m128i r = _mm_cmpestrm(vb, 8, va, 8, _SIDD_UWORD_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK);
+        unsigned mask = (unsigned) _mm_cvtsi128_si32(r);
+        int16_t amax = a[i + 7], bmax = b[j + 7], blk[8];
+        _mm_storeu_si128((__m128i *) blk, va);
+        for (; mask; mask &= mask - 1) out[k++] = blk[__builtin_ctz(mask)];
+        i += amax <= bmax ? 8 : 0;
+        j += bmax <= amax ? 8 : 0;
+    }
+    return k + inter_merge_int16_t(a + i, na - i, b + j, nb - j, out + k);
+}
+
+/** 掩码 -> permutevar8x32 的下标, 把命中的 32 位元素挤到低位 (64 位元素占两个下标) */
+static int32_t compress32[256][8], compress64[16][8];
+
+static void compress_init(void) {
+    for (int m = 0; m < 256; m++)
+        for (int b = 0, k = 0; b < 8; b++)
+            if (m >> b & 1) compress32[m][k++] = b;
+    for (int m = 0; m < 16; m++)
+        for (int b = 0, k = 0; b < 4; b++)
+            if (m >> b & 1) {
+                compress64[m][k++] = 2 * b;
+                compress64[m][k++] = 2 * b + 1;
+            }
+}
+
+/**
+ * 命中的元素用一次 permute 挤到一起, 整块写出再按 popcount 前进
+ * 最多写到 out + k + 8, k <= min(i, j) 所以不会超出 out 的容量
+ */
+__attribute__((target("avx2")))
+static size_t inter32_avx2(const int32_t *a, size_t na, const int32_t *b, size_t nb, int32_t *out) {
+    size_t i = 0, j = 0, k = 0;
+    while (i + 8 <= na && j + 8 <= nb) {
+        __m256i va = _mm256_loadu_si256((const __m256i *) (a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *) (b + j));
+        // lane 内轮转 3 次, 交换两个 lane 后再轮转 3 次, 8 次比较覆盖 8 x 8 的所有组合
+        __m256i vs = _mm256_permute2x128_si256(vb, vb, 1);
+        __m256i eq = _mm256_or_si256(
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi32(va, vb),
+                                            _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vb, 0x39))),
+                            _mm256_or_si256(_mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vb, 0x4e)),
+                                            _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vb, 0x93)))),
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi32(va, vs),
+                                            _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vs, 0x39))),
+                            _mm256_or_si256(_mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vs, 0x4e)),
+                                            _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vs, 0x93)))));
+        unsigned mask = (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+        int32_t amax = a[i + 7], bmax = b[j + 7];
+        __m256i idx = _mm256_loadu_si256((const __m256i *) compress32[mask]);
+        _mm256_storeu_si256((__m256i *) (out + k), _mm256_permutevar8x32_epi32(va, idx));
+        k += (size_t) __builtin_popcount(mask);
+        i += amax <= bmax ? 8 : 0;
+        j += bmax <= amax ? 8 : 0;
+    }
+    return k + inter_merge_int32_t(a + i, na - i, b + j, nb - j, out + k);
+}
+
+__attribute__((target("avx2")))
+static size_t inter64_avx2(const int64_t *a, size_t na, const int64_t *b, size_t nb, int64_t *out) {
+    size_t i = 0, j = 0, k = 0;
+    while (i + 4 <= na && j + 4 <= nb) {
+        __m256i va = _mm256_loadu_si256((const __m256i *) (a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *) (b + j));
+        __m256i eq = _mm256_cmpeq_epi64(va, vb);
+        for (int r = 1; r < 4; r++) {
+            vb = _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0, 3, 2, 1));
+            eq = _mm256_or_si256(eq, _mm256_cmpeq_epi64(va, vb));
+        }
+        unsigned mask = (unsigned) _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+        int64_t amax = a[i + 3], bmax = b[j + 3];
+        __m256i idx = _mm256_loadu_si256((const __m256i *) compress64[mask]);
+        _mm256_storeu_si256((__m256i *) (out + k), _mm256_permutevar8x32_epi32(va, idx));
+        k += (size_t) __builtin_popcount(mask);
+        i += amax <= bmax ? 4 : 0;
+        j += bmax <= amax ? 4 : 0;
+    }
+    return k + inter_merge_int64_t(a + i, na - i, b + j, nb - j, out + k);
+}
+
+/** permute 用的压缩表在第一次走 AVX2 内核前建好 */
+static int avx2_ready(void) {
+    static int ready = -1;
+    if (ready < 0 && (ready = cpu_has_avx2())) compress_init();
+    return ready;
+}
+#endif
+
+/** 大小悬殊时 galloping, 小的一侧放在 a */
+#define OSET_INTER_DISPATCH(T, simd, feature)                                        \
+    if (na * OSET_GALLOP_RATIO < nb) return inter_gallop_##T(a, na, b, nb, out);     \
+    if (nb * OSET_GALLOP_RATIO < na) return inter_gallop_##T(b, nb, a, na, out);     \
+    OSET_SIMD_CALL(simd, feature)                                                    \
+    return inter_merge_##T(a, na, b, nb, out);
+
+#if defined(__x86_64__)
+#define OSET_SIMD_CALL(simd, feature)                                                \
+    if (feature) return simd(a, na, b, nb, out);
+#else
+#define OSET_SIMD_CALL(simd, feature)
+#endif
+
+size_t
+oset_inter16(const int16_t *a, size_t na, const int16_t *b, size_t nb, int16_t *out) {
+    OSET_INTER_DISPATCH(int16_t, inter16_sse42, cpu_has_sse42())
+}
+
+size_t
+oset_inter32(const int32_t *a, size_t na, const int32_t *b, size_t nb, int32_t *out) {
+    OSET_INTER_DISPATCH(int32_t, inter32_avx2, avx2_ready())
+}
+
+size_t
+oset_inter64(const int64_t *a, size_t na, const int64_t *b, size_t nb, int64_t *out) {
+    OSET_INTER_DISPATCH(int64_t, inter64_avx2, avx2_ready())
+}
+
+/** v 的元素展开到 enc 的宽度 (enc 不窄于 v->enc), 已经是这个宽度时不复制 @return NULL 表示 -ENOMEM */
+static const char *iwiden(const osv *v, uint8_t enc, char **tmp) {
+    *tmp = NULL;
+    if (v->enc == enc) return v->d;
+    uint64_t n = icount(v);
+    if (!(*tmp = malloc(n * (2U << (enc & 0xF)) + 1))) return NULL;
+    for (uint64_t i = 0; i < n; i++) iput(enc, *tmp, i, iget(v->enc, v->d, i));
+    return *tmp;
+}
+
+/** 两个整数集合按较宽的编码对齐后调用 op */
+static osv *icombine(const osv *a, const osv *b, int is_union) {
+    uint8_t enc = a->enc > b->enc ? a->enc : b->enc;
+    uint32_t w = 2U << (enc & 0xF);
+    uint64_t na = icount(a), nb = icount(b);
+    uint64_t cap = is_union ? na + nb : (na < nb ? na : nb);
+    char *ta, *tb;
+    const char *da = iwiden(a, enc, &ta), *db = iwiden(b, enc, &tb);
+    osv *r = da && db ? malloc(sizeof(osv) + cap * w) : NULL;
+    if (r) {
+        size_t n;
+        r->meta = 0;
+        r->enc = enc;
+        if (enc == OSV_SET_INT16)
+            n = is_union ? union_merge_int16_t((const int16_t *) da, na, (const int16_t *) db, nb, (int16_t *) r->d)
+                         : oset_inter16((const int16_t *) da, na, (const int16_t *) db, nb, (int16_t *) r->d);
+        else if (enc == OSV_SET_INT32)
+            n = is_union ? union_merge_int32_t((const int32_t *) da, na, (const int32_t *) db, nb, (int32_t *) r->d)
+                         : oset_inter32((const int32_t *) da, na, (const int32_t *) db, nb, (int32_t *) r->d);
+        else
+            n = is_union ? union_merge_int64_t((const int64_t *) da, na, (const int64_t *) db, nb, (int64_t *) r->d)
+                         : oset_inter64((const int64_t *) da, na, (const int64_t *) db, nb, (int64_t *) r->d);
+        r->vlen = n * w;
+        r->spare = (cap - n) * w;
+    }
+    free(ta);
+    free(tb);
+    return r;
+}
+
+osv *
+osetv_inter_int(const osv *a, const osv *b) {
+    return icombine(a, b, 0);
+}
+
+osv *
+osetv_union_int(const osv *a, const osv *b) {
+    return icombine(a, b, 1);
+}
@@ -0,0 +1,243 @@
+//
+// Created by weishen on 2025/11/15.
+//
+
+#include "osv_sketch.h"
+#include "ocpu.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xxhash.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+uint64_t
+osketch_hash(const char *e, uint64_t len) {
+    return XXH3_64bits(e, len);
+}
+
+/** 第 i 行的列: (h1 + i * h2) 乘法取模, h2 是奇数 */
+static inline uint32_t col_of(uint32_t h1, uint32_t h2, uint32_t i, uint32_t width) {
+    return (uint32_t) (((uint64_t) (h1 + i * h2) * width) >> 32);
+}
+
+#define H1(h) ((uint32_t) (h))
+#define H2(h) ((uint32_t) ((h) >> 32) | 1U)
+
+/*********************** Count-Min Sketch ******************************/
+
+osv *
+ocmsv_new(uint32_t width, uint32_t depth) {
+    uint64_t n = (uint64_t) width * depth;
+    osv *v = calloc(1, sizeof(osv) + sizeof(struct ocms) + n * sizeof(uint32_t));
+    if (!v) return NULL;
+    v->vlen = sizeof(struct ocms) + n * sizeof(uint32_t);
+    v->enc = OSV_CMS;
+    ocmsv_cms(v)->width = width;
+    ocmsv_cms(v)->depth = depth;
+    return v;
+}
+
+int
+ocms_dims(double error, double prob, uint32_t *width, uint32_t *depth) {
+    double w = ceil(2 / error), d = ceil(log(prob) / log(0.5));
+    if (d < 1) d = 1;
+    if (d > OCMS_DEPTH_MAX || w * d >= (double) INT32_MAX) return -EINVAL;
+    *width = (uint32_t) w;
+    *depth = (uint32_t) d;
+    return 0;
+}
+
+void
+ocmsv_prefetch(const osv *v, uint64_t h) {
+    const struct ocms *s = ocmsv_cms(v);
+    for (uint32_t i = 0; i < s->depth; i++)
+        __builtin_prefetch(s->c + (uint64_t) i * s->width + col_of(H1(h), H2(h), i, s->width));
+}
+
+uint32_t
+ocmsv_incrby(osv *v, uint64_t h, uint32_t by) {
+    struct ocms *s = ocmsv_cms(v);
+    uint32_t min = UINT32_MAX;
+    for (uint32_t i = 0; i < s->depth; i++) {
+        uint32_t *c = s->c + (uint64_t) i * s->width + col_of(H1(h), H2(h), i, s->width);
+        *c = *c > UINT32_MAX - by ? UINT32_MAX : *c + by;
+        if (*c < min) min = *c;
+    }
+    s->count += by;
+    return min;
+}
+
+static uint32_t query_scalar(const struct ocms *s, uint64_t h) {
+    uint32_t min = UINT32_MAX;
+    for (uint32_t i = 0; i < s->depth; i++) {
+        uint32_t c = s->c[(uint64_t) i * s->width + col_of(H1(h), H2(h), i, s->width)];
+        if (c < min) min = c;
+    }
+    return min;
+}
+
+#if defined(__x86_64__)
+/**
+ * 8 行一组: 列下标 (32x32 -> 高 32 位的乘法取模, 奇偶 lane 各一次 vpmuludq) 和
+ * 行偏移在向量里算出, 一次 vpgatherdd 取回 8 个计数器, 超出 depth 的 lane 不读, 按 UINT32_MAX 参与 min
+ */
+__attribute__((target("avx2")))
+static uint32_t query_avx2(const struct ocms *s, uint64_t h) {
+    const __m256i h1 = _mm256_set1_epi32((int) H1(h)), h2 = _mm256_set1_epi32((int) H2(h));
+    const __m256i w = _mm256_set1_epi32((int) s->width), depth = _mm256_set1_epi32((int) s->depth);
+    const __m256i ones = _mm256_set1_epi32(-1);
+    __m256i best = ones;
+    for (uint32_t r = 0; r < s->depth; r += 8) {
+        __m256i rows = _mm256_add_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32((int) r));
+        __m256i x = _mm256_add_epi32(h1, _mm256_mullo_epi32(rows, h2));
+        __m256i even = _mm256_mul_epu32(x, w);
+        __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), w);
+        __m256i col = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+        __m256i idx = _mm256_add_epi32(_mm256_mullo_epi32(rows, w), col);
+        __m256i active = _mm256_cmpgt_epi32(depth, rows);
+        __m256i got = _mm256_mask_i32gather_epi32(ones, (const int *) s->c, idx, active, 4);
+        best = _mm256_min_epu32(best, got);
+    }
+    __m128i m = _mm_min_epu32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+    m = _mm_min_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_min_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t) _mm_cvtsi128_si32(m);
+}
+
+#endif
+
+uint32_t
+ocmsv_query(const osv *v, uint64_t h) {
+#if defined(__x86_64__)
+    if (cpu_has_avx2()) return query_avx2(ocmsv_cms(v), h);
+#endif
+    return query_scalar(ocmsv_cms(v), h);
+}
+
+/*********************** Top-K ******************************/
+
+osv *
+otopkv_new(uint32_t k, uint32_t width, uint32_t depth, double decay) {
+    uint64_t nb = (uint64_t) width * depth;
+    uint64_t n = sizeof(struct otopk) + nb * sizeof(struct otopk_bucket) + (uint64_t) k * sizeof(struct otopk_item);
+    osv *v = calloc(1, sizeof(osv) + n);
+    if (!v) return NULL;
+    v->vlen = n;
+    v->enc = OSV_TOPK;
+    struct otopk *tk = otopkv_tk(v);
+    tk->k = k;
+    tk->width = width;
+    tk->depth = depth;
+    tk->decay = decay;
+    tk->rng = 0x9e3779b97f4a7c15ULL;
+    tk->decay_pow[0] = 1;
+    for (int i = 1; i < OTOPK_DECAY_TABLE; i++) tk->decay_pow[i] = tk->decay_pow[i - 1] * decay;
+    return v;
+}
+
+void
+otopkv_clear(osv *v) {
+    struct otopk *tk = otopkv_tk(v);
+    struct otopk_item *heap = otopk_heap(tk);
+    for (uint32_t i = 0; i < tk->k; i++) {
+        free(heap[i].item);
+        heap[i].item = NULL;
+    }
+}
+
+/** [0, 1) 的均匀随机数, xorshift64* */
+static inline double rand_unit(uint64_t *s) {
+    uint64_t x = *s;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *s = x;
+    return (double) ((x * 0x2545f4914f6cdd1dULL) >> 11) * 0x1.0p-53;
+}
+
+static inline double decay_of(const struct otopk *tk, uint32_t count) {
+    if (count < OTOPK_DECAY_TABLE) return tk->decay_pow[count];
+    const uint32_t last = OTOPK_DECAY_TABLE - 1;
+    return pow(tk->decay_pow[last], count / last) * tk->decay_pow[count % last];
+}
+
+/** 元素 j 的计数变化后恢复小顶堆 */
+static void heap_fix(struct otopk_item *heap, uint32_t k, uint32_t j) {
+    struct otopk_item cur = heap[j];
+    while (j > 0 && heap[(j - 1) / 2].count > cur.count) {
+        heap[j] = heap[(j - 1) / 2];
+        j = (j - 1) / 2;
+    }
+    for (;;) {
+        uint32_t c = 2 * j + 1;
+        if (c >= k) break;
+        if (c + 1 < k && heap[c + 1].count < heap[c].count) c++;
+        if (heap[c].count >= cur.count) break;
+        heap[j] = heap[c];
+        j = c;
+    }
+    heap[j] = cur;
+}
+
+int
+otopkv_add(osv *v, const char *e, uint32_t len, uint64_t h, char **expelled, uint32_t *elen) {
+    struct otopk *tk = otopkv_tk(v);
+    struct otopk_item *heap = otopk_heap(tk);
+    uint32_t fp = (uint32_t) (h >> 32), h1 = H1(h), h2 = (uint32_t) ((h * 0x9e3779b97f4a7c15ULL) >> 32) | 1U;
+    uint64_t est = 0;
+    for (uint32_t i = 0; i < tk->depth; i++) {
+        struct otopk_bucket *b = tk->b + (uint64_t) i * tk->width + col_of(h1, h2, i, tk->width);
+        if (!b->count) {
+            b->fp = fp;
+            b->count = 1;
+        } else if (b->fp == fp) {
+            if (b->count < UINT32_MAX) b->count++;
+        } else if (rand_unit(&tk->rng) < decay_of(tk, b->count) && !--b->count) {
+            b->fp = fp; // 衰减到 0, 桶换成新元素
+            b->count = 1;
+        }
+        if (b->fp == fp && b->count > est) est = b->count;
+    }
+    if (!est || est < heap[0].count) return 0;
+
+    for (uint32_t j = 0; j < tk->k; j++) {
+        if (heap[j].item && heap[j].fp == fp && heap[j].len == len && !memcmp(heap[j].item, e, len)) {
+            heap[j].count = est;
+            heap_fix(heap, tk->k, j);
+            return 0;
+        }
+    }
+    char *dup = malloc(len ? len : 1);
+    if (!dup) return -ENOMEM;
+    memcpy(dup, e, len);
+    struct otopk_item old = heap[0];
+    heap[0] = (struct otopk_item) {dup, len, fp, est};
+    heap_fix(heap, tk->k, 0);
+    if (!old.item) return 0;
+    *expelled = old.item;
+    *elen = old.len;
+    return 1;
+}
+
+static int cmp_count_desc(const void *a, const void *b) {
+    uint64_t x = (*(const struct otopk_item *const *) a)->count;
+    uint64_t y = (*(const struct otopk_item *const *) b)->count;
+    return (x < y) - (x > y);
+}
+
+uint32_t
+otopkv_list(const osv *v, const struct otopk_item **out) {
+    const struct otopk *tk = otopkv_tk(v);
+    const struct otopk_item *heap = otopk_heap(tk);
+    uint32_t n = 0;
+    for (uint32_t j = 0; j < tk->k; j++)
+        if (heap[j].item) out[n++] = heap + j;
+    qsort(out, n, sizeof(*out), cmp_count_desc);
+    return n;
+}
@@ -0,0 +1,457 @@
+//
+// Created by weishen on 2025/11/16.
+//
+
+#include "osv_stream.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NODE_CAP_MIN 256
+
+/*********************** varint (LEB128) ******************************/
+
+static inline uint32_t varint_size(uint64_t v) {
+    uint32_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static inline uint8_t *varint_put(uint8_t *p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t) (v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t) v;
+    return p;
+}
+
+static inline const uint8_t *varint_get(const uint8_t *p, uint64_t *v) {
+    uint64_t r = 0;
+    for (uint32_t shift = 0;; shift += 7) {
+        uint8_t b = *p++;
+        r |= (uint64_t) (b & 0x7f) << shift;
+        if (b < 0x80) break;
+    }
+    *v = r;
+    return p;
+}
+
+static inline uint8_t *str_put(uint8_t *p, const struct ostream_str *s) {
+    p = varint_put(p, s->len);
+    memcpy(p, s->p, s->len);
+    return p + s->len;
+}
+
+static inline const uint8_t *str_get(const uint8_t *p, struct ostream_str *s) {
+    uint64_t len;
+    p = varint_get(p, &len);
+    s->p = (const char *) p;
+    s->len = (uint32_t) len;
+    return p + len;
+}
+
+static inline const uint8_t *str_skip(const uint8_t *p) {
+    uint64_t len;
+    p = varint_get(p, &len);
+    return p + len;
+}
+
+/*********************** 节点 ******************************/
+
+/** 字段名与节点的主字段表相同 */
+static int same_fields(const struct osnode *n, const struct ostream_str *fv, uint32_t nfields) {
+    uint64_t cnt;
+    const uint8_t *p = varint_get(n->d, &cnt);
+    if (cnt != nfields) return 0;
+    for (uint32_t i = 0; i < nfields; i++) {
+        struct ostream_str f;
+        p = str_get(p, &f);
+        if (f.len != fv[2 * i].len || memcmp(f.p, fv[2 * i].p, f.len) != 0) return 0;
+    }
+    return 1;
+}
+
+static uint64_t fields_size(const struct ostream_str *fv, uint32_t nfields, int values) {
+    uint64_t n = 0;
+    for (uint32_t i = 0; i < nfields; i++) {
+        const struct ostream_str *s = fv + 2 * i + (values ? 1 : 0);
+        n += varint_size(s->len) + s->len;
+    }
+    return n;
+}
+
+static uint64_t entry_size(const struct ostream_id *master, const struct ostream_id *id,
+                           const struct ostream_str *fv, uint32_t nfields, int same) {
+    uint64_t n = 1 + varint_size(id->ms - master->ms) + varint_size(id->seq) + fields_size(fv, nfields, 1);
+    if (!same) n += varint_size(nfields) + fields_size(fv, nfields, 0);
+    return n;
+}
+
+static uint64_t node_cap_for(uint64_t need) {
+    if (need > OSTREAM_NODE_BYTES) return need;
+    uint64_t c = NODE_CAP_MIN;
+    while (c < need) c <<= 1;
+    return c;
+}
+
+/** 以 id 为主 ID, fv 的字段为主字段表的空节点 */
+static struct osnode *node_new(const struct ostream_id *id, const struct ostream_str *fv, uint32_t nfields,
+                               uint64_t first) {
+    uint64_t mlen = varint_size(nfields) + fields_size(fv, nfields, 0);
+    uint64_t cap = node_cap_for(mlen + first);
+    struct osnode *n = malloc(sizeof(struct osnode) + cap);
+    if (!n) return NULL;
+    n->master = *id;
+    n->count = 0;
+    n->mlen = n->off = n->len = (uint32_t) mlen;
+    n->cap = (uint32_t) cap;
+    uint8_t *p = varint_put(n->d, nfields);
+    for (uint32_t i = 0; i < nfields; i++) p = str_put(p, fv + 2 * i);
+    return n;
+}
+
+/** 解码 off 处的 entry @return 下一个 entry 的 off */
+static uint32_t entry_decode(const struct osnode *n, uint32_t off, struct ostream_entry *e) {
+    const uint8_t *p = n->d + off;
+    uint8_t flags = *p++;
+    uint64_t dms, seq, cnt;
+    p = varint_get(p, &dms);
+    p = varint_get(p, &seq);
+    e->id.ms = n->master.ms + dms;
+    e->id.seq = seq;
+    if (flags & OSE_SAMEFIELDS) {
+        e->mf = varint_get(n->d, &cnt);
+    } else {
+        p = varint_get(p, &cnt);
+        e->mf = NULL;
+    }
+    e->nfields = (uint32_t) cnt;
+    e->p = p;
+    for (uint32_t i = 0; i < e->nfields; i++) {
+        if (!e->mf) p = str_skip(p);
+        p = str_skip(p);
+    }
+    return (uint32_t) (p - n->d);
+}
+
+void
+ostream_entry_next(struct ostream_entry *e, struct ostream_str *f, struct ostream_str *val) {
+    if (e->mf) e->mf = str_get(e->mf, f);
+    else e->p = str_get(e->p, f);
+    e->p = str_get(e->p, val);
+}
+
+/*********************** stream ******************************/
+
+osv *
+ostreamv_new(void) {
+    osv *v = calloc(1, sizeof(osv) + sizeof(struct ostream));
+    if (!v) return NULL;
+    v->vlen = sizeof(struct ostream);
+    v->enc = OSV_STREAM;
+    return v;
+}
+
+static void group_free(struct osgroup *g) {
+    for (uint32_t i = 0; i < g->nconsumers; i++) free(g->consumers[i].name);
+    free(g->consumers);
+    free(g->pel);
+    free(g->name);
+}
+
+void
+ostreamv_clear(osv *v) {
+    struct ostream *s = ostreamv_s(v);
+    for (uint32_t i = 0; i < s->nnodes; i++) free(s->nodes[i]);
+    free(s->nodes);
+    for (uint32_t i = 0; i < s->ngroups; i++) group_free(s->groups + i);
+    free(s->groups);
+    memset(s, 0, sizeof(*s));
+}
+
+uint64_t
+ostreamv_bytes(const osv *v) {
+    const struct ostream *s = ostreamv_s(v);
+    uint64_t n = sizeof(osv) + sizeof(struct ostream) + (uint64_t) s->cnodes * sizeof(*s->nodes);
+    for (uint32_t i = 0; i < s->nnodes; i++) n += sizeof(struct osnode) + s->nodes[i]->cap;
+    for (uint32_t i = 0; i < s->ngroups; i++) {
+        const struct osgroup *g = s->groups + i;
+        n += sizeof(*g) + g->len + g->cpel * sizeof(struct ospel) + g->nconsumers * sizeof(struct osconsumer);
+    }
+    return n;
+}
+
+int
+ostreamv_append(osv *v, const struct ostream_id *id, const struct ostream_str *fv, uint32_t nfields) {
+    struct ostream *s = ostreamv_s(v);
+    struct osnode *n = s->nnodes ? s->nodes[s->nnodes - 1] : NULL;
+    int same = n && same_fields(n, fv, nfields);
+    uint64_t size = n ? entry_size(&n->master, id, fv, nfields, same) : 0;
+
+    if (!n || n->count >= OSTREAM_NODE_ENTRIES || n->len + size > OSTREAM_NODE_BYTES) {
+        if (s->nnodes == s->cnodes) {
+            uint32_t ncap = s->cnodes ? s->cnodes * 2 : 4;
+            struct osnode **p = realloc(s->nodes, ncap * sizeof(*p));
+            if (!p) return -ENOMEM;
+            s->nodes = p;
+            s->cnodes = ncap;
+        }
+        if (n && n->cap > n->len) { // 写满的节点不会再追加, 去掉余量
+            struct osnode *fit = realloc(n, sizeof(struct osnode) + n->len);
+            if (fit) {
+                fit->cap = fit->len;
+                s->nodes[s->nnodes - 1] = fit;
+            }
+        }
+        same = 1;
+        size = entry_size(id, id, fv, nfields, 1);
+        if (!(n = node_new(id, fv, nfields, size))) return -ENOMEM;
+        s->nodes[s->nnodes++] = n;
+    } else if (n->len + size > n->cap) {
+        uint64_t cap = node_cap_for(n->len + size);
+        struct osnode *p = realloc(n, sizeof(struct osnode) + cap);
+        if (!p) return -ENOMEM;
+        n = s->nodes[s->nnodes - 1] = p;
+        n->cap = (uint32_t) cap;
+    }
+
+    uint8_t *p = n->d + n->len;
+    *p++ = same ? OSE_SAMEFIELDS : 0;
+    p = varint_put(p, id->ms - n->master.ms);
+    p = varint_put(p, id->seq);
+    if (!same) p = varint_put(p, nfields);
+    for (uint32_t i = 0; i < nfields; i++) {
+        if (!same) p = str_put(p, fv + 2 * i);
+        p = str_put(p, fv + 2 * i + 1);
+    }
+    n->len = (uint32_t) (p - n->d);
+    n->count++;
+    s->length++;
+    s->last_id = *id;
+    return 0;
+}
+
+/*********************** 遍历 ******************************/
+
+void
+ostreamv_iter_init(struct ostream_iter *it, const osv *v, const struct ostream_id *start) {
+    const struct ostream *s = ostreamv_s(v);
+    // 最后一个 master <= start 的节点
+    uint32_t lo = 0, hi = s->nnodes;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (ostream_id_cmp(&s->nodes[mid]->master, start) <= 0) lo = mid + 1;
+        else hi = mid;
+    }
+    it->s = s;
+    it->ni = lo ? lo - 1 : 0;
+    it->off = it->ni < s->nnodes ? s->nodes[it->ni]->off : 0;
+    struct ostream_iter save;
+    struct ostream_entry e;
+    for (;;) {
+        save = *it;
+        if (!ostreamv_next(it, &e)) return;
+        if (ostream_id_cmp(&e.id, start) >= 0) break;
+    }
+    *it = save;
+}
+
+int
+ostreamv_next(struct ostream_iter *it, struct ostream_entry *e) {
+    while (it->ni < it->s->nnodes) {
+        const struct osnode *n = it->s->nodes[it->ni];
+        if (it->off < n->len) {
+            it->off = entry_decode(n, it->off, e);
+            return 1;
+        }
+        if (++it->ni < it->s->nnodes) it->off = it->s->nodes[it->ni]->off;
+    }
+    return 0;
+}
+
+int
+ostreamv_get(const osv *v, const struct ostream_id *id, struct ostream_entry *e) {
+    struct ostream_iter it;
+    ostreamv_iter_init(&it, v, id);
+    return ostreamv_next(&it, e) && ostream_id_cmp(&e->id, id) == 0;
+}
+
+/*********************** 裁剪 ******************************/
+
+/** 删除前 drop 个节点 */
+static void drop_nodes(struct ostream *s, uint32_t drop) {
+    if (!drop) return;
+    for (uint32_t i = 0; i < drop; i++) {
+        s->length -= s->nodes[i]->count;
+        free(s->nodes[i]);
+    }
+    s->nnodes -= drop;
+    memmove(s->nodes, s->nodes + drop, s->nnodes * sizeof(*s->nodes));
+}
+
+/** 删除第一个节点开头的 k 个 entry, 删空时删除整个节点 */
+static void drop_entries(struct ostream *s, uint32_t k) {
+    struct osnode *n = s->nodes[0];
+    if (k >= n->count) {
+        drop_nodes(s, 1);
+        return;
+    }
+    struct ostream_entry e;
+    for (uint32_t i = 0; i < k; i++) n->off = entry_decode(n, n->off, &e);
+    n->count -= k;
+    s->length -= k;
+}
+
+uint64_t
+ostreamv_trim_maxlen(osv *v, uint64_t maxlen, int approx) {
+    struct ostream *s = ostreamv_s(v);
+    uint64_t before = s->length, left = s->length;
+    uint32_t drop = 0;
+    while (drop < s->nnodes && left - s->nodes[drop]->count >= maxlen) left -= s->nodes[drop++]->count;
+    drop_nodes(s, drop);
+    if (!approx && s->length > maxlen) drop_entries(s, (uint32_t) (s->length - maxlen));
+    return before - s->length;
+}
+
+uint64_t
+ostreamv_trim_minid(osv *v, const struct ostream_id *minid, int approx) {
+    struct ostream *s = ostreamv_s(v);
+    uint64_t before = s->length;
+    uint32_t drop = 0;
+    // 节点 i 整个都 < minid: 下一个节点的主 ID <= minid, 或它是最后一个节点且 last_id < minid
+    while (drop < s->nnodes && (drop + 1 < s->nnodes ? ostream_id_cmp(&s->nodes[drop + 1]->master, minid) <= 0
+                                                      : ostream_id_cmp(&s->last_id, minid) < 0))
+        drop++;
+    drop_nodes(s, drop);
+    if (!approx && s->nnodes) {
+        const struct osnode *n = s->nodes[0];
+        struct ostream_entry e;
+        uint32_t k = 0;
+        for (uint32_t off = n->off; off < n->len; k++) {
+            off = entry_decode(n, off, &e);
+            if (ostream_id_cmp(&e.id, minid) >= 0) break;
+        }
+        if (k) drop_entries(s, k);
+    }
+    return before - s->length;
+}
+
+/*********************** 消费组 ******************************/
+
+struct osgroup *
+ostreamv_group(const osv *v, const char *name, uint32_t len) {
+    const struct ostream *s = ostreamv_s(v);
+    for (uint32_t i = 0; i < s->ngroups; i++)
+        if (s->groups[i].len == len && !memcmp(s->groups[i].name, name, len)) return s->groups + i;
+    return NULL;
+}
+
+int
+ostreamv_group_create(osv *v, const char *name, uint32_t len, const struct ostream_id *last) {
+    struct ostream *s = ostreamv_s(v);
+    if (ostreamv_group(v, name, len)) return -EEXIST;
+    struct osgroup *gs = realloc(s->groups, (s->ngroups + 1) * sizeof(*gs));
+    if (!gs) return -ENOMEM;
+    s->groups = gs;
+    struct osgroup *g = gs + s->ngroups;
+    memset(g, 0, sizeof(*g));
+    if (!(g->name = malloc(len ? len : 1))) return -ENOMEM;
+    memcpy(g->name, name, len);
+    g->len = len;
+    g->last_delivered = *last;
+    s->ngroups++;
+    return 0;
+}
+
+int
+ostreamv_group_destroy(osv *v, const char *name, uint32_t len) {
+    struct ostream *s = ostreamv_s(v);
+    struct osgroup *g = ostreamv_group(v, name, len);
+    if (!g) return 0;
+    group_free(g);
+    uint32_t i = (uint32_t) (g - s->groups);
+    memmove(g, g + 1, (s->ngroups - i - 1) * sizeof(*g));
+    s->ngroups--;
+    return 1;
+}
+
+int64_t
+osgroup_consumer(struct osgroup *g, const char *name, uint32_t len, int create) {
+    for (uint32_t i = 0; i < g->nconsumers; i++)
+        if (g->consumers[i].len == len && !memcmp(g->consumers[i].name, name, len)) return i;
+    if (!create) return -1;
+    struct osconsumer *cs = realloc(g->consumers, (g->nconsumers + 1) * sizeof(*cs));
+    if (!cs) return -ENOMEM;
+    g->consumers = cs;
+    char *dup = malloc(len ? len : 1);
+    if (!dup) return -ENOMEM;
+    memcpy(dup, name, len);
+    cs[g->nconsumers] = (struct osconsumer) {dup, len, 0, 0};
+    return g->nconsumers++;
+}
+
+int
+osgroup_pel_add(struct osgroup *g, const struct ostream_id *id, uint32_t consumer, uint64_t now) {
+    if (g->npel == g->cpel) {
+        uint64_t ncap = g->cpel ? g->cpel * 2 : 16;
+        struct ospel *p = realloc(g->pel, ncap * sizeof(*p));
+        if (!p) return -ENOMEM;
+        g->pel = p;
+        g->cpel = ncap;
+    }
+    g->pel[g->npel++] = (struct ospel) {*id, consumer, 1, now};
+    g->pending++;
+    g->consumers[consumer].pending++;
+    return 0;
+}
+
+/** 第一个 >= id 的下标, 包括已确认的标记 */
+static uint64_t pel_lower_bound(const struct osgroup *g, const struct ostream_id *id) {
+    uint64_t lo = 0, hi = g->npel;
+    while (lo < hi) {
+        uint64_t mid = (lo + hi) / 2;
+        if (ostream_id_cmp(&g->pel[mid].id, id) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+uint64_t
+osgroup_pel_seek(const struct osgroup *g, const struct ostream_id *id) {
+    uint64_t i = pel_lower_bound(g, id);
+    while (i < g->npel && g->pel[i].consumer == OSPEL_ACKED) i++;
+    return i;
+}
+
+struct ospel *
+osgroup_pel_find(const struct osgroup *g, const struct ostream_id *id) {
+    uint64_t i = pel_lower_bound(g, id);
+    if (i == g->npel || ostream_id_cmp(&g->pel[i].id, id) != 0 || g->pel[i].consumer == OSPEL_ACKED) return NULL;
+    return g->pel + i;
+}
+
+/** 去掉已确认的标记 */
+static void pel_compact(struct osgroup *g) {
+    uint64_t w = 0;
+    for (uint64_t r = 0; r < g->npel; r++)
+        if (g->pel[r].consumer != OSPEL_ACKED) g->pel[w++] = g->pel[r];
+    g->npel = w;
+}
+
+int
+osgroup_ack(struct osgroup *g, const struct ostream_id *id) {
+    struct ospel *e = osgroup_pel_find(g, id);
+    if (!e) return 0;
+    g->consumers[e->consumer].pending--;
+    e->consumer = OSPEL_ACKED;
+    g->pending--;
+    uint64_t acked = g->npel - g->pending;
+    if (!g->pending) g->npel = 0;
+    else if (acked > 64 && acked > g->pending) pel_compact(g);
+    return 1;
+}
@@ -0,0 +1,356 @@
+//
+// Created by weishen on 2025/11/16.
+//
+
+#include "osv_ts.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** 一个样本最坏情况的位数: '1111' + 64 位 dod, '11' + 5 + 6 + 64 位 xor */
+#define SAMPLE_BITS_MAX (4 + 64 + 2 + 5 + 6 + 64)
+
+/*********************** 位流 ******************************/
+
+static inline uint64_t load_be64(const uint8_t *p) {
+    uint64_t w;
+    memcpy(&w, p, 8);
+    return __builtin_bswap64(w);
+}
+
+/** 写入 v 的低 n 位 (1 <= n <= 32), 高位在前; 目标位置之后的位必须是 0 */
+static inline void put_bits(uint8_t *d, uint32_t *pos, uint64_t v, uint32_t n) {
+    uint8_t *p = d + (*pos >> 3);
+    uint64_t w = load_be64(p) | (v & ((1ULL << n) - 1)) << (64 - (*pos & 7) - n);
+    w = __builtin_bswap64(w);
+    memcpy(p, &w, 8);
+    *pos += n;
+}
+
+static inline void put_bits64(uint8_t *d, uint32_t *pos, uint64_t v, uint32_t n) {
+    if (n > 32) {
+        put_bits(d, pos, v >> 32, n - 32);
+        n = 32;
+    }
+    put_bits(d, pos, v, n);
+}
+
+/** 从 pos 起看 n 位 (1 <= n <= 32), 不移动 pos */
+static inline uint64_t peek_bits(const uint8_t *d, uint32_t pos, uint32_t n) {
+    return load_be64(d + (pos >> 3)) << (pos & 7) >> (64 - n);
+}
+
+static inline uint64_t get_bits(const uint8_t *d, uint32_t *pos, uint32_t n) {
+    uint64_t v = peek_bits(d, *pos, n);
+    *pos += n;
+    return v;
+}
+
+static inline uint64_t get_bits64(const uint8_t *d, uint32_t *pos, uint32_t n) {
+    if (n <= 32) return get_bits(d, pos, n);
+    uint64_t hi = get_bits(d, pos, n - 32);
+    return hi << 32 | get_bits(d, pos, 32);
+}
+
+static inline int64_t sext(uint64_t v, uint32_t n) {
+    return (int64_t) (v << (64 - n)) >> (64 - n);
+}
+
+static inline uint64_t d2bits(double d) {
+    uint64_t b;
+    memcpy(&b, &d, 8);
+    return b;
+}
+
+static inline double bits2d(uint64_t b) {
+    double d;
+    memcpy(&d, &b, 8);
+    return d;
+}
+
+/*********************** chunk ******************************/
+
+static struct ots_chunk *chunk_new(uint32_t size, int64_t ts, uint64_t bits) {
+    struct ots_chunk *c = calloc(1, sizeof(*c) + size + 8);
+    if (!c) return NULL;
+    c->first_ts = c->last_ts = ts;
+    c->first_bits = c->last_bits = bits;
+    c->n = 1;
+    c->cap = size;
+    c->leading = 0xff;
+    return c;
+}
+
+static void chunk_append(struct ots_chunk *c, int64_t ts, uint64_t bits) {
+    int64_t delta = ts - c->last_ts, dod = delta - c->last_delta;
+    if (dod == 0) put_bits(c->data, &c->pos, 0, 1);
+    else if (dod >= -64 && dod < 64) put_bits(c->data, &c->pos, 0x2ULL << 7 | ((uint64_t) dod & 0x7f), 9);
+    else if (dod >= -256 && dod < 256) put_bits(c->data, &c->pos, 0x6ULL << 9 | ((uint64_t) dod & 0x1ff), 12);
+    else if (dod >= -2048 && dod < 2048) put_bits(c->data, &c->pos, 0xeULL << 12 | ((uint64_t) dod & 0xfff), 16);
+    else {
+        put_bits(c->data, &c->pos, 0xf, 4);
+        put_bits64(c->data, &c->pos, (uint64_t) dod, 64);
+    }
+
+    uint64_t x = bits ^ c->last_bits;
+    if (!x) {
+        put_bits(c->data, &c->pos, 0, 1);
+    } else {
+        uint32_t lz = (uint32_t) __builtin_clzll(x), tz = (uint32_t) __builtin_ctzll(x);
+        if (lz > 31) lz = 31;
+        if (c->leading != 0xff && lz >= c->leading && tz >= c->trailing) {
+            put_bits(c->data, &c->pos, 0x2, 2);
+            put_bits64(c->data, &c->pos, x >> c->trailing, 64 - c->leading - c->trailing);
+        } else {
+            uint32_t sig = 64 - lz - tz;
+            put_bits(c->data, &c->pos, 0x3ULL << 11 | lz << 6 | (sig & 63), 13);
+            put_bits64(c->data, &c->pos, x >> tz, sig);
+            c->leading = (uint8_t) lz;
+            c->trailing = (uint8_t) tz;
+        }
+    }
+    c->last_delta = delta;
+    c->last_ts = ts;
+    c->last_bits = bits;
+    c->n++;
+}
+
+/*********************** 序列 ******************************/
+
+osv *
+otsv_new(int64_t retention, uint32_t chunk_size) {
+    osv *v = calloc(1, sizeof(osv) + sizeof(struct ots));
+    if (!v) return NULL;
+    v->vlen = sizeof(struct ots);
+    v->enc = OSV_TS;
+    otsv_ts(v)->retention = retention;
+    otsv_ts(v)->chunk_size = chunk_size;
+    return v;
+}
+
+osv *
+otsv_new_default(void) {
+    return otsv_new(0, OTS_CHUNK_SIZE_DEFAULT);
+}
+
+void
+otsv_clear(osv *v) {
+    struct ots *s = otsv_ts(v);
+    for (uint32_t i = 0; i < s->nchunks; i++) free(s->chunks[i]);
+    free(s->chunks);
+    s->chunks = NULL;
+    s->nchunks = s->cchunks = 0;
+    s->total = 0;
+}
+
+uint64_t
+otsv_bytes(const osv *v) {
+    const struct ots *s = otsv_ts(v);
+    uint64_t n = sizeof(osv) + sizeof(struct ots) + (uint64_t) s->cchunks * sizeof(*s->chunks);
+    for (uint32_t i = 0; i < s->nchunks; i++) n += sizeof(struct ots_chunk) + s->chunks[i]->cap + 8;
+    return n;
+}
+
+/** 丢弃整个落在保留窗口之外的 chunk, 最后一个 chunk 总是保留 */
+static void trim_retention(struct ots *s, int64_t now) {
+    uint32_t drop = 0;
+    while (drop + 1 < s->nchunks && s->chunks[drop]->last_ts < now - s->retention) {
+        s->total -= s->chunks[drop]->n;
+        free(s->chunks[drop++]);
+    }
+    if (!drop) return;
+    s->nchunks -= drop;
+    memmove(s->chunks, s->chunks + drop, s->nchunks * sizeof(*s->chunks));
+}
+
+int
+otsv_add(osv *v, int64_t ts, double val) {
+    struct ots *s = otsv_ts(v);
+    uint64_t bits = d2bits(val);
+    struct ots_chunk *c = s->nchunks ? s->chunks[s->nchunks - 1] : NULL;
+    if (c && ts == c->last_ts) return -EEXIST;
+    if (c && ts < c->last_ts) return -ERANGE;
+
+    if (c && c->pos + SAMPLE_BITS_MAX <= c->cap * 8) {
+        chunk_append(c, ts, bits);
+    } else {
+        if (s->nchunks == s->cchunks) {
+            uint32_t ncap = s->cchunks ? s->cchunks * 2 : 4;
+            struct ots_chunk **p = realloc(s->chunks, ncap * sizeof(*p));
+            if (!p) return -ENOMEM;
+            s->chunks = p;
+            s->cchunks = ncap;
+        }
+        if (!(c = chunk_new(s->chunk_size, ts, bits))) return -ENOMEM;
+        s->chunks[s->nchunks++] = c;
+    }
+    s->total++;
+    if (s->retention > 0) trim_retention(s, ts);
+    return 0;
+}
+
+int
+otsv_last(const osv *v, struct ots_sample *out) {
+    const struct ots *s = otsv_ts(v);
+    if (!s->nchunks) return 0;
+    const struct ots_chunk *c = s->chunks[s->nchunks - 1];
+    out->ts = c->last_ts;
+    out->v = bits2d(c->last_bits);
+    return 1;
+}
+
+/*********************** 解码 ******************************/
+
+void
+otsv_iter_init(struct ots_iter *it, const osv *v, int64_t from) {
+    const struct ots *s = otsv_ts(v);
+    // 第一个 last_ts >= from 的 chunk
+    uint32_t lo = 0, hi = s->nchunks;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (s->chunks[mid]->last_ts < from) lo = mid + 1;
+        else hi = mid;
+    }
+    memset(it, 0, sizeof(*it));
+    it->s = s;
+    it->ci = lo;
+}
+
+int
+ots_iter_next(struct ots_iter *it, struct ots_sample *out) {
+    const struct ots_chunk *c;
+    for (;;) {
+        if (it->ci >= it->s->nchunks) return 0;
+        c = it->s->chunks[it->ci];
+        if (it->i < c->n) break;
+        it->ci++;
+        it->i = 0;
+    }
+    if (it->i++ == 0) {
+        it->ts = c->first_ts;
+        it->bits = c->first_bits;
+        it->delta = 0;
+        it->pos = 0;
+        it->leading = 0xff;
+        out->ts = it->ts;
+        out->v = bits2d(it->bits);
+        return 1;
+    }
+
+    const uint8_t *d = c->data;
+    uint64_t p = peek_bits(d, it->pos, 4);
+    int64_t dod;
+    if (!(p & 0x8)) {
+        dod = 0;
+        it->pos += 1;
+    } else if ((p & 0xc) == 0x8) {
+        it->pos += 2;
+        dod = sext(get_bits(d, &it->pos, 7), 7);
+    } else if ((p & 0xe) == 0xc) {
+        it->pos += 3;
+        dod = sext(get_bits(d, &it->pos, 9), 9);
+    } else if (p == 0xe) {
+        it->pos += 4;
+        dod = sext(get_bits(d, &it->pos, 12), 12);
+    } else {
+        it->pos += 4;
+        dod = (int64_t) get_bits64(d, &it->pos, 64);
+    }
+    it->delta += dod;
+    it->ts += it->delta;
+
+    p = peek_bits(d, it->pos, 2);
+    if (!(p & 0x2)) {
+        it->pos += 1;
+    } else if (p == 0x2) {
+        it->pos += 2;
+        uint32_t sig = 64 - it->leading - it->trailing;
+        it->bits ^= get_bits64(d, &it->pos, sig) << it->trailing;
+    } else {
+        it->pos += 2;
+        uint64_t h = get_bits(d, &it->pos, 11);
+        uint32_t lz = (uint32_t) (h >> 6), sig = (uint32_t) (h & 63);
+        if (!sig) sig = 64;
+        it->leading = (uint8_t) lz;
+        it->trailing = (uint8_t) (64 - lz - sig);
+        it->bits ^= get_bits64(d, &it->pos, sig) << it->trailing;
+    }
+    out->ts = it->ts;
+    out->v = bits2d(it->bits);
+    return 1;
+}
+
+/*********************** 范围 / 聚合 ******************************/
+
+struct range_out {
+    struct ots_sample *a;
+    uint64_t n;
+    uint64_t cap;
+};
+
+static int push(struct range_out *r, int64_t ts, double v) {
+    if (r->n == r->cap) {
+        uint64_t ncap = r->cap ? r->cap * 2 : 64;
+        struct ots_sample *p = realloc(r->a, ncap * sizeof(*p));
+        if (!p) return -ENOMEM;
+        r->a = p;
+        r->cap = ncap;
+    }
+    r->a[r->n++] = (struct ots_sample) {ts, v};
+    return 0;
+}
+
+struct bucket {
+    int64_t start;
+    uint64_t count;
+    double sum;
+    double min;
+    double max;
+};
+
+static double bucket_value(const struct bucket *b, int agg) {
+    switch (agg) {
+        case OTS_AGG_AVG: return b->sum / (double) b->count;
+        case OTS_AGG_SUM: return b->sum;
+        case OTS_AGG_MIN: return b->min;
+        case OTS_AGG_MAX: return b->max;
+        default: return (double) b->count;
+    }
+}
+
+int64_t
+otsv_range(const osv *v, int64_t from, int64_t to, int agg, int64_t bucket, uint64_t limit,
+           struct ots_sample **out) {
+    struct range_out r = {0};
+    struct ots_iter it;
+    struct ots_sample smp;
+    struct bucket b = {0};
+    otsv_iter_init(&it, v, from);
+    while ((!limit || r.n < limit) && ots_iter_next(&it, &smp)) {
+        if (smp.ts > to) break;
+        if (smp.ts < from) continue;
+        if (agg == OTS_AGG_NONE) {
+            if (push(&r, smp.ts, smp.v) < 0) goto oom;
+            continue;
+        }
+        int64_t start = smp.ts - smp.ts % bucket;
+        if (b.count && start != b.start) {
+            if (push(&r, b.start, bucket_value(&b, agg)) < 0) goto oom;
+            b.count = 0;
+        }
+        if (!b.count) {
+            b = (struct bucket) {start, 0, 0, smp.v, smp.v};
+        }
+        b.count++;
+        b.sum += smp.v;
+        if (smp.v < b.min) b.min = smp.v;
+        if (smp.v > b.max) b.max = smp.v;
+    }
+    if (b.count && (!limit || r.n < limit) && push(&r, b.start, bucket_value(&b, agg)) < 0) goto oom;
+    *out = r.a;
+    return (int64_t) r.n;
+oom:
+    free(r.a);
+    return -ENOMEM;
+}
@@ -0,0 +1,577 @@
+//
+// Created by weishen on 2025/11/17.
+//
+
+#include "osv_vset.h"
+#include "ocpu.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+/*********************** 距离内核 ******************************/
+
+static float dot_f32_scalar(const float *a, const float *b, uint32_t n) {
+    float s = 0;
+    for (uint32_t i = 0; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+static float l2_f32_scalar(const float *a, const float *b, uint32_t n) {
+    float s = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        float d = a[i] - b[i];
+        s += d * d;
+    }
+    return s;
+}
+
+static int32_t dot_i8_scalar(const int8_t *a, const int8_t *b, uint32_t n) {
+    int32_t s = 0;
+    for (uint32_t i = 0; i < n; i++) s += (int32_t) a[i] * b[i];
+    return s;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2,fma")))
+static inline float hsum_avx2(__m256 v) {
+    __m128 x = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+    x = _mm_add_ss(x, _mm_movehdup_ps(x));
+    return _mm_cvtss_f32(x);
+}
+
+/** 4 个累加器, 一次 32 个 float, 隐藏 FMA 的延迟 */
+__attribute__((target("avx2,fma")))
+static float dot_f32_avx2(const float *a, const float *b, uint32_t n) {
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps(), s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+    uint32_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+        s1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), s1);
+        s2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), s2);
+        s3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), s3);
+    }
+    for (; i + 8 <= n; i += 8) s0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), s0);
+    float s = hsum_avx2(_mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3)));
+    for (; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+__attribute__((target("avx2,fma")))
+static float l2_f32_avx2(const float *a, const float *b, uint32_t n) {
+    __m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps(), s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+    uint32_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+        __m256 d2 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16));
+        __m256 d3 = _mm256_sub_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24));
+        s0 = _mm256_fmadd_ps(d0, d0, s0);
+        s1 = _mm256_fmadd_ps(d1, d1, s1);
+        s2 = _mm256_fmadd_ps(d2, d2, s2);
+        s3 = _mm256_fmadd_ps(d3, d3, s3);
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        s0 = _mm256_fmadd_ps(d, d, s0);
+    }
+    float s = hsum_avx2(_mm256_add_ps(_mm256_add_ps(s0, s1), _mm256_add_ps(s2, s3)));
+    for (; i < n; i++) {
+        float d = a[i] - b[i];
+        s += d * d;
+    }
+    return s;
+}
+
+/** int8 扩展成 int16 后 madd: 每对乘积 <= 2 * 127^2, 32768 维内 int32 不会溢出 */
+__attribute__((target("avx2")))
+static int32_t dot_i8_avx2(const int8_t *a, const int8_t *b, uint32_t n) {
+    __m256i s0 = _mm256_setzero_si256(), s1 = _mm256_setzero_si256();
+    uint32_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i a0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (a + i)));
+        __m256i b0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (b + i)));
+        __m256i a1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (a + i + 16)));
+        __m256i b1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (b + i + 16)));
+        s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(a0, b0));
+        s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(a1, b1));
+    }
+    for (; i + 16 <= n; i += 16) {
+        __m256i a0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (a + i)));
+        __m256i b0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *) (b + i)));
+        s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(a0, b0));
+    }
+    __m256i s = _mm256_add_epi32(s0, s1);
+    __m128i x = _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0x4e));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0xb1));
+    int32_t r = _mm_cvtsi128_si32(x);
+    for (; i < n; i++) r += (int32_t) a[i] * b[i];
+    return r;
+}
+#endif
+
+static float (*dot_f32)(const float *, const float *, uint32_t);
+static float (*l2_f32)(const float *, const float *, uint32_t);
+static int32_t (*dot_i8)(const int8_t *, const int8_t *, uint32_t);
+
+static void kernels_init(void) {
+    if (dot_f32) return;
+    dot_f32 = dot_f32_scalar;
+    l2_f32 = l2_f32_scalar;
+    dot_i8 = dot_i8_scalar;
+#if defined(__x86_64__)
+    if (cpu_has_avx2()) dot_i8 = dot_i8_avx2;
+    if (cpu_has_avx2() && cpu_has_fma()) {
+        dot_f32 = dot_f32_avx2;
+        l2_f32 = l2_f32_avx2;
+    }
+#endif
+}
+
+/*********************** 编码与距离 ******************************/
+
+/** 查询向量: 已编码 (归一化 / 量化) 的一段 stride 字节, 加上 Q8 的 scale 和 |x|^2 */
+struct ovq {
+    const uint8_t *p;
+    float scale;
+    float norm2;
+};
+
+static inline const uint8_t *vec_at(const struct ovset *s, uint32_t id) {
+    return s->vecs + (uint64_t) id * s->stride;
+}
+
+static inline struct ovq stored_q(const struct ovset *s, uint32_t id) {
+    struct ovq q = {vec_at(s, id), 0, 0};
+    if (s->quant == OVSET_Q8) {
+        q.scale = s->aux[2 * (uint64_t) id];
+        q.norm2 = s->aux[2 * (uint64_t) id + 1];
+    }
+    return q;
+}
+
+static inline float qdist(const struct ovset *s, const struct ovq *q, uint32_t id) {
+    const uint8_t *x = vec_at(s, id);
+    if (s->quant == OVSET_F32) {
+        if (s->metric == OVSET_COSINE) return 1 - dot_f32((const float *) q->p, (const float *) x, s->dim);
+        return l2_f32((const float *) q->p, (const float *) x, s->dim);
+    }
+    float d = (float) dot_i8((const int8_t *) q->p, (const int8_t *) x, s->dim) * q->scale * s->aux[2 * (uint64_t) id];
+    if (s->metric == OVSET_COSINE) return 1 - d;
+    float r = q->norm2 + s->aux[2 * (uint64_t) id + 1] - 2 * d;
+    return r > 0 ? r : 0;
+}
+
+/** x -> dst (stride 字节), Q8 时 aux[0] = scale, aux[1] = |x|^2 */
+static void encode(const struct ovset *s, const float *x, uint8_t *dst, float *aux) {
+    float norm = 1;
+    if (s->metric == OVSET_COSINE) {
+        double n2 = 0;
+        for (uint32_t i = 0; i < s->dim; i++) n2 += (double) x[i] * x[i];
+        norm = n2 > 0 ? (float) (1 / sqrt(n2)) : 0;
+    }
+    if (s->quant == OVSET_F32) {
+        float *f = (float *) dst;
+        for (uint32_t i = 0; i < s->dim; i++) f[i] = x[i] * norm;
+        return;
+    }
+    float max = 0;
+    for (uint32_t i = 0; i < s->dim; i++) max = fmaxf(max, fabsf(x[i] * norm));
+    float scale = max / 127, inv = max > 0 ? 127 / max : 0, n2 = 0;
+    int8_t *q = (int8_t *) dst;
+    for (uint32_t i = 0; i < s->dim; i++) {
+        long r = lrintf(x[i] * norm * inv);
+        q[i] = (int8_t) (r > 127 ? 127 : r < -127 ? -127 : r);
+        n2 += (q[i] * scale) * (q[i] * scale);
+    }
+    aux[0] = scale;
+    aux[1] = n2;
+}
+
+/*********************** 搜索用的堆 ******************************/
+
+struct ovheap {
+    struct ovhit *a;
+    uint32_t n;
+    uint32_t cap;
+};
+
+/** 单线程: 所有集合共用一组堆和缓冲区 */
+static struct ovheap cand, res, work;
+static uint8_t *qbuf;
+static uint32_t qcap;
+
+/** max: 堆顶是最大的 (结果集), 否则堆顶最小 (候选集) */
+static inline int before(struct ovhit a, struct ovhit b, int max) {
+    return max ? a.dist > b.dist : a.dist < b.dist;
+}
+
+static int heap_reserve(struct ovheap *h, uint32_t need) {
+    if (need <= h->cap) return 0;
+    uint32_t cap = h->cap ? h->cap * 2 : 256;
+    while (cap < need) cap *= 2;
+    struct ovhit *a = realloc(h->a, cap * sizeof(*a));
+    if (!a) return -ENOMEM;
+    h->a = a;
+    h->cap = cap;
+    return 0;
+}
+
+/** 扩容失败时丢掉这个点: 只影响召回, 不影响正确性 */
+static void heap_push(struct ovheap *h, struct ovhit e, int max) {
+    if (h->n == h->cap && heap_reserve(h, h->n + 1) < 0) return;
+    uint32_t i = h->n++;
+    while (i && before(e, h->a[(i - 1) / 2], max)) {
+        h->a[i] = h->a[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    h->a[i] = e;
+}
+
+static struct ovhit heap_pop(struct ovheap *h, int max) {
+    struct ovhit top = h->a[0], last = h->a[--h->n];
+    uint32_t i = 0;
+    for (;;) {
+        uint32_t c = 2 * i + 1;
+        if (c >= h->n) break;
+        if (c + 1 < h->n && before(h->a[c + 1], h->a[c], max)) c++;
+        if (!before(h->a[c], last, max)) break;
+        h->a[i] = h->a[c];
+        i = c;
+    }
+    if (h->n) h->a[i] = last;
+    return top;
+}
+
+static int hit_cmp(const void *a, const void *b) {
+    float x = ((const struct ovhit *) a)->dist, y = ((const struct ovhit *) b)->dist;
+    return x < y ? -1 : x > y;
+}
+
+/*********************** HNSW ******************************/
+
+static inline uint32_t *links(const struct ovset *s, uint32_t id, uint32_t layer) {
+    if (!layer) return s->links0 + (uint64_t) id * (1 + 2 * s->m);
+    return s->upper[id] + (uint64_t) (layer - 1) * (1 + s->m);
+}
+
+static inline void visit_begin(struct ovset *s) {
+    if (++s->epoch == 0) {
+        memset(s->visited, 0, s->cap * sizeof(uint32_t));
+        s->epoch = 1;
+    }
+}
+
+/** 上层: 贪心走到局部最近的点 */
+static struct ovhit greedy(const struct ovset *s, const struct ovq *q, struct ovhit cur, uint32_t layer) {
+    for (int changed = 1; changed;) {
+        changed = 0;
+        uint32_t *l = links(s, cur.id, layer);
+        for (uint32_t i = 1; i <= l[0]; i++) {
+            float d = qdist(s, q, l[i]);
+            if (d < cur.dist) {
+                cur = (struct ovhit) {l[i], d};
+                changed = 1;
+            }
+        }
+    }
+    return cur;
+}
+
+/** 从 ep 出发的 best-first 搜索, 结果 (最多 ef 个) 留在 res 这个最大堆里 */
+static void search_layer(struct ovset *s, const struct ovq *q, struct ovhit ep, uint32_t ef, uint32_t layer) {
+    visit_begin(s);
+    cand.n = res.n = 0;
+    s->visited[ep.id] = s->epoch;
+    heap_push(&cand, ep, 0);
+    heap_push(&res, ep, 1);
+    while (cand.n) {
+        struct ovhit c = heap_pop(&cand, 0);
+        if (res.n >= ef && c.dist > res.a[0].dist) break;
+        uint32_t *l = links(s, c.id, layer);
+        for (uint32_t i = 1; i <= l[0]; i++) __builtin_prefetch(vec_at(s, l[i]));
+        for (uint32_t i = 1; i <= l[0]; i++) {
+            uint32_t nb = l[i];
+            if (s->visited[nb] == s->epoch) continue;
+            s->visited[nb] = s->epoch;
+            float d = qdist(s, q, nb);
+            if (res.n < ef || d < res.a[0].dist) {
+                heap_push(&cand, (struct ovhit) {nb, d}, 0);
+                heap_push(&res, (struct ovhit) {nb, d}, 1);
+                if (res.n > ef) heap_pop(&res, 1);
+            }
+        }
+    }
+}
+
+/**
+ * 启发式选邻居: w 按距离升序, 一个候选点只有比所有已选的邻居都更靠近中心时才保留
+ * (否则它可以经由已选的邻居到达), 让边分散到不同方向 @return 选中的个数
+ */
+static uint32_t select_neighbours(const struct ovset *s, struct ovhit *w, uint32_t n, uint32_t m, uint32_t *out) {
+    qsort(w, n, sizeof(*w), hit_cmp);
+    uint32_t k = 0;
+    for (uint32_t i = 0; i < n && k < m; i++) {
+        struct ovq qi = stored_q(s, w[i].id);
+        int keep = 1;
+        for (uint32_t j = 0; j < k && keep; j++) keep = qdist(s, &qi, out[j]) >= w[i].dist;
+        if (keep) out[k++] = w[i].id;
+    }
+    return k;
+}
+
+/** 反向边 nb -> id, nb 的边满了就在原有的边加上 id 中重新选 */
+static void link_back(const struct ovset *s, uint32_t nb, uint32_t id, uint32_t layer) {
+    uint32_t *l = links(s, nb, layer), max = layer ? s->m : 2 * s->m;
+    if (l[0] < max) {
+        l[++l[0]] = id;
+        return;
+    }
+    struct ovhit c[2 * OVSET_M_MAX + 1];
+    uint32_t sel[2 * OVSET_M_MAX + 1];
+    struct ovq q = stored_q(s, nb);
+    for (uint32_t i = 0; i < l[0]; i++) c[i] = (struct ovhit) {l[i + 1], qdist(s, &q, l[i + 1])};
+    c[l[0]] = (struct ovhit) {id, qdist(s, &q, id)};
+    uint32_t k = select_neighbours(s, c, l[0] + 1, max, sel);
+    memcpy(l + 1, sel, k * sizeof(uint32_t));
+    l[0] = k;
+}
+
+static uint32_t random_level(struct ovset *s) {
+    s->rng ^= s->rng << 13;
+    s->rng ^= s->rng >> 7;
+    s->rng ^= s->rng << 17;
+    double u = (double) ((s->rng >> 11) + 1) / (double) (1ULL << 53);
+    uint32_t l = (uint32_t) (-log(u) / log((double) s->m));
+    return l < OVSET_LEVEL_MAX ? l : OVSET_LEVEL_MAX;
+}
+
+/** 给 id 分配层数和上层的边 (插入前做, 失败时集合不变) */
+static int node_prepare(struct ovset *s, uint32_t id) {
+    uint32_t l = random_level(s);
+    s->upper[id] = NULL;
+    if (l && !(s->upper[id] = calloc((uint64_t) l * (1 + s->m), sizeof(uint32_t)))) return -ENOMEM;
+    s->level[id] = (uint8_t) l;
+    links(s, id, 0)[0] = 0;
+    return 0;
+}
+
+/** 把已经 node_prepare 过的 id 连进图, first: 图中还没有别的点 */
+static void node_link(struct ovset *s, uint32_t id, int first) {
+    uint32_t l = s->level[id];
+    if (first) {
+        s->entry = id;
+        s->max_level = l;
+        return;
+    }
+    struct ovq q = stored_q(s, id);
+    struct ovhit cur = {s->entry, qdist(s, &q, s->entry)};
+    for (uint32_t lc = s->max_level; lc > l; lc--) cur = greedy(s, &q, cur, lc);
+    for (int64_t lc = l < s->max_level ? l : s->max_level; lc >= 0; lc--) {
+        search_layer(s, &q, cur, s->ef, (uint32_t) lc);
+        if (heap_reserve(&work, res.n) < 0) break;
+        memcpy(work.a, res.a, res.n * sizeof(struct ovhit));
+        uint32_t sel[OVSET_M_MAX];
+        uint32_t k = select_neighbours(s, work.a, res.n, s->m, sel);
+        uint32_t *own = links(s, id, (uint32_t) lc);
+        memcpy(own + 1, sel, k * sizeof(uint32_t));
+        own[0] = k;
+        for (uint32_t i = 0; i < k; i++) link_back(s, sel[i], id, (uint32_t) lc);
+        cur = work.a[0]; // select_neighbours 已经按距离排好序
+    }
+    if (l > s->max_level) {
+        s->max_level = l;
+        s->entry = id;
+    }
+}
+
+static void graph_free(struct ovset *s) {
+    if (s->upper)
+        for (uint64_t i = 0; i < s->count; i++) free(s->upper[i]);
+    free(s->links0);
+    free(s->upper);
+    free(s->level);
+    free(s->visited);
+    s->links0 = NULL;
+    s->upper = NULL;
+    s->level = NULL;
+    s->visited = NULL;
+}
+
+/** 超过 OVSET_FLAT_MAX 时一次性建图, 失败时保持精确扫描 */
+static void graph_build(struct ovset *s) {
+    s->links0 = malloc(s->cap * (1 + 2 * s->m) * sizeof(uint32_t));
+    s->upper = calloc(s->cap, sizeof(uint32_t *));
+    s->level = malloc(s->cap);
+    s->visited = calloc(s->cap, sizeof(uint32_t));
+    if (!s->links0 || !s->upper || !s->level || !s->visited) goto failure;
+    for (uint64_t i = 0; i < s->count; i++)
+        if (node_prepare(s, (uint32_t) i) < 0) goto failure;
+    s->epoch = 0;
+    for (uint64_t i = 0; i < s->count; i++) node_link(s, (uint32_t) i, i == 0);
+    return;
+failure:
+    graph_free(s);
+}
+
+/*********************** API ******************************/
+
+osv *
+ovsetv_new(uint32_t dim, enum ovset_metric metric, enum ovset_quant quant, uint32_t m, uint32_t ef) {
+    kernels_init();
+    osv *v = calloc(1, sizeof(osv) + sizeof(struct ovset));
+    if (!v) return NULL;
+    v->vlen = sizeof(struct ovset);
+    v->enc = OSV_VSET;
+    struct ovset *s = ovsetv_s(v);
+    s->dim = dim;
+    s->metric = (uint8_t) metric;
+    s->quant = (uint8_t) quant;
+    s->stride = quant == OVSET_Q8 ? dim : dim * (uint32_t) sizeof(float);
+    s->m = m;
+    s->ef = ef;
+    s->rng = 0x2545f4914f6cdd1dULL;
+    if (otable_init(&s->dict, 16) < 0) {
+        free(v);
+        return NULL;
+    }
+    return v;
+}
+
+void
+ovsetv_clear(osv *v) {
+    struct ovset *s = ovsetv_s(v);
+    graph_free(s);
+    for (uint64_t i = 0; i < s->count; i++) free((char *) s->names[i].p);
+    otable_destroy(&s->dict, NULL);
+    free(s->vecs);
+    free(s->aux);
+    free(s->names);
+    s->vecs = NULL;
+    s->aux = NULL;
+    s->names = NULL;
+    s->count = s->cap = 0;
+}
+
+uint64_t
+ovsetv_bytes(const osv *v) {
+    const struct ovset *s = ovsetv_s(v);
+    uint64_t n = sizeof(osv) + sizeof(struct ovset) + s->dict.cap * sizeof(ohash_t);
+    n += s->cap * (s->stride + sizeof(struct ovname) + (s->quant == OVSET_Q8 ? 2 * sizeof(float) : 0));
+    for (uint64_t i = 0; i < s->count; i++) n += s->names[i].len;
+    if (s->links0) {
+        n += s->cap * ((1 + 2 * s->m) * sizeof(uint32_t) + sizeof(uint32_t *) + 1 + sizeof(uint32_t));
+        for (uint64_t i = 0; i < s->count; i++) n += (uint64_t) s->level[i] * (1 + s->m) * sizeof(uint32_t);
+    }
+    return n;
+}
+
+int64_t
+ovsetv_find(const osv *v, const char *name, uint32_t len) {
+    ohash_t *slot = otable_lookup((otable_t *) &ovsetv_s(v)->dict, name, len);
+    return slot ? (int64_t) (uintptr_t) slot->v : -1;
+}
+
+/** 所有按 id 索引的数组扩到 need, 任何一步失败 cap 都不变 */
+static int reserve(struct ovset *s, uint64_t need) {
+    if (need <= s->cap) return 0;
+    if (need > UINT32_MAX) return -ENOMEM;
+    uint64_t cap = s->cap ? s->cap * 2 : 16;
+    while (cap < need) cap *= 2;
+    void *p;
+    if (!(p = realloc(s->vecs, cap * s->stride))) return -ENOMEM;
+    s->vecs = p;
+    if (!(p = realloc(s->names, cap * sizeof(struct ovname)))) return -ENOMEM;
+    s->names = p;
+    if (s->quant == OVSET_Q8) {
+        if (!(p = realloc(s->aux, cap * 2 * sizeof(float)))) return -ENOMEM;
+        s->aux = p;
+    }
+    if (s->links0) {
+        if (!(p = realloc(s->links0, cap * (1 + 2 * s->m) * sizeof(uint32_t)))) return -ENOMEM;
+        s->links0 = p;
+        if (!(p = realloc(s->upper, cap * sizeof(uint32_t *)))) return -ENOMEM;
+        s->upper = p;
+        if (!(p = realloc(s->level, cap))) return -ENOMEM;
+        s->level = p;
+        if (!(p = realloc(s->visited, cap * sizeof(uint32_t)))) return -ENOMEM;
+        s->visited = p;
+        memset(s->visited + s->cap, 0, (cap - s->cap) * sizeof(uint32_t));
+    }
+    s->cap = cap;
+    return 0;
+}
+
+int
+ovsetv_add(osv *v, const char *name, uint32_t len, const float *x) {
+    struct ovset *s = ovsetv_s(v);
+    if (ovsetv_find(v, name, len) >= 0) return 0;
+    if (reserve(s, s->count + 1) < 0) return -ENOMEM;
+    uint32_t id = (uint32_t) s->count;
+    encode(s, x, s->vecs + (uint64_t) id * s->stride, s->quant == OVSET_Q8 ? s->aux + 2 * (uint64_t) id : NULL);
+    if (s->links0 && node_prepare(s, id) < 0) return -ENOMEM;
+    char *dup = malloc(len ? len : 1);
+    if (!dup || otable_insert(&s->dict, memcpy(dup, name, len), len, (void *) (uintptr_t) id, NULL) < 0) {
+        free(dup);
+        if (s->links0) free(s->upper[id]);
+        return -ENOMEM;
+    }
+    s->names[id] = (struct ovname) {dup, len};
+    s->count++;
+    if (s->links0) node_link(s, id, id == 0);
+    else if (s->count > OVSET_FLAT_MAX) graph_build(s);
+    return 1;
+}
+
+/** 精确扫描, 用 k 个元素的最大堆保留最近的 k 个 */
+static uint32_t search_flat(const struct ovset *s, const struct ovq *q, uint32_t k, struct ovhit *out) {
+    res.n = 0;
+    for (uint64_t i = 0; i < s->count; i++) {
+        if (i + 4 < s->count) __builtin_prefetch(vec_at(s, (uint32_t) i + 4));
+        float d = qdist(s, q, (uint32_t) i);
+        if (res.n < k) heap_push(&res, (struct ovhit) {(uint32_t) i, d}, 1);
+        else if (d < res.a[0].dist) {
+            heap_pop(&res, 1);
+            heap_push(&res, (struct ovhit) {(uint32_t) i, d}, 1);
+        }
+    }
+    uint32_t n = res.n;
+    memcpy(out, res.a, n * sizeof(struct ovhit));
+    qsort(out, n, sizeof(*out), hit_cmp);
+    return n;
+}
+
+uint32_t
+ovsetv_search(osv *v, const float *x, uint32_t id, uint32_t k, uint32_t ef, int exact, struct ovhit *out) {
+    struct ovset *s = ovsetv_s(v);
+    if (!s->count || !k) return 0;
+    struct ovq q;
+    if (x) {
+        if (qcap < s->stride) {
+            uint8_t *p = realloc(qbuf, s->stride);
+            if (!p) return 0;
+            qbuf = p;
+            qcap = s->stride;
+        }
+        float aux[2] = {0, 0};
+        encode(s, x, qbuf, aux);
+        q = (struct ovq) {qbuf, aux[0], aux[1]};
+    } else q = stored_q(s, id);
+    if (exact || !s->links0) return search_flat(s, &q, k, out);
+
+    struct ovhit cur = {s->entry, qdist(s, &q, s->entry)};
+    for (uint32_t lc = s->max_level; lc > 0; lc--) cur = greedy(s, &q, cur, lc);
+    search_layer(s, &q, cur, ef > k ? ef : k, 0);
+    while (res.n > k) heap_pop(&res, 1);
+    uint32_t n = res.n;
+    memcpy(out, res.a, n * sizeof(struct ovhit));
+    qsort(out, n, sizeof(*out), hit_cmp);
+    return n;
+}
@@ -0,0 +1,576 @@
+//
+// Created by weishen on 2025/11/11.
+//
+
+#include "osv_zset.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define OZ_MAX_HEIGHT 16 // 每层至少分到一半, 64 路树 16 层远超 2^64
+
+/** PACK 的 entry 起点 -> score / member */
+#define ZP_MLEN(p) ((uint8_t) (p)[8])
+#define ZP_M(p) ((p) + 9)
+#define ZP_SIZE(p) (9 + ZP_MLEN(p))
+
+static inline double zp_score(const char *p) {
+    double s;
+    memcpy(&s, p, sizeof(s));
+    return s;
+}
+
+/** dict 的 v 直接放 score 的位模式 */
+static inline void *score2v(double s) {
+    void *v;
+    memcpy(&v, &s, sizeof(v));
+    return v;
+}
+
+static inline double v2score(void *v) {
+    double s;
+    memcpy(&s, &v, sizeof(s));
+    return s;
+}
+
+/** (score, member) 的全序: 先比 score, 再按字节比 member */
+static inline int ent_cmp(double s1, const char *m1, uint32_t l1, double s2, const char *m2, uint32_t l2) {
+    if (s1 < s2) return -1;
+    if (s1 > s2) return 1;
+    int c = memcmp(m1, m2, l1 < l2 ? l1 : l2);
+    if (c) return c;
+    return (l1 > l2) - (l1 < l2);
+}
+
+static inline int oz_cmp(const struct ozent *a, const struct ozent *b) {
+    return ent_cmp(a->score, a->m, a->mlen, b->score, b->m, b->mlen);
+}
+
+/*********************** B+ tree ******************************/
+
+/** 最大的 i >= 1 使 k[i] <= e, 没有则 0 */
+static inline uint32_t inner_find(const struct ozinner *in, const struct ozent *e) {
+    uint32_t lo = 1, hi = in->n;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) >> 1;
+        if (oz_cmp(&in->k[mid], e) <= 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo - 1;
+}
+
+/** 第一个 >= e 的位置 */
+static inline uint32_t leaf_lb(const struct ozleaf *lf, const struct ozent *e) {
+    uint32_t lo = 0, hi = lf->n;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) >> 1;
+        if (oz_cmp(&lf->e[mid], e) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static inline int node_full(const void *node, uint32_t h) {
+    return h ? ((const struct ozinner *) node)->n == OZ_FAN : ((const struct ozleaf *) node)->n == OZ_LEAF;
+}
+
+static struct ozent node_min(const void *node, uint32_t h) {
+    for (; h; h--) node = ((const struct ozinner *) node)->c[0];
+    return ((const struct ozleaf *) node)->e[0];
+}
+
+static void leaf_unlink(struct ozset *s, struct ozleaf *lf) {
+    if (lf->prev) lf->prev->next = lf->next;
+    else s->first = lf->next;
+    if (lf->next) lf->next->prev = lf->prev;
+    free(lf);
+}
+
+static void node_free(struct ozset *s, void *node, uint32_t h) {
+    if (!h) {
+        leaf_unlink(s, node);
+        return;
+    }
+    struct ozinner *in = node;
+    for (uint32_t i = 0; i < in->n; i++) node_free(s, in->c[i], h - 1);
+    free(in);
+}
+
+static void inner_remove(struct ozinner *in, uint32_t i) {
+    uint32_t tail = in->n - i - 1;
+    memmove(in->c + i, in->c + i + 1, tail * sizeof(in->c[0]));
+    memmove(in->k + i, in->k + i + 1, tail * sizeof(in->k[0]));
+    memmove(in->cnt + i, in->cnt + i + 1, tail * sizeof(in->cnt[0]));
+    in->n--;
+}
+
+/**
+ * 把 in->c[i] (高度 ch, 已满) 分成两半, 右半插到 i + 1; in 必须有空位
+ * 分裂不改变内容, 失败时树仍然完整
+ */
+static int split_child(struct ozinner *in, uint32_t i, uint32_t ch) {
+    void *r;
+    struct ozent sep;
+    uint64_t rc = 0;
+    if (!ch) {
+        struct ozleaf *lf = in->c[i], *nr = malloc(sizeof(struct ozleaf));
+        if (!nr) return -ENOMEM;
+        uint32_t half = lf->n / 2;
+        nr->n = lf->n - half;
+        memcpy(nr->e, lf->e + half, nr->n * sizeof(struct ozent));
+        lf->n = half;
+        nr->prev = lf;
+        nr->next = lf->next;
+        if (lf->next) lf->next->prev = nr;
+        lf->next = nr;
+        r = nr;
+        sep = nr->e[0];
+        rc = nr->n;
+    } else {
+        struct ozinner *c = in->c[i], *nr = malloc(sizeof(struct ozinner));
+        if (!nr) return -ENOMEM;
+        uint32_t half = c->n / 2;
+        nr->n = c->n - half;
+        memcpy(nr->c, c->c + half, nr->n * sizeof(c->c[0]));
+        memcpy(nr->k, c->k + half, nr->n * sizeof(c->k[0]));
+        memcpy(nr->cnt, c->cnt + half, nr->n * sizeof(c->cnt[0]));
+        c->n = half;
+        for (uint32_t j = 0; j < nr->n; j++) rc += nr->cnt[j];
+        r = nr;
+        sep = nr->k[0]; // 原来的 c->k[half], half >= 1, 是有效的分隔
+    }
+    uint32_t tail = in->n - i - 1;
+    memmove(in->c + i + 2, in->c + i + 1, tail * sizeof(in->c[0]));
+    memmove(in->k + i + 2, in->k + i + 1, tail * sizeof(in->k[0]));
+    memmove(in->cnt + i + 2, in->cnt + i + 1, tail * sizeof(in->cnt[0]));
+    in->c[i + 1] = r;
+    in->k[i + 1] = sep;
+    in->cnt[i + 1] = rc;
+    in->cnt[i] -= rc;
+    in->n++;
+    return 0;
+}
+
+/**
+ * 自顶向下插入: 经过的满节点先分裂, 到叶子时一定有空位
+ * 子树计数在成功之后才沿路径加一, 中途 -ENOMEM 时树的内容不变
+ */
+static int tree_insert(struct ozset *s, const struct ozent *e) {
+    if (!s->root) {
+        struct ozleaf *lf = malloc(sizeof(struct ozleaf));
+        if (!lf) return -ENOMEM;
+        lf->prev = lf->next = NULL;
+        lf->n = 0;
+        s->root = s->first = lf;
+        s->height = 0;
+    }
+    if (node_full(s->root, s->height)) {
+        if (s->height + 1 >= OZ_MAX_HEIGHT) return -ENOMEM;
+        struct ozinner *nr = malloc(sizeof(struct ozinner));
+        if (!nr) return -ENOMEM;
+        nr->n = 1;
+        nr->c[0] = s->root;
+        nr->cnt[0] = s->len;
+        if (split_child(nr, 0, s->height) < 0) {
+            free(nr);
+            return -ENOMEM;
+        }
+        s->root = nr;
+        s->height++;
+    }
+    struct ozinner *path[OZ_MAX_HEIGHT];
+    uint32_t idx[OZ_MAX_HEIGHT], d = 0;
+    void *node = s->root;
+    for (uint32_t h = s->height; h; h--) {
+        struct ozinner *in = node;
+        uint32_t i = inner_find(in, e);
+        if (node_full(in->c[i], h - 1)) {
+            if (split_child(in, i, h - 1) < 0) return -ENOMEM;
+            if (oz_cmp(&in->k[i + 1], e) <= 0) i++;
+        }
+        path[d] = in;
+        idx[d++] = i;
+        node = in->c[i];
+    }
+    struct ozleaf *lf = node;
+    uint32_t pos = leaf_lb(lf, e);
+    memmove(lf->e + pos + 1, lf->e + pos, (lf->n - pos) * sizeof(struct ozent));
+    lf->e[pos] = *e;
+    lf->n++;
+    for (uint32_t j = 0; j < d; j++) path[j]->cnt[idx[j]]++;
+    s->len++;
+    return 0;
+}
+
+/**
+ * 叶子 c[i] 太空时与相邻的叶子合并 (合并后不超过 3/4, 避免马上又分裂)
+ * @return 合并后包含原 c[i] 内容的下标
+ */
+static uint32_t leaf_merge(struct ozset *s, struct ozinner *in, uint32_t i) {
+    struct ozleaf *lf = in->c[i];
+    if (lf->n >= OZ_LEAF / 4 || in->n < 2) return i;
+    uint32_t l = i + 1 < in->n ? i : i - 1;
+    struct ozleaf *a = in->c[l], *b = in->c[l + 1];
+    if (a->n + b->n > OZ_LEAF * 3 / 4) return i;
+    memcpy(a->e + a->n, b->e, b->n * sizeof(struct ozent));
+    a->n += b->n;
+    in->cnt[l] += in->cnt[l + 1];
+    leaf_unlink(s, b);
+    inner_remove(in, l + 1);
+    return l;
+}
+
+/** 删除 e (必须存在), 叶子空了就释放, 太空就合并; 被删元素做分隔时换成新的最小值 */
+static void tree_delete(struct ozset *s, const struct ozent *e) {
+    struct ozinner *path[OZ_MAX_HEIGHT];
+    uint32_t idx[OZ_MAX_HEIGHT], d = 0;
+    void *node = s->root;
+    for (uint32_t h = s->height; h; h--) {
+        struct ozinner *in = node;
+        uint32_t i = inner_find(in, e);
+        path[d] = in;
+        idx[d++] = i;
+        node = in->c[i];
+    }
+    struct ozleaf *lf = node;
+    uint32_t pos = leaf_lb(lf, e);
+    if (pos == lf->n || oz_cmp(&lf->e[pos], e)) return;
+    memmove(lf->e + pos, lf->e + pos + 1, (lf->n - pos - 1) * sizeof(struct ozent));
+    lf->n--;
+    if (!--s->len) {
+        node_free(s, s->root, s->height);
+        s->root = NULL;
+        s->height = 0;
+        return;
+    }
+    for (uint32_t j = d; j-- > 0;) {
+        struct ozinner *in = path[j];
+        uint32_t i = idx[j], ch = s->height - 1 - j;
+        // 空的子树: 有兄弟时释放, 否则 in 本身也空了, 交给上一层
+        if (!--in->cnt[i]) {
+            if (in->n > 1) {
+                node_free(s, in->c[i], ch);
+                inner_remove(in, i);
+            }
+            continue;
+        }
+        if (!ch) i = leaf_merge(s, in, i);
+        if (i && !oz_cmp(&in->k[i], e)) in->k[i] = node_min(in->c[i], ch);
+    }
+    while (s->height && ((struct ozinner *) s->root)->n == 1) {
+        struct ozinner *old = s->root;
+        s->root = old->c[0];
+        free(old);
+        s->height--;
+    }
+}
+
+/*********************** set (TREE) ******************************/
+
+static int set_add(struct ozset *s, const char *m, uint32_t mlen, double score) {
+    ohash_t *slot = otable_lookup(&s->dict, m, mlen);
+    if (slot) {
+        double old = v2score(slot->v);
+        if (old == score) return 0;
+        // 先插新位置再删旧位置, 插入失败时集合不变
+        struct ozent oe = {old, slot->key, mlen}, ne = {score, slot->key, mlen};
+        if (tree_insert(s, &ne) < 0) return -ENOMEM;
+        tree_delete(s, &oe);
+        slot->v = score2v(score);
+        return 0;
+    }
+    char *dup = malloc(mlen ? mlen : 1);
+    if (!dup) return -ENOMEM;
+    memcpy(dup, m, mlen);
+    struct ozent ne = {score, dup, mlen};
+    if (tree_insert(s, &ne) < 0) {
+        free(dup);
+        return -ENOMEM;
+    }
+    if (otable_insert(&s->dict, dup, mlen, score2v(score), NULL) < 0) {
+        tree_delete(s, &ne);
+        free(dup);
+        return -ENOMEM;
+    }
+    return 1;
+}
+
+static int set_del(struct ozset *s, const char *m, uint32_t mlen) {
+    oret_t ot = {0};
+    otable_take(&s->dict, m, mlen, &ot);
+    if (!ot.key) return 0;
+    struct ozent e = {v2score(ot.value), ot.key, mlen};
+    tree_delete(s, &e);
+    free(ot.key);
+    return 1;
+}
+
+/*********************** PACK ******************************/
+
+/** PACK 中按 member 线性查找, *count <- 扫描过的 entry 数 @return entry 起点, NULL 不存在 */
+static char *
+pack_find(const osv *v, const char *m, uint32_t mlen, uint64_t *count) {
+    char *p = (char *) v->d, *end = p + v->vlen;
+    uint64_t n = 0;
+    for (; p < end; p += ZP_SIZE(p), n++) {
+        if (ZP_MLEN(p) == mlen && !memcmp(ZP_M(p), m, mlen)) {
+            if (count) *count = n;
+            return p;
+        }
+    }
+    if (count) *count = n;
+    return NULL;
+}
+
+/** 按 1.25 倍扩容, 同 OSV_HASH_PACK */
+static osv *
+pack_reserve(osv *v, uint64_t need) {
+    uint64_t room = v->vlen + v->spare;
+    if (need <= room) return v;
+    room = need < 32 ? 32 : need + (need >> 2);
+    osv *nv = realloc(v, sizeof(osv) + room);
+    if (!nv) return NULL;
+    nv->spare = room - nv->vlen;
+    return nv;
+}
+
+/** 在有序的位置写入 entry, 容量由调用者保证 */
+static void
+pack_put(osv *v, const char *m, uint32_t mlen, double score) {
+    char *p = v->d, *end = p + v->vlen;
+    while (p < end && ent_cmp(zp_score(p), ZP_M(p), ZP_MLEN(p), score, m, mlen) < 0) p += ZP_SIZE(p);
+    uint64_t need = 9 + mlen;
+    memmove(p + need, p, end - p);
+    memcpy(p, &score, sizeof(score));
+    p[8] = (char) mlen;
+    memcpy(p + 9, m, mlen);
+    v->vlen += need;
+    v->spare -= need;
+}
+
+static void
+pack_remove(osv *v, char *p) {
+    uint64_t sz = ZP_SIZE(p);
+    memmove(p, p + sz, v->d + v->vlen - p - sz);
+    v->vlen -= sz;
+    v->spare += sz;
+}
+
+/** PACK -> TREE, 成功后释放原来的 PACK @return 新的 osv, NULL 表示 -ENOMEM (原值不变) */
+static osv *
+pack_to_tree(osv *v, uint64_t count) {
+    osv *nv = malloc(sizeof(osv) + sizeof(struct ozset));
+    if (!nv) return NULL;
+    nv->vlen = sizeof(struct ozset);
+    nv->meta = 0;
+    nv->enc = OSV_ZSET_TREE;
+    struct ozset *s = ozv_set(nv);
+    memset(s, 0, sizeof(struct ozset));
+    if (otable_init(&s->dict, (count + 1) * 2 * LOAD_FACTOR_DENOMINATOR / LOAD_FACTOR_THRESHOLD) < 0) {
+        free(nv);
+        return NULL;
+    }
+    char *p = v->d, *end = p + v->vlen;
+    for (; p < end; p += ZP_SIZE(p)) {
+        if (set_add(s, ZP_M(p), ZP_MLEN(p), zp_score(p)) < 0) {
+            ozv_clear(nv);
+            free(nv);
+            return NULL;
+        }
+    }
+    free(v);
+    return nv;
+}
+
+/*********************** API ******************************/
+
+osv *
+ozv_new(void) {
+    osv *v = malloc(sizeof(osv));
+    if (!v) return NULL;
+    v->vlen = 0;
+    v->meta = 0;
+    v->enc = OSV_ZSET_PACK;
+    return v;
+}
+
+void
+ozv_clear(osv *v) {
+    if (v->enc != OSV_ZSET_TREE) return;
+    struct ozset *s = ozv_set(v);
+    // dict 的 v 是 score 不是指针, key 单独释放
+    for (uint64_t i = 0; i < s->dict.cap; i++) {
+        ohash_t *slot = s->dict.slots + i;
+        if (slot->key && !slot->tb) free(slot->key);
+    }
+    otable_destroy(&s->dict, NULL);
+    if (s->root) node_free(s, s->root, s->height);
+    memset(s, 0, sizeof(struct ozset));
+}
+
+uint64_t
+ozv_len(const osv *v) {
+    if (v->enc == OSV_ZSET_TREE) return ozv_set(v)->len;
+    uint64_t n;
+    pack_find(v, NULL, UINT32_MAX, &n);
+    return n;
+}
+
+int
+ozv_score(const osv *v, const char *m, uint32_t mlen, double *score) {
+    if (v->enc == OSV_ZSET_TREE) {
+        ohash_t *slot = otable_lookup(&ozv_set(v)->dict, m, mlen);
+        if (!slot) return 0;
+        *score = v2score(slot->v);
+        return 1;
+    }
+    if (mlen > OSV_ZSET_PACK_VALUE) return 0;
+    const char *p = pack_find(v, m, mlen, NULL);
+    if (!p) return 0;
+    *score = zp_score(p);
+    return 1;
+}
+
+int
+ozv_add(osv **pv, const char *m, uint32_t mlen, double score) {
+    osv *v = *pv;
+    if (v->enc == OSV_ZSET_TREE) return set_add(ozv_set(v), m, mlen, score);
+
+    uint64_t count;
+    char *p = NULL;
+    if (mlen <= OSV_ZSET_PACK_VALUE) p = pack_find(v, m, mlen, &count);
+    else count = ozv_len(v);
+    if (mlen > OSV_ZSET_PACK_VALUE || (!p && count >= OSV_ZSET_PACK_ENTRIES)) {
+        osv *nv = pack_to_tree(v, count);
+        if (!nv) return -ENOMEM;
+        *pv = nv;
+        return set_add(ozv_set(nv), m, mlen, score);
+    }
+    if (p) {
+        if (zp_score(p) == score) return 0;
+        // 大小不变, 删掉再按新 score 放回去
+        pack_remove(v, p);
+        pack_put(v, m, mlen, score);
+        return 0;
+    }
+    if (!(v = pack_reserve(v, v->vlen + 9 + mlen))) return -ENOMEM;
+    *pv = v;
+    pack_put(v, m, mlen, score);
+    return 1;
+}
+
+int
+ozv_del(osv *v, const char *m, uint32_t mlen) {
+    if (v->enc == OSV_ZSET_TREE) return set_del(ozv_set(v), m, mlen);
+    if (mlen > OSV_ZSET_PACK_VALUE) return 0;
+    char *p = pack_find(v, m, mlen, NULL);
+    if (!p) return 0;
+    pack_remove(v, p);
+    return 1;
+}
+
+int
+ozv_rank(const osv *v, const char *m, uint32_t mlen, uint64_t *rank) {
+    if (v->enc != OSV_ZSET_TREE) {
+        if (mlen > OSV_ZSET_PACK_VALUE) return 0;
+        return pack_find(v, m, mlen, rank) != NULL;
+    }
+    const struct ozset *s = ozv_set(v);
+    ohash_t *slot = otable_lookup((otable_t *) &s->dict, m, mlen);
+    if (!slot) return 0;
+    struct ozent e = {v2score(slot->v), m, mlen};
+    uint64_t r = 0;
+    const void *node = s->root;
+    for (uint32_t h = s->height; h; h--) {
+        const struct ozinner *in = node;
+        uint32_t i = inner_find(in, &e);
+        for (uint32_t j = 0; j < i; j++) r += in->cnt[j];
+        node = in->c[i];
+    }
+    *rank = r + leaf_lb(node, &e);
+    return 1;
+}
+
+void
+ozv_iter_rank(struct ozv_iter *it, const osv *v, uint64_t rank) {
+    it->v = v;
+    it->leaf = NULL;
+    it->pos = 0;
+    if (v->enc != OSV_ZSET_TREE) {
+        const char *p = v->d, *end = p + v->vlen;
+        while (rank-- && p < end) p += ZP_SIZE(p);
+        it->pos = p - v->d;
+        return;
+    }
+    const struct ozset *s = ozv_set(v);
+    if (rank >= s->len) return;
+    const void *node = s->root;
+    for (uint32_t h = s->height; h; h--) {
+        const struct ozinner *in = node;
+        uint32_t i = 0;
+        while (rank >= in->cnt[i]) rank -= in->cnt[i++];
+        node = in->c[i];
+    }
+    it->leaf = node;
+    it->pos = rank;
+}
+
+uint64_t
+ozv_iter_score(struct ozv_iter *it, const osv *v, double min, int exclusive) {
+    // before(s): s 排在区间起点之前
+#define OZ_BEFORE(sc) (exclusive ? (sc) <= min : (sc) < min)
+    it->v = v;
+    it->leaf = NULL;
+    it->pos = 0;
+    uint64_t r = 0;
+    if (v->enc != OSV_ZSET_TREE) {
+        const char *p = v->d, *end = p + v->vlen;
+        for (; p < end && OZ_BEFORE(zp_score(p)); p += ZP_SIZE(p)) r++;
+        it->pos = p - v->d;
+        return r;
+    }
+    const struct ozset *s = ozv_set(v);
+    if (!s->root) return 0;
+    const void *node = s->root;
+    for (uint32_t h = s->height; h; h--) {
+        const struct ozinner *in = node;
+        uint32_t i = 0;
+        while (i + 1 < in->n && OZ_BEFORE(in->k[i + 1].score)) r += in->cnt[i++];
+        node = in->c[i];
+    }
+    const struct ozleaf *lf = node;
+    uint32_t lo = 0, hi = lf->n;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) >> 1;
+        if (OZ_BEFORE(lf->e[mid].score)) lo = mid + 1;
+        else hi = mid;
+    }
+#undef OZ_BEFORE
+    it->leaf = lf;
+    it->pos = lo;
+    return r + lo;
+}
+
+int
+ozv_next(struct ozv_iter *it, const char **m, uint32_t *mlen, double *score) {
+    const osv *v = it->v;
+    if (v->enc != OSV_ZSET_TREE) {
+        if (it->pos >= v->vlen) return 0;
+        const char *p = v->d + it->pos;
+        *score = zp_score(p);
+        *m = ZP_M(p);
+        *mlen = ZP_MLEN(p);
+        it->pos += ZP_SIZE(p);
+        return 1;
+    }
+    while (it->leaf && it->pos >= it->leaf->n) {
+        it->leaf = it->leaf->next;
+        it->pos = 0;
+    }
+    if (!it->leaf) return 0;
+    const struct ozent *e = &it->leaf->e[it->pos++];
+    *score = e->score;
+    *m = e->m;
+    *mlen = e->mlen;
+    return 1;
+}
@@ -0,0 +1,219 @@
+//
+// Created by weishen on 2025/11/2.
+//
+
+#include "otier.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+struct otier_stats otier_stats = {0};
+
+struct spill_pending {
+    uint64_t idx; // slot index
+    uint64_t off; // record offset in file
+};
+
+static int tier_fd = -1;
+static uint64_t clock_hand = 0;
+static char *wbuf = NULL;
+static uint64_t wbuf_used = 0;
+static struct spill_pending *pending = NULL;
+static uint64_t pending_n = 0;
+
+#define PENDING_MAX (OTIER_WBUF_SIZE / OTIER_MIN_SPILL)
+
+static inline uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int pwrite_all(const char *bf, uint64_t len, uint64_t off) {
+    while (len) {
+        ssize_t n = pwrite(tier_fd, bf, len, (off_t) off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        bf += n;
+        off += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int pread_all(char *bf, uint64_t len, uint64_t off) {
+    while (len) {
+        ssize_t n = pread(tier_fd, bf, len, (off_t) off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        if (n == 0) return -EIO; // short file
+        bf += n;
+        off += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/**
+ * Swap the slot's RAM value for a stub pointing at off.
+ * The record is already durable in the file (page cache).
+ */
+static void install_stub(uint64_t idx, uint64_t off) {
+    ohash_t *slot = ohashtabl + idx;
+    osv *v = slot->v;
+    osv *stub = malloc(sizeof(osv) + sizeof(uint64_t));
+    if (!stub) {
+        // 值仍在内存里, 文件中那份就是垃圾
+        otier_stats.dead_bytes += v->vlen;
+        return;
+    }
+    stub->vlen = v->vlen;
+    stub->meta = 0;
+    stub->enc = OSV_COLD;
+    memcpy(stub->d, &off, sizeof(off));
+    slot->v = stub;
+    otier_stats.spilled++;
+    otier_stats.spilled_bytes += v->vlen;
+    free(v);
+}
+
+static int flush_pending(void) {
+    if (!wbuf_used) return 0;
+    int ret = pwrite_all(wbuf, wbuf_used, otier_stats.file_bytes);
+    if (ret < 0) {
+        syslog(LOG_ERR, "otier flush failed : %s", strerror(-ret));
+        wbuf_used = 0;
+        pending_n = 0;
+        return ret;
+    }
+    otier_stats.file_bytes += wbuf_used;
+    for (uint64_t i = 0; i < pending_n; i++)
+        install_stub(pending[i].idx, pending[i].off);
+    wbuf_used = 0;
+    pending_n = 0;
+    return 0;
+}
+
+int
+otier_open(const char *path) {
+    if (!path) return -EINVAL;
+    if (tier_fd >= 0) return -EBUSY;
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) return -errno;
+    wbuf = malloc(OTIER_WBUF_SIZE);
+    pending = malloc(sizeof(struct spill_pending) * PENDING_MAX);
+    if (!wbuf || !pending) {
+        free(wbuf);
+        free(pending);
+        wbuf = NULL;
+        pending = NULL;
+        close(fd);
+        return -ENOMEM;
+    }
+    tier_fd = fd;
+    clock_hand = 0;
+    wbuf_used = 0;
+    pending_n = 0;
+    memset(&otier_stats, 0, sizeof(otier_stats));
+    return OK;
+}
+
+int
+otier_close(void) {
+    if (tier_fd < 0) return -EBADF;
+    close(tier_fd);
+    tier_fd = -1;
+    free(wbuf);
+    free(pending);
+    wbuf = NULL;
+    pending = NULL;
+    return OK;
+}
+
+long long
+otier_evict(uint64_t bytes) {
+    if (tier_fd < 0) return -EBADF;
+    if (!ohashtabl || !cap) return 0;
+    int ret;
+    uint64_t freed = 0, scanned = 0, limit = cap << 1; // 两圈: 第一圈只清 ref
+    while (freed < bytes && scanned++ < limit) {
+        uint64_t idx = clock_hand++ & (cap - 1);
+        ohash_t *slot = ohashtabl + idx;
+        if (!slot->key || slot->tb || slot->rm) continue;
+        osv *v = slot->v;
+        if (v->enc != OSV_RAW || v->vlen < OTIER_MIN_SPILL) continue;
+        if (v->ref) {
+            v->ref = 0; // second chance
+            continue;
+        }
+        if (v->vlen > OTIER_WBUF_SIZE) {
+            // big value: write it straight from the osv, no staging copy
+            if ((ret = flush_pending()) < 0) return ret;
+            uint64_t off = otier_stats.file_bytes;
+            if ((ret = pwrite_all(v->d, v->vlen, off)) < 0) return ret;
+            otier_stats.file_bytes += v->vlen;
+            freed += v->vlen;
+            install_stub(idx, off);
+            continue;
+        }
+        if (wbuf_used + v->vlen > OTIER_WBUF_SIZE || pending_n == PENDING_MAX)
+            if ((ret = flush_pending()) < 0) return ret;
+        memcpy(wbuf + wbuf_used, v->d, v->vlen);
+        pending[pending_n].idx = idx;
+        pending[pending_n].off = otier_stats.file_bytes + wbuf_used;
+        pending_n++;
+        wbuf_used += v->vlen;
+        freed += v->vlen;
+    }
+    if ((ret = flush_pending()) < 0) return ret;
+    return (long long) freed;
+}
+
+osv *
+otier_promote(ohash_t *slot) {
+    if (tier_fd < 0) return NULL;
+    osv *stub = slot->v;
+    uint64_t off;
+    memcpy(&off, stub->d, sizeof(off));
+    osv *v = malloc(sizeof(osv) + stub->vlen);
+    if (!v) return NULL;
+    uint64_t t0 = now_ns();
+    int ret = pread_all(v->d, stub->vlen, off);
+    otier_stats.disk_read_ns += now_ns() - t0;
+    if (ret < 0) {
+        syslog(LOG_ERR, "otier promote failed : %s", strerror(-ret));
+        free(v);
+        return NULL;
+    }
+    v->vlen = stub->vlen;
+    v->meta = 0;
+    v->enc = OSV_RAW;
+    v->ref = 1;
+    slot->v = v;
+    otier_stats.disk_hits++;
+    otier_stats.dead_bytes += v->vlen;
+    free(stub);
+    return v;
+}
+
+void
+otier_prefetch_slot(ohash_t *slot) {
+    if (tier_fd < 0) return;
+    osv *stub = slot->v;
+    if (stub->enc != OSV_COLD) return;
+    uint64_t off;
+    memcpy(&off, stub->d, sizeof(off));
+    posix_fadvise(tier_fd, (off_t) off, (off_t) stub->vlen, POSIX_FADV_WILLNEED);
+}
+
+void
+otier_prefetch(char *key, uint32_t keylen) {
+    if (tier_fd < 0) return;
+    ohash_t *slot = olookup(key, keylen);
+    if (slot) otier_prefetch_slot(slot);
+}
@@ -0,0 +1,151 @@
+//
+// Batch Command Tests for CMD + OHASH
+// Tests: MGET / MSET / multi-key DEL correctness and per-key cost vs single GET
+//
+
+#include "test_cmd_common.h"
+#include <assert.h>
+
+// Test 1: MGET returns hits and nils in argument order
+static void test_mget_order(void) {
+    TEST_START("MGET hits / misses / duplicates");
+
+    SET4dup("ba", 2, "1", 1, 0);
+    SET4dup("bb", 2, "22", 2, 0);
+    obatch_t b[4] = {{.key = "ba", .keylen = 2}, {.key = "nope", .keylen = 4},
+                     {.key = "bb", .keylen = 2}, {.key = "ba", .keylen = 2}};
+    MGET(b, 4);
+    ASSERT_NOT_NULL(b[0].v, "ba should hit");
+    ASSERT_NULL(b[1].v, "nope should miss");
+    ASSERT_NOT_NULL(b[2].v, "bb should hit");
+    ASSERT_TRUE(b[3].v == b[0].v, "duplicate key resolves to the same osv");
+    ASSERT_STR_EQ(((osv *) b[2].v)->d, "22", 2, "bb value");
+
+    TEST_PASS();
+}
+
+// Test 2: MSET is last-writer-wins and survives expansion mid batch
+static void test_mset_semantics(void) {
+    TEST_START("MSET duplicates and expansion");
+
+    uint64_t cap_before = cap;
+    int n = (int) cap; // 一定会触发扩容
+    obatch_t *b = calloc(n + 1, sizeof(obatch_t));
+    char (*keys)[32] = malloc(32 * (n + 1));
+    assert(b && keys);
+    for (int i = 0; i < n; i++) {
+        snprintf(keys[i], 32, "mset_%d", i);
+        b[i].key = keys[i];
+        b[i].keylen = strlen(keys[i]);
+        b[i].v = keys[i];
+        b[i].vlen = b[i].keylen;
+    }
+    b[n].key = keys[0];
+    b[n].keylen = strlen(keys[0]);
+    b[n].v = "last";
+    b[n].vlen = 4;
+    int ret = MSET4dup(b, n + 1, 0);
+    ASSERT_EQ(ret, OK, "MSET should succeed");
+    ASSERT_GT(cap, cap_before, "capacity reserved up front");
+
+    osv *v = GET(keys[0], strlen(keys[0]));
+    ASSERT_NOT_NULL(v, "first key exists");
+    ASSERT_EQ(v->vlen, 4, "duplicate key: last value wins");
+    for (int i = 1; i < n; i++) {
+        v = GET(keys[i], strlen(keys[i]));
+        ASSERT_NOT_NULL(v, "every key exists");
+        ASSERT_STR_EQ(v->d, keys[i], strlen(keys[i]), "value matches");
+    }
+    free(b);
+    free(keys);
+
+    TEST_PASS();
+}
+
+// Test 3: dispatch level replies
+static void test_batch_dispatch(void) {
+    TEST_START("MGET / MSET / DEL through dispatch");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+    assert(cn.write_buffer);
+
+    const char *mset[] = {"MSET", "d1", "v1", "d2", "v22", "d3", "v333"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, mset), "+OK\r\n"), "MSET reply");
+    const char *mset_odd[] = {"MSET", "d1", "v1", "d2"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, mset_odd), "-ERR wrong number", 17), "MSET odd args");
+    const char *mget[] = {"mget", "d1", "zz", "d3"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, mget), "*3\r\n$2\r\nv1\r\n$-1\r\n$4\r\nv333\r\n"), "MGET reply");
+    const char *del[] = {"DEL", "d1", "d2", "zz", "d2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, del), ":2\r\n"), "DEL counts only deleted keys");
+    const char *mget2[] = {"MGET", "d1", "d2", "d3"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, mget2), "*3\r\n$-1\r\n$-1\r\n$4\r\nv333\r\n"), "MGET after DEL");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 4: per-key cost inside MGET vs standalone GET on a table bigger than cache
+static void test_mget_vs_get_benchmark(void) {
+    TEST_START("Per-key cost: MGET batch vs GET");
+
+    const int nkeys = 1 << 20;
+    const int nops = 1 << 20;
+    const int batch_n = 128;
+    char key[32];
+    for (int i = 0; i < nkeys; i++) {
+        int n = snprintf(key, sizeof(key), "bk_%d", i);
+        SET4dup(key, n, key, n, 0);
+    }
+    // 预先生成随机 key, 计时中不含 snprintf
+    char (*keys)[16] = malloc(16 * (size_t) nops);
+    uint32_t *lens = malloc(sizeof(uint32_t) * nops);
+    obatch_t *b = malloc(sizeof(obatch_t) * batch_n);
+    assert(keys && lens && b);
+    srand(7);
+    for (int i = 0; i < nops; i++)
+        lens[i] = snprintf(keys[i], 16, "bk_%d", (int) (((unsigned) rand() * 2654435761U) % nkeys));
+
+    uint64_t sink = 0;
+    double t0 = get_time_ns();
+    for (int i = 0; i < nops; i++) {
+        osv *v = GET(keys[i], lens[i]);
+        sink += v->vlen;
+    }
+    double get_ns = (get_time_ns() - t0) / nops;
+
+    t0 = get_time_ns();
+    for (int i = 0; i < nops; i += batch_n) {
+        for (int j = 0; j < batch_n; j++) {
+            b[j].key = keys[i + j];
+            b[j].keylen = lens[i + j];
+        }
+        MGET(b, batch_n);
+        for (int j = 0; j < batch_n; j++) sink += ((osv *) b[j].v)->vlen;
+    }
+    double mget_ns = (get_time_ns() - t0) / nops;
+
+    printf("\n      Table: %d keys, %d random lookups, batch %d\n", nkeys, nops, batch_n);
+    printf("      GET : %.1f ns/key\n", get_ns);
+    printf("      MGET: %.1f ns/key (%.2fx)\n", mget_ns, get_ns / mget_ns);
+    (void) sink;
+
+    free(keys);
+    free(lens);
+    free(b);
+    ASSERT_LT(mget_ns, get_ns, "batched lookups should be cheaper per key");
+
+    TEST_PASS();
+}
+
+void run_cmd_batch_tests(void) {
+    TEST_SUITE_START("CMD Batch (MGET/MSET/DEL) Tests");
+
+    test_mget_order();
+    test_mset_semantics();
+    test_batch_dispatch();
+    test_mget_vs_get_benchmark();
+
+    TEST_SUITE_END();
+}
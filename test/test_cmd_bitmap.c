@@ -0,0 +1,285 @@
+//
+// Bitmap Tests for CMD + OHASH
+// Tests: popcount / bitop / skip kernels vs scalar, SETBIT / BITCOUNT / BITPOS / BITOP / BITFIELD, 128 MB BITCOUNT
+//
+
+#include "test_cmd_common.h"
+#include "../include/obitmap.h"
+#include <assert.h>
+
+static uint64_t ref_count(const uint8_t *p, uint64_t n) {
+    uint64_t c = 0;
+    for (uint64_t i = 0; i < n; i++)
+        for (int b = 0; b < 8; b++) c += p[i] >> b & 1;
+    return c;
+}
+
+// Test 1: 内核与逐位参考一致 (任意长度 / 不对齐的起点)
+static void test_bitmap_kernels(void) {
+    TEST_START("Bitmap kernels vs scalar reference");
+
+    uint8_t *buf = malloc(4096 + 64), *a = malloc(2048), *b = malloc(2048), *c = malloc(2048);
+    uint8_t *dst = malloc(2048), *ref = malloc(2048);
+    for (int i = 0; i < 4096 + 64; i++) buf[i] = (uint8_t) test_rand64();
+    int ok = 1;
+    for (int round = 0; round < 500 && ok; round++) {
+        uint64_t off = test_rand64() % 64, n = test_rand64() % (round < 250 ? 300 : 4096);
+        if (obit_count(buf + off, n) != ref_count(buf + off, n)) ok = 0;
+    }
+    ASSERT_TRUE(ok, "obit_count");
+
+    ok = 1;
+    for (int round = 0; round < 300 && ok; round++) {
+        uint64_t la = test_rand64() % 2048, lb = test_rand64() % 2048, lc = test_rand64() % 2048;
+        for (uint64_t i = 0; i < 2048; i++) {
+            a[i] = (uint8_t) test_rand64();
+            b[i] = (uint8_t) test_rand64();
+            c[i] = (uint8_t) test_rand64();
+        }
+        const uint8_t *src[] = {a, b, c};
+        uint64_t lens[] = {la, lb, lc};
+        uint64_t len = la > lb ? la : lb;
+        if (lc > len) len = lc;
+        for (int op = OBIT_AND; op <= OBIT_NOT; op++) {
+            int nsrc = op == OBIT_NOT ? 1 : 3;
+            uint64_t l = op == OBIT_NOT ? la : len;
+            for (uint64_t i = 0; i < l; i++) {
+                uint8_t x = i < la ? a[i] : 0, y = i < lb ? b[i] : 0, z = i < lc ? c[i] : 0;
+                ref[i] = op == OBIT_AND ? x & y & z : op == OBIT_OR ? x | y | z : op == OBIT_XOR ? x ^ y ^ z : (uint8_t) ~x;
+            }
+            obit_op(op, dst, l, src, lens, nsrc);
+            if (memcmp(dst, ref, l)) ok = 0;
+        }
+    }
+    ASSERT_TRUE(ok, "obit_op AND / OR / XOR / NOT with uneven lengths");
+
+    ok = 1;
+    for (int round = 0; round < 300 && ok; round++) {
+        uint64_t n = test_rand64() % 2048, at = n ? test_rand64() % n : 0;
+        uint8_t skip = round & 1 ? 0xff : 0x00;
+        memset(a, skip, n);
+        if (round % 5 && n) a[at] = (uint8_t) (skip ^ (1 + test_rand64() % 255));
+        uint64_t want = (round % 5 && n) ? at : n;
+        if (obit_skip(a, n, skip) != want) ok = 0;
+    }
+    ASSERT_TRUE(ok, "obit_skip");
+    ASSERT_EQ(obit_first_in_byte(0x10, 1), 3, "first set bit");
+    ASSERT_EQ(obit_first_in_byte(0xf0, 0), 4, "first clear bit");
+    ASSERT_EQ(obit_first_in_byte(0xff, 0), 8, "no clear bit");
+
+    free(buf);
+    free(a);
+    free(b);
+    free(c);
+    free(dst);
+    free(ref);
+    TEST_PASS();
+}
+
+// Test 2: 命令, 例子取自 Redis 的文档
+static void test_bitmap_dispatch(void) {
+    TEST_START("Bitmap commands through cmd_dispatch");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *setbit[] = {"SETBIT", "dau", "7", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, setbit), ":0\r\n"), "SETBIT new key");
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, setbit), ":1\r\n"), "SETBIT returns the old bit");
+    const char *setbit_far[] = {"SETBIT", "dau", "100", "1"};
+    exec(&cn, 4, setbit_far);
+    const char *strlen_[] = {"STRLEN", "dau"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, strlen_), ":13\r\n"), "grown to 13 bytes");
+    const char *getbit[] = {"GETBIT", "dau", "100"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, getbit), ":1\r\n"), "GETBIT");
+    const char *getbit_far[] = {"GETBIT", "dau", "100000"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, getbit_far), ":0\r\n"), "GETBIT past the end");
+    const char *setbit_bad[] = {"SETBIT", "dau", "-1", "1"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, setbit_bad), "-ERR bit offset", 15), "negative offset");
+    const char *setbit_val[] = {"SETBIT", "dau", "1", "2"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, setbit_val), "-ERR bit is not", 15), "bad bit value");
+
+    const char *set[] = {"SET", "mykey", "foobar"};
+    exec(&cn, 3, set);
+    const char *bc[] = {"BITCOUNT", "mykey"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, bc), ":26\r\n"), "BITCOUNT");
+    const char *bc00[] = {"BITCOUNT", "mykey", "0", "0"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, bc00), ":4\r\n"), "BITCOUNT 0 0");
+    const char *bc11[] = {"BITCOUNT", "mykey", "1", "1", "BYTE"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, bc11), ":6\r\n"), "BITCOUNT 1 1 BYTE");
+    const char *bcbit[] = {"BITCOUNT", "mykey", "5", "30", "BIT"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, bcbit), ":17\r\n"), "BITCOUNT 5 30 BIT");
+    const char *bcneg[] = {"BITCOUNT", "mykey", "-2", "-1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, bcneg), ":7\r\n"), "BITCOUNT negative range");
+    const char *bcbad[] = {"BITCOUNT", "mykey", "0"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, bcbad), "-ERR syntax", 11), "BITCOUNT one index");
+    const char *bcmiss[] = {"BITCOUNT", "nokey"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, bcmiss), ":0\r\n"), "BITCOUNT missing key");
+
+    const char *set_pos[] = {"SET", "pk", "\xff\xf0"};
+    exec(&cn, 3, set_pos);
+    const char *bp0[] = {"BITPOS", "pk", "0"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, bp0), ":12\r\n"), "BITPOS 0");
+    const char *set_pos2[] = {"SET", "pk", "\0\xff\xf0"};
+    const int set_pos2_len[] = {-1, -1, 3};
+    exec_n(&cn, 3, set_pos2, set_pos2_len);
+    const char *bp1[] = {"BITPOS", "pk", "1", "0"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, bp1), ":8\r\n"), "BITPOS 1 0");
+    const char *bp12[] = {"BITPOS", "pk", "1", "2", "-1", "BYTE"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, bp12), ":16\r\n"), "BITPOS 1 2 -1 BYTE");
+    const char *bpbit[] = {"BITPOS", "pk", "1", "7", "15", "BIT"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, bpbit), ":8\r\n"), "BITPOS 1 7 15 BIT");
+    const char *set_ones[] = {"SET", "ones", "\xff\xff\xff"};
+    exec(&cn, 3, set_ones);
+    const char *bpones[] = {"BITPOS", "ones", "0"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, bpones), ":24\r\n"), "BITPOS 0 past the end");
+    const char *bpones_end[] = {"BITPOS", "ones", "0", "0", "-1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, bpones_end), ":-1\r\n"), "BITPOS 0 with end");
+    const char *bpmiss[] = {"BITPOS", "nokey", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, bpmiss), ":-1\r\n"), "BITPOS missing key");
+    // 长一些的 0 串, 整字节走 obit_skip
+    const char *setbit_deep[] = {"SETBIT", "deep", "5003", "1"};
+    exec(&cn, 4, setbit_deep);
+    const char *bpdeep[] = {"BITPOS", "deep", "1", "3"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, bpdeep), ":5003\r\n"), "BITPOS across many zero bytes");
+
+    const char *set1[] = {"SET", "key1", "foobar"};
+    const char *set2[] = {"SET", "key2", "abcdef"};
+    exec(&cn, 3, set1);
+    exec(&cn, 3, set2);
+    const char *bitop_and[] = {"BITOP", "AND", "dest", "key1", "key2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, bitop_and), ":6\r\n"), "BITOP AND");
+    const char *get_dest[] = {"GET", "dest"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, get_dest), "$6\r\n`bc`ab\r\n"), "AND result");
+    const char *bitop_not[] = {"BITOP", "NOT", "key1", "key1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, bitop_not), ":6\r\n"), "BITOP NOT in place of its source");
+    exec(&cn, 4, bitop_not);
+    const char *get_key1[] = {"GET", "key1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, get_key1), "$6\r\nfoobar\r\n"), "NOT twice");
+    const char *bitop_or[] = {"BITOP", "OR", "dest", "key1", "mykey", "nokey"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, bitop_or), ":6\r\n"), "BITOP OR with a missing key");
+    const char *bitop_empty[] = {"BITOP", "XOR", "dest", "nokey"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, bitop_empty), ":0\r\n"), "BITOP of nothing");
+    ASSERT_NULL(olookup("dest", 4), "empty result deletes dest");
+    const char *bitop_bad[] = {"BITOP", "NOT", "dest", "key1", "key2"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 5, bitop_bad), "-ERR BITOP NOT", 14), "NOT takes one key");
+
+    const char *bf1[] = {"BITFIELD", "bf", "INCRBY", "i5", "100", "1", "GET", "u4", "0"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 9, bf1), "*2\r\n:1\r\n:0\r\n"), "BITFIELD INCRBY / GET");
+    const char *bf_sat[] = {"BITFIELD", "ow", "INCRBY", "u2", "100", "1", "OVERFLOW", "SAT", "INCRBY", "u2", "102", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 12, bf_sat), "*2\r\n:1\r\n:1\r\n"), "round 1");
+    exec(&cn, 12, bf_sat);
+    exec(&cn, 12, bf_sat);
+    ASSERT_TRUE(!strcmp(exec(&cn, 12, bf_sat), "*2\r\n:0\r\n:3\r\n"), "WRAP wraps, SAT saturates");
+    const char *bf_fail[] = {"BITFIELD", "ow", "OVERFLOW", "FAIL", "INCRBY", "u2", "102", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, bf_fail), "*1\r\n$-1\r\n"), "FAIL returns nil");
+    const char *bf_set[] = {"BITFIELD", "bs", "SET", "i8", "#1", "-100", "GET", "i8", "8", "GET", "u8", "#1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 12, bf_set), "*3\r\n:0\r\n:-100\r\n:156\r\n"), "BITFIELD SET signed with #offset");
+    const char *bf_i64[] = {"BITFIELD", "b64", "SET", "i64", "0", "9223372036854775807", "INCRBY", "i64", "0", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 10, bf_i64), "*2\r\n:0\r\n:-9223372036854775808\r\n"), "i64 wraps");
+    const char *bf_ro[] = {"BITFIELD", "nokey", "GET", "u8", "0"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, bf_ro), "*1\r\n:0\r\n"), "GET on a missing key");
+    ASSERT_NULL(olookup("nokey", 5), "GET does not create the key");
+    const char *bf_badtype[] = {"BITFIELD", "bs", "GET", "u64", "0"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 5, bf_badtype), "-ERR Invalid bitfield type", 26), "u64 rejected");
+    const char *bf_badop[] = {"BITFIELD", "bs", "SET", "u8", "0"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 5, bf_badop), "-ERR syntax", 11), "SET without value");
+
+    const char *lpush[] = {"LPUSH", "list", "x"};
+    exec(&cn, 3, lpush);
+    const char *setbit_wt[] = {"SETBIT", "list", "1", "1"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, setbit_wt), "-WRONGTYPE", 10), "SETBIT on a list");
+    const char *bc_wt[] = {"BITCOUNT", "list"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 2, bc_wt), "-WRONGTYPE", 10), "BITCOUNT on a list");
+    const char *bitop_wt[] = {"BITOP", "OR", "dest", "key1", "list"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 5, bitop_wt), "-WRONGTYPE", 10), "BITOP with a list");
+
+    // 整数编码的值按十进制字符串处理
+    const char *set_int[] = {"SET", "n", "12"};
+    exec(&cn, 3, set_int);
+    const char *incr[] = {"INCR", "n"};
+    exec(&cn, 2, incr);
+    const char *bc_int[] = {"BITCOUNT", "n"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, bc_int), ":7\r\n"), "BITCOUNT of \"13\"");
+    const char *setbit_int[] = {"SETBIT", "n", "23", "1"};
+    exec(&cn, 4, setbit_int);
+    const char *get_n[] = {"GET", "n"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, get_n), "$3\r\n13\x01\r\n"), "SETBIT on an integer value");
+
+    const char *del[] = {"DEL", "dau", "mykey", "pk", "ones", "deep", "key1", "key2", "bf", "ow", "bs", "b64", "list", "n"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 14, del), ":13\r\n"), "DEL");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 3: 128 MB 的位图
+static void test_bitmap_benchmark(void) {
+    TEST_START("BITCOUNT / BITOP on a 128 MB bitmap");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const uint64_t bytes = 128ULL << 20;
+    char off[24];
+    snprintf(off, sizeof(off), "%llu", (unsigned long long) (bytes * 8 - 1));
+    const char *setbit_a[] = {"SETBIT", "users:a", off, "1"};
+    const char *setbit_b[] = {"SETBIT", "users:b", off, "1"};
+    exec(&cn, 4, setbit_a);
+    exec(&cn, 4, setbit_b);
+    osv *a = olookup("users:a", 7)->v, *b = olookup("users:b", 7)->v;
+    ASSERT_EQ(a->vlen, bytes, "grown to 128 MB");
+    for (uint64_t i = 0; i < bytes; i += 8) {
+        uint64_t r = test_rand64();
+        memcpy(a->d + i, &r, 8);
+        r = test_rand64();
+        memcpy(b->d + i, &r, 8);
+    }
+
+    const char *bc[] = {"BITCOUNT", "users:a"};
+    double t0 = get_time_ns();
+    const char *rep = exec(&cn, 2, bc);
+    double count_ms = (get_time_ns() - t0) / 1e6;
+    long long got = atoll(rep + 1);
+    // 标量参考: 逐 8 字节的 SWAR
+    t0 = get_time_ns();
+    uint64_t want = 0;
+    for (uint64_t i = 0; i < bytes; i += 8) {
+        uint64_t x;
+        memcpy(&x, a->d + i, 8);
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        want += (x * 0x0101010101010101ULL) >> 56;
+    }
+    double scalar_ms = (get_time_ns() - t0) / 1e6;
+    ASSERT_EQ((uint64_t) got, want, "BITCOUNT matches the scalar count");
+
+    const char *bitop[] = {"BITOP", "AND", "users:both", "users:a", "users:b"};
+    t0 = get_time_ns();
+    rep = exec(&cn, 5, bitop);
+    double bitop_ms = (get_time_ns() - t0) / 1e6;
+    ASSERT_TRUE(!strcmp(rep, ":134217728\r\n"), "BITOP AND length");
+
+    printf("\n      BITCOUNT 128 MB : %.2f ms (%.2f GB/s)\n", count_ms, bytes / count_ms / 1e6);
+    printf("      scalar SWAR     : %.2f ms\n", scalar_ms);
+    printf("      BITOP AND 2x128 : %.2f ms\n", bitop_ms);
+    ASSERT_LT(count_ms, 1000, "128 MB BITCOUNT takes milliseconds");
+
+    const char *del[] = {"DEL", "users:a", "users:b", "users:both"};
+    exec(&cn, 4, del);
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+void run_cmd_bitmap_tests(void) {
+    TEST_SUITE_START("CMD Bitmap Tests");
+
+    test_bitmap_kernels();
+    test_bitmap_dispatch();
+    test_bitmap_benchmark();
+
+    TEST_SUITE_END();
+}
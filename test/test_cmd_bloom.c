@@ -0,0 +1,176 @@
+//
+// Bloom Filter Type Tests for CMD + OHASH
+// Tests: blocked layout sizing, false positive rate, scalable layers, NONSCALING, BF.* commands, batched prefetch throughput
+//
+
+#include "test_cmd_common.h"
+
+static uint64_t hash_of(const char *prefix, uint32_t i) {
+    char e[48];
+    return obloom_hash(e, (uint64_t) snprintf(e, sizeof(e), "%s:%u", prefix, i));
+}
+
+/** 插入 "in:[0, n)", 返回 "out:[0, probes)" 中的误判数 */
+static uint32_t fill_and_probe(osv *v, uint32_t n, uint32_t probes, uint32_t *false_neg) {
+    for (uint32_t i = 0; i < n; i++) obloomv_add(v, hash_of("in", i));
+    *false_neg = 0;
+    for (uint32_t i = 0; i < n; i++) *false_neg += !obloomv_exists(v, hash_of("in", i));
+    uint32_t fp = 0;
+    for (uint32_t i = 0; i < probes; i++) fp += obloomv_exists(v, hash_of("out", i));
+    return fp;
+}
+
+// Test 1: 单层的位数 / k / 实测误判率
+static void test_bloom_rate(void) {
+    TEST_START("Blocked layout sizing and false positive rate");
+
+    static const double rates[] = {0.01, 0.001, 0.0001};
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        osv *v = obloomv_new(rates[r], 100000, 0);
+        ASSERT_TRUE(v != NULL, "reserve");
+        struct obloom_layer *l = obloomv_bf(v)->layers;
+        ASSERT_EQ((uintptr_t) l->blocks % OBLOOM_BLOCK, 0, "blocks are cache line aligned");
+        uint32_t fn, fp = fill_and_probe(v, 100000, 1000000, &fn);
+        double rate = fp / 1e6;
+        printf("\n      error %-7g k = %-2u %.2f bits/item  measured %.5f", rates[r], l->k,
+               l->nblocks * OBLOOM_BLOCK * 8.0 / 100000, rate);
+        ASSERT_EQ(fn, 0, "no false negatives");
+        ASSERT_TRUE(rate < rates[r] * 1.5, "measured rate close to the target");
+        ASSERT_GT(obloomv_bf(v)->items, 99000, "items counted, minus false positives while adding");
+        osv_free(v);
+    }
+    printf("\n");
+    TEST_PASS();
+}
+
+// Test 2: 写满后追加层, NONSCALING 写满报错
+static void test_bloom_scale(void) {
+    TEST_START("Scalable layers and NONSCALING");
+
+    osv *v = obloomv_new(0.01, 1000, 2);
+    uint32_t fn, fp = fill_and_probe(v, 20000, 200000, &fn);
+    struct obloom *bf = obloomv_bf(v);
+    ASSERT_EQ(bf->nlayers, 5, "1000 + 2000 + 4000 + 8000 + 16000");
+    ASSERT_EQ(bf->layers[4].capacity, 16000, "capacity doubles per layer");
+    ASSERT_GT(bf->layers[4].k, bf->layers[0].k, "error tightens per layer");
+    ASSERT_EQ(fn, 0, "no false negatives across layers");
+    ASSERT_TRUE(fp / 2e5 < 0.02 * 1.5, "compound rate bounded by error / (1 - tightening)");
+    ASSERT_EQ(obloomv_add(v, hash_of("in", 7)), 0, "existing item in an old layer");
+    osv_free(v);
+
+    v = obloomv_new(0.01, 100, 0);
+    int full = 0;
+    for (uint32_t i = 0; i < 200 && !full; i++) full = obloomv_add(v, hash_of("x", i)) == -ENOSPC;
+    ASSERT_TRUE(full, "NONSCALING filter fills up");
+    ASSERT_EQ(obloomv_bf(v)->nlayers, 1, "no layer added");
+    ASSERT_EQ(obloomv_bf(v)->items, 100, "stops at capacity");
+    osv_free(v);
+    TEST_PASS();
+}
+
+static void test_bloom_dispatch(void) {
+    TEST_START("BF.* commands through cmd_dispatch");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *reserve[] = {"BF.RESERVE", "bf", "0.001", "1000", "EXPANSION", "4"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, reserve), "+OK\r\n"), "BF.RESERVE");
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, reserve), "-ERR item exists\r\n"), "BF.RESERVE existing key");
+    ASSERT_EQ(obloomv_bf((osv *) olookup("bf", 2)->v)->expansion, 4, "EXPANSION");
+    const char *bad_rate[] = {"BF.RESERVE", "x", "1", "1000"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, bad_rate), "-ERR (0 < error rate", 20), "error rate range");
+    const char *bad_cap[] = {"BF.RESERVE", "x", "0.1", "0"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, bad_cap), "-ERR (capacity", 14), "capacity range");
+    const char *bad_opt[] = {"BF.RESERVE", "x", "0.1", "10", "FOO"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, bad_opt), "-ERR syntax error\r\n"), "unknown option");
+
+    const char *add[] = {"bf.add", "bf", "a"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, add), ":1\r\n"), "BF.ADD");
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, add), ":0\r\n"), "BF.ADD existing");
+    const char *madd[] = {"BF.MADD", "bf", "a", "b", "c"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, madd), "*3\r\n:0\r\n:1\r\n:1\r\n"), "BF.MADD");
+    const char *exists[] = {"BF.EXISTS", "bf", "b"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, exists), ":1\r\n"), "BF.EXISTS");
+    const char *mexists[] = {"BF.MEXISTS", "bf", "a", "zz", "c"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, mexists), "*3\r\n:1\r\n:0\r\n:1\r\n"), "BF.MEXISTS");
+    const char *mexists_miss[] = {"BF.MEXISTS", "nokey", "a", "b"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, mexists_miss), "*2\r\n:0\r\n:0\r\n"), "BF.MEXISTS missing key");
+    const char *exists_miss[] = {"BF.EXISTS", "nokey", "a"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, exists_miss), ":0\r\n"), "BF.EXISTS missing key");
+
+    // BF.ADD 自动创建默认参数的 filter
+    const char *add_new[] = {"BF.ADD", "auto", "x"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, add_new), ":1\r\n"), "BF.ADD creates the key");
+    ASSERT_EQ(obloomv_bf((osv *) olookup("auto", 4)->v)->layers[0].capacity, OBLOOM_CAPACITY_DEFAULT,
+              "default capacity");
+
+    // NONSCALING 写满: 数组里的单个错误
+    const char *ns[] = {"BF.RESERVE", "ns", "0.01", "2", "NONSCALING"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, ns), "+OK\r\n"), "BF.RESERVE NONSCALING");
+    const char *ns_add[] = {"BF.MADD", "ns", "1", "2", "3"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, ns_add), "*3\r\n:1\r\n:1\r\n-ERR non scaling filter is full\r\n"),
+                "full NONSCALING filter");
+
+    const char *set[] = {"SET", "str", "v"};
+    exec(&cn, 3, set);
+    const char *add_wt[] = {"BF.ADD", "str", "x"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, add_wt), "-WRONGTYPE", 10), "BF.ADD on a string");
+    const char *reserve_wt[] = {"BF.RESERVE", "str", "0.1", "10"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, reserve_wt), "-ERR item exists\r\n"), "BF.RESERVE on a string");
+
+    const char *del[] = {"DEL", "bf", "auto", "ns", "str"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, del), ":4\r\n"), "DEL frees the layers");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 4: 远大于 LLC 的 filter 上, 逐个查询 vs 每批 OBLOOM_BATCH 个先预取
+static void test_bloom_benchmark(void) {
+    TEST_START("Memory footprint and batched lookups");
+
+    enum { N = 4000000, Q = 2000000 };
+    osv *v = obloomv_new(0.01, N, 0);
+    for (uint32_t i = 0; i < N; i++) obloomv_add(v, hash_of("id", i));
+    uint64_t bytes = obloomv_bytes(v);
+    // 精确集合: 每个成员至少一个 slot (24 字节) + key 副本 (~12 字节) 再除以负载因子
+    double set_bytes = N * (sizeof(ohash_t) + 12.0) / 0.75;
+    printf("\n      %d ids: bloom %.1f MB, exact set >= %.1f MB", N, bytes / 1048576.0, set_bytes / 1048576.0);
+    ASSERT_LT(bytes * 10, (uint64_t) set_bytes, "an order of magnitude smaller than the exact set");
+
+    uint64_t *h = malloc(sizeof(uint64_t) * Q);
+    for (uint32_t i = 0; i < Q; i++) h[i] = hash_of(i & 1 ? "id" : "no", i);
+
+    uint64_t hits1 = 0, hits2 = 0;
+    double t0 = get_time_ns();
+    for (uint32_t i = 0; i < Q; i++) hits1 += obloomv_exists(v, h[i]);
+    double single_ns = get_time_ns() - t0;
+    t0 = get_time_ns();
+    for (uint32_t i = 0; i < Q; i += OBLOOM_BATCH) {
+        for (uint32_t j = i; j < i + OBLOOM_BATCH; j++) obloomv_prefetch(v, h[j]);
+        for (uint32_t j = i; j < i + OBLOOM_BATCH; j++) hits2 += obloomv_exists(v, h[j]);
+    }
+    double batch_ns = get_time_ns() - t0;
+    ASSERT_EQ(hits1, hits2, "same answers");
+    ASSERT_GT(hits1, Q / 2 - 1, "every inserted id is found");
+    printf("\n      one by one : %.1f ns/lookup", single_ns / Q);
+    printf("\n      prefetched : %.1f ns/lookup\n", batch_ns / Q);
+    ASSERT_LT(batch_ns / 1e6, 5000, "lookups stay fast");
+
+    free(h);
+    osv_free(v);
+    TEST_PASS();
+}
+
+void run_cmd_bloom_tests(void) {
+    TEST_SUITE_START("CMD Bloom Filter Type Tests");
+
+    test_bloom_rate();
+    test_bloom_scale();
+    test_bloom_dispatch();
+    test_bloom_benchmark();
+
+    TEST_SUITE_END();
+}
@@ -0,0 +1,45 @@
+//
+// Created by weishen on 2025/11/17.
+//
+
+//
+// CMD Test Helpers - 各 test_cmd_*.c 共用的计时与内存连接执行
+//
+#ifndef TEST_CMD_COMMON_H
+#define TEST_CMD_COMMON_H
+
+#include "test_common_framework.h"
+#include "../include/cmd_dispatch.h"
+
+static inline double get_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+#define EXEC_ARGV_MAX 64
+
+/**
+ * 在内存中的连接上执行一条命令, 返回回复 (以 \0 结尾)
+ * 参数可以含 \0: lens 为 NULL 或 lens[i] < 0 时按 strlen
+ */
+static inline const char *exec_n(struct connection_t *cn, int argc, const char **args, const int *lens) {
+    struct element argv[EXEC_ARGV_MAX];
+    assert(argc > 0 && argc <= EXEC_ARGV_MAX);
+    for (int i = 0; i < argc; i++) {
+        argv[i].type = BULK_STRINGS;
+        argv[i].data = (char *) args[i];
+        argv[i].len = lens && lens[i] >= 0 ? (uint32_t) lens[i] : strlen(args[i]);
+    }
+    cn->wb_limit = 0;
+    cn->wb_offset = 0;
+    cmd_dispatch(cn, argv, argc);
+    reply_raw(cn, "", 1);
+    return cn->write_buffer;
+}
+
+static inline const char *exec(struct connection_t *cn, int argc, const char **args) {
+    return exec_n(cn, argc, args, NULL);
+}
+
+#endif //TEST_CMD_COMMON_H
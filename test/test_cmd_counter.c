@@ -0,0 +1,164 @@
+//
+// Counter Command Tests for CMD + OHASH
+// Tests: INCR/DECR/INCRBY/DECRBY/INCRBYFLOAT semantics and in-place cost vs GET+SET
+//
+
+#include "test_cmd_common.h"
+#include <assert.h>
+
+// Test 1: strict integer parsing
+static void test_string2ll(void) {
+    TEST_START("string2ll strict parsing");
+
+    int64_t n;
+    ASSERT_EQ(string2ll("0", 1, &n), 0, "zero");
+    ASSERT_EQ(n, 0, "zero value");
+    ASSERT_EQ(string2ll("-42", 3, &n), 0, "negative");
+    ASSERT_EQ(n, -42, "negative value");
+    ASSERT_EQ(string2ll("9223372036854775807", 19, &n), 0, "INT64_MAX");
+    ASSERT_TRUE(n == INT64_MAX, "INT64_MAX value");
+    ASSERT_EQ(string2ll("-9223372036854775808", 20, &n), 0, "INT64_MIN");
+    ASSERT_TRUE(n == INT64_MIN, "INT64_MIN value");
+    ASSERT_EQ(string2ll("9223372036854775808", 19, &n), -EINVAL, "overflow");
+    ASSERT_EQ(string2ll("18446744073709551616", 20, &n), -EINVAL, "u64 overflow");
+    ASSERT_EQ(string2ll("01", 2, &n), -EINVAL, "leading zero");
+    ASSERT_EQ(string2ll("-0", 2, &n), -EINVAL, "negative zero");
+    ASSERT_EQ(string2ll("+1", 2, &n), -EINVAL, "plus sign");
+    ASSERT_EQ(string2ll(" 1", 2, &n), -EINVAL, "space");
+    ASSERT_EQ(string2ll("-", 1, &n), -EINVAL, "lone minus");
+    ASSERT_EQ(string2ll("", 0, &n), -EINVAL, "empty");
+
+    TEST_PASS();
+}
+
+// Test 2: INCRBY keeps the value as OSV_INT and updates it in place
+static void test_incr_in_place(void) {
+    TEST_START("INCRBY in place on OSV_INT");
+
+    int64_t n;
+    ASSERT_EQ(INCRBY("c1", 2, 5, &n), 0, "INCRBY on missing key");
+    ASSERT_EQ(n, 5, "missing key counts from 0");
+    osv *v = GET("c1", 2);
+    ASSERT_NOT_NULL(v, "counter exists");
+    ASSERT_EQ(v->enc, OSV_INT, "stored natively");
+    ASSERT_EQ(INCRBY("c1", 2, -7, &n), 0, "negative increment");
+    ASSERT_EQ(n, -2, "5 - 7");
+    ASSERT_TRUE(GET("c1", 2) == v, "no reallocation");
+
+    // 字符串值第一次 INCR 时转成 OSV_INT, 过期时间保留
+    SET4dup("c2", 2, "100", 3, get_current_time_ms() + 1000000);
+    ASSERT_EQ(INCRBY("c2", 2, 1, &n), 0, "INCR on string value");
+    ASSERT_EQ(n, 101, "string parsed");
+    ASSERT_EQ(GET("c2", 2)->enc, OSV_INT, "converted");
+    ASSERT_TRUE(olookup("c2", 2)->expiratime > 0, "TTL kept");
+
+    SET4dup("c3", 2, "abc", 3, 0);
+    ASSERT_EQ(INCRBY("c3", 2, 1, &n), -EINVAL, "not an integer");
+    ASSERT_EQ(GET("c3", 2)->enc, OSV_RAW, "left untouched");
+
+    SET4dup("c4", 2, "9223372036854775807", 19, 0);
+    ASSERT_EQ(INCRBY("c4", 2, 1, &n), -ERANGE, "overflow");
+    ASSERT_TRUE(osv_int(GET("c4", 2)) == INT64_MAX, "value unchanged on overflow");
+
+    TEST_PASS();
+}
+
+// Test 3: dispatch level replies, GET formats OSV_INT
+static void test_counter_dispatch(void) {
+    TEST_START("INCR family through dispatch");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+    assert(cn.write_buffer);
+
+    const char *incr[] = {"INCR", "dc"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, incr), ":1\r\n"), "INCR new key");
+    const char *incrby[] = {"incrby", "dc", "41"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, incrby), ":42\r\n"), "INCRBY");
+    const char *decr[] = {"DECR", "dc"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, decr), ":41\r\n"), "DECR");
+    const char *decrby[] = {"DECRBY", "dc", "50"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, decrby), ":-9\r\n"), "DECRBY");
+    const char *get[] = {"GET", "dc"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, get), "$2\r\n-9\r\n"), "GET formats the integer");
+    const char *mget[] = {"MGET", "dc", "nx"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, mget), "*2\r\n$2\r\n-9\r\n$-1\r\n"), "MGET formats the integer");
+
+    const char *badby[] = {"INCRBY", "dc", "1x"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, badby), "-ERR value is not an integer or out of range\r\n"),
+                "bad increment");
+    const char *minby[] = {"DECRBY", "dc", "-9223372036854775808"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, minby), "-ERR decrement would overflow\r\n"), "DECRBY INT64_MIN");
+
+    const char *fset[] = {"SET", "fl", "10.5"};
+    exec(&cn, 3, fset);
+    const char *fincr[] = {"INCRBYFLOAT", "fl", "0.1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, fincr), "$4\r\n10.6\r\n"), "INCRBYFLOAT");
+    const char *fincr2[] = {"incrbyfloat", "dc", "1.5"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, fincr2), "$4\r\n-7.5\r\n"), "INCRBYFLOAT on OSV_INT");
+    const char *fincr3[] = {"INCRBYFLOAT", "dc", "7.5"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, fincr3), "$1\r\n0\r\n"), "trailing zeros trimmed");
+    const char *fbad[] = {"INCRBYFLOAT", "dc", "abc"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, fbad), "-ERR value is not a valid float\r\n"), "bad float");
+    const char *incr_after[] = {"INCR", "dc"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, incr_after), ":1\r\n"), "INCR after INCRBYFLOAT wrote an integer");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 4: INCR in place vs the GET + parse + format + SET4dup emulation
+static void test_incr_benchmark(void) {
+    TEST_START("INCR in place vs GET+SET emulation");
+
+    const int ncounters = 1000;
+    const int nops = 2000000;
+    char (*keys)[16] = malloc(16 * (size_t) ncounters);
+    uint32_t *lens = malloc(sizeof(uint32_t) * ncounters);
+    assert(keys && lens);
+    for (int i = 0; i < ncounters; i++) lens[i] = snprintf(keys[i], 16, "ctr_%d", i);
+
+    int64_t n = 0;
+    double t0 = get_time_ns();
+    for (int i = 0; i < nops; i++) {
+        int k = i % ncounters;
+        INCRBY(keys[k], lens[k], 1, &n);
+    }
+    double incr_ns = (get_time_ns() - t0) / nops;
+    ASSERT_EQ(n, nops / ncounters, "every counter reached nops / ncounters");
+
+    t0 = get_time_ns();
+    for (int i = 0; i < nops; i++) {
+        int k = i % ncounters;
+        char bf[24];
+        int64_t cur = 0;
+        osv *v = GET(keys[k] + 1, lens[k] - 1); // 另一组 key, 避开 OSV_INT
+        if (v) string2ll(v->d, v->vlen, &cur);
+        int len = snprintf(bf, sizeof(bf), "%" PRId64, cur + 1);
+        SET4dup(keys[k] + 1, lens[k] - 1, bf, len, 0);
+    }
+    double emu_ns = (get_time_ns() - t0) / nops;
+    osv *v = GET(keys[0] + 1, lens[0] - 1);
+    ASSERT_STR_EQ(v->d, "2000", 4, "emulated counter");
+
+    printf("\n      %d counters, %d increments\n", ncounters, nops);
+    printf("      INCR in place : %.1f ns/op\n", incr_ns);
+    printf("      GET+SET4dup   : %.1f ns/op (%.2fx)\n", emu_ns, emu_ns / incr_ns);
+    free(keys);
+    free(lens);
+    ASSERT_LT(incr_ns, emu_ns, "in place increment should be cheaper");
+
+    TEST_PASS();
+}
+
+void run_cmd_counter_tests(void) {
+    TEST_SUITE_START("CMD Counter (INCR family) Tests");
+
+    test_string2ll();
+    test_incr_in_place();
+    test_counter_dispatch();
+    test_incr_benchmark();
+
+    TEST_SUITE_END();
+}
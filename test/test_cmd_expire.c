@@ -0,0 +1,173 @@
+//
+// Millisecond Expiry Tests for CMD + OHASH
+// Tests: PEXPIRE/PTTL/TTL/PERSIST, sub-second TTLs, cached clock cost on the lookup path
+//
+
+#include "test_cmd_common.h"
+#include <assert.h>
+
+/** ":<n>\r\n" -> n */
+static long long reply_num(const char *r) {
+    return r[0] == ':' ? strtoll(r + 1, NULL, 10) : LLONG_MIN;
+}
+
+// Test 1: sub-second TTLs expire on time, not a whole second late
+static void test_ms_expiry(void) {
+    TEST_START("Sub-second TTL precision");
+
+    uint64_t now = get_current_time_ms();
+    SET4dup("ms50", 4, "v", 1, now + 50);
+    SET4dup("ms300", 5, "v", 1, now + 300);
+    ASSERT_NOT_NULL(GET("ms50", 4), "alive before 50 ms");
+    usleep(80 * 1000);
+    ASSERT_NULL(GET("ms50", 4), "gone after 80 ms");
+    ASSERT_NOT_NULL(GET("ms300", 5), "300 ms key still alive");
+    usleep(250 * 1000);
+    ASSERT_NULL(GET("ms300", 5), "gone after 330 ms");
+
+    // 2106 年之后的时间点也能表示
+    SET4dup("far", 3, "v", 1, 5000000000000ULL);
+    ASSERT_NOT_NULL(GET("far", 3), "expiry beyond 2106");
+    ASSERT_TRUE(olookup("far", 3)->expiratime == 5000000000000ULL, "stored without truncation");
+
+    TEST_PASS();
+}
+
+// Test 2: the cached clock is what lookups compare against
+static void test_cached_clock(void) {
+    TEST_START("Cached clock drives expiry");
+
+    uint64_t frozen = oclock_tick();
+    SET4dup("clk", 3, "v", 1, frozen + 20);
+    usleep(40 * 1000);
+    ASSERT_NOT_NULL(GET("clk", 3), "same batch: still the frozen now");
+    oclock_tick();
+    ASSERT_NULL(GET("clk", 3), "next tick sees it expired");
+
+    // 真正的一批: cmd_on_read 结束时清掉缓存时钟, 之后直接调用的路径重新现读
+    static const char req[] = "*5\r\n$3\r\nSET\r\n$4\r\nclk2\r\n$1\r\nv\r\n$2\r\nPX\r\n$2\r\n20\r\n";
+    struct connection_t cn = {0};
+    cn.read_buffer = malloc(sizeof(req));
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+    assert(cn.read_buffer && cn.write_buffer);
+    memcpy(cn.read_buffer, req, sizeof(req) - 1);
+    cn.rb_size = sizeof(req) - 1;
+    ASSERT_EQ(cmd_on_read(&cn), 0, "batch handled");
+    ASSERT_TRUE(cn.wb_limit == 5 && !memcmp(cn.write_buffer, "+OK\r\n", 5), "SET PX replied");
+    ASSERT_EQ(ohash_clock_ms, 0, "batch leaves the clock live");
+    usleep(40 * 1000);
+    ASSERT_NULL(GET("clk2", 4), "outside a batch now moves");
+    cn.use_data_free(cn.use_data);
+    free(cn.read_buffer);
+    free(cn.write_buffer);
+
+    TEST_PASS();
+}
+
+// Test 3: dispatch level PEXPIRE / PTTL / TTL / PERSIST / EXPIRE
+static void test_expire_dispatch(void) {
+    TEST_START("PEXPIRE/PTTL/TTL/PERSIST through dispatch");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+    assert(cn.write_buffer);
+
+    const char *set[] = {"SET", "ek", "v"};
+    exec(&cn, 3, set);
+    const char *pttl[] = {"PTTL", "ek"};
+    const char *ttl[] = {"TTL", "ek"};
+    ASSERT_EQ(reply_num(exec(&cn, 2, pttl)), -1, "no TTL");
+    const char *pttl_nx[] = {"PTTL", "nx"};
+    ASSERT_EQ(reply_num(exec(&cn, 2, pttl_nx)), -2, "missing key");
+
+    const char *pex[] = {"PEXPIRE", "ek", "1500"};
+    ASSERT_EQ(reply_num(exec(&cn, 3, pex)), 1, "PEXPIRE");
+    long long left = reply_num(exec(&cn, 2, pttl));
+    ASSERT_TRUE(left > 1400 && left <= 1500, "PTTL in ms");
+    ASSERT_EQ(reply_num(exec(&cn, 2, ttl)), 2, "TTL rounds to the nearest second");
+
+    const char *persist[] = {"PERSIST", "ek"};
+    ASSERT_EQ(reply_num(exec(&cn, 2, persist)), 1, "PERSIST removes the TTL");
+    ASSERT_EQ(reply_num(exec(&cn, 2, persist)), 0, "PERSIST without TTL");
+    ASSERT_EQ(reply_num(exec(&cn, 2, pttl)), -1, "no TTL after PERSIST");
+
+    const char *ex[] = {"EXPIRE", "ek", "100"};
+    ASSERT_EQ(reply_num(exec(&cn, 3, ex)), 1, "EXPIRE");
+    left = reply_num(exec(&cn, 2, pttl));
+    ASSERT_TRUE(left > 99000 && left <= 100000, "EXPIRE stored in ms");
+    const char *ex_nx[] = {"EXPIRE", "nx", "100"};
+    ASSERT_EQ(reply_num(exec(&cn, 3, ex_nx)), 0, "EXPIRE on missing key");
+    const char *ex_bad[] = {"PEXPIRE", "ek", "1.5"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, ex_bad), "-ERR value is not an integer or out of range\r\n"), "bad ms");
+    const char *ex_big[] = {"EXPIRE", "ek", "9223372036854775807"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, ex_big), "-ERR invalid expire time in 'expire' command\r\n"), "overflow");
+
+    const char *pex_neg[] = {"PEXPIRE", "ek", "-1"};
+    ASSERT_EQ(reply_num(exec(&cn, 3, pex_neg)), 1, "non-positive TTL deletes");
+    const char *get[] = {"GET", "ek"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, get), "$-1\r\n"), "deleted");
+
+    const char *setpx[] = {"SET", "ek", "v", "PX", "60"};
+    exec(&cn, 5, setpx);
+    usleep(90 * 1000);
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, get), "$-1\r\n"), "SET PX 60 gone after 90 ms");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 4: lookup cost, live clock per probe vs cached clock
+static void test_cached_clock_benchmark(void) {
+    TEST_START("Lookup cost: live clock vs cached clock");
+
+    const int nkeys = 1 << 16;
+    const int nops = 1 << 22;
+    char (*keys)[16] = malloc(16 * (size_t) nkeys);
+    uint32_t *lens = malloc(sizeof(uint32_t) * nkeys);
+    assert(keys && lens);
+    uint64_t far = get_current_time_ms() + 3600000;
+    for (int i = 0; i < nkeys; i++) {
+        lens[i] = snprintf(keys[i], 16, "ck_%d", i);
+        SET4dup(keys[i], lens[i], "v", 1, far);
+    }
+
+    uint64_t sink = 0;
+    double t0 = get_time_ns();
+    for (int i = 0; i < nops; i++) {
+        int k = i & (nkeys - 1);
+        sink += (uintptr_t) olookup(keys[k], lens[k]);
+    }
+    double live_ns = (get_time_ns() - t0) / nops;
+
+    t0 = get_time_ns();
+    for (int i = 0; i < nops; i++) {
+        int k = i & (nkeys - 1);
+        if (!(k & 63)) oclock_tick(); // 模拟事件循环: 每 64 条命令刷新一次
+        sink += (uintptr_t) olookup(keys[k], lens[k]);
+    }
+    double cached_ns = (get_time_ns() - t0) / nops;
+    oclock_reset(); // 批次结束
+    (void) sink;
+
+    printf("\n      %d keys with TTL, %d lookups\n", nkeys, nops);
+    printf("      live clock   : %.1f ns/op\n", live_ns);
+    printf("      cached clock : %.1f ns/op (%.2fx)\n", cached_ns, live_ns / cached_ns);
+    free(keys);
+    free(lens);
+    ASSERT_LT(cached_ns, live_ns, "cached clock should remove the per-probe clock read");
+
+    TEST_PASS();
+}
+
+void run_cmd_expire_tests(void) {
+    TEST_SUITE_START("CMD Millisecond Expiry Tests");
+
+    test_ms_expiry();
+    test_cached_clock();
+    test_expire_dispatch();
+    test_cached_clock_benchmark();
+
+    TEST_SUITE_END();
+}
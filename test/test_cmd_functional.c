@@ -103,7 +103,7 @@ static void test_expired_immediate(void) {
     const char *key = "expire_key";
     const char *value = "expire_value";
     uint32_t keylen = strlen(key);
-    uint32_t expiratime = (uint32_t) get_current_time_seconds() - 1; // Already expired
+    uint64_t expiratime = get_current_time_ms() - 1000; // Already expired
 
     // Insert with past expiration
     int ret = SET4dup(key, keylen, value, strlen(value), expiratime);
@@ -123,7 +123,7 @@ static void test_expired_future(void) {
     const char *key = "future_expire_key";
     const char *value = "future_value";
     uint32_t keylen = strlen(key);
-    uint32_t expiratime = (uint32_t) get_current_time_seconds() + 10; // 10 seconds from now
+    uint64_t expiratime = get_current_time_ms() + 10000; // 10 seconds from now
 
     // Insert with future expiration
     int ret = SET4dup(key, keylen, value, strlen(value), expiratime);
@@ -149,7 +149,7 @@ static void test_update_expiration(void) {
     ASSERT_EQ(ret, OK, "SET should succeed");
 
     // Set expiration in future
-    uint32_t new_expiratime = (uint32_t) get_current_time_seconds() + 100;
+    uint64_t new_expiratime = get_current_time_ms() + 100000;
     ret = EXPIRED((char *) key, keylen, new_expiratime);
     ASSERT_EQ(ret, 0, "EXPIRED should return 0");
 
@@ -389,7 +389,7 @@ static void test_expired_key_replacement(void) {
     uint32_t keylen = strlen(key);
 
     // Insert with immediate expiration
-    uint32_t past_time = (uint32_t) get_current_time_seconds() - 1;
+    uint64_t past_time = get_current_time_ms() - 1000;
     int ret = SET4dup(key, keylen, value1, strlen(value1), past_time);
     ASSERT_EQ(ret, OK, "SET with expiration should succeed");
 
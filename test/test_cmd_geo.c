@@ -0,0 +1,346 @@
+//
+// Geo Command Tests for CMD + OHASH
+// Tests: geohash encoding, neighbour ranges against brute force, vectorized distance filter, GEO* commands, latency
+//
+
+#include "test_cmd_common.h"
+#include "../include/ogeo.h"
+#include <math.h>
+
+static double frand(double lo, double hi) {
+    return lo + (hi - lo) * (double) (test_rand64() >> 11) / (double) (1ULL << 53);
+}
+
+/** 参考实现: 与 Redis 的 geohashGetDistanceIfInRectangle 相同 */
+static int ref_within(const struct ogeo_shape *s, double lon, double lat) {
+    if (!s->box) return ogeo_dist(s->lon, s->lat, lon, lat) <= s->radius;
+    if (OGEO_EARTH_RADIUS * fabs((lat - s->lat) * M_PI / 180) > s->height / 2) return 0;
+    return ogeo_dist(lon, lat, s->lon, lat) <= s->width / 2;
+}
+
+// Test 1: encoding matches Redis scores
+static void test_geo_encode(void) {
+    TEST_START("geohash encode / decode");
+
+    ASSERT_TRUE(ogeo_encode(13.361389, 38.115556) == 3479099956230698ULL, "Palermo score");
+    ASSERT_TRUE(ogeo_encode(15.087269, 37.502669) == 3479447370796909ULL, "Catania score");
+    double lon, lat;
+    ogeo_decode(3479099956230698ULL, &lon, &lat);
+    ASSERT_TRUE(fabs(lon - 13.361389) < 1e-5 && fabs(lat - 38.115556) < 1e-5, "decode near input");
+    ASSERT_TRUE(ogeo_encode(180, OGEO_LAT_MAX) < (1ULL << 52), "upper corner stays in 52 bits");
+    ASSERT_TRUE(ogeo_encode(-180, OGEO_LAT_MIN) == 0, "lower corner");
+
+    int ok = 1;
+    for (int i = 0; i < 10000; i++) {
+        double x = frand(-180, 180), y = frand(OGEO_LAT_MIN, OGEO_LAT_MAX);
+        uint64_t h = ogeo_encode(x, y);
+        ogeo_decode(h, &lon, &lat);
+        if (ogeo_encode(lon, lat) != h || fabs(lon - x) > 1e-5 || fabs(lat - y) > 1e-5) ok = 0;
+    }
+    ASSERT_TRUE(ok, "decode lands in the same cell");
+
+    TEST_PASS();
+}
+
+// Test 2: every point inside the shape falls in one of the neighbour ranges
+static void test_geo_ranges(void) {
+    TEST_START("neighbour ranges cover the shape");
+
+    struct ogeo_shape shapes[] = {
+        {.lon = 116.4, .lat = 39.9, .radius = 1000},
+        {.lon = 179.99, .lat = 10, .radius = 50000},       // 跨日期变更线
+        {.lon = -179.99, .lat = -10, .box = 1, .width = 80000, .height = 30000},
+        {.lon = 0, .lat = 84.5, .radius = 200000},         // 靠近纬度上限
+        {.lon = 20, .lat = -60, .box = 1, .width = 3000000, .height = 1000000},
+        {.lon = -70, .lat = 30, .radius = 9000000},        // 大半个地球
+        {.lon = 10, .lat = 10, .radius = 0},
+    };
+    int covered = 1, nranges = 1;
+    for (size_t k = 0; k < sizeof(shapes) / sizeof(shapes[0]); k++) {
+        struct ogeo_shape *s = &shapes[k];
+        struct ogeo_range r[OGEO_RANGES_MAX];
+        uint32_t nr = ogeo_ranges(s, r);
+        if (nr < 1 || nr > OGEO_RANGES_MAX) nranges = 0;
+        double span = s->box ? fmax(s->width, s->height) : s->radius;
+        double deg = span / OGEO_EARTH_RADIUS * 180 / M_PI * 1.5 + 1e-4;
+        for (int i = 0; i < 20000; i++) {
+            double lat = s->lat + frand(-deg, deg), lon = s->lon + frand(-deg, deg) / fmax(cos(lat * M_PI / 180), 0.05);
+            while (lon > 180) lon -= 360;
+            while (lon < -180) lon += 360;
+            if (lat > OGEO_LAT_MAX || lat < OGEO_LAT_MIN) continue;
+            double dlon, dlat;
+            uint64_t h = ogeo_encode(lon, lat);
+            ogeo_decode(h, &dlon, &dlat);
+            if (!ref_within(s, dlon, dlat)) continue;
+            int in = 0;
+            for (uint32_t j = 0; j < nr; j++) in |= h >= r[j].min && h < r[j].max;
+            if (!in) covered = 0;
+        }
+    }
+    ASSERT_TRUE(nranges, "1 .. 9 ranges");
+    ASSERT_TRUE(covered, "no point inside the shape is outside the ranges");
+
+    TEST_PASS();
+}
+
+// Test 3: the vectorized filter agrees with the scalar reference
+static void test_geo_within(void) {
+    TEST_START("ogeo_within vs scalar reference");
+
+    enum { N = 4099 };
+    static double lon[N], lat[N], dist[N];
+    static uint32_t idx[N];
+    int same = 1;
+    for (int round = 0; round < 40; round++) {
+        struct ogeo_shape s = {.lon = frand(-180, 180), .lat = frand(-80, 80)};
+        double deg = round < 20 ? 0.05 : 20;
+        s.box = round & 1;
+        s.radius = deg * 111000 * 0.6;
+        s.width = deg * 111000 * frand(0.2, 1.5);
+        s.height = deg * 111000 * frand(0.2, 1.5);
+        for (int i = 0; i < N; i++) {
+            lat[i] = fmax(fmin(s.lat + frand(-deg, deg), OGEO_LAT_MAX), OGEO_LAT_MIN);
+            lon[i] = s.lon + frand(-deg, deg);
+            if (lon[i] > 180) lon[i] -= 360;
+            if (lon[i] < -180) lon[i] += 360;
+        }
+        // 一部分点正好放在边界上
+        for (int i = 0; i < 64 && !s.box; i++) {
+            double b = frand(0, 2 * M_PI), t = s.radius / OGEO_EARTH_RADIUS, la = s.lat * M_PI / 180;
+            double la2 = asin(sin(la) * cos(t) + cos(la) * sin(t) * cos(b));
+            double lo2 = s.lon * M_PI / 180 + atan2(sin(b) * sin(t) * cos(la), cos(t) - sin(la) * sin(la2));
+            lat[i] = la2 * 180 / M_PI;
+            lon[i] = remainder(lo2 * 180 / M_PI, 360);
+        }
+        uint32_t n = ogeo_within(&s, lon, lat, N, idx, dist);
+        uint32_t j = 0;
+        for (uint32_t i = 0; i < N; i++) {
+            if (!ref_within(&s, lon[i], lat[i])) continue;
+            if (j >= n || idx[j] != i || dist[j] != ogeo_dist(s.lon, s.lat, lon[i], lat[i])) same = 0;
+            j++;
+        }
+        if (j != n) same = 0;
+    }
+    ASSERT_TRUE(same, "same points and distances");
+
+    TEST_PASS();
+}
+
+// Test 4: GEOADD / GEODIST / GEOSEARCH against the Redis documentation examples
+static void test_geo_commands(void) {
+    TEST_START("GEOADD / GEODIST / GEOSEARCH");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *add[] = {"GEOADD", "Sicily", "13.361389", "38.115556", "Palermo", "15.087269", "37.502669", "Catania"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, add), ":2\r\n"), "GEOADD");
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, add), ":0\r\n"), "GEOADD again");
+    const char *zs[] = {"ZSCORE", "Sicily", "Palermo"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, zs), "$16\r\n3479099956230698\r\n"), "stored as a sorted set");
+
+    const char *d1[] = {"GEODIST", "Sicily", "Palermo", "Catania"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, d1), "$11\r\n166274.1516\r\n"), "GEODIST m");
+    const char *d2[] = {"GEODIST", "Sicily", "Palermo", "Catania", "km"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, d2), "$8\r\n166.2742\r\n"), "GEODIST km");
+    const char *d3[] = {"GEODIST", "Sicily", "Palermo", "Catania", "MI"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, d3), "$8\r\n103.3182\r\n"), "GEODIST mi");
+    const char *d4[] = {"GEODIST", "Sicily", "Palermo", "Nope"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, d4), "$-1\r\n"), "GEODIST missing member");
+
+    const char *edge[] = {"GEOADD", "Sicily", "12.758489", "38.788135", "edge1", "17.241510", "38.788135", "edge2"};
+    exec(&cn, 8, edge);
+    const char *s1[] = {"GEOSEARCH", "Sicily", "FROMLONLAT", "15", "37", "BYRADIUS", "200", "km", "ASC"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 9, s1), "*2\r\n$7\r\nCatania\r\n$7\r\nPalermo\r\n"), "BYRADIUS");
+    const char *s2[] = {"GEOSEARCH", "Sicily", "FROMLONLAT", "15", "37", "BYBOX", "400", "400", "km", "ASC",
+                        "WITHCOORD", "WITHDIST"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 12, s2),
+                        "*4\r\n"
+                        "*3\r\n$7\r\nCatania\r\n$7\r\n56.4413\r\n"
+                        "*2\r\n$20\r\n15.08726745843887329\r\n$20\r\n37.50266842333162032\r\n"
+                        "*3\r\n$7\r\nPalermo\r\n$8\r\n190.4424\r\n"
+                        "*2\r\n$20\r\n13.36138933897018433\r\n$20\r\n38.11555639549629859\r\n"
+                        "*3\r\n$5\r\nedge2\r\n$8\r\n279.7403\r\n"
+                        "*2\r\n$20\r\n17.24151045083999634\r\n$20\r\n38.78813451624225195\r\n"
+                        "*3\r\n$5\r\nedge1\r\n$8\r\n279.7405\r\n"
+                        "*2\r\n$19\r\n12.7584877610206604\r\n$20\r\n38.78813451624225195\r\n"),
+                "BYBOX WITHCOORD WITHDIST");
+    const char *s3[] = {"GEOSEARCH", "Sicily", "FROMMEMBER", "Palermo", "BYRADIUS", "200", "km", "DESC", "COUNT", "1",
+                        "WITHHASH"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 11, s3), "*1\r\n*2\r\n$7\r\nCatania\r\n:3479447370796909\r\n"), "FROMMEMBER DESC COUNT");
+    const char *s4[] = {"GEOSEARCH", "nokey", "FROMLONLAT", "15", "37", "BYRADIUS", "200", "km"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, s4), "*0\r\n"), "missing key");
+
+    const char *xx[] = {"GEOADD", "Sicily", "XX", "CH", "13.5", "38.1", "Palermo", "1", "1", "New"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 10, xx), ":1\r\n"), "XX CH updates, does not add");
+    const char *card[] = {"ZCARD", "Sicily"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, card), ":4\r\n"), "ZCARD");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 5: errors
+static void test_geo_errors(void) {
+    TEST_START("GEO errors");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *a1[] = {"GEOADD", "g:e", "200", "10", "x"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, a1), "-ERR invalid longitude,latitude pair 200.000000,10.000000\r\n"), "bad lon");
+    const char *a2[] = {"GEOADD", "g:e", "10", "10", "x", "20"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, a2), "-ERR syntax error\r\n"), "odd arguments");
+    const char *a3[] = {"GEOADD", "g:e", "NX", "XX", "10", "10", "x"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, a3), "-ERR XX and NX options at the same time are not compatible\r\n"), "NX XX");
+    const char *exists[] = {"ZCARD", "g:e"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, exists), ":0\r\n"), "nothing written");
+
+    const char *ok[] = {"GEOADD", "g:e", "10", "10", "x"};
+    exec(&cn, 5, ok);
+    const char *d1[] = {"GEODIST", "g:e", "x", "x", "yards"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, d1), "-ERR unsupported unit provided. please use M, KM, FT, MI\r\n"), "unit");
+    const char *s1[] = {"GEOSEARCH", "g:e", "BYRADIUS", "1", "km", "COUNT", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, s1),
+                        "-ERR exactly one of FROMMEMBER or FROMLONLAT can be specified for GEOSEARCH\r\n"),
+                "no FROM");
+    const char *s2[] = {"GEOSEARCH", "g:e", "FROMMEMBER", "x", "BYRADIUS", "1", "km", "BYBOX", "1", "1", "km"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 11, s2),
+                        "-ERR exactly one of BYRADIUS and BYBOX can be specified for GEOSEARCH\r\n"),
+                "two BY");
+    const char *s3[] = {"GEOSEARCH", "g:e", "FROMMEMBER", "y", "BYRADIUS", "1", "km"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, s3), "-ERR could not decode requested zset member\r\n"), "missing member");
+    const char *s4[] = {"GEOSEARCH", "g:e", "FROMMEMBER", "x", "BYRADIUS", "-1", "km"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, s4), "-ERR radius cannot be negative\r\n"), "negative radius");
+    const char *s5[] = {"GEOSEARCH", "g:e", "FROMMEMBER", "x", "BYRADIUS", "1", "km", "COUNT", "0"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 9, s5), "-ERR COUNT must be > 0\r\n"), "COUNT 0");
+    const char *set[] = {"SET", "g:s", "v"};
+    exec(&cn, 3, set);
+    const char *s6[] = {"GEOSEARCH", "g:s", "FROMLONLAT", "1", "1", "BYRADIUS", "1", "km"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, s6), "-WRONGTYPE Operation against a key holding the wrong kind of value\r\n"),
+                "wrong type");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 6: GEOSEARCH against a brute-force scan, then latency on a city-sized set
+static void test_geo_search_perf(void) {
+    TEST_START("GEOSEARCH vs brute force, latency");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    enum { N = 100000 };
+    static double lon[N], lat[N];
+    static char name[N][12];
+    for (int i = 0; i < N; i++) {
+        lon[i] = 116.4 + frand(-0.5, 0.5);
+        lat[i] = 39.9 + frand(-0.5, 0.5);
+        snprintf(name[i], sizeof(name[i]), "d%d", i);
+        char x[32], y[32];
+        snprintf(x, sizeof(x), "%.6f", lon[i]);
+        snprintf(y, sizeof(y), "%.6f", lat[i]);
+        const char *add[] = {"GEOADD", "drivers", x, y, name[i]};
+        exec(&cn, 5, add);
+        ogeo_decode(ogeo_encode(atof(x), atof(y)), &lon[i], &lat[i]);
+    }
+
+    int same = 1;
+    for (int q = 0; q < 20; q++) {
+        struct ogeo_shape s = {.lon = 116.4 + frand(-0.4, 0.4), .lat = 39.9 + frand(-0.4, 0.4)};
+        s.box = q & 1;
+        s.radius = frand(100, 5000);
+        s.width = frand(100, 8000);
+        s.height = frand(100, 8000);
+        char x[32], y[32], r[32], w[32], h[32];
+        snprintf(x, sizeof(x), "%.17g", s.lon);
+        snprintf(y, sizeof(y), "%.17g", s.lat);
+        snprintf(r, sizeof(r), "%.17g", s.radius);
+        snprintf(w, sizeof(w), "%.17g", s.width);
+        snprintf(h, sizeof(h), "%.17g", s.height);
+        const char *byr[] = {"GEOSEARCH", "drivers", "FROMLONLAT", x, y, "BYRADIUS", r, "m"};
+        const char *byb[] = {"GEOSEARCH", "drivers", "FROMLONLAT", x, y, "BYBOX", w, h, "m"};
+        const char *out = s.box ? exec(&cn, 9, byb) : exec(&cn, 8, byr);
+        int expect = 0;
+        for (int i = 0; i < N; i++) expect += ref_within(&s, lon[i], lat[i]);
+        if (out[0] != '*' || atoi(out + 1) != expect) same = 0;
+    }
+    ASSERT_TRUE(same, "result counts match a full scan");
+
+    // 只给 COUNT (没有 ASC/DESC): 仍然是最近的 N 个
+    same = 1;
+    for (int q = 0; q < 20; q++) {
+        struct ogeo_shape s = {.lon = 116.4 + frand(-0.4, 0.4), .lat = 39.9 + frand(-0.4, 0.4), .radius = 3000};
+        char x[32], y[32];
+        snprintf(x, sizeof(x), "%.17g", s.lon);
+        snprintf(y, sizeof(y), "%.17g", s.lat);
+        const char *byc[] = {"GEOSEARCH", "drivers", "FROMLONLAT", x, y, "BYRADIUS", "3000", "m", "COUNT", "5"};
+        enum { K = 5 };
+        int best[K], nb = 0;
+        double bd[K];
+        for (int i = 0; i < N; i++) {
+            if (!ref_within(&s, lon[i], lat[i])) continue;
+            double d = ogeo_dist(s.lon, s.lat, lon[i], lat[i]);
+            int j = nb < K ? nb++ : K;
+            for (; j > 0 && bd[j - 1] > d; j--)
+                if (j < K) bd[j] = bd[j - 1], best[j] = best[j - 1];
+            if (j < K) bd[j] = d, best[j] = i;
+        }
+        char expect[256];
+        int len = snprintf(expect, sizeof(expect), "*%d\r\n", nb);
+        for (int j = 0; j < nb; j++)
+            len += snprintf(expect + len, sizeof(expect) - len, "$%zu\r\n%s\r\n", strlen(name[best[j]]), name[best[j]]);
+        if (strcmp(exec(&cn, 10, byc), expect)) same = 0;
+    }
+    ASSERT_TRUE(same, "COUNT without ASC returns the nearest N");
+
+    // 1 km 半径, 每次约 60 个命中
+    const char *q[] = {"GEOSEARCH", "drivers", "FROMLONLAT", NULL, NULL, "BYRADIUS", "1", "km", "ASC", "COUNT", "10"};
+    char xs[64][32], ys[64][32];
+    for (int i = 0; i < 64; i++) {
+        snprintf(xs[i], sizeof(xs[i]), "%.6f", 116.4 + frand(-0.4, 0.4));
+        snprintf(ys[i], sizeof(ys[i]), "%.6f", 39.9 + frand(-0.4, 0.4));
+    }
+    const int Q = 20000;
+    double t0 = get_time_ns();
+    for (int i = 0; i < Q; i++) {
+        q[3] = xs[i & 63];
+        q[4] = ys[i & 63];
+        exec(&cn, 11, q);
+    }
+    double per = (get_time_ns() - t0) / Q;
+
+    // 对照: 同样的过滤内核扫全部 N 个点
+    static uint32_t idx[N];
+    static double dist[N];
+    struct ogeo_shape s = {.lon = 116.4, .lat = 39.9, .radius = 1000};
+    t0 = get_time_ns();
+    for (int i = 0; i < 20; i++) ogeo_within(&s, lon, lat, N, idx, dist);
+    double scan = (get_time_ns() - t0) / 20;
+
+    // 过滤内核本身: 每个候选点的开销
+    double t_pt = scan / N;
+    printf("    GEOSEARCH 1km COUNT 10: %.0f ns/query (%.0f K qps), full scan: %.0f ns, filter: %.2f ns/point\n",
+           per, 1e6 / per, scan, t_pt);
+    ASSERT_TRUE(per < scan, "neighbour ranges beat a full scan");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+void run_cmd_geo_tests(void) {
+    TEST_SUITE_START("Geo Tests");
+
+    test_geo_encode();
+    test_geo_ranges();
+    test_geo_within();
+    test_geo_commands();
+    test_geo_errors();
+    test_geo_search_perf();
+
+    TEST_SUITE_END();
+}
@@ -0,0 +1,254 @@
+//
+// Hash Type Tests for CMD + OHASH
+// Tests: packed encoding, upgrade to a nested ohashtable, H* commands, WRONGTYPE, memory per field
+//
+
+#include "test_cmd_common.h"
+#include <assert.h>
+#include <malloc.h>
+
+// Test 1: packed encoding set / overwrite / delete / iterate
+static void test_hash_packed(void) {
+    TEST_START("Packed hash encoding");
+
+    osv *v = ohv_new();
+    assert(v);
+    ASSERT_EQ(ohv_set(&v, "name", 4, "alice", 5), 1, "new field");
+    ASSERT_EQ(ohv_set(&v, "age", 3, "30", 2), 1, "second field");
+    ASSERT_EQ(ohv_set(&v, "city", 4, "paris", 5), 1, "third field");
+    ASSERT_EQ(v->enc, OSV_HASH_PACK, "still packed");
+    ASSERT_EQ(v->vlen, (2 + 4 + 5) + (2 + 3 + 2) + (2 + 4 + 5), "2 bytes of overhead per field");
+
+    ASSERT_EQ(ohv_set(&v, "age", 3, "31", 2), 0, "same length overwrite");
+    ASSERT_EQ(ohv_set(&v, "name", 4, "bartholomew", 11), 0, "longer overwrite");
+    ASSERT_EQ(ohv_set(&v, "city", 4, "rome", 4), 0, "shorter overwrite");
+    const char *val;
+    uint64_t vlen;
+    ASSERT_TRUE(ohv_get(v, "name", 4, &val, &vlen) && vlen == 11 && !memcmp(val, "bartholomew", 11), "name");
+    ASSERT_TRUE(ohv_get(v, "age", 3, &val, &vlen) && vlen == 2 && !memcmp(val, "31", 2), "age");
+    ASSERT_TRUE(ohv_get(v, "city", 4, &val, &vlen) && vlen == 4 && !memcmp(val, "rome", 4), "city");
+    ASSERT_EQ(ohv_get(v, "nope", 4, &val, &vlen), 0, "missing field");
+    ASSERT_EQ(ohv_len(v), 3, "HLEN");
+
+    ASSERT_EQ(ohv_del(v, "age", 3), 1, "delete middle");
+    ASSERT_EQ(ohv_del(v, "age", 3), 0, "delete again");
+    struct ohv_iter it;
+    const char *f;
+    uint32_t flen;
+    ohv_iter_init(&it, v);
+    ASSERT_TRUE(ohv_next(&it, &f, &flen, &val, &vlen) && flen == 4 && !memcmp(f, "name", 4), "order 1");
+    ASSERT_TRUE(ohv_next(&it, &f, &flen, &val, &vlen) && flen == 4 && !memcmp(f, "city", 4), "order 2");
+    ASSERT_EQ(ohv_next(&it, &f, &flen, &val, &vlen), 0, "end");
+    ohv_free(v);
+
+    TEST_PASS();
+}
+
+// Test 2: upgrade to a nested otable_t on entry count and on element size
+static void test_hash_upgrade(void) {
+    TEST_START("Upgrade PACK -> nested ohashtable");
+
+    osv *v = ohv_new();
+    char f[16], val[16];
+    for (int i = 0; i < OSV_HASH_PACK_ENTRIES; i++) {
+        int n = snprintf(f, sizeof(f), "f%d", i);
+        ohv_set(&v, f, n, f, n);
+    }
+    ASSERT_EQ(v->enc, OSV_HASH_PACK, "packed up to the entry threshold");
+    ASSERT_EQ(ohv_set(&v, "one_more", 8, "x", 1), 1, "entry past the threshold");
+    ASSERT_EQ(v->enc, OSV_HASH_TABLE, "upgraded");
+    ASSERT_EQ(ohv_len(v), OSV_HASH_PACK_ENTRIES + 1, "no field lost");
+    for (int i = 0; i < 5000; i++) {
+        int n = snprintf(f, sizeof(f), "f%d", i);
+        int m = snprintf(val, sizeof(val), "v%d", i);
+        ohv_set(&v, f, n, val, m);
+    }
+    ASSERT_EQ(ohv_len(v), 5001, "nested table expanded");
+    const char *p;
+    uint64_t plen;
+    ASSERT_TRUE(ohv_get(v, "f4999", 5, &p, &plen) && plen == 5 && !memcmp(p, "v4999", 5), "lookup");
+    for (int i = 0; i < 5000; i += 2) {
+        int n = snprintf(f, sizeof(f), "f%d", i);
+        ohv_del(v, f, n);
+    }
+    ASSERT_EQ(ohv_len(v), 2501, "deleted half");
+    uint64_t seen = 0;
+    struct ohv_iter it;
+    const char *fp;
+    uint32_t flen;
+    ohv_iter_init(&it, v);
+    while (ohv_next(&it, &fp, &flen, &p, &plen)) seen++;
+    ASSERT_EQ(seen, 2501, "iteration skips tombstones");
+    ohv_free(v);
+
+    // 一个大 value 也会触发升级
+    v = ohv_new();
+    char big[OSV_HASH_PACK_VALUE + 1];
+    memset(big, 'b', sizeof(big));
+    ohv_set(&v, "a", 1, "1", 1);
+    ASSERT_EQ(ohv_set(&v, "big", 3, big, sizeof(big)), 1, "large value");
+    ASSERT_EQ(v->enc, OSV_HASH_TABLE, "upgraded on value size");
+    ASSERT_TRUE(ohv_get(v, "a", 1, &p, &plen) && plen == 1 && p[0] == '1', "old field kept");
+    ohv_free(v);
+
+    TEST_PASS();
+}
+
+// Test 3: dispatch level replies and type checks
+static void test_hash_dispatch(void) {
+    TEST_START("H* commands through dispatch");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+    assert(cn.write_buffer);
+
+    const char *hset[] = {"HSET", "user:1", "name", "ann", "age", "41"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, hset), ":2\r\n"), "HSET two new fields");
+    const char *hset2[] = {"hset", "user:1", "age", "42", "mail", "a@x"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, hset2), ":1\r\n"), "HSET one new, one update");
+    const char *hset_odd[] = {"HSET", "user:1", "a", "1", "b"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 5, hset_odd), "-ERR wrong number", 17), "HSET odd args");
+    const char *hget[] = {"HGET", "user:1", "age"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, hget), "$2\r\n42\r\n"), "HGET");
+    const char *hget_nx[] = {"HGET", "user:1", "zip"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, hget_nx), "$-1\r\n"), "HGET missing field");
+    const char *hmget[] = {"HMGET", "user:1", "name", "zip", "mail"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, hmget), "*3\r\n$3\r\nann\r\n$-1\r\n$3\r\na@x\r\n"), "HMGET");
+    const char *hmget_nx[] = {"HMGET", "nokey", "a"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, hmget_nx), "*1\r\n$-1\r\n"), "HMGET missing key");
+    const char *hlen[] = {"HLEN", "user:1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, hlen), ":3\r\n"), "HLEN");
+    const char *hgetall[] = {"HGETALL", "user:1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, hgetall),
+                        "*6\r\n$4\r\nname\r\n$3\r\nann\r\n$3\r\nage\r\n$2\r\n42\r\n$4\r\nmail\r\n$3\r\na@x\r\n"),
+                "HGETALL in insertion order");
+
+    const char *hincr[] = {"HINCRBY", "user:1", "age", "-2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, hincr), ":40\r\n"), "HINCRBY");
+    const char *hincr_new[] = {"HINCRBY", "user:1", "visits", "5"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, hincr_new), ":5\r\n"), "HINCRBY new field");
+    const char *hincr_bad[] = {"HINCRBY", "user:1", "name", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, hincr_bad), "-ERR hash value is not an integer\r\n"), "HINCRBY string");
+    const char *hset_max[] = {"HSET", "user:1", "big", "9223372036854775807"};
+    exec(&cn, 4, hset_max);
+    const char *hincr_of[] = {"HINCRBY", "user:1", "big", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, hincr_of), "-ERR increment or decrement would overflow\r\n"), "overflow");
+
+    const char *get[] = {"GET", "user:1"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 2, get), "-WRONGTYPE", 10), "GET on a hash");
+    const char *incr[] = {"INCR", "user:1"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 2, incr), "-WRONGTYPE", 10), "INCR on a hash");
+    const char *append[] = {"APPEND", "user:1", "x"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, append), "-WRONGTYPE", 10), "APPEND on a hash");
+    const char *getdel[] = {"GETDEL", "user:1"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 2, getdel), "-WRONGTYPE", 10), "GETDEL on a hash");
+    const char *setget[] = {"SET", "user:1", "v", "GET"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, setget), "-WRONGTYPE", 10), "SET GET on a hash");
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, hlen), ":5\r\n"), "hash untouched");
+
+    const char *set[] = {"SET", "str", "v"};
+    exec(&cn, 3, set);
+    const char *hset_str[] = {"HSET", "str", "a", "1"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, hset_str), "-WRONGTYPE", 10), "HSET on a string");
+    const char *hget_str[] = {"HGET", "str", "a"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, hget_str), "-WRONGTYPE", 10), "HGET on a string");
+
+    const char *hdel[] = {"HDEL", "user:1", "name", "age", "zip"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, hdel), ":2\r\n"), "HDEL counts deleted fields");
+    const char *hdel_rest[] = {"HDEL", "user:1", "mail", "visits", "big"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, hdel_rest), ":3\r\n"), "HDEL the rest");
+    ASSERT_NULL(olookup("user:1", 6), "empty hash removes the key");
+
+    // 升级后的 hash 被 SET 覆盖 / DEL 删除, 嵌套表一起释放
+    for (int i = 0; i < 300; i++) {
+        char f[16];
+        snprintf(f, sizeof(f), "f%d", i);
+        const char *hs[] = {"HSET", "bigh", f, f};
+        exec(&cn, 4, hs);
+    }
+    ASSERT_EQ(((osv *) olookup("bigh", 4)->v)->enc, OSV_HASH_TABLE, "upgraded through HSET");
+    const char *set_over[] = {"SET", "bigh", "plain"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, set_over), "+OK\r\n"), "SET overwrites a hash");
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, (const char *[]){"GET", "bigh"}), "$5\r\nplain\r\n"), "now a string");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 4: memory per field, one hash per user vs one top-level key per field
+static void test_hash_memory_benchmark(void) {
+    TEST_START("Memory per field: HSET vs sibling keys");
+
+    const int users = 20000;
+    const int fields = 10;
+    static const char *names[] = {"name", "email", "age", "city", "zip", "plan", "since", "lang", "tz", "score"};
+    char key[48], val[16];
+    // 两边都计入全局 slot 的摊销 (32 字节 / 装载因子)
+    const double slot_cost = (double) sizeof(ohash_t) * LOAD_FACTOR_DENOMINATOR / LOAD_FACTOR_THRESHOLD;
+
+    size_t before = mallinfo2().uordblks;
+    for (int u = 0; u < users; u++) {
+        int kl = snprintf(key, sizeof(key), "hprofile:%d", u);
+        int err;
+        ohash_t *slot = otype_lookup(key, kl, OSV_T_HASH, ohv_new, &err);
+        for (int f = 0; f < fields; f++) {
+            int vl = snprintf(val, sizeof(val), "v%d_%d", u, f);
+            osv *v = slot->v;
+            ohv_set(&v, names[f], strlen(names[f]), val, vl);
+            slot->v = v;
+        }
+    }
+    double hash_bytes = (double) (mallinfo2().uordblks - before) + users * slot_cost;
+
+    before = mallinfo2().uordblks;
+    for (int u = 0; u < users; u++) {
+        for (int f = 0; f < fields; f++) {
+            int kl = snprintf(key, sizeof(key), "kprofile:%d:%s", u, names[f]);
+            int vl = snprintf(val, sizeof(val), "v%d_%d", u, f);
+            SET4dup(key, kl, val, vl, 0);
+        }
+    }
+    double key_bytes = (double) (mallinfo2().uordblks - before) + (double) users * fields * slot_cost;
+
+    // 查找的代价: 小 hash 的线性扫描 vs 全局表的一次 probe
+    const int nops = 1 << 20;
+    const char *p;
+    uint64_t plen, sink = 0;
+    double t0 = get_time_ns();
+    for (int i = 0; i < nops; i++) {
+        int u = (int) ((i * 2654435761U) % users);
+        int kl = snprintf(key, sizeof(key), "hprofile:%d", u);
+        ohash_t *slot = olookup(key, kl);
+        if (ohv_get(slot->v, names[i % fields], strlen(names[i % fields]), &p, &plen)) sink += plen;
+    }
+    double hget_ns = (get_time_ns() - t0) / nops;
+    t0 = get_time_ns();
+    for (int i = 0; i < nops; i++) {
+        int u = (int) ((i * 2654435761U) % users);
+        int kl = snprintf(key, sizeof(key), "kprofile:%d:%s", u, names[i % fields]);
+        osv *v = GET(key, kl);
+        sink += v->vlen;
+    }
+    double get_ns = (get_time_ns() - t0) / nops;
+    (void) sink;
+
+    printf("\n      %d users x %d fields\n", users, fields);
+    printf("      hash (packed)  : %.1f bytes/field, HGET %.1f ns\n", hash_bytes / (users * fields), hget_ns);
+    printf("      sibling keys   : %.1f bytes/field, GET  %.1f ns (%.1fx memory)\n",
+           key_bytes / (users * fields), get_ns, key_bytes / hash_bytes);
+    ASSERT_LT(hash_bytes * 3, key_bytes, "packed fields should cost far less than top-level keys");
+
+    TEST_PASS();
+}
+
+void run_cmd_hash_tests(void) {
+    TEST_SUITE_START("CMD Hash Type Tests");
+
+    test_hash_packed();
+    test_hash_upgrade();
+    test_hash_dispatch();
+    test_hash_memory_benchmark();
+
+    TEST_SUITE_END();
+}
@@ -0,0 +1,226 @@
+//
+// HyperLogLog Type Tests for CMD + OHASH
+// Tests: sparse run-length encoding, promotion to dense, estimator accuracy, cached cardinality, PF* commands, PFMERGE throughput
+//
+
+#include "test_cmd_common.h"
+
+/** 加入 "<prefix>:<i>", i in [from, to) */
+static void add_range(osv **v, const char *prefix, uint32_t from, uint32_t to) {
+    char e[48];
+    for (uint32_t i = from; i < to; i++) ohllv_add(v, e, (uint64_t) snprintf(e, sizeof(e), "%s:%u", prefix, i));
+}
+
+static double rel_err(uint64_t est, uint64_t exact) {
+    return fabs((double) est - (double) exact) / (double) exact;
+}
+
+// Test 1: sparse 编码与同样元素的 dense 编码寄存器一致
+static void test_hll_sparse(void) {
+    TEST_START("Sparse encoding matches dense registers");
+
+    osv *s = ohllv_new();
+    ASSERT_EQ(s->enc, OSV_HLL_SPARSE, "starts sparse");
+    ASSERT_EQ(s->vlen, 10, "empty HLL is header + one XZERO");
+    ASSERT_EQ(ohllv_count(s), 0, "empty count");
+    ASSERT_EQ(ohllv_add(&s, "a", 1), 1, "first add changes a register");
+    ASSERT_EQ(ohllv_add(&s, "a", 1), 0, "duplicate add is a no-op");
+    add_range(&s, "e", 0, 200);
+    ASSERT_EQ(s->enc, OSV_HLL_SPARSE, "200 elements stay sparse");
+    ASSERT_LT(s->vlen, 1024, "sparse is much smaller than dense");
+
+    uint32_t saved = ohll_sparse_max;
+    ohll_sparse_max = 0;
+    osv *d = ohllv_new();
+    ohllv_add(&d, "a", 1);
+    add_range(&d, "e", 0, 200);
+    ohll_sparse_max = saved;
+    ASSERT_EQ(d->enc, OSV_HLL_DENSE, "sparse_max 0 forces dense");
+    ASSERT_EQ(d->vlen, 8 + OHLL_DENSE_SIZE + 1, "dense is 12 KB");
+
+    static uint8_t rs[OHLL_REGS], rd[OHLL_REGS];
+    memset(rs, 0, sizeof(rs));
+    memset(rd, 0, sizeof(rd));
+    ohllv_merge(s, rs);
+    ohllv_merge(d, rd);
+    ASSERT_TRUE(!memcmp(rs, rd, OHLL_REGS), "same registers in both encodings");
+    uint64_t cs = ohllv_count(s);
+    ASSERT_EQ(cs, ohllv_count(d), "same estimate");
+    ASSERT_EQ(cs, ohll_estimate(rs), "estimate from unpacked registers");
+    ASSERT_TRUE(rel_err(cs, 201) < 0.03, "small cardinality is near exact");
+
+    free(s);
+    free(d);
+    TEST_PASS();
+}
+
+// Test 2: 编码超过 ohll_sparse_max 时转成 dense, 估算不受影响
+static void test_hll_promote(void) {
+    TEST_START("Sparse to dense promotion and accuracy");
+
+    osv *v = ohllv_new();
+    uint32_t n = 0;
+    for (; v->enc == OSV_HLL_SPARSE; n++) add_range(&v, "p", n, n + 1);
+    ASSERT_GT(n, 500, "sparse holds a few thousand registers");
+    ASSERT_EQ(v->vlen, 8 + OHLL_DENSE_SIZE + 1, "promoted to dense");
+    ASSERT_TRUE(rel_err(ohllv_count(v), n) < 0.03, "estimate right after promotion");
+
+    static const uint32_t sizes[] = {10000, 100000, 1000000};
+    uint32_t done = n;
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        add_range(&v, "p", done, sizes[k]);
+        done = sizes[k];
+        uint64_t est = ohllv_count(v);
+        printf("\n      n = %-8u estimate = %-8llu error = %.3f%%", sizes[k], (unsigned long long) est,
+               rel_err(est, sizes[k]) * 100);
+        ASSERT_TRUE(rel_err(est, sizes[k]) < 0.02, "within 2% (std error 0.81%)");
+    }
+    printf("\n");
+
+    // 缓存: 重复元素不改寄存器, 缓存仍有效; 新元素使缓存失效
+    uint64_t c = ohllv_count(v);
+    ASSERT_EQ(*(uint64_t *) v->d, c, "count is cached");
+    add_range(&v, "p", 0, 1000);
+    ASSERT_EQ(*(uint64_t *) v->d, c, "duplicates keep the cache");
+    add_range(&v, "q", 0, 100000);
+    ASSERT_TRUE(*(uint64_t *) v->d & OHLL_STALE, "new elements invalidate the cache");
+    ASSERT_TRUE(rel_err(ohllv_count(v), 1100000) < 0.02, "recomputed");
+
+    free(v);
+    TEST_PASS();
+}
+
+static void test_hll_dispatch(void) {
+    TEST_START("PF* commands through cmd_dispatch");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *pfadd_empty[] = {"PFADD", "h0"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, pfadd_empty), ":1\r\n"), "PFADD without elements creates the key");
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, pfadd_empty), ":0\r\n"), "second time is a no-op");
+    const char *pfadd_a[] = {"PFADD", "h1", "a", "b", "c", "d"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, pfadd_a), ":1\r\n"), "PFADD h1");
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, pfadd_a), ":0\r\n"), "PFADD same elements");
+    const char *pfadd_b[] = {"PFADD", "h2", "c", "d", "e", "f"};
+    exec(&cn, 6, pfadd_b);
+    const char *pfcount[] = {"PFCOUNT", "h1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, pfcount), ":4\r\n"), "PFCOUNT");
+    const char *pfcount_u[] = {"PFCOUNT", "h1", "h2", "nokey"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, pfcount_u), ":6\r\n"), "PFCOUNT of the union");
+    const char *pfcount_miss[] = {"PFCOUNT", "nokey"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, pfcount_miss), ":0\r\n"), "PFCOUNT missing key");
+
+    const char *pfmerge[] = {"PFMERGE", "h3", "h1", "h2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, pfmerge), "+OK\r\n"), "PFMERGE into a new key");
+    ASSERT_EQ(((osv *) olookup("h3", 2)->v)->enc, OSV_HLL_DENSE, "merge result is dense");
+    const char *pfcount3[] = {"PFCOUNT", "h3"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, pfcount3), ":6\r\n"), "merged count");
+    const char *pfmerge_self[] = {"PFMERGE", "h1", "h2"};
+    exec(&cn, 3, pfmerge_self);
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, pfcount), ":6\r\n"), "PFMERGE keeps the destination's registers");
+
+    const char *set[] = {"SET", "str", "v"};
+    exec(&cn, 3, set);
+    const char *pfadd_wt[] = {"PFADD", "str", "x"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, pfadd_wt), "-WRONGTYPE", 10), "PFADD on a string");
+    const char *pfcount_wt[] = {"PFCOUNT", "h1", "str"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, pfcount_wt), "-WRONGTYPE", 10), "PFCOUNT with a string");
+    const char *pfmerge_wt[] = {"PFMERGE", "h1", "str"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, pfmerge_wt), "-WRONGTYPE", 10), "PFMERGE from a string");
+    const char *get[] = {"GET", "h1"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 2, get), "-WRONGTYPE", 10), "GET on a HyperLogLog");
+
+    const char *del[] = {"DEL", "h0", "h1", "h2", "h3", "str"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, del), ":5\r\n"), "DEL");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 4: 内存 (HLL vs 精确集合) 和寄存器合并的吞吐
+static void test_hll_benchmark(void) {
+    TEST_START("Memory footprint and PFMERGE throughput");
+
+    // 1000 个 key 各 500 个访客: sparse HLL 对比存成员的集合
+    enum { KEYS = 1000, PER_KEY = 500, MERGE = 64, ROUNDS = 200 };
+    uint64_t hll_bytes = 0, set_bytes = 0;
+    char e[48];
+    for (int k = 0; k < KEYS; k++) {
+        osv *v = ohllv_new();
+        add_range(&v, "u", (uint32_t) k * 37, (uint32_t) k * 37 + PER_KEY);
+        hll_bytes += sizeof(osv) + v->vlen + v->spare;
+        free(v);
+    }
+    for (uint32_t i = 0; i < PER_KEY; i++)
+        set_bytes += sizeof(ohash_t) + (uint64_t) snprintf(e, sizeof(e), "u:%u", i) + 16;
+    set_bytes *= KEYS;
+    printf("\n      %d keys x %d members: sparse HLL %.1f KB, exact set >= %.1f KB, dense %.1f KB",
+           KEYS, PER_KEY, hll_bytes / 1024.0, set_bytes / 1024.0, KEYS * (OHLL_DENSE_SIZE + 25) / 1024.0);
+    ASSERT_LT(hll_bytes, set_bytes / 4, "sparse HLL is far smaller than the exact set");
+
+    osv *src[MERGE];
+    uint32_t saved = ohll_sparse_max;
+    ohll_sparse_max = 0;
+    for (int i = 0; i < MERGE; i++) {
+        src[i] = ohllv_new();
+        add_range(&src[i], "m", (uint32_t) i * 20000, (uint32_t) i * 20000 + 30000);
+    }
+    ohll_sparse_max = saved;
+
+    static uint8_t regs[OHLL_REGS], unpacked[MERGE][OHLL_REGS], ref[OHLL_REGS];
+    memset(regs, 0, sizeof(regs));
+    for (int i = 0; i < MERGE; i++) ohllv_merge(src[i], regs);
+    uint64_t est = ohll_estimate(regs), exact = (MERGE - 1) * 20000 + 30000;
+    printf("\n      union of %d dense HLLs: estimate %llu, exact %llu", MERGE, (unsigned long long) est,
+           (unsigned long long) exact);
+    ASSERT_TRUE(rel_err(est, exact) < 0.02, "merged estimate");
+
+    // 已解包的寄存器上比较 ohll_max 和逐字节的标量 max
+    for (int i = 0; i < MERGE; i++) {
+        memset(unpacked[i], 0, OHLL_REGS);
+        ohllv_merge(src[i], unpacked[i]);
+    }
+    double t0 = get_time_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        memset(regs, 0, sizeof(regs));
+        for (int i = 0; i < MERGE; i++) ohll_max(regs, unpacked[i], OHLL_REGS);
+    }
+    double simd_ns = get_time_ns() - t0;
+    t0 = get_time_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        memset(ref, 0, sizeof(ref));
+        for (int i = 0; i < MERGE; i++)
+            for (uint32_t j = 0; j < OHLL_REGS; j++)
+                if (unpacked[i][j] > ref[j]) ref[j] = unpacked[i][j];
+    }
+    double scalar_ns = get_time_ns() - t0;
+    ASSERT_TRUE(!memcmp(regs, ref, OHLL_REGS), "SIMD max matches scalar");
+
+    t0 = get_time_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        memset(regs, 0, sizeof(regs));
+        for (int i = 0; i < MERGE; i++) ohllv_merge(src[i], regs);
+    }
+    double merge_ns = get_time_ns() - t0;
+    double bytes = (double) ROUNDS * MERGE * OHLL_REGS;
+    printf("\n      SIMD max     : %.2f GB/s", bytes / simd_ns);
+    printf("\n      scalar max   : %.2f GB/s", bytes / scalar_ns);
+    printf("\n      unpack + max : %.1f us per dense source\n", merge_ns / 1e3 / ROUNDS / MERGE);
+    ASSERT_LT(simd_ns / 1e6, 1000, "register max stays fast");
+
+    for (int i = 0; i < MERGE; i++) free(src[i]);
+    TEST_PASS();
+}
+
+void run_cmd_hll_tests(void) {
+    TEST_SUITE_START("CMD HyperLogLog Type Tests");
+
+    test_hll_sparse();
+    test_hll_promote();
+    test_hll_dispatch();
+    test_hll_benchmark();
+
+    TEST_SUITE_END();
+}
@@ -0,0 +1,276 @@
+//
+// JSON Command Tests for CMD + OHASH
+// Tests: parse / dump round trip, paths, JSON.SET / GET / NUMINCRBY / ARRAPPEND, in-place updates, latency
+//
+
+#include "test_cmd_common.h"
+
+/** 解析再序列化 */
+static const char *round_trip(const char *in) {
+    static struct ojbuf bin, txt;
+    bin.len = txt.len = 0;
+    if (ojson_parse(&bin, in, strlen(in)) < 0) return NULL;
+    if (ojson_dump(&txt, bin.p) < 0 || ojson_put(&txt, "", 1) < 0) return NULL;
+    return txt.p;
+}
+
+// Test 1: 文本 -> 二进制 -> 文本
+static void test_json_round_trip(void) {
+    TEST_START("parse / dump round trip");
+
+    static const char *same[] = {
+        "null", "true", "false", "0", "-7", "9223372036854775807", "-9223372036854775808", "1.5", "-0.25",
+        "1e+100", "\"\"", "\"a\\\"b\\\\c\\n\\u0001\"", "[]", "{}", "[1,[2,[3,{}]],\"x\"]",
+        "{\"a\":{\"b\":[true,null]},\"c\":\"d\"}",
+    };
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(same) / sizeof(same[0]); i++) {
+        const char *out = round_trip(same[i]);
+        if (!out || strcmp(out, same[i])) {
+            printf("\n    %s -> %s", same[i], out ? out : "(error)");
+            ok = 0;
+        }
+    }
+    ASSERT_TRUE(ok, "canonical documents survive unchanged");
+
+    const char *out = round_trip(" { \"k\" : [ 1 , 2.0 , 3e2 ] , \"u\" : \"\\u00e9\\ud83d\\ude00\\/\" } ");
+    ASSERT_TRUE(out && !strcmp(out, "{\"k\":[1,2.0,300.0],\"u\":\"\xc3\xa9\xf0\x9f\x98\x80/\"}"),
+                "whitespace, doubles, unicode escapes");
+    out = round_trip("12345678901234567890");
+    ASSERT_TRUE(out && !strcmp(out, "1.2345678901234567e+19"), "integer overflow becomes a double");
+
+    static const char *bad[] = {
+        "", "tru", "[1,]", "{\"a\"}", "{\"a\":1,}", "01", "1.", "-", "\"abc", "\"\\x\"", "\"\\ud800\"",
+        "[1] 2", "{a:1}", "1e999", "\"\t\"",
+    };
+    ok = 1;
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        if (round_trip(bad[i])) {
+            printf("\n    accepted: %s", bad[i]);
+            ok = 0;
+        }
+    }
+    ASSERT_TRUE(ok, "invalid documents rejected");
+
+    char deep[2 * OJSON_DEPTH_MAX + 8];
+    memset(deep, '[', OJSON_DEPTH_MAX + 1);
+    memset(deep + OJSON_DEPTH_MAX + 1, ']', OJSON_DEPTH_MAX + 1);
+    deep[2 * OJSON_DEPTH_MAX + 2] = '\0';
+    ASSERT_TRUE(!round_trip(deep), "nesting deeper than OJSON_DEPTH_MAX rejected");
+    deep[OJSON_DEPTH_MAX] = '1';
+    memmove(deep + OJSON_DEPTH_MAX + 1, deep + OJSON_DEPTH_MAX + 2, OJSON_DEPTH_MAX + 1);
+    ASSERT_TRUE(round_trip(deep) != NULL, "nesting at OJSON_DEPTH_MAX accepted");
+
+    TEST_PASS();
+}
+
+// Test 2: 路径语法
+static void test_json_paths(void) {
+    TEST_START("path syntax");
+
+    static struct ojpath p;
+    ASSERT_TRUE(ojpath_parse(&p, "$", 1) == 0 && p.n == 0 && p.dollar, "$");
+    ASSERT_TRUE(ojpath_parse(&p, ".", 1) == 0 && p.n == 0 && !p.dollar, ".");
+    ASSERT_TRUE(ojpath_parse(&p, "$.a['b c'][-2].d", 16) == 0 && p.n == 4, "$.a['b c'][-2].d");
+    ASSERT_TRUE(p.s[1].klen == 3 && !memcmp(p.s[1].key, "b c", 3) && !p.s[2].key && p.s[2].idx == -2, "steps");
+    ASSERT_TRUE(ojpath_parse(&p, "a.b[0]", 6) == 0 && p.n == 3 && !p.dollar, "legacy without the leading dot");
+    static const char *bad[] = {"$..a", "$.*", "$[*]", "$.a[", "$[1x]", "$['a]", "$.", "$[?(@.a)]"};
+    int ok = 1;
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) ok &= ojpath_parse(&p, bad[i], strlen(bad[i])) < 0;
+    ASSERT_TRUE(ok, "wildcards, filters and malformed paths rejected");
+
+    TEST_PASS();
+}
+
+// Test 3: JSON.SET / JSON.GET
+static void test_json_set_get(void) {
+    TEST_START("JSON.SET / JSON.GET");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *s1[] = {"JSON.SET", "doc", "$", "{\"a\":{\"b\":1},\"arr\":[1,2,3],\"s\":\"x\"}"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, s1), "+OK\r\n"), "SET root");
+    const char *g1[] = {"JSON.GET", "doc"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, g1), "$35\r\n{\"a\":{\"b\":1},\"arr\":[1,2,3],\"s\":\"x\"}\r\n"), "GET whole");
+    const char *g2[] = {"JSON.GET", "doc", "$.a.b"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, g2), "$3\r\n[1]\r\n"), "GET $ path");
+    const char *g3[] = {"JSON.GET", "doc", ".arr[-1]"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, g3), "$1\r\n3\r\n"), "GET legacy path");
+    const char *g4[] = {"JSON.GET", "doc", "$.nope"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, g4), "$2\r\n[]\r\n"), "GET $ missing");
+    const char *g5[] = {"JSON.GET", "doc", ".nope"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, g5), "-ERR Path '.nope' does not exist\r\n"), "GET legacy missing");
+    const char *g6[] = {"JSON.GET", "doc", ".s", "$.a"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, g6), "$26\r\n{\".s\":\"x\",\"$.a\":[{\"b\":1}]}\r\n"), "GET several paths");
+
+    // 替换子树: 变长, 变短, 新增成员
+    const char *s2[] = {"JSON.SET", "doc", "$.a.b", "{\"deep\":[true,false]}"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, s2), "+OK\r\n"), "SET grows a subtree");
+    const char *s3[] = {"JSON.SET", "doc", "$.arr", "[]"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, s3), "+OK\r\n"), "SET shrinks a subtree");
+    const char *s4[] = {"JSON.SET", "doc", "$.a.new", "\"v\""};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, s4), "+OK\r\n"), "SET adds a member");
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, g1), "$60\r\n{\"a\":{\"b\":{\"deep\":[true,false]},\"new\":\"v\"},\"arr\":[],\"s\":\"x\"}\r\n"),
+                "document after the edits");
+    const char *s5[] = {"JSON.SET", "doc", "$.s", "1", "NX"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, s5), "$-1\r\n"), "NX on an existing path");
+    const char *s6[] = {"JSON.SET", "doc", "$.t", "1", "XX"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, s6), "$-1\r\n"), "XX on a missing path");
+    const char *s7[] = {"JSON.SET", "doc", "$.x.y", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, s7), "$-1\r\n"), "missing parent");
+    const char *s8[] = {"JSON.SET", "doc", "$.arr[0]", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, s8), "$-1\r\n"), "index out of range");
+    const char *s9[] = {"JSON.SET", "doc", ".", "[0]"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, s9), "+OK\r\n"), "SET root of an existing key");
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, g1), "$3\r\n[0]\r\n"), "root replaced");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 4: JSON.NUMINCRBY / JSON.ARRAPPEND
+static void test_json_incr_append(void) {
+    TEST_START("JSON.NUMINCRBY / JSON.ARRAPPEND");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *s1[] = {"JSON.SET", "n", "$", "{\"i\":1,\"f\":1.5,\"s\":\"x\",\"a\":[1],\"m\":9223372036854775807}"};
+    exec(&cn, 4, s1);
+    ohash_t *slot = olookup("n", 1);
+    void *before = slot->v;
+    const char *i1[] = {"JSON.NUMINCRBY", "n", "$.i", "41"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, i1), "$4\r\n[42]\r\n"), "int + int");
+    const char *i2[] = {"JSON.NUMINCRBY", "n", ".f", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, i2), "$3\r\n2.5\r\n"), "double + int");
+    const char *i3[] = {"JSON.NUMINCRBY", "n", ".i", "0.5"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, i3), "$4\r\n42.5\r\n"), "int + double");
+    const char *i4[] = {"JSON.NUMINCRBY", "n", ".m", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, i4), "$21\r\n9.223372036854776e+18\r\n"), "overflow becomes a double");
+    ASSERT_TRUE(olookup("n", 1)->v == before, "NUMINCRBY does not reallocate");
+    const char *i5[] = {"JSON.NUMINCRBY", "n", "$.s", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, i5), "$6\r\n[null]\r\n"), "$ path on a string");
+    const char *i6[] = {"JSON.NUMINCRBY", "n", ".s", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, i6), "-ERR value at path is not a number\r\n"), "legacy path on a string");
+    const char *i7[] = {"JSON.NUMINCRBY", "n", ".f", "1e308"};
+    exec(&cn, 4, i7);
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, i7), "-ERR result is not a finite number\r\n"), "overflow to infinity");
+
+    const char *a1[] = {"JSON.ARRAPPEND", "n", "$.a", "2", "\"three\"", "[4]"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, a1), "*1\r\n:4\r\n"), "ARRAPPEND $");
+    const char *a2[] = {"JSON.ARRAPPEND", "n", ".a", "{}"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, a2), ":5\r\n"), "ARRAPPEND legacy");
+    const char *a3[] = {"JSON.ARRAPPEND", "n", "$.s", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, a3), "*1\r\n$-1\r\n"), "ARRAPPEND $ on a string");
+    const char *a4[] = {"JSON.ARRAPPEND", "n", "$.zz", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, a4), "*0\r\n"), "ARRAPPEND $ missing");
+    const char *a5[] = {"JSON.ARRAPPEND", "n", ".a", "[1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, a5), "-ERR invalid JSON\r\n"), "invalid value");
+    const char *g[] = {"JSON.GET", "n", ".a"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, g), "$20\r\n[1,2,\"three\",[4],{}]\r\n"), "array after appends");
+    const char *g2[] = {"JSON.GET", "n", "$.s"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, g2), "$5\r\n[\"x\"]\r\n"), "later member intact");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 5: 错误
+static void test_json_errors(void) {
+    TEST_START("JSON errors");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *s1[] = {"JSON.SET", "e", "$.a", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, s1), "-ERR new objects must be created at the root\r\n"), "new key, sub-path");
+    const char *s2[] = {"JSON.SET", "e", "$", "{"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, s2), "-ERR invalid JSON\r\n"), "invalid JSON");
+    const char *s3[] = {"JSON.SET", "e", "$[*]", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, s3), "-ERR invalid or unsupported JSON path\r\n"), "wildcard");
+    const char *s4[] = {"JSON.SET", "e", "$", "1", "NX", "XX"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, s4), "-ERR syntax error\r\n"), "NX XX");
+    const char *s5[] = {"JSON.SET", "e", "$", "1", "XX"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, s5), "$-1\r\n"), "XX on a new key");
+    const char *g1[] = {"JSON.GET", "e"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, g1), "$-1\r\n"), "GET missing key");
+    const char *i1[] = {"JSON.NUMINCRBY", "e", "$", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, i1),
+                        "-ERR could not perform this operation on a key that doesn't exist\r\n"), "NUMINCRBY missing key");
+    const char *i2[] = {"JSON.NUMINCRBY", "e", "$", "abc"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, i2), "-ERR value is not a number\r\n"), "NUMINCRBY not a number");
+
+    const char *set[] = {"SET", "str", "v"};
+    exec(&cn, 3, set);
+    const char *g2[] = {"JSON.GET", "str"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, g2), "-WRONGTYPE Operation against a key holding the wrong kind of value\r\n"),
+                "WRONGTYPE");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 6: 20KB 的文档改一个字段: GET + SET 整个字符串 vs JSON.SET 路径
+static void test_json_perf(void) {
+    TEST_START("update one field of a 20KB document");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    static char doc[32 << 10];
+    int len = snprintf(doc, sizeof(doc), "{\"user\":{\"name\":\"n\",\"visits\":0},\"items\":[");
+    for (int i = 0; len < 20000; i++)
+        len += snprintf(doc + len, sizeof(doc) - len, "%s{\"id\":%d,\"sku\":\"sku-%06d\",\"price\":%d.25}", i ? "," : "",
+                        i, i, i);
+    len += snprintf(doc + len, sizeof(doc) - len, "]}");
+    const char *js[] = {"JSON.SET", "big", "$", doc};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, js), "+OK\r\n"), "20KB document");
+    const char *ss[] = {"SET", "bigs", doc};
+    exec(&cn, 3, ss);
+
+    enum { Q = 2000 };
+    const char *gs[] = {"GET", "bigs"};
+    double t0 = get_time_ns();
+    for (int i = 0; i < Q; i++) {
+        exec(&cn, 2, gs);
+        exec(&cn, 3, ss);
+    }
+    double t_blob = (get_time_ns() - t0) / Q;
+
+    const char *up[] = {"JSON.SET", "big", "$.user.name", "\"someone else\""};
+    t0 = get_time_ns();
+    for (int i = 0; i < Q; i++) exec(&cn, 4, up);
+    double t_set = (get_time_ns() - t0) / Q;
+
+    const char *inc[] = {"JSON.NUMINCRBY", "big", "$.user.visits", "1"};
+    t0 = get_time_ns();
+    for (int i = 0; i < Q; i++) exec(&cn, 4, inc);
+    double t_incr = (get_time_ns() - t0) / Q;
+
+    const char *get[] = {"JSON.GET", "big", "$.user"};
+    t0 = get_time_ns();
+    for (int i = 0; i < Q; i++) exec(&cn, 3, get);
+    double t_get = (get_time_ns() - t0) / Q;
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, get), "$39\r\n[{\"name\":\"someone else\",\"visits\":2000}]\r\n"), "sub-path read");
+
+    printf("    %d bytes: GET + SET blob %.0f ns, JSON.SET path %.0f ns, NUMINCRBY %.0f ns, JSON.GET sub-path %.0f ns\n",
+           len, t_blob, t_set, t_incr, t_get);
+    ASSERT_TRUE(t_set < t_blob && t_incr < t_blob, "path updates beat a blob round trip");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+void run_cmd_json_tests(void) {
+    test_json_round_trip();
+    test_json_paths();
+    test_json_set_get();
+    test_json_incr_append();
+    test_json_errors();
+    test_json_perf();
+}
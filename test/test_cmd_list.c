@@ -0,0 +1,330 @@
+//
+// List Type Tests for CMD + OHASH
+// Tests: packed node deque, node boundaries, LTRIM, interior node compression, L* commands, memory per element
+//
+
+#include "test_cmd_common.h"
+#include "../include/olzf.h"
+#include <assert.h>
+#include <malloc.h>
+
+/** 按顺序遍历整个 list, 检查第 i 个元素是 "e<base + i>" */
+static int list_matches(const osv *v, long long base) {
+    struct olv_iter it;
+    const char *p;
+    uint64_t len;
+    char bf[32];
+    if (olv_iter_init(&it, v, 0) < 0) return 0;
+    uint64_t i = 0;
+    int ok = 1;
+    while (ok && olv_next(&it, &p, &len) > 0) {
+        int n = snprintf(bf, sizeof(bf), "e%lld", base + (long long) i++);
+        ok = (uint64_t) n == len && !memcmp(p, bf, len);
+    }
+    olv_iter_release(&it);
+    return ok && i == olv_len(v);
+}
+
+// Test 1: push / pop at both ends, in order
+static void test_list_deque(void) {
+    TEST_START("Deque push / pop at both ends");
+
+    osv *v = olv_new();
+    assert(v);
+    char bf[32];
+    // 头部 e-1 .. e-5000, 尾部 e0 .. e4999: 整体是 e-5000 .. e4999
+    for (int i = 0; i < 5000; i++) {
+        int n = snprintf(bf, sizeof(bf), "e%d", i);
+        ASSERT_EQ(olv_push(v, OLIST_TAIL, bf, n), 0, "RPUSH");
+        n = snprintf(bf, sizeof(bf), "e%d", -1 - i);
+        ASSERT_EQ(olv_push(v, OLIST_HEAD, bf, n), 0, "LPUSH");
+    }
+    ASSERT_EQ(olv_len(v), 10000, "length");
+    ASSERT_GT(olv_list(v)->nodes, 2, "spans several nodes");
+    ASSERT_TRUE(list_matches(v, -5000), "order after mixed pushes");
+
+    const char *p;
+    uint64_t len;
+    ASSERT_TRUE(olv_peek(v, OLIST_HEAD, &p, &len) && len == 6 && !memcmp(p, "e-5000", 6), "head");
+    ASSERT_TRUE(olv_peek(v, OLIST_TAIL, &p, &len) && len == 5 && !memcmp(p, "e4999", 5), "tail");
+
+    // 从头部弹出 7000 个 (穿过中间的分界), 剩下 e2000 .. e4999
+    for (int i = 0; i < 7000; i++) ASSERT_EQ(olv_pop(v, OLIST_HEAD), 0, "LPOP");
+    ASSERT_TRUE(list_matches(v, 2000), "order after pops");
+    for (int i = 0; i < 3000; i++) ASSERT_EQ(olv_pop(v, OLIST_TAIL), 0, "RPOP");
+    ASSERT_EQ(olv_len(v), 0, "empty");
+    ASSERT_NULL(olv_list(v)->head, "no nodes left");
+    ASSERT_EQ(olv_peek(v, OLIST_HEAD, &p, &len), 0, "peek on empty");
+    ASSERT_EQ(olv_pop(v, OLIST_TAIL), 0, "pop on empty");
+
+    osv_free(v);
+    TEST_PASS();
+}
+
+// Test 2: entry encodings and elements bigger than a node
+static void test_list_big_elements(void) {
+    TEST_START("Big elements and node boundaries");
+
+    osv *v = olv_new();
+    static char big[OLIST_NODE_MAX * 2];
+    for (size_t i = 0; i < sizeof(big); i++) big[i] = (char) ('a' + i % 26);
+    const uint64_t sizes[] = {0, 1, 127, 128, 255, 256, 4000, OLIST_NODE_MAX - 10, OLIST_NODE_MAX, sizeof(big)};
+    const int ns = (int) (sizeof(sizes) / sizeof(sizes[0]));
+    for (int i = 0; i < ns; i++) {
+        ASSERT_EQ(olv_push(v, OLIST_TAIL, big, sizes[i]), 0, "RPUSH sized element");
+        ASSERT_EQ(olv_push(v, OLIST_HEAD, big, sizes[i]), 0, "LPUSH sized element");
+    }
+    // 每个节点的数据都不超过 OLIST_NODE_MAX, 除非只有一个超大元素
+    for (const struct olnode *n = olv_list(v)->head; n; n = n->next)
+        ASSERT_TRUE(n->hi - n->lo <= OLIST_NODE_MAX || n->count == 1, "node size bound");
+
+    const char *p;
+    uint64_t len;
+    for (int i = ns - 1; i >= 0; i--) {
+        ASSERT_TRUE(olv_peek(v, OLIST_HEAD, &p, &len) && len == sizes[i] && !memcmp(p, big, len), "LPOP size");
+        olv_pop(v, OLIST_HEAD);
+        ASSERT_TRUE(olv_peek(v, OLIST_TAIL, &p, &len) && len == sizes[i] && !memcmp(p, big, len), "RPOP size");
+        olv_pop(v, OLIST_TAIL);
+    }
+    ASSERT_EQ(olv_len(v), 0, "empty");
+
+    osv_free(v);
+    TEST_PASS();
+}
+
+// Test 3: LTRIM across node boundaries
+static void test_list_trim(void) {
+    TEST_START("LTRIM across nodes");
+
+    osv *v = olv_new();
+    char bf[32];
+    for (int i = 0; i < 20000; i++) olv_push(v, OLIST_TAIL, bf, snprintf(bf, sizeof(bf), "e%d", i));
+    uint64_t nodes = olv_list(v)->nodes;
+    ASSERT_EQ(olv_trim(v, 3333, 5555), 0, "trim both ends");
+    ASSERT_EQ(olv_len(v), 20000 - 3333 - 5555, "length after trim");
+    ASSERT_LT(olv_list(v)->nodes, nodes, "whole nodes freed");
+    ASSERT_TRUE(list_matches(v, 3333), "content after trim");
+    ASSERT_EQ(olv_trim(v, 0, 1), 0, "trim one from the tail");
+    ASSERT_TRUE(list_matches(v, 3333), "content after tail trim");
+    ASSERT_EQ(olv_trim(v, 1, 0), 0, "trim one from the head");
+    ASSERT_TRUE(list_matches(v, 3334), "content after head trim");
+    ASSERT_EQ(olv_trim(v, 5000, 10000), 0, "trim everything");
+    ASSERT_EQ(olv_len(v), 0, "empty");
+    ASSERT_EQ(olv_list(v)->nodes, 0, "no nodes");
+
+    osv_free(v);
+    TEST_PASS();
+}
+
+// Test 4: olzf round trip on compressible, incompressible and edge inputs
+static void test_olzf_roundtrip(void) {
+    TEST_START("olzf round trip");
+
+    static char in[OLIST_NODE_MAX], out[OLIST_NODE_MAX + OLIST_NODE_MAX / 32 + 16], back[OLIST_NODE_MAX];
+    uint32_t seed = 12345;
+    for (int round = 0; round < 200; round++) {
+        size_t n = (size_t) (round * 41) % sizeof(in) + 1;
+        int alphabet = round % 4 == 0 ? 256 : 2 + round % 16; // 随机数据 / 高度重复
+        for (size_t i = 0; i < n; i++) {
+            seed = seed * 1103515245 + 12345;
+            in[i] = (char) ((seed >> 16) % alphabet);
+        }
+        size_t c = olzf_compress(in, n, out, sizeof(out));
+        ASSERT_GT(c, 0, "fits with headroom");
+        ASSERT_EQ(olzf_decompress(out, c, back, sizeof(back)), n, "decompressed size");
+        ASSERT_TRUE(!memcmp(in, back, n), "same bytes");
+        if (c > 1) ASSERT_EQ(olzf_decompress(out, c - 1, back, sizeof(back)), 0, "truncated input rejected");
+        ASSERT_EQ(olzf_decompress(out, c, back, n - 1), 0, "small output rejected");
+    }
+    memset(in, 'x', sizeof(in));
+    size_t c = olzf_compress(in, sizeof(in), out, sizeof(out));
+    ASSERT_LT(c, sizeof(in) / 20, "runs compress well");
+    ASSERT_EQ(olzf_compress(in, sizeof(in), out, 8), 0, "output too small");
+
+    TEST_PASS();
+}
+
+// Test 5: interior nodes compressed with depth 1, all operations still see the same list
+static void test_list_compress(void) {
+    TEST_START("Interior node compression (depth 1)");
+
+    olist_compress_depth = 1;
+    osv *v = olv_new();
+    char bf[64];
+    // 重复度高的元素, 与真实的日志 / 队列内容类似
+    for (int i = 0; i < 20000; i++)
+        olv_push(v, OLIST_TAIL, bf, snprintf(bf, sizeof(bf), "e%d", i));
+    const struct olist *l = olv_list(v);
+    uint64_t lz = 0, bytes = 0, raw = 0;
+    for (const struct olnode *n = l->head; n; n = n->next) {
+        lz += n->lz;
+        bytes += n->lz ? n->hi : n->hi - n->lo;
+        raw += n->lz ? n->rawsz : n->hi - n->lo;
+    }
+    ASSERT_FALSE(l->head->lz || l->tail->lz, "ends are never compressed");
+    ASSERT_EQ(lz, l->nodes - 2, "every interior node compressed");
+    ASSERT_LT(bytes, raw, "compressed data is smaller");
+    ASSERT_TRUE(list_matches(v, 0), "iterate through compressed nodes");
+
+    struct olv_iter it;
+    const char *p;
+    uint64_t len;
+    ASSERT_EQ(olv_iter_init(&it, v, 12345), 0, "iterator starting inside a compressed node");
+    ASSERT_TRUE(olv_next(&it, &p, &len) > 0 && len == 6 && !memcmp(p, "e12345", 6), "random access");
+    olv_iter_release(&it);
+
+    // pop 到压缩节点成为新的一端, 它会先被解压
+    uint64_t first = l->head->count;
+    for (uint64_t i = 0; i < first + 1; i++) ASSERT_EQ(olv_pop(v, OLIST_HEAD), 0, "LPOP into a compressed node");
+    ASSERT_FALSE(l->head->lz, "new head inflated");
+    ASSERT_TRUE(list_matches(v, (long long) first + 1), "content after pops");
+    ASSERT_EQ(olv_trim(v, 1000, 1000), 0, "trim into compressed nodes");
+    ASSERT_FALSE(l->head->lz || l->tail->lz, "trimmed ends inflated");
+    ASSERT_TRUE(list_matches(v, (long long) first + 1001), "content after trim");
+    for (int i = 0; i < 5000; i++) olv_push(v, OLIST_HEAD, "x", 1);
+    ASSERT_FALSE(l->head->lz || l->tail->lz, "ends stay raw after pushes");
+
+    osv_free(v);
+    olist_compress_depth = 0;
+    TEST_PASS();
+}
+
+// Test 6: L* commands through the dispatcher, WRONGTYPE, empty list removes the key
+static void test_list_dispatch(void) {
+    TEST_START("List commands through cmd_dispatch");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *rpush[] = {"RPUSH", "q", "a", "b", "c"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, rpush), ":3\r\n"), "RPUSH");
+    const char *lpush[] = {"LPUSH", "q", "y", "z"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, lpush), ":5\r\n"), "LPUSH");
+    const char *lrange[] = {"LRANGE", "q", "0", "-1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, lrange), "*5\r\n$1\r\nz\r\n$1\r\ny\r\n$1\r\na\r\n$1\r\nb\r\n$1\r\nc\r\n"),
+                "LRANGE 0 -1");
+    const char *lrange_mid[] = {"LRANGE", "q", "-3", "100"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, lrange_mid), "*3\r\n$1\r\na\r\n$1\r\nb\r\n$1\r\nc\r\n"), "LRANGE clamps");
+    const char *lrange_empty[] = {"LRANGE", "q", "4", "2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, lrange_empty), "*0\r\n"), "LRANGE start > stop");
+    const char *lrange_bad[] = {"LRANGE", "q", "x", "2"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, lrange_bad), "-ERR", 4), "LRANGE non-integer");
+    const char *lindex[] = {"LINDEX", "q", "-1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, lindex), "$1\r\nc\r\n"), "LINDEX -1");
+    const char *lindex_out[] = {"LINDEX", "q", "5"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, lindex_out), "$-1\r\n"), "LINDEX out of range");
+    const char *llen[] = {"LLEN", "q"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, llen), ":5\r\n"), "LLEN");
+
+    const char *lpop[] = {"LPOP", "q"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, lpop), "$1\r\nz\r\n"), "LPOP");
+    const char *rpop2[] = {"RPOP", "q", "2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, rpop2), "*2\r\n$1\r\nc\r\n$1\r\nb\r\n"), "RPOP count");
+    const char *lpop0[] = {"LPOP", "q", "0"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, lpop0), "*0\r\n"), "LPOP 0");
+    const char *lpop_neg[] = {"LPOP", "q", "-1"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, lpop_neg), "-ERR", 4), "LPOP negative count");
+    const char *ltrim[] = {"LTRIM", "q", "1", "-1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, ltrim), "+OK\r\n"), "LTRIM");
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, lrange), "*1\r\n$1\r\na\r\n"), "after LTRIM");
+    const char *lpop9[] = {"LPOP", "q", "9"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, lpop9), "*1\r\n$1\r\na\r\n"), "LPOP more than the length");
+    ASSERT_NULL(olookup("q", 1), "empty list removes the key");
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, lpop), "$-1\r\n"), "LPOP missing key");
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, lpop9), "*-1\r\n"), "LPOP count on a missing key");
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, llen), ":0\r\n"), "LLEN missing key");
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, lrange), "*0\r\n"), "LRANGE missing key");
+
+    exec(&cn, 5, rpush);
+    const char *ltrim_all[] = {"LTRIM", "q", "5", "10"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, ltrim_all), "+OK\r\n"), "LTRIM out of range");
+    ASSERT_NULL(olookup("q", 1), "LTRIM to empty removes the key");
+
+    const char *set[] = {"SET", "str", "v"};
+    exec(&cn, 3, set);
+    const char *lpush_str[] = {"LPUSH", "str", "a"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, lpush_str), "-WRONGTYPE", 10), "LPUSH on a string");
+    const char *lrange_str[] = {"LRANGE", "str", "0", "-1"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, lrange_str), "-WRONGTYPE", 10), "LRANGE on a string");
+    exec(&cn, 5, rpush);
+    const char *get[] = {"GET", "q"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 2, get), "-WRONGTYPE", 10), "GET on a list");
+    const char *hget[] = {"HGET", "q", "a"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, hget), "-WRONGTYPE", 10), "HGET on a list");
+    const char *del[] = {"DEL", "q"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, del), ":1\r\n"), "DEL a list");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 7: memory per element and queue throughput, list vs one top-level key per element
+static void test_list_benchmark(void) {
+    TEST_START("List vs key-per-element queue");
+
+    const int n = 200000;
+    char key[48], val[32];
+    const double slot_cost = (double) sizeof(ohash_t) * LOAD_FACTOR_DENOMINATOR / LOAD_FACTOR_THRESHOLD;
+
+    size_t before = mallinfo2().uordblks;
+    int err;
+    ohash_t *slot = otype_lookup("jobs", 4, OSV_T_LIST, olv_new, &err);
+    assert(slot);
+    double t0 = get_time_ns();
+    for (int i = 0; i < n; i++) olv_push(slot->v, OLIST_HEAD, val, snprintf(val, sizeof(val), "job:%d", i));
+    double push_ns = (get_time_ns() - t0) / n;
+    double list_bytes = (double) (mallinfo2().uordblks - before) + slot_cost;
+
+    // 队列用法: 每个 key 一个元素, 用递增的序号当 key
+    before = mallinfo2().uordblks;
+    t0 = get_time_ns();
+    for (int i = 0; i < n; i++) {
+        int kl = snprintf(key, sizeof(key), "jobs:%d", i);
+        SET4dup(key, kl, val, snprintf(val, sizeof(val), "job:%d", i), 0);
+    }
+    double set_ns = (get_time_ns() - t0) / n;
+    double key_bytes = (double) (mallinfo2().uordblks - before) + (double) n * slot_cost;
+
+    const char *p;
+    uint64_t len, sink = 0;
+    slot = olookup("jobs", 4); // SET4dup 可能让全局表扩容
+    t0 = get_time_ns();
+    for (int i = 0; i < n; i++) {
+        olv_peek(slot->v, OLIST_TAIL, &p, &len);
+        sink += len;
+        olv_pop(slot->v, OLIST_TAIL);
+    }
+    double pop_ns = (get_time_ns() - t0) / n;
+    t0 = get_time_ns();
+    for (int i = 0; i < n; i++) {
+        int kl = snprintf(key, sizeof(key), "jobs:%d", i);
+        DEL(key, kl, free);
+    }
+    double del_ns = (get_time_ns() - t0) / n;
+    (void) sink;
+    otype_remove(slot);
+
+    printf("\n      %d elements\n", n);
+    printf("      list        : %.1f bytes/elem, LPUSH %.1f ns, RPOP %.1f ns\n",
+           list_bytes / n, push_ns, pop_ns);
+    printf("      key per elem: %.1f bytes/elem, SET   %.1f ns, DEL  %.1f ns (%.1fx memory)\n",
+           key_bytes / n, set_ns, del_ns, key_bytes / list_bytes);
+    ASSERT_LT(list_bytes * 3, key_bytes, "packed nodes should cost far less than top-level keys");
+
+    TEST_PASS();
+}
+
+void run_cmd_list_tests(void) {
+    TEST_SUITE_START("CMD List Type Tests");
+
+    test_list_deque();
+    test_list_big_elements();
+    test_list_trim();
+    test_olzf_roundtrip();
+    test_list_compress();
+    test_list_dispatch();
+    test_list_benchmark();
+
+    TEST_SUITE_END();
+}
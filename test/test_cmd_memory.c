@@ -140,7 +140,7 @@ static void test_memory_expired_entries(void) {
     const char *key = "expired_mem_key";
     const char *value = "expired_value";
     uint32_t keylen = strlen(key);
-    uint32_t past_time = (uint32_t) get_current_time_seconds() - 10;
+    uint64_t past_time = get_current_time_ms() - 10000;
 
     reset_tracking();
 
@@ -424,7 +424,7 @@ static void test_expired_entry_overhead(void) {
 
     const int num_keys = 5000;
     char key[64], value[128];
-    uint32_t past_time = (uint32_t) get_current_time_seconds() - 100;
+    uint64_t past_time = get_current_time_ms() - 100000;
 
     // Insert expired entries
     for (int i = 0; i < num_keys; i++) {
@@ -15,6 +15,27 @@ extern void run_cmd_functional_tests(void);
 extern void run_cmd_memory_tests(void);
 extern void run_cmd_performance_tests(void);
 extern void run_cmd_stress_tests(void);
+extern void run_cmd_tier_tests(void);
+extern void run_cmd_server_tests(void);
+extern void run_cmd_batch_tests(void);
+extern void run_cmd_counter_tests(void);
+extern void run_cmd_string_tests(void);
+extern void run_cmd_setopt_tests(void);
+extern void run_cmd_expire_tests(void);
+extern void run_cmd_hash_tests(void);
+extern void run_cmd_list_tests(void);
+extern void run_cmd_zset_tests(void);
+extern void run_cmd_set_tests(void);
+extern void run_cmd_bitmap_tests(void);
+extern void run_cmd_hll_tests(void);
+extern void run_cmd_bloom_tests(void);
+extern void run_cmd_sketch_tests(void);
+extern void run_cmd_ts_tests(void);
+extern void run_cmd_stream_tests(void);
+extern void run_cmd_throttle_tests(void);
+extern void run_cmd_geo_tests(void);
+extern void run_cmd_vset_tests(void);
+extern void run_cmd_json_tests(void);
 
 static void print_banner(void) {
     printf("\n");
@@ -117,6 +138,27 @@ static void print_final_report(test_stats_t stats) {
     printf("  ✓ Memory safety and leak detection\n");
     printf("  ✓ Performance benchmarks\n");
     printf("  ✓ Stress and edge case tests\n");
+    printf("  ✓ Tiered storage (RAM / disk)\n");
+    printf("  ✓ End-to-end dispatch over loopback\n");
+    printf("  ✓ Batched multi-key commands\n");
+    printf("  ✓ In-place integer counters\n");
+    printf("  ✓ Growable string values\n");
+    printf("  ✓ Single probe SET options\n");
+    printf("  ✓ Millisecond expiry\n");
+    printf("  ✓ Hash type\n");
+    printf("  ✓ List type (packed nodes, LZF interior compression, L* commands)\n");
+    printf("  ✓ Sorted set type (packed, B+ tree with ranks, Z* commands)\n");
+    printf("  ✓ Set type (adaptive intset, SIMD SINTER, S* commands)\n");
+    printf("  ✓ Bitmaps (AVX2 / POPCNT kernels, BIT* commands)\n");
+    printf("  ✓ HyperLogLog (sparse / dense encodings, SIMD PFMERGE, PF* commands)\n");
+    printf("  ✓ Bloom filter (cache-line blocks, AVX2 probes, scalable layers, BF.* commands)\n");
+    printf("  ✓ Count-Min Sketch / Top-K (AVX2 gather-min, HeavyKeeper, CMS.* / TOPK.* commands)\n");
+    printf("  ✓ Time series (Gorilla chunks, bucket aggregation, retention, TS.* commands)\n");
+    printf("  ✓ Streams (ID-indexed macro nodes, consumer groups with PEL, X* commands)\n");
+    printf("  ✓ Rate limiting (GCRA with the TAT inline in the slot, THROTTLE command)\n");
+    printf("  ✓ Geo (52-bit geohash in a sorted set, neighbour ranges, AVX2 distance filter, GEO* commands)\n");
+    printf("  ✓ Vector set (AVX2 exact scan, int8 quantization, HNSW graph, VADD / VSIM / VCARD / VDIM)\n");
+    printf("  ✓ JSON (compact binary tree with subtree sizes, in-place path updates, JSON.* commands)\n");
     printf("\n");
 
     // Final verdict
@@ -150,6 +192,27 @@ int main(int argc, char *argv[]) {
     int run_memory = 1;
     int run_performance = 1;
     int run_stress = 1;
+    int run_tier = 1;
+    int run_server = 1;
+    int run_batch = 1;
+    int run_counter = 1;
+    int run_string = 1;
+    int run_setopt = 1;
+    int run_expire = 1;
+    int run_hash = 1;
+    int run_list = 1;
+    int run_zset = 1;
+    int run_set = 1;
+    int run_bitmap = 1;
+    int run_hll = 1;
+    int run_bloom = 1;
+    int run_sketch = 1;
+    int run_ts = 1;
+    int run_stream = 1;
+    int run_throttle = 1;
+    int run_geo = 1;
+    int run_vset = 1;
+    int run_json = 1;
 
     if (argc > 1) {
         // Allow selective test running
@@ -157,17 +220,80 @@ int main(int argc, char *argv[]) {
         run_memory = 0;
         run_performance = 0;
         run_stress = 0;
+        run_tier = 0;
+        run_server = 0;
+        run_batch = 0;
+        run_counter = 0;
+        run_string = 0;
+        run_setopt = 0;
+        run_expire = 0;
+        run_hash = 0;
+        run_list = 0;
+        run_zset = 0;
+        run_set = 0;
+        run_bitmap = 0;
+        run_hll = 0;
+        run_bloom = 0;
+        run_sketch = 0;
+        run_ts = 0;
+        run_stream = 0;
+        run_throttle = 0;
+        run_geo = 0;
+        run_vset = 0;
+        run_json = 0;
 
         for (int i = 1; i < argc; i++) {
             if (strcmp(argv[i], "--functional") == 0) run_functional = 1;
             else if (strcmp(argv[i], "--memory") == 0) run_memory = 1;
             else if (strcmp(argv[i], "--performance") == 0) run_performance = 1;
             else if (strcmp(argv[i], "--stress") == 0) run_stress = 1;
+            else if (strcmp(argv[i], "--tier") == 0) run_tier = 1;
+            else if (strcmp(argv[i], "--server") == 0) run_server = 1;
+            else if (strcmp(argv[i], "--batch") == 0) run_batch = 1;
+            else if (strcmp(argv[i], "--counter") == 0) run_counter = 1;
+            else if (strcmp(argv[i], "--string") == 0) run_string = 1;
+            else if (strcmp(argv[i], "--setopt") == 0) run_setopt = 1;
+            else if (strcmp(argv[i], "--expire") == 0) run_expire = 1;
+            else if (strcmp(argv[i], "--hash") == 0) run_hash = 1;
+            else if (strcmp(argv[i], "--list") == 0) run_list = 1;
+            else if (strcmp(argv[i], "--zset") == 0) run_zset = 1;
+            else if (strcmp(argv[i], "--set") == 0) run_set = 1;
+            else if (strcmp(argv[i], "--bitmap") == 0) run_bitmap = 1;
+            else if (strcmp(argv[i], "--hll") == 0) run_hll = 1;
+            else if (strcmp(argv[i], "--bloom") == 0) run_bloom = 1;
+            else if (strcmp(argv[i], "--sketch") == 0) run_sketch = 1;
+            else if (strcmp(argv[i], "--ts") == 0) run_ts = 1;
+            else if (strcmp(argv[i], "--stream") == 0) run_stream = 1;
+            else if (strcmp(argv[i], "--throttle") == 0) run_throttle = 1;
+            else if (strcmp(argv[i], "--geo") == 0) run_geo = 1;
+            else if (strcmp(argv[i], "--vset") == 0) run_vset = 1;
+            else if (strcmp(argv[i], "--json") == 0) run_json = 1;
             else if (strcmp(argv[i], "--all") == 0) {
                 run_functional = 1;
                 run_memory = 1;
                 run_performance = 1;
                 run_stress = 1;
+                run_tier = 1;
+                run_server = 1;
+                run_batch = 1;
+                run_counter = 1;
+                run_string = 1;
+                run_setopt = 1;
+                run_expire = 1;
+                run_hash = 1;
+                run_list = 1;
+                run_zset = 1;
+                run_set = 1;
+                run_bitmap = 1;
+                run_hll = 1;
+                run_bloom = 1;
+                run_sketch = 1;
+                run_ts = 1;
+                run_stream = 1;
+                run_throttle = 1;
+                run_geo = 1;
+                run_vset = 1;
+                run_json = 1;
             } else if (strcmp(argv[i], "--help") == 0) {
                 printf("Usage: %s [OPTIONS]\n", argv[0]);
                 printf("\nOptions:\n");
@@ -175,6 +301,27 @@ int main(int argc, char *argv[]) {
                 printf("  --memory        Run memory safety tests\n");
                 printf("  --performance   Run performance benchmarks\n");
                 printf("  --stress        Run stress and edge case tests\n");
+                printf("  --tier          Run tiered storage tests and Zipfian benchmark\n");
+                printf("  --server        Run end-to-end dispatch tests and loopback benchmark\n");
+                printf("  --batch         Run MGET/MSET/DEL batch tests and benchmark\n");
+                printf("  --counter       Run INCR/DECR/INCRBYFLOAT tests and benchmark\n");
+                printf("  --string        Run APPEND/SETRANGE/GETRANGE/STRLEN tests and benchmark\n");
+                printf("  --setopt        Run SET options / GETSET / GETDEL / GETEX tests and benchmark\n");
+                printf("  --expire        Run millisecond expiry tests and cached clock benchmark\n");
+                printf("  --hash          Run hash type tests and memory per field comparison\n");
+                printf("  --list          List type: packed node deque, compression, L* commands\n");
+                printf("  --zset          Sorted set type: packed / B+ tree, Z* commands\n");
+                printf("  --set           Set type: intset / table, SIMD intersection, S* commands\n");
+                printf("  --bitmap        Bitmaps: SIMD BITCOUNT / BITOP, BITPOS, BITFIELD\n");
+                printf("  --hll           HyperLogLog type tests\n");
+                printf("  --bloom         Bloom filter type tests\n");
+                printf("  --sketch        Count-Min Sketch / Top-K tests\n");
+                printf("  --ts            Time series type tests\n");
+                printf("  --stream        Stream type tests\n");
+                printf("  --throttle      THROTTLE (GCRA) tests\n");
+                printf("  --geo           Geo command tests\n");
+                printf("  --vset          Vector set command tests\n");
+                printf("  --json          JSON command tests\n");
                 printf("  --all           Run all test suites (default)\n");
                 printf("  --help          Show this help message\n");
                 printf("\n");
@@ -227,6 +374,217 @@ int main(int argc, char *argv[]) {
         suite_end = g_stats;
         print_suite_summary(suite_start, suite_end, "Stress Tests");
     }
+
+    // Run Tiered Storage Tests
+    if (run_tier) {
+        print_section_header("TIERED STORAGE TESTS");
+        reinit_hashtable("Tier Tests");
+        suite_start = g_stats;
+        run_cmd_tier_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "Tier Tests");
+    }
+
+    // Run End-to-End Server Tests
+    if (run_server) {
+        print_section_header("END-TO-END SERVER TESTS");
+        reinit_hashtable("Server Tests");
+        suite_start = g_stats;
+        run_cmd_server_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "Server Tests");
+    }
+
+    // Run Batch Command Tests
+    if (run_batch) {
+        print_section_header("BATCH COMMAND TESTS");
+        reinit_hashtable("Batch Tests");
+        suite_start = g_stats;
+        run_cmd_batch_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "Batch Tests");
+    }
+
+    // Run Counter Tests
+    if (run_counter) {
+        print_section_header("COUNTER COMMAND TESTS");
+        reinit_hashtable("Counter Tests");
+        suite_start = g_stats;
+        run_cmd_counter_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "Counter Tests");
+    }
+
+    // Run String Range Tests
+    if (run_string) {
+        print_section_header("STRING RANGE TESTS");
+        reinit_hashtable("String Range Tests");
+        suite_start = g_stats;
+        run_cmd_string_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "String Range Tests");
+    }
+
+    // Run SET Option Tests
+    if (run_setopt) {
+        print_section_header("SET OPTION TESTS");
+        reinit_hashtable("SET Option Tests");
+        suite_start = g_stats;
+        run_cmd_setopt_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "SET Option Tests");
+    }
+
+    // Run Expiry Tests
+    if (run_expire) {
+        print_section_header("EXPIRY TESTS");
+        reinit_hashtable("Expiry Tests");
+        suite_start = g_stats;
+        run_cmd_expire_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "Expiry Tests");
+    }
+
+    // Run Hash Tests
+    if (run_hash) {
+        print_section_header("HASH TESTS");
+        reinit_hashtable("Hash Tests");
+        suite_start = g_stats;
+        run_cmd_hash_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "Hash Tests");
+    }
+
+    // Run List Tests
+    if (run_list) {
+        print_section_header("CMD LIST TYPE");
+        reinit_hashtable("List Tests");
+        suite_start = g_stats;
+        run_cmd_list_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "List Tests");
+    }
+
+    // Run Sorted Set Tests
+    if (run_zset) {
+        print_section_header("CMD SORTED SET TYPE");
+        reinit_hashtable("Sorted Set Tests");
+        suite_start = g_stats;
+        run_cmd_zset_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "Sorted Set Tests");
+    }
+
+    // Run Set Tests
+    if (run_set) {
+        print_section_header("CMD SET TYPE");
+        reinit_hashtable("Set Tests");
+        suite_start = g_stats;
+        run_cmd_set_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "Set Tests");
+    }
+
+    // Run Bitmap Tests
+    if (run_bitmap) {
+        print_section_header("CMD BITMAP");
+        reinit_hashtable("Bitmap Tests");
+        suite_start = g_stats;
+        run_cmd_bitmap_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "Bitmap Tests");
+    }
+
+    // Run HyperLogLog
+    if (run_hll) {
+        print_section_header("CMD HYPERLOGLOG");
+        reinit_hashtable("HyperLogLog");
+        suite_start = g_stats;
+        run_cmd_hll_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "HyperLogLog");
+    }
+
+    // Run Bloom filter
+    if (run_bloom) {
+        print_section_header("CMD BLOOM FILTER");
+        reinit_hashtable("Bloom filter");
+        suite_start = g_stats;
+        run_cmd_bloom_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "Bloom filter");
+    }
+
+    // Run Sketch
+    if (run_sketch) {
+        print_section_header("CMD SKETCH");
+        reinit_hashtable("Sketch");
+        suite_start = g_stats;
+        run_cmd_sketch_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "Sketch");
+    }
+
+    // Run Time Series
+    if (run_ts) {
+        print_section_header("CMD TIME SERIES");
+        reinit_hashtable("Time Series");
+        suite_start = g_stats;
+        run_cmd_ts_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "Time Series");
+    }
+
+    // Run Stream
+    if (run_stream) {
+        print_section_header("CMD STREAM");
+        reinit_hashtable("Stream");
+        suite_start = g_stats;
+        run_cmd_stream_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "Stream");
+    }
+
+    // Run THROTTLE
+    if (run_throttle) {
+        print_section_header("CMD THROTTLE");
+        reinit_hashtable("THROTTLE");
+        suite_start = g_stats;
+        run_cmd_throttle_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "THROTTLE");
+    }
+
+    // Run Geo
+    if (run_geo) {
+        print_section_header("CMD GEO");
+        reinit_hashtable("Geo");
+        suite_start = g_stats;
+        run_cmd_geo_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "Geo");
+    }
+
+    // Run Vector set
+    if (run_vset) {
+        print_section_header("CMD VADD / VSIM");
+        reinit_hashtable("Vector set");
+        suite_start = g_stats;
+        run_cmd_vset_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "Vector set");
+    }
+
+    // Run JSON
+    if (run_json) {
+        print_section_header("CMD JSON.*");
+        reinit_hashtable("JSON");
+        suite_start = g_stats;
+        run_cmd_json_tests();
+        suite_end = g_stats;
+        print_suite_summary(suite_start, suite_end, "JSON");
+    }
+
     // Print final report
     print_final_report(g_stats);
 
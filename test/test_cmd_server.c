@@ -0,0 +1,348 @@
+//
+// End-to-end Tests for CMD dispatch over loopback
+// Tests: command table, RESP replies, fragmentation, pipelined syscalls / throughput
+//
+
+#include "test_common_framework.h"
+#include "../include/cmd_dispatch.h"
+#include <assert.h>
+#include <signal.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+
+static pid_t server_pid = -1;
+static int server_port = 0;
+/** server 进程的系统调用计数, fork 前 mmap 成共享内存 */
+static struct sserver_stats *stats = NULL;
+
+static double get_time_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1e6 + tv.tv_usec;
+}
+
+static int start_server(void) {
+    int sfd = createsfd(0, 511);
+    if (sfd < 0) return sfd;
+    struct sockaddr_in addr;
+    socklen_t alen = sizeof(addr);
+    getsockname(sfd, (struct sockaddr *) &addr, &alen);
+    server_port = ntohs(addr.sin_port);
+    stats = mmap(NULL, sizeof(*stats), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (stats == MAP_FAILED) return -errno;
+    memset(stats, 0, sizeof(*stats));
+    server_pid = fork();
+    if (server_pid < 0) return -errno;
+    if (server_pid == 0) {
+        struct runenvironment rt = {
+            .sfd = sfd, .pool = create_pool(64),
+            .on_read = cmd_on_read, .on_writer = cmd_on_writer, .stats = stats,
+        };
+        epollrun(rt);
+        _exit(0);
+    }
+    close(sfd);
+    return 0;
+}
+
+static void stop_server(void) {
+    if (server_pid > 0) {
+        kill(server_pid, SIGKILL);
+        waitpid(server_pid, NULL, 0);
+        server_pid = -1;
+    }
+    if (stats) {
+        munmap(stats, sizeof(*stats));
+        stats = NULL;
+    }
+}
+
+static int client_connect(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(server_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static int send_all(int fd, const char *p, size_t len) {
+    while (len) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/** 读满 expect 字节 */
+static long long recv_exact(int fd, char *bf, size_t expect) {
+    size_t got = 0;
+    while (got < expect) {
+        ssize_t n = recv(fd, bf + got, expect - got, 0);
+        if (n <= 0) return -1;
+        got += n;
+    }
+    return (long long) got;
+}
+
+static int roundtrip(int fd, const char *req, const char *expect) {
+    char bf[256];
+    size_t elen = strlen(expect);
+    if (send_all(fd, req, strlen(req)) < 0) return 0;
+    if (recv_exact(fd, bf, elen) < 0) return 0;
+    return memcmp(bf, expect, elen) == 0;
+}
+
+// Test 1: compile-time table has no collision, lookups are case-insensitive
+static void test_command_table(void) {
+    TEST_START("Command table lookup");
+
+    ASSERT_EQ(cmd_table_check(), 0, "every command should resolve to itself");
+    ASSERT_NOT_NULL(cmd_lookup("GET", 3), "upper case lookup");
+    ASSERT_NOT_NULL(cmd_lookup("gEt", 3), "mixed case lookup");
+    ASSERT_NOT_NULL(cmd_lookup("EXPIRE", 6), "6 byte name");
+    ASSERT_NULL(cmd_lookup("GETX", 4), "unknown name");
+    ASSERT_NULL(cmd_lookup("GE", 2), "prefix is not a match");
+    ASSERT_NULL(cmd_lookup("", 0), "empty name");
+    // 只有字母做大小写折叠: 0x0E | 0x20 == '.', 但 0x0E 不是 '.'
+    ASSERT_NOT_NULL(cmd_lookup("JSON.SET", 8), "upper case name with '.'");
+    ASSERT_NULL(cmd_lookup("JSON\x0eSET", 8), "non-letter is not case folded");
+    ASSERT_NULL(cmd_lookup("BF\x0e" "ADD", 6), "non-letter is not case folded (BF.ADD)");
+    ASSERT_NULL(cmd_lookup("G\x05T", 3), "0x05 is not 'E'");
+
+    TEST_PASS();
+}
+
+// Test 2: SET/GET/DEL/EXPIRE over a real socket
+static void test_e2e_basic(void) {
+    TEST_START("SET/GET/DEL/EXPIRE over loopback");
+
+    int fd = client_connect();
+    ASSERT_TRUE(fd >= 0, "connect should succeed");
+    ASSERT_TRUE(roundtrip(fd, "*1\r\n$4\r\nPING\r\n", "+PONG\r\n"), "PING");
+    ASSERT_TRUE(roundtrip(fd, "*3\r\n$3\r\nSET\r\n$3\r\nfoo\r\n$3\r\nbar\r\n", "+OK\r\n"), "SET");
+    ASSERT_TRUE(roundtrip(fd, "*2\r\n$3\r\nget\r\n$3\r\nfoo\r\n", "$3\r\nbar\r\n"), "GET");
+    ASSERT_TRUE(roundtrip(fd, "*3\r\n$6\r\nexpire\r\n$3\r\nfoo\r\n$3\r\n100\r\n", ":1\r\n"), "EXPIRE");
+    ASSERT_TRUE(roundtrip(fd, "*3\r\n$6\r\nEXPIRE\r\n$3\r\nnop\r\n$3\r\n100\r\n", ":0\r\n"), "EXPIRE miss");
+    ASSERT_TRUE(roundtrip(fd, "*2\r\n$3\r\nDEL\r\n$3\r\nfoo\r\n", ":1\r\n"), "DEL");
+    ASSERT_TRUE(roundtrip(fd, "*2\r\n$3\r\nGET\r\n$3\r\nfoo\r\n", "$-1\r\n"), "GET after DEL");
+    ASSERT_TRUE(roundtrip(fd, "*1\r\n$4\r\nNOPE\r\n", "-ERR unknown command 'NOPE'\r\n"), "unknown");
+    ASSERT_TRUE(roundtrip(fd, "*2\r\n$3\r\nSET\r\n$1\r\nk\r\n",
+                          "-ERR wrong number of arguments for 'set' command\r\n"), "arity");
+    close(fd);
+
+    TEST_PASS();
+}
+
+// Test 3: a command split across many reads is reassembled
+static void test_e2e_fragmented(void) {
+    TEST_START("Fragmented command over loopback");
+
+    int fd = client_connect();
+    ASSERT_TRUE(fd >= 0, "connect should succeed");
+    const char *req = "*3\r\n$3\r\nSET\r\n$4\r\nfrag\r\n$5\r\nhello\r\n";
+    for (size_t i = 0; req[i]; i++) {
+        send_all(fd, req + i, 1);
+        usleep(200);
+    }
+    char bf[16];
+    ASSERT_TRUE(recv_exact(fd, bf, 5) == 5 && !memcmp(bf, "+OK\r\n", 5), "fragmented SET");
+    ASSERT_TRUE(roundtrip(fd, "*2\r\n$3\r\nGET\r\n$4\r\nfrag\r\n", "$5\r\nhello\r\n"), "GET");
+
+    // 大于 64K 的值: element.len 不能截断
+    size_t vlen = 200000;
+    char *big = malloc(vlen + 64);
+    assert(big);
+    int h = snprintf(big, 64, "*3\r\n$3\r\nSET\r\n$3\r\nbig\r\n$%zu\r\n", vlen);
+    memset(big + h, 'z', vlen);
+    memcpy(big + h + vlen, "\r\n", 2);
+    send_all(fd, big, h + vlen + 2);
+    ASSERT_TRUE(recv_exact(fd, bf, 5) == 5 && !memcmp(bf, "+OK\r\n", 5), "big SET");
+    send_all(fd, "*2\r\n$3\r\nGET\r\n$3\r\nbig\r\n", 22);
+    char *rb = malloc(vlen + 64);
+    assert(rb);
+    long long n = recv_exact(fd, rb, vlen + 11);
+    ASSERT_TRUE(n == (long long) vlen + 11 && !memcmp(rb, "$200000\r\n", 9), "big GET header");
+    ASSERT_TRUE(rb[9] == 'z' && rb[vlen + 8] == 'z' && !memcmp(rb + vlen + 9, "\r\n", 2), "big GET payload");
+    free(big);
+    free(rb);
+    close(fd);
+
+    TEST_PASS();
+}
+
+// Test 4: a pipelined batch costs one read + one send and no epoll_ctl
+static void test_e2e_pipeline_syscalls(void) {
+    TEST_START("Pipelined batch syscalls over loopback");
+
+    int fd = client_connect();
+    ASSERT_TRUE(fd >= 0, "connect should succeed");
+    // 先跑一批让 read_buffer 长到足够大
+    ASSERT_TRUE(roundtrip(fd, "*3\r\n$3\r\nSET\r\n$2\r\npk\r\n$1\r\n0\r\n", "+OK\r\n"), "SET");
+
+    // 每批 64 条: INCR / GET 交替, 回复按顺序逐字节核对
+    const int depth = 64, batches = 200;
+    char batch[64 * 64], expect[64 * 64], rb[64 * 64];
+    struct sserver_stats s0 = *stats;
+    int ok = 1;
+    long long v = 0;
+    for (int b = 0; b < batches && ok; b++) {
+        size_t off = 0, eoff = 0;
+        for (int j = 0; j < depth; j += 2) {
+            off += sprintf(batch + off, "*2\r\n$4\r\nINCR\r\n$2\r\npk\r\n*2\r\n$3\r\nGET\r\n$2\r\npk\r\n");
+            v++;
+            char num[24];
+            int nl = sprintf(num, "%lld", v);
+            eoff += sprintf(expect + eoff, ":%s\r\n$%d\r\n%s\r\n", num, nl, num);
+        }
+        ok = send_all(fd, batch, off) == 0 && recv_exact(fd, rb, eoff) == (long long) eoff && !memcmp(rb, expect, eoff);
+    }
+    ASSERT_TRUE(ok, "pipelined replies should come back in order");
+    struct sserver_stats s1 = *stats;
+    unsigned long long reads = s1.reads - s0.reads, sends = s1.sends - s0.sends, ctls = s1.ctls - s0.ctls;
+    printf("\n      %d batches x %d: %llu reads, %llu sends, %llu epoll_ctl\n", batches, depth, reads, sends, ctls);
+    ASSERT_EQ((long long) ctls, 0, "replies that fit the socket buffer never touch EPOLLOUT");
+    ASSERT_EQ((long long) sends, batches, "one send per batch");
+    ASSERT_TRUE(reads <= (unsigned long long) batches * 3 / 2, "about one read per batch");
+
+    // 客户端暂时不读: 回复塞满内核缓冲区, EPOLLOUT 打开, 发完以后再关掉
+    const size_t vlen = 100000;
+    char *big = malloc(vlen + 64);
+    assert(big);
+    int h = snprintf(big, 64, "*3\r\n$3\r\nSET\r\n$3\r\nbpk\r\n$%zu\r\n", vlen);
+    memset(big + h, 'q', vlen);
+    memcpy(big + h + vlen, "\r\n", 2);
+    send_all(fd, big, h + vlen + 2);
+    ASSERT_TRUE(recv_exact(fd, rb, 5) == 5 && !memcmp(rb, "+OK\r\n", 5), "big SET");
+    s0 = *stats;
+    const int ngets = 64;
+    off_t glen = 0;
+    for (int j = 0; j < ngets; j++) glen += sprintf(batch + glen, "*2\r\n$3\r\nGET\r\n$3\r\nbpk\r\n");
+    send_all(fd, batch, glen);
+    usleep(50000);
+    size_t rlen = (vlen + 11) * ngets; // $100000\r\n<v>\r\n
+    char *all = malloc(rlen);
+    assert(all);
+    ASSERT_TRUE(recv_exact(fd, all, rlen) == (long long) rlen, "all big replies should arrive");
+    ok = 1;
+    for (int j = 0; j < ngets; j++) {
+        const char *r = all + (size_t) j * (vlen + 11);
+        ok &= !memcmp(r, "$100000\r\n", 9) && r[9] == 'q' && r[vlen + 8] == 'q' && !memcmp(r + vlen + 9, "\r\n", 2);
+    }
+    ASSERT_TRUE(ok, "big replies should be intact");
+    ASSERT_TRUE(roundtrip(fd, "*1\r\n$4\r\nPING\r\n", "+PONG\r\n"), "connection still usable");
+    s1 = *stats;
+    ctls = s1.ctls - s0.ctls;
+    ASSERT_TRUE(ctls >= 2 && ctls % 2 == 0, "EPOLLOUT armed on a full socket and disarmed once drained");
+    free(big);
+    free(all);
+    close(fd);
+
+    TEST_PASS();
+}
+
+static double bench_pipeline(int fd, int nops, int depth, int is_set) {
+    // every request is the same size: key_XXXXXXXX, 16 byte value
+    char req[128];
+    char *batch = malloc(sizeof(req) * depth);
+    size_t reply_len = is_set ? 5 : 5 + 16 + 2; // +OK\r\n | $16\r\n<16>\r\n
+    char *rbuf = malloc(reply_len * depth);
+    assert(batch && rbuf);
+    double start = get_time_us();
+    for (int done = 0; done < nops; done += depth) {
+        size_t off = 0;
+        for (int j = 0; j < depth; j++) {
+            int k = (done + j) % 10000;
+            int n = is_set
+                        ? snprintf(req, sizeof(req),
+                                   "*3\r\n$3\r\nSET\r\n$12\r\nkey_%08d\r\n$16\r\nvalue_%010d\r\n", k, k)
+                        : snprintf(req, sizeof(req), "*2\r\n$3\r\nGET\r\n$12\r\nkey_%08d\r\n", k);
+            memcpy(batch + off, req, n);
+            off += n;
+        }
+        if (send_all(fd, batch, off) < 0 || recv_exact(fd, rbuf, reply_len * depth) < 0) {
+            free(batch);
+            free(rbuf);
+            return -1;
+        }
+    }
+    double elapsed_ms = (get_time_us() - start) / 1000.0;
+    free(batch);
+    free(rbuf);
+    return nops / elapsed_ms * 1000.0;
+}
+
+// Test 5: end-to-end throughput, one connection, varying pipeline depth
+static void test_e2e_throughput(void) {
+    TEST_START("Loopback throughput (SET/GET, pipelined)");
+
+    int fd = client_connect();
+    ASSERT_TRUE(fd >= 0, "connect should succeed");
+    const int nops = 100000;
+    int depths[] = {1, 16, 64};
+    printf("\n");
+    for (int i = 0; i < 3; i++) {
+        double set_ops = bench_pipeline(fd, depths[i] == 1 ? nops / 5 : nops, depths[i], 1);
+        double get_ops = bench_pipeline(fd, depths[i] == 1 ? nops / 5 : nops, depths[i], 0);
+        ASSERT_TRUE(set_ops > 0 && get_ops > 0, "pipeline should complete");
+        printf("      depth %2d: SET %.0f ops/sec, GET %.0f ops/sec\n", depths[i], set_ops, get_ops);
+    }
+    close(fd);
+
+    TEST_PASS();
+}
+
+// Test 6: a protocol error is answered once, then the connection is closed
+static void test_e2e_protocol_error(void) {
+    TEST_START("Protocol error closes the connection");
+
+    int fd = client_connect();
+    ASSERT_TRUE(fd >= 0, "connect should succeed");
+    // 超过 MAX_ARRAY_ELEMENTS 的数组头, 后面的 bulk 不能被当成单独的命令执行
+    char req[256];
+    int len = snprintf(req, sizeof(req), "*%d\r\n$2\r\ne0\r\n$2\r\ne1\r\n*1\r\n$4\r\nPING\r\n",
+                       MAX_ARRAY_ELEMENTS + 1);
+    ASSERT_EQ(send_all(fd, req, (size_t) len), 0, "send");
+    const char expect[] = "-ERR Protocol error\r\n";
+    char bf[256];
+    size_t got = 0;
+    ssize_t n;
+    while ((n = recv(fd, bf + got, sizeof(bf) - got, 0)) > 0) got += (size_t) n;
+    ASSERT_EQ(n, 0, "server closes the connection");
+    ASSERT_TRUE(got == sizeof(expect) - 1 && !memcmp(bf, expect, got), "only the protocol error is replied");
+    close(fd);
+
+    fd = client_connect();
+    ASSERT_TRUE(fd >= 0, "server still accepts");
+    ASSERT_TRUE(roundtrip(fd, "*1\r\n$4\r\nPING\r\n", "+PONG\r\n"), "PING on a new connection");
+    close(fd);
+
+    TEST_PASS();
+}
+
+void run_cmd_server_tests(void) {
+    TEST_SUITE_START("CMD Dispatch End-to-End Tests");
+
+    int ret = start_server();
+    assert(ret == 0 && "server start failed");
+
+    test_command_table();
+    test_e2e_basic();
+    test_e2e_fragmented();
+    test_e2e_pipeline_syscalls();
+    test_e2e_throughput();
+    test_e2e_protocol_error();
+
+    stop_server();
+
+    TEST_SUITE_END();
+}
@@ -0,0 +1,353 @@
+//
+// Set Type Tests for CMD + OHASH
+// Tests: adaptive integer encoding, table conversion, SIMD intersection kernels vs scalar, S* commands, SINTER throughput
+//
+
+#include "test_cmd_common.h"
+#include <assert.h>
+
+static int add(osv **v, const char *m) {
+    return osetv_add(v, m, strlen(m));
+}
+
+/** 按遍历顺序拼成 "a,b,c" */
+static const char *members(const osv *v) {
+    static char out[1024];
+    struct osetv_iter it;
+    const char *m;
+    uint32_t mlen;
+    size_t n = 0;
+    osetv_iter_init(&it, v);
+    while (osetv_next(&it, &m, &mlen)) {
+        if (n) out[n++] = ',';
+        memcpy(out + n, m, mlen);
+        n += mlen;
+    }
+    out[n] = 0;
+    return out;
+}
+
+// Test 1: 整数编码的宽度升级, 删除, 转换
+static void test_set_intset(void) {
+    TEST_START("Adaptive integer encoding");
+
+    osv *v = osetv_new();
+    ASSERT_EQ(v->enc, OSV_SET_INT16, "starts as int16");
+    ASSERT_EQ(add(&v, "5"), 1, "add 5");
+    ASSERT_EQ(add(&v, "-3"), 1, "add -3");
+    ASSERT_EQ(add(&v, "100"), 1, "add 100");
+    ASSERT_EQ(add(&v, "5"), 0, "duplicate");
+    ASSERT_EQ(v->vlen, 6, "three int16");
+    ASSERT_TRUE(!strcmp(members(v), "-3,5,100"), "sorted");
+
+    ASSERT_EQ(add(&v, "70000"), 1, "needs int32");
+    ASSERT_EQ(v->enc, OSV_SET_INT32, "upgraded to int32");
+    ASSERT_TRUE(!strcmp(members(v), "-3,5,100,70000"), "appended after upgrade");
+    ASSERT_EQ(add(&v, "-9223372036854775808"), 1, "needs int64");
+    ASSERT_EQ(v->enc, OSV_SET_INT64, "upgraded to int64");
+    ASSERT_EQ(v->vlen, 5 * 8, "five int64");
+    ASSERT_TRUE(!strcmp(members(v), "-9223372036854775808,-3,5,100,70000"), "prepended after upgrade");
+
+    ASSERT_TRUE(osetv_has(v, "70000", 5), "has 70000");
+    ASSERT_TRUE(!osetv_has(v, "7", 1), "no 7");
+    ASSERT_TRUE(!osetv_has(v, "05", 2), "non-canonical form is another member");
+    ASSERT_EQ(osetv_del(v, "5", 1), 1, "del 5");
+    ASSERT_EQ(osetv_del(v, "5", 1), 0, "del again");
+    ASSERT_EQ(osetv_del(v, "x", 1), 0, "del non-integer");
+    ASSERT_EQ(osetv_len(v), 4, "len after del");
+    ASSERT_EQ(v->enc, OSV_SET_INT64, "never downgrades");
+
+    ASSERT_EQ(add(&v, "05"), 1, "non-canonical integer");
+    ASSERT_EQ(v->enc, OSV_SET_TABLE, "converted to table");
+    ASSERT_EQ(osetv_len(v), 5, "members kept");
+    ASSERT_TRUE(osetv_has(v, "-3", 2) && osetv_has(v, "05", 2) && osetv_has(v, "70000", 5), "lookups on table");
+    ASSERT_EQ(add(&v, "100"), 0, "integer already in table");
+    ASSERT_EQ(osetv_del(v, "100", 3), 1, "del from table");
+    osetv_clear(v);
+    free(v);
+
+    // 超过 oset_intset_max
+    v = osetv_new();
+    char m[24];
+    for (uint32_t i = 0; i < oset_intset_max; i++) add(&v, (snprintf(m, sizeof(m), "%u", i * 7), m));
+    ASSERT_EQ(v->enc, OSV_SET_INT16, "still packed at the limit");
+    ASSERT_EQ(add(&v, "1"), 1, "one past the limit");
+    ASSERT_EQ(v->enc, OSV_SET_TABLE, "converted past the limit");
+    ASSERT_EQ(osetv_len(v), oset_intset_max + 1, "all members kept");
+    osetv_clear(v);
+    free(v);
+
+    TEST_PASS();
+}
+
+/** 严格升序的随机数组, 间隔 1..gap */
+#define FILL_SORTED(T, arr, n, start, gap)                                           \
+    do {                                                                             \
+        int64_t x_ = (start);                                                        \
+        for (size_t i_ = 0; i_ < (n); i_++) {                                        \
+            x_ += 1 + (int64_t) (test_rand64() % (gap));                                     \
+            (arr)[i_] = (T) x_;                                                      \
+        }                                                                            \
+    } while (0)
+
+#define REF_INTER(T, a, na, b, nb, out, k)                                           \
+    do {                                                                             \
+        size_t i_ = 0, j_ = 0;                                                       \
+        (k) = 0;                                                                     \
+        while (i_ < (na) && j_ < (nb)) {                                             \
+            if ((a)[i_] < (b)[j_]) i_++;                                             \
+            else if ((a)[i_] > (b)[j_]) j_++;                                        \
+            else {                                                                   \
+                (out)[(k)++] = (a)[i_];                                              \
+                i_++;                                                                \
+                j_++;                                                                \
+            }                                                                        \
+        }                                                                            \
+    } while (0)
+
+// 每种宽度: 随机长度 / 密度 / 大小悬殊, 与标量参考比较, 交换两侧结果不变
+#define CHECK_KERNEL(T, fn, lo)                                                      \
+    do {                                                                             \
+        T *a = malloc(4096 * sizeof(T)), *b = malloc(4096 * sizeof(T));              \
+        T *ref = malloc(4096 * sizeof(T)), *got = malloc(4096 * sizeof(T));          \
+        int ok = 1;                                                                  \
+        for (int round = 0; round < 400 && ok; round++) {                            \
+            size_t na = test_rand64() % (round < 200 ? 64 : 2000), nb = test_rand64() % 2000;        \
+            if (round % 7 == 0) na = test_rand64() % 8;                                      \
+            uint64_t gap = 1 + test_rand64() % 6;                                            \
+            FILL_SORTED(T, a, na, (lo), gap);                                        \
+            FILL_SORTED(T, b, nb, (lo) + (int64_t) (test_rand64() % 4), gap);                \
+            size_t k;                                                                \
+            REF_INTER(T, a, na, b, nb, ref, k);                                      \
+            size_t g = fn(a, na, b, nb, got);                                        \
+            if (g != k || memcmp(ref, got, k * sizeof(T))) ok = 0;                   \
+            if (fn(b, nb, a, na, got) != k || memcmp(ref, got, k * sizeof(T))) ok = 0; \
+        }                                                                            \
+        ASSERT_TRUE(ok, #fn " matches the scalar reference");                        \
+        free(a);                                                                     \
+        free(b);                                                                     \
+        free(ref);                                                                   \
+        free(got);                                                                   \
+    } while (0)
+
+// Test 2: SIMD 交集与标量参考一致
+static void test_set_kernels(void) {
+    TEST_START("Intersection kernels vs scalar reference");
+
+    CHECK_KERNEL(int16_t, oset_inter16, -3000);
+    CHECK_KERNEL(int32_t, oset_inter32, -2000000000LL);
+    CHECK_KERNEL(int64_t, oset_inter64, -9000000000000000000LL);
+
+    // 混合宽度走 osetv_inter_int / osetv_union_int
+    osv *a = osetv_new(), *b = osetv_new();
+    const char *am[] = {"1", "2", "3", "40000", "5000000000"};
+    const char *bm[] = {"-7", "2", "3", "40000", "6"};
+    for (int i = 0; i < 5; i++) {
+        add(&a, am[i]);
+        add(&b, bm[i]);
+    }
+    ASSERT_EQ(a->enc, OSV_SET_INT64, "a is int64");
+    ASSERT_EQ(b->enc, OSV_SET_INT32, "b is int32");
+    osv *r = osetv_inter_int(a, b);
+    ASSERT_TRUE(!strcmp(members(r), "2,3,40000"), "mixed-width intersection");
+    ASSERT_EQ(r->enc, OSV_SET_INT64, "result takes the wider width");
+    free(r);
+    r = osetv_union_int(b, a);
+    ASSERT_TRUE(!strcmp(members(r), "-7,1,2,3,6,40000,5000000000"), "mixed-width union");
+    free(r);
+    free(a);
+    free(b);
+
+    TEST_PASS();
+}
+
+// Test 3: S* 命令
+static void test_set_dispatch(void) {
+    TEST_START("Set commands through cmd_dispatch");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *sadd_a[] = {"SADD", "a", "3", "1", "2", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, sadd_a), ":3\r\n"), "SADD ints");
+    const char *sadd_b[] = {"SADD", "b", "2", "3", "4"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, sadd_b), ":3\r\n"), "SADD b");
+    const char *smembers[] = {"SMEMBERS", "a"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, smembers), "*3\r\n$1\r\n1\r\n$1\r\n2\r\n$1\r\n3\r\n"), "SMEMBERS sorted");
+    const char *sinter[] = {"SINTER", "a", "b"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, sinter), "*2\r\n$1\r\n2\r\n$1\r\n3\r\n"), "SINTER intsets");
+    const char *sunion[] = {"SUNION", "a", "b", "nokey"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, sunion), "*4\r\n$1\r\n1\r\n$1\r\n2\r\n$1\r\n3\r\n$1\r\n4\r\n"),
+                "SUNION intsets, missing key is empty");
+    const char *sinter_missing[] = {"SINTER", "a", "nokey"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, sinter_missing), "*0\r\n"), "SINTER with a missing key");
+    const char *sismember[] = {"SISMEMBER", "a", "2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, sismember), ":1\r\n"), "SISMEMBER");
+    const char *sismember_no[] = {"SISMEMBER", "a", "9"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, sismember_no), ":0\r\n"), "SISMEMBER miss");
+
+    // 非整数成员: b 转成 TABLE, 交集走逐个查找
+    const char *sadd_str[] = {"SADD", "b", "x"};
+    exec(&cn, 3, sadd_str);
+    ASSERT_EQ(((osv *) olookup("b", 1)->v)->enc, OSV_SET_TABLE, "b converted");
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, sinter), "*2\r\n$1\r\n2\r\n$1\r\n3\r\n"), "SINTER mixed encodings");
+    const char *sunion2[] = {"SUNION", "a", "b"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, sunion2), "*5\r\n", 4), "SUNION mixed encodings");
+    const char *scard[] = {"SCARD", "b"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, scard), ":4\r\n"), "SCARD");
+
+    const char *srem[] = {"SREM", "a", "1", "2", "3", "9"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, srem), ":3\r\n"), "SREM");
+    ASSERT_NULL(olookup("a", 1), "empty set removes the key");
+    const char *scard_a[] = {"SCARD", "a"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, scard_a), ":0\r\n"), "SCARD missing key");
+
+    const char *set[] = {"SET", "str", "v"};
+    exec(&cn, 3, set);
+    const char *sadd_wt[] = {"SADD", "str", "1"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, sadd_wt), "-WRONGTYPE", 10), "SADD on a string");
+    const char *sinter_wt[] = {"SINTER", "b", "str"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, sinter_wt), "-WRONGTYPE", 10), "SINTER with a string");
+    const char *lpush[] = {"LPUSH", "b", "x"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, lpush), "-WRONGTYPE", 10), "LPUSH on a set");
+
+    const char *del[] = {"DEL", "b", "str"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, del), ":2\r\n"), "DEL set and string");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+static size_t scalar_inter32(const int32_t *a, size_t na, const int32_t *b, size_t nb, int32_t *out) {
+    size_t k;
+    REF_INTER(int32_t, a, na, b, nb, out, k);
+    return k;
+}
+
+// Test 4: 两个 1M 成员的整数集合求交
+static void test_set_benchmark(void) {
+    TEST_START("SINTER throughput (2 x 1M integer members)");
+
+    const size_t n = 1000000;
+    int32_t *a = malloc(n * sizeof(int32_t)), *b = malloc(n * sizeof(int32_t)), *out = malloc(n * sizeof(int32_t));
+    // 随机间隔 1..4, 命中的位置不可预测 (标量归并的分支无法预测)
+    FILL_SORTED(int32_t, a, n, 0, 4);
+    FILL_SORTED(int32_t, b, n, 0, 4);
+    const int rounds = 5;
+    size_t k = 0, ks = 0;
+    double t0 = get_time_ns();
+    for (int r = 0; r < rounds; r++) k = oset_inter32(a, n, b, n, out);
+    double simd_ns = (get_time_ns() - t0) / rounds;
+    t0 = get_time_ns();
+    for (int r = 0; r < rounds; r++) ks = scalar_inter32(a, n, b, n, out);
+    double scalar_ns = (get_time_ns() - t0) / rounds;
+    ASSERT_EQ(k, ks, "same result");
+    ASSERT_GT(k, n / 5, "overlapping sets");
+
+    // 同样的成员在 TABLE 编码下逐个查找 (SINTER 的非整数路径)
+    uint32_t saved = oset_intset_max;
+    oset_intset_max = 0;
+    osv *t = osetv_new();
+    char m[24];
+    for (size_t i = 0; i < n; i++) osetv_add(&t, m, snprintf(m, sizeof(m), "%d", b[i]));
+    oset_intset_max = saved;
+    size_t hits = 0;
+    t0 = get_time_ns();
+    for (size_t i = 0; i < n; i++) hits += osetv_has(t, m, snprintf(m, sizeof(m), "%d", a[i]));
+    double probe_ns = get_time_ns() - t0;
+    ASSERT_EQ(hits, k, "hash probes agree");
+    osetv_clear(t);
+    free(t);
+
+    double bytes = 2.0 * n * sizeof(int32_t);
+    printf("\n      SIMD merge   : %.2f ms (%.2f GB/s)\n", simd_ns / 1e6, bytes / simd_ns);
+    printf("      scalar merge : %.2f ms (%.2f GB/s)\n", scalar_ns / 1e6, bytes / scalar_ns);
+    printf("      hash probes  : %.2f ms\n", probe_ns / 1e6);
+    ASSERT_LT(simd_ns, probe_ns, "sorted intersection beats hash probing");
+
+    free(a);
+    free(b);
+    free(out);
+    TEST_PASS();
+}
+
+/** SADD key 的 n 个整数成员, 每条命令最多 60 个 */
+static void sadd_ints(struct connection_t *cn, const char *key, const int32_t *a, size_t n) {
+    static char bf[60][12];
+    const char *args[62] = {"SADD", key};
+    for (size_t i = 0; i < n;) {
+        int c = 0;
+        for (; c < 60 && i < n; c++, i++) {
+            snprintf(bf[c], sizeof(bf[c]), "%d", a[i]);
+            args[2 + c] = bf[c];
+        }
+        exec(cn, 2 + c, args);
+    }
+}
+
+// Test 5: 经过 cmd_dispatch 的 SINTER, 大集合的两种编码
+static void test_sinter_benchmark(void) {
+    TEST_START("SINTER through dispatch (2 x 200K integer members)");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const size_t n = 200000;
+    int32_t *a = malloc(n * sizeof(int32_t)), *b = malloc(n * sizeof(int32_t)), *out = malloc(n * sizeof(int32_t));
+    FILL_SORTED(int32_t, a, n, 0, 4);
+    FILL_SORTED(int32_t, b, n, 0, 4);
+    size_t k = scalar_inter32(a, n, b, n, out);
+
+    // 默认的 oset_intset_max: 超过 512 个成员转成 TABLE, SINTER 逐个查找
+    sadd_ints(&cn, "st:a", a, n);
+    sadd_ints(&cn, "st:b", b, n);
+    ASSERT_EQ(((osv *) olookup("st:a", 4)->v)->enc, OSV_SET_TABLE, "large set is a TABLE");
+    // 调大 oset_intset_max: 保持整数数组, SINTER 是 SIMD 有序交集
+    uint32_t saved = oset_intset_max;
+    oset_intset_max = UINT32_MAX;
+    sadd_ints(&cn, "si:a", a, n);
+    sadd_ints(&cn, "si:b", b, n);
+    oset_intset_max = saved;
+    ASSERT_TRUE(osetv_is_int(olookup("si:a", 4)->v), "large set stays an intset");
+
+    const char *qt[] = {"SINTER", "st:a", "st:b"};
+    const char *qi[] = {"SINTER", "si:a", "si:b"};
+    const int rounds = 5;
+    double t0 = get_time_ns();
+    for (int r = 0; r < rounds; r++) exec(&cn, 3, qt);
+    double table_ns = (get_time_ns() - t0) / rounds;
+    ASSERT_EQ((size_t) atoll(cn.write_buffer + 1), k, "TABLE path: intersection size");
+    size_t table_len = (size_t) cn.wb_limit;
+    t0 = get_time_ns();
+    for (int r = 0; r < rounds; r++) exec(&cn, 3, qi);
+    double int_ns = (get_time_ns() - t0) / rounds;
+    ASSERT_EQ((size_t) atoll(cn.write_buffer + 1), k, "intset path: intersection size");
+    ASSERT_EQ((size_t) cn.wb_limit, table_len, "same reply size");
+
+    printf("\n      TABLE (hash probes) : %.2f ms/SINTER\n", table_ns / 1e6);
+    printf("      intset (SIMD merge) : %.2f ms/SINTER\n", int_ns / 1e6);
+    ASSERT_LT(int_ns, table_ns, "sorted intersection beats hash probing");
+
+    const char *del[] = {"DEL", "st:a", "st:b", "si:a", "si:b"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, del), ":4\r\n"), "cleanup");
+    free(a);
+    free(b);
+    free(out);
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+void run_cmd_set_tests(void) {
+    TEST_SUITE_START("CMD Set Type Tests");
+    test_rand_seed(88172645463325252ULL);
+
+    test_set_intset();
+    test_set_kernels();
+    test_set_dispatch();
+    test_set_benchmark();
+    test_sinter_benchmark();
+
+    TEST_SUITE_END();
+}
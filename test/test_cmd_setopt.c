@@ -0,0 +1,201 @@
+//
+// SET Option Tests for CMD + OHASH
+// Tests: SET NX/XX/GET/KEEPTTL/EX.., GETSET/GETDEL/GETEX, single probe vs SET4dup + EXPIRED
+//
+
+#include "test_cmd_common.h"
+#include <assert.h>
+
+// Test 1: conditional writes, TTL handling and ownership of the old value
+static void test_setopt_semantics(void) {
+    TEST_START("SETOPT4dup NX/XX/KEEPTTL/GET");
+
+    osv *old;
+    ASSERT_EQ(SETOPT4dup("so", 2, "a", 1, 0, SET_XX, NULL), 0, "XX on missing key");
+    ASSERT_NULL(GET("so", 2), "XX did not create");
+    ASSERT_EQ(SETOPT4dup("so", 2, "a", 1, 0, SET_NX, NULL), 1, "NX on missing key");
+    ASSERT_EQ(SETOPT4dup("so", 2, "b", 1, 0, SET_NX | SET_GET, &old), 0, "NX on existing key");
+    ASSERT_TRUE(old && old == GET("so", 2), "NX+GET returns the borrowed current value");
+
+    uint64_t ttl = get_current_time_ms() + 100000;
+    ASSERT_EQ(SETOPT4dup("so", 2, "bb", 2, ttl, SET_XX, NULL), 1, "XX on existing key");
+    ASSERT_EQ(olookup("so", 2)->expiratime, ttl, "TTL written in the same probe");
+    ASSERT_EQ(SETOPT4dup("so", 2, "cc", 2, 0, SET_KEEPTTL, NULL), 1, "KEEPTTL");
+    ASSERT_EQ(olookup("so", 2)->expiratime, ttl, "TTL kept");
+    ASSERT_EQ(SETOPT4dup("so", 2, "dd", 2, 0, 0, NULL), 1, "plain SET");
+    ASSERT_EQ(olookup("so", 2)->expiratime, 0, "plain SET clears TTL");
+
+    ASSERT_EQ(SETOPT4dup("so", 2, "eee", 3, 0, SET_GET, &old), 1, "SET GET");
+    ASSERT_TRUE(old && old->vlen == 2 && !memcmp(old->d, "dd", 2), "old value handed back");
+    ASSERT_TRUE(GET("so", 2) != old, "slot holds the new value");
+    free(old);
+
+    // 同尺寸覆盖直接复用 osv, key 也不再复制
+    osv *before = GET("so", 2);
+    char *key_before = olookup("so", 2)->key;
+    ASSERT_EQ(SETOPT4dup("so", 2, "fff", 3, 0, 0, NULL), 1, "overwrite");
+    ASSERT_TRUE(GET("so", 2) == before, "osv reused in place");
+    ASSERT_TRUE(olookup("so", 2)->key == key_before, "key not duplicated");
+    ASSERT_STR_EQ(GET("so", 2)->d, "fff", 3, "new content");
+
+    // 过期的 key 对 NX 来说不存在
+    SETOPT4dup("sx", 2, "old", 3, 1, 0, NULL);
+    ASSERT_EQ(SETOPT4dup("sx", 2, "new", 3, 0, SET_NX, NULL), 1, "NX over an expired key");
+    ASSERT_STR_EQ(GET("sx", 2)->d, "new", 3, "expired value replaced");
+
+    int err;
+    osv *v = GETDEL("sx", 2, &err);
+    ASSERT_TRUE(v && !err && !memcmp(v->d, "new", 3), "GETDEL returns the value");
+    free(v);
+    ASSERT_NULL(GET("sx", 2), "GETDEL removed the key");
+    ASSERT_NULL(GETDEL("sx", 2, &err), "GETDEL on missing key");
+
+    v = GETEX("so", 2, 1, ttl);
+    ASSERT_NOT_NULL(v, "GETEX hit");
+    ASSERT_EQ(olookup("so", 2)->expiratime, ttl, "GETEX set TTL");
+    GETEX("so", 2, 1, 0);
+    ASSERT_EQ(olookup("so", 2)->expiratime, 0, "GETEX PERSIST");
+
+    TEST_PASS();
+}
+
+// Test 2: dispatch level option parsing and replies
+static void test_setopt_dispatch(void) {
+    TEST_START("SET options / GETSET / GETDEL / GETEX through dispatch");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+    assert(cn.write_buffer);
+
+    const char *s1[] = {"SET", "dk", "v1", "nx", "EX", "100"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, s1), "+OK\r\n"), "SET NX EX");
+    ASSERT_TRUE(olookup("dk", 2)->expiratime >= get_current_time_ms() + 99000, "EX applied");
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, s1), "$-1\r\n"), "SET NX on existing key");
+    const char *s2[] = {"SET", "dk", "v2", "XX", "GET", "KEEPTTL"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, s2), "$2\r\nv1\r\n"), "SET XX GET KEEPTTL");
+    ASSERT_TRUE(olookup("dk", 2)->expiratime > 0, "KEEPTTL kept the TTL");
+    const char *s3[] = {"SET", "dk", "v3", "PX", "1500"};
+    uint64_t now = get_current_time_ms();
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, s3), "+OK\r\n"), "SET PX");
+    uint64_t px_at = olookup("dk", 2)->expiratime;
+    ASSERT_TRUE(px_at >= now + 1500 && px_at <= get_current_time_ms() + 1500, "PX keeps millisecond precision");
+    const char *s4[] = {"SET", "dk", "v4", "EXAT", "4000000000"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, s4), "+OK\r\n"), "SET EXAT");
+    ASSERT_TRUE(olookup("dk", 2)->expiratime == 4000000000000ULL, "EXAT absolute, in ms");
+
+    const char *bad1[] = {"SET", "dk", "v", "NX", "XX"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, bad1), "-ERR syntax error\r\n"), "NX XX");
+    const char *bad2[] = {"SET", "dk", "v", "EX", "10", "KEEPTTL"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, bad2), "-ERR syntax error\r\n"), "EX KEEPTTL");
+    const char *bad3[] = {"SET", "dk", "v", "EX", "0"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, bad3), "-ERR invalid expire time in 'set' command\r\n"), "EX 0");
+    const char *bad4[] = {"SET", "dk", "v", "EX"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, bad4), "-ERR syntax error\r\n"), "EX without value");
+    const char *bad5[] = {"SET", "dk", "v", "PX", "abc"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, bad5), "-ERR value is not an integer or out of range\r\n"), "PX abc");
+    const char *get[] = {"GET", "dk"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, get), "$2\r\nv4\r\n"), "failed SETs did not write");
+
+    const char *gs[] = {"GETSET", "dk", "v5"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, gs), "$2\r\nv4\r\n"), "GETSET");
+    ASSERT_EQ(olookup("dk", 2)->expiratime, 0, "GETSET clears TTL");
+    const char *gx[] = {"GETEX", "dk", "EX", "50"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, gx), "$2\r\nv5\r\n"), "GETEX EX");
+    ASSERT_TRUE(olookup("dk", 2)->expiratime > 0, "GETEX set TTL");
+    const char *gp[] = {"GETEX", "dk", "persist"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, gp), "$2\r\nv5\r\n"), "GETEX PERSIST");
+    ASSERT_EQ(olookup("dk", 2)->expiratime, 0, "PERSIST cleared TTL");
+    const char *gbad[] = {"GETEX", "dk", "EX"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, gbad), "-ERR syntax error\r\n"), "GETEX EX without value");
+    const char *gd[] = {"GETDEL", "dk"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, gd), "$2\r\nv5\r\n"), "GETDEL");
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, gd), "$-1\r\n"), "GETDEL again");
+
+    const char *ci[] = {"INCR", "dn"};
+    exec(&cn, 2, ci);
+    const char *gsi[] = {"SET", "dn", "x", "GET"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, gsi), "$1\r\n1\r\n"), "SET GET formats an OSV_INT");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 3: SET with TTL in one probe vs SET4dup + EXPIRED, NX vs GET + SET4dup
+static void test_setopt_benchmark(void) {
+    TEST_START("SET EX single probe vs SET4dup + EXPIRED");
+
+    const int nkeys = 1 << 20;
+    char (*keys)[16] = malloc(16 * (size_t) nkeys);
+    uint32_t *lens = malloc(sizeof(uint32_t) * nkeys);
+    uint32_t *order = malloc(sizeof(uint32_t) * nkeys);
+    assert(keys && lens && order);
+    for (int i = 0; i < nkeys; i++) {
+        lens[i] = snprintf(keys[i], 16, "se_%d", i);
+        order[i] = i;
+    }
+    srand(11);
+    for (int i = nkeys - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        uint32_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+    for (int i = 0; i < nkeys; i++) SET4dup(keys[i], lens[i], "v0", 2, 0);
+    uint64_t ttl = get_current_time_ms() + 3600000;
+
+    double t0 = get_time_ns();
+    for (int i = 0; i < nkeys; i++) {
+        uint32_t k = order[i];
+        SET4dup(keys[k], lens[k], "value_16_bytes__", 16, 0);
+        EXPIRED(keys[k], lens[k], ttl);
+    }
+    double two_ns = (get_time_ns() - t0) / nkeys;
+
+    t0 = get_time_ns();
+    for (int i = 0; i < nkeys; i++) {
+        uint32_t k = order[i];
+        SETOPT4dup(keys[k], lens[k], "value_16_bytes__", 16, ttl, 0, NULL);
+    }
+    double one_ns = (get_time_ns() - t0) / nkeys;
+    ASSERT_EQ(olookup(keys[0], lens[0])->expiratime, ttl, "TTL applied");
+
+    // 条件写: GET 判断后再 SET 对比 NX 一次 probe (一半 key 存在)
+    // 进程内第二次 probe 已经在 cache 中, 这里只做参考; NX 省下的主要是客户端的往返
+    for (int i = 0; i < nkeys; i += 2) DEL(keys[i], lens[i], free);
+    t0 = get_time_ns();
+    for (int i = 0; i < nkeys; i++) {
+        uint32_t k = order[i];
+        if (!GET(keys[k], lens[k])) SET4dup(keys[k], lens[k], "nx", 2, 0);
+    }
+    double getset_ns = (get_time_ns() - t0) / nkeys;
+    for (int i = 0; i < nkeys; i += 2) DEL(keys[i], lens[i], free);
+    t0 = get_time_ns();
+    for (int i = 0; i < nkeys; i++) {
+        uint32_t k = order[i];
+        SETOPT4dup(keys[k], lens[k], "nx", 2, 0, SET_NX, NULL);
+    }
+    double nx_ns = (get_time_ns() - t0) / nkeys;
+
+    printf("\n      %d keys, random order\n", nkeys);
+    printf("      SET4dup + EXPIRED : %.1f ns/op\n", two_ns);
+    printf("      SET EX (1 probe)  : %.1f ns/op (%.2fx)\n", one_ns, two_ns / one_ns);
+    printf("      GET + SET4dup     : %.1f ns/op\n", getset_ns);
+    printf("      SET NX (1 probe)  : %.1f ns/op (%.2fx)\n", nx_ns, getset_ns / nx_ns);
+    free(keys);
+    free(lens);
+    free(order);
+    ASSERT_LT(one_ns, two_ns, "single probe SET EX should be cheaper");
+
+    TEST_PASS();
+}
+
+void run_cmd_setopt_tests(void) {
+    TEST_SUITE_START("CMD SET Options Tests");
+
+    test_setopt_semantics();
+    test_setopt_dispatch();
+    test_setopt_benchmark();
+
+    TEST_SUITE_END();
+}
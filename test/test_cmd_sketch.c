@@ -0,0 +1,236 @@
+//
+// Count-Min Sketch / Top-K Type Tests for CMD + OHASH
+// Tests: CMS error bounds, gather-min vs scalar rows, HeavyKeeper heavy hitters, CMS.* / TOPK.* commands, query throughput
+//
+
+#include "test_cmd_common.h"
+
+static uint64_t hash_of(const char *prefix, uint32_t i) {
+    char e[48];
+    return osketch_hash(e, (uint64_t) snprintf(e, sizeof(e), "%s:%u", prefix, i));
+}
+
+/** 逐行读取计数器的参考实现 */
+static uint32_t ref_query(const osv *v, uint64_t h) {
+    const struct ocms *s = ocmsv_cms(v);
+    uint32_t h1 = (uint32_t) h, h2 = (uint32_t) (h >> 32) | 1U, min = UINT32_MAX;
+    for (uint32_t i = 0; i < s->depth; i++) {
+        uint32_t col = (uint32_t) (((uint64_t) (h1 + i * h2) * s->width) >> 32);
+        uint32_t c = s->c[(uint64_t) i * s->width + col];
+        if (c < min) min = c;
+    }
+    return min;
+}
+
+/** 第 i 个元素出现 N / (i + 1) 次, 近似 Zipf */
+#define ZIPF_ITEMS 5000
+#define ZIPF_TOP 20000
+
+// Test 1: 估计值不小于真实值, 绝大多数元素的误差在 error * count 以内
+static void test_cms_bounds(void) {
+    TEST_START("Count-Min Sketch error bounds and gather-min");
+
+    uint32_t w, d;
+    ASSERT_EQ(ocms_dims(0.001, 0.01, &w, &d), 0, "dims by probability");
+    ASSERT_EQ(w, 2000, "width = 2 / error");
+    ASSERT_EQ(d, 7, "depth = log2(1 / prob)");
+    ASSERT_EQ(ocms_dims(1e-9, 1e-9, &w, &d), -EINVAL, "too large");
+
+    osv *v = ocmsv_new(w, d);
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < ZIPF_ITEMS; i++) {
+        uint32_t n = ZIPF_TOP / (i + 1);
+        ocmsv_incrby(v, hash_of("z", i), n);
+        total += n;
+    }
+    ASSERT_EQ(ocmsv_cms(v)->count, total, "total count");
+    uint32_t under = 0, over = 0, mismatch = 0;
+    for (uint32_t i = 0; i < ZIPF_ITEMS; i++) {
+        uint64_t h = hash_of("z", i);
+        uint32_t est = ocmsv_query(v, h), n = ZIPF_TOP / (i + 1);
+        under += est < n;
+        over += est > n + 0.001 * total;
+        mismatch += est != ref_query(v, h);
+    }
+    ASSERT_EQ(under, 0, "never underestimates");
+    ASSERT_LT(over, ZIPF_ITEMS / 100, "error bound holds with probability 1 - prob");
+    ASSERT_EQ(mismatch, 0, "vector gather matches the row by row minimum");
+
+    // depth 不是 8 的倍数, 以及 16 行 (两次 gather)
+    static const uint32_t depths[] = {1, 5, 9, 16};
+    for (size_t k = 0; k < sizeof(depths) / sizeof(depths[0]); k++) {
+        osv *s = ocmsv_new(97, depths[k]);
+        for (uint32_t i = 0; i < 1000; i++) ocmsv_incrby(s, hash_of("d", i), i % 7 + 1);
+        mismatch = 0;
+        for (uint32_t i = 0; i < 2000; i++) mismatch += ocmsv_query(s, hash_of("d", i)) != ref_query(s, hash_of("d", i));
+        ASSERT_EQ(mismatch, 0, "gather with partial lanes");
+        osv_free(s);
+    }
+
+    // 饱和而不是回绕
+    osv *s = ocmsv_new(4, 2);
+    ocmsv_incrby(s, 1, UINT32_MAX - 1);
+    ASSERT_EQ(ocmsv_incrby(s, 1, 5), UINT32_MAX, "counters saturate");
+    osv_free(s);
+    osv_free(v);
+    TEST_PASS();
+}
+
+// Test 2: HeavyKeeper 在大量噪声中留住大流量元素
+static void test_topk_heavy(void) {
+    TEST_START("Top-K keeps the heavy hitters");
+
+    osv *v = otopkv_new(10, 200, 5, 0.9);
+    char e[32];
+    uint32_t expelled = 0;
+    for (uint32_t round = 0; round < 200; round++) {
+        for (uint32_t i = 0; i < 10; i++) {
+            // 热点 i 每轮出现 (i + 1) * 5 次
+            uint32_t len = (uint32_t) snprintf(e, sizeof(e), "hot:%u", i);
+            for (uint32_t r = 0; r < (i + 1) * 5; r++) {
+                char *out;
+                uint32_t olen;
+                if (otopkv_add(v, e, len, osketch_hash(e, len), &out, &olen) == 1) {
+                    expelled++;
+                    free(out);
+                }
+            }
+        }
+        for (uint32_t i = 0; i < 500; i++) {
+            uint32_t len = (uint32_t) snprintf(e, sizeof(e), "noise:%u:%u", round, i);
+            char *out;
+            uint32_t olen;
+            if (otopkv_add(v, e, len, osketch_hash(e, len), &out, &olen) == 1) {
+                expelled++;
+                free(out);
+            }
+        }
+    }
+    const struct otopk_item *items[10];
+    uint32_t n = otopkv_list(v, items), hot = 0;
+    ASSERT_EQ(n, 10, "heap is full");
+    for (uint32_t i = 0; i < n; i++) hot += !strncmp(items[i]->item, "hot:", 4);
+    for (uint32_t i = 1; i < n; i++) ASSERT_TRUE(items[i - 1]->count >= items[i]->count, "sorted by count");
+    ASSERT_EQ(hot, 10, "all heavy hitters survive 100k noise items");
+    ASSERT_TRUE(!memcmp(items[0]->item, "hot:9", 5), "heaviest first");
+    ASSERT_GT(items[0]->count, 9000, "count of the heaviest is close to 10000");
+    uint64_t bytes = sizeof(osv) + v->vlen;
+    printf("\n      fixed payload %llu bytes, %u expelled\n", (unsigned long long) bytes, expelled);
+    osv_free(v);
+    TEST_PASS();
+}
+
+static void test_sketch_dispatch(void) {
+    TEST_START("CMS.* / TOPK.* commands through cmd_dispatch");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *init[] = {"CMS.INITBYDIM", "cms", "1000", "5"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, init), "+OK\r\n"), "CMS.INITBYDIM");
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, init), "-CMS: key already exists\r\n"), "existing key");
+    const char *bad_depth[] = {"CMS.INITBYDIM", "x", "10", "17"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, bad_depth), "-CMS: invalid depth\r\n"), "depth limit");
+    const char *byprob[] = {"CMS.INITBYPROB", "cms2", "0.01", "0.001"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, byprob), "+OK\r\n"), "CMS.INITBYPROB");
+    ASSERT_EQ(ocmsv_cms((osv *) olookup("cms2", 4)->v)->width, 200, "width from error");
+    const char *bad_prob[] = {"CMS.INITBYPROB", "x", "0.01", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, bad_prob), "-CMS: invalid prob value\r\n"), "probability range");
+
+    const char *incr[] = {"CMS.INCRBY", "cms", "a", "5", "b", "2", "a", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, incr), "*3\r\n:5\r\n:2\r\n:6\r\n"), "CMS.INCRBY");
+    const char *incr_bad[] = {"CMS.INCRBY", "cms", "a", "5", "b", "x"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, incr_bad), "-CMS: Cannot parse number\r\n"), "bad increment");
+    const char *incr_odd[] = {"CMS.INCRBY", "cms", "a", "5", "b"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 5, incr_odd), "-ERR wrong number", 17), "item without increment");
+    const char *query[] = {"CMS.QUERY", "cms", "a", "b", "c"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, query), "*3\r\n:6\r\n:2\r\n:0\r\n"), "CMS.QUERY, bad INCRBY applied nothing");
+    const char *query_miss[] = {"CMS.QUERY", "nokey", "a"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, query_miss), "-CMS: key does not exist\r\n"), "missing sketch");
+
+    const char *reserve[] = {"TOPK.RESERVE", "tk", "2", "50", "4", "0.9"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, reserve), "+OK\r\n"), "TOPK.RESERVE");
+    const char *reserve_def[] = {"TOPK.RESERVE", "tk2", "3"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, reserve_def), "+OK\r\n"), "TOPK.RESERVE with defaults");
+    ASSERT_EQ(otopkv_tk((osv *) olookup("tk2", 3)->v)->width, OTOPK_WIDTH_DEFAULT, "default width");
+    const char *bad_decay[] = {"TOPK.RESERVE", "x", "2", "50", "4", "1.5"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 6, bad_decay), "-TopK: invalid decay", 20), "decay range");
+    const char *add[] = {"TOPK.ADD", "tk", "a", "a", "b"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, add), "*3\r\n$-1\r\n$-1\r\n$-1\r\n"), "TOPK.ADD fills the heap");
+    const char *add2[] = {"TOPK.ADD", "tk", "c", "c", "c"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, add2), "*3\r\n$1\r\nb\r\n$-1\r\n$-1\r\n"), "c expels b");
+    const char *list[] = {"TOPK.LIST", "tk"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, list), "*2\r\n$1\r\nc\r\n$1\r\na\r\n"), "TOPK.LIST");
+    const char *listc[] = {"TOPK.LIST", "tk", "WITHCOUNT"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, listc), "*4\r\n$1\r\nc\r\n:3\r\n$1\r\na\r\n:2\r\n"), "TOPK.LIST WITHCOUNT");
+    const char *list_miss[] = {"TOPK.LIST", "nokey"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, list_miss), "-TopK: key does not exist\r\n"), "missing Top-K");
+
+    const char *query_wt[] = {"CMS.QUERY", "tk", "a"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, query_wt), "-WRONGTYPE", 10), "CMS.QUERY on a Top-K");
+    const char *reserve_wt[] = {"TOPK.RESERVE", "cms", "2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, reserve_wt), "-TopK: key already exists\r\n"), "TOPK.RESERVE on a CMS");
+
+    const char *del[] = {"DEL", "cms", "cms2", "tk", "tk2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, del), ":4\r\n"), "DEL frees heap items");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 4: 1M 个不同元素后大小不变; gather-min 与逐行读取的查询吞吐
+static void test_sketch_benchmark(void) {
+    TEST_START("Fixed memory and query throughput");
+
+    enum { DISTINCT = 1000000, Q = 1000000 };
+    uint32_t w, d;
+    ocms_dims(0.00001, 0.001, &w, &d);
+    osv *v = ocmsv_new(w, d);
+    uint64_t before = sizeof(osv) + v->vlen;
+    uint64_t *h = malloc(sizeof(uint64_t) * DISTINCT);
+    for (uint32_t i = 0; i < DISTINCT; i++) h[i] = hash_of("ev", i);
+
+    double t0 = get_time_ns();
+    for (uint32_t i = 0; i < DISTINCT; i++) ocmsv_incrby(v, h[i], 1);
+    double single_ns = get_time_ns() - t0;
+    t0 = get_time_ns();
+    for (uint32_t i = 0; i < DISTINCT; i += OSKETCH_BATCH) {
+        for (uint32_t j = i; j < i + OSKETCH_BATCH; j++) ocmsv_prefetch(v, h[j]);
+        for (uint32_t j = i; j < i + OSKETCH_BATCH; j++) ocmsv_incrby(v, h[j], 1);
+    }
+    double batch_ns = get_time_ns() - t0;
+    ASSERT_EQ(sizeof(osv) + v->vlen, before, "memory is fixed regardless of cardinality");
+
+    uint64_t s1 = 0, s2 = 0;
+    t0 = get_time_ns();
+    for (uint32_t i = 0; i < Q; i++) s1 += ocmsv_query(v, h[i]);
+    double simd_ns = get_time_ns() - t0;
+    t0 = get_time_ns();
+    for (uint32_t i = 0; i < Q; i++) s2 += ref_query(v, h[i]);
+    double scalar_ns = get_time_ns() - t0;
+    ASSERT_EQ(s1, s2, "same estimates");
+    ASSERT_GT(s1, 2ULL * Q - 1, "every event counted twice");
+
+    printf("\n      %u x %u sketch = %.1f MB after %d distinct items", w, d, before / 1048576.0, DISTINCT);
+    printf("\n      incrby one by one : %.1f ns/item", single_ns / DISTINCT);
+    printf("\n      incrby prefetched : %.1f ns/item", batch_ns / DISTINCT);
+    printf("\n      query gather-min  : %.1f ns/item", simd_ns / Q);
+    printf("\n      query row by row  : %.1f ns/item\n", scalar_ns / Q);
+    ASSERT_LT(simd_ns / 1e6, 5000, "queries stay fast");
+
+    free(h);
+    osv_free(v);
+    TEST_PASS();
+}
+
+void run_cmd_sketch_tests(void) {
+    TEST_SUITE_START("CMD Count-Min Sketch / Top-K Type Tests");
+
+    test_cms_bounds();
+    test_topk_heavy();
+    test_sketch_dispatch();
+    test_sketch_benchmark();
+
+    TEST_SUITE_END();
+}
@@ -0,0 +1,331 @@
+//
+// Stream Type Tests for CMD + OHASH
+// Tests: macro node packing and ID seeks, XTRIM strategies, consumer group PEL, X* commands, append throughput
+//
+
+#include "test_cmd_common.h"
+
+/** 第 i 个 entry: 大多数是 {sensor, value}, 每 7 个换一组字段 */
+static uint32_t make_entry(uint32_t i, struct ostream_str *fv, char *bf) {
+    int n = snprintf(bf, 32, "%u", i * 31);
+    if (i % 7 == 0) {
+        fv[0] = (struct ostream_str) {"event", 5};
+        fv[1] = (struct ostream_str) {bf, (uint32_t) n};
+        fv[2] = (struct ostream_str) {"tag", 3};
+        fv[3] = (struct ostream_str) {"odd", 3};
+        return 2;
+    }
+    fv[0] = (struct ostream_str) {"sensor", 6};
+    fv[1] = (struct ostream_str) {"s-1", 3};
+    fv[2] = (struct ostream_str) {"value", 5};
+    fv[3] = (struct ostream_str) {bf, (uint32_t) n};
+    return 2;
+}
+
+static int entry_matches(struct ostream_entry *e, uint32_t i) {
+    struct ostream_str want[4], f, val;
+    char bf[32];
+    uint32_t n = make_entry(i, want, bf);
+    if (e->nfields != n || e->id.ms != 1000 + i / 3 || e->id.seq != i % 3) return 0;
+    for (uint32_t k = 0; k < n; k++) {
+        ostream_entry_next(e, &f, &val);
+        if (f.len != want[2 * k].len || memcmp(f.p, want[2 * k].p, f.len) != 0) return 0;
+        if (val.len != want[2 * k + 1].len || memcmp(val.p, want[2 * k + 1].p, val.len) != 0) return 0;
+    }
+    return 1;
+}
+
+static osv *fill(uint32_t n) {
+    osv *v = ostreamv_new();
+    struct ostream_str fv[4];
+    char bf[32];
+    for (uint32_t i = 0; i < n; i++) {
+        struct ostream_id id = {1000 + i / 3, i % 3};
+        uint32_t nf = make_entry(i, fv, bf);
+        ostreamv_append(v, &id, fv, nf);
+    }
+    return v;
+}
+
+// Test 1: 宏节点的打包 / 主字段表复用, 顺序遍历与按 ID 定位
+static void test_stream_nodes(void) {
+    TEST_START("Macro nodes, shared field names and ID seeks");
+
+    enum { N = 10000 };
+    osv *v = fill(N);
+    struct ostream *s = ostreamv_s(v);
+    ASSERT_EQ(s->length, N, "length");
+    ASSERT_EQ(s->nnodes, N / OSTREAM_NODE_ENTRIES, "100 entries per node");
+    ASSERT_EQ(s->last_id.ms, 1000 + (N - 1) / 3, "last id");
+
+    struct ostream_iter it;
+    struct ostream_entry e;
+    const struct ostream_id zero = {0, 0};
+    ostreamv_iter_init(&it, v, &zero);
+    int bad = 0;
+    uint32_t n = 0;
+    while (ostreamv_next(&it, &e)) bad += !entry_matches(&e, n++);
+    ASSERT_EQ(n, N, "every entry visited");
+    ASSERT_EQ(bad, 0, "ids, fields and values round-trip");
+
+    int miss = 0;
+    for (uint32_t i = 0; i < N; i += 37) {
+        struct ostream_id id = {1000 + i / 3, i % 3};
+        miss += !(ostreamv_get(v, &id, &e) && entry_matches(&e, i));
+    }
+    ASSERT_EQ(miss, 0, "point lookups by id");
+    struct ostream_id gap = {1000 + 5000 / 3, 7};
+    ASSERT_EQ(ostreamv_get(v, &gap, &e), 0, "absent id");
+    ostreamv_iter_init(&it, v, &gap);
+    ASSERT_TRUE(ostreamv_next(&it, &e) && e.id.ms == gap.ms + 1 && e.id.seq == 0, "seek lands on the next id");
+
+    double per = (double) ostreamv_bytes(v) / N;
+    printf("\n      %.1f bytes/entry for 2 field/value pairs (%u nodes)\n", per, s->nnodes);
+    ASSERT_LT(per, 20, "field names are stored once per node");
+    osv_free(v);
+    TEST_PASS();
+}
+
+// Test 2: MAXLEN / MINID, 精确裁剪会删到节点中间, ~ 只删整个节点
+static void test_stream_trim(void) {
+    TEST_START("XTRIM strategies");
+
+    osv *v = fill(1000);
+    struct ostream *s = ostreamv_s(v);
+    ASSERT_EQ(ostreamv_trim_maxlen(v, 950, 1), 0, "approx keeps a partial node");
+    ASSERT_EQ(ostreamv_trim_maxlen(v, 850, 1), 100, "approx drops one whole node");
+    ASSERT_EQ(ostreamv_trim_maxlen(v, 777, 0), 123, "exact drops a node, then trims inside the next");
+    ASSERT_EQ(s->length, 777, "length after exact trim");
+    struct ostream_iter it;
+    struct ostream_entry e;
+    const struct ostream_id zero = {0, 0};
+    ostreamv_iter_init(&it, v, &zero);
+    ASSERT_TRUE(ostreamv_next(&it, &e) && entry_matches(&e, 223), "oldest entry after trim");
+
+    struct ostream_id minid = {1000 + 500 / 3, 500 % 3};
+    ASSERT_EQ(ostreamv_trim_minid(v, &minid, 0), 500 - 223, "MINID exact");
+    ostreamv_iter_init(&it, v, &zero);
+    ASSERT_TRUE(ostreamv_next(&it, &e) && entry_matches(&e, 500), "first entry is minid");
+    ASSERT_EQ(ostreamv_trim_maxlen(v, 0, 0), 500, "trim everything");
+    ASSERT_EQ(s->nnodes, 0, "no nodes left");
+    ASSERT_EQ(s->last_id.ms, 1000 + 999 / 3, "last id survives trimming");
+
+    struct ostream_str fv[4];
+    char bf[32];
+    struct ostream_id id = {5000, 0};
+    ASSERT_EQ(ostreamv_append(v, &id, fv, make_entry(1, fv, bf)), 0, "append after full trim");
+    ASSERT_EQ(s->length, 1, "one entry");
+    osv_free(v);
+    TEST_PASS();
+}
+
+// Test 3: PEL 追加 / 确认 / 压缩, 二分查找跳过已确认的标记
+static void test_stream_groups(void) {
+    TEST_START("Consumer group pending entries");
+
+    osv *v = fill(10);
+    struct ostream_id z = {0, 0};
+    ASSERT_EQ(ostreamv_group_create(v, "g", 1, &z), 0, "create");
+    ASSERT_EQ(ostreamv_group_create(v, "g", 1, &z), -EEXIST, "duplicate group");
+    struct osgroup *g = ostreamv_group(v, "g", 1);
+    int64_t a = osgroup_consumer(g, "alice", 5, 1), b = osgroup_consumer(g, "bob", 3, 1);
+    ASSERT_EQ(a, 0, "first consumer");
+    ASSERT_EQ(b, 1, "second consumer");
+    ASSERT_EQ(osgroup_consumer(g, "alice", 5, 1), 0, "existing consumer");
+    ASSERT_EQ(osgroup_consumer(g, "carol", 5, 0), -1, "lookup without create");
+
+    enum { P = 1000 };
+    for (uint64_t i = 1; i <= P; i++) osgroup_pel_add(g, &(struct ostream_id) {i, 0}, (uint32_t) (i % 2), i);
+    ASSERT_EQ(g->pending, P, "pending");
+    ASSERT_EQ(g->consumers[0].pending, P / 2, "per consumer");
+    int acked = 0;
+    for (uint64_t i = 1; i <= P; i += 2) acked += osgroup_ack(g, &(struct ostream_id) {i, 0});
+    ASSERT_EQ(acked, P / 2, "ack odd ids");
+    ASSERT_EQ(osgroup_ack(g, &(struct ostream_id) {1, 0}), 0, "double ack");
+    ASSERT_EQ(g->consumers[1].pending, 0, "bob has nothing pending");
+    ASSERT_EQ(g->npel, P, "acks only mark tombstones");
+    ASSERT_NULL(osgroup_pel_find(g, &(struct ostream_id) {3, 0}), "acked id not found");
+    ASSERT_TRUE(osgroup_pel_find(g, &(struct ostream_id) {4, 0}) != NULL, "pending id found");
+    uint64_t k = osgroup_pel_seek(g, &(struct ostream_id) {5, 0});
+    ASSERT_EQ(g->pel[k].id.ms, 6, "seek skips acked ids");
+    for (uint64_t i = 2; i <= 200; i += 2) osgroup_ack(g, &(struct ostream_id) {i, 0});
+    ASSERT_LT(g->npel, P / 2, "compacted once tombstones outnumber pending");
+    ASSERT_TRUE(osgroup_pel_find(g, &(struct ostream_id) {202, 0}) != NULL, "lookup after compaction");
+    for (uint64_t i = 202; i <= P; i += 2) osgroup_ack(g, &(struct ostream_id) {i, 0});
+    ASSERT_EQ(g->pending, 0, "all acked");
+    ASSERT_EQ(g->npel, 0, "PEL emptied");
+
+    ASSERT_EQ(ostreamv_group_destroy(v, "g", 1), 1, "destroy");
+    ASSERT_EQ(ostreamv_group_destroy(v, "g", 1), 0, "destroy again");
+    osv_free(v);
+    TEST_PASS();
+}
+
+static void test_stream_dispatch(void) {
+    TEST_START("X* commands through cmd_dispatch");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *a1[] = {"XADD", "s", "1-1", "f", "a"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, a1), "$3\r\n1-1\r\n"), "XADD explicit id");
+    ASSERT_TRUE(!strncmp(exec(&cn, 5, a1), "-ERR The ID specified in XADD is equal or smaller", 49), "id must grow");
+    const char *a2[] = {"XADD", "s", "1-*", "f", "b"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, a2), "$3\r\n1-2\r\n"), "XADD ms-*");
+    const char *a3[] = {"XADD", "s", "5", "f", "c", "g", "d"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, a3), "$3\r\n5-0\r\n"), "XADD ms");
+    const char *a0[] = {"XADD", "s", "0-0", "f", "x"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 5, a0), "-ERR The ID specified in XADD must be greater than 0-0", 54), "0-0");
+    const char *aodd[] = {"XADD", "s", "*", "f"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, aodd), "-ERR wrong number", 17), "field without value");
+    const char *nomk[] = {"XADD", "nokey", "NOMKSTREAM", "*", "f", "v"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, nomk), "$-1\r\n"), "NOMKSTREAM");
+    const char *bad_new[] = {"XADD", "fresh", "0-0", "f", "x"};
+    exec(&cn, 5, bad_new);
+    ASSERT_NULL(olookup("fresh", 5), "bad id does not create the key");
+    const char *len[] = {"XLEN", "s"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, len), ":3\r\n"), "XLEN");
+
+    const char *range[] = {"XRANGE", "s", "-", "+", "COUNT", "2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, range),
+                        "*2\r\n*2\r\n$3\r\n1-1\r\n*2\r\n$1\r\nf\r\n$1\r\na\r\n"
+                        "*2\r\n$3\r\n1-2\r\n*2\r\n$1\r\nf\r\n$1\r\nb\r\n"), "XRANGE COUNT");
+    const char *range_ex[] = {"XRANGE", "s", "(1-2", "+"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, range_ex),
+                        "*1\r\n*2\r\n$3\r\n5-0\r\n*4\r\n$1\r\nf\r\n$1\r\nc\r\n$1\r\ng\r\n$1\r\nd\r\n"),
+                "exclusive start, different field set");
+    const char *range_ms[] = {"XRANGE", "s", "1", "1"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, range_ms), "*2\r\n", 4), "ms-only bounds cover every seq");
+    const char *range_bad[] = {"XRANGE", "s", "x", "+"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, range_bad), "-ERR Invalid stream ID", 22), "bad id");
+
+    const char *read[] = {"XREAD", "COUNT", "1", "STREAMS", "s", "nokey", "1-1", "0"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, read), "*1\r\n*2\r\n$1\r\ns\r\n*1\r\n*2\r\n$3\r\n1-2\r\n*2\r\n$1\r\nf\r\n$1\r\nb\r\n"),
+                "XREAD after an id, missing key skipped");
+    const char *read_tail[] = {"XREAD", "STREAMS", "s", "$"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, read_tail), "*-1\r\n"), "XREAD $ has nothing new");
+    const char *read_block[] = {"XREAD", "BLOCK", "0", "STREAMS", "s", "$"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 6, read_block), "-ERR BLOCK is not supported", 27), "no blocking reads");
+    const char *read_unbal[] = {"XREAD", "STREAMS", "s", "t", "0"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 5, read_unbal), "-ERR Unbalanced", 15), "unbalanced keys and ids");
+
+    const char *gc[] = {"XGROUP", "CREATE", "s", "g", "0"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, gc), "+OK\r\n"), "XGROUP CREATE");
+    ASSERT_TRUE(!strncmp(exec(&cn, 5, gc), "-BUSYGROUP", 10), "BUSYGROUP");
+    const char *gc_missing[] = {"XGROUP", "CREATE", "q", "g", "$"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 5, gc_missing), "-ERR The XGROUP subcommand requires the key to exist", 52), "no key");
+    const char *gc_mk[] = {"XGROUP", "CREATE", "q", "g", "$", "MKSTREAM"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, gc_mk), "+OK\r\n"), "MKSTREAM");
+    const char *qlen[] = {"XLEN", "q"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, qlen), ":0\r\n"), "empty stream kept");
+
+    const char *rg[] = {"XREADGROUP", "GROUP", "g", "alice", "COUNT", "2", "STREAMS", "s", ">"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 9, rg),
+                        "*1\r\n*2\r\n$1\r\ns\r\n*2\r\n*2\r\n$3\r\n1-1\r\n*2\r\n$1\r\nf\r\n$1\r\na\r\n"
+                        "*2\r\n$3\r\n1-2\r\n*2\r\n$1\r\nf\r\n$1\r\nb\r\n"), "XREADGROUP >");
+    const char *rg_bob[] = {"XREADGROUP", "GROUP", "g", "bob", "STREAMS", "s", ">"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 7, rg_bob), "*1\r\n*2\r\n$1\r\ns\r\n*1\r\n*2\r\n$3\r\n5-0\r\n", 31), "bob gets the rest");
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, rg_bob), "*-1\r\n"), "nothing new");
+    const char *rg_hist[] = {"XREADGROUP", "GROUP", "g", "alice", "STREAMS", "s", "1-1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, rg_hist), "*1\r\n*2\r\n$1\r\ns\r\n*1\r\n*2\r\n$3\r\n1-2\r\n*2\r\n$1\r\nf\r\n$1\r\nb\r\n"),
+                "history after 1-1");
+    const char *rg_nogroup[] = {"XREADGROUP", "GROUP", "nog", "alice", "STREAMS", "s", ">"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 7, rg_nogroup), "-NOGROUP No such key 's' or consumer group 'nog'", 48), "NOGROUP");
+
+    const char *pend[] = {"XPENDING", "s", "g"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, pend),
+                        "*4\r\n:3\r\n$3\r\n1-1\r\n$3\r\n5-0\r\n*2\r\n*2\r\n$5\r\nalice\r\n$1\r\n2\r\n*2\r\n$3\r\nbob\r\n$1\r\n1\r\n"),
+                "XPENDING summary");
+    const char *pend_x[] = {"XPENDING", "s", "g", "-", "+", "10", "alice"};
+    const char *r = exec(&cn, 7, pend_x);
+    ASSERT_TRUE(!strncmp(r, "*2\r\n*4\r\n$3\r\n1-1\r\n$5\r\nalice\r\n:", 29), "XPENDING extended, first entry");
+    ASSERT_TRUE(strstr(r, "$3\r\n1-2\r\n$5\r\nalice\r\n") && strstr(r, ":2\r\n"), "history read counted as a delivery");
+
+    const char *ack[] = {"XACK", "s", "g", "1-1", "1-2", "9-9"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, ack), ":2\r\n"), "XACK");
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, ack), ":0\r\n"), "XACK again");
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, pend), "*4\r\n:1\r\n$3\r\n5-0\r\n$3\r\n5-0\r\n", 26), "one pending left");
+
+    const char *a4[] = {"XADD", "s", "MAXLEN", "=", "2", "6-0", "f", "e"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, a4), "$3\r\n6-0\r\n"), "XADD MAXLEN");
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, len), ":2\r\n"), "trimmed on add");
+    const char *rg_gone[] = {"XREADGROUP", "GROUP", "g", "bob", "STREAMS", "s", "0"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, rg_gone), "*1\r\n*2\r\n$1\r\ns\r\n*1\r\n*2\r\n$3\r\n5-0\r\n*4\r\n"
+                                                 "$1\r\nf\r\n$1\r\nc\r\n$1\r\ng\r\n$1\r\nd\r\n"), "pending entry still there");
+    const char *trim[] = {"XTRIM", "s", "MINID", "6"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, trim), ":1\r\n"), "XTRIM MINID");
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, rg_gone), "*1\r\n*2\r\n$1\r\ns\r\n*1\r\n*2\r\n$3\r\n5-0\r\n$-1\r\n"),
+                "trimmed pending entry has nil fields");
+
+    const char *gd[] = {"XGROUP", "DESTROY", "s", "g"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, gd), ":1\r\n"), "XGROUP DESTROY");
+    const char *set[] = {"SET", "str", "x"};
+    exec(&cn, 3, set);
+    const char *xadd_wt[] = {"XADD", "str", "*", "f", "v"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 5, xadd_wt), "-WRONGTYPE", 10), "XADD on a string");
+    const char *del[] = {"DEL", "s", "q", "str"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, del), ":3\r\n"), "DEL frees nodes and groups");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 5: 1M 次 XADD 经过 cmd_dispatch, 以及 XRANGE 的顺序读
+static void test_stream_benchmark(void) {
+    TEST_START("Append and range throughput");
+
+    enum { N = 1000000 };
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+    char val[16];
+    const char *add[] = {"XADD", "bench", "*", "sensor", "s-1", "value", val};
+    double t0 = get_time_ns();
+    for (int i = 0; i < N; i++) {
+        snprintf(val, sizeof(val), "%d", i);
+        exec(&cn, 7, add);
+    }
+    double add_ns = get_time_ns() - t0;
+    osv *v = olookup("bench", 5)->v;
+    ASSERT_EQ(ostreamv_s(v)->length, N, "all appended");
+
+    struct ostream_iter it;
+    struct ostream_entry e;
+    struct ostream_str f, fv;
+    const struct ostream_id zero = {0, 0};
+    uint64_t bytes = 0, n = 0;
+    t0 = get_time_ns();
+    ostreamv_iter_init(&it, v, &zero);
+    while (ostreamv_next(&it, &e)) {
+        for (uint32_t k = 0; k < e.nfields; k++) {
+            ostream_entry_next(&e, &f, &fv);
+            bytes += fv.len;
+        }
+        n++;
+    }
+    double scan_ns = get_time_ns() - t0;
+    ASSERT_EQ(n, N, "all scanned");
+
+    printf("\n      XADD via dispatch : %.0f ns/entry (%.2f M entries/s)", add_ns / N, N / add_ns * 1e3);
+    printf("\n      sequential scan   : %.1f ns/entry", scan_ns / N);
+    printf("\n      memory            : %.1f bytes/entry\n", (double) ostreamv_bytes(v) / N);
+    ASSERT_LT(add_ns / 1e6, 10000, "appends stay fast");
+
+    const char *del[] = {"DEL", "bench"};
+    exec(&cn, 2, del);
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+void run_cmd_stream_tests(void) {
+    TEST_SUITE_START("CMD Stream Type Tests");
+
+    test_stream_nodes();
+    test_stream_trim();
+    test_stream_groups();
+    test_stream_dispatch();
+    test_stream_benchmark();
+
+    TEST_SUITE_END();
+}
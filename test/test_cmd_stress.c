@@ -186,11 +186,11 @@ static void test_expiration_edge_cases(void) {
 
     char key[64];
     const char *value = "value";
-    time_t now = get_current_time_seconds();
+    uint64_t now = get_current_time_ms();
 
     // Test 1: Expiration at exact current time
     snprintf(key, sizeof(key), "expire_now");
-    int ret = SET4dup(key, strlen(key), value, strlen(value), (uint32_t) now);
+    int ret = SET4dup(key, strlen(key), value, strlen(value), now);
     ASSERT_TRUE(ret >= 0 || ret == FULL, "SET with current time should succeed");
 
     osv *result = GET(key, strlen(key));
@@ -198,15 +198,15 @@ static void test_expiration_edge_cases(void) {
 
     // Test 2: Expiration 1 second in future
     snprintf(key, sizeof(key), "expire_soon");
-    ret = SET4dup(key, strlen(key), value, strlen(value), (uint32_t) (now + 1));
+    ret = SET4dup(key, strlen(key), value, strlen(value), now + 1000);
     ASSERT_TRUE(ret >= 0 || ret == FULL, "SET with future time should succeed");
 
     result = GET(key, strlen(key));
     ASSERT_NOT_NULL(result, "Key with future expiration should exist");
 
-    // Test 3: Maximum expiration time (UINT32_MAX)
+    // Test 3: Maximum expiration time (UINT64_MAX)
     snprintf(key, sizeof(key), "expire_far_future");
-    ret = SET4dup(key, strlen(key), value, strlen(value), UINT32_MAX);
+    ret = SET4dup(key, strlen(key), value, strlen(value), UINT64_MAX);
     ASSERT_TRUE(ret >= 0 || ret == FULL, "SET with max time should succeed");
 
     result = GET(key, strlen(key));
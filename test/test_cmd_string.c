@@ -0,0 +1,162 @@
+//
+// String Range Command Tests for CMD + OHASH
+// Tests: APPEND/SETRANGE/GETRANGE/STRLEN semantics, spare capacity, append cost vs SET4dup
+//
+
+#include "test_cmd_common.h"
+#include <assert.h>
+
+// Test 1: APPEND grows geometrically, most appends do not reallocate
+static void test_append_capacity(void) {
+    TEST_START("APPEND spare capacity");
+
+    uint64_t n;
+    ASSERT_EQ(APPEND("ap", 2, "hello", 5, &n), 0, "APPEND creates the key");
+    ASSERT_EQ(n, 5, "length after create");
+    ASSERT_EQ(GET("ap", 2)->spare, 0, "fresh value has no spare");
+    ASSERT_EQ(APPEND("ap", 2, " world", 6, &n), 0, "APPEND grows");
+    ASSERT_EQ(n, 11, "length after append");
+    osv *v = GET("ap", 2);
+    ASSERT_EQ(v->spare, 11, "doubled to 22 bytes");
+    ASSERT_STR_EQ(v->d, "hello world", 11, "content");
+
+    int reallocs = 0;
+    for (int i = 0; i < 10000; i++) {
+        osv *before = GET("ap", 2);
+        APPEND("ap", 2, "0123456789", 10, &n);
+        if (GET("ap", 2) != before) reallocs++;
+    }
+    ASSERT_EQ(n, 11 + 100000, "final length");
+    ASSERT_LT(reallocs, 20, "reallocations are logarithmic");
+
+    // OSV_INT 先格式化成字符串
+    int64_t c;
+    INCRBY("ai", 2, 42, &c);
+    ASSERT_EQ(APPEND("ai", 2, "x", 1, &n), 0, "APPEND on integer");
+    v = GET("ai", 2);
+    ASSERT_EQ(v->enc, OSV_RAW, "converted to string");
+    ASSERT_STR_EQ(v->d, "42x", 3, "formatted then appended");
+    ASSERT_EQ(INCRBY("ai", 2, 1, &c), -EINVAL, "no longer an integer");
+
+    TEST_PASS();
+}
+
+// Test 2: SETRANGE pads with zeros and reuses spare
+static void test_setrange(void) {
+    TEST_START("SETRANGE padding and overwrite");
+
+    uint64_t n;
+    ASSERT_EQ(SETRANGE("sr", 2, 0, "", 0, &n), 0, "empty SETRANGE on missing key");
+    ASSERT_EQ(n, 0, "length 0");
+    ASSERT_NULL(olookup("sr", 2), "empty SETRANGE does not create");
+    ASSERT_EQ(SETRANGE("sr", 2, 3, "abc", 3, &n), 0, "SETRANGE creates with padding");
+    ASSERT_EQ(n, 6, "offset + len");
+    osv *v = GET("sr", 2);
+    ASSERT_TRUE(!memcmp(v->d, "\0\0\0abc", 6), "zero padded");
+    ASSERT_EQ(SETRANGE("sr", 2, 1, "XY", 2, &n), 0, "overwrite inside");
+    ASSERT_EQ(n, 6, "length unchanged");
+    ASSERT_TRUE(!memcmp(GET("sr", 2)->d, "\0XYabc", 6), "overwritten");
+    ASSERT_EQ(SETRANGE("sr", 2, OSV_MAX_STRLEN, "z", 1, &n), -EFBIG, "too large");
+
+    int64_t c;
+    INCRBY("si", 2, 12345, &c);
+    ASSERT_EQ(SETRANGE("si", 2, 0, "9", 1, &n), 0, "SETRANGE on integer");
+    ASSERT_STR_EQ(GET("si", 2)->d, "92345", 5, "formatted then patched");
+
+    TEST_PASS();
+}
+
+// Test 3: dispatch level replies
+static void test_string_dispatch(void) {
+    TEST_START("APPEND/SETRANGE/GETRANGE/STRLEN through dispatch");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+    assert(cn.write_buffer);
+
+    const char *set[] = {"SET", "gr", "This is a string"};
+    exec(&cn, 3, set);
+    const char *r1[] = {"GETRANGE", "gr", "0", "3"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, r1), "$4\r\nThis\r\n"), "GETRANGE 0 3");
+    const char *r2[] = {"GETRANGE", "gr", "-3", "-1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, r2), "$3\r\ning\r\n"), "GETRANGE -3 -1");
+    const char *r3[] = {"GETRANGE", "gr", "0", "-1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, r3), "$16\r\nThis is a string\r\n"), "GETRANGE 0 -1");
+    const char *r4[] = {"GETRANGE", "gr", "10", "100"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, r4), "$6\r\nstring\r\n"), "end clamped");
+    const char *r5[] = {"GETRANGE", "gr", "5", "3"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, r5), "$0\r\n\r\n"), "empty range");
+    const char *r6[] = {"GETRANGE", "nx", "0", "-1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, r6), "$0\r\n\r\n"), "missing key");
+
+    const char *ap[] = {"APPEND", "gr", "!!"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, ap), ":18\r\n"), "APPEND");
+    const char *sl[] = {"STRLEN", "gr"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, sl), ":18\r\n"), "STRLEN");
+    const char *sr[] = {"SETRANGE", "gr", "0", "that"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, sr), ":18\r\n"), "SETRANGE");
+    const char *get[] = {"GET", "gr"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, get), "$18\r\nthat is a string!!\r\n"), "GET");
+    const char *srneg[] = {"SETRANGE", "gr", "-1", "x"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, srneg), "-ERR offset is out of range\r\n"), "negative offset");
+
+    const char *incr[] = {"INCRBY", "gi", "-1234"};
+    exec(&cn, 3, incr);
+    const char *sli[] = {"STRLEN", "gi"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, sli), ":5\r\n"), "STRLEN of integer");
+    const char *gri[] = {"GETRANGE", "gi", "1", "2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, gri), "$2\r\n12\r\n"), "GETRANGE of integer");
+    const char *slx[] = {"STRLEN", "nx"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, slx), ":0\r\n"), "STRLEN missing");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 4: log accumulation, APPEND vs GET + copy + SET4dup
+static void test_append_benchmark(void) {
+    TEST_START("APPEND vs SET4dup re-copy");
+
+    const int nops = 20000;
+    const char line[] = "2025-11-08 12:00:00 INFO request served in 12ms\n"; // 48 bytes
+    const uint64_t llen = sizeof(line) - 1;
+    uint64_t n = 0;
+
+    double t0 = get_time_ns();
+    for (int i = 0; i < nops; i++) APPEND("log_a", 5, line, llen, &n);
+    double append_ns = (get_time_ns() - t0) / nops;
+    ASSERT_EQ(n, nops * llen, "APPEND log length");
+
+    char *bf = malloc(nops * llen);
+    assert(bf);
+    t0 = get_time_ns();
+    for (int i = 0; i < nops; i++) {
+        osv *v = GET("log_s", 5);
+        uint64_t cur = v ? v->vlen : 0;
+        if (v) memcpy(bf, v->d, cur);
+        memcpy(bf + cur, line, llen);
+        SET4dup("log_s", 5, bf, cur + llen, 0);
+    }
+    double set_ns = (get_time_ns() - t0) / nops;
+    ASSERT_EQ(GET("log_s", 5)->vlen, nops * llen, "emulated log length");
+    free(bf);
+
+    printf("\n      %d appends of %" PRIu64 " bytes (final %.1f MB)\n", nops, llen, nops * llen / 1048576.0);
+    printf("      APPEND       : %.1f ns/op\n", append_ns);
+    printf("      GET+SET4dup  : %.1f ns/op (%.1fx)\n", set_ns, set_ns / append_ns);
+    ASSERT_LT(append_ns * 10, set_ns, "amortized O(1) append should win by an order of magnitude");
+
+    TEST_PASS();
+}
+
+void run_cmd_string_tests(void) {
+    TEST_SUITE_START("CMD String Range Tests");
+
+    test_append_capacity();
+    test_setrange();
+    test_string_dispatch();
+    test_append_benchmark();
+
+    TEST_SUITE_END();
+}
@@ -0,0 +1,197 @@
+//
+// Throttle Command Tests for CMD + OHASH
+// Tests: THROTTLE (GCRA) burst / refill / retry-after, in-place TAT, errors, cost vs GET+INCR+EXPIRE
+//
+
+#include "test_cmd_common.h"
+
+#define NS 1000000000LL
+
+static int64_t now_ns(void) {
+    return (int64_t) oclock_ms() * 1000000;
+}
+
+// Test 1: max_burst + 1 requests pass, then retry_after is one interval
+static void test_throttle_burst(void) {
+    TEST_START("THROTTLE burst then limited");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *th[] = {"THROTTLE", "th:burst", "4", "1", "60"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, th), "*5\r\n:0\r\n:5\r\n:4\r\n:-1\r\n:60\r\n"), "first request");
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, th), "*5\r\n:0\r\n:5\r\n:3\r\n:-1\r\n:120\r\n"), "second request");
+    exec(&cn, 5, th);
+    exec(&cn, 5, th);
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, th), "*5\r\n:0\r\n:5\r\n:0\r\n:-1\r\n:300\r\n"), "last in burst");
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, th), "*5\r\n:1\r\n:5\r\n:0\r\n:60\r\n:300\r\n"), "limited");
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, th), "*5\r\n:1\r\n:5\r\n:0\r\n:60\r\n:300\r\n"), "limited does not consume");
+
+    // key 在桶装满时过期
+    const char *ttl[] = {"TTL", "th:burst"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, ttl), ":300\r\n"), "ttl is reset_after");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 2: refill driven by an explicit clock
+static void test_throttle_refill(void) {
+    TEST_START("THROTTLE refill over time");
+
+    struct othrottle t;
+    int64_t t0 = now_ns();
+    char key[] = "th:refill";
+    uint32_t len = sizeof(key) - 1;
+    for (int i = 0; i < 5; i++) {
+        ASSERT_EQ(THROTTLE(key, len, 4, NS, 1, t0, &t), 0, "burst");
+        ASSERT_EQ(t.limited, 0, "burst allowed");
+        ASSERT_EQ(t.remaining, 4 - i, "remaining");
+    }
+    ASSERT_EQ(THROTTLE(key, len, 4, NS, 1, t0 + NS / 2, &t), 0, "half interval");
+    ASSERT_EQ(t.limited, 1, "still limited");
+    ASSERT_TRUE(t.retry_after == NS / 2, "retry after the rest of the interval");
+
+    ASSERT_EQ(THROTTLE(key, len, 4, NS, 1, t0 + 2 * NS, &t), 0, "two intervals later");
+    ASSERT_EQ(t.limited, 0, "allowed again");
+    ASSERT_EQ(t.remaining, 1, "one more token left");
+    ASSERT_TRUE(t.reset_after == 4 * NS, "reset_after");
+
+    // 两个请求一起 (quantity 2): 只剩一个
+    ASSERT_EQ(THROTTLE(key, len, 4, NS, 2, t0 + 2 * NS, &t), 0, "quantity 2");
+    ASSERT_EQ(t.limited, 1, "not enough for 2");
+    ASSERT_TRUE(t.retry_after == NS, "retry after one interval");
+
+    // quantity 0 只查看
+    ASSERT_EQ(THROTTLE(key, len, 4, NS, 0, t0 + 2 * NS, &t), 0, "peek");
+    ASSERT_EQ(t.limited, 0, "peek allowed");
+    ASSERT_EQ(t.remaining, 1, "peek does not consume");
+
+    // 空闲足够久, 桶满
+    ASSERT_EQ(THROTTLE(key, len, 4, NS, 1, t0 + 100 * NS, &t), 0, "idle");
+    ASSERT_EQ(t.remaining, 4, "full bucket after idle");
+
+    TEST_PASS();
+}
+
+// Test 3: TAT is an OSV_INT updated in place, slot expiry follows it
+static void test_throttle_in_place(void) {
+    TEST_START("THROTTLE state inline, no reallocation");
+
+    struct othrottle t;
+    int64_t t0 = now_ns();
+    char key[] = "th:inline";
+    uint32_t len = sizeof(key) - 1;
+    ASSERT_EQ(THROTTLE(key, len, 100, NS / 100, 1, t0, &t), 0, "create");
+    ohash_t *slot = olookup(key, len);
+    ASSERT_TRUE(slot != NULL, "key created");
+    osv *v = slot->v;
+    ASSERT_EQ(v->enc, OSV_INT, "OSV_INT");
+    ASSERT_TRUE(osv_int(v) == t0 + NS / 100, "TAT");
+    ASSERT_TRUE(slot->expiratime == (uint64_t) (t0 + NS / 100 + 999999) / 1000000, "expires at TAT");
+
+    for (int i = 0; i < 50; i++) THROTTLE(key, len, 100, NS / 100, 1, t0, &t);
+    slot = olookup(key, len);
+    ASSERT_TRUE(slot->v == v, "same osv after updates");
+    ASSERT_TRUE(osv_int(v) == t0 + 51 * (NS / 100), "TAT advanced in place");
+    ASSERT_EQ(t.remaining, 50, "remaining");
+
+    // 不可能满足的 quantity 不创建 key
+    ASSERT_EQ(THROTTLE("th:never", 8, 4, NS, 10, t0, &t), 0, "quantity > burst");
+    ASSERT_EQ(t.limited, 1, "limited");
+    ASSERT_TRUE(t.retry_after == -1, "never allowed");
+    ASSERT_TRUE(olookup("th:never", 8) == NULL, "no key for a rejected first call");
+
+    TEST_PASS();
+}
+
+// Test 4: argument and type errors
+static void test_throttle_errors(void) {
+    TEST_START("THROTTLE errors");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *a1[] = {"THROTTLE", "th:e", "x", "1", "60"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, a1), "-ERR value is not an integer or out of range\r\n"), "bad burst");
+    const char *a2[] = {"THROTTLE", "th:e", "1", "0", "60"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, a2), "-ERR invalid THROTTLE arguments\r\n"), "zero count");
+    const char *a3[] = {"THROTTLE", "th:e", "-1", "1", "60"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, a3), "-ERR invalid THROTTLE arguments\r\n"), "negative burst");
+    const char *a4[] = {"THROTTLE", "th:e", "1", "1", "60", "1", "x"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, a4), "-ERR syntax error\r\n"), "extra argument");
+    const char *a5[] = {"THROTTLE", "th:e", "1", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, a5), "-ERR wrong number of arguments for 'throttle' command\r\n"), "arity");
+    const char *a6[] = {"THROTTLE", "th:e", "4611686018427387903", "1", "9000000000"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, a6), "-ERR THROTTLE arguments would overflow\r\n"), "overflow");
+    ASSERT_TRUE(olookup("th:e", 4) == NULL, "no key on error");
+
+    const char *s1[] = {"SET", "th:s", "abc"};
+    exec(&cn, 3, s1);
+    const char *t1[] = {"THROTTLE", "th:s", "1", "1", "60"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, t1), "-ERR value is not an integer or out of range\r\n"), "string value");
+    const char *s2[] = {"SADD", "th:set", "a"};
+    exec(&cn, 3, s2);
+    const char *t2[] = {"THROTTLE", "th:set", "1", "1", "60"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, t2), "-WRONGTYPE Operation against a key holding the wrong kind of value\r\n"),
+                "wrong type");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 5: THROTTLE vs the GET + INCR + EXPIRE pattern it replaces
+static void test_throttle_perf(void) {
+    TEST_START("THROTTLE vs GET+INCR+EXPIRE");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    enum { KEYS = 1024, ROUNDS = 200 };
+    char keys[KEYS][16];
+    for (int i = 0; i < KEYS; i++) snprintf(keys[i], sizeof(keys[i]), "th:p:%d", i);
+
+    const char *th[] = {"THROTTLE", NULL, "1000000", "1000000", "1"};
+    double t0 = get_time_ns();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < KEYS; i++) {
+            th[1] = keys[i];
+            exec(&cn, 5, th);
+        }
+    double t_th = (get_time_ns() - t0) / (ROUNDS * KEYS);
+    ASSERT_TRUE(!strncmp(exec(&cn, 5, th), "*5\r\n:0\r\n:1000001\r\n", 18), "allowed");
+
+    const char *get[] = {"GET", NULL};
+    const char *incr[] = {"INCR", NULL};
+    const char *exp[] = {"EXPIRE", NULL, "1"};
+    t0 = get_time_ns();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < KEYS; i++) {
+            get[1] = incr[1] = exp[1] = keys[i] + 1;
+            exec(&cn, 2, get);
+            exec(&cn, 2, incr);
+            exec(&cn, 3, exp);
+        }
+    double t_three = (get_time_ns() - t0) / (ROUNDS * KEYS);
+
+    printf("    THROTTLE: %.0f ns/op, GET+INCR+EXPIRE: %.0f ns/op (%.2fx)\n", t_th, t_three, t_three / t_th);
+    ASSERT_TRUE(t_th < 2 * t_three, "one command no slower than three");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+void run_cmd_throttle_tests(void) {
+    TEST_SUITE_START("THROTTLE (GCRA) Tests");
+
+    test_throttle_burst();
+    test_throttle_refill();
+    test_throttle_in_place();
+    test_throttle_errors();
+    test_throttle_perf();
+
+    TEST_SUITE_END();
+}
@@ -0,0 +1,296 @@
+//
+// Tiered Storage Tests for CMD + OTIER
+// Tests: spill/promote correctness, ownership of stubs, Zipfian RAM/disk tier benchmark
+//
+
+#include "test_common_framework.h"
+#include "../include/cmd_.h"
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <unistd.h>
+
+static char tier_path[] = "/tmp/ssw_tier_XXXXXX";
+
+static osv *peek(const char *key) {
+    return oget((char *) key, strlen(key));
+}
+
+static void fill_value(char *buf, size_t len, int i) {
+    for (size_t j = 0; j < len; j++) buf[j] = (char) ('a' + (i + j) % 26);
+}
+
+// Test 1: everything big enough spills, GET promotes back byte-exact
+static void test_spill_and_promote(void) {
+    TEST_START("Spill cold values and promote on GET");
+
+    char key[64], value[256];
+    const int n = 200;
+    for (int i = 0; i < n; i++) {
+        snprintf(key, sizeof(key), "tier_key_%d", i);
+        fill_value(value, sizeof(value), i);
+        int ret = SET4dup(key, strlen(key), value, sizeof(value), 0);
+        ASSERT_TRUE(ret >= 0, "SET should succeed");
+    }
+
+    long long freed = otier_evict(UINT64_MAX);
+    ASSERT_TRUE(freed >= (long long) n * (long long) sizeof(value), "all values should spill");
+
+    for (int i = 0; i < n; i++) {
+        snprintf(key, sizeof(key), "tier_key_%d", i);
+        osv *stub = peek(key);
+        ASSERT_NOT_NULL(stub, "cold key must stay indexed");
+        ASSERT_EQ(stub->enc, OSV_COLD, "value should be cold");
+        ASSERT_EQ(stub->vlen, sizeof(value), "stub keeps the value length");
+    }
+
+    uint64_t disk_before = otier_stats.disk_hits;
+    for (int i = 0; i < n; i++) {
+        snprintf(key, sizeof(key), "tier_key_%d", i);
+        fill_value(value, sizeof(value), i);
+        osv *v = GET(key, strlen(key));
+        ASSERT_NOT_NULL(v, "GET should promote");
+        ASSERT_EQ(v->enc, OSV_RAW, "promoted value is raw");
+        ASSERT_EQ(v->vlen, sizeof(value), "length should match");
+        ASSERT_TRUE(memcmp(v->d, value, sizeof(value)) == 0, "data should match");
+    }
+    ASSERT_EQ(otier_stats.disk_hits - disk_before, n, "each GET should hit disk once");
+
+    TEST_PASS();
+}
+
+// Test 2: small values are never worth a stub
+static void test_small_values_stay(void) {
+    TEST_START("Small values stay resident");
+
+    const char *key = "tier_small";
+    int ret = SET4dup(key, strlen(key), "tiny", 4, 0);
+    ASSERT_TRUE(ret >= 0, "SET should succeed");
+    otier_evict(UINT64_MAX);
+    osv *v = peek(key);
+    ASSERT_NOT_NULL(v, "key should exist");
+    ASSERT_EQ(v->enc, OSV_RAW, "small value must stay in RAM");
+
+    TEST_PASS();
+}
+
+// Test 3: DEL and SET on cold slots free the stub, not the record
+static void test_cold_ownership(void) {
+    TEST_START("DEL / SET over cold values");
+
+    char value[512];
+    fill_value(value, sizeof(value), 7);
+    const char *k1 = "tier_cold_del";
+    const char *k2 = "tier_cold_set";
+    SET4dup(k1, strlen(k1), value, sizeof(value), 0);
+    SET4dup(k2, strlen(k2), value, sizeof(value), 0);
+    otier_evict(UINT64_MAX);
+    ASSERT_EQ(peek(k1)->enc, OSV_COLD, "k1 should be cold");
+    ASSERT_EQ(peek(k2)->enc, OSV_COLD, "k2 should be cold");
+
+    DEL((char *) k1, strlen(k1), free);
+    ASSERT_NULL(GET((char *) k1, strlen(k1)), "deleted cold key is gone");
+
+    int ret = SET4dup(k2, strlen(k2), "fresh", 5, 0);
+    ASSERT_EQ(ret, REPLACED, "SET replaces the stub");
+    osv *v = GET((char *) k2, strlen(k2));
+    ASSERT_NOT_NULL(v, "new value readable");
+    ASSERT_STR_EQ(v->d, "fresh", 5, "new value wins over the disk record");
+
+    TEST_PASS();
+}
+
+// Test 4: referenced values get a second chance
+static void test_clock_second_chance(void) {
+    TEST_START("CLOCK keeps recently read values");
+
+    char key[64], value[128];
+    const int n = 64;
+    for (int i = 0; i < n; i++) {
+        snprintf(key, sizeof(key), "tier_clock_%d", i);
+        fill_value(value, sizeof(value), i);
+        SET4dup(key, strlen(key), value, sizeof(value), 0);
+    }
+    // 全部下沉再全部读回: 现在每个值都是 ref=1
+    otier_evict(UINT64_MAX);
+    for (int i = 0; i < n; i++) {
+        snprintf(key, sizeof(key), "tier_clock_%d", i);
+        GET(key, strlen(key));
+    }
+    // one lap clears ref bits without spilling anything of ours, then read half again
+    otier_evict(1);
+    for (int i = 0; i < n; i += 2) {
+        snprintf(key, sizeof(key), "tier_clock_%d", i);
+        GET(key, strlen(key));
+    }
+    // odd values are the only unreferenced ones: spilling half the set should take them first
+    otier_evict((uint64_t) (n / 2) * sizeof(value));
+    int hot_resident = 0;
+    for (int i = 0; i < n; i++) {
+        snprintf(key, sizeof(key), "tier_clock_%d", i);
+        osv *v = peek(key);
+        if (i % 2 == 0 && v->enc == OSV_RAW) hot_resident++;
+        if (i % 2) ASSERT_EQ(v->enc, OSV_COLD, "unreferenced value should spill first");
+    }
+    ASSERT_GT(hot_resident, 0, "some recently read values should still be resident");
+
+    TEST_PASS();
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+static inline uint64_t bench_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Test 5: Zipfian workload with RAM budget at 10% of the data set
+static void test_zipf_tier_benchmark(void) {
+    TEST_START("Zipfian workload, RAM tier vs disk tier");
+
+    const int nkeys = 20000;
+    const int vsize = 1024;
+    const int nops = 200000;
+    const int budget = nkeys / 10; // values kept resident
+    const double theta = 0.99;
+
+    char key[64];
+    char *value = malloc(vsize);
+    double *cdf = malloc(sizeof(double) * nkeys);
+    uint32_t *ram_lat = malloc(sizeof(uint32_t) * nops);
+    uint32_t *disk_lat = malloc(sizeof(uint32_t) * nops);
+    assert(value && cdf && ram_lat && disk_lat);
+
+    for (int i = 0; i < nkeys; i++) {
+        snprintf(key, sizeof(key), "zipf_%d", i);
+        fill_value(value, vsize, i);
+        int ret = SET4dup(key, strlen(key), value, vsize, 0);
+        ASSERT_TRUE(ret >= 0, "SET should succeed");
+    }
+
+    double sum = 0;
+    for (int i = 0; i < nkeys; i++) sum += 1.0 / pow(i + 1, theta);
+    double acc = 0;
+    for (int i = 0; i < nkeys; i++) {
+        acc += 1.0 / pow(i + 1, theta) / sum;
+        cdf[i] = acc;
+    }
+
+    uint64_t base_spilled = otier_stats.spilled, base_hits = otier_stats.disk_hits;
+    int64_t resident = nkeys;
+    otier_evict((uint64_t) (resident - budget) * vsize);
+
+    srand(42);
+    int nram = 0, ndisk = 0;
+    for (int op = 0; op < nops; op++) {
+        double u = (double) rand() / RAND_MAX;
+        int lo = 0, hi = nkeys - 1;
+        while (lo < hi) {
+            int mid = (lo + hi) >> 1;
+            if (cdf[mid] < u) lo = mid + 1;
+            else hi = mid;
+        }
+        // scatter ranks over the key space so hot keys are not adjacent slots
+        snprintf(key, sizeof(key), "zipf_%d", (int) ((lo * 7919ULL) % nkeys));
+
+        uint64_t hits = otier_stats.disk_hits;
+        uint64_t t0 = bench_ns();
+        osv *v = GET(key, strlen(key));
+        uint32_t dt = (uint32_t) (bench_ns() - t0);
+        if (!v) {
+            free(value);
+            free(cdf);
+            free(ram_lat);
+            free(disk_lat);
+            TEST_FAIL("GET should find every key");
+        }
+        if (otier_stats.disk_hits != hits) disk_lat[ndisk++] = dt;
+        else ram_lat[nram++] = dt;
+
+        if ((op & 1023) == 1023) {
+            resident = nkeys - (int64_t) (otier_stats.spilled - base_spilled)
+                       + (int64_t) (otier_stats.disk_hits - base_hits);
+            if (resident > budget) otier_evict((uint64_t) (resident - budget) * vsize);
+        }
+    }
+
+    qsort(ram_lat, nram, sizeof(uint32_t), cmp_u32);
+    qsort(disk_lat, ndisk, sizeof(uint32_t), cmp_u32);
+    double ram_avg = 0, disk_avg = 0;
+    for (int i = 0; i < nram; i++) ram_avg += ram_lat[i];
+    for (int i = 0; i < ndisk; i++) disk_avg += disk_lat[i];
+    ram_avg = nram ? ram_avg / nram : 0;
+    disk_avg = ndisk ? disk_avg / ndisk : 0;
+
+    printf("\n      Keys: %d x %d B, RAM budget: %d values, theta=%.2f\n", nkeys, vsize, budget, theta);
+    printf("      RAM tier : %d hits (%.2f%%), avg %.0f ns, p99 %u ns\n",
+           nram, nram * 100.0 / nops, ram_avg, nram ? ram_lat[(int) (nram * 0.99)] : 0);
+    printf("      Disk tier: %d hits (%.2f%%), avg %.0f ns, p99 %u ns\n",
+           ndisk, ndisk * 100.0 / nops, disk_avg, ndisk ? disk_lat[(int) (ndisk * 0.99)] : 0);
+    printf("      File: %" PRIu64 " B written, %" PRIu64 " B dead\n",
+           otier_stats.file_bytes, otier_stats.dead_bytes);
+
+    free(value);
+    free(cdf);
+    free(ram_lat);
+    free(disk_lat);
+
+    ASSERT_GT(nram, ndisk, "Zipfian hot set should mostly hit the RAM tier");
+    TEST_PASS();
+}
+
+// Test 6: in-place string updates promote cold values first, STRLEN does no IO
+static void test_cold_append(void) {
+    TEST_START("APPEND/SETRANGE on cold values");
+
+    char value[128];
+    fill_value(value, sizeof(value), 7);
+    SET4dup("tier_ap", 7, value, sizeof(value), 0);
+    otier_evict(UINT64_MAX);
+    ASSERT_EQ(peek("tier_ap")->enc, OSV_COLD, "value should be cold");
+    uint64_t hits = otier_stats.disk_hits;
+
+    uint64_t n;
+    ASSERT_EQ(APPEND("tier_ap", 7, "tail", 4, &n), 0, "APPEND on cold value");
+    ASSERT_EQ(n, sizeof(value) + 4, "length includes the spilled bytes");
+    osv *v = peek("tier_ap");
+    ASSERT_EQ(v->enc, OSV_RAW, "promoted");
+    ASSERT_EQ(otier_stats.disk_hits, hits + 1, "one promote");
+    ASSERT_TRUE(!memcmp(v->d, value, sizeof(value)) && !memcmp(v->d + sizeof(value), "tail", 4),
+                "spilled bytes + appended tail");
+
+    otier_evict(UINT64_MAX);
+    otier_evict(UINT64_MAX); // APPEND set ref, the second sweep spills it
+    ASSERT_EQ(peek("tier_ap")->enc, OSV_COLD, "cold again");
+    ASSERT_EQ(SETRANGE("tier_ap", 7, 0, "HEAD", 4, &n), 0, "SETRANGE on cold value");
+    v = peek("tier_ap");
+    ASSERT_TRUE(!memcmp(v->d, "HEAD", 4) && !memcmp(v->d + 4, value + 4, sizeof(value) - 4), "patched in place");
+
+    TEST_PASS();
+}
+
+void run_cmd_tier_tests(void) {
+    TEST_SUITE_START("CMD + OTIER Tiered Storage Tests");
+
+    int fd = mkstemp(tier_path);
+    assert(fd >= 0 && "mkstemp failed");
+    close(fd);
+    int ret = otier_open(tier_path);
+    assert(ret == OK && "otier_open failed");
+
+    test_spill_and_promote();
+    test_small_values_stay();
+    test_cold_ownership();
+    test_clock_second_chance();
+    test_zipf_tier_benchmark();
+    test_cold_append();
+
+    otier_close();
+    unlink(tier_path);
+
+    TEST_SUITE_END();
+}
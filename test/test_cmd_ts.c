@@ -0,0 +1,278 @@
+//
+// Time Series Type Tests for CMD + OHASH
+// Tests: Gorilla round-trip, bytes per sample, bucket aggregation and retention, TS.* commands, range decode throughput
+//
+
+#include "test_cmd_common.h"
+
+static int same_bits(double a, double b) {
+    return !memcmp(&a, &b, sizeof(double));
+}
+
+// Test 1: 不规则的时间戳 / 任意位模式的值 (NaN, inf, -0), 跨多个 chunk 解码后逐位相同
+static void test_ts_roundtrip(void) {
+    TEST_START("Gorilla chunks round-trip exactly");
+
+    enum { N = 20000 };
+    int64_t *ts = malloc(sizeof(int64_t) * N);
+    double *vs = malloc(sizeof(double) * N);
+    osv *v = otsv_new(0, OTS_CHUNK_SIZE_MIN * 4);
+    int64_t t = 1700000000000LL;
+    for (int i = 0; i < N; i++) {
+        uint64_t r = test_rand64();
+        switch (r % 8) {
+            case 0: t += 1000; break; // dod == 0 或很小
+            case 1: t += 1000 + (int64_t) (r >> 40) % 100; break;
+            case 2: t += (int64_t) (r >> 40) % 5000 + 1; break;
+            case 3: t += (int64_t) (r >> 20) + 1; break; // 64 位的 dod
+            default: t += 1000; break;
+        }
+        ts[i] = t;
+        switch ((r >> 8) % 8) {
+            case 0: vs[i] = i ? vs[i - 1] : 0; break;
+            case 1: vs[i] = (double) (r >> 44); break;
+            case 2: memcpy(&vs[i], &r, sizeof(double)); break; // 任意位模式, 包括 NaN
+            case 3: vs[i] = (r & 0x100000) ? INFINITY : -0.0; break;
+            default: vs[i] = 20.0 + (double) (int64_t) (r % 200) / 10; break;
+        }
+        ASSERT_EQ(otsv_add(v, ts[i], vs[i]), 0, "append");
+    }
+    struct ots *s = otsv_ts(v);
+    ASSERT_EQ(s->total, N, "sample count");
+    ASSERT_GT(s->nchunks, 10, "spans many chunks");
+    ASSERT_EQ(otsv_add(v, t, 1), -EEXIST, "same timestamp");
+    ASSERT_EQ(otsv_add(v, t - 1, 1), -ERANGE, "older timestamp");
+
+    struct ots_iter it;
+    struct ots_sample smp;
+    int bad = 0, n = 0;
+    otsv_iter_init(&it, v, 0);
+    while (ots_iter_next(&it, &smp)) {
+        if (n >= N || smp.ts != ts[n] || !same_bits(smp.v, vs[n])) bad++;
+        n++;
+    }
+    ASSERT_EQ(n, N, "every sample decoded");
+    ASSERT_EQ(bad, 0, "timestamps and value bits match");
+
+    // 从中间开始: 二分到 chunk, 再顺序跳过前面的样本
+    struct ots_sample *out;
+    int64_t m = otsv_range(v, ts[N / 2], ts[N / 2 + 99], OTS_AGG_NONE, 0, 0, &out);
+    ASSERT_EQ(m, 100, "range from the middle");
+    ASSERT_EQ(out[0].ts, ts[N / 2], "first sample of the range");
+    ASSERT_TRUE(same_bits(out[99].v, vs[N / 2 + 99]), "last sample of the range");
+    free(out);
+    m = otsv_range(v, ts[10], INT64_MAX, OTS_AGG_NONE, 0, 5, &out);
+    ASSERT_EQ(m, 5, "COUNT limit");
+    free(out);
+
+    free(ts);
+    free(vs);
+    osv_free(v);
+    TEST_PASS();
+}
+
+// Test 2: 等间隔采样 (带少量抖动) 的计数器 / 量表, 每个样本的字节数
+static void test_ts_compression(void) {
+    TEST_START("Bytes per sample for regular metrics");
+
+    enum { N = 1000000 };
+    osv *counter = otsv_new_default(), *gauge = otsv_new_default(), *decimal = otsv_new_default();
+    int64_t t = 1700000000000LL;
+    double c = 0, g = 50, d = 20;
+    for (int i = 0; i < N; i++) {
+        uint64_t r = test_rand64();
+        t += 10000 + ((r & 0xff) == 0 ? (int64_t) (r >> 8) % 3 - 1 : 0);
+        c += (double) (r >> 60);
+        g += (double) ((int64_t) ((r >> 32) % 5) - 2);
+        d = (double) (int64_t) (d * 10 + (int64_t) ((r >> 24) % 3) - 1) / 10;
+        otsv_add(counter, t, c);
+        otsv_add(gauge, t, g);
+        otsv_add(decimal, t, d);
+    }
+    double bc = (double) otsv_bytes(counter) / N, bg = (double) otsv_bytes(gauge) / N;
+    double bd = (double) otsv_bytes(decimal) / N;
+    printf("\n      counter : %.2f bytes/sample", bc);
+    printf("\n      gauge   : %.2f bytes/sample", bg);
+    printf("\n      decimal : %.2f bytes/sample (one-decimal random walk, xor of non-integers)\n", bd);
+    ASSERT_TRUE(bc < 3, "counter compresses to a couple of bytes");
+    ASSERT_TRUE(bg < 3, "gauge compresses to a couple of bytes");
+    ASSERT_TRUE(bd < 8, "decimals still beat 16 raw bytes");
+
+    osv_free(counter);
+    osv_free(gauge);
+    osv_free(decimal);
+    TEST_PASS();
+}
+
+// Test 3: 分桶聚合与逐个样本计算的结果相同; retention 丢弃整个 chunk
+static void test_ts_aggregation(void) {
+    TEST_START("Bucket aggregation and retention");
+
+    enum { N = 10000, BUCKET = 60000 };
+    osv *v = otsv_new_default();
+    static int64_t ts[N];
+    static double vs[N];
+    int64_t t = 0;
+    for (int i = 0; i < N; i++) {
+        t += 1000 + (int64_t) (test_rand64() % 5000);
+        ts[i] = t;
+        vs[i] = (double) (int64_t) (test_rand64() % 1000) - 500;
+        otsv_add(v, ts[i], vs[i]);
+    }
+    int64_t from = ts[100], to = ts[N - 100];
+    static const int aggs[] = {OTS_AGG_AVG, OTS_AGG_SUM, OTS_AGG_MIN, OTS_AGG_MAX, OTS_AGG_COUNT};
+    for (int a = 0; a < 5; a++) {
+        struct ots_sample *out;
+        int64_t n = otsv_range(v, from, to, aggs[a], BUCKET, 0, &out);
+        int64_t k = 0, bad = 0, i = 100;
+        while (i <= N - 100) {
+            int64_t start = ts[i] - ts[i] % BUCKET;
+            double sum = 0, mn = vs[i], mx = vs[i];
+            int cnt = 0;
+            for (; i <= N - 100 && ts[i] - ts[i] % BUCKET == start; i++, cnt++) {
+                sum += vs[i];
+                if (vs[i] < mn) mn = vs[i];
+                if (vs[i] > mx) mx = vs[i];
+            }
+            double want = aggs[a] == OTS_AGG_AVG ? sum / cnt : aggs[a] == OTS_AGG_SUM ? sum
+                        : aggs[a] == OTS_AGG_MIN ? mn : aggs[a] == OTS_AGG_MAX ? mx : cnt;
+            if (k >= n || out[k].ts != start || out[k].v != want) bad++;
+            k++;
+        }
+        ASSERT_EQ(n, k, "one result per bucket");
+        ASSERT_EQ(bad, 0, "bucket values match the brute force");
+        free(out);
+    }
+    osv_free(v);
+
+    osv *r = otsv_new(100000, OTS_CHUNK_SIZE_MIN);
+    for (int64_t i = 0; i < 10000; i++) otsv_add(r, i * 1000, (double) i);
+    struct ots *s = otsv_ts(r);
+    ASSERT_LT(s->total, 300, "old chunks dropped");
+    ASSERT_GT(s->total, 100, "retention window kept");
+    ASSERT_TRUE(s->chunks[0]->last_ts >= 9999000 - 100000, "first chunk reaches into the window");
+    osv_free(r);
+    TEST_PASS();
+}
+
+static void test_ts_dispatch(void) {
+    TEST_START("TS.* commands through cmd_dispatch");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *create[] = {"TS.CREATE", "t1", "RETENTION", "0", "CHUNK_SIZE", "128"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, create), "+OK\r\n"), "TS.CREATE");
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, create), "-ERR TSDB: key already exists\r\n"), "existing key");
+    ASSERT_EQ(otsv_ts((osv *) olookup("t1", 2)->v)->chunk_size, 128, "CHUNK_SIZE");
+    const char *bad_chunk[] = {"TS.CREATE", "x", "CHUNK_SIZE", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, bad_chunk), "-ERR TSDB: invalid CHUNK_SIZE value\r\n"), "chunk size range");
+
+    const char *a1[] = {"TS.ADD", "t1", "1000", "1.5"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, a1), ":1000\r\n"), "TS.ADD");
+    const char *a2[] = {"TS.ADD", "t1", "2000", "2.5"};
+    exec(&cn, 4, a2);
+    const char *a3[] = {"TS.ADD", "t1", "61000", "-4"};
+    exec(&cn, 4, a3);
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, a3), "-ERR TSDB: duplicate sample for the last timestamp\r\n"), "duplicate");
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, a1), "-ERR TSDB: timestamp is older than the last sample\r\n"), "older");
+    const char *bad_val[] = {"TS.ADD", "t1", "70000", "abc"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, bad_val), "-ERR TSDB: invalid value\r\n"), "bad value");
+    const char *now[] = {"TS.ADD", "t2", "*", "7", "RETENTION", "3600000"};
+    ASSERT_TRUE(exec(&cn, 6, now)[0] == ':', "TS.ADD * auto-creates");
+    ASSERT_EQ(otsv_ts((osv *) olookup("t2", 2)->v)->retention, 3600000, "RETENTION on auto-create");
+
+    const char *get[] = {"TS.GET", "t1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, get), "*2\r\n:61000\r\n+-4\r\n"), "TS.GET");
+    const char *range[] = {"TS.RANGE", "t1", "-", "+"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, range),
+                        "*3\r\n*2\r\n:1000\r\n+1.5\r\n*2\r\n:2000\r\n+2.5\r\n*2\r\n:61000\r\n+-4\r\n"), "TS.RANGE");
+    const char *range_cnt[] = {"TS.RANGE", "t1", "1500", "+", "COUNT", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, range_cnt), "*1\r\n*2\r\n:2000\r\n+2.5\r\n"), "TS.RANGE COUNT");
+    const char *range_avg[] = {"TS.RANGE", "t1", "-", "+", "AGGREGATION", "avg", "60000"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, range_avg), "*2\r\n*2\r\n:0\r\n+2\r\n*2\r\n:60000\r\n+-4\r\n"), "avg buckets");
+    const char *range_bad[] = {"TS.RANGE", "t1", "-", "+", "AGGREGATION", "median", "10"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, range_bad), "-ERR TSDB: unknown aggregation type\r\n"), "bad aggregation");
+    const char *range_miss[] = {"TS.RANGE", "nokey", "-", "+"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, range_miss), "-ERR TSDB: the key does not exist\r\n"), "missing series");
+
+    const char *mrange[] = {"TS.MRANGE", "-", "+", "AGGREGATION", "max", "100000", "KEYS", "t1", "nokey"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 9, mrange), "*1\r\n*3\r\n$2\r\nt1\r\n*0\r\n*1\r\n*2\r\n:0\r\n+2.5\r\n"),
+                "TS.MRANGE skips missing keys");
+    const char *mrange_nokeys[] = {"TS.MRANGE", "-", "+", "COUNT", "2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, mrange_nokeys), "-ERR syntax error\r\n"), "missing KEYS");
+
+    const char *set[] = {"SET", "str", "x"};
+    exec(&cn, 3, set);
+    const char *add_wt[] = {"TS.ADD", "str", "1", "1"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, add_wt), "-WRONGTYPE", 10), "TS.ADD on a string");
+    const char *mrange_wt[] = {"TS.MRANGE", "-", "+", "KEYS", "t1", "str"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 6, mrange_wt), "-WRONGTYPE", 10), "TS.MRANGE on a string");
+
+    const char *del[] = {"DEL", "t1", "t2", "str"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, del), ":3\r\n"), "DEL frees chunks");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 5: 顺序解码 chunk 的吞吐, 对比逐个 key 存 16 字节样本的开销
+static void test_ts_benchmark(void) {
+    TEST_START("Range decode throughput");
+
+    enum { N = 2000000 };
+    osv *v = otsv_new_default();
+    int64_t t = 1700000000000LL;
+    double g = 100;
+    double t0 = get_time_ns();
+    for (int i = 0; i < N; i++) {
+        t += 1000;
+        g += (double) ((int64_t) (test_rand64() % 3) - 1);
+        otsv_add(v, t, g);
+    }
+    double add_ns = get_time_ns() - t0;
+
+    struct ots_iter it;
+    struct ots_sample smp;
+    double sum = 0;
+    int n = 0;
+    t0 = get_time_ns();
+    otsv_iter_init(&it, v, 0);
+    while (ots_iter_next(&it, &smp)) {
+        sum += smp.v;
+        n++;
+    }
+    double decode_ns = get_time_ns() - t0;
+    ASSERT_EQ(n, N, "all samples decoded");
+
+    struct ots_sample *out;
+    t0 = get_time_ns();
+    int64_t m = otsv_range(v, 0, INT64_MAX, OTS_AGG_AVG, 3600000, 0, &out);
+    double agg_ns = get_time_ns() - t0;
+    int64_t first = 1700000000000LL + 1000, hours = t / 3600000 - first / 3600000 + 1;
+    ASSERT_EQ(m, hours, "hourly buckets");
+    free(out);
+
+    printf("\n      %.2f bytes/sample, %u chunks (sum %.0f)", (double) otsv_bytes(v) / N, otsv_ts(v)->nchunks, sum);
+    printf("\n      append          : %.1f ns/sample", add_ns / N);
+    printf("\n      sequential read : %.1f ns/sample", decode_ns / N);
+    printf("\n      hourly avg      : %.1f ns/sample\n", agg_ns / N);
+    ASSERT_LT(decode_ns / 1e6, 5000, "decoding stays fast");
+
+    osv_free(v);
+    TEST_PASS();
+}
+
+void run_cmd_ts_tests(void) {
+    TEST_SUITE_START("CMD Time Series Type Tests");
+    test_rand_seed(0x243f6a8885a308d3ULL);
+
+    test_ts_roundtrip();
+    test_ts_compression();
+    test_ts_aggregation();
+    test_ts_dispatch();
+    test_ts_benchmark();
+
+    TEST_SUITE_END();
+}
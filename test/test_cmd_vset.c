@@ -0,0 +1,268 @@
+//
+// Vector Set Command Tests for CMD + OHASH
+// Tests: exact scan vs scalar reference, int8 quantization error, HNSW recall, VADD / VSIM / VCARD / VDIM, latency
+//
+
+#include "test_cmd_common.h"
+#include "../include/osv_vset.h"
+#include <math.h>
+
+static float frand(void) {
+    return (float) ((double) (test_rand64() >> 11) / (double) (1ULL << 53)) * 2 - 1;
+}
+
+/** 参考距离: double 精度, 与 struct ovhit 的定义一致 */
+static double ref_dist(const float *a, const float *b, uint32_t dim, int metric) {
+    double dot = 0, na = 0, nb = 0, l2 = 0;
+    for (uint32_t i = 0; i < dim; i++) {
+        dot += (double) a[i] * b[i];
+        na += (double) a[i] * a[i];
+        nb += (double) b[i] * b[i];
+        l2 += ((double) a[i] - b[i]) * ((double) a[i] - b[i]);
+    }
+    return metric == OVSET_COSINE ? 1 - dot / sqrt(na * nb) : l2;
+}
+
+static osv *fill(uint32_t n, uint32_t dim, int metric, int quant, uint32_t m, uint32_t ef, float *data) {
+    osv *v = ovsetv_new(dim, metric, quant, m, ef);
+    for (uint32_t i = 0; i < n; i++) {
+        char name[16];
+        for (uint32_t j = 0; j < dim; j++) data[(uint64_t) i * dim + j] = frand();
+        int len = snprintf(name, sizeof(name), "e%u", i);
+        ovsetv_add(v, name, (uint32_t) len, data + (uint64_t) i * dim);
+    }
+    return v;
+}
+
+// Test 1: 精确扫描 (SIMD 内核) 与 double 参考实现逐个比较, 包括不是 8 的倍数的维数
+static void test_vset_exact(void) {
+    TEST_START("exact scan vs scalar reference");
+
+    static const uint32_t dims[] = {3, 8, 37, 128, 300};
+    enum { N = 500, K = 10 };
+    int same = 1;
+    for (int metric = 0; metric < 2; metric++) {
+        for (size_t d = 0; d < sizeof(dims) / sizeof(dims[0]); d++) {
+            uint32_t dim = dims[d];
+            float *data = malloc((size_t) N * dim * sizeof(float)), *q = malloc(dim * sizeof(float));
+            osv *v = fill(N, dim, metric, OVSET_F32, 16, 100, data);
+            for (uint32_t j = 0; j < dim; j++) q[j] = frand();
+            struct ovhit out[K];
+            uint32_t n = ovsetv_search(v, q, 0, K, 0, 1, out);
+            if (n != K) same = 0;
+            // 第 k 近的参考距离
+            double ref[N];
+            for (int i = 0; i < N; i++) ref[i] = ref_dist(q, data + (size_t) i * dim, dim, metric);
+            for (uint32_t k = 0; k < n; k++) {
+                double d0 = ref[out[k].id];
+                int closer = 0;
+                for (int i = 0; i < N; i++) closer += ref[i] < d0 - 1e-4;
+                if (closer > (int) k || fabs(out[k].dist - d0) > 1e-3 * (1 + d0)) same = 0;
+                if (k && out[k].dist < out[k - 1].dist) same = 0;
+            }
+            osv_free(v);
+            free(data);
+            free(q);
+        }
+    }
+    ASSERT_TRUE(same, "top-10 ids and distances match");
+
+    TEST_PASS();
+}
+
+// Test 2: Q8 的距离误差, 以及内存只有 F32 的 1/4
+static void test_vset_q8(void) {
+    TEST_START("int8 quantization");
+
+    enum { N = 300, DIM = 128 };
+    float *data = malloc((size_t) N * DIM * sizeof(float)), q[DIM];
+    for (int metric = 0; metric < 2; metric++) {
+        osv *v = fill(N, DIM, metric, OVSET_Q8, 16, 100, data);
+        for (int j = 0; j < DIM; j++) q[j] = frand();
+        struct ovhit out[N];
+        uint32_t n = ovsetv_search(v, q, 0, N, 0, 1, out);
+        double worst = 0, scale = metric == OVSET_COSINE ? 1 : 2.0 * DIM / 3;
+        for (uint32_t k = 0; k < n; k++)
+            worst = fmax(worst, fabs(out[k].dist - ref_dist(q, data + (size_t) out[k].id * DIM, DIM, metric)) / scale);
+        printf("    %s: worst relative distance error %.4f\n", metric == OVSET_COSINE ? "COSINE" : "L2", worst);
+        ASSERT_TRUE(n == N && worst < 0.02, "quantized distance within 2%");
+        if (metric == OVSET_L2) {
+            osv *f = ovsetv_new(DIM, OVSET_L2, OVSET_F32, 16, 100);
+            for (uint32_t i = 0; i < N; i++) ovsetv_add(f, (const char *) &i, sizeof(i), data + (size_t) i * DIM);
+            printf("    %d x %d: F32 %llu bytes, Q8 %llu bytes\n", N, DIM,
+                   (unsigned long long) ovsetv_bytes(f), (unsigned long long) ovsetv_bytes(v));
+            ASSERT_TRUE(ovsetv_bytes(v) * 2 < ovsetv_bytes(f), "Q8 is much smaller");
+            osv_free(f);
+        }
+        osv_free(v);
+    }
+    free(data);
+
+    TEST_PASS();
+}
+
+/**
+ * 类似 embedding 的数据: LATENT 维的隐变量经过随机线性映射再加一点噪声
+ * (均匀随机的高维向量彼此几乎等距, 任何近似索引在上面都没有意义)
+ */
+enum { LATENT = 8 };
+
+static void embed(const float *proj, uint32_t dim, float *x) {
+    float z[LATENT];
+    for (int j = 0; j < LATENT; j++) z[j] = frand();
+    for (uint32_t i = 0; i < dim; i++) {
+        x[i] = 0.05f * frand();
+        for (int j = 0; j < LATENT; j++) x[i] += proj[i * LATENT + j] * z[j];
+    }
+}
+
+// Test 3: HNSW 的 recall@10, 以及与精确扫描的查询时间对比
+static void test_vset_hnsw(void) {
+    TEST_START("HNSW recall and latency");
+
+    enum { N = 8000, DIM = 64, K = 10, Q = 200 };
+    static float proj[DIM * LATENT], x[DIM];
+    for (int i = 0; i < DIM * LATENT; i++) proj[i] = frand();
+    osv *v = ovsetv_new(DIM, OVSET_COSINE, OVSET_F32, 16, 100);
+    double t0 = get_time_ns();
+    for (uint32_t i = 0; i < N; i++) {
+        char name[16];
+        embed(proj, DIM, x);
+        ovsetv_add(v, name, (uint32_t) snprintf(name, sizeof(name), "e%u", i), x);
+    }
+    double build = get_time_ns() - t0;
+    ASSERT_TRUE(ovsetv_s(v)->links0 != NULL, "graph built past OVSET_FLAT_MAX");
+
+    static float qs[Q][DIM];
+    for (int i = 0; i < Q; i++) embed(proj, DIM, qs[i]);
+    static struct ovhit truth[Q][K];
+    struct ovhit out[K];
+    t0 = get_time_ns();
+    for (int i = 0; i < Q; i++) ovsetv_search(v, qs[i], 0, K, 0, 1, truth[i]);
+    double t_flat = (get_time_ns() - t0) / Q;
+    uint32_t hit = 0;
+    t0 = get_time_ns();
+    for (int i = 0; i < Q; i++) {
+        uint32_t n = ovsetv_search(v, qs[i], 0, K, 100, 0, out);
+        for (uint32_t a = 0; a < n; a++)
+            for (int b = 0; b < K; b++) hit += out[a].id == truth[i][b].id;
+    }
+    double t_hnsw = (get_time_ns() - t0) / Q;
+    double recall = (double) hit / (Q * K);
+    printf("    %d x %d: build %.0f ms, recall@10 %.3f (ef 100), HNSW %.1f us/query, exact %.1f us/query\n",
+           N, DIM, build / 1e6, recall, t_hnsw / 1e3, t_flat / 1e3);
+    ASSERT_TRUE(recall > 0.9, "recall@10 > 0.9");
+    ASSERT_TRUE(t_hnsw < t_flat, "HNSW faster than a full scan");
+
+    // 元素自己的向量查询: 第一个结果就是自己
+    int self = 1;
+    for (uint32_t i = 0; i < 50; i++) {
+        uint32_t id = i * 397 % N;
+        ovsetv_search(v, NULL, id, 1, 50, 0, out);
+        self &= out[0].id == id;
+    }
+    ASSERT_TRUE(self, "query by element finds itself");
+
+    osv_free(v);
+    TEST_PASS();
+}
+
+// Test 4: 命令
+static void test_vset_commands(void) {
+    TEST_START("VADD / VSIM / VCARD / VDIM");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *a1[] = {"VADD", "pts", "VALUES", "3", "1", "0", "0", "x"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, a1), ":1\r\n"), "VADD new");
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, a1), ":0\r\n"), "VADD existing");
+    const char *a2[] = {"VADD", "pts", "VALUES", "3", "0", "1", "0", "y"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, a2), ":1\r\n"), "VADD y");
+    float z[3] = {0.6f, 0.8f, 0};
+    const char *a3[] = {"VADD", "pts", "FP32", (const char *) z, "z"};
+    const int l3[] = {-1, -1, -1, sizeof(z), -1};
+    ASSERT_TRUE(!strcmp(exec_n(&cn, 5, a3, l3), ":1\r\n"), "VADD FP32");
+
+    const char *card[] = {"VCARD", "pts"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, card), ":3\r\n"), "VCARD");
+    const char *dim[] = {"VDIM", "pts"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, dim), ":3\r\n"), "VDIM");
+
+    const char *s1[] = {"VSIM", "pts", "ELE", "x", "WITHSCORES"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, s1), "*6\r\n$1\r\nx\r\n$1\r\n1\r\n$1\r\nz\r\n$3\r\n0.8\r\n$1\r\ny\r\n$3\r\n0.5\r\n"),
+                "VSIM ELE WITHSCORES");
+    const char *s2[] = {"VSIM", "pts", "VALUES", "3", "0", "2", "0.1", "COUNT", "2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 9, s2), "*2\r\n$1\r\ny\r\n$1\r\nz\r\n"), "VSIM VALUES COUNT");
+    const char *s3[] = {"VSIM", "pts", "VALUES", "3", "0", "2", "0.1", "COUNT", "2", "TRUTH", "EF", "50"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 12, s3), "*2\r\n$1\r\ny\r\n$1\r\nz\r\n"), "VSIM TRUTH EF");
+    const char *s4[] = {"VSIM", "none", "ELE", "x"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, s4), "*0\r\n"), "VSIM missing key");
+
+    // L2: 分数是欧氏距离
+    const char *l1[] = {"VADD", "l2", "VALUES", "2", "0", "0", "o", "METRIC", "L2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 9, l1), ":1\r\n"), "VADD L2");
+    const char *l2[] = {"VADD", "l2", "VALUES", "2", "3", "4", "p"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, l2), ":1\r\n"), "VADD L2 second");
+    const char *l3s[] = {"VSIM", "l2", "ELE", "o", "WITHSCORES"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, l3s), "*4\r\n$1\r\no\r\n$1\r\n0\r\n$1\r\np\r\n$1\r\n5\r\n"), "VSIM L2 scores");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 5: 错误
+static void test_vset_errors(void) {
+    TEST_START("vector set errors");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *a1[] = {"VADD", "ev", "VALUES", "2", "1", "2", "a"};
+    exec(&cn, 7, a1);
+    const char *a2[] = {"VADD", "ev", "VALUES", "3", "1", "2", "3", "b"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, a2), "-ERR Vector dimension mismatch - got 3 but set has 2\r\n"), "dim mismatch");
+    const char *a3[] = {"VADD", "ev", "VALUES", "2", "1", "2", "b", "Q8"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, a3), "-ERR asked quantization mismatch with existing vector set\r\n"),
+                "quant mismatch");
+    const char *a4[] = {"VADD", "ev", "VALUES", "2", "1", "nan", "b"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, a4), "-ERR invalid vector specification\r\n"), "nan");
+    const char *a5[] = {"VADD", "ev", "VALUES", "4", "1", "2", "b"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, a5), "-ERR invalid vector specification\r\n"), "too few values");
+    const char *a6[] = {"VADD", "ev", "FP32", "abc", "b"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, a6), "-ERR invalid vector specification\r\n"), "blob not a multiple of 4");
+    const char *a7[] = {"VADD", "nv", "VALUES", "2", "1", "2", "b", "M", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 9, a7), "-ERR invalid M\r\n"), "M");
+    const char *a8[] = {"VADD", "nv", "VALUES", "2", "1", "2", "b", "BOGUS"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, a8), "-ERR syntax error\r\n"), "unknown option");
+    const char *card[] = {"VCARD", "nv"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, card), ":0\r\n"), "nothing written");
+
+    const char *s1[] = {"VSIM", "ev", "ELE", "zz"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, s1), "-ERR element not found in set\r\n"), "missing element");
+    const char *s2[] = {"VSIM", "ev", "VALUES", "1", "1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, s2), "-ERR Vector dimension mismatch - got 1 but set has 2\r\n"), "query dim");
+    const char *s3[] = {"VSIM", "ev", "ELE", "a", "COUNT", "0"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, s3), "-ERR invalid COUNT\r\n"), "COUNT 0");
+    const char *dim[] = {"VDIM", "nv"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, dim), "-ERR key does not exist\r\n"), "VDIM missing");
+
+    const char *set[] = {"SET", "str", "v"};
+    exec(&cn, 3, set);
+    const char *w[] = {"VADD", "str", "VALUES", "1", "1", "a"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 6, w), "-WRONGTYPE Operation against a key holding the wrong kind of value\r\n"),
+                "WRONGTYPE");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+void run_cmd_vset_tests(void) {
+    test_vset_exact();
+    test_vset_q8();
+    test_vset_hnsw();
+    test_vset_commands();
+    test_vset_errors();
+}
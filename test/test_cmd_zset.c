@@ -0,0 +1,365 @@
+//
+// Sorted Set Type Tests for CMD + OHASH
+// Tests: packed encoding, B+ tree index against a reference model, score ranges, Z* commands, range latency
+//
+
+#include "test_cmd_common.h"
+#include <assert.h>
+
+static int ent_less(const struct ozent *a, const struct ozent *b) {
+    if (a->score != b->score) return a->score < b->score;
+    uint32_t l = a->mlen < b->mlen ? a->mlen : b->mlen;
+    int c = memcmp(a->m, b->m, l);
+    return c ? c < 0 : a->mlen < b->mlen;
+}
+
+/** 子树的元素个数, 同时检查计数 / 分隔 / 叶子内的顺序 @return -1 表示结构错误 */
+static int64_t check_node(const void *node, uint32_t h) {
+    if (!h) {
+        const struct ozleaf *lf = node;
+        if (!lf->n) return -1;
+        for (uint32_t i = 1; i < lf->n; i++)
+            if (!ent_less(&lf->e[i - 1], &lf->e[i])) return -1;
+        return lf->n;
+    }
+    const struct ozinner *in = node;
+    int64_t total = 0;
+    for (uint32_t i = 0; i < in->n; i++) {
+        int64_t c = check_node(in->c[i], h - 1);
+        if (c < 0 || (uint64_t) c != in->cnt[i]) return -1;
+        if (i) {
+            // k[i] 是子树 c[i] 的最小元素
+            const void *p = in->c[i];
+            for (uint32_t d = h - 1; d; d--) p = ((const struct ozinner *) p)->c[0];
+            const struct ozent *mn = &((const struct ozleaf *) p)->e[0];
+            if (in->k[i].score != mn->score || in->k[i].mlen != mn->mlen || memcmp(in->k[i].m, mn->m, mn->mlen))
+                return -1;
+        }
+        total += c;
+    }
+    return total;
+}
+
+static int check_tree(const osv *v) {
+    const struct ozset *s = ozv_set(v);
+    if (!s->root) return s->len == 0 && s->first == NULL;
+    if (check_node(s->root, s->height) != (int64_t) s->len) return 0;
+    // 叶子链表覆盖全部元素, 整体有序
+    uint64_t n = 0;
+    const struct ozent *prev = NULL;
+    for (const struct ozleaf *lf = s->first; lf; lf = lf->next) {
+        for (uint32_t i = 0; i < lf->n; i++) {
+            if (prev && !ent_less(prev, &lf->e[i])) return 0;
+            prev = &lf->e[i];
+            n++;
+        }
+    }
+    return n == s->len && s->dict.size == s->len;
+}
+
+// Test 1: packed encoding keeps (score, member) order
+static void test_zset_packed(void) {
+    TEST_START("Packed sorted set encoding");
+
+    osv *v = ozv_new();
+    assert(v);
+    ASSERT_EQ(ozv_add(&v, "carol", 5, 30), 1, "new member");
+    ASSERT_EQ(ozv_add(&v, "alice", 5, 10), 1, "new member");
+    ASSERT_EQ(ozv_add(&v, "bob", 3, 20), 1, "new member");
+    ASSERT_EQ(ozv_add(&v, "bea", 3, 20), 1, "tie on score");
+    ASSERT_EQ(v->enc, OSV_ZSET_PACK, "still packed");
+    ASSERT_EQ(v->vlen, (9 + 5) * 2 + (9 + 3) * 2, "9 bytes of overhead per member");
+
+    static const char *order[] = {"alice", "bea", "bob", "carol"};
+    struct ozv_iter it;
+    const char *m;
+    uint32_t mlen;
+    double score;
+    ozv_iter_rank(&it, v, 0);
+    for (int i = 0; i < 4; i++)
+        ASSERT_TRUE(ozv_next(&it, &m, &mlen, &score) && mlen == strlen(order[i]) && !memcmp(m, order[i], mlen),
+                    "ordered by score, then member");
+    ASSERT_EQ(ozv_next(&it, &m, &mlen, &score), 0, "end");
+
+    ASSERT_EQ(ozv_add(&v, "alice", 5, 25), 0, "update moves the member");
+    uint64_t rank;
+    ASSERT_TRUE(ozv_rank(v, "alice", 5, &rank) && rank == 2, "rank after update");
+    ASSERT_TRUE(ozv_score(v, "alice", 5, &score) && score == 25, "score after update");
+    ASSERT_EQ(ozv_iter_score(&it, v, 20, 0), 0, "first >= 20");
+    ASSERT_EQ(ozv_iter_score(&it, v, 20, 1), 2, "first > 20");
+    ASSERT_EQ(ozv_iter_score(&it, v, 100, 0), 4, "past the end");
+    ASSERT_EQ(ozv_del(v, "bea", 3), 1, "delete");
+    ASSERT_EQ(ozv_del(v, "bea", 3), 0, "delete again");
+    ASSERT_EQ(ozv_len(v), 3, "ZCARD");
+
+    osv_free(v);
+    TEST_PASS();
+}
+
+// Test 2: random adds / updates / deletes on the tree against a plain score array
+static void test_zset_tree_model(void) {
+    TEST_START("B+ tree index vs reference model");
+
+    enum { N = 20000 };
+    static double model[N]; // NaN: 不在集合中
+    for (int i = 0; i < N; i++) model[i] = NAN;
+    osv *v = ozv_new();
+    char m[16];
+    uint32_t seed = 7;
+    uint64_t len = 0;
+    int ok = 1;
+    for (int op = 0; op < 200000 && ok; op++) {
+        seed = seed * 1103515245 + 12345;
+        int k = (int) ((seed >> 8) % N);
+        int ml = snprintf(m, sizeof(m), "m%d", k);
+        seed = seed * 1103515245 + 12345;
+        if ((seed >> 16) % 4 == 0) {
+            int ret = ozv_del(v, m, ml);
+            ok &= ret == !isnan(model[k]);
+            len -= ret;
+            model[k] = NAN;
+        } else {
+            double sc = (double) ((seed >> 12) % 1000); // 大量相同的 score
+            int ret = ozv_add(&v, m, ml, sc);
+            ok &= ret == isnan(model[k]);
+            len += ret;
+            model[k] = sc;
+        }
+        if (op % 20000 == 0) ok &= v->enc != OSV_ZSET_TREE || check_tree(v);
+    }
+    ASSERT_TRUE(ok, "add / delete results match the model");
+    ASSERT_EQ(v->enc, OSV_ZSET_TREE, "converted to the tree");
+    ASSERT_EQ(ozv_len(v), len, "length");
+    ASSERT_TRUE(check_tree(v), "tree invariants");
+    ASSERT_GT(ozv_set(v)->height, 1, "multi-level tree");
+
+    // 名次 == 严格小于它的成员数
+    ok = 1;
+    for (int k = 0; k < N && ok; k += 37) {
+        int ml = snprintf(m, sizeof(m), "m%d", k);
+        uint64_t rank, expect = 0;
+        double sc;
+        if (isnan(model[k])) {
+            ok &= !ozv_rank(v, m, ml, &rank) && !ozv_score(v, m, ml, &sc);
+            continue;
+        }
+        for (int j = 0; j < N; j++) {
+            if (isnan(model[j])) continue;
+            char mj[16];
+            int lj = snprintf(mj, sizeof(mj), "m%d", j);
+            int c = memcmp(mj, m, lj < ml ? lj : ml);
+            if (model[j] < model[k] || (model[j] == model[k] && (c < 0 || (!c && lj < ml)))) expect++;
+        }
+        ok &= ozv_rank(v, m, ml, &rank) && rank == expect && ozv_score(v, m, ml, &sc) && sc == model[k];
+        // 按名次定位回到同一个成员
+        struct ozv_iter it;
+        const char *pm;
+        uint32_t pl;
+        ozv_iter_rank(&it, v, rank);
+        ok &= ozv_next(&it, &pm, &pl, &sc) && pl == (uint32_t) ml && !memcmp(pm, m, ml);
+    }
+    ASSERT_TRUE(ok, "ZRANK / ZSCORE / select by rank match the model");
+
+    // 删空: 树整个释放, 之后还能继续用
+    for (int k = 0; k < N; k++) ozv_del(v, m, snprintf(m, sizeof(m), "m%d", k));
+    ASSERT_EQ(ozv_len(v), 0, "empty");
+    ASSERT_NULL(ozv_set(v)->root, "tree freed");
+    ASSERT_EQ(ozv_add(&v, "again", 5, 1), 1, "reusable after emptying");
+    ASSERT_TRUE(check_tree(v), "single leaf");
+
+    osv_free(v);
+    TEST_PASS();
+}
+
+// Test 3: score seeks with ties and exclusive bounds, both encodings
+static void test_zset_score_range(void) {
+    TEST_START("Score seeks on both encodings");
+
+    for (int big = 0; big < 2; big++) {
+        osv *v = ozv_new();
+        char m[16];
+        int n = big ? 5000 : 50;
+        // score = i / 10: 每个 score 有 10 个成员
+        for (int i = 0; i < n; i++) ozv_add(&v, m, snprintf(m, sizeof(m), "m%05d", i), (double) (i / 10));
+        ASSERT_EQ(v->enc, big ? OSV_ZSET_TREE : OSV_ZSET_PACK, "encoding");
+        struct ozv_iter it;
+        const char *pm;
+        uint32_t pl;
+        double sc;
+        int ok = 1;
+        for (int s = 0; s < n / 10; s += 3) {
+            ok &= ozv_iter_score(&it, v, s, 0) == (uint64_t) s * 10;
+            ok &= ozv_next(&it, &pm, &pl, &sc) && sc == s;
+            ok &= ozv_iter_score(&it, v, s, 1) == (uint64_t) (s + 1) * 10;
+            ok &= ozv_iter_score(&it, v, s - 0.5, 1) == (uint64_t) s * 10;
+        }
+        ASSERT_TRUE(ok, "seek lands on the first member of the score");
+        ASSERT_EQ(ozv_iter_score(&it, v, -INFINITY, 0), 0, "-inf");
+        ASSERT_EQ(ozv_iter_score(&it, v, INFINITY, 0), (uint64_t) n, "+inf");
+        ASSERT_EQ(ozv_next(&it, &pm, &pl, &sc), 0, "nothing past the end");
+        osv_free(v);
+    }
+
+    TEST_PASS();
+}
+
+// Test 4: Z* commands through the dispatcher
+static void test_zset_dispatch(void) {
+    TEST_START("Sorted set commands through cmd_dispatch");
+
+    struct connection_t cn = {0};
+    cn.write_buffer = malloc(BUFFER_SIZE_DEFAULT);
+    cn.wb_cap = BUFFER_SIZE_DEFAULT;
+
+    const char *zadd[] = {"ZADD", "lb", "100", "alice", "85.5", "bob", "100", "carol", "-inf", "dave"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 10, zadd), ":4\r\n"), "ZADD");
+    ASSERT_TRUE(!strcmp(exec(&cn, 10, zadd), ":0\r\n"), "ZADD again");
+    const char *zrange[] = {"ZRANGE", "lb", "0", "-1", "WITHSCORES"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, zrange),
+                        "*8\r\n$4\r\ndave\r\n$4\r\n-inf\r\n$3\r\nbob\r\n$4\r\n85.5\r\n"
+                        "$5\r\nalice\r\n$3\r\n100\r\n$5\r\ncarol\r\n$3\r\n100\r\n"), "ZRANGE WITHSCORES");
+    const char *zrange_tail[] = {"ZRANGE", "lb", "-2", "-1"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, zrange_tail), "*2\r\n$5\r\nalice\r\n$5\r\ncarol\r\n"), "ZRANGE negative");
+    const char *zrbs[] = {"ZRANGEBYSCORE", "lb", "(85.5", "+inf"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, zrbs), "*2\r\n$5\r\nalice\r\n$5\r\ncarol\r\n"), "ZRANGEBYSCORE exclusive");
+    const char *zrbs_limit[] = {"ZRANGEBYSCORE", "lb", "-inf", "100", "LIMIT", "1", "2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, zrbs_limit), "*2\r\n$3\r\nbob\r\n$5\r\nalice\r\n"), "ZRANGEBYSCORE LIMIT");
+    const char *zrbs_none[] = {"ZRANGEBYSCORE", "lb", "101", "200"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, zrbs_none), "*0\r\n"), "ZRANGEBYSCORE empty");
+    const char *zrbs_bad[] = {"ZRANGEBYSCORE", "lb", "x", "200"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, zrbs_bad), "-ERR min or max", 15), "ZRANGEBYSCORE bad bound");
+    const char *zrank[] = {"ZRANK", "lb", "alice"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, zrank), ":2\r\n"), "ZRANK");
+    const char *zrank_none[] = {"ZRANK", "lb", "zed"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, zrank_none), "$-1\r\n"), "ZRANK missing member");
+    const char *zscore[] = {"ZSCORE", "lb", "bob"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, zscore), "$4\r\n85.5\r\n"), "ZSCORE");
+
+    const char *zadd_nx[] = {"ZADD", "lb", "NX", "1", "bob", "2", "erin"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 7, zadd_nx), ":1\r\n"), "ZADD NX only adds");
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, zscore), "$4\r\n85.5\r\n"), "NX kept the score");
+    const char *zadd_xx_ch[] = {"ZADD", "lb", "XX", "CH", "90", "bob", "3", "frank"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, zadd_xx_ch), ":1\r\n"), "ZADD XX CH counts changes");
+    const char *zadd_gt[] = {"ZADD", "lb", "GT", "CH", "50", "bob", "95", "alice"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 8, zadd_gt), ":0\r\n"), "ZADD GT ignores lower scores");
+    const char *zadd_incr[] = {"ZADD", "lb", "INCR", "0.5", "bob"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, zadd_incr), "$4\r\n90.5\r\n"), "ZADD INCR");
+    const char *zadd_bad[] = {"ZADD", "lb", "NX", "XX", "1", "x"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 6, zadd_bad), "-ERR XX and NX", 14), "NX + XX");
+    const char *zadd_nan[] = {"ZADD", "lb", "1", "a", "nope", "b"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 6, zadd_nan), "-ERR value is not a valid float", 31), "bad score");
+    const char *zcard[] = {"ZCARD", "lb"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 2, zcard), ":5\r\n"), "bad ZADD wrote nothing");
+
+    const char *zpop[] = {"ZPOPMIN", "lb", "2"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, zpop), "*4\r\n$4\r\ndave\r\n$4\r\n-inf\r\n$4\r\nerin\r\n$1\r\n2\r\n"),
+                "ZPOPMIN count");
+    const char *zrem[] = {"ZREM", "lb", "alice", "nobody"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 4, zrem), ":1\r\n"), "ZREM");
+    const char *zpop_all[] = {"ZPOPMIN", "lb", "10"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, zpop_all), "*4\r\n$3\r\nbob\r\n$4\r\n90.5\r\n$5\r\ncarol\r\n$3\r\n100\r\n"),
+                "ZPOPMIN everything");
+    ASSERT_NULL(olookup("lb", 2), "empty zset removes the key");
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, zpop), "*0\r\n"), "ZPOPMIN missing key");
+    const char *zadd_xx_missing[] = {"ZADD", "lb", "XX", "1", "a"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 5, zadd_xx_missing), ":0\r\n"), "ZADD XX on a missing key");
+    ASSERT_NULL(olookup("lb", 2), "XX did not create the key");
+
+    const char *set[] = {"SET", "str", "v"};
+    exec(&cn, 3, set);
+    const char *zadd_str[] = {"ZADD", "str", "1", "a"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, zadd_str), "-WRONGTYPE", 10), "ZADD on a string");
+    const char *zrange_str[] = {"ZRANGE", "str", "0", "-1"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 4, zrange_str), "-WRONGTYPE", 10), "ZRANGE on a string");
+    exec(&cn, 10, zadd);
+    const char *lpush[] = {"LPUSH", "lb", "x"};
+    ASSERT_TRUE(!strncmp(exec(&cn, 3, lpush), "-WRONGTYPE", 10), "LPUSH on a zset");
+
+    // 转换成树之后被 DEL 删除, 嵌套结构一起释放
+    for (int i = 0; i < 300; i++) {
+        char m[16];
+        snprintf(m, sizeof(m), "p%d", i);
+        const char *za[] = {"ZADD", "big", "1", m};
+        exec(&cn, 4, za);
+    }
+    ASSERT_EQ(((osv *) olookup("big", 3)->v)->enc, OSV_ZSET_TREE, "converted through ZADD");
+    const char *del[] = {"DEL", "big", "lb"};
+    ASSERT_TRUE(!strcmp(exec(&cn, 3, del), ":2\r\n"), "DEL zsets");
+
+    free(cn.write_buffer);
+    TEST_PASS();
+}
+
+// Test 5: range / rank latency on a 100k-member set
+static void test_zset_benchmark(void) {
+    TEST_START("Sorted set range latency (100k members)");
+
+    const int n = 100000;
+    int err;
+    ohash_t *slot = otype_lookup("board", 5, OSV_T_ZSET, ozv_new, &err);
+    assert(slot);
+    char m[24];
+    uint32_t seed = 99;
+    double t0 = get_time_ns();
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245 + 12345;
+        osv *v = slot->v;
+        ozv_add(&v, m, snprintf(m, sizeof(m), "player:%d", i), (double) (seed >> 8));
+        slot->v = v;
+    }
+    double add_ns = (get_time_ns() - t0) / n;
+    const osv *v = slot->v;
+
+    const int nq = 100000;
+    struct ozv_iter it;
+    const char *pm;
+    uint32_t pl;
+    double sc, sink = 0;
+    // ZRANGEBYSCORE 取 10 个: 两次 seek + 顺序读
+    t0 = get_time_ns();
+    for (int i = 0; i < nq; i++) {
+        seed = seed * 1103515245 + 12345;
+        double lo = (double) (seed >> 8);
+        ozv_iter_score(&it, v, lo, 0);
+        for (int j = 0; j < 10 && ozv_next(&it, &pm, &pl, &sc); j++) sink += sc;
+    }
+    double range_ns = (get_time_ns() - t0) / nq;
+    t0 = get_time_ns();
+    uint64_t rank, rsum = 0;
+    for (int i = 0; i < nq; i++) {
+        int ml = snprintf(m, sizeof(m), "player:%d", (int) ((i * 2654435761U) % n));
+        if (ozv_rank(v, m, ml, &rank)) rsum += rank;
+    }
+    double rank_ns = (get_time_ns() - t0) / nq;
+    // ZRANGE 100 个 (按名次定位)
+    t0 = get_time_ns();
+    for (int i = 0; i < nq / 10; i++) {
+        ozv_iter_rank(&it, v, (uint64_t) (i * 97) % (n - 100));
+        for (int j = 0; j < 100 && ozv_next(&it, &pm, &pl, &sc); j++) sink += pl;
+    }
+    double zrange_ns = (get_time_ns() - t0) / (nq / 10);
+    (void) sink;
+    (void) rsum;
+
+    printf("\n      height %u, ZADD %.1f ns\n", ozv_set(v)->height, add_ns);
+    printf("      ZRANGEBYSCORE (10) : %.1f ns\n", range_ns);
+    printf("      ZRANK              : %.1f ns\n", rank_ns);
+    printf("      ZRANGE (100)       : %.1f ns\n", zrange_ns);
+    ASSERT_LT(range_ns, 5000, "10-element score range stays in the microseconds");
+    ASSERT_LT(zrange_ns, 20000, "100-element rank range stays in the microseconds");
+
+    otype_remove(slot);
+    TEST_PASS();
+}
+
+void run_cmd_zset_tests(void) {
+    TEST_SUITE_START("CMD Sorted Set Type Tests");
+
+    test_zset_packed();
+    test_zset_tree_model();
+    test_zset_score_range();
+    test_zset_dispatch();
+    test_zset_benchmark();
+
+    TEST_SUITE_END();
+}
@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <assert.h>
 #include <time.h>
 #include <sys/time.h>
@@ -42,6 +43,21 @@ static struct timeval g_test_start;
 static const char *g_current_test = NULL;
 static const char *g_current_suite = NULL;
 
+// 测试用的伪随机数: xorshift64, 每个测试文件各有一份状态, 种子固定所以可以复现
+#define TEST_RAND_SEED 0x9e3779b97f4a7c15ULL
+static uint64_t g_test_rand = TEST_RAND_SEED;
+
+static inline void test_rand_seed(uint64_t seed) {
+    g_test_rand = seed ? seed : TEST_RAND_SEED; // 0 是 xorshift 的不动点
+}
+
+static inline uint64_t test_rand64(void) {
+    g_test_rand ^= g_test_rand << 13;
+    g_test_rand ^= g_test_rand >> 7;
+    g_test_rand ^= g_test_rand << 17;
+    return g_test_rand;
+}
+
 // Macros
 #define TEST_SUITE_START(name) \
     do { \
@@ -21,6 +21,10 @@ extern void test_expansion_cleans_tombstones(void);
 
 extern void test_manual_expansion(void);
 
+extern void test_probe_and_claim(void);
+
+extern void test_nested_table(void);
+
 
 int main() {
     printf("\n"
@@ -36,6 +40,7 @@ int main() {
 
     printf("\n=== Tombstone & Probing Chain ===\n");
     RUN_TEST(test_tombstone_probing);
+    RUN_TEST(test_probe_and_claim);
 
     printf("\n=== Expiration ===\n");
     RUN_TEST(test_expiration);
@@ -44,6 +49,9 @@ int main() {
     RUN_TEST(test_manual_expansion);
     RUN_TEST(test_expansion_cleans_tombstones);
 
+    printf("\n=== Nested Tables ===\n");
+    RUN_TEST(test_nested_table);
+
 
     // Print test report from common framework
     print_test_report();
@@ -163,7 +163,7 @@ void test_expiration() {
     char *key1 = make_key("key", 1);
     void *val1 = make_value("val", 1);
 
-    unsigned int expiry_time = get_current_time_seconds() + 1;
+    uint64_t expiry_time = get_current_time_ms() + 1000;
     oinsert(key1, strlen(key1), val1, expiry_time, NULL);
 
     sleep(2); // Wait for item to expire
@@ -259,3 +259,102 @@ void test_expansion_cleans_tombstones() {
         }
     }
 }
+
+void test_probe_and_claim() {
+    uint64_t hash;
+    int found;
+    char *key1 = make_key("key", 1);
+
+    // miss: a candidate slot is returned but nothing is written until oclaim
+    ohash_t *slot = oprobe(key1, strlen(key1), &hash, &found);
+    assert(slot != NULL && found == 0);
+    assert(hash == XXH64(key1, strlen(key1), H_SEED));
+    assert(size == 0);
+    assert(oget(key1, strlen(key1)) == NULL);
+
+    void *val1 = make_value("val", 1);
+    oret_t ot = {0};
+    assert(oclaim(slot, key1, strlen(key1), hash, val1, 0, &ot) == OK);
+    assert(size == 1);
+    assert(oget(key1, strlen(key1)) == val1);
+
+    // hit: the live slot itself
+    assert(oprobe(key1, strlen(key1), &hash, &found) == slot && found == 1);
+
+    // a key behind a tombstone is found, not shadowed by the reusable tombstone
+    char *key_collide = NULL;
+    for (int i = 2; i < 10000 && !key_collide; ++i) {
+        char *k = make_key("key", i);
+        if ((XXH64(k, strlen(k), H_SEED) & (cap - 1)) == (hash & (cap - 1))) key_collide = k;
+        else free(k);
+    }
+    assert(key_collide != NULL);
+    void *val_collide = make_value("val", 2);
+    oinsert(key_collide, strlen(key_collide), val_collide, 0, NULL);
+    otake_slot(slot, &ot);
+    assert(size == 1);
+    free(ot.key);
+    free(ot.value);
+    ohash_t *s2 = oprobe(key_collide, strlen(key_collide), &hash, &found);
+    assert(found == 1 && s2->v == val_collide);
+
+    // a miss reuses the first tombstone on its path
+    char *key3 = make_key("key", 1);
+    ohash_t *s3 = oprobe(key3, strlen(key3), &hash, &found);
+    assert(found == 0 && s3 == slot);
+    void *val3 = make_value("val", 3);
+    assert(oclaim(s3, key3, strlen(key3), hash, val3, 0, &ot) == REMOVED);
+    assert(size == 2);
+
+    // an expired entry hands its key/value back on claim
+    s3->expiratime = 1;
+    ohash_t *s4 = oprobe(key3, strlen(key3), &hash, &found);
+    assert(found == 0 && s4 == s3);
+    char *key4 = make_key("key", 1);
+    void *val4 = make_value("val", 4);
+    ot.key = NULL;
+    assert(oclaim(s4, key4, strlen(key4), hash, val4, 0, &ot) == EXPIRED_);
+    assert(ot.key == key3 && ot.value == val3);
+    assert(size == 2);
+    free(ot.key);
+    free(ot.value);
+    assert(oget(key4, strlen(key4)) == val4);
+}
+
+void test_nested_table() {
+    otable_t t;
+    assert(otable_init(&t, 4) == OK);
+    uint64_t global_size = size;
+
+    // 嵌套表自己扩容, 不碰全局表
+    for (int i = 0; i < 1000; ++i) {
+        char *key = make_key("field", i);
+        assert(otable_insert(&t, key, strlen(key), make_value("v", i), NULL) >= 0);
+    }
+    assert(t.size == 1000);
+    assert(t.cap >= 1024);
+    assert(size == global_size);
+
+    char *k = make_key("field", 500);
+    ohash_t *s = otable_lookup(&t, k, strlen(k));
+    assert(s != NULL && strcmp(s->v, "v_val_500") == 0);
+    assert(otable_lookup(&t, "field_1000", 10) == NULL);
+
+    // replace hands the old pair back
+    oret_t ot = {0};
+    assert(otable_insert(&t, k, strlen(k), make_value("w", 500), &ot) == REPLACED);
+    assert(t.size == 1000);
+    free(ot.key);
+    free(ot.value);
+
+    ot.key = NULL;
+    otable_take(&t, k, strlen(k), &ot);
+    assert(ot.key == k && t.size == 999);
+    free(ot.key);
+    free(ot.value);
+    assert(otable_lookup(&t, "field_500", 9) == NULL);
+    assert(otable_lookup(&t, "field_501", 9) != NULL);
+
+    otable_destroy(&t, free_key_value_pair);
+    assert(t.slots == NULL && t.size == 0);
+}
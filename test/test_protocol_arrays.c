@@ -215,6 +215,55 @@ void test_array_redis_command(void) {
     TEST_PASS();
 }
 
+void test_command_single_pass(void) {
+    TEST_START("Command: single-pass parse of pipelined commands");
+
+    const char buf[] = "*3\r\n$3\r\nSET\r\n$3\r\nkey\r\n$5\r\nvalue\r\n"
+            "*2\r\n$3\r\nGET\r\n$0\r\n\r\n"
+            "*1\r\n$4\r\nPING\r\n";
+    struct connection_t cn;
+    struct parser_context ctx;
+    setup_test_context(&cn, &ctx, buf, sizeof(buf) - 1);
+    struct element *e = ctx.segment_context.elements;
+
+    ASSERT_EQ(command_proceed(&ctx), 1, "SET should be complete");
+    ASSERT_EQ(ctx.segment_context.element_count, 3, "SET has 3 args");
+    ASSERT_STR_EQ(e[0].data, "SET", 3, "argv[0]");
+    ASSERT_STR_EQ(e[1].data, "key", 3, "argv[1]");
+    ASSERT_EQ(e[2].len, 5, "argv[2] length");
+    ASSERT_STR_EQ(e[2].data, "value", 5, "argv[2]");
+    ASSERT_TRUE(e[0].data == cn.read_buffer + 8, "argv points into the read buffer");
+
+    ASSERT_EQ(command_proceed(&ctx), 1, "GET should be complete");
+    ASSERT_EQ(ctx.segment_context.element_count, 2, "GET has 2 args");
+    ASSERT_EQ(e[1].len, 0, "empty bulk string");
+
+    ASSERT_EQ(command_proceed(&ctx), 1, "PING should be complete");
+    ASSERT_EQ(ctx.segment_context.element_count, 1, "PING has 1 arg");
+    ASSERT_EQ(cn.rb_offset, cn.rb_size, "everything consumed");
+    ASSERT_EQ(command_proceed(&ctx), 0, "empty buffer");
+
+    cleanup_test_context(&cn);
+    TEST_PASS();
+}
+
+void test_command_single_pass_fallback(void) {
+    TEST_START("Command: other shapes fall back to frame parsing");
+
+    const char *bufs[] = {"+OK\r\n", "*0\r\n", "*2\r\n:1\r\n:2\r\n", "*1\r\n*1\r\n$1\r\na\r\n",
+                          "*2\r\n$-1\r\n", "*1\r\n$3\r\nabcX\r\n", "*x\r\n", "*1\r\n$3\rX"};
+    for (size_t k = 0; k < sizeof(bufs) / sizeof(bufs[0]); k++) {
+        struct connection_t cn;
+        struct parser_context ctx;
+        setup_test_context(&cn, &ctx, bufs[k], strlen(bufs[k]));
+        ASSERT_EQ(command_proceed(&ctx), -EAGAIN, bufs[k]);
+        ASSERT_EQ(cn.rb_offset, 0, "offset untouched on fallback");
+        ASSERT_EQ(ctx.cmdprog.argc, 0, "no breakpoint on fallback");
+        cleanup_test_context(&cn);
+    }
+
+    TEST_PASS();
+}
 
 void run_array_tests(void) {
     TEST_SUITE_START("Array Protocol Tests");
@@ -226,6 +275,8 @@ void run_array_tests(void) {
     test_array_nested_simple();
     test_array_nested_deep();
     test_array_redis_command();
+    test_command_single_pass();
+    test_command_single_pass_fallback();
 
     TEST_SUITE_END();
 }
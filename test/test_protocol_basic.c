@@ -114,6 +114,38 @@ void test_integer_positive(void) {
     ASSERT_EQ(rc, 0, "Should return 0");
     ASSERT_EQ(ctx.outframe.type, NUMERIC, "Type should be NUMERIC");
     ASSERT_STR_EQ(ctx.outframe.start_rbp, "42", 2, "Content should be '42'");
+    long long v = 0;
+    ASSERT_EQ(frame_integer(&ctx.outframe, &v), 0, "Should parse");
+    ASSERT_EQ(v, 42, "Value should be 42");
+
+    cleanup_test_context(&cn);
+    TEST_PASS();
+}
+
+void test_integer_negative(void) {
+    TEST_START("Integer: :-42\\r\\n and :-9223372036854775808\\r\\n (LLONG_MIN)");
+
+    const char buf[] = ":-42\r\n:-9223372036854775808\r\n:+7\r\n";
+    struct connection_t cn;
+    struct parser_context ctx;
+    setup_test_context(&cn, &ctx, buf, sizeof(buf) - 1);
+
+    int rc = zerocopy_proceed(&ctx);
+    ASSERT_EQ(rc, 0, "Should return 0");
+    ASSERT_EQ(ctx.outframe.type, NUMERIC, "Type should be NUMERIC");
+    ASSERT_STR_EQ(ctx.outframe.start_rbp, "-42", 3, "Content should be '-42'");
+    long long v = 0;
+    ASSERT_EQ(frame_integer(&ctx.outframe, &v), 0, "Should parse");
+    ASSERT_EQ(v, -42, "Value should be -42");
+
+    rc = zerocopy_proceed(&ctx);
+    ASSERT_EQ(rc, 0, "Should return 0");
+    ASSERT_TRUE(frame_integer(&ctx.outframe, &v) == 0 && v == LLONG_MIN, "Value should be LLONG_MIN");
+
+    rc = zerocopy_proceed(&ctx);
+    ASSERT_EQ(rc, 0, "Should return 0");
+    ASSERT_TRUE(frame_integer(&ctx.outframe, &v) == 0 && v == 7, "Explicit + sign");
+    ASSERT_EQ(cn.rb_offset, cn.rb_size, "All frames consumed");
 
     cleanup_test_context(&cn);
     TEST_PASS();
@@ -132,6 +164,8 @@ void test_integer_large(void) {
     ASSERT_EQ(rc, 0, "Should return 0");
     ASSERT_EQ(ctx.outframe.type, NUMERIC, "Type should be NUMERIC");
     ASSERT_STR_EQ(ctx.outframe.start_rbp, "9223372036854775807", 19, "Content should match");
+    long long v = 0;
+    ASSERT_TRUE(frame_integer(&ctx.outframe, &v) == 0 && v == LLONG_MAX, "Value should be LLONG_MAX");
 
     cleanup_test_context(&cn);
     TEST_PASS();
@@ -238,6 +272,7 @@ void run_basic_tests(void) {
 
     test_integer_zero();
     test_integer_positive();
+    test_integer_negative();
     test_integer_large();
 
     test_bulk_string_simple();
@@ -241,6 +241,76 @@ void test_integer_max_long_long(void) {
     TEST_PASS();
 }
 
+void test_integer_invalid(void) {
+    TEST_START("Integer: invalid / overflowing :<n> is framed, but has no value");
+
+    const char *bad[] = {":abc\r\n", ":\r\n", ":-\r\n", ":--1\r\n", ":1-\r\n", ":12a4\r\n",
+                         ":9223372036854775808\r\n", ":-9223372036854775809\r\n", ":99999999999999999999\r\n"};
+    for (size_t k = 0; k < sizeof(bad) / sizeof(bad[0]); k++) {
+        struct connection_t cn;
+        struct parser_context ctx;
+        setup_test_context(&cn, &ctx, bad[k], strlen(bad[k]));
+        int rc = zerocopy_proceed(&ctx);
+        ASSERT_EQ(rc, 0, bad[k]);
+        ASSERT_EQ(ctx.outframe.type, NUMERIC, "Still a NUMERIC frame");
+        ASSERT_EQ(cn.rb_offset, cn.rb_size, "Frame consumed");
+        long long v;
+        ASSERT_EQ(frame_integer(&ctx.outframe, &v), -1, bad[k]);
+        cleanup_test_context(&cn);
+    }
+
+    TEST_PASS();
+}
+
+/** 参照实现: 严格的非负十进制, 溢出返回 -1 */
+static long long ref_positive(const char *s, size_t len) {
+    unsigned long long acc = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] < '0' || s[i] > '9') return -1;
+        if (acc > (unsigned long long) (LLONG_MAX - (s[i] - '0')) / 10) return -1;
+        acc = acc * 10 + (unsigned long long) (s[i] - '0');
+    }
+    return (long long) acc;
+}
+
+void test_number_parser_vs_scalar(void) {
+    TEST_START("Edge: SWAR length parser matches digit-by-digit parse");
+
+    char buf[40];
+    test_rand_seed(88172645463325252ULL);
+    int mismatches = 0;
+    for (int round = 0; round < 200000; round++) {
+        uint64_t seed = test_rand64();
+        size_t len = 1 + seed % 21;
+        for (size_t i = 0; i < len; i++) buf[i] = (char) ('0' + (seed >> (i * 3 % 60)) % 10);
+        // 1/4 的概率在随机位置放一个非数字 (包括 '0' - 1 和 '9' + 1)
+        if ((seed >> 40) % 4 == 0) buf[(seed >> 44) % len] = "/:a \r-"[(seed >> 50) % 6];
+        buf[len] = '\r';
+        if (try_parser_num(buf, len) != ref_positive(buf, len)) mismatches++;
+        // 有符号: 开头的 '-' 是符号, 其余和非负的一样
+        long long v = 0, want = buf[0] == '-' ? ref_positive(buf + 1, len - 1) : ref_positive(buf, len);
+        if (buf[0] == '-' && len == 1) want = -1;
+        int sr = try_parser_signed_num_str_64(buf, len, &v);
+        if (sr != (want < 0 ? -1 : 0) || (sr == 0 && v != (buf[0] == '-' ? -want : want))) mismatches++;
+    }
+    ASSERT_EQ(mismatches, 0, "random digit strings should agree");
+
+    ASSERT_TRUE(try_parser_num("9223372036854775807", 19) == LLONG_MAX, "LLONG_MAX");
+    ASSERT_EQ(try_parser_num("9223372036854775808", 19), -1, "LLONG_MAX + 1 overflows");
+    ASSERT_EQ(try_parser_num("99999999999999999999", 20), -1, "20 digits overflow");
+    ASSERT_EQ(try_parser_num("00000000000000000000042", 23), 42, "leading zeros");
+    ASSERT_EQ(try_parser_num("12345678", 8), 12345678, "exactly one SWAR group");
+    ASSERT_EQ(try_parser_num("1234567890123456", 16), 1234567890123456LL, "two SWAR groups");
+    ASSERT_EQ(try_parser_num("", 0), 0, "empty length is 0");
+    long long v;
+    ASSERT_EQ(try_parser_signed_num_str_64("-0", 2, &v), 0, "-0");
+    ASSERT_EQ(v, 0, "-0 is 0");
+    ASSERT_EQ(try_parser_signed_num_str_64("-9223372036854775807", 20, &v), 0, "-LLONG_MAX");
+    ASSERT_TRUE(v == -LLONG_MAX, "-LLONG_MAX value");
+
+    TEST_PASS();
+}
+
 void test_bulk_string_max_valid(void) {
     TEST_START("Bulk String: large but valid (1MB)");
 
@@ -428,6 +498,80 @@ void test_leading_whitespace(void) {
     TEST_PASS();
 }
 
+// ============================================================================
+// SIMD scanner Tests
+// ============================================================================
+
+static long long ref_crlf(const char *p, long long n) {
+    for (long long i = 0; i + 1 < n; i++)
+        if (p[i] == '\r' && p[i + 1] == '\n') return i;
+    return -1;
+}
+
+static long long ref_prefix(const char *p, long long n) {
+    for (long long i = 0; i < n; i++)
+        if (strchr("+-:$*", p[i]) && p[i]) return i;
+    return -1;
+}
+
+void test_scan_vs_scalar(void) {
+    TEST_START("Edge: SIMD CRLF / prefix scan matches scalar");
+
+    // 稀疏的 \r \n 和 prefix 字节, 覆盖 16 / 32 字节组的边界 (包括跨组的 \r|\n)
+    const char alphabet[] = "abcdefgh\r\n$*";
+    unsigned seed = 12345;
+    char buf[160];
+    int mismatches = 0;
+    for (int round = 0; round < 20000; round++) {
+        long long n = round % 150;
+        for (long long i = 0; i < n; i++) {
+            seed = seed * 1103515245u + 12345u;
+            unsigned r = (seed >> 16) % 64;
+            buf[i] = r < sizeof(alphabet) - 1 ? alphabet[r] : (char) ('a' + r % 26);
+        }
+        // 不能读到 n 之后: 让 n 之后紧跟一个会造成误判的 \n
+        buf[n] = '\n';
+        if (resp_scan_crlf(buf, n) != ref_crlf(buf, n)) mismatches++;
+        if (get_next_crlf_simd_inline(buf, n) != ref_crlf(buf, n)) mismatches++;
+        if (resp_scan_prefix(buf, n) != ref_prefix(buf, n)) mismatches++;
+        if (get_next_prefix_inline(buf, n) != ref_prefix(buf, n)) mismatches++;
+    }
+    ASSERT_EQ(mismatches, 0, "every position should agree with the scalar scan");
+
+    // CRLF 正好跨过 16 / 32 字节边界
+    for (int at = 13; at < 36; at++) {
+        memset(buf, 'x', sizeof(buf));
+        buf[at] = '\r';
+        buf[at + 1] = '\n';
+        ASSERT_EQ(resp_scan_crlf(buf, at + 2), at, "CRLF across a group boundary");
+        ASSERT_EQ(resp_scan_crlf(buf, at + 1), -1, "\\r as the last byte is not a CRLF");
+    }
+
+    TEST_PASS();
+}
+
+void test_long_simple_string_crlf(void) {
+    TEST_START("Edge: simple string longer than one SIMD group");
+
+    char buf[256];
+    buf[0] = '+';
+    memset(buf + 1, 'y', 200);
+    buf[100] = '\r'; // 单独的 \r 不是行尾
+    memcpy(buf + 201, "\r\n", 2);
+    struct connection_t cn;
+    struct parser_context ctx;
+    setup_test_context(&cn, &ctx, buf, 203);
+
+    int rc = zerocopy_proceed(&ctx);
+    ASSERT_EQ(rc, 0, "Should succeed");
+    ASSERT_EQ(ctx.state, COMPLETE, "Should complete");
+    ASSERT_EQ(ctx.outframe.data_len, 200, "Line ends at the first CRLF");
+    ASSERT_EQ(cn.rb_offset, 203, "Whole frame consumed");
+
+    cleanup_test_context(&cn);
+    TEST_PASS();
+}
+
 void run_edge_case_tests(void) {
     TEST_SUITE_START("Edge Cases & Error Handling");
 
@@ -451,6 +595,8 @@ void run_edge_case_tests(void) {
 
     // Boundary values
     test_integer_max_long_long();
+    test_integer_invalid();
+    test_number_parser_vs_scalar();
     test_bulk_string_max_valid();
 
     // Special characters
@@ -465,5 +611,9 @@ void run_edge_case_tests(void) {
     // Whitespace
     test_leading_whitespace();
 
+    // SIMD scanner
+    test_scan_vs_scalar();
+    test_long_simple_string_crlf();
+
     TEST_SUITE_END();
 }
@@ -453,6 +453,54 @@ void test_random_split_bulk_string(void) {
     TEST_PASS();
 }
 
+void test_command_resume(void) {
+    TEST_START("Fragmentation: single-pass command resumes at its breakpoint");
+
+    const char full[] = "*3\r\n$3\r\nSET\r\n$3\r\nkey\r\n$10\r\n0123456789\r\n";
+    const size_t len = sizeof(full) - 1;
+
+    // 同一块缓冲区 (不扩容): 从断点继续, 已切好的参数保留
+    struct connection_t cn;
+    struct parser_context ctx;
+    setup_test_context(&cn, &ctx, full, len);
+    cn.rb_size = 20; // "*3 $3 SET $3 k"
+    ASSERT_EQ(command_proceed(&ctx), 0, "incomplete");
+    ASSERT_EQ(ctx.cmdprog.argc, 3, "breakpoint remembers argc");
+    ASSERT_EQ(ctx.cmdprog.done, 1, "SET already cut");
+    ASSERT_EQ(ctx.cmdprog.pos, 13, "next arg starts after SET");
+    cn.rb_size = 35;
+    ASSERT_EQ(command_proceed(&ctx), 0, "still incomplete");
+    ASSERT_EQ(ctx.cmdprog.done, 2, "key cut");
+    cn.rb_size = (long long) len;
+    ASSERT_EQ(command_proceed(&ctx), 1, "complete");
+    ASSERT_STR_EQ(ctx.segment_context.elements[0].data, "SET", 3, "argv[0]");
+    ASSERT_STR_EQ(ctx.segment_context.elements[2].data, "0123456789", 10, "argv[2]");
+    ASSERT_EQ(ctx.cmdprog.argc, 0, "breakpoint cleared");
+    cleanup_test_context(&cn);
+
+    // 每次 1 字节, 缓冲区 realloc 可能搬家: 结果必须一样
+    for (size_t split = 1; split < len; split++) {
+        setup_test_context(&cn, &ctx, "", 0);
+        size_t fed = 0;
+        int rc = 0;
+        while (fed < len) {
+            size_t n = fed + split > len ? len - fed : split;
+            feed_data(&cn, full + fed, n);
+            fed += n;
+            rc = command_proceed(&ctx);
+            if (fed < len) ASSERT_EQ(rc, 0, "incomplete until the last byte");
+        }
+        ASSERT_EQ(rc, 1, "complete after the last byte");
+        ASSERT_EQ(ctx.segment_context.element_count, 3, "3 args");
+        ASSERT_STR_EQ(ctx.segment_context.elements[1].data, "key", 3, "argv[1]");
+        ASSERT_STR_EQ(ctx.segment_context.elements[2].data, "0123456789", 10, "argv[2]");
+        ASSERT_EQ(cn.rb_offset, (long long) len, "whole command consumed");
+        cleanup_test_context(&cn);
+    }
+
+    TEST_PASS();
+}
+
 void run_fragmentation_tests(void) {
     TEST_SUITE_START("Fragmentation & Packet Splitting Tests");
 
@@ -478,6 +526,7 @@ void run_fragmentation_tests(void) {
     test_bulk_string_with_embedded_crlf_fragmented();
     test_extreme_fragmentation();
     test_random_split_bulk_string();
+    test_command_resume();
 
     TEST_SUITE_END();
 }
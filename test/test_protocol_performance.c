@@ -239,6 +239,95 @@ void test_perf_redis_set_command(void) {
     TEST_PASS();
 }
 
+void test_perf_pipelined_set_framing(void) {
+    TEST_START("Performance: Pipelined SET framing (small args)");
+
+    // 一个读缓冲区里塞满小参数的 SET, 和 pipeline 下 cmd_on_read 看到的一样; 计时覆盖整块
+    const int ncmd = 4096;
+    char *buf = malloc((size_t) ncmd * 64);
+    assert(buf);
+    size_t len = 0;
+    for (int i = 0; i < ncmd; i++)
+        len += sprintf(buf + len, "*3\r\n$3\r\nSET\r\n$8\r\nkey:%04d\r\n$5\r\nv%04d\r\n", i, i % 10000);
+    struct connection_t cn;
+    struct parser_context ctx;
+
+    // 逐帧: zerocopy_proceed + segment_proceed 聚合
+    const int iterations = 200;
+    double total_time_ns = 0;
+    long long cmds = 0;
+    for (int iter = 0; iter < iterations; iter++) {
+        setup_test_context(&cn, &ctx, buf, len);
+        double start = get_time_ns();
+        while (cn.rb_offset < cn.rb_size && zerocopy_proceed(&ctx) == 0 && ctx.state == COMPLETE) {
+            segment_proceed(&ctx.segment_context, &ctx.outframe);
+            if (ctx.segment_context.consumed) cmds++;
+        }
+        total_time_ns += get_time_ns() - start;
+        cleanup_test_context(&cn);
+    }
+    ASSERT_EQ(cmds, (long long) iterations * ncmd, "every command should be assembled");
+    double frame_ns = total_time_ns / ((double) iterations * ncmd);
+
+    // 单趟: command_proceed 直接产出 argv
+    total_time_ns = 0;
+    cmds = 0;
+    for (int iter = 0; iter < iterations; iter++) {
+        setup_test_context(&cn, &ctx, buf, len);
+        double start = get_time_ns();
+        while (command_proceed(&ctx) == 1) cmds++;
+        total_time_ns += get_time_ns() - start;
+        cleanup_test_context(&cn);
+    }
+    ASSERT_EQ(cmds, (long long) iterations * ncmd, "every command should be parsed");
+    double ns_cmd = total_time_ns / ((double) iterations * ncmd);
+
+    printf("\n");
+    printf("    Commands:    %d x %d\n", ncmd, iterations);
+    printf("    Frames:      %.2f ns/command\n", frame_ns);
+    printf("    Single-pass: %.2f ns/command\n", ns_cmd);
+    printf("    Throughput:  %.2f MB/sec\n", (double) len * iterations / (total_time_ns / 1e9) / 1048576.0);
+    free(buf);
+
+    TEST_PASS();
+}
+
+void test_perf_length_parse(void) {
+    TEST_START("Performance: $/* length parse (SWAR vs digit loop)");
+
+    // 典型的长度: 大多 1-2 位, 偶尔更长
+    const char *lens[] = {"3", "5", "12", "8", "128", "3", "1024", "16", "65536", "7", "1048576", "2"};
+    const int nl = sizeof(lens) / sizeof(lens[0]);
+    size_t ll[16];
+    for (int k = 0; k < nl; k++) ll[k] = strlen(lens[k]);
+    const int iterations = 2000000;
+    volatile uint64_t sink = 0; // 无符号: 累加溢出是回绕, 不是未定义行为
+
+    double start = get_time_ns();
+    for (int i = 0; i < iterations; i++) sink += (uint64_t) try_parser_num(lens[i % nl], ll[i % nl]);
+    double swar_ns = (get_time_ns() - start) / iterations;
+    start = get_time_ns();
+    for (int i = 0; i < iterations; i++)
+        sink += (uint64_t) try_parser_positive_num_str_64_scalar(lens[i % nl], ll[i % nl]);
+    double scalar_ns = (get_time_ns() - start) / iterations;
+
+    // 19 位: 一组 3 位 + 两组 SWAR
+    const char big[] = "9223372036854775807";
+    start = get_time_ns();
+    for (int i = 0; i < iterations; i++) sink += (uint64_t) try_parser_num(big, 19 - (i & 1));
+    double swar19_ns = (get_time_ns() - start) / iterations;
+    start = get_time_ns();
+    for (int i = 0; i < iterations; i++) sink += (uint64_t) try_parser_positive_num_str_64_scalar(big, 19 - (i & 1));
+    double scalar19_ns = (get_time_ns() - start) / iterations;
+    (void) sink;
+
+    printf("\n");
+    printf("    Typical lengths:  %.2f ns (digit loop %.2f ns)\n", swar_ns, scalar_ns);
+    printf("    18-19 digits:     %.2f ns (digit loop %.2f ns)\n", swar19_ns, scalar19_ns);
+
+    TEST_PASS();
+}
+
 void test_perf_nested_array(void) {
     TEST_START("Performance: Nested array [[1,2],[3,4]]");
 
@@ -491,6 +580,8 @@ void run_performance_tests(void) {
 
     // Complex protocol
     test_perf_redis_set_command();
+    test_perf_pipelined_set_framing();
+    test_perf_length_parse();
     test_perf_nested_array();
 
     // Throughput